@@ -48,6 +48,7 @@ static Context *ctx;
 static gboolean info_flag; /* set when no action found */
 static gboolean connect_flag;
 static gboolean disconnect_flag;
+static gboolean monitor_throughput_flag;
 
 static GOptionEntry entries[] = {
     { "connect", 'c', 0, G_OPTION_ARG_NONE, &connect_flag,
@@ -58,6 +59,10 @@ static GOptionEntry entries[] = {
       "Disconnect a given bearer.",
       NULL
     },
+    { "monitor-throughput", 0, 0, G_OPTION_ARG_NONE, &monitor_throughput_flag,
+      "Monitor throughput of a given bearer.",
+      NULL
+    },
     { NULL }
 };
 
@@ -87,7 +92,8 @@ mmcli_bearer_options_enabled (void)
         return !!n_actions;
 
     n_actions = (connect_flag +
-                 disconnect_flag);
+                 disconnect_flag +
+                 monitor_throughput_flag);
 
     if (n_actions == 0 && mmcli_get_common_bearer_string ()) {
         /* default to info */
@@ -100,6 +106,9 @@ mmcli_bearer_options_enabled (void)
         exit (EXIT_FAILURE);
     }
 
+    if (monitor_throughput_flag)
+        mmcli_force_async_operation ();
+
     if (info_flag)
         mmcli_force_sync_operation ();
 
@@ -137,11 +146,13 @@ print_bearer_info (MMBearer *bearer)
     MMBearerIpConfig   *ipv6_config;
     MMBearerProperties *properties;
     MMBearerStats      *stats;
+    MMBearerThroughput *throughput;
 
     ipv4_config = mm_bearer_get_ipv4_config (bearer);
     ipv6_config = mm_bearer_get_ipv6_config (bearer);
     properties  = mm_bearer_get_properties (bearer);
     stats       = mm_bearer_get_stats (bearer);
+    throughput  = mm_bearer_get_throughput (bearer);
 
     mmcli_output_string      (MMC_F_BEARER_GENERAL_DBUS_PATH, mm_bearer_get_path (bearer));
     mmcli_output_string      (MMC_F_BEARER_GENERAL_TYPE,      mm_bearer_type_get_string (mm_bearer_get_bearer_type (bearer)));
@@ -268,8 +279,38 @@ print_bearer_info (MMBearer *bearer)
         mmcli_output_string_take (MMC_F_BEARER_STATS_BYTES_TX, bytes_tx);
     }
 
+    /* Throughput */
+    {
+        gchar *interval = NULL;
+        gchar *rx_rate = NULL;
+        gchar *tx_rate = NULL;
+        gchar *rx_peak = NULL;
+        gchar *tx_peak = NULL;
+        gchar *rx_average = NULL;
+        gchar *tx_average = NULL;
+
+        if (throughput) {
+            interval   = g_strdup_printf ("%u", mm_bearer_throughput_get_interval (throughput));
+            rx_rate    = g_strdup_printf ("%" G_GUINT64_FORMAT, mm_bearer_throughput_get_rx_rate (throughput));
+            tx_rate    = g_strdup_printf ("%" G_GUINT64_FORMAT, mm_bearer_throughput_get_tx_rate (throughput));
+            rx_peak    = g_strdup_printf ("%" G_GUINT64_FORMAT, mm_bearer_throughput_get_rx_peak (throughput));
+            tx_peak    = g_strdup_printf ("%" G_GUINT64_FORMAT, mm_bearer_throughput_get_tx_peak (throughput));
+            rx_average = g_strdup_printf ("%" G_GUINT64_FORMAT, mm_bearer_throughput_get_rx_average (throughput));
+            tx_average = g_strdup_printf ("%" G_GUINT64_FORMAT, mm_bearer_throughput_get_tx_average (throughput));
+        }
+
+        mmcli_output_string_take (MMC_F_BEARER_THROUGHPUT_INTERVAL,   interval);
+        mmcli_output_string_take (MMC_F_BEARER_THROUGHPUT_RX_RATE,    rx_rate);
+        mmcli_output_string_take (MMC_F_BEARER_THROUGHPUT_TX_RATE,    tx_rate);
+        mmcli_output_string_take (MMC_F_BEARER_THROUGHPUT_RX_PEAK,    rx_peak);
+        mmcli_output_string_take (MMC_F_BEARER_THROUGHPUT_TX_PEAK,    tx_peak);
+        mmcli_output_string_take (MMC_F_BEARER_THROUGHPUT_RX_AVERAGE, rx_average);
+        mmcli_output_string_take (MMC_F_BEARER_THROUGHPUT_TX_AVERAGE, tx_average);
+    }
+
     mmcli_output_dump ();
 
+    g_clear_object (&throughput);
     g_clear_object (&stats);
     g_clear_object (&properties);
     g_clear_object (&ipv4_config);
@@ -330,6 +371,59 @@ disconnect_ready (MMBearer      *bearer,
     mmcli_async_operation_done ();
 }
 
+static void
+cancelled (GCancellable *cancellable)
+{
+    mmcli_async_operation_done ();
+}
+
+static void
+print_throughput_rates (const gchar *prefix,
+                        guint64      rate,
+                        guint64      average,
+                        guint64      peak)
+{
+    gchar *rate_str;
+    gchar *average_str;
+    gchar *peak_str;
+
+    rate_str    = g_format_size (rate);
+    average_str = g_format_size (average);
+    peak_str    = g_format_size (peak);
+    g_print ("%s %s/s (average %s/s, peak %s/s)", prefix, rate_str, average_str, peak_str);
+    g_free (rate_str);
+    g_free (average_str);
+    g_free (peak_str);
+}
+
+static void
+throughput_updated (MMBearer   *bearer,
+                    GParamSpec *pspec)
+{
+    MMBearerThroughput *throughput;
+
+    throughput = mm_bearer_get_throughput (bearer);
+    if (!throughput) {
+        g_print ("\t%s: Throughput unknown\n", mm_bearer_get_path (bearer));
+        fflush (stdout);
+        return;
+    }
+
+    g_print ("\t%s: ", mm_bearer_get_path (bearer));
+    print_throughput_rates ("rx",
+                            mm_bearer_throughput_get_rx_rate (throughput),
+                            mm_bearer_throughput_get_rx_average (throughput),
+                            mm_bearer_throughput_get_rx_peak (throughput));
+    print_throughput_rates (", tx",
+                            mm_bearer_throughput_get_tx_rate (throughput),
+                            mm_bearer_throughput_get_tx_average (throughput),
+                            mm_bearer_throughput_get_tx_peak (throughput));
+    g_print ("\n");
+    fflush (stdout);
+
+    g_object_unref (throughput);
+}
+
 static void
 get_bearer_ready (GObject      *source,
                   GAsyncResult *result,
@@ -342,6 +436,43 @@ get_bearer_ready (GObject      *source,
     if (info_flag)
         g_assert_not_reached ();
 
+    /* Request to monitor throughput? */
+    if (monitor_throughput_flag) {
+        MMBearerThroughput *throughput;
+
+        g_signal_connect (ctx->bearer,
+                          "notify::throughput",
+                          G_CALLBACK (throughput_updated),
+                          NULL);
+
+        /* Recent history, oldest first, then the current values */
+        throughput = mm_bearer_get_throughput (ctx->bearer);
+        if (throughput) {
+            const guint32 *rx_rates;
+            const guint32 *tx_rates;
+            guint          n_samples;
+            guint          i;
+
+            if (mm_bearer_throughput_peek_history (throughput, &rx_rates, &tx_rates, &n_samples)) {
+                g_print ("\t%s: History (%us interval), rx/tx B/s:",
+                         mm_bearer_get_path (ctx->bearer),
+                         mm_bearer_throughput_get_interval (throughput));
+                for (i = 0; i < n_samples; i++)
+                    g_print (" %u/%u", rx_rates[i], tx_rates[i]);
+                g_print ("\n");
+            }
+            g_object_unref (throughput);
+        }
+        throughput_updated (ctx->bearer, NULL);
+
+        /* If we get cancelled, operation done */
+        g_cancellable_connect (ctx->cancellable,
+                               G_CALLBACK (cancelled),
+                               NULL,
+                               NULL);
+        return;
+    }
+
     /* Request to connect the bearer? */
     if (connect_flag) {
         g_debug ("Asynchronously connecting bearer...");
@@ -387,6 +518,9 @@ mmcli_bearer_run_synchronous (GDBusConnection *connection)
 {
     GError *error = NULL;
 
+    if (monitor_throughput_flag)
+        g_assert_not_reached ();
+
     /* Initialize context */
     ctx = g_new0 (Context, 1);
     ctx->bearer = mmcli_get_bearer_sync (connection,
@@ -55,6 +55,7 @@ static gboolean get_daemon_version_flag;
 static gboolean list_modems_flag;
 static gboolean monitor_modems_flag;
 static gboolean scan_modems_flag;
+static gboolean poll_timeline_flag;
 static gchar *set_logging_str;
 static gchar *inhibit_device_str;
 static gchar *report_kernel_event_str;
@@ -84,6 +85,10 @@ static GOptionEntry entries[] = {
       "Request to re-scan looking for modems",
       NULL
     },
+    { "poll-timeline", 0, 0, G_OPTION_ARG_NONE, &poll_timeline_flag,
+      "Show the periodic checks scheduled in the ModemManager daemon (debug mode only)",
+      NULL
+    },
     { "inhibit-device", 'I', 0, G_OPTION_ARG_STRING, &inhibit_device_str,
       "Inhibit device given a unique device identifier",
       "[UID]"
@@ -130,6 +135,7 @@ mmcli_manager_options_enabled (void)
                  list_modems_flag +
                  monitor_modems_flag +
                  scan_modems_flag +
+                 poll_timeline_flag +
                  !!set_logging_str +
                  !!inhibit_device_str +
                  !!report_kernel_event_str);
@@ -321,6 +327,76 @@ scan_devices_ready (MMManager    *manager,
     mmcli_async_operation_done ();
 }
 
+static void
+poll_timeline_process_reply (GVariant     *result,
+                             const GError *error)
+{
+    guint64 wakeups = 0;
+    guint64 runs = 0;
+    guint64 satisfied = 0;
+    GVariant *jobs;
+
+    if (!result) {
+        g_printerr ("error: couldn't get poll timeline: '%s'\n",
+                    error ? error->message : "unknown error");
+        exit (EXIT_FAILURE);
+    }
+
+    g_variant_lookup (result, "wakeups", "t", &wakeups);
+    g_variant_lookup (result, "runs", "t", &runs);
+    g_variant_lookup (result, "satisfied", "t", &satisfied);
+    g_print ("wakeups: %" G_GUINT64_FORMAT ", runs: %" G_GUINT64_FORMAT
+             ", skipped: %" G_GUINT64_FORMAT "\n",
+             wakeups, runs, satisfied);
+
+    jobs = g_variant_lookup_value (result, "jobs", G_VARIANT_TYPE ("aa{sv}"));
+    if (jobs) {
+        GVariantIter iter;
+        GVariant *job;
+
+        g_variant_iter_init (&iter, jobs);
+        while ((job = g_variant_iter_next_value (&iter))) {
+            const gchar *owner = NULL;
+            const gchar *name = NULL;
+            guint32 interval = 0;
+            gint64 next = 0;
+            guint64 job_runs = 0;
+            guint64 job_satisfied = 0;
+
+            g_variant_lookup (job, "owner", "&s", &owner);
+            g_variant_lookup (job, "name", "&s", &name);
+            g_variant_lookup (job, "interval", "u", &interval);
+            g_variant_lookup (job, "next", "x", &next);
+            g_variant_lookup (job, "runs", "t", &job_runs);
+            g_variant_lookup (job, "satisfied", "t", &job_satisfied);
+            g_print ("  in %6.1fs: %s %s (every %us, runs %" G_GUINT64_FORMAT
+                     ", satisfied %" G_GUINT64_FORMAT ")\n",
+                     (gdouble) next / 1000.0,
+                     owner ? owner : "unknown",
+                     name ? name : "unknown",
+                     interval, job_runs, job_satisfied);
+            g_variant_unref (job);
+        }
+        g_variant_unref (jobs);
+    }
+
+    g_variant_unref (result);
+}
+
+static void
+poll_timeline_ready (MMManager    *manager,
+                     GAsyncResult *result,
+                     gpointer      nothing)
+{
+    GVariant *operation_result;
+    GError *error = NULL;
+
+    operation_result = mm_manager_get_poll_timeline_finish (manager, result, &error);
+    poll_timeline_process_reply (operation_result, error);
+
+    mmcli_async_operation_done ();
+}
+
 #define FOUND_ACTION_PREFIX   "    "
 #define ADDED_ACTION_PREFIX   "(+) "
 #define REMOVED_ACTION_PREFIX "(-) "
@@ -428,6 +504,15 @@ get_manager_ready (GObject      *source,
         return;
     }
 
+    /* Request to show the poll timeline? */
+    if (poll_timeline_flag) {
+        mm_manager_get_poll_timeline (ctx->manager,
+                                      ctx->cancellable,
+                                      (GAsyncReadyCallback)poll_timeline_ready,
+                                      NULL);
+        return;
+    }
+
     /* Request to report kernel event? */
     if (report_kernel_event_str) {
         MMKernelEventProperties *properties;
@@ -587,6 +672,15 @@ mmcli_manager_run_synchronous (GDBusConnection *connection)
         return;
     }
 
+    /* Request to show the poll timeline? */
+    if (poll_timeline_flag) {
+        GVariant *result;
+
+        result = mm_manager_get_poll_timeline_sync (ctx->manager, NULL, &error);
+        poll_timeline_process_reply (result, error);
+        return;
+    }
+
     /* Request to report kernel event? */
     if (report_kernel_event_str) {
         MMKernelEventProperties *properties;
@@ -57,6 +57,7 @@ static gboolean set_power_state_off_flag;
 static gboolean reset_flag;
 static gchar *factory_reset_str;
 static gchar *command_str;
+static gboolean port_stats_flag;
 static gchar *create_bearer_str;
 static gchar *delete_bearer_str;
 static gchar *set_current_capabilities_str;
@@ -102,6 +103,10 @@ static GOptionEntry entries[] = {
       "Send an AT command to the modem",
       "[COMMAND]"
     },
+    { "port-stats", 0, 0, G_OPTION_ARG_NONE, &port_stats_flag,
+      "Show statistics of the commands sent through the modem ports (debug mode only)",
+      NULL
+    },
     { "create-bearer", 0, 0, G_OPTION_ARG_STRING, &create_bearer_str,
       "Create a new packet data bearer in a given modem",
       "[\"key=value,...\"]"
@@ -169,6 +174,7 @@ mmcli_modem_options_enabled (void)
                  !!delete_bearer_str +
                  !!factory_reset_str +
                  !!command_str +
+                 port_stats_flag +
                  !!set_current_capabilities_str +
                  !!set_allowed_modes_str +
                  !!set_preferred_mode_str +
@@ -658,6 +664,162 @@ command_ready (MMModem      *modem,
     mmcli_async_operation_done ();
 }
 
+static void
+print_histogram (const gchar *name,
+                 GVariant    *histogram)
+{
+    guint64 count = 0;
+    guint64 min = 0;
+    guint64 mean = 0;
+    guint64 p50 = 0;
+    guint64 p90 = 0;
+    guint64 p99 = 0;
+    guint64 max = 0;
+
+    g_variant_lookup (histogram, "count", "t", &count);
+    if (!count)
+        return;
+
+    g_variant_lookup (histogram, "min",  "t", &min);
+    g_variant_lookup (histogram, "mean", "t", &mean);
+    g_variant_lookup (histogram, "p50",  "t", &p50);
+    g_variant_lookup (histogram, "p90",  "t", &p90);
+    g_variant_lookup (histogram, "p99",  "t", &p99);
+    g_variant_lookup (histogram, "max",  "t", &max);
+    g_print ("           |     %-10s (us): min %" G_GUINT64_FORMAT ", mean %" G_GUINT64_FORMAT
+             ", p50 %" G_GUINT64_FORMAT ", p90 %" G_GUINT64_FORMAT ", p99 %" G_GUINT64_FORMAT
+             ", max %" G_GUINT64_FORMAT "\n",
+             name, min, mean, p50, p90, p99, max);
+}
+
+static void
+port_stats_process_reply (GVariant     *result,
+                          const GError *error)
+{
+    GVariantIter iter;
+    GVariant *port;
+
+    if (!result) {
+        g_printerr ("error: couldn't get port stats: '%s'\n",
+                    error ? error->message : "unknown error");
+        exit (EXIT_FAILURE);
+    }
+
+    g_variant_iter_init (&iter, result);
+    while ((port = g_variant_iter_next_value (&iter))) {
+        const gchar *name = NULL;
+        guint32 consecutive_timeouts = 0;
+        guint32 cache_hits = 0;
+        guint32 cache_misses = 0;
+        GVariant *commands;
+        GVariant *lanes;
+
+        g_variant_lookup (port, "port", "&s", &name);
+        g_variant_lookup (port, "consecutive-timeouts", "u", &consecutive_timeouts);
+        g_variant_lookup (port, "cache-hits", "u", &cache_hits);
+        g_variant_lookup (port, "cache-misses", "u", &cache_misses);
+
+        g_print ("\n"
+                 "  %s\n"
+                 "  -------------------------\n"
+                 "  Port     | consecutive timeouts: '%u'\n"
+                 "           |           cache hits: '%u'\n"
+                 "           |         cache misses: '%u'\n",
+                 name ? name : "unknown",
+                 consecutive_timeouts,
+                 cache_hits,
+                 cache_misses);
+
+        commands = g_variant_lookup_value (port, "commands", G_VARIANT_TYPE ("aa{sv}"));
+        if (commands) {
+            GVariantIter commands_iter;
+            GVariant *command;
+
+            g_print ("  -------------------------\n"
+                     "  Commands |\n");
+
+            g_variant_iter_init (&commands_iter, commands);
+            while ((command = g_variant_iter_next_value (&commands_iter))) {
+                const gchar *key = NULL;
+                guint64 count = 0;
+                guint64 timeouts = 0;
+                guint64 errors = 0;
+                guint64 hits = 0;
+                const gchar *histograms[] = { "queue-wait", "send", "first-byte", "parse" };
+                guint i;
+
+                g_variant_lookup (command, "command", "&s", &key);
+                g_variant_lookup (command, "count", "t", &count);
+                g_variant_lookup (command, "timeouts", "t", &timeouts);
+                g_variant_lookup (command, "errors", "t", &errors);
+                g_variant_lookup (command, "cache-hits", "t", &hits);
+                g_print ("           | %s: count %" G_GUINT64_FORMAT ", timeouts %" G_GUINT64_FORMAT
+                         ", errors %" G_GUINT64_FORMAT ", cache hits %" G_GUINT64_FORMAT "\n",
+                         key ? key : "unknown", count, timeouts, errors, hits);
+
+                for (i = 0; i < G_N_ELEMENTS (histograms); i++) {
+                    GVariant *histogram;
+
+                    histogram = g_variant_lookup_value (command, histograms[i], G_VARIANT_TYPE ("a{st}"));
+                    if (histogram) {
+                        print_histogram (histograms[i], histogram);
+                        g_variant_unref (histogram);
+                    }
+                }
+                g_variant_unref (command);
+            }
+            g_variant_unref (commands);
+        }
+
+        lanes = g_variant_lookup_value (port, "lanes", G_VARIANT_TYPE ("aa{sv}"));
+        if (lanes) {
+            GVariantIter lanes_iter;
+            GVariant *lane;
+
+            g_print ("  -------------------------\n"
+                     "  Lanes    |\n");
+
+            g_variant_iter_init (&lanes_iter, lanes);
+            while ((lane = g_variant_iter_next_value (&lanes_iter))) {
+                const gchar *lane_name = NULL;
+                guint32 depth = 0;
+                guint64 dispatched = 0;
+                guint64 total_wait = 0;
+                guint64 max_wait = 0;
+
+                g_variant_lookup (lane, "lane", "&s", &lane_name);
+                g_variant_lookup (lane, "depth", "u", &depth);
+                g_variant_lookup (lane, "dispatched", "t", &dispatched);
+                g_variant_lookup (lane, "total-wait", "t", &total_wait);
+                g_variant_lookup (lane, "max-wait", "t", &max_wait);
+                g_print ("           | %s: depth %u, dispatched %" G_GUINT64_FORMAT
+                         ", mean wait %" G_GUINT64_FORMAT ", max wait %" G_GUINT64_FORMAT "\n",
+                         lane_name ? lane_name : "unknown", depth, dispatched,
+                         dispatched ? total_wait / dispatched : 0, max_wait);
+                g_variant_unref (lane);
+            }
+            g_variant_unref (lanes);
+        }
+        g_variant_unref (port);
+    }
+
+    g_variant_unref (result);
+}
+
+static void
+port_stats_ready (MMModem      *modem,
+                  GAsyncResult *result,
+                  gpointer      nothing)
+{
+    GVariant *operation_result;
+    GError *error = NULL;
+
+    operation_result = mm_modem_get_port_stats_finish (modem, result, &error);
+    port_stats_process_reply (operation_result, error);
+
+    mmcli_async_operation_done ();
+}
+
 static guint
 command_get_timeout (MMModem *modem)
 {
@@ -1055,6 +1217,16 @@ get_modem_ready (GObject      *source,
         return;
     }
 
+    /* Request to get the port stats? */
+    if (port_stats_flag) {
+        g_debug ("Asynchronously getting port stats...");
+        mm_modem_get_port_stats (ctx->modem,
+                                 ctx->cancellable,
+                                 (GAsyncReadyCallback)port_stats_ready,
+                                 NULL);
+        return;
+    }
+
     /* Request to create a new bearer? */
     if (create_bearer_str) {
         GError *error = NULL;
@@ -1291,6 +1463,16 @@ mmcli_modem_run_synchronous (GDBusConnection *connection)
         return;
     }
 
+    /* Request to get the port stats? */
+    if (port_stats_flag) {
+        GVariant *result;
+
+        g_debug ("Synchronously getting port stats...");
+        result = mm_modem_get_port_stats_sync (ctx->modem, NULL, &error);
+        port_stats_process_reply (result, error);
+        return;
+    }
+
     /* Request to create a new bearer? */
     if (create_bearer_str) {
         MMBearer *bearer;
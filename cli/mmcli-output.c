@@ -72,6 +72,7 @@ static SectionInfo section_infos[] = {
     [MMC_S_BEARER_IPV4_CONFIG]      = { "IPv4 configuration" },
     [MMC_S_BEARER_IPV6_CONFIG]      = { "IPv6 configuration" },
     [MMC_S_BEARER_STATS]            = { "Statistics"         },
+    [MMC_S_BEARER_THROUGHPUT]       = { "Throughput"         },
     [MMC_S_CALL_GENERAL]            = { "General"            },
     [MMC_S_CALL_PROPERTIES]         = { "Properties"         },
     [MMC_S_CALL_AUDIO_FORMAT]       = { "Audio format"       },
@@ -224,6 +225,13 @@ static FieldInfo field_infos[] = {
     [MMC_F_BEARER_STATS_DURATION]             = { "bearer.stats.duration",                           "duration",                 MMC_S_BEARER_STATS,            },
     [MMC_F_BEARER_STATS_BYTES_RX]             = { "bearer.stats.bytes-rx",                           "bytes rx",                 MMC_S_BEARER_STATS,            },
     [MMC_F_BEARER_STATS_BYTES_TX]             = { "bearer.stats.bytes-tx",                           "bytes tx",                 MMC_S_BEARER_STATS,            },
+    [MMC_F_BEARER_THROUGHPUT_INTERVAL]        = { "bearer.throughput.interval",                      "interval",                 MMC_S_BEARER_THROUGHPUT,       },
+    [MMC_F_BEARER_THROUGHPUT_RX_RATE]         = { "bearer.throughput.rx-rate",                       "rx rate",                  MMC_S_BEARER_THROUGHPUT,       },
+    [MMC_F_BEARER_THROUGHPUT_TX_RATE]         = { "bearer.throughput.tx-rate",                       "tx rate",                  MMC_S_BEARER_THROUGHPUT,       },
+    [MMC_F_BEARER_THROUGHPUT_RX_PEAK]         = { "bearer.throughput.rx-peak",                       "rx peak",                  MMC_S_BEARER_THROUGHPUT,       },
+    [MMC_F_BEARER_THROUGHPUT_TX_PEAK]         = { "bearer.throughput.tx-peak",                       "tx peak",                  MMC_S_BEARER_THROUGHPUT,       },
+    [MMC_F_BEARER_THROUGHPUT_RX_AVERAGE]      = { "bearer.throughput.rx-average",                    "rx average",               MMC_S_BEARER_THROUGHPUT,       },
+    [MMC_F_BEARER_THROUGHPUT_TX_AVERAGE]      = { "bearer.throughput.tx-average",                    "tx average",               MMC_S_BEARER_THROUGHPUT,       },
     [MMC_F_CALL_GENERAL_DBUS_PATH]            = { "call.dbus-path",                                  "dbus path",                MMC_S_CALL_GENERAL,            },
     [MMC_F_CALL_PROPERTIES_NUMBER]            = { "call.properties.number",                          "number",                   MMC_S_CALL_PROPERTIES,         },
     [MMC_F_CALL_PROPERTIES_DIRECTION]         = { "call.properties.direction",                       "direction",                MMC_S_CALL_PROPERTIES,         },
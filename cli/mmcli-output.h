@@ -69,6 +69,7 @@ typedef enum {
     MMC_S_BEARER_IPV4_CONFIG,
     MMC_S_BEARER_IPV6_CONFIG,
     MMC_S_BEARER_STATS,
+    MMC_S_BEARER_THROUGHPUT,
     MMC_S_CALL_GENERAL,
     MMC_S_CALL_PROPERTIES,
     MMC_S_CALL_AUDIO_FORMAT,
@@ -240,6 +241,13 @@ typedef enum {
     MMC_F_BEARER_STATS_DURATION,
     MMC_F_BEARER_STATS_BYTES_RX,
     MMC_F_BEARER_STATS_BYTES_TX,
+    MMC_F_BEARER_THROUGHPUT_INTERVAL,
+    MMC_F_BEARER_THROUGHPUT_RX_RATE,
+    MMC_F_BEARER_THROUGHPUT_TX_RATE,
+    MMC_F_BEARER_THROUGHPUT_RX_PEAK,
+    MMC_F_BEARER_THROUGHPUT_TX_PEAK,
+    MMC_F_BEARER_THROUGHPUT_RX_AVERAGE,
+    MMC_F_BEARER_THROUGHPUT_TX_AVERAGE,
     MMC_F_CALL_GENERAL_DBUS_PATH,
     MMC_F_CALL_PROPERTIES_NUMBER,
     MMC_F_CALL_PROPERTIES_DIRECTION,
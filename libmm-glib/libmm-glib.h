@@ -67,6 +67,7 @@
 #include <mm-bearer-properties.h>
 #include <mm-bearer-ip-config.h>
 #include <mm-bearer-stats.h>
+#include <mm-bearer-throughput.h>
 #include <mm-location-common.h>
 #include <mm-location-3gpp.h>
 #include <mm-location-gps-raw.h>
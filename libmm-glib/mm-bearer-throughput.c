@@ -0,0 +1,457 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <string.h>
+
+#include "mm-errors-types.h"
+#include "mm-bearer-throughput.h"
+
+/**
+ * SECTION: mm-bearer-throughput
+ * @title: MMBearerThroughput
+ * @short_description: Helper object to handle bearer throughput.
+ *
+ * The #MMBearerThroughput is an object handling the throughput of a bearer
+ * during a connection, as sampled periodically by the daemon: the rate in the
+ * last interval, the peak and average rates, and the rates in the last
+ * intervals.
+ *
+ * All rates are given in bytes per second.
+ *
+ * This object is retrieved with either mm_bearer_get_throughput() or
+ * mm_bearer_peek_throughput().
+ */
+
+G_DEFINE_TYPE (MMBearerThroughput, mm_bearer_throughput, G_TYPE_OBJECT)
+
+#define PROPERTY_INTERVAL   "interval"
+#define PROPERTY_RX_RATE    "rx-rate"
+#define PROPERTY_TX_RATE    "tx-rate"
+#define PROPERTY_RX_PEAK    "rx-peak"
+#define PROPERTY_TX_PEAK    "tx-peak"
+#define PROPERTY_RX_AVERAGE "rx-average"
+#define PROPERTY_TX_AVERAGE "tx-average"
+#define PROPERTY_HISTORY    "history"
+
+struct _MMBearerThroughputPrivate {
+    guint    interval;
+    guint64  rx_rate;
+    guint64  tx_rate;
+    guint64  rx_peak;
+    guint64  tx_peak;
+    guint64  rx_average;
+    guint64  tx_average;
+    /* guint32 rates, oldest first */
+    GArray  *rx_history;
+    GArray  *tx_history;
+};
+
+/*****************************************************************************/
+
+/**
+ * mm_bearer_throughput_get_interval:
+ * @self: a #MMBearerThroughput.
+ *
+ * Gets the interval between samples, in seconds.
+ *
+ * Returns: a #guint.
+ */
+guint
+mm_bearer_throughput_get_interval (MMBearerThroughput *self)
+{
+    g_return_val_if_fail (MM_IS_BEARER_THROUGHPUT (self), 0);
+
+    return self->priv->interval;
+}
+
+void
+mm_bearer_throughput_set_interval (MMBearerThroughput *self,
+                                   guint interval)
+{
+    g_return_if_fail (MM_IS_BEARER_THROUGHPUT (self));
+
+    self->priv->interval = interval;
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_bearer_throughput_get_rx_rate:
+ * @self: a #MMBearerThroughput.
+ *
+ * Gets the rate of bytes received in the last interval.
+ *
+ * Returns: a #guint64, in bytes per second.
+ */
+guint64
+mm_bearer_throughput_get_rx_rate (MMBearerThroughput *self)
+{
+    g_return_val_if_fail (MM_IS_BEARER_THROUGHPUT (self), 0);
+
+    return self->priv->rx_rate;
+}
+
+void
+mm_bearer_throughput_set_rx_rate (MMBearerThroughput *self,
+                                  guint64 rate)
+{
+    g_return_if_fail (MM_IS_BEARER_THROUGHPUT (self));
+
+    self->priv->rx_rate = rate;
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_bearer_throughput_get_tx_rate:
+ * @self: a #MMBearerThroughput.
+ *
+ * Gets the rate of bytes transmitted in the last interval.
+ *
+ * Returns: a #guint64, in bytes per second.
+ */
+guint64
+mm_bearer_throughput_get_tx_rate (MMBearerThroughput *self)
+{
+    g_return_val_if_fail (MM_IS_BEARER_THROUGHPUT (self), 0);
+
+    return self->priv->tx_rate;
+}
+
+void
+mm_bearer_throughput_set_tx_rate (MMBearerThroughput *self,
+                                  guint64 rate)
+{
+    g_return_if_fail (MM_IS_BEARER_THROUGHPUT (self));
+
+    self->priv->tx_rate = rate;
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_bearer_throughput_get_rx_peak:
+ * @self: a #MMBearerThroughput.
+ *
+ * Gets the highest rate of bytes received in an interval during the connection.
+ *
+ * Returns: a #guint64, in bytes per second.
+ */
+guint64
+mm_bearer_throughput_get_rx_peak (MMBearerThroughput *self)
+{
+    g_return_val_if_fail (MM_IS_BEARER_THROUGHPUT (self), 0);
+
+    return self->priv->rx_peak;
+}
+
+void
+mm_bearer_throughput_set_rx_peak (MMBearerThroughput *self,
+                                  guint64 rate)
+{
+    g_return_if_fail (MM_IS_BEARER_THROUGHPUT (self));
+
+    self->priv->rx_peak = rate;
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_bearer_throughput_get_tx_peak:
+ * @self: a #MMBearerThroughput.
+ *
+ * Gets the highest rate of bytes transmitted in an interval during the connection.
+ *
+ * Returns: a #guint64, in bytes per second.
+ */
+guint64
+mm_bearer_throughput_get_tx_peak (MMBearerThroughput *self)
+{
+    g_return_val_if_fail (MM_IS_BEARER_THROUGHPUT (self), 0);
+
+    return self->priv->tx_peak;
+}
+
+void
+mm_bearer_throughput_set_tx_peak (MMBearerThroughput *self,
+                                  guint64 rate)
+{
+    g_return_if_fail (MM_IS_BEARER_THROUGHPUT (self));
+
+    self->priv->tx_peak = rate;
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_bearer_throughput_get_rx_average:
+ * @self: a #MMBearerThroughput.
+ *
+ * Gets the exponentially weighted moving average of the rate of bytes
+ * received.
+ *
+ * Returns: a #guint64, in bytes per second.
+ */
+guint64
+mm_bearer_throughput_get_rx_average (MMBearerThroughput *self)
+{
+    g_return_val_if_fail (MM_IS_BEARER_THROUGHPUT (self), 0);
+
+    return self->priv->rx_average;
+}
+
+void
+mm_bearer_throughput_set_rx_average (MMBearerThroughput *self,
+                                     guint64 rate)
+{
+    g_return_if_fail (MM_IS_BEARER_THROUGHPUT (self));
+
+    self->priv->rx_average = rate;
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_bearer_throughput_get_tx_average:
+ * @self: a #MMBearerThroughput.
+ *
+ * Gets the exponentially weighted moving average of the rate of bytes
+ * transmitted.
+ *
+ * Returns: a #guint64, in bytes per second.
+ */
+guint64
+mm_bearer_throughput_get_tx_average (MMBearerThroughput *self)
+{
+    g_return_val_if_fail (MM_IS_BEARER_THROUGHPUT (self), 0);
+
+    return self->priv->tx_average;
+}
+
+void
+mm_bearer_throughput_set_tx_average (MMBearerThroughput *self,
+                                     guint64 rate)
+{
+    g_return_if_fail (MM_IS_BEARER_THROUGHPUT (self));
+
+    self->priv->tx_average = rate;
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_bearer_throughput_peek_history:
+ * @self: a #MMBearerThroughput.
+ * @rx_rates: (out) (array length=n_samples): return location for the rates of bytes received.
+ * @tx_rates: (out) (array length=n_samples): return location for the rates of bytes transmitted.
+ * @n_samples: (out): return location for the number of samples.
+ *
+ * Gets the rates in the last intervals, in bytes per second, oldest first.
+ *
+ * The returned arrays belong to @self.
+ *
+ * Returns: %TRUE if there is any sample, %FALSE otherwise.
+ */
+gboolean
+mm_bearer_throughput_peek_history (MMBearerThroughput  *self,
+                                   const guint32      **rx_rates,
+                                   const guint32      **tx_rates,
+                                   guint               *n_samples)
+{
+    g_return_val_if_fail (MM_IS_BEARER_THROUGHPUT (self), FALSE);
+
+    if (rx_rates)
+        *rx_rates = (const guint32 *) self->priv->rx_history->data;
+    if (tx_rates)
+        *tx_rates = (const guint32 *) self->priv->tx_history->data;
+    if (n_samples)
+        *n_samples = self->priv->rx_history->len;
+    return (self->priv->rx_history->len > 0);
+}
+
+void
+mm_bearer_throughput_add_history (MMBearerThroughput *self,
+                                  guint32 rx_rate,
+                                  guint32 tx_rate)
+{
+    g_return_if_fail (MM_IS_BEARER_THROUGHPUT (self));
+
+    g_array_append_val (self->priv->rx_history, rx_rate);
+    g_array_append_val (self->priv->tx_history, tx_rate);
+}
+
+/*****************************************************************************/
+
+GVariant *
+mm_bearer_throughput_get_dictionary (MMBearerThroughput *self)
+{
+    GVariantBuilder builder;
+    GVariantBuilder history;
+    guint i;
+
+    /* We do allow self==NULL. We'll just report NULL. */
+    if (!self)
+        return NULL;
+
+    g_variant_builder_init (&history, G_VARIANT_TYPE ("a(uu)"));
+    for (i = 0; i < self->priv->rx_history->len; i++)
+        g_variant_builder_add (&history,
+                               "(uu)",
+                               g_array_index (self->priv->rx_history, guint32, i),
+                               g_array_index (self->priv->tx_history, guint32, i));
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+    g_variant_builder_add  (&builder,
+                            "{sv}",
+                            PROPERTY_INTERVAL,
+                            g_variant_new_uint32 (self->priv->interval));
+    g_variant_builder_add  (&builder,
+                            "{sv}",
+                            PROPERTY_RX_RATE,
+                            g_variant_new_uint64 (self->priv->rx_rate));
+    g_variant_builder_add  (&builder,
+                            "{sv}",
+                            PROPERTY_TX_RATE,
+                            g_variant_new_uint64 (self->priv->tx_rate));
+    g_variant_builder_add  (&builder,
+                            "{sv}",
+                            PROPERTY_RX_PEAK,
+                            g_variant_new_uint64 (self->priv->rx_peak));
+    g_variant_builder_add  (&builder,
+                            "{sv}",
+                            PROPERTY_TX_PEAK,
+                            g_variant_new_uint64 (self->priv->tx_peak));
+    g_variant_builder_add  (&builder,
+                            "{sv}",
+                            PROPERTY_RX_AVERAGE,
+                            g_variant_new_uint64 (self->priv->rx_average));
+    g_variant_builder_add  (&builder,
+                            "{sv}",
+                            PROPERTY_TX_AVERAGE,
+                            g_variant_new_uint64 (self->priv->tx_average));
+    g_variant_builder_add  (&builder,
+                            "{sv}",
+                            PROPERTY_HISTORY,
+                            g_variant_builder_end (&history));
+    return g_variant_builder_end (&builder);
+}
+
+/*****************************************************************************/
+
+MMBearerThroughput *
+mm_bearer_throughput_new_from_dictionary (GVariant *dictionary,
+                                          GError **error)
+{
+    GVariantIter iter;
+    gchar *key;
+    GVariant *value;
+    MMBearerThroughput *self;
+
+    self = mm_bearer_throughput_new ();
+    if (!dictionary)
+        return self;
+
+    if (!g_variant_is_of_type (dictionary, G_VARIANT_TYPE ("a{sv}"))) {
+        g_set_error (error,
+                     MM_CORE_ERROR,
+                     MM_CORE_ERROR_INVALID_ARGS,
+                     "Cannot create Throughput from dictionary: "
+                     "invalid variant type received");
+        g_object_unref (self);
+        return NULL;
+    }
+
+    g_variant_iter_init (&iter, dictionary);
+    while (g_variant_iter_next (&iter, "{sv}", &key, &value)) {
+        if (g_str_equal (key, PROPERTY_INTERVAL)) {
+            mm_bearer_throughput_set_interval (
+                self,
+                g_variant_get_uint32 (value));
+        } else if (g_str_equal (key, PROPERTY_RX_RATE)) {
+            mm_bearer_throughput_set_rx_rate (
+                self,
+                g_variant_get_uint64 (value));
+        } else if (g_str_equal (key, PROPERTY_TX_RATE)) {
+            mm_bearer_throughput_set_tx_rate (
+                self,
+                g_variant_get_uint64 (value));
+        } else if (g_str_equal (key, PROPERTY_RX_PEAK)) {
+            mm_bearer_throughput_set_rx_peak (
+                self,
+                g_variant_get_uint64 (value));
+        } else if (g_str_equal (key, PROPERTY_TX_PEAK)) {
+            mm_bearer_throughput_set_tx_peak (
+                self,
+                g_variant_get_uint64 (value));
+        } else if (g_str_equal (key, PROPERTY_RX_AVERAGE)) {
+            mm_bearer_throughput_set_rx_average (
+                self,
+                g_variant_get_uint64 (value));
+        } else if (g_str_equal (key, PROPERTY_TX_AVERAGE)) {
+            mm_bearer_throughput_set_tx_average (
+                self,
+                g_variant_get_uint64 (value));
+        } else if (g_str_equal (key, PROPERTY_HISTORY)) {
+            GVariantIter history_iter;
+            guint32 rx_rate;
+            guint32 tx_rate;
+
+            g_variant_iter_init (&history_iter, value);
+            while (g_variant_iter_next (&history_iter, "(uu)", &rx_rate, &tx_rate))
+                mm_bearer_throughput_add_history (self, rx_rate, tx_rate);
+        }
+        g_free (key);
+        g_variant_unref (value);
+    }
+
+    return self;
+}
+
+/*****************************************************************************/
+
+MMBearerThroughput *
+mm_bearer_throughput_new (void)
+{
+    return (MM_BEARER_THROUGHPUT (g_object_new (MM_TYPE_BEARER_THROUGHPUT, NULL)));
+}
+
+static void
+mm_bearer_throughput_init (MMBearerThroughput *self)
+{
+    self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, MM_TYPE_BEARER_THROUGHPUT, MMBearerThroughputPrivate);
+    self->priv->rx_history = g_array_new (FALSE, FALSE, sizeof (guint32));
+    self->priv->tx_history = g_array_new (FALSE, FALSE, sizeof (guint32));
+}
+
+static void
+finalize (GObject *object)
+{
+    MMBearerThroughput *self = MM_BEARER_THROUGHPUT (object);
+
+    g_array_unref (self->priv->rx_history);
+    g_array_unref (self->priv->tx_history);
+
+    G_OBJECT_CLASS (mm_bearer_throughput_parent_class)->finalize (object);
+}
+
+static void
+mm_bearer_throughput_class_init (MMBearerThroughputClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    g_type_class_add_private (object_class, sizeof (MMBearerThroughputPrivate));
+
+    object_class->finalize = finalize;
+}
@@ -0,0 +1,100 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#ifndef MM_BEARER_THROUGHPUT_H
+#define MM_BEARER_THROUGHPUT_H
+
+#if !defined (__LIBMM_GLIB_H_INSIDE__) && !defined (LIBMM_GLIB_COMPILATION)
+#error "Only <libmm-glib.h> can be included directly."
+#endif
+
+#include <ModemManager.h>
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define MM_TYPE_BEARER_THROUGHPUT            (mm_bearer_throughput_get_type ())
+#define MM_BEARER_THROUGHPUT(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), MM_TYPE_BEARER_THROUGHPUT, MMBearerThroughput))
+#define MM_BEARER_THROUGHPUT_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  MM_TYPE_BEARER_THROUGHPUT, MMBearerThroughputClass))
+#define MM_IS_BEARER_THROUGHPUT(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), MM_TYPE_BEARER_THROUGHPUT))
+#define MM_IS_BEARER_THROUGHPUT_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  MM_TYPE_BEARER_THROUGHPUT))
+#define MM_BEARER_THROUGHPUT_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  MM_TYPE_BEARER_THROUGHPUT, MMBearerThroughputClass))
+
+typedef struct _MMBearerThroughput MMBearerThroughput;
+typedef struct _MMBearerThroughputClass MMBearerThroughputClass;
+typedef struct _MMBearerThroughputPrivate MMBearerThroughputPrivate;
+
+/**
+ * MMBearerThroughput:
+ *
+ * The #MMBearerThroughput structure contains private data and should
+ * only be accessed using the provided API.
+ */
+struct _MMBearerThroughput {
+    /*< private >*/
+    GObject parent;
+    MMBearerThroughputPrivate *priv;
+};
+
+struct _MMBearerThroughputClass {
+    /*< private >*/
+    GObjectClass parent;
+};
+
+GType mm_bearer_throughput_get_type (void);
+
+#if GLIB_CHECK_VERSION(2, 44, 0)
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (MMBearerThroughput, g_object_unref)
+#endif
+
+guint    mm_bearer_throughput_get_interval   (MMBearerThroughput *self);
+guint64  mm_bearer_throughput_get_rx_rate    (MMBearerThroughput *self);
+guint64  mm_bearer_throughput_get_tx_rate    (MMBearerThroughput *self);
+guint64  mm_bearer_throughput_get_rx_peak    (MMBearerThroughput *self);
+guint64  mm_bearer_throughput_get_tx_peak    (MMBearerThroughput *self);
+guint64  mm_bearer_throughput_get_rx_average (MMBearerThroughput *self);
+guint64  mm_bearer_throughput_get_tx_average (MMBearerThroughput *self);
+gboolean mm_bearer_throughput_peek_history   (MMBearerThroughput  *self,
+                                              const guint32      **rx_rates,
+                                              const guint32      **tx_rates,
+                                              guint               *n_samples);
+
+/*****************************************************************************/
+/* ModemManager/libmm-glib/mmcli specific methods */
+
+#if defined (_LIBMM_INSIDE_MM) ||    \
+    defined (_LIBMM_INSIDE_MMCLI) || \
+    defined (LIBMM_GLIB_COMPILATION)
+
+MMBearerThroughput *mm_bearer_throughput_new (void);
+MMBearerThroughput *mm_bearer_throughput_new_from_dictionary (GVariant *dictionary,
+                                                              GError **error);
+
+void mm_bearer_throughput_set_interval   (MMBearerThroughput *self, guint interval);
+void mm_bearer_throughput_set_rx_rate    (MMBearerThroughput *self, guint64 rate);
+void mm_bearer_throughput_set_tx_rate    (MMBearerThroughput *self, guint64 rate);
+void mm_bearer_throughput_set_rx_peak    (MMBearerThroughput *self, guint64 rate);
+void mm_bearer_throughput_set_tx_peak    (MMBearerThroughput *self, guint64 rate);
+void mm_bearer_throughput_set_rx_average (MMBearerThroughput *self, guint64 rate);
+void mm_bearer_throughput_set_tx_average (MMBearerThroughput *self, guint64 rate);
+void mm_bearer_throughput_add_history    (MMBearerThroughput *self, guint32 rx_rate, guint32 tx_rate);
+
+GVariant *mm_bearer_throughput_get_dictionary (MMBearerThroughput *self);
+
+#endif
+
+G_END_DECLS
+
+#endif /* MM_BEARER_THROUGHPUT_H */
@@ -58,6 +58,11 @@ struct _MMBearerPrivate {
     GMutex stats_mutex;
     guint stats_id;
     MMBearerStats *stats;
+
+    /* Throughput */
+    GMutex throughput_mutex;
+    guint throughput_id;
+    MMBearerThroughput *throughput;
 };
 
 /*****************************************************************************/
@@ -669,6 +674,117 @@ mm_bearer_peek_stats (MMBearer *self)
 
 /*****************************************************************************/
 
+static void
+throughput_updated (MMBearer *self,
+                    GParamSpec *pspec)
+{
+    g_mutex_lock (&self->priv->throughput_mutex);
+    {
+        GVariant *dictionary;
+
+        g_clear_object (&self->priv->throughput);
+
+        dictionary = mm_gdbus_bearer_get_throughput (MM_GDBUS_BEARER (self));
+        if (dictionary) {
+            GError *error = NULL;
+
+            self->priv->throughput = mm_bearer_throughput_new_from_dictionary (dictionary, &error);
+            if (error) {
+                g_warning ("Invalid bearer throughput update received: %s", error->message);
+                g_error_free (error);
+            }
+        }
+    }
+    g_mutex_unlock (&self->priv->throughput_mutex);
+}
+
+static void
+ensure_internal_throughput (MMBearer *self,
+                            MMBearerThroughput **dup)
+{
+    g_mutex_lock (&self->priv->throughput_mutex);
+    {
+        /* If this is the first time ever asking for the object, setup the
+         * update listener and the initial object, if any. */
+        if (!self->priv->throughput_id) {
+            GVariant *dictionary;
+
+            dictionary = mm_gdbus_bearer_dup_throughput (MM_GDBUS_BEARER (self));
+            if (dictionary) {
+                GError *error = NULL;
+
+                self->priv->throughput = mm_bearer_throughput_new_from_dictionary (dictionary, &error);
+                if (error) {
+                    g_warning ("Invalid initial bearer throughput: %s", error->message);
+                    g_error_free (error);
+                }
+                g_variant_unref (dictionary);
+            }
+
+            /* No need to clear this signal connection when freeing self */
+            self->priv->throughput_id =
+                g_signal_connect (self,
+                                  "notify::throughput",
+                                  G_CALLBACK (throughput_updated),
+                                  NULL);
+        }
+
+        if (dup && self->priv->throughput)
+            *dup = g_object_ref (self->priv->throughput);
+    }
+    g_mutex_unlock (&self->priv->throughput_mutex);
+}
+
+/**
+ * mm_bearer_get_throughput:
+ * @self: A #MMBearer.
+ *
+ * Gets a #MMBearerThroughput object specifying the throughput of the current bearer
+ * connection, as sampled by the daemon.
+ *
+ * <warning>The values reported by @self are not updated when the values in the
+ * interface change. Instead, the client is expected to call
+ * mm_bearer_get_throughput() again to get a new #MMBearerThroughput with the
+ * new values.</warning>
+ *
+ * Returns: (transfer full): A #MMBearerThroughput that must be freed with g_object_unref() or %NULL if unknown.
+ */
+MMBearerThroughput *
+mm_bearer_get_throughput (MMBearer *self)
+{
+    MMBearerThroughput *throughput = NULL;
+
+    g_return_val_if_fail (MM_IS_BEARER (self), NULL);
+
+    ensure_internal_throughput (self, &throughput);
+    return throughput;
+}
+
+/**
+ * mm_bearer_peek_throughput:
+ * @self: A #MMBearer.
+ *
+ * Gets a #MMBearerThroughput object specifying the throughput of the current bearer
+ * connection, as sampled by the daemon.
+ *
+ * <warning>The returned value is only valid until the property changes so
+ * it is only safe to use this function on the thread where
+ * @self was constructed. Use mm_bearer_get_throughput() if on another
+ * thread.</warning>
+ *
+ * Returns: (transfer none): A #MMBearerThroughput. Do not free the returned value, it belongs to @self.
+ */
+MMBearerThroughput *
+mm_bearer_peek_throughput (MMBearer *self)
+{
+    g_return_val_if_fail (MM_IS_BEARER (self), NULL);
+
+    ensure_internal_throughput (self, NULL);
+    return self->priv->throughput;
+}
+
+/*****************************************************************************/
+
 /**
  * mm_bearer_connect_finish:
  * @self: A #MMBearer.
@@ -822,6 +938,7 @@ mm_bearer_init (MMBearer *self)
     g_mutex_init (&self->priv->ipv6_config_mutex);
     g_mutex_init (&self->priv->properties_mutex);
     g_mutex_init (&self->priv->stats_mutex);
+    g_mutex_init (&self->priv->throughput_mutex);
 }
 
 static void
@@ -833,6 +950,7 @@ finalize (GObject *object)
     g_mutex_clear (&self->priv->ipv6_config_mutex);
     g_mutex_clear (&self->priv->properties_mutex);
     g_mutex_clear (&self->priv->stats_mutex);
+    g_mutex_clear (&self->priv->throughput_mutex);
 
     G_OBJECT_CLASS (mm_bearer_parent_class)->finalize (object);
 }
@@ -846,6 +964,7 @@ dispose (GObject *object)
     g_clear_object (&self->priv->ipv6_config);
     g_clear_object (&self->priv->properties);
     g_clear_object (&self->priv->stats);
+    g_clear_object (&self->priv->throughput);
 
     G_OBJECT_CLASS (mm_bearer_parent_class)->dispose (object);
 }
@@ -34,6 +34,7 @@
 #include "mm-bearer-properties.h"
 #include "mm-bearer-ip-config.h"
 #include "mm-bearer-stats.h"
+#include "mm-bearer-throughput.h"
 
 G_BEGIN_DECLS
 
@@ -119,6 +120,9 @@ MMBearerIpConfig   *mm_bearer_peek_ipv6_config (MMBearer *self);
 MMBearerStats      *mm_bearer_get_stats        (MMBearer *self);
 MMBearerStats      *mm_bearer_peek_stats       (MMBearer *self);
 
+MMBearerThroughput *mm_bearer_get_throughput   (MMBearer *self);
+MMBearerThroughput *mm_bearer_peek_throughput  (MMBearer *self);
+
 G_END_DECLS
 
 #endif /* _MM_BEARER_H_ */
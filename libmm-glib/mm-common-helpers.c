@@ -1585,16 +1585,18 @@ mm_sms_delivery_state_get_string_extended (guint delivery_state)
 
 /* From hostap, Copyright (c) 2002-2005, Jouni Malinen <jkmaline@cc.hut.fi> */
 
-static gint
+/* Value of each hex digit plus one, so that 0 means 'not a hex digit' */
+static const guint8 hex_values[256] = {
+    ['0'] = 1,  ['1'] = 2,  ['2'] = 3,  ['3'] = 4,  ['4'] = 5,
+    ['5'] = 6,  ['6'] = 7,  ['7'] = 8,  ['8'] = 9,  ['9'] = 10,
+    ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+    ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+};
+
+static inline gint
 hex2num (gchar c)
 {
-    if (c >= '0' && c <= '9')
-        return c - '0';
-    if (c >= 'a' && c <= 'f')
-        return c - 'a' + 10;
-    if (c >= 'A' && c <= 'F')
-        return c - 'A' + 10;
-    return -1;
+    return (gint) hex_values[(guint8) c] - 1;
 }
 
 gint
@@ -1611,14 +1613,35 @@ mm_utils_hex2byte (const gchar *hex)
     return (a << 4) | b;
 }
 
+gboolean
+mm_utils_hexstr2bin_into (const gchar *hex,
+                          gsize len,
+                          guint8 *out)
+{
+    const guint8 *ipos = (const guint8 *) hex;
+    guint8 invalid = 0;
+    gsize i;
+
+    /* Length must be a multiple of 2 */
+    g_return_val_if_fail ((len % 2) == 0, FALSE);
+
+    /* Invalid digits are only checked once at the end, so that the loop
+     * doesn't need to branch on every character */
+    for (i = 0; i < len; i += 2) {
+        guint8 a, b;
+
+        a = hex_values[ipos[i]];
+        b = hex_values[ipos[i + 1]];
+        invalid |= (!a | !b);
+        *out++ = ((a - 1) << 4) | ((b - 1) & 0x0F);
+    }
+    return !invalid;
+}
+
 gchar *
 mm_utils_hexstr2bin (const gchar *hex, gsize *out_len)
 {
-    const gchar *ipos = hex;
-    gchar *buf = NULL;
-    gsize i;
-    gint a;
-    gchar *opos;
+    guint8 *buf;
     gsize len;
 
     len = strlen (hex);
@@ -1626,18 +1649,14 @@ mm_utils_hexstr2bin (const gchar *hex, gsize *out_len)
     /* Length must be a multiple of 2 */
     g_return_val_if_fail ((len % 2) == 0, NULL);
 
-    opos = buf = g_malloc0 ((len / 2) + 1);
-    for (i = 0; i < len; i += 2) {
-        a = mm_utils_hex2byte (ipos);
-        if (a < 0) {
-            g_free (buf);
-            return NULL;
-        }
-        *opos++ = a;
-        ipos += 2;
+    buf = g_malloc ((len / 2) + 1);
+    if (!mm_utils_hexstr2bin_into (hex, len, buf)) {
+        g_free (buf);
+        return NULL;
     }
+    buf[len / 2] = '\0';
     *out_len = len / 2;
-    return buf;
+    return (gchar *) buf;
 }
 
 /* End from hostap */
@@ -1655,13 +1674,8 @@ mm_utils_ishexstr (const gchar *hex)
 
     for (i = 0; i < len; i++) {
         /* Non-hex char? */
-        if (hex[i] >= '0' && hex[i] <= '9')
-            continue;
-        if (hex[i] >= 'a' && hex[i] <= 'f')
-            continue;
-        if (hex[i] >= 'A' && hex[i] <= 'F')
-            continue;
-        return FALSE;
+        if (!hex_values[(guint8) hex[i]])
+            return FALSE;
     }
 
     return TRUE;
@@ -1670,15 +1684,19 @@ mm_utils_ishexstr (const gchar *hex)
 gchar *
 mm_utils_bin2hexstr (const guint8 *bin, gsize len)
 {
-    GString *ret;
+    static const gchar digits[] = "0123456789ABCDEF";
+    gchar *ret;
     gsize i;
 
     g_return_val_if_fail (bin != NULL, NULL);
 
-    ret = g_string_sized_new (len * 2 + 1);
-    for (i = 0; i < len; i++)
-        g_string_append_printf (ret, "%.2X", bin[i]);
-    return g_string_free (ret, FALSE);
+    ret = g_malloc (len * 2 + 1);
+    for (i = 0; i < len; i++) {
+        ret[2 * i]     = digits[bin[i] >> 4];
+        ret[2 * i + 1] = digits[bin[i] & 0x0F];
+    }
+    ret[len * 2] = '\0';
+    return ret;
 }
 
 gboolean
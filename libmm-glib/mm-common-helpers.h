@@ -176,6 +176,8 @@ const gchar *mm_sms_delivery_state_get_string_extended (guint delivery_state);
 
 gint      mm_utils_hex2byte   (const gchar *hex);
 gchar    *mm_utils_hexstr2bin (const gchar *hex, gsize *out_len);
+/* @out must hold at least @len / 2 bytes */
+gboolean  mm_utils_hexstr2bin_into (const gchar *hex, gsize len, guint8 *out);
 gchar    *mm_utils_bin2hexstr (const guint8 *bin, gsize len);
 gboolean  mm_utils_ishexstr   (const gchar *hex);
 
@@ -528,6 +528,130 @@ mm_manager_scan_devices_sync (MMManager     *manager,
 
 /*****************************************************************************/
 
+/**
+ * mm_manager_get_poll_timeline_finish:
+ * @manager: A #MMManager.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_manager_get_poll_timeline().
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mm_manager_get_poll_timeline().
+ *
+ * Returns: (transfer full): A #GVariant of type "a{sv}" with the state of the periodic checks, or #NULL if @error is set. The returned value should be freed with g_variant_unref().
+ */
+GVariant *
+mm_manager_get_poll_timeline_finish (MMManager     *manager,
+                                     GAsyncResult  *res,
+                                     GError       **error)
+{
+    return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+static void
+get_poll_timeline_ready (MmGdbusOrgFreedesktopModemManager1 *manager_iface_proxy,
+                         GAsyncResult                       *res,
+                         GTask                              *task)
+{
+    GError *error = NULL;
+    GVariant *timeline = NULL;
+
+    if (!mm_gdbus_org_freedesktop_modem_manager1_call_get_poll_timeline_finish (
+            manager_iface_proxy,
+            &timeline,
+            res,
+            &error))
+        g_task_return_error (task, error);
+    else
+        g_task_return_pointer (task, timeline, (GDestroyNotify) g_variant_unref);
+
+    g_object_unref (task);
+}
+
+/**
+ * mm_manager_get_poll_timeline:
+ * @manager: A #MMManager.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously gets the state of the periodic checks run by the daemon for
+ * all modems and bearers.
+ *
+ * This is a debugging aid, only allowed when ModemManager runs in debug mode.
+ *
+ * When the operation is finished, @callback will be invoked in the
+ * <link linkend="g-main-context-push-thread-default">thread-default main loop</link>
+ * of the thread you are calling this method from. You can then call
+ * mm_manager_get_poll_timeline_finish() to get the result of the operation.
+ *
+ * See mm_manager_get_poll_timeline_sync() for the synchronous, blocking version of this method.
+ */
+void
+mm_manager_get_poll_timeline (MMManager           *manager,
+                              GCancellable        *cancellable,
+                              GAsyncReadyCallback  callback,
+                              gpointer             user_data)
+{
+    GTask *task;
+    GError *inner_error = NULL;
+
+    g_return_if_fail (MM_IS_MANAGER (manager));
+
+    task = g_task_new (manager, cancellable, callback, user_data);
+
+    if (!ensure_modem_manager1_proxy (manager, &inner_error)) {
+        g_task_return_error (task, inner_error);
+        g_object_unref (task);
+        return;
+    }
+
+    mm_gdbus_org_freedesktop_modem_manager1_call_get_poll_timeline (
+        manager->priv->manager_iface_proxy,
+        cancellable,
+        (GAsyncReadyCallback)get_poll_timeline_ready,
+        task);
+}
+
+/**
+ * mm_manager_get_poll_timeline_sync:
+ * @manager: A #MMManager.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously gets the state of the periodic checks run by the daemon for
+ * all modems and bearers.
+ *
+ * This is a debugging aid, only allowed when ModemManager runs in debug mode.
+ *
+ * The calling thread is blocked until a reply is received.
+ *
+ * See mm_manager_get_poll_timeline() for the asynchronous version of this method.
+ *
+ * Returns: (transfer full): A #GVariant of type "a{sv}" with the state of the periodic checks, or #NULL if @error is set. The returned value should be freed with g_variant_unref().
+ */
+GVariant *
+mm_manager_get_poll_timeline_sync (MMManager     *manager,
+                                   GCancellable  *cancellable,
+                                   GError       **error)
+{
+    GVariant *timeline = NULL;
+
+    g_return_val_if_fail (MM_IS_MANAGER (manager), NULL);
+
+    if (!ensure_modem_manager1_proxy (manager, error))
+        return NULL;
+
+    if (!mm_gdbus_org_freedesktop_modem_manager1_call_get_poll_timeline_sync (
+            manager->priv->manager_iface_proxy,
+            &timeline,
+            cancellable,
+            error))
+        return NULL;
+
+    return timeline;
+}
+
+/*****************************************************************************/
+
 /**
  * mm_manager_report_kernel_event_finish:
  * @manager: A #MMManager.
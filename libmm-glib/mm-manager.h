@@ -115,6 +115,17 @@ gboolean mm_manager_scan_devices_sync (MMManager     *manager,
                                        GCancellable  *cancellable,
                                        GError       **error);
 
+void      mm_manager_get_poll_timeline        (MMManager           *manager,
+                                               GCancellable        *cancellable,
+                                               GAsyncReadyCallback  callback,
+                                               gpointer             user_data);
+GVariant *mm_manager_get_poll_timeline_finish (MMManager           *manager,
+                                               GAsyncResult        *res,
+                                               GError             **error);
+GVariant *mm_manager_get_poll_timeline_sync   (MMManager           *manager,
+                                               GCancellable        *cancellable,
+                                               GError             **error);
+
 void     mm_manager_report_kernel_event        (MMManager                *manager,
                                                 MMKernelEventProperties  *properties,
                                                 GCancellable             *cancellable,
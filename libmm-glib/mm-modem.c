@@ -2577,6 +2577,92 @@ mm_modem_command_sync (MMModem *self,
 
 /*****************************************************************************/
 
+/**
+ * mm_modem_get_port_stats_finish:
+ * @self: A #MMModem.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_modem_get_port_stats().
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mm_modem_get_port_stats().
+ *
+ * Returns: (transfer full): A #GVariant of type "aa{sv}" with the statistics of each serial port, or #NULL if @error is set. The returned value should be freed with g_variant_unref().
+ */
+GVariant *
+mm_modem_get_port_stats_finish (MMModem *self,
+                                GAsyncResult *res,
+                                GError **error)
+{
+    GVariant *result;
+
+    g_return_val_if_fail (MM_IS_MODEM (self), NULL);
+
+    if (!mm_gdbus_modem_call_get_port_stats_finish (MM_GDBUS_MODEM (self), &result, res, error))
+        return NULL;
+
+    return result;
+}
+
+/**
+ * mm_modem_get_port_stats:
+ * @self: A #MMModem.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously gets the statistics of the commands sent through each serial
+ * port of the modem.
+ *
+ * This is a debugging aid, only allowed when ModemManager runs in debug mode.
+ *
+ * When the operation is finished, @callback will be invoked in the <link linkend="g-main-context-push-thread-default">thread-default main loop</link> of the thread you are calling this method from.
+ * You can then call mm_modem_get_port_stats_finish() to get the result of the operation.
+ *
+ * See mm_modem_get_port_stats_sync() for the synchronous, blocking version of this method.
+ */
+void
+mm_modem_get_port_stats (MMModem *self,
+                         GCancellable *cancellable,
+                         GAsyncReadyCallback callback,
+                         gpointer user_data)
+{
+    g_return_if_fail (MM_IS_MODEM (self));
+
+    mm_gdbus_modem_call_get_port_stats (MM_GDBUS_MODEM (self), cancellable, callback, user_data);
+}
+
+/**
+ * mm_modem_get_port_stats_sync:
+ * @self: A #MMModem.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously gets the statistics of the commands sent through each serial
+ * port of the modem.
+ *
+ * This is a debugging aid, only allowed when ModemManager runs in debug mode.
+ *
+ * The calling thread is blocked until a reply is received. See mm_modem_get_port_stats()
+ * for the asynchronous version of this method.
+ *
+ * Returns: (transfer full): A #GVariant of type "aa{sv}" with the statistics of each serial port, or #NULL if @error is set. The returned value should be freed with g_variant_unref().
+ */
+GVariant *
+mm_modem_get_port_stats_sync (MMModem *self,
+                              GCancellable *cancellable,
+                              GError **error)
+{
+    GVariant *result;
+
+    g_return_val_if_fail (MM_IS_MODEM (self), NULL);
+
+    if (!mm_gdbus_modem_call_get_port_stats_sync (MM_GDBUS_MODEM (self), &result, cancellable, error))
+        return NULL;
+
+    return result;
+}
+
+/*****************************************************************************/
+
 /**
  * mm_modem_set_power_state_finish:
  * @self: A #MMModem.
@@ -280,6 +280,17 @@ gchar    *mm_modem_command_sync   (MMModem *self,
                                    GCancellable *cancellable,
                                    GError **error);
 
+void      mm_modem_get_port_stats        (MMModem *self,
+                                          GCancellable *cancellable,
+                                          GAsyncReadyCallback callback,
+                                          gpointer user_data);
+GVariant *mm_modem_get_port_stats_finish (MMModem *self,
+                                          GAsyncResult *res,
+                                          GError **error);
+GVariant *mm_modem_get_port_stats_sync   (MMModem *self,
+                                          GCancellable *cancellable,
+                                          GError **error);
+
 void     mm_modem_set_power_state        (MMModem *self,
                                           MMModemPowerState state,
                                           GCancellable *cancellable,
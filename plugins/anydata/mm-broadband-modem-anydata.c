@@ -26,6 +26,7 @@
 #include "ModemManager.h"
 #include "mm-serial-parsers.h"
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-modem-helpers.h"
 #include "mm-errors-types.h"
 #include "mm-base-modem-at.h"
@@ -92,8 +93,8 @@ hstate_ready (MMIfaceModemCdma *self,
     response = mm_strip_tag (response, "*HSTATE:");
 
     /* Format is "<at state>,<session state>,<channel>,<pn>,<EcIo>,<rssi>,..." */
-    r = g_regex_new ("\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*([^,\\)]*)\\s*,\\s*([^,\\)]*)\\s*,.*",
-                     G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    r = mm_regex_get ("\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*([^,\\)]*)\\s*,\\s*([^,\\)]*)\\s*,.*",
+                      G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     g_assert (r != NULL);
 
     g_regex_match (r, response, 0, &match_info);
@@ -158,8 +159,8 @@ state_ready (MMIfaceModemCdma *self,
     response = mm_strip_tag (response, "*STATE:");
 
     /* Format is "<channel>,<pn>,<sid>,<nid>,<state>,<rssi>,..." */
-    r = g_regex_new ("\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*([^,\\)]*)\\s*,.*",
-                     G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    r = mm_regex_get ("\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*([^,\\)]*)\\s*,.*",
+                      G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     g_assert (r != NULL);
 
     g_regex_match (r, response, 0, &match_info);
@@ -279,17 +280,17 @@ setup_ports (MMBroadbandModem *self)
         /* Data state notifications */
 
         /* Data call has connected */
-        regex = g_regex_new ("\\r\\n\\*ACTIVE:(.*)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get ("\\r\\n\\*ACTIVE:(.*)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
         mm_port_serial_at_add_unsolicited_msg_handler (MM_PORT_SERIAL_AT (ports[i]), regex, NULL, NULL, NULL);
         g_regex_unref (regex);
 
         /* Data call disconnected */
-        regex = g_regex_new ("\\r\\n\\*INACTIVE:(.*)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get ("\\r\\n\\*INACTIVE:(.*)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
         mm_port_serial_at_add_unsolicited_msg_handler (MM_PORT_SERIAL_AT (ports[i]), regex, NULL, NULL, NULL);
         g_regex_unref (regex);
 
         /* Modem is now dormant */
-        regex = g_regex_new ("\\r\\n\\*DORMANT:(.*)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get ("\\r\\n\\*DORMANT:(.*)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
         mm_port_serial_at_add_unsolicited_msg_handler (MM_PORT_SERIAL_AT (ports[i]), regex, NULL, NULL, NULL);
         g_regex_unref (regex);
 
@@ -300,17 +301,17 @@ setup_ports (MMBroadbandModem *self)
          */
 
         /* Network acquisition fail */
-        regex = g_regex_new ("\\r\\n\\*OFFLINE:(.*)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get ("\\r\\n\\*OFFLINE:(.*)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
         mm_port_serial_at_add_unsolicited_msg_handler (MM_PORT_SERIAL_AT (ports[i]), regex, NULL, NULL, NULL);
         g_regex_unref (regex);
 
         /* Registration fail */
-        regex = g_regex_new ("\\r\\n\\*REGREQ:(.*)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get ("\\r\\n\\*REGREQ:(.*)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
         mm_port_serial_at_add_unsolicited_msg_handler (MM_PORT_SERIAL_AT (ports[i]), regex, NULL, NULL, NULL);
         g_regex_unref (regex);
 
         /* Authentication fail */
-        regex = g_regex_new ("\\r\\n\\*AUTHREQ:(.*)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get ("\\r\\n\\*AUTHREQ:(.*)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
         mm_port_serial_at_add_unsolicited_msg_handler (MM_PORT_SERIAL_AT (ports[i]), regex, NULL, NULL, NULL);
         g_regex_unref (regex);
     }
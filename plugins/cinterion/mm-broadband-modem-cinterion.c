@@ -29,6 +29,7 @@
 #include "mm-modem-helpers.h"
 #include "mm-serial-parsers.h"
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-errors-types.h"
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-3gpp.h"
@@ -533,8 +534,8 @@ modem_power_off (MMIfaceModem        *self,
 
     ctx = g_slice_new0 (PowerOffContext);
     ctx->port = mm_base_modem_get_port_primary (MM_BASE_MODEM (self));
-    ctx->shutdown_regex = g_regex_new ("\\r\\n\\^SHUTDOWN\\r\\n",
-                                       G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    ctx->shutdown_regex = mm_regex_get ("\\r\\n\\^SHUTDOWN\\r\\n",
+                                        G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     ctx->timeout_id = g_timeout_add_seconds (MAX_POWER_OFF_WAIT_TIME_SECS,
                                              (GSourceFunc)power_off_timeout_cb,
                                              task);
@@ -1819,8 +1820,8 @@ mm_broadband_modem_cinterion_init (MMBroadbandModemCinterion *self)
     self->priv->sind_psinfo_support = FEATURE_SUPPORT_UNKNOWN;
     self->priv->swwan_support       = FEATURE_SUPPORT_UNKNOWN;
 
-    self->priv->ciev_psinfo_regex = g_regex_new ("\\r\\n\\+CIEV: psinfo,(\\d+)\\r\\n",
-                                                 G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->ciev_psinfo_regex = mm_regex_get ("\\r\\n\\+CIEV: psinfo,(\\d+)\\r\\n",
+                                                  G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
 }
 
 static void
@@ -24,6 +24,7 @@
 #define _LIBMM_INSIDE_MM
 #include <libmm-glib.h>
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-charsets.h"
 #include "mm-errors-types.h"
 #include "mm-modem-helpers-cinterion.h"
@@ -109,9 +110,9 @@ mm_cinterion_parse_scfg_test (const gchar *response,
         return FALSE;
     }
 
-    r = g_regex_new ("\\^SCFG:\\s*\"Radio/Band\",\\((?:\")?([0-9]*)(?:\")?-(?:\")?([0-9]*)(?:\")?.*\\)",
-                     G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
-                     0, NULL);
+    r = mm_regex_get ("\\^SCFG:\\s*\"Radio/Band\",\\((?:\")?([0-9]*)(?:\")?-(?:\")?([0-9]*)(?:\")?.*\\)",
+                      G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
+                      0, NULL);
     g_assert (r != NULL);
 
     g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -198,7 +199,7 @@ mm_cinterion_parse_scfg_response (const gchar *response,
         return FALSE;
     }
 
-    r = g_regex_new ("\\^SCFG:\\s*\"Radio/Band\",\\s*\"?([0-9a-fA-F]*)\"?", 0, 0, NULL);
+    r = mm_regex_get ("\\^SCFG:\\s*\"Radio/Band\",\\s*\"?([0-9a-fA-F]*)\"?", 0, 0, NULL);
     g_assert (r != NULL);
 
     if (g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, NULL)) {
@@ -283,9 +284,9 @@ mm_cinterion_parse_cnmi_test (const gchar *response,
         return FALSE;
     }
 
-    r = g_regex_new ("\\+CNMI:\\s*\\((.*)\\),\\((.*)\\),\\((.*)\\),\\((.*)\\),\\((.*)\\)",
-                     G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
-                     0, NULL);
+    r = mm_regex_get ("\\+CNMI:\\s*\\((.*)\\),\\((.*)\\),\\((.*)\\),\\((.*)\\),\\((.*)\\)",
+                      G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
+                      0, NULL);
     g_assert (r != NULL);
 
     g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -438,7 +439,7 @@ mm_cinterion_parse_sind_response (const gchar *response,
         return FALSE;
     }
 
-    r = g_regex_new ("\\^SIND:\\s*(.*),(\\d+),(\\d+)(\\r\\n)?", 0, 0, NULL);
+    r = mm_regex_get ("\\^SIND:\\s*(.*),(\\d+),(\\d+)(\\r\\n)?", 0, 0, NULL);
     g_assert (r != NULL);
 
     if (g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, NULL)) {
@@ -519,8 +520,8 @@ mm_cinterion_parse_swwan_response (const gchar  *response,
         return MM_BEARER_CONNECTION_STATUS_UNKNOWN;
     }
 
-    r = g_regex_new ("\\^SWWAN:\\s*(\\d+),\\s*(\\d+)(?:,\\s*(\\d+))?(?:\\r\\n)?",
-                     G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW, 0, NULL);
+    r = mm_regex_get ("\\^SWWAN:\\s*(\\d+),\\s*(\\d+)(?:,\\s*(\\d+))?(?:\\r\\n)?",
+                      G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW, 0, NULL);
     g_assert (r != NULL);
 
     status = MM_BEARER_CONNECTION_STATUS_UNKNOWN;
@@ -606,11 +607,11 @@ mm_cinterion_parse_smong_response (const gchar              *response,
      * 0776  1  -      -   214   03  2    00      01
      * OK
      */
-    regex = g_regex_new (".*GPRS Monitor(?:\r\n)*"
-                         "BCCH\\s*G.*\\r\\n"
-                         "\\s*(\\d+)\\s*(\\d+)\\s*",
-                         G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
-                         0, NULL);
+    regex = mm_regex_get (".*GPRS Monitor(?:\r\n)*"
+                          "BCCH\\s*G.*\\r\\n"
+                          "\\s*(\\d+)\\s*(\\d+)\\s*",
+                          G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
+                          0, NULL);
     g_assert (regex);
 
     if (g_regex_match_full (regex, response, strlen (response), 0, 0, &match_info, &inner_error)) {
@@ -32,6 +32,7 @@
 #include <libmm-glib.h>
 
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-errors-types.h"
 #include "mm-modem-helpers.h"
 #include "mm-modem-helpers-huawei.h"
@@ -643,8 +644,8 @@ load_unlock_retries_finish (MMIfaceModem *self,
     if (!result)
         return NULL;
 
-    r = g_regex_new ("\\^CPIN:\\s*([^,]+),[^,]*,(\\d+),(\\d+),(\\d+),(\\d+)",
-                     G_REGEX_UNGREEDY, 0, NULL);
+    r = mm_regex_get ("\\^CPIN:\\s*([^,]+),[^,]*,(\\d+),(\\d+),(\\d+),(\\d+)",
+                      G_REGEX_UNGREEDY, 0, NULL);
     g_assert (r != NULL);
 
     if (!g_regex_match_full (r, result, strlen (result), 0, 0, &match_info, &match_error)) {
@@ -4092,62 +4093,62 @@ mm_broadband_modem_huawei_init (MMBroadbandModemHuawei *self)
                                               MM_TYPE_BROADBAND_MODEM_HUAWEI,
                                               MMBroadbandModemHuaweiPrivate);
     /* Prepare regular expressions to setup */
-    self->priv->rssi_regex = g_regex_new ("\\r\\n\\^RSSI:\\s*(\\d+)\\r\\n",
-                                           G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->rssilvl_regex = g_regex_new ("\\r\\n\\^RSSILVL:\\s*(\\d+)\\r+\\n",
-                                             G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->hrssilvl_regex = g_regex_new ("\\r\\n\\^HRSSILVL:\\s*(\\d+)\\r+\\n",
+    self->priv->rssi_regex = mm_regex_get ("\\r\\n\\^RSSI:\\s*(\\d+)\\r\\n",
+                                            G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->rssilvl_regex = mm_regex_get ("\\r\\n\\^RSSILVL:\\s*(\\d+)\\r+\\n",
                                               G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->hrssilvl_regex = mm_regex_get ("\\r\\n\\^HRSSILVL:\\s*(\\d+)\\r+\\n",
+                                               G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
 
     /* 3GPP: <cr><lf>^MODE:5<cr><lf>
      * CDMA: <cr><lf>^MODE: 2<cr><cr><lf>
      */
-    self->priv->mode_regex = g_regex_new ("\\r\\n\\^MODE:\\s*(\\d*),?(\\d*)\\r+\\n",
-                                          G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->dsflowrpt_regex = g_regex_new ("\\r\\n\\^DSFLOWRPT:(.+)\\r\\n",
+    self->priv->mode_regex = mm_regex_get ("\\r\\n\\^MODE:\\s*(\\d*),?(\\d*)\\r+\\n",
+                                           G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->dsflowrpt_regex = mm_regex_get ("\\r\\n\\^DSFLOWRPT:(.+)\\r\\n",
+                                                G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->ndisstat_regex = mm_regex_get ("\\r\\n(\\^NDISSTAT:.+)\\r+\\n",
                                                G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->ndisstat_regex = g_regex_new ("\\r\\n(\\^NDISSTAT:.+)\\r+\\n",
-                                              G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->boot_regex = g_regex_new ("\\r\\n\\^BOOT:.+\\r\\n",
-                                          G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->connect_regex = g_regex_new ("\\r\\n\\^CONNECT .+\\r\\n",
-                                          G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->csnr_regex = g_regex_new ("\\r\\n\\^CSNR:.+\\r\\n",
+    self->priv->boot_regex = mm_regex_get ("\\r\\n\\^BOOT:.+\\r\\n",
+                                           G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->connect_regex = mm_regex_get ("\\r\\n\\^CONNECT .+\\r\\n",
                                           G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->cusatp_regex = g_regex_new ("\\r\\n\\+CUSATP:.+\\r\\n",
-                                            G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->cusatend_regex = g_regex_new ("\\r\\n\\+CUSATEND\\r\\n",
-                                              G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->dsdormant_regex = g_regex_new ("\\r\\n\\^DSDORMANT:.+\\r\\n",
+    self->priv->csnr_regex = mm_regex_get ("\\r\\n\\^CSNR:.+\\r\\n",
+                                           G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->cusatp_regex = mm_regex_get ("\\r\\n\\+CUSATP:.+\\r\\n",
+                                             G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->cusatend_regex = mm_regex_get ("\\r\\n\\+CUSATEND\\r\\n",
                                                G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->simst_regex = g_regex_new ("\\r\\n\\^SIMST:.+\\r\\n",
+    self->priv->dsdormant_regex = mm_regex_get ("\\r\\n\\^DSDORMANT:.+\\r\\n",
+                                                G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->simst_regex = mm_regex_get ("\\r\\n\\^SIMST:.+\\r\\n",
+                                            G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->srvst_regex = mm_regex_get ("\\r\\n\\^SRVST:.+\\r\\n",
+                                            G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->stin_regex = mm_regex_get ("\\r\\n\\^STIN:.+\\r\\n",
                                            G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->srvst_regex = g_regex_new ("\\r\\n\\^SRVST:.+\\r\\n",
+    self->priv->hcsq_regex = mm_regex_get ("\\r\\n(\\^HCSQ:.+)\\r+\\n",
                                            G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->stin_regex = g_regex_new ("\\r\\n\\^STIN:.+\\r\\n",
-                                          G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->hcsq_regex = g_regex_new ("\\r\\n(\\^HCSQ:.+)\\r+\\n",
-                                          G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->pdpdeact_regex = g_regex_new ("\\r\\n\\^PDPDEACT:.+\\r+\\n",
+    self->priv->pdpdeact_regex = mm_regex_get ("\\r\\n\\^PDPDEACT:.+\\r+\\n",
+                                               G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->ndisend_regex = mm_regex_get ("\\r\\n\\^NDISEND:.+\\r+\\n",
                                               G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->ndisend_regex = g_regex_new ("\\r\\n\\^NDISEND:.+\\r+\\n",
+    self->priv->rfswitch_regex = mm_regex_get ("\\r\\n\\^RFSWITCH:.+\\r\\n",
+                                               G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->position_regex = mm_regex_get ("\\r\\n\\^POSITION:.+\\r\\n",
+                                               G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->posend_regex = mm_regex_get ("\\r\\n\\^POSEND:.+\\r\\n",
                                              G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->rfswitch_regex = g_regex_new ("\\r\\n\\^RFSWITCH:.+\\r\\n",
+    self->priv->ecclist_regex = mm_regex_get ("\\r\\n\\^ECCLIST:.+\\r\\n",
                                               G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->position_regex = g_regex_new ("\\r\\n\\^POSITION:.+\\r\\n",
-                                              G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->posend_regex = g_regex_new ("\\r\\n\\^POSEND:.+\\r\\n",
-                                            G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->ecclist_regex = g_regex_new ("\\r\\n\\^ECCLIST:.+\\r\\n",
-                                             G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->ltersrp_regex = g_regex_new ("\\r\\n\\^LTERSRP:.+\\r\\n",
-                                             G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->cschannelinfo_regex = g_regex_new ("\\r\\n\\^CSCHANNELINFO:.+\\r\\n",
-                                                    G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->eons_regex = g_regex_new ("\\r\\n\\^EONS:.+\\r\\n",
-                                          G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->orig_regex = g_regex_new ("\\r\\n\\^ORIG:.+\\r\\n",
+    self->priv->ltersrp_regex = mm_regex_get ("\\r\\n\\^LTERSRP:.+\\r\\n",
                                               G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->cschannelinfo_regex = mm_regex_get ("\\r\\n\\^CSCHANNELINFO:.+\\r\\n",
+                                                     G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->eons_regex = mm_regex_get ("\\r\\n\\^EONS:.+\\r\\n",
+                                           G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->orig_regex = mm_regex_get ("\\r\\n\\^ORIG:.+\\r\\n",
+                                               G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
 
     self->priv->ndisdup_support = FEATURE_SUPPORT_UNKNOWN;
     self->priv->rfswitch_support = FEATURE_SUPPORT_UNKNOWN;
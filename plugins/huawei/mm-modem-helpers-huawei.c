@@ -23,6 +23,7 @@
 #include <libmm-glib.h>
 
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-modem-helpers.h"
 #include "mm-modem-helpers-huawei.h"
 
@@ -69,10 +70,10 @@ mm_huawei_parse_ndisstatqry_response (const gchar *response,
 
     /* If multiple fields available, try first parsing method */
     if (strchr (response, ',')) {
-        r = g_regex_new ("\\^NDISSTAT(?:QRY)?(?:Qry)?:\\s*(\\d),([^,]*),([^,]*),([^,\\r\\n]*)(?:\\r\\n)?"
-                         "(?:\\^NDISSTAT:|\\^NDISSTATQRY:)?\\s*,?(\\d)?,?([^,]*)?,?([^,]*)?,?([^,\\r\\n]*)?(?:\\r\\n)?",
-                         G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
-                         0, NULL);
+        r = mm_regex_get ("\\^NDISSTAT(?:QRY)?(?:Qry)?:\\s*(\\d),([^,]*),([^,]*),([^,\\r\\n]*)(?:\\r\\n)?"
+                          "(?:\\^NDISSTAT:|\\^NDISSTATQRY:)?\\s*,?(\\d)?,?([^,]*)?,?([^,]*)?,?([^,\\r\\n]*)?(?:\\r\\n)?",
+                          G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
+                          0, NULL);
         g_assert (r != NULL);
 
         g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -112,9 +113,9 @@ mm_huawei_parse_ndisstatqry_response (const gchar *response,
     }
     /* No separate IPv4/IPv6 info given just connected/not connected */
     else {
-        r = g_regex_new ("\\^NDISSTAT(?:QRY)?(?:Qry)?:\\s*(\\d)(?:\\r\\n)?",
-                         G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
-                         0, NULL);
+        r = mm_regex_get ("\\^NDISSTAT(?:QRY)?(?:Qry)?:\\s*(\\d)(?:\\r\\n)?",
+                          G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
+                          0, NULL);
         g_assert (r != NULL);
 
         g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -230,7 +231,7 @@ mm_huawei_parse_dhcp_response (const char *reply,
      * actually 10.10.1.1.
      */
 
-    r = g_regex_new ("\\^DHCP:\\s*(?:0[xX])?([0-9a-fA-F]+),(?:0[xX])?([0-9a-fA-F]+),(?:0[xX])?([0-9a-fA-F]+),(?:0[xX])?([0-9a-fA-F]+),(?:0[xX])?([0-9a-fA-F]+),(?:0[xX])?([0-9a-fA-F]+),.*$", 0, 0, NULL);
+    r = mm_regex_get ("\\^DHCP:\\s*(?:0[xX])?([0-9a-fA-F]+),(?:0[xX])?([0-9a-fA-F]+),(?:0[xX])?([0-9a-fA-F]+),(?:0[xX])?([0-9a-fA-F]+),(?:0[xX])?([0-9a-fA-F]+),(?:0[xX])?([0-9a-fA-F]+),.*$", 0, 0, NULL);
     g_assert (r != NULL);
 
     matched = g_regex_match_full (r, reply, -1, 0, 0, &match_info, &match_error);
@@ -295,7 +296,7 @@ mm_huawei_parse_sysinfo_response (const char *reply,
      */
 
     /* Can't just use \d here since sometimes you get "^SYSINFO:2,1,0,3,1,,3" */
-    r = g_regex_new ("\\^SYSINFO:\\s*(\\d+),(\\d+),(\\d+),(\\d+),(\\d+),?(\\d+)?,?(\\d+)?$", 0, 0, NULL);
+    r = mm_regex_get ("\\^SYSINFO:\\s*(\\d+),(\\d+),(\\d+),(\\d+),(\\d+),?(\\d+)?,?(\\d+)?$", 0, 0, NULL);
     g_assert (r != NULL);
 
     matched = g_regex_match_full (r, reply, -1, 0, 0, &match_info, &match_error);
@@ -362,7 +363,7 @@ mm_huawei_parse_sysinfoex_response (const char *reply,
 
     /* ^SYSINFOEX:2,3,0,1,,3,"WCDMA",41,"HSPA+" */
 
-    r = g_regex_new ("\\^SYSINFOEX:\\s*(\\d+),(\\d+),(\\d+),(\\d+),?(\\d*),(\\d+),\"?([^\"]*)\"?,(\\d+),\"?([^\"]*)\"?$", 0, 0, NULL);
+    r = mm_regex_get ("\\^SYSINFOEX:\\s*(\\d+),(\\d+),(\\d+),(\\d+),?(\\d*),(\\d+),\"?([^\"]*)\"?,(\\d+),\"?([^\"]*)\"?$", 0, 0, NULL);
     g_assert (r != NULL);
 
     matched = g_regex_match_full (r, reply, -1, 0, 0, &match_info, &match_error);
@@ -1200,7 +1201,7 @@ gboolean mm_huawei_parse_nwtime_response (const gchar *response,
 
     g_assert (iso8601p || tzp); /* at least one */
 
-    r = g_regex_new ("\\^NWTIME:\\s*(\\d+)/(\\d+)/(\\d+),(\\d+):(\\d+):(\\d*)([\\-\\+\\d]+),(\\d+)$", 0, 0, NULL);
+    r = mm_regex_get ("\\^NWTIME:\\s*(\\d+)/(\\d+)/(\\d+),(\\d+):(\\d+):(\\d*)([\\-\\+\\d]+),(\\d+)$", 0, 0, NULL);
     g_assert (r != NULL);
 
     if (!g_regex_match_full (r, response, -1, 0, 0, &match_info, &match_error)) {
@@ -1286,7 +1287,7 @@ gboolean mm_huawei_parse_time_response (const gchar *response,
     }
 
     /* Already in ISO-8601 format, but verify just to be sure */
-    r = g_regex_new ("\\^TIME:\\s*(\\d+)/(\\d+)/(\\d+)\\s*(\\d+):(\\d+):(\\d*)$", 0, 0, NULL);
+    r = mm_regex_get ("\\^TIME:\\s*(\\d+)/(\\d+)/(\\d+)\\s*(\\d+):(\\d+):(\\d*)$", 0, 0, NULL);
     g_assert (r != NULL);
 
     if (!g_regex_match_full (r, response, -1, 0, 0, &match_info, &match_error)) {
@@ -1350,7 +1351,7 @@ mm_huawei_parse_hcsq_response (const gchar *response,
     gboolean ret = FALSE;
     char *s;
 
-    r = g_regex_new ("\\^HCSQ:\\s*\"([a-zA-Z]*)\",(\\d+),?(\\d+)?,?(\\d+)?,?(\\d+)?,?(\\d+)?$", 0, 0, NULL);
+    r = mm_regex_get ("\\^HCSQ:\\s*\"([a-zA-Z]*)\",(\\d+),?(\\d+)?,?(\\d+)?,?(\\d+)?,?(\\d+)?$", 0, 0, NULL);
     g_assert (r != NULL);
 
     if (!g_regex_match_full (r, response, -1, 0, 0, &match_info, &match_error)) {
@@ -1417,7 +1418,7 @@ mm_huawei_parse_cvoice_response (const gchar  *response,
     gboolean ret = FALSE;
 
     /* ^CVOICE: <0=supported,1=unsupported>,<hz>,<bits>,<unknown> */
-    r = g_regex_new ("\\^CVOICE:\\s*(\\d)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)$", 0, 0, NULL);
+    r = mm_regex_get ("\\^CVOICE:\\s*(\\d)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)$", 0, 0, NULL);
     g_assert (r != NULL);
 
     if (!g_regex_match_full (r, response, -1, 0, 0, &match_info, &match_error)) {
@@ -32,6 +32,7 @@
 
 #include "ModemManager.h"
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-bearer-list.h"
 #include "mm-errors-types.h"
 #include "mm-modem-helpers.h"
@@ -1264,6 +1265,7 @@ gps_enabled_ready (MMBaseModem *self,
                                     3,
                                     FALSE, /* never cached */
                                     FALSE, /* always queued last */
+                                    MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                                     NULL,
                                     NULL,
                                     NULL);
@@ -1469,22 +1471,22 @@ mm_broadband_modem_mbm_init (MMBroadbandModemMbm *self)
                                               MMBroadbandModemMbmPrivate);
 
     /* Prepare regular expressions to setup */
-    self->priv->e2nap_regex = g_regex_new ("\\r\\n\\*E2NAP: (\\d)\\r\\n",
-                                           G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->e2nap_ext_regex = g_regex_new ("\\r\\n\\*E2NAP: (\\d),.*\\r\\n",
-                                               G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->emrdy_regex = g_regex_new ("\\r\\n\\*EMRDY: \\d\\r\\n",
-                                           G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->pacsp_regex = g_regex_new ("\\r\\n\\+PACSP(\\d)\\r\\n",
+    self->priv->e2nap_regex = mm_regex_get ("\\r\\n\\*E2NAP: (\\d)\\r\\n",
+                                            G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->e2nap_ext_regex = mm_regex_get ("\\r\\n\\*E2NAP: (\\d),.*\\r\\n",
+                                                G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->emrdy_regex = mm_regex_get ("\\r\\n\\*EMRDY: \\d\\r\\n",
+                                            G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->pacsp_regex = mm_regex_get ("\\r\\n\\+PACSP(\\d)\\r\\n",
+                                            G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->estksmenu_regex = mm_regex_get ("\\R\\*ESTKSMENU:.*\\R",
+                                                G_REGEX_RAW | G_REGEX_OPTIMIZE | G_REGEX_MULTILINE | G_REGEX_NEWLINE_CRLF, G_REGEX_MATCH_NEWLINE_CRLF, NULL);
+    self->priv->estksms_regex = mm_regex_get ("\\r\\n\\*ESTKSMS:.*\\r\\n",
+                                              G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->emwi_regex = mm_regex_get ("\\r\\n\\*EMWI: (\\d),(\\d).*\\r\\n",
                                            G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->estksmenu_regex = g_regex_new ("\\R\\*ESTKSMENU:.*\\R",
-                                               G_REGEX_RAW | G_REGEX_OPTIMIZE | G_REGEX_MULTILINE | G_REGEX_NEWLINE_CRLF, G_REGEX_MATCH_NEWLINE_CRLF, NULL);
-    self->priv->estksms_regex = g_regex_new ("\\r\\n\\*ESTKSMS:.*\\r\\n",
+    self->priv->erinfo_regex = mm_regex_get ("\\r\\n\\*ERINFO:\\s*(\\d),(\\d),(\\d).*\\r\\n",
                                              G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->emwi_regex = g_regex_new ("\\r\\n\\*EMWI: (\\d),(\\d).*\\r\\n",
-                                          G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->erinfo_regex = g_regex_new ("\\r\\n\\*ERINFO:\\s*(\\d),(\\d),(\\d).*\\r\\n",
-                                            G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
 
     self->priv->mbm_mode = MBM_NETWORK_MODE_ANY;
 }
@@ -25,6 +25,7 @@
 
 #include "ModemManager.h"
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-errors-types.h"
 #include "mm-modem-helpers.h"
 #include "mm-base-modem-at.h"
@@ -83,7 +84,7 @@ load_unlock_retries_ready (MMBaseModem *self,
         return;
     }
 
-    r = g_regex_new (
+    r = mm_regex_get (
             "\\+EPINC:\\s*([0-9]+),\\s*([0-9]+),\\s*([0-9]+),\\s*([0-9]+)",
             0,
             0,
@@ -196,7 +197,7 @@ get_supported_modes_ready (MMBaseModem *self,
         return;
     }
 
-    r = g_regex_new ("\\+EGMR:\\s*\"MT([0-9]+)",
+    r = mm_regex_get ("\\+EGMR:\\s*\"MT([0-9]+)",
             G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     g_assert (r != NULL);
 
@@ -324,7 +325,7 @@ load_current_modes_finish (MMIfaceModem *self,
     if (!response)
         return result;
 
-    r = g_regex_new (
+    r = mm_regex_get (
                 "\\+ERAT:\\s*[0-9]+,\\s*[0-9]+,\\s*([0-9]+),\\s*([0-9]+)",
                 0,
                 0,
@@ -888,19 +889,19 @@ mm_broadband_modem_mtk_init (MMBroadbandModemMtk *self)
     self->priv = G_TYPE_INSTANCE_GET_PRIVATE ((self),
                                               MM_TYPE_BROADBAND_MODEM_MTK,
                                               MMBroadbandModemMtkPrivate);
-    self->priv->ecsqg_regex = g_regex_new (
+    self->priv->ecsqg_regex = mm_regex_get (
         "\\r\\n\\+ECSQ:\\s*([0-9]*),\\s*[0-9]*,\\s*-[0-9]*\\r\\n",
         G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->ecsqu_regex = g_regex_new (
+    self->priv->ecsqu_regex = mm_regex_get (
         "\\r\\n\\+ECSQ:\\s*([0-9]*),\\s*[0-9]*,\\s*-[0-9]*,\\s*-[0-9]*,\\s*-[0-9]*\\r\\n",
         G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->ecsqeg_regex = g_regex_new (
+    self->priv->ecsqeg_regex = mm_regex_get (
         "\\r\\n\\+ECSQ:\\s*([0-9]*),\\s*[0-9]*,\\s*-[0-9]*,\\s*1,\\s*1,\\s*1,\\s*1,\\s*[0-9]*\\r\\n",
         G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->ecsqeu_regex = g_regex_new (
+    self->priv->ecsqeu_regex = mm_regex_get (
         "\\r\\n\\+ECSQ:\\s*([0-9]*),\\s*[0-9]*,\\s*1,\\s*-[0-9]*,\\s*-[0-9]*,\\s*1,\\s*1,\\s*[0-9]*\\r\\n",
         G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->ecsqel_regex = g_regex_new (
+    self->priv->ecsqel_regex = mm_regex_get (
         "\\r\\n\\+ECSQ:\\s*[0-9]*,\\s*([0-9]*),\\s*1,\\s*1,\\s*1,\\s*-[0-9]*,\\s*-[0-9]*,\\s*[0-9]*\\r\\n",
         G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
 }
@@ -36,6 +36,7 @@
 #include "libqcdm/src/commands.h"
 #include "libqcdm/src/result.h"
 #include "mm-log.h"
+#include "mm-regex.h"
 
 static void iface_modem_init (MMIfaceModem *iface);
 static void iface_modem_messaging_init (MMIfaceModemMessaging *iface);
@@ -173,7 +174,7 @@ nwrat_query_ready (MMBaseModem *self,
     }
 
     /* Parse response */
-    r = g_regex_new ("\\$NWRAT:\\s*(\\d),(\\d),(\\d)", G_REGEX_UNGREEDY, 0, NULL);
+    r = mm_regex_get ("\\$NWRAT:\\s*(\\d),(\\d),(\\d)", G_REGEX_UNGREEDY, 0, NULL);
     g_assert (r != NULL);
 
     if (!g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &error)) {
@@ -1112,7 +1113,7 @@ parse_nwltime_reply (const char *response,
     gboolean success = FALSE;
 
     /* Sample reply: 2013.3.27.15.47.19.2.-5 */
-    r = g_regex_new ("(\\d+)\\.(\\d+)\\.(\\d+)\\.(\\d+)\\.(\\d+)\\.(\\d+)\\.(\\d+)\\.([\\-\\+\\d]+)$", 0, 0, NULL);
+    r = mm_regex_get ("(\\d+)\\.(\\d+)\\.(\\d+)\\.(\\d+)\\.(\\d+)\\.(\\d+)\\.(\\d+)\\.([\\-\\+\\d]+)$", 0, 0, NULL);
     g_assert (r != NULL);
 
     if (!g_regex_match_full (r, response, -1, 0, 0, &match_info, &match_error)) {
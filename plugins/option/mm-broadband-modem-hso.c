@@ -26,6 +26,7 @@
 #include "ModemManager.h"
 #include "mm-modem-helpers.h"
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-errors-types.h"
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-3gpp.h"
@@ -734,8 +735,8 @@ mm_broadband_modem_hso_init (MMBroadbandModemHso *self)
                                               MM_TYPE_BROADBAND_MODEM_HSO,
                                               MMBroadbandModemHsoPrivate);
 
-    self->priv->_owancall_regex = g_regex_new ("_OWANCALL: (\\d),\\s*(\\d)\\r\\n",
-                                               G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->_owancall_regex = mm_regex_get ("_OWANCALL: (\\d),\\s*(\\d)\\r\\n",
+                                                G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     self->priv->enabled_sources = MM_MODEM_LOCATION_SOURCE_NONE;
 }
 
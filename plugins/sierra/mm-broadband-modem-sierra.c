@@ -27,6 +27,7 @@
 #include "mm-broadband-modem-sierra.h"
 #include "mm-base-modem-at.h"
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-modem-helpers.h"
 #include "mm-errors-types.h"
 #include "mm-iface-modem.h"
@@ -657,7 +658,7 @@ selrat_query_ready (MMBaseModem *self,
     result = g_new0 (LoadCurrentModesResult, 1);
 
     /* Example response: !SELRAT: 03, UMTS 3G Preferred */
-    r = g_regex_new ("!SELRAT:\\s*(\\d+).*$", 0, 0, NULL);
+    r = mm_regex_get ("!SELRAT:\\s*(\\d+).*$", 0, 0, NULL);
     g_assert (r != NULL);
 
     if (g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &error)) {
@@ -1352,7 +1353,7 @@ parse_time (const gchar *response,
     guint year, month, day, hour, minute, second;
     gchar *result = NULL;
 
-    r = g_regex_new (regex, 0, 0, NULL);
+    r = mm_regex_get (regex, 0, 0, NULL);
     g_assert (r != NULL);
 
     if (!g_regex_match_full (r, response, -1, 0, 0, &match_info, &match_error)) {
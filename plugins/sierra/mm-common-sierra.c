@@ -21,6 +21,7 @@
 #include "mm-common-sierra.h"
 #include "mm-base-modem-at.h"
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-modem-helpers.h"
 #include "mm-sim-sierra.h"
 
@@ -482,7 +483,7 @@ mm_common_sierra_setup_ports (MMBroadbandModem *self)
     guint i;
     GRegex *pacsp_regex;
 
-    pacsp_regex = g_regex_new ("\\r\\n\\+PACSP.*\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    pacsp_regex = mm_regex_get ("\\r\\n\\+PACSP.*\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
 
     ports[0] = mm_base_modem_peek_port_primary (MM_BASE_MODEM (self));
     ports[1] = mm_base_modem_peek_port_secondary (MM_BASE_MODEM (self));
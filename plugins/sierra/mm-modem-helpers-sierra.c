@@ -17,6 +17,7 @@
 #include <string.h>
 
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-modem-helpers.h"
 #include "mm-modem-helpers-sierra.h"
 
@@ -34,8 +35,8 @@ mm_sierra_parse_scact_read_response (const gchar  *reply,
         return NULL;
 
     list = NULL;
-    r = g_regex_new ("!SCACT:\\s*(\\d+),(\\d+)",
-                     G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW, 0, &inner_error);
+    r = mm_regex_get ("!SCACT:\\s*(\\d+),(\\d+)",
+                      G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW, 0, &inner_error);
     g_assert (r);
 
     g_regex_match_full (r, reply, strlen (reply), 0, 0, &match_info, &inner_error);
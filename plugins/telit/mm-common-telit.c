@@ -17,6 +17,7 @@
 
 #include "mm-common-telit.h"
 #include "mm-log.h"
+#include "mm-regex.h"
 
 /*****************************************************************************/
 
@@ -109,7 +110,7 @@ cache_port_mode (MMDevice *device,
     guint portcfg_current;
 
     /* #PORTCFG: <requested>,<active> */
-    r = g_regex_new ("#PORTCFG:\\s*(\\d+),(\\d+)", flags, 0, NULL);
+    r = mm_regex_get ("#PORTCFG:\\s*(\\d+),(\\d+)", flags, 0, NULL);
     g_assert (r != NULL);
 
     if (!g_regex_match_full (r, reply, strlen (reply), 0, 0, &match_info, &error))
@@ -24,6 +24,7 @@
 #include <libmm-glib.h>
 
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-modem-helpers.h"
 #include "mm-modem-helpers-telit.h"
 
@@ -204,11 +205,11 @@ mm_telit_parse_bnd_response (const gchar *response,
     switch (band_type) {
         case LOAD_SUPPORTED_BANDS:
             /* Parse #BND=? response */
-            r = g_regex_new (SUPP_BAND_RESPONSE_REGEX, G_REGEX_RAW, 0, NULL);
+            r = mm_regex_get (SUPP_BAND_RESPONSE_REGEX, G_REGEX_RAW, 0, NULL);
             break;
         case LOAD_CURRENT_BANDS:
             /* Parse #BND? response */
-            r = g_regex_new (CURR_BAND_RESPONSE_REGEX, G_REGEX_RAW, 0, NULL);
+            r = mm_regex_get (CURR_BAND_RESPONSE_REGEX, G_REGEX_RAW, 0, NULL);
         default:
             break;
     }
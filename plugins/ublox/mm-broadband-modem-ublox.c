@@ -23,6 +23,7 @@
 
 #include "ModemManager.h"
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-3gpp.h"
 #include "mm-iface-modem-voice.h"
@@ -1396,8 +1397,8 @@ mm_broadband_modem_ublox_init (MMBroadbandModemUblox *self)
     self->priv->support_config.method   = SETTINGS_UPDATE_METHOD_UNKNOWN;
     self->priv->support_config.uact     = FEATURE_SUPPORT_UNKNOWN;
     self->priv->support_config.ubandsel = FEATURE_SUPPORT_UNKNOWN;
-    self->priv->pbready_regex = g_regex_new ("\\r\\n\\+PBREADY\\r\\n",
-                                             G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->pbready_regex = mm_regex_get ("\\r\\n\\+PBREADY\\r\\n",
+                                              G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
 }
 
 static void
@@ -17,6 +17,7 @@
 #include <string.h>
 
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-modem-helpers.h"
 #include "mm-modem-helpers-ublox.h"
 
@@ -48,7 +49,7 @@ mm_ublox_parse_upincnt_response (const gchar  *response,
     /* Response may be e.g.:
      * +UPINCNT: 3,3,10,10
      */
-    r = g_regex_new ("\\+UPINCNT: (\\d+),(\\d+),(\\d+),(\\d+)(?:\\r\\n)?", 0, 0, NULL);
+    r = mm_regex_get ("\\+UPINCNT: (\\d+),(\\d+),(\\d+),(\\d+)(?:\\r\\n)?", 0, 0, NULL);
     g_assert (r != NULL);
 
     g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -122,7 +123,7 @@ mm_ublox_parse_uusbconf_response (const gchar        *response,
      * Note: we don't rely on the PID; assuming future new modules will
      * have a different PID but they may keep the profile names.
      */
-    r = g_regex_new ("\\+UUSBCONF: (\\d+),([^,]*),([^,]*),([^,]*)(?:\\r\\n)?", 0, 0, NULL);
+    r = mm_regex_get ("\\+UUSBCONF: (\\d+),([^,]*),([^,]*),([^,]*)(?:\\r\\n)?", 0, 0, NULL);
     g_assert (r != NULL);
 
     g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -180,7 +181,7 @@ mm_ublox_parse_ubmconf_response (const gchar            *response,
      * +UBMCONF: 1
      * +UBMCONF: 2
      */
-    r = g_regex_new ("\\+UBMCONF: (\\d+)(?:\\r\\n)?", 0, 0, NULL);
+    r = mm_regex_get ("\\+UBMCONF: (\\d+)(?:\\r\\n)?", 0, 0, NULL);
     g_assert (r != NULL);
 
     g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -251,7 +252,7 @@ mm_ublox_parse_uipaddr_response (const gchar  *response,
      *
      * We assume only ONE line is returned; because we request +UIPADDR with a specific N CID.
      */
-    r = g_regex_new ("\\+UIPADDR: (\\d+),([^,]*),([^,]*),([^,]*),([^,]*),([^,]*)(?:\\r\\n)?", 0, 0, NULL);
+    r = mm_regex_get ("\\+UIPADDR: (\\d+),([^,]*),([^,]*),([^,]*),([^,]*),([^,]*)(?:\\r\\n)?", 0, 0, NULL);
     g_assert (r != NULL);
 
     g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -1551,8 +1552,8 @@ mm_ublox_parse_uact_response (const gchar  *response,
      * AT+UACT?
      * +UACT: ,,,900,1800,1,8,101,103,107,108,120,138
      */
-    r = g_regex_new ("\\+UACT: ([^,]*),([^,]*),([^,]*),(.*)(?:\\r\\n)?",
-                     G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW, 0, NULL);
+    r = mm_regex_get ("\\+UACT: ([^,]*),([^,]*),([^,]*),(.*)(?:\\r\\n)?",
+                      G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW, 0, NULL);
     g_assert (r != NULL);
 
     g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -1634,8 +1635,8 @@ mm_ublox_parse_uact_test (const gchar  *response,
      * AT+UACT=?
      * +UACT: ,,,(900,1800),(1,8),(101,103,107,108,120),(138)
      */
-    r = g_regex_new ("\\+UACT: ([^,]*),([^,]*),([^,]*),(.*)(?:\\r\\n)?",
-                     G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW, 0, NULL);
+    r = mm_regex_get ("\\+UACT: ([^,]*),([^,]*),([^,]*),(.*)(?:\\r\\n)?",
+                      G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW, 0, NULL);
     g_assert (r != NULL);
 
     g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -1758,7 +1759,7 @@ mm_ublox_parse_urat_read_response (const gchar  *response,
      * +URAT: 1,2
      * +URAT: 1
      */
-    r = g_regex_new ("\\+URAT: (\\d+)(?:,(\\d+))?(?:\\r\\n)?", 0, 0, NULL);
+    r = mm_regex_get ("\\+URAT: (\\d+)(?:,(\\d+))?(?:\\r\\n)?", 0, 0, NULL);
     g_assert (r != NULL);
 
     g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -1977,8 +1978,8 @@ mm_ublox_parse_ugcntrd_response_for_cid (const gchar  *response,
      *  +UGCNTRD: 31,2704,1819,2724,1839
      * We assume only ONE line is returned.
      */
-    r = g_regex_new ("\\+UGCNTRD:\\s*(\\d+),\\s*(\\d+),\\s*(\\d+),\\s*(\\d+),\\s*(\\d+)",
-                     G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW, 0, NULL);
+    r = mm_regex_get ("\\+UGCNTRD:\\s*(\\d+),\\s*(\\d+),\\s*(\\d+),\\s*(\\d+),\\s*(\\d+)",
+                      G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW, 0, NULL);
     g_assert (r != NULL);
 
     /* Report invalid CID given */
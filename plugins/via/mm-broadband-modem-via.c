@@ -25,6 +25,7 @@
 #include <libmm-glib.h>
 
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-modem-helpers.h"
 #include "mm-errors-types.h"
 #include "mm-base-modem-at.h"
@@ -192,8 +193,8 @@ sysinfo_ready (MMBaseModem  *self,
     response = mm_strip_tag (response, "^SYSINFO:");
 
     /* Format is "<srv_status>,<srv_domain>,<roam_status>,<sys_mode>,<sim_state>" */
-    r = g_regex_new ("\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)",
-                     G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    r = mm_regex_get ("\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)",
+                      G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     g_assert (r != NULL);
 
     /* Try to parse the results */
@@ -475,26 +476,26 @@ mm_broadband_modem_via_init (MMBroadbandModemVia *self)
                                               MMBroadbandModemViaPrivate);
 
     /* Prepare regular expressions to setup */
-    self->priv->hrssilvl_regex = g_regex_new ("\\r\\n\\^HRSSILVL:(.*)\\r\\n",
-                                              G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->mode_regex = g_regex_new ("\\r\\n\\^MODE:(.*)\\r\\n",
-                                          G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->dosession_regex = g_regex_new ("\\r\\n\\+DOSESSION:(.*)\\r\\n",
+    self->priv->hrssilvl_regex = mm_regex_get ("\\r\\n\\^HRSSILVL:(.*)\\r\\n",
                                                G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->simst_regex = g_regex_new ("\\r\\n\\^SIMST:(.*)\\r\\n",
+    self->priv->mode_regex = mm_regex_get ("\\r\\n\\^MODE:(.*)\\r\\n",
                                            G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->simst_regex = g_regex_new ("\\r\\n\\+VPON:(.*)\\r\\n",
+    self->priv->dosession_regex = mm_regex_get ("\\r\\n\\+DOSESSION:(.*)\\r\\n",
+                                                G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->simst_regex = mm_regex_get ("\\r\\n\\^SIMST:(.*)\\r\\n",
+                                            G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->simst_regex = mm_regex_get ("\\r\\n\\+VPON:(.*)\\r\\n",
+                                            G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->creg_regex = mm_regex_get ("\\r\\n\\+CREG:(.*)\\r\\n",
+                                           G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->vrom_regex = mm_regex_get ("\\r\\n\\+VROM:(.*)\\r\\n",
+                                           G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->vser_regex = mm_regex_get ("\\r\\n\\+VSER:(.*)\\r\\n",
+                                           G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->ciev_regex = mm_regex_get ("\\r\\n\\+CIEV:(.*)\\r\\n",
+                                           G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->vpup_regex = mm_regex_get ("\\r\\n\\+VPUP:(.*)\\r\\n",
                                            G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->creg_regex = g_regex_new ("\\r\\n\\+CREG:(.*)\\r\\n",
-                                          G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->vrom_regex = g_regex_new ("\\r\\n\\+VROM:(.*)\\r\\n",
-                                          G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->vser_regex = g_regex_new ("\\r\\n\\+VSER:(.*)\\r\\n",
-                                          G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->ciev_regex = g_regex_new ("\\r\\n\\+CIEV:(.*)\\r\\n",
-                                          G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->vpup_regex = g_regex_new ("\\r\\n\\+VPUP:(.*)\\r\\n",
-                                          G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
 }
 
 static void
@@ -28,6 +28,7 @@
 
 #include "ModemManager.h"
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-serial-parsers.h"
 #include "mm-modem-helpers.h"
 #include "mm-iface-modem.h"
@@ -258,7 +259,7 @@ wwsm_read_ready (MMBaseModem  *self,
      *   +WWSM: 2,1  (2G preferred)
      *   +WWSM: 2,2  (3G preferred)
      */
-    r = g_regex_new ("\\r\\n\\+WWSM: ([0-2])(,([0-2]))?.*$", 0, 0, NULL);
+    r = mm_regex_get ("\\r\\n\\+WWSM: ([0-2])(,([0-2]))?.*$", 0, 0, NULL);
     g_assert (r != NULL);
 
     if (g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, NULL)) {
@@ -1050,7 +1051,7 @@ parse_network_registration_mode (const gchar *reply,
     if (!reply)
         return FALSE;
 
-    r = g_regex_new ("\\+COPS:\\s*(\\d)", G_REGEX_UNGREEDY, 0, NULL);
+    r = mm_regex_get ("\\+COPS:\\s*(\\d)", G_REGEX_UNGREEDY, 0, NULL);
     g_assert (r != NULL);
 
     g_regex_match (r, reply, 0, &match_info);
@@ -1265,9 +1266,9 @@ setup_ports (MMBroadbandModem *self)
 
     /* AT+CPIN? replies will never have an OK appended */
     parser = mm_serial_parser_v1_new ();
-    regex = g_regex_new ("\\r\\n\\+CPIN: .*\\r\\n",
-                         G_REGEX_RAW | G_REGEX_OPTIMIZE,
-                         0, NULL);
+    regex = mm_regex_get ("\\r\\n\\+CPIN: .*\\r\\n",
+                          G_REGEX_RAW | G_REGEX_OPTIMIZE,
+                          0, NULL);
     mm_serial_parser_v1_set_custom_regex (parser, regex, NULL);
     g_regex_unref (regex);
 
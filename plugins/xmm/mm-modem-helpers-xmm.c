@@ -16,6 +16,7 @@
 #include <string.h>
 
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-modem-helpers.h"
 #include "mm-modem-helpers-xmm.h"
 #include "mm-signal.h"
@@ -384,8 +385,8 @@ mm_xmm_parse_xact_query_response (const gchar             *response,
      * Note: the first 3 fields corresponde to allowed and preferred modes. Only the
      * first one of those 3 first fields is mandatory, the other two may be empty.
      */
-    r = g_regex_new ("\\+XACT: (\\d+),([^,]*),([^,]*),(.*)(?:\\r\\n)?",
-                     G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW, 0, NULL);
+    r = mm_regex_get ("\\+XACT: (\\d+),([^,]*),([^,]*),(.*)(?:\\r\\n)?",
+                      G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW, 0, NULL);
     g_assert (r != NULL);
 
     g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -633,7 +634,7 @@ mm_xmm_parse_xcesq_query_response (const gchar  *response,
      * +XCESQ: 0,99,99,46,31,255,255,255
      * +XCESQ: 0,99,99,255,255,17,45,-2
      */
-    r = g_regex_new ("\\+XCESQ: (\\d+),(\\d+),(\\d+),(\\d+),(\\d+),(\\d+),(\\d+),(-?\\d+)(?:\\r\\n)?", 0, 0, NULL);
+    r = mm_regex_get ("\\+XCESQ: (\\d+),(\\d+),(\\d+),(\\d+),(\\d+),(\\d+),(\\d+),(-?\\d+)(?:\\r\\n)?", 0, 0, NULL);
     g_assert (r != NULL);
 
     g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -967,8 +968,8 @@ mm_xmm_parse_xlcsslp_query_response (const gchar  *response,
      *  +XLCSSLP:1,"www.spirent-lcs.com",7275
      */
 
-    r = g_regex_new ("\\+XLCSSLP:\\s*(\\d+),([^,]*),(\\d+)(?:\\r\\n)?",
-                     G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW, 0, NULL);
+    r = mm_regex_get ("\\+XLCSSLP:\\s*(\\d+),([^,]*),(\\d+)(?:\\r\\n)?",
+                      G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW, 0, NULL);
     g_assert (r != NULL);
 
     g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
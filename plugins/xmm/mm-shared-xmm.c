@@ -23,6 +23,7 @@
 #include <libmm-glib.h>
 
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-signal.h"
 #include "mm-iface-modem-location.h"
@@ -90,8 +91,8 @@ get_private (MMSharedXmm *self)
         priv->gps_engine_state = GPS_ENGINE_STATE_OFF;
 
         /* Setup regex for URCs */
-        priv->xlsrstop_regex = g_regex_new ("\\r\\n\\+XLSRSTOP:(.*)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-        priv->nmea_regex     = g_regex_new ("(?:\\r\\n)?(?:\\r\\n)?(\\$G.*)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        priv->xlsrstop_regex = mm_regex_get ("\\r\\n\\+XLSRSTOP:(.*)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        priv->nmea_regex     = mm_regex_get ("(?:\\r\\n)?(?:\\r\\n)?(\\$G.*)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
 
         /* Setup parent class' MMBroadbandModemClass */
         g_assert (MM_SHARED_XMM_GET_INTERFACE (self)->peek_parent_broadband_modem_class);
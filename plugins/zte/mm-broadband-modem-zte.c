@@ -25,6 +25,7 @@
 
 #include "ModemManager.h"
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-errors-types.h"
 #include "mm-modem-helpers.h"
 #include "mm-base-modem-at.h"
@@ -345,7 +346,7 @@ load_current_modes_finish (MMIfaceModem *self,
     if (!response)
         return FALSE;
 
-    r = g_regex_new ("\\+ZSNT:\\s*(\\d),(\\d),(\\d)", G_REGEX_UNGREEDY, 0, error);
+    r = mm_regex_get ("\\+ZSNT:\\s*(\\d),(\\d),(\\d)", G_REGEX_UNGREEDY, 0, error);
     g_assert (r != NULL);
 
     result = FALSE;
@@ -32,6 +32,8 @@ udev_rule_match_clear (MMUdevRuleMatch *rule_match)
 {
     g_free (rule_match->parameter);
     g_free (rule_match->value);
+    g_free (rule_match->pattern.str);
+    g_free (rule_match->implicit_prefix.str);
 }
 
 static void
@@ -55,6 +57,214 @@ udev_rule_clear (MMUdevRule *rule)
         g_array_unref (rule->conditions);
 }
 
+/*****************************************************************************/
+/* Rule compilation */
+
+static void
+compile_pattern (MMUdevRulePattern *pattern,
+                 const gchar       *str)
+{
+    gboolean open_prefix = FALSE;
+    gboolean open_suffix = FALSE;
+    gsize    len;
+
+    if (str[0] == '*') {
+        open_prefix = TRUE;
+        str++;
+    }
+
+    len = strlen (str);
+    if (len > 0 && str[len - 1] == '*') {
+        open_suffix = TRUE;
+        len--;
+    }
+
+    pattern->str = g_strndup (str, len);
+    if (open_suffix && !open_prefix)
+        pattern->type = MM_UDEV_RULE_PATTERN_TYPE_PREFIX;
+    else if (!open_suffix && open_prefix)
+        pattern->type = MM_UDEV_RULE_PATTERN_TYPE_SUFFIX;
+    else if (open_suffix && open_prefix)
+        pattern->type = MM_UDEV_RULE_PATTERN_TYPE_SUBSTRING;
+    else
+        pattern->type = MM_UDEV_RULE_PATTERN_TYPE_EXACT;
+}
+
+static gchar *
+get_parameter_key (const gchar *parameter,
+                   gsize        prefix_len)
+{
+    gchar *key;
+
+    /* e.g. ATTRS{idVendor} or ENV{ID_MM_CANDIDATE} */
+    key = g_strdup (&parameter[prefix_len]);
+    g_strdelimit (key, "{}", ' ');
+    g_strstrip (key);
+    return key;
+}
+
+static const struct {
+    const gchar         *name;
+    MMUdevRuleParameter  id;
+} attributes[] = {
+    { "idVendor",           MM_UDEV_RULE_PARAMETER_ATTR_ID_VENDOR          },
+    { "idProduct",          MM_UDEV_RULE_PARAMETER_ATTR_ID_PRODUCT         },
+    { "manufacturer",       MM_UDEV_RULE_PARAMETER_ATTR_MANUFACTURER       },
+    { "product",            MM_UDEV_RULE_PARAMETER_ATTR_PRODUCT            },
+    { "bInterfaceClass",    MM_UDEV_RULE_PARAMETER_ATTR_INTERFACE_CLASS    },
+    { "bInterfaceSubClass", MM_UDEV_RULE_PARAMETER_ATTR_INTERFACE_SUBCLASS },
+    { "bInterfaceProtocol", MM_UDEV_RULE_PARAMETER_ATTR_INTERFACE_PROTOCOL },
+    { "bInterfaceNumber",   MM_UDEV_RULE_PARAMETER_ATTR_INTERFACE_NUMBER   },
+};
+
+static MMUdevRuleParameter
+compile_attribute (const gchar *attribute)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (attributes); i++) {
+        if (g_str_equal (attribute, attributes[i].name))
+            return attributes[i].id;
+    }
+    return MM_UDEV_RULE_PARAMETER_ATTR_UNKNOWN;
+}
+
+static void
+compile_rule_match (MMUdevRuleMatch *match)
+{
+    if (g_str_equal (match->parameter, "ACTION")) {
+        /* We only apply 'add' rules */
+        match->id = MM_UDEV_RULE_PARAMETER_ACTION;
+        match->any = !!strstr (match->value, "add");
+        return;
+    }
+
+    if (g_str_equal (match->parameter, "SUBSYSTEMS") || g_str_equal (match->parameter, "SUBSYSTEM")) {
+        match->id = MM_UDEV_RULE_PARAMETER_SUBSYSTEM;
+        return;
+    }
+
+    if (g_str_equal (match->parameter, "DRIVER") || g_str_equal (match->parameter, "DRIVERS")) {
+        match->id = MM_UDEV_RULE_PARAMETER_DRIVER;
+        return;
+    }
+
+    if (g_str_equal (match->parameter, "KERNEL")) {
+        match->id = MM_UDEV_RULE_PARAMETER_KERNEL;
+        compile_pattern (&match->pattern, match->value);
+        return;
+    }
+
+    if (g_str_equal (match->parameter, "DEVPATH")) {
+        match->id = MM_UDEV_RULE_PARAMETER_DEVPATH;
+        compile_pattern (&match->pattern, match->value);
+        /* If not already doing a prefix match, do an implicit one. This is so that
+         * we can add properties to the usb_device owning all ports, and then apply
+         * the property to all ports individually processed. */
+        if (match->value[0] && match->value[strlen (match->value) - 1] != '*') {
+            gchar *prefix;
+
+            prefix = g_strdup_printf ("%s/*", match->value);
+            compile_pattern (&match->implicit_prefix, prefix);
+            g_free (prefix);
+        }
+        return;
+    }
+
+    if (g_str_has_prefix (match->parameter, "ATTRS")) {
+        gchar *attribute;
+
+        attribute = get_parameter_key (match->parameter, 5);
+        match->id = compile_attribute (attribute);
+        if (match->id == MM_UDEV_RULE_PARAMETER_ATTR_UNKNOWN)
+            mm_warn ("[rules] unknown attribute: %s", attribute);
+        g_free (attribute);
+
+        match->any = g_str_equal (match->value, "?*");
+        match->number_valid = mm_get_uint_from_hex_str (match->value, &match->number);
+        return;
+    }
+
+    if (g_str_has_prefix (match->parameter, "ENV")) {
+        gchar *property;
+
+        property = get_parameter_key (match->parameter, 3);
+        match->id = MM_UDEV_RULE_PARAMETER_ENV;
+        match->env = g_quark_from_string (property);
+        g_free (property);
+        return;
+    }
+
+    mm_warn ("[rules] unknown match condition parameter: %s", match->parameter);
+    match->id = MM_UDEV_RULE_PARAMETER_UNKNOWN;
+}
+
+static void
+compile_rule_result (MMUdevRuleResult *result)
+{
+    const gchar *value;
+
+    if (result->type != MM_UDEV_RULE_RESULT_TYPE_PROPERTY)
+        return;
+
+    result->content.property.quark = g_quark_from_string (result->content.property.name);
+
+    value = result->content.property.value;
+    if (g_str_has_prefix (value, "$attr{") && value[strlen (value) - 1] == '}') {
+        gchar *attribute;
+
+        attribute = g_strndup (value + 6, strlen (value) - 7);
+        result->content.property.value_attribute = compile_attribute (attribute);
+        g_free (attribute);
+        /* Only interface details can be read as property values */
+        if (result->content.property.value_attribute < MM_UDEV_RULE_PARAMETER_ATTR_INTERFACE_CLASS)
+            result->content.property.value_attribute = MM_UDEV_RULE_PARAMETER_UNKNOWN;
+    }
+}
+
+static void
+compile_rules (GArray *rules)
+{
+    guint i;
+
+    /* Required vid/pid of each rule */
+    for (i = 0; i < rules->len; i++) {
+        MMUdevRule *rule;
+        guint       j;
+
+        rule = &g_array_index (rules, MMUdevRule, i);
+        for (j = 0; rule->conditions && j < rule->conditions->len; j++) {
+            MMUdevRuleMatch *match;
+
+            match = &g_array_index (rule->conditions, MMUdevRuleMatch, j);
+            if (match->type != MM_UDEV_RULE_MATCH_TYPE_EQUAL || !match->number_valid || match->number > G_MAXUINT16)
+                continue;
+            if (match->id == MM_UDEV_RULE_PARAMETER_ATTR_ID_VENDOR && !rule->vid)
+                rule->vid = match->number;
+            else if (match->id == MM_UDEV_RULE_PARAMETER_ATTR_ID_PRODUCT && !rule->pid)
+                rule->pid = match->number;
+        }
+    }
+
+    /* Consecutive rules with the same requirements are skipped together */
+    for (i = rules->len; i > 0; i--) {
+        MMUdevRule *rule;
+        MMUdevRule *next;
+
+        rule = &g_array_index (rules, MMUdevRule, i - 1);
+        if (i == rules->len) {
+            rule->skip_index = i;
+            continue;
+        }
+
+        next = &g_array_index (rules, MMUdevRule, i);
+        rule->skip_index = ((next->vid == rule->vid && next->pid == rule->pid) ? next->skip_index : i);
+    }
+}
+
+/*****************************************************************************/
+/* Rule loading */
+
 static gboolean
 split_item (const gchar  *item,
             gchar       **out_left,
@@ -202,6 +412,7 @@ load_rule_match (MMUdevRuleMatch  *rule_match,
     g_free (operator);
     rule_match->parameter = left;
     rule_match->value     = right;
+    compile_rule_match (rule_match);
     return TRUE;
 }
 
@@ -245,6 +456,7 @@ load_rule_from_line (MMUdevRule   *rule,
     g_assert ((rule->result.type == MM_UDEV_RULE_RESULT_TYPE_GOTO_TAG && rule->result.content.tag) ||
               (rule->result.type == MM_UDEV_RULE_RESULT_TYPE_LABEL && rule->result.content.tag) ||
               (rule->result.type == MM_UDEV_RULE_RESULT_TYPE_PROPERTY && rule->result.content.property.name && rule->result.content.property.value));
+    compile_rule_result (&rule->result);
 
 out:
     g_strfreev (split);
@@ -430,6 +642,8 @@ mm_kernel_device_generic_rules_load (const gchar  *rules_dir,
         goto out;
     }
 
+    compile_rules (rules);
+
     mm_dbg ("[rules] %u loaded", rules->len);
 
 out:
@@ -444,3 +658,238 @@ out:
 
     return rules;
 }
+
+/*****************************************************************************/
+/* Rule matching */
+
+static gboolean
+pattern_match (const MMUdevRulePattern *pattern,
+               const gchar             *str)
+{
+    switch (pattern->type) {
+    case MM_UDEV_RULE_PATTERN_TYPE_PREFIX:
+        return g_str_has_prefix (str, pattern->str);
+    case MM_UDEV_RULE_PATTERN_TYPE_SUFFIX:
+        return g_str_has_suffix (str, pattern->str);
+    case MM_UDEV_RULE_PATTERN_TYPE_SUBSTRING:
+        return !!strstr (str, pattern->str);
+    case MM_UDEV_RULE_PATTERN_TYPE_EXACT:
+    default:
+        return g_str_equal (str, pattern->str);
+    }
+}
+
+static gboolean
+devpath_match (const MMUdevRuleMatch *match,
+               const gchar           *devpath,
+               gboolean               condition_equal)
+{
+    /* We allow both a direct match and a prefix match */
+    return ((pattern_match (&match->pattern, devpath) == condition_equal) ||
+            (match->implicit_prefix.str && pattern_match (&match->implicit_prefix, devpath) == condition_equal));
+}
+
+static gboolean
+interface_attribute_match (const MMUdevRuleMatch *match,
+                           guint8                 value,
+                           gboolean               condition_equal)
+{
+    return (match->any || (match->number_valid && ((value == match->number) == condition_equal)));
+}
+
+static gboolean
+check_condition (const MMUdevRuleMatch  *match,
+                 const MMUdevRuleDevice *device,
+                 GObject                *properties)
+{
+    gboolean condition_equal;
+
+    condition_equal = (match->type == MM_UDEV_RULE_MATCH_TYPE_EQUAL);
+
+    switch (match->id) {
+    case MM_UDEV_RULE_PARAMETER_ACTION:
+        /* We only apply 'add' rules */
+        return (match->any == condition_equal);
+
+    case MM_UDEV_RULE_PARAMETER_SUBSYSTEM:
+        /* We look for the subsystem string in the whole sysfs path.
+         *
+         * Note that we're not really making a difference between "SUBSYSTEMS"
+         * (where the whole device tree is checked) and "SUBSYSTEM" (where just one
+         * single device is checked), because a lot of the MM udev rules are meant
+         * to just tag the physical device (e.g. with ID_MM_DEVICE_IGNORE) instead
+         * of the single ports. In our case with the custom parsing, we do tag all
+         * independent ports.
+         */
+        return ((device->sysfs_path && !!strstr (device->sysfs_path, match->value)) == condition_equal);
+
+    case MM_UDEV_RULE_PARAMETER_DRIVER:
+        /* Exact DRIVER match? We also include the check for DRIVERS, even if we
+         * only apply it to this port driver. */
+        return ((!g_strcmp0 (match->value, device->driver)) == condition_equal);
+
+    case MM_UDEV_RULE_PARAMETER_KERNEL:
+        /* Device name checks */
+        return (pattern_match (&match->pattern, device->name) == condition_equal);
+
+    case MM_UDEV_RULE_PARAMETER_DEVPATH:
+        /* If sysfs path invalid (e.g. path doesn't exist), no match */
+        if (!device->sysfs_path)
+            return FALSE;
+        if (devpath_match (match, device->sysfs_path, condition_equal))
+            return TRUE;
+        return (g_str_has_prefix (device->sysfs_path, "/sys") &&
+                devpath_match (match, &device->sysfs_path[4], condition_equal));
+
+    case MM_UDEV_RULE_PARAMETER_ENV:
+        /* Previously set property checks */
+        return ((!g_strcmp0 ((const gchar *) g_object_get_qdata (properties, match->env), match->value)) == condition_equal);
+
+    case MM_UDEV_RULE_PARAMETER_ATTR_ID_VENDOR:
+        return (match->number_valid && ((device->physdev_vid == match->number) == condition_equal));
+
+    case MM_UDEV_RULE_PARAMETER_ATTR_ID_PRODUCT:
+        return (match->number_valid && ((device->physdev_pid == match->number) == condition_equal));
+
+    case MM_UDEV_RULE_PARAMETER_ATTR_MANUFACTURER:
+        return ((device->physdev_manufacturer && g_str_equal (device->physdev_manufacturer, match->value)) == condition_equal);
+
+    case MM_UDEV_RULE_PARAMETER_ATTR_PRODUCT:
+        return ((device->physdev_product && g_str_equal (device->physdev_product, match->value)) == condition_equal);
+
+    case MM_UDEV_RULE_PARAMETER_ATTR_INTERFACE_CLASS:
+        return interface_attribute_match (match, device->interface_class, condition_equal);
+
+    case MM_UDEV_RULE_PARAMETER_ATTR_INTERFACE_SUBCLASS:
+        return interface_attribute_match (match, device->interface_subclass, condition_equal);
+
+    case MM_UDEV_RULE_PARAMETER_ATTR_INTERFACE_PROTOCOL:
+        return interface_attribute_match (match, device->interface_protocol, condition_equal);
+
+    case MM_UDEV_RULE_PARAMETER_ATTR_INTERFACE_NUMBER:
+        return interface_attribute_match (match, device->interface_number, condition_equal);
+
+    case MM_UDEV_RULE_PARAMETER_ATTR_UNKNOWN:
+    case MM_UDEV_RULE_PARAMETER_UNKNOWN:
+    default:
+        /* Already warned when loading */
+        return FALSE;
+    }
+}
+
+static gchar *
+read_property_value (const MMUdevRuleResultProperty *property,
+                     const MMUdevRuleDevice         *device)
+{
+    switch (property->value_attribute) {
+    case MM_UDEV_RULE_PARAMETER_ATTR_INTERFACE_CLASS:
+        return g_strdup_printf ("%02x", device->interface_class);
+    case MM_UDEV_RULE_PARAMETER_ATTR_INTERFACE_SUBCLASS:
+        return g_strdup_printf ("%02x", device->interface_subclass);
+    case MM_UDEV_RULE_PARAMETER_ATTR_INTERFACE_PROTOCOL:
+        return g_strdup_printf ("%02x", device->interface_protocol);
+    case MM_UDEV_RULE_PARAMETER_ATTR_INTERFACE_NUMBER:
+        return g_strdup_printf ("%02x", device->interface_number);
+    default:
+        return NULL;
+    }
+}
+
+static guint
+check_rule (GArray                 *rules,
+            guint                   rule_i,
+            const MMUdevRuleDevice *device,
+            GObject                *properties)
+{
+    MMUdevRule *rule;
+    gboolean    apply = TRUE;
+
+    g_assert (rule_i < rules->len);
+
+    rule = &g_array_index (rules, MMUdevRule, rule_i);
+    if (rule->conditions) {
+        guint condition_i;
+
+        for (condition_i = 0; condition_i < rule->conditions->len; condition_i++) {
+            MMUdevRuleMatch *match;
+
+            match = &g_array_index (rule->conditions, MMUdevRuleMatch, condition_i);
+            if (!check_condition (match, device, properties)) {
+                apply = FALSE;
+                break;
+            }
+        }
+    }
+
+    if (apply) {
+        switch (rule->result.type) {
+        case MM_UDEV_RULE_RESULT_TYPE_PROPERTY: {
+            gchar *property_value_read;
+
+            property_value_read = read_property_value (&rule->result.content.property, device);
+
+            /* add new property */
+            mm_dbg ("(%s/%s) property added: %s=%s",
+                    device->subsystem,
+                    device->name,
+                    rule->result.content.property.name,
+                    property_value_read ? property_value_read : rule->result.content.property.value);
+
+            if (!property_value_read)
+                /* NOTE: the owner of the properties object keeps a reference to the
+                 * list of rules, so it isn't an issue if we re-use the same string
+                 * (i.e. without g_strdup-ing it) as a property value. */
+                g_object_set_qdata (properties,
+                                    rule->result.content.property.quark,
+                                    rule->result.content.property.value);
+            else
+                g_object_set_qdata_full (properties,
+                                         rule->result.content.property.quark,
+                                         property_value_read,
+                                         g_free);
+            break;
+        }
+
+        case MM_UDEV_RULE_RESULT_TYPE_LABEL:
+            /* noop */
+            break;
+
+        case MM_UDEV_RULE_RESULT_TYPE_GOTO_INDEX:
+            /* Jump to a new index */
+            return rule->result.content.index;
+
+        case MM_UDEV_RULE_RESULT_TYPE_GOTO_TAG:
+        case MM_UDEV_RULE_RESULT_TYPE_UNKNOWN:
+            g_assert_not_reached ();
+        }
+    }
+
+    /* Go to the next rule */
+    return rule_i + 1;
+}
+
+void
+mm_kernel_device_generic_rules_apply (GArray                 *rules,
+                                      const MMUdevRuleDevice *device,
+                                      GObject                *properties)
+{
+    guint i;
+
+    g_assert (rules);
+    g_assert (device->subsystem && device->name);
+
+    i = 0;
+    while (i < rules->len) {
+        MMUdevRule *rule;
+
+        /* Skip all consecutive rules meant for other devices at once */
+        rule = &g_array_index (rules, MMUdevRule, i);
+        if ((rule->vid && rule->vid != device->physdev_vid) ||
+            (rule->pid && rule->pid != device->physdev_pid)) {
+            i = rule->skip_index;
+            continue;
+        }
+
+        i = check_rule (rules, i, device, properties);
+    }
+}
@@ -14,6 +14,7 @@
  */
 
 #include <glib.h>
+#include <glib-object.h>
 
 G_BEGIN_DECLS
 
@@ -23,10 +24,53 @@ typedef enum {
     MM_UDEV_RULE_MATCH_TYPE_NOT_EQUAL,
 } MMUdevRuleMatchType;
 
+/* Parameters and attributes supported in the rules, resolved when the rules
+ * are loaded so that no string comparison is needed when applying them. */
+typedef enum {
+    MM_UDEV_RULE_PARAMETER_UNKNOWN,
+    MM_UDEV_RULE_PARAMETER_ACTION,
+    MM_UDEV_RULE_PARAMETER_SUBSYSTEM,
+    MM_UDEV_RULE_PARAMETER_DRIVER,
+    MM_UDEV_RULE_PARAMETER_KERNEL,
+    MM_UDEV_RULE_PARAMETER_DEVPATH,
+    MM_UDEV_RULE_PARAMETER_ENV,
+    MM_UDEV_RULE_PARAMETER_ATTR_UNKNOWN,
+    MM_UDEV_RULE_PARAMETER_ATTR_ID_VENDOR,
+    MM_UDEV_RULE_PARAMETER_ATTR_ID_PRODUCT,
+    MM_UDEV_RULE_PARAMETER_ATTR_MANUFACTURER,
+    MM_UDEV_RULE_PARAMETER_ATTR_PRODUCT,
+    MM_UDEV_RULE_PARAMETER_ATTR_INTERFACE_CLASS,
+    MM_UDEV_RULE_PARAMETER_ATTR_INTERFACE_SUBCLASS,
+    MM_UDEV_RULE_PARAMETER_ATTR_INTERFACE_PROTOCOL,
+    MM_UDEV_RULE_PARAMETER_ATTR_INTERFACE_NUMBER,
+} MMUdevRuleParameter;
+
+/* Glob patterns, with the leading and trailing '*' wildcards removed */
+typedef enum {
+    MM_UDEV_RULE_PATTERN_TYPE_EXACT,
+    MM_UDEV_RULE_PATTERN_TYPE_PREFIX,
+    MM_UDEV_RULE_PATTERN_TYPE_SUFFIX,
+    MM_UDEV_RULE_PATTERN_TYPE_SUBSTRING,
+} MMUdevRulePatternType;
+
+typedef struct {
+    MMUdevRulePatternType  type;
+    gchar                 *str;
+} MMUdevRulePattern;
+
 typedef struct {
     MMUdevRuleMatchType  type;
     gchar               *parameter;
     gchar               *value;
+
+    /* Compiled when loaded */
+    MMUdevRuleParameter  id;
+    MMUdevRulePattern    pattern;        /* KERNEL, DEVPATH */
+    MMUdevRulePattern    implicit_prefix; /* DEVPATH without trailing '*' */
+    GQuark               env;            /* ENV{} */
+    guint                number;         /* ATTRS{} given in hex */
+    gboolean             number_valid;
+    gboolean             any;            /* ATTRS{}=="?*", or ACTION with "add" */
 } MMUdevRuleMatch;
 
 typedef enum {
@@ -38,8 +82,11 @@ typedef enum {
 } MMUdevRuleResultType;
 
 typedef struct {
-    gchar *name;
-    gchar *value;
+    gchar               *name;
+    gchar               *value;
+    /* Compiled when loaded */
+    GQuark               quark;
+    MMUdevRuleParameter  value_attribute; /* $attr{} values, or UNKNOWN */
 } MMUdevRuleResultProperty;
 
 typedef struct {
@@ -54,9 +101,39 @@ typedef struct {
 typedef struct {
     GArray           *conditions;
     MMUdevRuleResult  result;
+
+    /* Compiled when loaded: vid and pid that the device must have for the
+     * rule to apply (0 if any), and index of the first rule after this one
+     * with a different vid/pid requirement, so that whole blocks of rules
+     * for other devices can be skipped at once. */
+    guint16           vid;
+    guint16           pid;
+    guint             skip_index;
 } MMUdevRule;
 
 GArray *mm_kernel_device_generic_rules_load (const gchar  *rules_dir,
                                              GError      **error);
 
+/* Contents of the device the rules are applied to */
+typedef struct {
+    const gchar *subsystem;
+    const gchar *name;
+    const gchar *sysfs_path;
+    const gchar *driver;
+    guint16      physdev_vid;
+    guint16      physdev_pid;
+    const gchar *physdev_manufacturer;
+    const gchar *physdev_product;
+    guint8       interface_class;
+    guint8       interface_subclass;
+    guint8       interface_protocol;
+    guint8       interface_number;
+} MMUdevRuleDevice;
+
+/* Applies the rules to the device; properties are read from and added to
+ * the object data of 'properties'. */
+void mm_kernel_device_generic_rules_apply (GArray                 *rules,
+                                           const MMUdevRuleDevice *device,
+                                           GObject                *properties);
+
 G_END_DECLS
@@ -601,273 +601,30 @@ kernel_device_cmp (MMKernelDevice *a,
 
 /*****************************************************************************/
 
-static gboolean
-string_match (const gchar *str,
-              const gchar *original_pattern)
-{
-    gchar    *pattern;
-    gchar    *start;
-    gboolean  open_prefix = FALSE;
-    gboolean  open_suffix = FALSE;
-    gboolean  match;
-
-    pattern = g_strdup (original_pattern);
-    start = pattern;
-
-    if (start[0] == '*') {
-        open_prefix = TRUE;
-        start++;
-    }
-
-    if (start[strlen (start) - 1] == '*') {
-        open_suffix = TRUE;
-        start[strlen (start) - 1] = '\0';
-    }
-
-    if (open_suffix && !open_prefix)
-        match = g_str_has_prefix (str, start);
-    else if (!open_suffix && open_prefix)
-        match = g_str_has_suffix (str, start);
-    else if (open_suffix && open_prefix)
-        match = !!strstr (str, start);
-    else
-        match = g_str_equal (str, start);
-
-    g_free (pattern);
-    return match;
-}
-
-static gboolean
-check_condition (MMKernelDeviceGeneric *self,
-                 MMUdevRuleMatch       *match)
-{
-    gboolean condition_equal;
-
-    condition_equal = (match->type == MM_UDEV_RULE_MATCH_TYPE_EQUAL);
-
-    /* We only apply 'add' rules */
-    if (g_str_equal (match->parameter, "ACTION"))
-        return ((!!strstr (match->value, "add")) == condition_equal);
-
-    /* We look for the subsystem string in the whole sysfs path.
-     *
-     * Note that we're not really making a difference between "SUBSYSTEMS"
-     * (where the whole device tree is checked) and "SUBSYSTEM" (where just one
-     * single device is checked), because a lot of the MM udev rules are meant
-     * to just tag the physical device (e.g. with ID_MM_DEVICE_IGNORE) instead
-     * of the single ports. In our case with the custom parsing, we do tag all
-     * independent ports.
-     */
-    if (g_str_equal (match->parameter, "SUBSYSTEMS") || g_str_equal (match->parameter, "SUBSYSTEM"))
-        return ((self->priv->sysfs_path && !!strstr (self->priv->sysfs_path, match->value)) == condition_equal);
-
-    /* Exact DRIVER match? We also include the check for DRIVERS, even if we
-     * only apply it to this port driver. */
-    if (g_str_equal (match->parameter, "DRIVER") || g_str_equal (match->parameter, "DRIVERS"))
-        return ((!g_strcmp0 (match->value, mm_kernel_device_get_driver (MM_KERNEL_DEVICE (self)))) == condition_equal);
-
-    /* Device name checks */
-    if (g_str_equal (match->parameter, "KERNEL"))
-        return (string_match (mm_kernel_device_get_name (MM_KERNEL_DEVICE (self)), match->value) == condition_equal);
-
-    /* Device sysfs path checks; we allow both a direct match and a prefix patch */
-    if (g_str_equal (match->parameter, "DEVPATH")) {
-        gchar    *prefix_match = NULL;
-        gboolean  result = FALSE;
-
-        /* If sysfs path invalid (e.g. path doesn't exist), no match */
-        if (!self->priv->sysfs_path)
-            return FALSE;
-
-        /* If not already doing a prefix match, do an implicit one. This is so that
-         * we can add properties to the usb_device owning all ports, and then apply
-         * the property to all ports individually processed here. */
-        if (match->value[0] && match->value[strlen (match->value) - 1] != '*')
-            prefix_match = g_strdup_printf ("%s/*", match->value);
-
-        if (string_match (self->priv->sysfs_path, match->value) == condition_equal) {
-            result = TRUE;
-            goto out;
-        }
-
-        if (prefix_match && string_match (self->priv->sysfs_path, prefix_match) == condition_equal) {
-            result = TRUE;
-            goto out;
-        }
-
-        if (g_str_has_prefix (self->priv->sysfs_path, "/sys")) {
-            if (string_match (&self->priv->sysfs_path[4], match->value) == condition_equal) {
-                result = TRUE;
-                goto out;
-            }
-            if (prefix_match && string_match (&self->priv->sysfs_path[4], prefix_match) == condition_equal) {
-                result = TRUE;
-                goto out;
-            }
-        }
-    out:
-        g_free (prefix_match);
-        return result;
-    }
-
-    /* Attributes checks */
-    if (g_str_has_prefix (match->parameter, "ATTRS")) {
-        gchar    *attribute;
-        gchar    *contents = NULL;
-        gboolean  result = FALSE;
-        guint     val;
-
-        attribute = g_strdup (&match->parameter[5]);
-        g_strdelimit (attribute, "{}", ' ');
-        g_strstrip (attribute);
-
-        /* VID/PID directly from our API */
-        if (g_str_equal (attribute, "idVendor"))
-            result = ((mm_get_uint_from_hex_str (match->value, &val)) &&
-                      ((mm_kernel_device_get_physdev_vid (MM_KERNEL_DEVICE (self)) == val) == condition_equal));
-        else if (g_str_equal (attribute, "idProduct"))
-            result = ((mm_get_uint_from_hex_str (match->value, &val)) &&
-                      ((mm_kernel_device_get_physdev_pid (MM_KERNEL_DEVICE (self)) == val) == condition_equal));
-        /* manufacturer in the physdev */
-        else if (g_str_equal (attribute, "manufacturer"))
-            result = ((self->priv->physdev_manufacturer && g_str_equal (self->priv->physdev_manufacturer, match->value)) == condition_equal);
-        /* product in the physdev */
-        else if (g_str_equal (attribute, "product"))
-            result = ((self->priv->physdev_product && g_str_equal (self->priv->physdev_product, match->value)) == condition_equal);
-        /* interface class/subclass/protocol/number in the interface */
-        else if (g_str_equal (attribute, "bInterfaceClass"))
-            result = (g_str_equal (match->value, "?*") || ((mm_get_uint_from_hex_str (match->value, &val)) &&
-                                                           ((self->priv->interface_class == val) == condition_equal)));
-        else if (g_str_equal (attribute, "bInterfaceSubClass"))
-            result = (g_str_equal (match->value, "?*") || ((mm_get_uint_from_hex_str (match->value, &val)) &&
-                                                           ((self->priv->interface_subclass == val) == condition_equal)));
-        else if (g_str_equal (attribute, "bInterfaceProtocol"))
-            result = (g_str_equal (match->value, "?*") || ((mm_get_uint_from_hex_str (match->value, &val)) &&
-                                                           ((self->priv->interface_protocol == val) == condition_equal)));
-        else if (g_str_equal (attribute, "bInterfaceNumber"))
-            result = (g_str_equal (match->value, "?*") || ((mm_get_uint_from_hex_str (match->value, &val)) &&
-                                                           ((self->priv->interface_number == val) == condition_equal)));
-        else
-            mm_warn ("Unknown attribute: %s", attribute);
-
-        g_free (contents);
-        g_free (attribute);
-        return result;
-    }
-
-    /* Previously set property checks */
-    if (g_str_has_prefix (match->parameter, "ENV")) {
-        gchar    *property;
-        gboolean  result = FALSE;
-
-        property = g_strdup (&match->parameter[3]);
-        g_strdelimit (property, "{}", ' ');
-        g_strstrip (property);
-
-        result = ((!g_strcmp0 ((const gchar *) g_object_get_data (G_OBJECT (self), property), match->value)) == condition_equal);
-
-        g_free (property);
-        return result;
-    }
-
-    mm_warn ("Unknown match condition parameter: %s", match->parameter);
-    return FALSE;
-}
-
-static guint
-check_rule (MMKernelDeviceGeneric *self,
-            guint                  rule_i)
-{
-    MMUdevRule *rule;
-    gboolean    apply = TRUE;
-
-    g_assert (rule_i < self->priv->rules->len);
-
-    rule = &g_array_index (self->priv->rules, MMUdevRule, rule_i);
-    if (rule->conditions) {
-        guint condition_i;
-
-        for (condition_i = 0; condition_i < rule->conditions->len; condition_i++) {
-            MMUdevRuleMatch *match;
-
-            match = &g_array_index (rule->conditions, MMUdevRuleMatch, condition_i);
-            if (!check_condition (self, match)) {
-                apply = FALSE;
-                break;
-            }
-        }
-    }
-
-    if (apply) {
-        switch (rule->result.type) {
-        case MM_UDEV_RULE_RESULT_TYPE_PROPERTY: {
-            gchar *property_value_read = NULL;
-
-            if (g_str_equal (rule->result.content.property.value, "$attr{bInterfaceClass}"))
-                property_value_read = g_strdup_printf ("%02x", self->priv->interface_class);
-            else if (g_str_equal (rule->result.content.property.value, "$attr{bInterfaceSubClass}"))
-                property_value_read = g_strdup_printf ("%02x", self->priv->interface_subclass);
-            else if (g_str_equal (rule->result.content.property.value, "$attr{bInterfaceProtocol}"))
-                property_value_read = g_strdup_printf ("%02x", self->priv->interface_protocol);
-            else if (g_str_equal (rule->result.content.property.value, "$attr{bInterfaceNumber}"))
-                property_value_read = g_strdup_printf ("%02x", self->priv->interface_number);
-
-            /* add new property */
-            mm_dbg ("(%s/%s) property added: %s=%s",
-                    mm_kernel_event_properties_get_subsystem (self->priv->properties),
-                    mm_kernel_event_properties_get_name      (self->priv->properties),
-                    rule->result.content.property.name,
-                    property_value_read ? property_value_read : rule->result.content.property.value);
-
-            if (!property_value_read)
-                /* NOTE: we keep a reference to the list of rules ourselves, so it isn't
-                 * an issue if we re-use the same string (i.e. without g_strdup-ing it)
-                 * as a property value. */
-                g_object_set_data (G_OBJECT (self),
-                                   rule->result.content.property.name,
-                                   rule->result.content.property.value);
-            else
-                g_object_set_data_full (G_OBJECT (self),
-                                        rule->result.content.property.name,
-                                        property_value_read,
-                                        g_free);
-            break;
-        }
-
-        case MM_UDEV_RULE_RESULT_TYPE_LABEL:
-            /* noop */
-            break;
-
-        case MM_UDEV_RULE_RESULT_TYPE_GOTO_INDEX:
-            /* Jump to a new index */
-            return rule->result.content.index;
-
-        case MM_UDEV_RULE_RESULT_TYPE_GOTO_TAG:
-        case MM_UDEV_RULE_RESULT_TYPE_UNKNOWN:
-            g_assert_not_reached ();
-        }
-    }
-
-    /* Go to the next rule */
-    return rule_i + 1;
-}
-
 static void
 preload_properties (MMKernelDeviceGeneric *self)
 {
-    guint i;
+    MMUdevRuleDevice device;
 
     g_assert (self->priv->rules);
     g_assert (self->priv->rules->len > 0);
 
-    /* Start to process rules */
-    i = 0;
-    while (i < self->priv->rules->len) {
-        guint next_rule;
-
-        next_rule = check_rule (self, i);
-        i = next_rule;
-    }
+    device.subsystem            = mm_kernel_event_properties_get_subsystem (self->priv->properties);
+    device.name                 = mm_kernel_event_properties_get_name      (self->priv->properties);
+    device.sysfs_path           = self->priv->sysfs_path;
+    device.driver               = self->priv->driver;
+    device.physdev_vid          = self->priv->physdev_vid;
+    device.physdev_pid          = self->priv->physdev_pid;
+    device.physdev_manufacturer = self->priv->physdev_manufacturer;
+    device.physdev_product      = self->priv->physdev_product;
+    device.interface_class      = self->priv->interface_class;
+    device.interface_subclass   = self->priv->interface_subclass;
+    device.interface_protocol   = self->priv->interface_protocol;
+    device.interface_number     = self->priv->interface_number;
+
+    /* Properties are stored as object data; we keep a reference to the list
+     * of rules ourselves, so the values may point to the rule strings */
+    mm_kernel_device_generic_rules_apply (self->priv->rules, &device, G_OBJECT (self));
 }
 
 static void
@@ -28,7 +28,10 @@
 
 #include "mm-base-manager.h"
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-context.h"
+#include "mm-properties-batch.h"
+#include "mm-netlink-monitor.h"
 
 #if defined WITH_SYSTEMD_SUSPEND_RESUME
 # include "mm-sleep-monitor.h"
@@ -39,6 +42,7 @@
 
 static GMainLoop *loop;
 static MMBaseManager *manager;
+static MMPropertiesBatch *properties_batch;
 
 static gboolean
 quit_cb (gpointer user_data)
@@ -55,6 +59,22 @@ quit_cb (gpointer user_data)
     return FALSE;
 }
 
+static gboolean
+dump_traces_cb (gpointer user_data)
+{
+    mm_log_trace_dump (NULL);
+
+    if (properties_batch) {
+        guint64 n_received;
+        guint64 n_emitted;
+
+        mm_properties_batch_get_stats (properties_batch, &n_received, &n_emitted);
+        mm_info ("%" G_GUINT64_FORMAT " property change notifications merged into %" G_GUINT64_FORMAT " signals",
+                 n_received, n_emitted);
+    }
+    return TRUE;
+}
+
 #if defined WITH_SYSTEMD_SUSPEND_RESUME
 
 static void
@@ -82,6 +102,13 @@ bus_acquired_cb (GDBusConnection *connection,
 
     mm_dbg ("Bus acquired, creating manager...");
 
+    /* Merge the property change notifications of all objects */
+    if (mm_context_get_properties_changed_window ()) {
+        g_assert (!properties_batch);
+        properties_batch = mm_properties_batch_new (mm_context_get_properties_changed_window ());
+        mm_properties_batch_attach (properties_batch, connection);
+    }
+
     /* Create Manager object */
     g_assert (!manager);
     manager = mm_base_manager_new (connection,
@@ -151,8 +178,12 @@ main (int argc, char *argv[])
         exit (1);
     }
 
+    mm_netlink_monitor_set_stats_interval (mm_netlink_monitor_get (),
+                                           mm_context_get_bearer_throughput_interval ());
+
     g_unix_signal_add (SIGTERM, quit_cb, NULL);
     g_unix_signal_add (SIGINT, quit_cb, NULL);
+    g_unix_signal_add (SIGUSR1, dump_traces_cb, NULL);
 
     mm_info ("ModemManager (version " MM_DIST_VERSION ") starting in %s bus...",
              mm_context_get_test_session () ? "session" : "system");
@@ -213,8 +244,28 @@ main (int argc, char *argv[])
 
     g_main_loop_unref (inner);
 
+    if (properties_batch) {
+        guint64 n_received;
+        guint64 n_emitted;
+
+        mm_properties_batch_get_stats (properties_batch, &n_received, &n_emitted);
+        mm_dbg ("%" G_GUINT64_FORMAT " property change notifications merged into %" G_GUINT64_FORMAT " signals",
+                n_received, n_emitted);
+        mm_properties_batch_free (properties_batch);
+    }
+
     g_bus_unown_name (name_id);
 
+    {
+        guint   n_compiled;
+        guint   n_reused;
+        gdouble compile_time;
+
+        mm_regex_get_stats (&n_compiled, &n_reused, &compile_time);
+        mm_dbg ("%u regular expressions compiled in %.3fms, reused %u times",
+                n_compiled, compile_time * 1000.0, n_reused);
+    }
+
     mm_info ("ModemManager is shut down");
 
     mm_log_shutdown ();
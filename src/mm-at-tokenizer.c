@@ -0,0 +1,362 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "mm-at-tokenizer.h"
+
+#define IS_SPACE(c)   ((c) == ' ' || (c) == '\t')
+#define IS_EOL(c)     ((c) == '\r' || (c) == '\n')
+
+/*****************************************************************************/
+
+void
+mm_at_tokenizer_init (MMAtTokenizer *self,
+                      const gchar   *str,
+                      gssize         len)
+{
+    g_assert (str != NULL);
+
+    self->p = str;
+    self->end = str + (len < 0 ? strlen (str) : (gsize) len);
+    /* No current line yet */
+    self->line_end = str;
+}
+
+void
+mm_at_tokenizer_init_group (MMAtTokenizer   *self,
+                            const MMAtToken *group)
+{
+    self->p = group->str;
+    self->end = group->str + group->len;
+    /* The whole group is the current line */
+    self->line_end = self->end;
+}
+
+gboolean
+mm_at_tokenizer_next_line (MMAtTokenizer *self,
+                           const gchar   *tag)
+{
+    gsize tag_len;
+
+    tag_len = tag ? strlen (tag) : 0;
+
+    self->p = self->line_end;
+    while (self->p < self->end) {
+        const gchar *line;
+
+        /* Skip line terminators and leading whitespace */
+        while (self->p < self->end && (IS_EOL (*self->p) || IS_SPACE (*self->p)))
+            self->p++;
+        if (self->p == self->end)
+            break;
+
+        line = self->p;
+        while (self->p < self->end && !IS_EOL (*self->p))
+            self->p++;
+        self->line_end = self->p;
+
+        if (!tag_len) {
+            self->p = line;
+            return TRUE;
+        }
+
+        if ((gsize) (self->line_end - line) >= tag_len && memcmp (line, tag, tag_len) == 0) {
+            self->p = line + tag_len;
+            return TRUE;
+        }
+    }
+
+    self->line_end = self->end;
+    return FALSE;
+}
+
+static void
+skip_field_separator (MMAtTokenizer *self)
+{
+    /* Anything between the end of the field and the next comma is ignored */
+    while (self->p < self->line_end && *self->p != ',')
+        self->p++;
+    if (self->p < self->line_end)
+        self->p++;
+}
+
+gboolean
+mm_at_tokenizer_next (MMAtTokenizer *self,
+                      MMAtToken     *token)
+{
+    const gchar *start;
+
+    while (self->p < self->line_end && IS_SPACE (*self->p))
+        self->p++;
+    if (self->p >= self->line_end)
+        return FALSE;
+
+    switch (*self->p) {
+    case ',':
+        token->type = MM_AT_TOKEN_TYPE_NONE;
+        token->str = self->p;
+        token->len = 0;
+        self->p++;
+        return TRUE;
+
+    case '"':
+        start = ++self->p;
+        while (self->p < self->line_end && *self->p != '"')
+            self->p++;
+        token->type = MM_AT_TOKEN_TYPE_STRING;
+        token->str = start;
+        token->len = self->p - start;
+        skip_field_separator (self);
+        return TRUE;
+
+    case '(': {
+        guint    depth = 1;
+        gboolean quoted = FALSE;
+
+        start = ++self->p;
+        while (self->p < self->line_end) {
+            if (*self->p == '"')
+                quoted = !quoted;
+            else if (!quoted && *self->p == '(')
+                depth++;
+            else if (!quoted && *self->p == ')' && --depth == 0)
+                break;
+            self->p++;
+        }
+        token->type = MM_AT_TOKEN_TYPE_GROUP;
+        token->str = start;
+        token->len = self->p - start;
+        skip_field_separator (self);
+        return TRUE;
+    }
+
+    default:
+        start = self->p;
+        while (self->p < self->line_end && *self->p != ',')
+            self->p++;
+        token->type = MM_AT_TOKEN_TYPE_VALUE;
+        token->str = start;
+        token->len = self->p - start;
+        while (token->len > 0 && IS_SPACE (token->str[token->len - 1]))
+            token->len--;
+        if (self->p < self->line_end)
+            self->p++;
+        return TRUE;
+    }
+}
+
+gboolean
+mm_at_tokenizer_rest (MMAtTokenizer *self,
+                      MMAtToken     *token)
+{
+    while (self->p < self->line_end && IS_SPACE (*self->p))
+        self->p++;
+    if (self->p >= self->line_end)
+        return FALSE;
+
+    token->type = MM_AT_TOKEN_TYPE_VALUE;
+    token->str = self->p;
+    token->len = self->line_end - self->p;
+    while (token->len > 0 && IS_SPACE (token->str[token->len - 1]))
+        token->len--;
+    self->p = self->line_end;
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+static void
+token_strip (const MMAtToken  *token,
+             const gchar     **out_str,
+             gsize            *out_len)
+{
+    const gchar *str = token->str;
+    gsize        len = token->len;
+
+    while (len > 0 && IS_SPACE (*str)) {
+        str++;
+        len--;
+    }
+    while (len > 0 && IS_SPACE (str[len - 1]))
+        len--;
+
+    *out_str = str;
+    *out_len = len;
+}
+
+static gboolean
+parse_uint (const gchar *str,
+            gsize        len,
+            guint        base,
+            guint       *out)
+{
+    guint64 num = 0;
+    gsize   i;
+
+    if (!len)
+        return FALSE;
+
+    for (i = 0; i < len; i++) {
+        gint digit;
+
+        digit = (base == 16) ? g_ascii_xdigit_value (str[i]) : g_ascii_digit_value (str[i]);
+        if (digit < 0)
+            return FALSE;
+        num = num * base + digit;
+        if (num > G_MAXUINT)
+            return FALSE;
+    }
+
+    *out = (guint) num;
+    return TRUE;
+}
+
+gboolean
+mm_at_token_get_uint (const MMAtToken *token,
+                      guint           *out)
+{
+    const gchar *str;
+    gsize        len;
+
+    token_strip (token, &str, &len);
+    return parse_uint (str, len, 10, out);
+}
+
+gboolean
+mm_at_token_get_int (const MMAtToken *token,
+                     gint            *out)
+{
+    const gchar *str;
+    gsize        len;
+    gboolean     negative = FALSE;
+    guint        num;
+
+    token_strip (token, &str, &len);
+    if (len > 0 && (*str == '-' || *str == '+')) {
+        negative = (*str == '-');
+        str++;
+        len--;
+    }
+
+    if (!parse_uint (str, len, 10, &num))
+        return FALSE;
+
+    if (negative) {
+        if (num > (guint) G_MAXINT + 1)
+            return FALSE;
+        *out = (gint) (0 - (gint64) num);
+    } else {
+        if (num > G_MAXINT)
+            return FALSE;
+        *out = (gint) num;
+    }
+    return TRUE;
+}
+
+gboolean
+mm_at_token_get_hex (const MMAtToken *token,
+                     guint           *out)
+{
+    const gchar *str;
+    gsize        len;
+
+    token_strip (token, &str, &len);
+    return parse_uint (str, len, 16, out);
+}
+
+gboolean
+mm_at_token_get_range (const MMAtToken *token,
+                       guint           *out_min,
+                       guint           *out_max)
+{
+    const gchar *str;
+    gsize        len;
+    const gchar *dash;
+    MMAtToken    aux;
+    guint        min;
+    guint        max;
+
+    token_strip (token, &str, &len);
+
+    /* Allow the range to be given within parentheses */
+    if (len >= 2 && str[0] == '(' && str[len - 1] == ')') {
+        aux.type = MM_AT_TOKEN_TYPE_GROUP;
+        aux.str = str + 1;
+        aux.len = len - 2;
+        token_strip (&aux, &str, &len);
+    }
+
+    dash = memchr (str, '-', len);
+    if (!dash) {
+        if (!parse_uint (str, len, 10, &min))
+            return FALSE;
+        max = min;
+    } else {
+        aux.type = MM_AT_TOKEN_TYPE_VALUE;
+        aux.str = str;
+        aux.len = dash - str;
+        if (!mm_at_token_get_uint (&aux, &min))
+            return FALSE;
+        aux.str = dash + 1;
+        aux.len = len - (dash - str) - 1;
+        if (!mm_at_token_get_uint (&aux, &max))
+            return FALSE;
+    }
+
+    *out_min = min;
+    *out_max = max;
+    return TRUE;
+}
+
+gboolean
+mm_at_token_equal (const MMAtToken *token,
+                   const gchar     *str)
+{
+    const gchar *token_str;
+    gsize        token_len;
+
+    token_strip (token, &token_str, &token_len);
+    return (strlen (str) == token_len && memcmp (token_str, str, token_len) == 0);
+}
+
+gboolean
+mm_at_token_copy (const MMAtToken *token,
+                  gchar           *buffer,
+                  gsize            buffer_size)
+{
+    const gchar *str;
+    gsize        len;
+
+    token_strip (token, &str, &len);
+    if (!len || len >= buffer_size)
+        return FALSE;
+
+    memcpy (buffer, str, len);
+    buffer[len] = '\0';
+    return TRUE;
+}
+
+gchar *
+mm_at_token_dup (const MMAtToken *token)
+{
+    const gchar *str;
+    gsize        len;
+
+    token_strip (token, &str, &len);
+    return (len ? g_strndup (str, len) : NULL);
+}
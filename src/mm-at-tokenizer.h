@@ -0,0 +1,89 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#ifndef MM_AT_TOKENIZER_H
+#define MM_AT_TOKENIZER_H
+
+#include <glib.h>
+
+/* Tokenizer for AT information responses, e.g.:
+ *
+ *   +TAG: 1,"text",(1-3),,("a","b")
+ *
+ * Tokens are slices of the original buffer, so nothing is allocated while
+ * parsing; the buffer must outlive the tokenizer and its tokens. */
+
+typedef enum {
+    MM_AT_TOKEN_TYPE_NONE,   /* Empty field */
+    MM_AT_TOKEN_TYPE_VALUE,  /* Unquoted value (number, range, hex...) */
+    MM_AT_TOKEN_TYPE_STRING, /* Quoted string, without the quotes */
+    MM_AT_TOKEN_TYPE_GROUP,  /* Parenthesised list, without the parentheses */
+} MMAtTokenType;
+
+typedef struct {
+    MMAtTokenType  type;
+    const gchar   *str;
+    gsize          len;
+} MMAtToken;
+
+typedef struct {
+    const gchar *p;
+    const gchar *end;
+    const gchar *line_end;
+} MMAtTokenizer;
+
+void     mm_at_tokenizer_init       (MMAtTokenizer   *self,
+                                     const gchar     *str,
+                                     gssize           len);
+
+/* Iterates the elements of a group token */
+void     mm_at_tokenizer_init_group (MMAtTokenizer   *self,
+                                     const MMAtToken *group);
+
+/* Moves to the next non-empty line. If a tag is given, lines not starting with
+ * it are skipped, and the tag itself is consumed. */
+gboolean mm_at_tokenizer_next_line  (MMAtTokenizer   *self,
+                                     const gchar     *tag);
+
+/* Reads the next field of the current line; FALSE when there are no more */
+gboolean mm_at_tokenizer_next       (MMAtTokenizer   *self,
+                                     MMAtToken       *token);
+
+/* Reads whatever is left in the current line as a single value */
+gboolean mm_at_tokenizer_rest       (MMAtTokenizer   *self,
+                                     MMAtToken       *token);
+
+gboolean mm_at_token_get_uint       (const MMAtToken *token,
+                                     guint           *out);
+gboolean mm_at_token_get_int        (const MMAtToken *token,
+                                     gint            *out);
+gboolean mm_at_token_get_hex        (const MMAtToken *token,
+                                     guint           *out);
+/* Either "<min>-<max>" or a single "<value>", with or without parentheses */
+gboolean mm_at_token_get_range      (const MMAtToken *token,
+                                     guint           *out_min,
+                                     guint           *out_max);
+gboolean mm_at_token_equal          (const MMAtToken *token,
+                                     const gchar     *str);
+/* Copies the (whitespace-stripped) token into the given buffer; FALSE if
+ * empty or if it doesn't fit */
+gboolean mm_at_token_copy           (const MMAtToken *token,
+                                     gchar           *buffer,
+                                     gsize            buffer_size);
+/* Returns a newly allocated copy of the (whitespace-stripped) token, or NULL
+ * if empty */
+gchar   *mm_at_token_dup            (const MMAtToken *token);
+
+#endif /* MM_AT_TOKENIZER_H */
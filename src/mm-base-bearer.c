@@ -38,6 +38,9 @@
 #include "mm-log.h"
 #include "mm-modem-helpers.h"
 #include "mm-bearer-stats.h"
+#include "mm-poll-scheduler.h"
+#include "mm-netlink-monitor.h"
+#include "mm-throughput.h"
 
 /* We require up to 20s to get a proper IP when using PPP */
 #define BEARER_IP_TIMEOUT_DEFAULT 20
@@ -45,6 +48,9 @@
 #define BEARER_DEFERRED_UNREGISTRATION_TIMEOUT 15
 
 #define BEARER_STATS_UPDATE_TIMEOUT 30
+/* When the byte counters are read from the kernel, the modem is only queried
+ * as a consistency check */
+#define BEARER_STATS_CONSISTENCY_CHECK_TIMEOUT 300
 
 /* Initial connectivity check after 30s, then each 5s */
 #define BEARER_CONNECTION_MONITOR_INITIAL_TIMEOUT 30
@@ -120,6 +126,16 @@ struct _MMBaseBearerPrivate {
     GTimer *duration_timer;
     /* Flag to specify whether reloading stats is supported or not */
     gboolean reload_stats_unsupported;
+
+    /* Netlink watch of the net data port, if any */
+    guint netlink_watch_id;
+    /* Kernel byte counters when the bearer stats were last rebased */
+    MMNetlinkStatsBase netlink_stats_base;
+    /* Last carrier reported while the interface was up */
+    gboolean netlink_carrier_known;
+    gboolean netlink_carrier;
+    /* Throughput computed from the kernel byte counters */
+    MMThroughput *throughput;
 };
 
 /*****************************************************************************/
@@ -152,7 +168,7 @@ static void
 connection_monitor_stop (MMBaseBearer *self)
 {
     if (self->priv->connection_monitor_id) {
-        g_source_remove (self->priv->connection_monitor_id);
+        mm_poll_scheduler_remove (mm_poll_scheduler_get (), self->priv->connection_monitor_id);
         self->priv->connection_monitor_id = 0;
     }
 }
@@ -188,7 +204,7 @@ load_connection_status_ready (MMBaseBearer *self,
     mm_base_bearer_report_connection_status (self, status);
 }
 
-static gboolean
+static void
 connection_monitor_cb (MMBaseBearer *self)
 {
     /* If the implementation knows how to load connection status, run it */
@@ -196,24 +212,21 @@ connection_monitor_cb (MMBaseBearer *self)
         self,
         (GAsyncReadyCallback)load_connection_status_ready,
         NULL);
-    return G_SOURCE_CONTINUE;
 }
 
-static gboolean
+static void
 initial_connection_monitor_cb (MMBaseBearer *self)
 {
-    MM_BASE_BEARER_GET_CLASS (self)->load_connection_status (
-        self,
-        (GAsyncReadyCallback)load_connection_status_ready,
-        NULL);
-
-    /* Add new monitor timeout at a higher rate */
-    self->priv->connection_monitor_id = g_timeout_add_seconds (BEARER_CONNECTION_MONITOR_TIMEOUT,
-                                                               (GSourceFunc) connection_monitor_cb,
+    /* Replace the initial check with a new job at a higher rate */
+    mm_poll_scheduler_remove (mm_poll_scheduler_get (), self->priv->connection_monitor_id);
+    self->priv->connection_monitor_id = mm_poll_scheduler_add (mm_poll_scheduler_get (),
+                                                               self->priv->path,
+                                                               "connection-monitor",
+                                                               BEARER_CONNECTION_MONITOR_TIMEOUT,
+                                                               0,
+                                                               (MMPollSchedulerFunc) connection_monitor_cb,
                                                                self);
-
-    /* Remove the initial connection monitor timeout as we added a new one */
-    return G_SOURCE_REMOVE;
+    connection_monitor_cb (self);
 }
 
 static void
@@ -229,8 +242,12 @@ connection_monitor_start (MMBaseBearer *self)
 
     /* Schedule initial check */
     g_assert (!self->priv->connection_monitor_id);
-    self->priv->connection_monitor_id = g_timeout_add_seconds (BEARER_CONNECTION_MONITOR_INITIAL_TIMEOUT,
-                                                               (GSourceFunc) initial_connection_monitor_cb,
+    self->priv->connection_monitor_id = mm_poll_scheduler_add (mm_poll_scheduler_get (),
+                                                               self->priv->path,
+                                                               "connection-monitor",
+                                                               BEARER_CONNECTION_MONITOR_INITIAL_TIMEOUT,
+                                                               0,
+                                                               (MMPollSchedulerFunc) initial_connection_monitor_cb,
                                                                self);
 }
 
@@ -262,7 +279,7 @@ bearer_stats_stop (MMBaseBearer *self)
     }
 
     if (self->priv->stats_update_id) {
-        g_source_remove (self->priv->stats_update_id);
+        mm_poll_scheduler_remove (mm_poll_scheduler_get (), self->priv->stats_update_id);
         self->priv->stats_update_id = 0;
     }
 }
@@ -292,6 +309,20 @@ reload_stats_ready (MMBaseBearer *self,
         g_error_free (error);
     }
 
+    /* If the byte counters are read from the kernel, just compare */
+    if (self->priv->netlink_stats_base.set && !self->priv->reload_stats_unsupported) {
+        mm_dbg ("Bearer '%s' stats consistency check: "
+                "modem reports %" G_GUINT64_FORMAT "/%" G_GUINT64_FORMAT " rx/tx bytes, "
+                "kernel reports %" G_GUINT64_FORMAT "/%" G_GUINT64_FORMAT " rx/tx bytes",
+                self->priv->path,
+                rx_bytes, tx_bytes,
+                mm_bearer_stats_get_rx_bytes (self->priv->stats),
+                mm_bearer_stats_get_tx_bytes (self->priv->stats));
+        mm_bearer_stats_set_duration (self->priv->stats, (guint32) g_timer_elapsed (self->priv->duration_timer, NULL));
+        bearer_update_interface_stats (self);
+        return;
+    }
+
     /* We only update stats if they were retrieved properly */
     mm_bearer_stats_set_duration (self->priv->stats, (guint32) g_timer_elapsed (self->priv->duration_timer, NULL));
     mm_bearer_stats_set_tx_bytes (self->priv->stats, tx_bytes);
@@ -299,7 +330,7 @@ reload_stats_ready (MMBaseBearer *self,
     bearer_update_interface_stats (self);
 }
 
-static gboolean
+static void
 stats_update_cb (MMBaseBearer *self)
 {
     /* If the implementation knows how to update stat values, run it */
@@ -310,15 +341,17 @@ stats_update_cb (MMBaseBearer *self)
             self,
             (GAsyncReadyCallback)reload_stats_ready,
             NULL);
-        return G_SOURCE_CONTINUE;
+        return;
     }
 
-    /* Otherwise, just update duration and we're done */
+    /* Otherwise, just update duration and we're done (byte counters may
+     * still be read from the kernel) */
     mm_bearer_stats_set_duration (self->priv->stats, (guint32) g_timer_elapsed (self->priv->duration_timer, NULL));
-    mm_bearer_stats_set_tx_bytes (self->priv->stats, 0);
-    mm_bearer_stats_set_rx_bytes (self->priv->stats, 0);
+    if (!self->priv->netlink_stats_base.set) {
+        mm_bearer_stats_set_tx_bytes (self->priv->stats, 0);
+        mm_bearer_stats_set_rx_bytes (self->priv->stats, 0);
+    }
     bearer_update_interface_stats (self);
-    return G_SOURCE_CONTINUE;
 }
 
 static void
@@ -335,13 +368,134 @@ bearer_stats_start (MMBaseBearer *self)
 
     /* Schedule */
     g_assert (!self->priv->stats_update_id);
-    self->priv->stats_update_id = g_timeout_add_seconds (BEARER_STATS_UPDATE_TIMEOUT,
-                                                         (GSourceFunc) stats_update_cb,
+    self->priv->stats_update_id = mm_poll_scheduler_add (mm_poll_scheduler_get (),
+                                                         self->priv->path,
+                                                         "stats",
+                                                         (self->priv->netlink_watch_id ?
+                                                          BEARER_STATS_CONSISTENCY_CHECK_TIMEOUT :
+                                                          BEARER_STATS_UPDATE_TIMEOUT),
+                                                         0,
+                                                         (MMPollSchedulerFunc) stats_update_cb,
                                                          self);
     /* Load initial values */
     stats_update_cb (self);
 }
 
+/*****************************************************************************/
+/* Data interface monitoring */
+
+static void
+netlink_stats_update (MMBaseBearer            *self,
+                      const MMNetlinkLinkInfo *info)
+{
+    guint64 previous_rx_bytes;
+    guint64 rx_bytes;
+    guint64 tx_bytes;
+
+    if (!self->priv->stats)
+        return;
+
+    previous_rx_bytes = mm_bearer_stats_get_rx_bytes (self->priv->stats);
+
+    /* The kernel counts since the interface was created, so just add what was
+     * counted since the first report to the values exposed so far */
+    rx_bytes = previous_rx_bytes;
+    tx_bytes = mm_bearer_stats_get_tx_bytes (self->priv->stats);
+    mm_netlink_stats_base_update (&self->priv->netlink_stats_base, info, &rx_bytes, &tx_bytes);
+
+    mm_bearer_stats_set_duration (self->priv->stats, (guint32) g_timer_elapsed (self->priv->duration_timer, NULL));
+    mm_bearer_stats_set_rx_bytes (self->priv->stats, rx_bytes);
+    mm_bearer_stats_set_tx_bytes (self->priv->stats, tx_bytes);
+    bearer_update_interface_stats (self);
+
+    if (mm_throughput_add_sample (self->priv->throughput, g_get_monotonic_time (), info->rx_bytes, info->tx_bytes))
+        mm_gdbus_bearer_set_throughput (MM_GDBUS_BEARER (self), mm_throughput_get_dictionary (self->priv->throughput));
+
+    /* Data received from the network means we're still connected, so the
+     * connection status check isn't needed yet */
+    if (self->priv->connection_monitor_id &&
+        mm_bearer_stats_get_rx_bytes (self->priv->stats) > previous_rx_bytes)
+        mm_poll_scheduler_touch (mm_poll_scheduler_get (), self->priv->connection_monitor_id);
+}
+
+static void
+netlink_carrier_update (MMBaseBearer            *self,
+                        const MMNetlinkLinkInfo *info)
+{
+    if (!info->removed) {
+        /* The interface is brought up by the connection manager after the
+         * bearer is connected; carrier is only meaningful while up */
+        if (!info->up) {
+            self->priv->netlink_carrier_known = FALSE;
+            return;
+        }
+
+        if (self->priv->netlink_carrier_known && self->priv->netlink_carrier == info->carrier)
+            return;
+
+        /* First report while up */
+        if (!self->priv->netlink_carrier_known) {
+            self->priv->netlink_carrier_known = TRUE;
+            self->priv->netlink_carrier = info->carrier;
+            return;
+        }
+
+        self->priv->netlink_carrier = info->carrier;
+    }
+
+    mm_dbg ("Bearer '%s' data interface '%s' %s",
+            self->priv->path,
+            info->ifname,
+            info->removed ? "removed" : (info->carrier ? "carrier on" : "carrier off"));
+
+    /* Check the connection status right away, if supported */
+    if (self->priv->connection_monitor_id)
+        connection_monitor_cb (self);
+}
+
+static void
+netlink_link_info_cb (const MMNetlinkLinkInfo *info,
+                      MMBaseBearer            *self)
+{
+    if (info->has_stats)
+        netlink_stats_update (self, info);
+    netlink_carrier_update (self, info);
+}
+
+static void
+netlink_monitor_stop (MMBaseBearer *self)
+{
+    if (self->priv->netlink_watch_id) {
+        mm_netlink_monitor_remove (mm_netlink_monitor_get (), self->priv->netlink_watch_id);
+        self->priv->netlink_watch_id = 0;
+    }
+    self->priv->netlink_stats_base.set = FALSE;
+    self->priv->netlink_carrier_known = FALSE;
+    if (self->priv->throughput) {
+        mm_throughput_reset (self->priv->throughput);
+        mm_gdbus_bearer_set_throughput (MM_GDBUS_BEARER (self), NULL);
+    }
+}
+
+static void
+netlink_monitor_start (MMBaseBearer *self,
+                       MMPort       *data)
+{
+    /* Only net ports; PPP interfaces are managed by pppd */
+    if (mm_port_get_port_type (data) != MM_PORT_TYPE_NET)
+        return;
+
+    /* Allocated once, and reset on every disconnection */
+    if (!self->priv->throughput)
+        self->priv->throughput = mm_throughput_new (mm_netlink_monitor_get_stats_interval (mm_netlink_monitor_get ()));
+
+    g_assert (!self->priv->netlink_watch_id);
+    self->priv->netlink_watch_id = mm_netlink_monitor_add (mm_netlink_monitor_get (),
+                                                           mm_port_get_device (data),
+                                                           (MMNetlinkMonitorFunc) netlink_link_info_cb,
+                                                           self);
+}
+
 /*****************************************************************************/
 
 static void
@@ -377,18 +531,20 @@ bearer_update_status (MMBaseBearer *self,
         bearer_stats_stop (self);
         /* Stop connection monitoring */
         connection_monitor_stop (self);
+        /* Stop data interface monitoring */
+        netlink_monitor_stop (self);
     }
 }
 
 static void
 bearer_update_status_connected (MMBaseBearer *self,
-                                const gchar *interface,
+                                MMPort *data,
                                 MMBearerIpConfig *ipv4_config,
                                 MMBearerIpConfig *ipv6_config)
 {
     mm_gdbus_bearer_set_connected (MM_GDBUS_BEARER (self), TRUE);
     mm_gdbus_bearer_set_suspended (MM_GDBUS_BEARER (self), FALSE);
-    mm_gdbus_bearer_set_interface (MM_GDBUS_BEARER (self), interface);
+    mm_gdbus_bearer_set_interface (MM_GDBUS_BEARER (self), mm_port_get_device (data));
     mm_gdbus_bearer_set_ip4_config (
         MM_GDBUS_BEARER (self),
         mm_bearer_ip_config_get_dictionary (ipv4_config));
@@ -396,6 +552,9 @@ bearer_update_status_connected (MMBaseBearer *self,
         MM_GDBUS_BEARER (self),
         mm_bearer_ip_config_get_dictionary (ipv6_config));
 
+    /* Start data interface monitoring, if it's a net port */
+    netlink_monitor_start (self, data);
+
     /* Start statistics */
     bearer_stats_start (self);
 
@@ -732,7 +891,7 @@ connect_ready (MMBaseBearer *self,
         /* Update bearer and interface status */
         bearer_update_status_connected (
             self,
-            mm_port_get_device (mm_bearer_connect_result_peek_data (result)),
+            mm_bearer_connect_result_peek_data (result),
             mm_bearer_connect_result_peek_ipv4_config (result),
             mm_bearer_connect_result_peek_ipv6_config (result));
         mm_bearer_connect_result_unref (result);
@@ -1399,6 +1558,8 @@ finalize (GObject *object)
 {
     MMBaseBearer *self = MM_BASE_BEARER (object);
 
+    if (self->priv->throughput)
+        mm_throughput_free (self->priv->throughput);
     g_free (self->priv->path);
 
     G_OBJECT_CLASS (mm_base_bearer_parent_class)->finalize (object);
@@ -1410,6 +1571,7 @@ dispose (GObject *object)
     MMBaseBearer *self = MM_BASE_BEARER (object);
 
     connection_monitor_stop (self);
+    netlink_monitor_stop (self);
     bearer_stats_stop (self);
     g_clear_object (&self->priv->stats);
 
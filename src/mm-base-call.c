@@ -31,6 +31,7 @@
 #include "mm-base-modem-at.h"
 #include "mm-base-modem.h"
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-modem-helpers.h"
 
 G_DEFINE_TYPE (MMBaseCall, mm_base_call, MM_GDBUS_TYPE_CALL_SKELETON)
@@ -99,8 +100,8 @@ common_setup_cleanup_unsolicited_events (MMBaseCall  *self,
     gint            i;
 
     if (G_UNLIKELY (!self->priv->in_call_events))
-        self->priv->in_call_events = g_regex_new ("\\r\\n(NO CARRIER|BUSY|NO ANSWER|NO DIALTONE)\\r\\n$",
-                                                  G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        self->priv->in_call_events = mm_regex_get ("\\r\\n(NO CARRIER|BUSY|NO ANSWER|NO DIALTONE)\\r\\n$",
+                                                   G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
 
     g_object_get (self,
                   MM_BASE_CALL_MODEM, &modem,
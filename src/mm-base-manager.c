@@ -44,6 +44,8 @@
 #include "mm-auth.h"
 #include "mm-plugin.h"
 #include "mm-filter.h"
+#include "mm-port-index.h"
+#include "mm-poll-scheduler.h"
 #include "mm-log.h"
 
 static void initable_iface_init (GInitableIface *iface);
@@ -85,6 +87,8 @@ struct _MMBaseManagerPrivate {
     MMFilter *filter;
     /* The container of devices being prepared */
     GHashTable *devices;
+    /* Index of the ports grabbed by each device */
+    MMPortIndex *ports;
     /* The Object Manager server */
     GDBusObjectManagerServer *object_manager;
     /* The map of inhibited devices */
@@ -101,21 +105,27 @@ struct _MMBaseManagerPrivate {
 
 /*****************************************************************************/
 
+static MMDevice *
+find_device_by_physdev_uid (MMBaseManager *self,
+                            const gchar   *physdev_uid)
+{
+    return g_hash_table_lookup (self->priv->devices, physdev_uid);
+}
+
 static MMDevice *
 find_device_by_modem (MMBaseManager *manager,
                       MMBaseModem *modem)
 {
-    GHashTableIter iter;
-    gpointer key, value;
+    const gchar *uid;
+    MMDevice    *device;
 
-    g_hash_table_iter_init (&iter, manager->priv->devices);
-    while (g_hash_table_iter_next (&iter, &key, &value)) {
-        MMDevice *candidate = MM_DEVICE (value);
+    /* Modems are created with the uid of the device owning them */
+    uid = mm_base_modem_get_device (modem);
+    if (!uid)
+        return NULL;
 
-        if (modem == mm_device_peek_modem (candidate))
-            return candidate;
-    }
-    return NULL;
+    device = find_device_by_physdev_uid (manager, uid);
+    return ((device && mm_device_peek_modem (device) == modem) ? device : NULL);
 }
 
 static MMDevice *
@@ -124,7 +134,19 @@ find_device_by_port (MMBaseManager  *manager,
 {
     GHashTableIter iter;
     gpointer key, value;
+    MMDevice *device;
 
+    /* The index is keyed by subsystem and name, which may not be the same
+     * port (e.g. another device got the same name before the old one was
+     * released), so the owner must still agree with mm_kernel_device_cmp() */
+    device = mm_port_index_lookup (manager->priv->ports,
+                                   mm_kernel_device_get_subsystem (port),
+                                   mm_kernel_device_get_name (port));
+    if (device && mm_device_owns_port (device, port))
+        return device;
+
+    /* Otherwise, the port may still be known by other means (e.g. renamed
+     * ports by their old sysfs path), so we need to ask each device */
     g_hash_table_iter_init (&iter, manager->priv->devices);
     while (g_hash_table_iter_next (&iter, &key, &value)) {
         MMDevice *candidate = MM_DEVICE (value);
@@ -135,13 +157,6 @@ find_device_by_port (MMBaseManager  *manager,
     return NULL;
 }
 
-static MMDevice *
-find_device_by_physdev_uid (MMBaseManager *self,
-                            const gchar   *physdev_uid)
-{
-    return g_hash_table_lookup (self->priv->devices, physdev_uid);
-}
-
 static MMDevice *
 find_device_by_kernel_device (MMBaseManager  *manager,
                               MMKernelDevice *kernel_device)
@@ -149,6 +164,68 @@ find_device_by_kernel_device (MMBaseManager  *manager,
     return find_device_by_physdev_uid (manager, mm_kernel_device_get_physdev_uid (kernel_device));
 }
 
+static void
+device_port_grabbed (MMDevice       *device,
+                     MMKernelDevice *port,
+                     MMBaseManager  *self)
+{
+    mm_port_index_add (self->priv->ports,
+                       mm_kernel_device_get_subsystem (port),
+                       mm_kernel_device_get_name (port),
+                       device);
+}
+
+static void
+device_port_released (MMDevice       *device,
+                      MMKernelDevice *port,
+                      MMBaseManager  *self)
+{
+    mm_port_index_remove (self->priv->ports,
+                          mm_kernel_device_get_subsystem (port),
+                          mm_kernel_device_get_name (port),
+                          device);
+}
+
+static void
+track_device (MMBaseManager *self,
+              MMDevice      *device)
+{
+    /* Takes ownership of the device */
+    g_hash_table_insert (self->priv->devices, g_strdup (mm_device_get_uid (device)), device);
+    g_signal_connect_object (device,
+                             MM_DEVICE_PORT_GRABBED,
+                             G_CALLBACK (device_port_grabbed),
+                             self,
+                             0);
+    g_signal_connect_object (device,
+                             MM_DEVICE_PORT_RELEASED,
+                             G_CALLBACK (device_port_released),
+                             self,
+                             0);
+}
+
+static void
+device_untrack_ports (MMBaseManager *self,
+                      MMDevice      *device)
+{
+    g_signal_handlers_disconnect_by_func (device, device_port_grabbed, self);
+    g_signal_handlers_disconnect_by_func (device, device_port_released, self);
+    mm_port_index_remove_owner (self->priv->ports, device);
+}
+
+static void
+untrack_device (MMBaseManager *self,
+                MMDevice      *device)
+{
+    /* The device may have already been removed from the tracking HT */
+    if (find_device_by_physdev_uid (self, mm_device_get_uid (device)) != device)
+        return;
+
+    device_untrack_ports (self, device);
+    mm_log_trace_forget (mm_device_get_uid (device));
+    g_hash_table_remove (self->priv->devices, mm_device_get_uid (device));
+}
+
 /*****************************************************************************/
 
 typedef struct {
@@ -183,7 +260,7 @@ device_support_check_ready (MMPluginManager          *plugin_manager,
         mm_info ("Couldn't check support for device '%s': %s",
                  mm_device_get_uid (ctx->device), error->message);
         g_error_free (error);
-        g_hash_table_remove (ctx->self->priv->devices, mm_device_get_uid (ctx->device));
+        untrack_device (ctx->self, ctx->device);
         find_device_support_context_free (ctx);
         return;
     }
@@ -196,7 +273,7 @@ device_support_check_ready (MMPluginManager          *plugin_manager,
         mm_warn ("Couldn't create modem for device '%s': %s",
                  mm_device_get_uid (ctx->device), error->message);
         g_error_free (error);
-        g_hash_table_remove (ctx->self->priv->devices, mm_device_get_uid (ctx->device));
+        untrack_device (ctx->self, ctx->device);
         find_device_support_context_free (ctx);
         return;
     }
@@ -237,7 +314,7 @@ device_removed (MMBaseManager  *self,
             /* The callbacks triggered when the port is released or device support is
              * cancelled may end up unreffing the device or removing it from the HT, and
              * so in order to make sure the reference is still valid when we call
-             * support_check_cancel() and g_hash_table_remove(), we hold a full reference
+             * support_check_cancel() and untrack_device(), we hold a full reference
              * ourselves. */
             g_object_ref (device);
             {
@@ -253,7 +330,7 @@ device_removed (MMBaseManager  *self,
                     /* The device may have already been removed from the tracking HT, we
                      * just try to remove it and if it fails, we ignore it */
                     mm_device_remove_modem (device);
-                    g_hash_table_remove (self->priv->devices, mm_device_get_uid (device));
+                    untrack_device (self, device);
                 }
             }
             g_object_unref (device);
@@ -293,7 +370,7 @@ device_removed (MMBaseManager  *self,
     if (device) {
         mm_dbg ("Removing device '%s'", mm_device_get_uid (device));
         mm_device_remove_modem (device);
-        g_hash_table_remove (self->priv->devices, mm_device_get_uid (device));
+        untrack_device (self, device);
         return;
     }
 }
@@ -369,9 +446,7 @@ device_added (MMBaseManager  *manager,
 
         /* Keep the device listed in the Manager */
         device = mm_device_new (physdev_uid, hotplugged, FALSE);
-        g_hash_table_insert (manager->priv->devices,
-                             g_strdup (physdev_uid),
-                             device);
+        track_device (manager, device);
 
         /* Launch device support check */
         ctx = g_slice_new (FindDeviceSupportContext);
@@ -653,7 +728,7 @@ remove_disable_ready (MMBaseModem *modem,
     if (device) {
         g_cancellable_cancel (mm_base_modem_peek_cancellable (modem));
         mm_device_remove_modem (device);
-        g_hash_table_remove (self->priv->devices, mm_device_get_uid (device));
+        untrack_device (self, device);
     }
 }
 
@@ -680,6 +755,7 @@ foreach_remove (gpointer key,
     if (modem)
         g_cancellable_cancel (mm_base_modem_peek_cancellable (modem));
     mm_device_remove_modem (device);
+    device_untrack_ports (self, device);
     return TRUE;
 }
 
@@ -847,6 +923,66 @@ handle_scan_devices (MmGdbusOrgFreedesktopModemManager1 *manager,
     return TRUE;
 }
 
+/*****************************************************************************/
+/* Poll timeline */
+
+typedef struct {
+    MMBaseManager *self;
+    GDBusMethodInvocation *invocation;
+} GetPollTimelineContext;
+
+static void
+get_poll_timeline_context_free (GetPollTimelineContext *ctx)
+{
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->self);
+    g_free (ctx);
+}
+
+static void
+get_poll_timeline_auth_ready (MMAuthProvider *authp,
+                              GAsyncResult *res,
+                              GetPollTimelineContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!mm_auth_provider_authorize_finish (authp, res, &error))
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+    /* Not part of the stable API, so only in debug mode */
+    else if (!mm_context_get_debug ())
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_UNAUTHORIZED,
+                                               "Cannot get poll timeline: "
+                                               "operation only allowed in debug mode");
+    else
+        mm_gdbus_org_freedesktop_modem_manager1_complete_get_poll_timeline (
+            MM_GDBUS_ORG_FREEDESKTOP_MODEM_MANAGER1 (ctx->self),
+            ctx->invocation,
+            mm_poll_scheduler_get_timeline (mm_poll_scheduler_get ()));
+
+    get_poll_timeline_context_free (ctx);
+}
+
+static gboolean
+handle_get_poll_timeline (MmGdbusOrgFreedesktopModemManager1 *manager,
+                          GDBusMethodInvocation *invocation)
+{
+    GetPollTimelineContext *ctx;
+
+    ctx = g_new (GetPollTimelineContext, 1);
+    ctx->self = g_object_ref (manager);
+    ctx->invocation = g_object_ref (invocation);
+
+    mm_auth_provider_authorize (ctx->self->priv->authp,
+                                invocation,
+                                MM_AUTHORIZATION_MANAGER_CONTROL,
+                                ctx->self->priv->authp_cancellable,
+                                (GAsyncReadyCallback)get_poll_timeline_auth_ready,
+                                ctx);
+    return TRUE;
+}
+
 /*****************************************************************************/
 
 typedef struct {
@@ -1272,7 +1408,8 @@ handle_set_profile (MmGdbusTest *skeleton,
     /* Create device and keep it listed in the Manager */
     physdev_uid = g_strdup_printf ("/virtual/%s", id);
     device = mm_device_new (physdev_uid, TRUE, TRUE);
-    g_hash_table_insert (self->priv->devices, physdev_uid, device);
+    g_free (physdev_uid);
+    track_device (self, device);
 
     /* Grab virtual ports */
     mm_device_virtual_grab_ports (device, (const gchar **)ports);
@@ -1306,7 +1443,7 @@ out:
 
     if (error) {
         mm_device_remove_modem (device);
-        g_hash_table_remove (self->priv->devices, mm_device_get_uid (device));
+        untrack_device (self, device);
         g_dbus_method_invocation_return_gerror (invocation, error);
         g_error_free (error);
     } else
@@ -1444,6 +1581,7 @@ mm_base_manager_init (MMBaseManager *manager)
 
     /* Setup internal lists of device objects */
     priv->devices = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+    priv->ports = mm_port_index_new ();
 
     /* Setup internal list of inhibited devices */
     priv->inhibited_devices = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify)inhibited_device_info_free);
@@ -1472,6 +1610,7 @@ mm_base_manager_init (MMBaseManager *manager)
                       "signal::handle-scan-devices",        G_CALLBACK (handle_scan_devices),        NULL,
                       "signal::handle-report-kernel-event", G_CALLBACK (handle_report_kernel_event), NULL,
                       "signal::handle-inhibit-device",      G_CALLBACK (handle_inhibit_device),      NULL,
+                      "signal::handle-get-poll-timeline",   G_CALLBACK (handle_get_poll_timeline),   NULL,
                       NULL);
 }
 
@@ -1537,6 +1676,7 @@ finalize (GObject *object)
 
     g_hash_table_destroy (priv->inhibited_devices);
     g_hash_table_destroy (priv->devices);
+    mm_port_index_free (priv->ports);
 
 #if defined WITH_UDEV
     if (priv->udev)
@@ -504,16 +504,17 @@ at_command_ready (MMPortSerialAt *port,
     at_command_context_free (ctx);
 }
 
-void
-mm_base_modem_at_command_full (MMBaseModem *self,
-                               MMPortSerialAt *port,
-                               const gchar *command,
-                               guint timeout,
-                               gboolean allow_cached,
-                               gboolean is_raw,
-                               GCancellable *cancellable,
-                               GAsyncReadyCallback callback,
-                               gpointer user_data)
+static void
+at_command_run (MMBaseModem *self,
+                MMPortSerialAt *port,
+                const gchar *command,
+                guint timeout,
+                gboolean allow_cached,
+                gboolean is_raw,
+                MMPortSerialCommandPriority priority,
+                GCancellable *cancellable,
+                GAsyncReadyCallback callback,
+                gpointer user_data)
 {
     AtCommandContext *ctx;
 
@@ -546,17 +547,41 @@ mm_base_modem_at_command_full (MMBaseModem *self,
     }
 
     /* Go on with the command */
-    mm_port_serial_at_command (
+    mm_port_serial_at_command_full (
         port,
         command,
         timeout,
         is_raw,
         allow_cached,
+        priority,
         ctx->cancellable,
         (GAsyncReadyCallback)at_command_ready,
         ctx);
 }
 
+void
+mm_base_modem_at_command_full (MMBaseModem *self,
+                               MMPortSerialAt *port,
+                               const gchar *command,
+                               guint timeout,
+                               gboolean allow_cached,
+                               gboolean is_raw,
+                               GCancellable *cancellable,
+                               GAsyncReadyCallback callback,
+                               gpointer user_data)
+{
+    at_command_run (self,
+                    port,
+                    command,
+                    timeout,
+                    allow_cached,
+                    is_raw,
+                    MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
+                    cancellable,
+                    callback,
+                    user_data);
+}
+
 const gchar *
 mm_base_modem_at_command_finish (MMBaseModem *self,
                                  GAsyncResult *res,
@@ -565,12 +590,32 @@ mm_base_modem_at_command_finish (MMBaseModem *self,
     return mm_base_modem_at_command_full_finish (self, res, error);
 }
 
+static MMPortSerialAt *
+peek_at_port_for_priority (MMBaseModem *self,
+                           MMPortSerialCommandPriority priority,
+                           GError **error)
+{
+    MMPortSerialAt *secondary;
+
+    /* Background commands (e.g. network scans) may take minutes to complete,
+     * so keep them out of the primary port whenever a secondary one is
+     * available, and let the primary port serve the latency-sensitive ones. */
+    if (priority == MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND) {
+        secondary = mm_base_modem_peek_port_secondary (self);
+        if (secondary && !mm_port_get_connected (MM_PORT (secondary)))
+            return secondary;
+    }
+
+    return mm_base_modem_peek_best_at_port (self, error);
+}
+
 static void
 _at_command (MMBaseModem *self,
              const gchar *command,
              guint timeout,
              gboolean allow_cached,
              gboolean is_raw,
+             MMPortSerialCommandPriority priority,
              GAsyncReadyCallback callback,
              gpointer user_data)
 {
@@ -578,7 +623,7 @@ _at_command (MMBaseModem *self,
     GError *error = NULL;
 
     /* No port given, so we'll try to guess which is best */
-    port = mm_base_modem_peek_best_at_port (self, &error);
+    port = peek_at_port_for_priority (self, priority, &error);
     if (!port) {
         g_assert (error != NULL);
         g_simple_async_report_take_gerror_in_idle (G_OBJECT (self),
@@ -588,15 +633,16 @@ _at_command (MMBaseModem *self,
         return;
     }
 
-    mm_base_modem_at_command_full (self,
-                                   port,
-                                   command,
-                                   timeout,
-                                   allow_cached,
-                                   is_raw,
-                                   NULL,
-                                   callback,
-                                   user_data);
+    at_command_run (self,
+                    port,
+                    command,
+                    timeout,
+                    allow_cached,
+                    is_raw,
+                    priority,
+                    NULL,
+                    callback,
+                    user_data);
 }
 
 void
@@ -607,7 +653,21 @@ mm_base_modem_at_command (MMBaseModem *self,
                           GAsyncReadyCallback callback,
                           gpointer user_data)
 {
-    _at_command (self, command, timeout, allow_cached, FALSE, callback, user_data);
+    _at_command (self, command, timeout, allow_cached, FALSE,
+                 MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
+                 callback, user_data);
+}
+
+void
+mm_base_modem_at_command_priority (MMBaseModem *self,
+                                   const gchar *command,
+                                   guint timeout,
+                                   gboolean allow_cached,
+                                   MMPortSerialCommandPriority priority,
+                                   GAsyncReadyCallback callback,
+                                   gpointer user_data)
+{
+    _at_command (self, command, timeout, allow_cached, FALSE, priority, callback, user_data);
 }
 
 void
@@ -618,5 +678,7 @@ mm_base_modem_at_command_raw (MMBaseModem *self,
                               GAsyncReadyCallback callback,
                               gpointer user_data)
 {
-    _at_command (self, command, timeout, allow_cached, TRUE, callback, user_data);
+    _at_command (self, command, timeout, allow_cached, TRUE,
+                 MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
+                 callback, user_data);
 }
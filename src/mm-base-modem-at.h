@@ -138,6 +138,15 @@ void mm_base_modem_at_command                (MMBaseModem *self,
                                               gboolean allow_cached,
                                               GAsyncReadyCallback callback,
                                               gpointer user_data);
+/* Like mm_base_modem_at_command() but queued in the given priority lane.
+ * Background commands are run in the secondary AT port if there is one. */
+void mm_base_modem_at_command_priority       (MMBaseModem *self,
+                                              const gchar *command,
+                                              guint timeout,
+                                              gboolean allow_cached,
+                                              MMPortSerialCommandPriority priority,
+                                              GAsyncReadyCallback callback,
+                                              gpointer user_data);
 /* Like mm_base_modem_at_command() except does not prefix with AT */
 void mm_base_modem_at_command_raw            (MMBaseModem *self,
                                               const gchar *command,
@@ -130,6 +130,7 @@ serial_port_timed_out_cb (MMPortSerial *port,
                  mm_port_type_get_string (mm_port_get_port_type (MM_PORT (port))),
                  n_consecutive_timeouts,
                  g_dbus_object_get_object_path (G_DBUS_OBJECT (self)));
+        mm_log_trace_dump (self->priv->device);
         g_cancellable_cancel (self->priv->cancellable);
         return;
     }
@@ -142,6 +143,37 @@ serial_port_timed_out_cb (MMPortSerial *port,
                  n_consecutive_timeouts);
 }
 
+static void
+invalidate_cached_replies (MMBaseModem *self,
+                           MMPortSerialCacheInvalidation what,
+                           MMPortSerial *skip)
+{
+    GHashTableIter iter;
+    gpointer value;
+    gpointer key;
+
+    /* Ports may still be around after the modem is disposed */
+    if (!self->priv->ports)
+        return;
+
+    g_hash_table_iter_init (&iter, self->priv->ports);
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+        if (MM_IS_PORT_SERIAL (value) && value != (gpointer) skip)
+            mm_port_serial_invalidate_cached_replies (MM_PORT_SERIAL (value), what);
+    }
+}
+
+static void
+serial_port_cache_invalidated_cb (MMPortSerial *port,
+                                  MMPortSerialCacheInvalidation what,
+                                  MMBaseModem *self)
+{
+    /* A state change requested through one port (e.g. +CFUN=) affects the
+     * replies cached in all the ports of the modem; the emitting port already
+     * dropped its own */
+    invalidate_cached_replies (self, what, port);
+}
+
 gboolean
 mm_base_modem_grab_port (MMBaseModem         *self,
                          MMKernelDevice      *kernel_device,
@@ -338,6 +370,15 @@ mm_base_modem_grab_port (MMBaseModem         *self,
             mm_port_type_get_string (ptype),
             mm_base_modem_get_device (self));
 
+    /* Any serial port, including non-tty AT ports, may change the state the
+     * replies cached in the others depend on */
+    if (MM_IS_PORT_SERIAL (port))
+        g_signal_connect_object (port,
+                                 "cache-invalidated",
+                                 G_CALLBACK (serial_port_cache_invalidated_cb),
+                                 self,
+                                 0);
+
     /* Add it to the tracking HT.
      * Note: 'key' and 'port' now owned by the HT. */
     g_hash_table_insert (self->priv->ports, key, port);
@@ -884,6 +925,118 @@ mm_base_modem_peek_best_at_port (MMBaseModem *self,
     return NULL;
 }
 
+void
+mm_base_modem_invalidate_cached_replies (MMBaseModem *self,
+                                         MMPortSerialCacheInvalidation what)
+{
+    /* The state change affects the replies cached in all serial ports */
+    invalidate_cached_replies (self, what, NULL);
+}
+
+static GVariant *
+histogram_build_variant (const MMHistogram *histogram)
+{
+    GVariantBuilder builder;
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{st}"));
+    g_variant_builder_add (&builder, "{st}", "count", histogram->count);
+    g_variant_builder_add (&builder, "{st}", "min",   histogram->min);
+    g_variant_builder_add (&builder, "{st}", "mean",  mm_histogram_get_mean (histogram));
+    g_variant_builder_add (&builder, "{st}", "p50",   mm_histogram_get_percentile (histogram, 50.0));
+    g_variant_builder_add (&builder, "{st}", "p90",   mm_histogram_get_percentile (histogram, 90.0));
+    g_variant_builder_add (&builder, "{st}", "p99",   mm_histogram_get_percentile (histogram, 99.0));
+    g_variant_builder_add (&builder, "{st}", "max",   histogram->max);
+    return g_variant_builder_end (&builder);
+}
+
+static void
+command_stats_build_variant (const gchar *key,
+                             const MMPortSerialCommandStats *stats,
+                             GVariantBuilder *builder)
+{
+    g_variant_builder_open (builder, G_VARIANT_TYPE ("a{sv}"));
+    g_variant_builder_add (builder, "{sv}", "command",    g_variant_new_string (key));
+    g_variant_builder_add (builder, "{sv}", "count",      g_variant_new_uint64 (stats->n_commands));
+    g_variant_builder_add (builder, "{sv}", "timeouts",   g_variant_new_uint64 (stats->n_timeouts));
+    g_variant_builder_add (builder, "{sv}", "errors",     g_variant_new_uint64 (stats->n_errors));
+    g_variant_builder_add (builder, "{sv}", "cache-hits", g_variant_new_uint64 (stats->n_cache_hits));
+    g_variant_builder_add (builder, "{sv}", "queue-wait", histogram_build_variant (&stats->queue_wait));
+    g_variant_builder_add (builder, "{sv}", "send",       histogram_build_variant (&stats->send));
+    g_variant_builder_add (builder, "{sv}", "first-byte", histogram_build_variant (&stats->first_byte));
+    g_variant_builder_add (builder, "{sv}", "parse",      histogram_build_variant (&stats->parse));
+    g_variant_builder_close (builder);
+}
+
+static const gchar *lane_names[MM_PORT_SERIAL_COMMAND_PRIORITY_LAST] = {
+    [MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE] = "interactive",
+    [MM_PORT_SERIAL_COMMAND_PRIORITY_POLL]        = "poll",
+    [MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND]  = "background",
+};
+
+static GVariant *
+lane_stats_build_variant (MMPortSerial *port)
+{
+    GVariantBuilder builder;
+    guint i;
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+    for (i = 0; i < MM_PORT_SERIAL_COMMAND_PRIORITY_LAST; i++) {
+        MMPortSerialLaneStats stats;
+
+        mm_port_serial_get_lane_stats (port, (MMPortSerialCommandPriority) i, &stats);
+        g_variant_builder_open (&builder, G_VARIANT_TYPE ("a{sv}"));
+        g_variant_builder_add (&builder, "{sv}", "lane",       g_variant_new_string (lane_names[i]));
+        g_variant_builder_add (&builder, "{sv}", "depth",      g_variant_new_uint32 (stats.depth));
+        g_variant_builder_add (&builder, "{sv}", "dispatched", g_variant_new_uint64 (stats.n_dispatched));
+        g_variant_builder_add (&builder, "{sv}", "total-wait", g_variant_new_uint64 (stats.total_wait_us));
+        g_variant_builder_add (&builder, "{sv}", "max-wait",   g_variant_new_uint64 (stats.max_wait_us));
+        g_variant_builder_close (&builder);
+    }
+    return g_variant_builder_end (&builder);
+}
+
+GVariant *
+mm_base_modem_get_port_stats (MMBaseModem *self)
+{
+    GVariantBuilder builder;
+    GHashTableIter iter;
+    gpointer value;
+    gpointer key;
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+
+    /* One dictionary per serial port, each with the per-command stats */
+    g_hash_table_iter_init (&iter, self->priv->ports);
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+        MMPortSerial *port;
+        GVariantBuilder commands;
+        guint hits = 0;
+        guint misses = 0;
+
+        if (!MM_IS_PORT_SERIAL (value))
+            continue;
+
+        port = MM_PORT_SERIAL (value);
+        mm_port_serial_get_cache_stats (port, &hits, &misses);
+
+        g_variant_builder_init (&commands, G_VARIANT_TYPE ("aa{sv}"));
+        mm_port_serial_foreach_command_stats (port,
+                                              (MMPortSerialCommandStatsFunc)command_stats_build_variant,
+                                              &commands);
+
+        g_variant_builder_open (&builder, G_VARIANT_TYPE ("a{sv}"));
+        g_variant_builder_add (&builder, "{sv}", "port",                 g_variant_new_string (mm_port_get_device (MM_PORT (port))));
+        g_variant_builder_add (&builder, "{sv}", "consecutive-timeouts", g_variant_new_uint32 (mm_port_serial_get_n_consecutive_timeouts (port)));
+        g_variant_builder_add (&builder, "{sv}", "cache-hits",           g_variant_new_uint32 (hits));
+        g_variant_builder_add (&builder, "{sv}", "cache-misses",         g_variant_new_uint32 (misses));
+        g_variant_builder_add (&builder, "{sv}", "commands",             g_variant_builder_end (&commands));
+        g_variant_builder_add (&builder, "{sv}", "lanes",                lane_stats_build_variant (port));
+        g_variant_builder_close (&builder);
+    }
+
+    return g_variant_builder_end (&builder);
+}
+
 gboolean
 mm_base_modem_has_at_port (MMBaseModem *self)
 {
@@ -113,6 +113,11 @@ gboolean  mm_base_modem_grab_port    (MMBaseModem         *self,
 
 gboolean  mm_base_modem_has_at_port  (MMBaseModem *self);
 
+void      mm_base_modem_invalidate_cached_replies (MMBaseModem *self,
+                                                   MMPortSerialCacheInvalidation what);
+
+GVariant *mm_base_modem_get_port_stats            (MMBaseModem *self);
+
 gboolean  mm_base_modem_organize_ports (MMBaseModem *self,
                                         GError **error);
 
@@ -1044,7 +1044,7 @@ load_sim_identifier (MMBaseSim *self,
         MM_BASE_MODEM (self->priv->modem),
         "+CRSM=176,12258,0,0,10",
         20,
-        FALSE,
+        TRUE, /* allow caching, it only changes with the SIM */
         (GAsyncReadyCallback)load_sim_identifier_command_ready,
         g_task_new (self, NULL, callback, user_data));
 }
@@ -1111,7 +1111,7 @@ load_imsi (MMBaseSim *self,
         MM_BASE_MODEM (self->priv->modem),
         "+CIMI",
         3,
-        FALSE,
+        TRUE, /* allow caching, it only changes with the SIM */
         (GAsyncReadyCallback)load_imsi_command_ready,
         g_task_new (self, NULL, callback, user_data));
 }
@@ -1230,7 +1230,7 @@ load_operator_identifier (MMBaseSim *self,
         MM_BASE_MODEM (self->priv->modem),
         "+CRSM=176,28589,0,0,4",
         10,
-        FALSE,
+        TRUE, /* allow caching, it only changes with the SIM */
         (GAsyncReadyCallback)load_operator_identifier_command_ready,
         g_task_new (self, NULL, callback, user_data));
 }
@@ -1325,7 +1325,7 @@ load_operator_name (MMBaseSim *self,
         MM_BASE_MODEM (self->priv->modem),
         "+CRSM=176,28486,0,0,17",
         10,
-        FALSE,
+        TRUE, /* allow caching, it only changes with the SIM */
         (GAsyncReadyCallback)load_operator_name_command_ready,
         g_task_new (self, NULL, callback, user_data));
 }
@@ -491,53 +491,7 @@ handle_store (MMBaseSms *self,
 }
 
 /*****************************************************************************/
-/* Send SMS (DBus call handling) */
-
-typedef struct {
-    MMBaseSms *self;
-    MMBaseModem *modem;
-    GDBusMethodInvocation *invocation;
-} HandleSendContext;
-
-static void
-handle_send_context_free (HandleSendContext *ctx)
-{
-    g_object_unref (ctx->invocation);
-    g_object_unref (ctx->modem);
-    g_object_unref (ctx->self);
-    g_free (ctx);
-}
-
-static void
-handle_send_ready (MMBaseSms *self,
-                   GAsyncResult *res,
-                   HandleSendContext *ctx)
-{
-    GError *error = NULL;
-
-    if (!MM_BASE_SMS_GET_CLASS (self)->send_finish (self, res, &error)) {
-        /* On error, clear up the parts we generated */
-        g_list_free_full (self->priv->parts, (GDestroyNotify)mm_sms_part_free);
-        self->priv->parts = NULL;
-        g_dbus_method_invocation_take_error (ctx->invocation, error);
-    } else {
-        /* Transition from Unknown->Sent or Stored->Sent */
-        if (mm_gdbus_sms_get_state (MM_GDBUS_SMS (ctx->self)) == MM_SMS_STATE_UNKNOWN ||
-            mm_gdbus_sms_get_state (MM_GDBUS_SMS (ctx->self)) == MM_SMS_STATE_STORED) {
-            GList *l;
-
-            /* Update state */
-            mm_gdbus_sms_set_state (MM_GDBUS_SMS (ctx->self), MM_SMS_STATE_SENT);
-            /* Grab last message reference */
-            l = g_list_last (mm_base_sms_get_parts (ctx->self));
-            mm_gdbus_sms_set_message_reference (MM_GDBUS_SMS (ctx->self),
-                                                mm_sms_part_get_message_reference ((MMSmsPart *)l->data));
-        }
-        mm_gdbus_sms_complete_send (MM_GDBUS_SMS (ctx->self), ctx->invocation);
-    }
-
-    handle_send_context_free (ctx);
-}
+/* Send SMS */
 
 static gboolean
 prepare_sms_to_be_sent (MMBaseSms *self,
@@ -567,63 +521,152 @@ prepare_sms_to_be_sent (MMBaseSms *self,
     return TRUE;
 }
 
+gboolean
+mm_base_sms_send_finish (MMBaseSms *self,
+                         GAsyncResult *res,
+                         GError **error)
+{
+    return g_task_propagate_boolean (G_TASK (res), error);
+}
+
 static void
-handle_send_auth_ready (MMBaseModem *modem,
-                        GAsyncResult *res,
-                        HandleSendContext *ctx)
+send_ready (MMBaseSms *self,
+            GAsyncResult *res,
+            GTask *task)
 {
-    MMSmsState state;
     GError *error = NULL;
 
-    if (!mm_base_modem_authorize_finish (modem, res, &error)) {
-        g_dbus_method_invocation_take_error (ctx->invocation, error);
-        handle_send_context_free (ctx);
+    if (!MM_BASE_SMS_GET_CLASS (self)->send_finish (self, res, &error)) {
+        /* On error, clear up the parts we generated */
+        g_list_free_full (self->priv->parts, (GDestroyNotify)mm_sms_part_free);
+        self->priv->parts = NULL;
+        g_task_return_error (task, error);
+        g_object_unref (task);
         return;
     }
 
+    /* Transition from Unknown->Sent or Stored->Sent */
+    if (mm_gdbus_sms_get_state (MM_GDBUS_SMS (self)) == MM_SMS_STATE_UNKNOWN ||
+        mm_gdbus_sms_get_state (MM_GDBUS_SMS (self)) == MM_SMS_STATE_STORED) {
+        GList *l;
+
+        /* Update state */
+        mm_gdbus_sms_set_state (MM_GDBUS_SMS (self), MM_SMS_STATE_SENT);
+        /* Grab last message reference */
+        l = g_list_last (mm_base_sms_get_parts (self));
+        mm_gdbus_sms_set_message_reference (MM_GDBUS_SMS (self),
+                                            mm_sms_part_get_message_reference ((MMSmsPart *)l->data));
+    }
+
+    g_task_return_boolean (task, TRUE);
+    g_object_unref (task);
+}
+
+void
+mm_base_sms_send (MMBaseSms *self,
+                  GAsyncReadyCallback callback,
+                  gpointer user_data)
+{
+    MMSmsState state;
+    GError *error = NULL;
+    GTask *task;
+
+    task = g_task_new (self, NULL, callback, user_data);
+
     /* We can only send SMS created by the user */
-    state = mm_gdbus_sms_get_state (MM_GDBUS_SMS (ctx->self));
+    state = mm_gdbus_sms_get_state (MM_GDBUS_SMS (self));
     if (state == MM_SMS_STATE_RECEIVED ||
         state == MM_SMS_STATE_RECEIVING) {
-        g_dbus_method_invocation_return_error (ctx->invocation,
-                                               MM_CORE_ERROR,
-                                               MM_CORE_ERROR_FAILED,
-                                               "This SMS was received, cannot send it");
-        handle_send_context_free (ctx);
+        g_task_return_new_error (task,
+                                 MM_CORE_ERROR,
+                                 MM_CORE_ERROR_FAILED,
+                                 "This SMS was received, cannot send it");
+        g_object_unref (task);
         return;
     }
 
     /* Don't allow sending the same SMS multiple times, we would lose the message reference */
     if (state == MM_SMS_STATE_SENT) {
-        g_dbus_method_invocation_return_error (ctx->invocation,
-                                               MM_CORE_ERROR,
-                                               MM_CORE_ERROR_FAILED,
-                                               "This SMS was already sent, cannot send it again");
-        handle_send_context_free (ctx);
+        g_task_return_new_error (task,
+                                 MM_CORE_ERROR,
+                                 MM_CORE_ERROR_FAILED,
+                                 "This SMS was already sent, cannot send it again");
+        g_object_unref (task);
         return;
     }
 
     /* Prepare the SMS to be sent, creating the PDU list if required */
-    if (!prepare_sms_to_be_sent (ctx->self, &error)) {
-        g_dbus_method_invocation_take_error (ctx->invocation, error);
-        handle_send_context_free (ctx);
+    if (!prepare_sms_to_be_sent (self, &error)) {
+        g_task_return_error (task, error);
+        g_object_unref (task);
         return;
     }
 
     /* Check if we do support doing it */
-    if (!MM_BASE_SMS_GET_CLASS (ctx->self)->send ||
-        !MM_BASE_SMS_GET_CLASS (ctx->self)->send_finish) {
-        g_dbus_method_invocation_return_error (ctx->invocation,
-                                               MM_CORE_ERROR,
-                                               MM_CORE_ERROR_UNSUPPORTED,
-                                               "Sending SMS is not supported by this modem");
+    if (!MM_BASE_SMS_GET_CLASS (self)->send ||
+        !MM_BASE_SMS_GET_CLASS (self)->send_finish) {
+        g_task_return_new_error (task,
+                                 MM_CORE_ERROR,
+                                 MM_CORE_ERROR_UNSUPPORTED,
+                                 "Sending SMS is not supported by this modem");
+        g_object_unref (task);
+        return;
+    }
+
+    MM_BASE_SMS_GET_CLASS (self)->send (self,
+                                        (GAsyncReadyCallback)send_ready,
+                                        task);
+}
+
+/*****************************************************************************/
+/* Send SMS (DBus call handling) */
+
+typedef struct {
+    MMBaseSms *self;
+    MMBaseModem *modem;
+    GDBusMethodInvocation *invocation;
+} HandleSendContext;
+
+static void
+handle_send_context_free (HandleSendContext *ctx)
+{
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->modem);
+    g_object_unref (ctx->self);
+    g_free (ctx);
+}
+
+static void
+handle_send_ready (MMBaseSms *self,
+                   GAsyncResult *res,
+                   HandleSendContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!mm_base_sms_send_finish (self, res, &error))
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+    else
+        mm_gdbus_sms_complete_send (MM_GDBUS_SMS (ctx->self), ctx->invocation);
+
+    handle_send_context_free (ctx);
+}
+
+static void
+handle_send_auth_ready (MMBaseModem *modem,
+                        GAsyncResult *res,
+                        HandleSendContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!mm_base_modem_authorize_finish (modem, res, &error)) {
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
         handle_send_context_free (ctx);
         return;
     }
 
-    MM_BASE_SMS_GET_CLASS (ctx->self)->send (ctx->self,
-                                             (GAsyncReadyCallback)handle_send_ready,
-                                             ctx);
+    mm_base_sms_send (ctx->self,
+                      (GAsyncReadyCallback)handle_send_ready,
+                      ctx);
 }
 
 static gboolean
@@ -1248,6 +1291,16 @@ sms_send_next_part (GTask *task)
     g_free (cmd);
 }
 
+static void
+sms_send_hold_link (MMBaseSms *self)
+{
+    /* Keep the relay link open between the parts of a multipart message, so
+     * that the network doesn't need to set it up again for each one. The
+     * command is just queued before the first part, no need to wait for it. */
+    if (g_list_length (self->priv->parts) > 1 && MM_IS_BROADBAND_MODEM (self->priv->modem))
+        mm_broadband_modem_hold_sms_link (MM_BROADBAND_MODEM (self->priv->modem), FALSE);
+}
+
 static void
 send_lock_sms_storages_ready (MMBroadbandModem *modem,
                               GAsyncResult *res,
@@ -1272,6 +1325,7 @@ send_lock_sms_storages_ready (MMBroadbandModem *modem,
 
     /* Go on to send the parts */
     ctx->current = self->priv->parts;
+    sms_send_hold_link (self);
     sms_send_next_part (task);
 }
 
@@ -1309,6 +1363,7 @@ sms_send (MMBaseSms *self,
                   MM_IFACE_MODEM_MESSAGING_SMS_PDU_MODE, &ctx->use_pdu_mode,
                   NULL);
     ctx->current = self->priv->parts;
+    sms_send_hold_link (self);
     sms_send_next_part (task);
 }
 
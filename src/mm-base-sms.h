@@ -116,6 +116,13 @@ guint        mm_base_sms_get_multipart_reference (MMBaseSms *self);
 gboolean     mm_base_sms_multipart_is_complete   (MMBaseSms *self);
 gboolean     mm_base_sms_multipart_is_assembled  (MMBaseSms *self);
 
+void     mm_base_sms_send        (MMBaseSms *self,
+                                  GAsyncReadyCallback callback,
+                                  gpointer user_data);
+gboolean mm_base_sms_send_finish (MMBaseSms *self,
+                                  GAsyncResult *res,
+                                  GError **error);
+
 void     mm_base_sms_delete        (MMBaseSms *self,
                                     GAsyncReadyCallback callback,
                                     gpointer user_data);
@@ -43,11 +43,13 @@
 #include "mm-iface-modem-oma.h"
 #include "mm-broadband-bearer.h"
 #include "mm-bearer-list.h"
+#include "mm-sms-link.h"
 #include "mm-sms-list.h"
 #include "mm-sms-part-3gpp.h"
 #include "mm-call-list.h"
 #include "mm-base-sim.h"
 #include "mm-log.h"
+#include "mm-regex.h"
 #include "mm-modem-helpers.h"
 #include "mm-error-helpers.h"
 #include "mm-port-serial-qcdm.h"
@@ -220,6 +222,10 @@ struct _MMBroadbandModemPrivate {
     MMSmsStorage current_sms_mem1_storage;
     gboolean mem2_storage_locked;
     MMSmsStorage current_sms_mem2_storage;
+    /* Whether the current storages are known to be the ones in the modem */
+    gboolean sms_storages_synced;
+    /* Users holding the relay link (+CMMS) */
+    MMSmsLink sms_link;
 
     /*<--- Modem Voice interface --->*/
     /* Properties */
@@ -3472,6 +3478,8 @@ current_charset_query_ready (MMBroadbandModem *self,
             /* We'll keep track ourselves of the current charset.
              * TODO: Make this a property so that plugins can also store it. */
             self->priv->modem_current_charset = current;
+            mm_base_modem_invalidate_cached_replies (MM_BASE_MODEM (self),
+                                                     MM_PORT_SERIAL_CACHE_INVALIDATION_CHARSET);
             g_task_return_boolean (task, TRUE);
         }
     }
@@ -4530,12 +4538,14 @@ modem_3gpp_scan_networks (MMIfaceModem3gpp *self,
                           GAsyncReadyCallback callback,
                           gpointer user_data)
 {
-    mm_base_modem_at_command (MM_BASE_MODEM (self),
-                              "+COPS=?",
-                              300,
-                              FALSE,
-                              callback,
-                              user_data);
+    /* Network scans take minutes, run them in the background lane */
+    mm_base_modem_at_command_priority (MM_BASE_MODEM (self),
+                                       "+COPS=?",
+                                       300,
+                                       FALSE,
+                                       MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND,
+                                       callback,
+                                       user_data);
 }
 
 /*****************************************************************************/
@@ -4789,12 +4799,13 @@ run_registration_checks_context_step (GTask *task)
         ctx->running_cs = TRUE;
         ctx->run_cs = FALSE;
         /* Check current CS-registration state. */
-        mm_base_modem_at_command (MM_BASE_MODEM (self),
-                                  "+CREG?",
-                                  10,
-                                  FALSE,
-                                  (GAsyncReadyCallback)registration_status_check_ready,
-                                  task);
+        mm_base_modem_at_command_priority (MM_BASE_MODEM (self),
+                                           "+CREG?",
+                                           10,
+                                           FALSE,
+                                           MM_PORT_SERIAL_COMMAND_PRIORITY_POLL,
+                                           (GAsyncReadyCallback)registration_status_check_ready,
+                                           task);
         return;
     }
 
@@ -4802,12 +4813,13 @@ run_registration_checks_context_step (GTask *task)
         ctx->running_ps = TRUE;
         ctx->run_ps = FALSE;
         /* Check current PS-registration state. */
-        mm_base_modem_at_command (MM_BASE_MODEM (self),
-                                  "+CGREG?",
-                                  10,
-                                  FALSE,
-                                  (GAsyncReadyCallback)registration_status_check_ready,
-                                  task);
+        mm_base_modem_at_command_priority (MM_BASE_MODEM (self),
+                                           "+CGREG?",
+                                           10,
+                                           FALSE,
+                                           MM_PORT_SERIAL_COMMAND_PRIORITY_POLL,
+                                           (GAsyncReadyCallback)registration_status_check_ready,
+                                           task);
         return;
     }
 
@@ -4815,12 +4827,13 @@ run_registration_checks_context_step (GTask *task)
         ctx->running_eps = TRUE;
         ctx->run_eps = FALSE;
         /* Check current EPS-registration state. */
-        mm_base_modem_at_command (MM_BASE_MODEM (self),
-                                  "+CEREG?",
-                                  10,
-                                  FALSE,
-                                  (GAsyncReadyCallback)registration_status_check_ready,
-                                  task);
+        mm_base_modem_at_command_priority (MM_BASE_MODEM (self),
+                                           "+CEREG?",
+                                           10,
+                                           FALSE,
+                                           MM_PORT_SERIAL_COMMAND_PRIORITY_POLL,
+                                           (GAsyncReadyCallback)registration_status_check_ready,
+                                           task);
         return;
     }
 
@@ -6111,6 +6124,7 @@ cpms_query_ready (MMBroadbandModem *self,
 
         self->priv->current_sms_mem1_storage = mem1;
         self->priv->current_sms_mem2_storage = mem2;
+        self->priv->sms_storages_synced = TRUE;
 
         mm_dbg ("Current storages initialized:");
 
@@ -6220,10 +6234,13 @@ lock_storages_cpms_set_ready (MMBaseModem *_self,
             self->priv->current_sms_mem2_storage = ctx->previous_mem2;
             self->priv->mem2_storage_locked = FALSE;
         }
+        /* We don't know what the modem ended up with */
+        self->priv->sms_storages_synced = FALSE;
         g_task_return_error (task, error);
-    }
-    else
+    } else {
+        self->priv->sms_storages_synced = TRUE;
         g_task_return_boolean (task, TRUE);
+    }
 
     g_object_unref (task);
 }
@@ -6260,6 +6277,22 @@ mm_broadband_modem_lock_sms_storages (MMBroadbandModem *self,
     g_assert (mem1 != MM_SMS_STORAGE_UNKNOWN ||
               mem2 != MM_SMS_STORAGE_UNKNOWN);
 
+    /* If the modem already uses the requested storages, e.g. when sending
+     * several stored messages in a row, there's no need to set them again */
+    if (self->priv->sms_storages_synced &&
+        (mem1 == MM_SMS_STORAGE_UNKNOWN || mem1 == self->priv->current_sms_mem1_storage) &&
+        (mem2 == MM_SMS_STORAGE_UNKNOWN || mem2 == self->priv->current_sms_mem2_storage) &&
+        self->priv->current_sms_mem1_storage != MM_SMS_STORAGE_UNKNOWN) {
+        if (mem1 != MM_SMS_STORAGE_UNKNOWN)
+            self->priv->mem1_storage_locked = TRUE;
+        if (mem2 != MM_SMS_STORAGE_UNKNOWN)
+            self->priv->mem2_storage_locked = TRUE;
+        task = g_task_new (self, NULL, callback, user_data);
+        g_task_return_boolean (task, TRUE);
+        g_object_unref (task);
+        return;
+    }
+
     ctx = g_new0 (LockSmsStoragesContext, 1);
 
     task = g_task_new (self, NULL, callback, user_data);
@@ -6323,6 +6356,72 @@ mm_broadband_modem_lock_sms_storages (MMBroadbandModem *self,
     g_free (cmd);
 }
 
+/*****************************************************************************/
+/* Holding the SMS relay link (+CMMS) */
+
+static void
+cmms_set_ready (MMBaseModem *_self,
+                GAsyncResult *res,
+                gpointer user_data)
+{
+    MMBroadbandModem *self = MM_BROADBAND_MODEM (_self);
+    GError *error = NULL;
+
+    if (mm_base_modem_at_command_finish (_self, res, &error))
+        return;
+
+    /* Not fatal, messages are sent anyway; just don't try again */
+    if (!g_error_matches (error, MM_SERIAL_ERROR, MM_SERIAL_ERROR_RESPONSE_TIMEOUT)) {
+        mm_dbg ("Couldn't hold SMS relay link, not trying again: '%s'", error->message);
+        self->priv->sms_link.unsupported = TRUE;
+    }
+    g_error_free (error);
+}
+
+static void
+cmms_set (MMBroadbandModem *self,
+          MMSmsLinkMode mode)
+{
+    gchar *cmd;
+
+    if (mode == MM_SMS_LINK_MODE_NONE)
+        return;
+
+    /* The command is only queued, so that the messages sent right after it
+     * don't need to wait for the reply */
+    cmd = g_strdup_printf ("+CMMS=%d", (gint) mode);
+    mm_base_modem_at_command (MM_BASE_MODEM (self),
+                              cmd,
+                              3,
+                              FALSE,
+                              (GAsyncReadyCallback)cmms_set_ready,
+                              NULL);
+    g_free (cmd);
+}
+
+void
+mm_broadband_modem_hold_sms_link (MMBroadbandModem *self,
+                                  gboolean until_released)
+{
+    cmms_set (self, mm_sms_link_hold (&self->priv->sms_link, until_released));
+}
+
+void
+mm_broadband_modem_release_sms_link (MMBroadbandModem *self)
+{
+    cmms_set (self, mm_sms_link_release (&self->priv->sms_link));
+}
+
+static void
+modem_messaging_set_sms_link_hold (MMIfaceModemMessaging *self,
+                                   gboolean hold)
+{
+    if (hold)
+        mm_broadband_modem_hold_sms_link (MM_BROADBAND_MODEM (self), TRUE);
+    else
+        mm_broadband_modem_release_sms_link (MM_BROADBAND_MODEM (self));
+}
+
 /*****************************************************************************/
 /* Set default SMS storage (Messaging interface) */
 
@@ -6342,10 +6441,13 @@ cpms_set_ready (MMBroadbandModem *self,
     GError *error = NULL;
 
     mm_base_modem_at_command_finish (MM_BASE_MODEM (self), res, &error);
-    if (error)
+    if (error) {
+        self->priv->sms_storages_synced = FALSE;
         g_task_return_error (task, error);
-    else
+    } else {
+        self->priv->sms_storages_synced = TRUE;
         g_task_return_boolean (task, TRUE);
+    }
     g_object_unref (task);
 }
 
@@ -6896,8 +6998,25 @@ modem_messaging_enable_unsolicited_events (MMIfaceModemMessaging *self,
 
 typedef struct {
     MMSmsStorage list_storage;
+    /* PDU mode only: entries are processed as they arrive on the port */
+    MMPortSerialAt *port;
+    GRegex *cmgl_regex;
+    guint n_streamed;
 } ListPartsContext;
 
+static void
+list_parts_context_free (ListPartsContext *ctx)
+{
+    if (ctx->port) {
+        if (ctx->cmgl_regex)
+            mm_port_serial_at_remove_unsolicited_msg_handler (ctx->port, ctx->cmgl_regex);
+        g_object_unref (ctx->port);
+    }
+    if (ctx->cmgl_regex)
+        g_regex_unref (ctx->cmgl_regex);
+    g_slice_free (ListPartsContext, ctx);
+}
+
 static gboolean
 modem_messaging_load_initial_sms_parts_finish (MMIfaceModemMessaging *self,
                                                GAsyncResult *res,
@@ -6955,8 +7074,8 @@ sms_text_part_list_ready (MMBroadbandModem *self,
     }
 
     /* +CMGL: <index>,<stat>,<oa/da>,[alpha],<scts><CR><LF><data><CR><LF> */
-    r = g_regex_new ("\\+CMGL:\\s*(\\d+)\\s*,\\s*([^,]*),\\s*([^,]*),\\s*([^,]*),\\s*([^\\r\\n]*)\\r\\n([^\\r\\n]*)",
-                     0, 0, NULL);
+    r = mm_regex_get ("\\+CMGL:\\s*(\\d+)\\s*,\\s*([^,]*),\\s*([^,]*),\\s*([^,]*),\\s*([^\\r\\n]*)\\r\\n([^\\r\\n]*)",
+                      0, 0, NULL);
     g_assert (r);
 
     if (!g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, NULL)) {
@@ -7067,6 +7186,60 @@ sms_state_from_index (guint index)
     }
 }
 
+static void
+sms_pdu_part_list_process_entry (MMBroadbandModem *self,
+                                 ListPartsContext *ctx,
+                                 guint index,
+                                 guint status,
+                                 const gchar *pdu)
+{
+    MMSmsPart *part;
+    GError *error = NULL;
+
+    part = mm_sms_part_3gpp_new_from_pdu (index, pdu, &error);
+    if (!part) {
+        /* Don't treat the error as critical */
+        mm_dbg ("Error parsing PDU (%d): %s", index, error->message);
+        g_error_free (error);
+        return;
+    }
+
+    mm_dbg ("Correctly parsed PDU (%d)", index);
+    mm_iface_modem_messaging_take_part (MM_IFACE_MODEM_MESSAGING (self),
+                                        part,
+                                        sms_state_from_index (status),
+                                        ctx->list_storage);
+}
+
+/* Each +CMGL entry is processed as soon as its PDU line is complete, and
+ * removed from the port buffer, so that the response never needs to hold
+ * the whole list of messages. */
+static void
+sms_pdu_part_list_entry_received (MMPortSerialAt *port,
+                                  GMatchInfo *match_info,
+                                  GTask *task)
+{
+    MMBroadbandModem *self;
+    ListPartsContext *ctx;
+    guint index;
+    guint status;
+    gchar *pdu;
+
+    self = g_task_get_source_object (task);
+    ctx = g_task_get_task_data (task);
+
+    if (!mm_get_uint_from_match_info (match_info, 1, &index) ||
+        !mm_get_uint_from_match_info (match_info, 2, &status)) {
+        mm_dbg ("Failed to parse +CMGL entry");
+        return;
+    }
+
+    pdu = g_match_info_fetch (match_info, 3);
+    sms_pdu_part_list_process_entry (self, ctx, index, status, pdu);
+    ctx->n_streamed++;
+    g_free (pdu);
+}
+
 static void
 sms_pdu_part_list_ready (MMBroadbandModem *self,
                          GAsyncResult *res,
@@ -7077,44 +7250,82 @@ sms_pdu_part_list_ready (MMBroadbandModem *self,
     GError *error = NULL;
     GList *info_list;
     GList *l;
+    guint n_pdus;
+    guint *indices;
+    const gchar **pdus;
+    MMSmsPart **parts;
+    GError **errors;
+    guint i;
+
+    ctx = g_task_get_task_data (task);
+
+    /* Stop processing entries as they arrive */
+    if (ctx->port && ctx->cmgl_regex) {
+        mm_port_serial_at_remove_unsolicited_msg_handler (ctx->port, ctx->cmgl_regex);
+        g_clear_pointer (&ctx->cmgl_regex, g_regex_unref);
+    }
 
     /* Always always always unlock mem1 storage. Warned you've been. */
     mm_broadband_modem_unlock_sms_storages (self, TRUE, FALSE);
 
-    response = mm_base_modem_at_command_finish (MM_BASE_MODEM (self), res, &error);
+    response = mm_base_modem_at_command_full_finish (MM_BASE_MODEM (self), res, &error);
     if (error) {
         g_task_return_error (task, error);
         g_object_unref (task);
         return;
     }
 
+    /* Whatever was not processed while streaming (e.g. an entry split in a way
+     * the streaming parser didn't match) is still in the final response */
     info_list = mm_3gpp_parse_pdu_cmgl_response (response, &error);
     if (error) {
-        g_task_return_error (task, error);
-        g_object_unref (task);
-        return;
+        if (ctx->n_streamed == 0) {
+            g_task_return_error (task, error);
+            g_object_unref (task);
+            return;
+        }
+        g_clear_error (&error);
     }
 
-    ctx = g_task_get_task_data (task);
+    mm_dbg ("Processed %u SMS parts while listing, %u in the final response",
+            ctx->n_streamed, g_list_length (info_list));
 
-    for (l = info_list; l; l = g_list_next (l)) {
+    /* Decode all the remaining entries at once */
+    n_pdus = g_list_length (info_list);
+    indices = g_new (guint, n_pdus);
+    pdus = g_new (const gchar *, n_pdus);
+    parts = g_new (MMSmsPart *, n_pdus);
+    errors = g_new0 (GError *, n_pdus);
+    for (l = info_list, i = 0; l; l = g_list_next (l), i++) {
         MM3gppPduInfo *info = l->data;
-        MMSmsPart *part;
 
-        part = mm_sms_part_3gpp_new_from_pdu (info->index, info->pdu, &error);
-        if (part) {
-            mm_dbg ("Correctly parsed PDU (%d)", info->index);
-            mm_iface_modem_messaging_take_part (MM_IFACE_MODEM_MESSAGING (self),
-                                                part,
-                                                sms_state_from_index (info->status),
-                                                ctx->list_storage);
-        } else {
+        indices[i] = info->index;
+        pdus[i] = info->pdu;
+    }
+
+    mm_sms_part_3gpp_new_from_pdus (n_pdus, indices, pdus, parts, errors);
+
+    for (l = info_list, i = 0; l; l = g_list_next (l), i++) {
+        MM3gppPduInfo *info = l->data;
+
+        if (!parts[i]) {
             /* Don't treat the error as critical */
-            mm_dbg ("Error parsing PDU (%d): %s", info->index, error->message);
-            g_clear_error (&error);
+            mm_dbg ("Error parsing PDU (%d): %s", info->index, errors[i]->message);
+            g_error_free (errors[i]);
+            continue;
         }
+
+        mm_dbg ("Correctly parsed PDU (%d)", info->index);
+        mm_iface_modem_messaging_take_part (MM_IFACE_MODEM_MESSAGING (self),
+                                            parts[i],
+                                            sms_state_from_index (info->status),
+                                            ctx->list_storage);
     }
 
+    g_free (errors);
+    g_free (parts);
+    g_free (pdus);
+    g_free (indices);
     mm_3gpp_pdu_info_list_free (info_list);
 
     /* We consider all done */
@@ -7127,6 +7338,7 @@ list_parts_lock_storages_ready (MMBroadbandModem *self,
                                 GAsyncResult *res,
                                 GTask *task)
 {
+    ListPartsContext *ctx;
     GError *error = NULL;
 
     if (!mm_broadband_modem_lock_sms_storages_finish (self, res, &error)) {
@@ -7141,16 +7353,46 @@ list_parts_lock_storages_ready (MMBroadbandModem *self,
 
     /* Get SMS parts from ALL types.
      * Different command to be used if we are on Text or PDU mode */
-    mm_base_modem_at_command (MM_BASE_MODEM (self),
-                              (MM_BROADBAND_MODEM (self)->priv->modem_messaging_sms_pdu_mode ?
-                               "+CMGL=4" :
-                               "+CMGL=\"ALL\""),
-                              20,
-                              FALSE,
-                              (GAsyncReadyCallback) (MM_BROADBAND_MODEM (self)->priv->modem_messaging_sms_pdu_mode ?
-                                                     sms_pdu_part_list_ready :
-                                                     sms_text_part_list_ready),
-                              task);
+    if (!MM_BROADBAND_MODEM (self)->priv->modem_messaging_sms_pdu_mode) {
+        mm_base_modem_at_command (MM_BASE_MODEM (self),
+                                  "+CMGL=\"ALL\"",
+                                  20,
+                                  FALSE,
+                                  (GAsyncReadyCallback)sms_text_part_list_ready,
+                                  task);
+        return;
+    }
+
+    ctx = g_task_get_task_data (task);
+    ctx->port = mm_base_modem_get_best_at_port (MM_BASE_MODEM (self), &error);
+    if (!ctx->port) {
+        mm_broadband_modem_unlock_sms_storages (self, TRUE, FALSE);
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+
+    /* +CMGL: <index>,<stat>,[alpha],<length><CR><LF><pdu>
+     * The entry is only matched once the PDU line is complete; the line
+     * separator after it is left in place for the next entry */
+    ctx->cmgl_regex = mm_regex_get ("\\r\\n\\+CMGL:\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,[^\\r\\n]*\\r\\n([0-9A-Fa-f]+)(?=\\r\\n)",
+                                    G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    g_assert (ctx->cmgl_regex);
+    mm_port_serial_at_add_unsolicited_msg_handler (ctx->port,
+                                                   ctx->cmgl_regex,
+                                                   (MMPortSerialAtUnsolicitedMsgFn)sms_pdu_part_list_entry_received,
+                                                   task,
+                                                   NULL);
+
+    mm_base_modem_at_command_full (MM_BASE_MODEM (self),
+                                   ctx->port,
+                                   "+CMGL=4",
+                                   20,
+                                   FALSE,
+                                   FALSE,
+                                   NULL,
+                                   (GAsyncReadyCallback)sms_pdu_part_list_ready,
+                                   task);
 }
 
 static void
@@ -7162,11 +7404,11 @@ modem_messaging_load_initial_sms_parts (MMIfaceModemMessaging *self,
     ListPartsContext *ctx;
     GTask *task;
 
-    ctx = g_new (ListPartsContext, 1);
+    ctx = g_slice_new0 (ListPartsContext);
     ctx->list_storage = storage;
 
     task = g_task_new (self, NULL, callback, user_data);
-    g_task_set_task_data (task, ctx, g_free);
+    g_task_set_task_data (task, ctx, (GDestroyNotify)list_parts_context_free);
 
     mm_dbg ("Listing SMS parts in storage '%s'",
             mm_sms_storage_get_string (storage));
@@ -8030,7 +8272,7 @@ css_query_ready (MMIfaceModemCdma *self,
         GMatchInfo *match_info;
 
         /* Format is "<band_class>,<band>,<sid>" */
-        r = g_regex_new ("\\s*([^,]*?)\\s*,\\s*([^,]*?)\\s*,\\s*(\\d+)", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        r = mm_regex_get ("\\s*([^,]*?)\\s*,\\s*([^,]*?)\\s*,\\s*(\\d+)", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
         g_assert (r);
 
         g_regex_match (r, result, 0, &match_info);
@@ -11026,6 +11268,9 @@ after_hotswap_event_disable_ready (MMBaseModem *self,
 void
 mm_broadband_modem_update_sim_hot_swap_detected (MMBroadbandModem *self)
 {
+    mm_base_modem_invalidate_cached_replies (MM_BASE_MODEM (self),
+                                             MM_PORT_SERIAL_CACHE_INVALIDATION_SIM);
+
     if (self->priv->sim_hot_swap_ports_ctx) {
         mm_dbg ("Releasing SIM hot swap ports context");
         ports_context_unref (self->priv->sim_hot_swap_ports_ctx);
@@ -11619,6 +11864,7 @@ iface_modem_messaging_init (MMIfaceModemMessaging *iface)
     iface->load_supported_storages_finish = modem_messaging_load_supported_storages_finish;
     iface->set_default_storage = modem_messaging_set_default_storage;
     iface->set_default_storage_finish = modem_messaging_set_default_storage_finish;
+    iface->set_sms_link_hold = modem_messaging_set_sms_link_hold;
     iface->setup_sms_format = modem_messaging_setup_sms_format;
     iface->setup_sms_format_finish = modem_messaging_setup_sms_format_finish;
     iface->load_initial_sms_parts = modem_messaging_load_initial_sms_parts;
@@ -130,6 +130,13 @@ gboolean mm_broadband_modem_lock_sms_storages_finish (MMBroadbandModem *self,
 void     mm_broadband_modem_unlock_sms_storages      (MMBroadbandModem *self,
                                                       gboolean mem1,
                                                       gboolean mem2);
+
+/* Holding the SMS relay link open between messages (AT+CMMS). The link is
+ * either held until the next message is sent, or until released. */
+void     mm_broadband_modem_hold_sms_link            (MMBroadbandModem *self,
+                                                      gboolean until_released);
+void     mm_broadband_modem_release_sms_link         (MMBroadbandModem *self);
+
 /* Helper to update SIM hot swap */
 void mm_broadband_modem_update_sim_hot_swap_detected (MMBroadbandModem *self);
 
@@ -46,20 +46,38 @@ static CharsetEntry charset_map[] = {
     { NULL,      NULL,     NULL,        NULL,                  MM_MODEM_CHARSET_UNKNOWN }
 };
 
+/* Charsets are single bits, so the map can be indexed by bit number */
+static const CharsetEntry *
+charset_entry_get (MMModemCharset charset)
+{
+    static const CharsetEntry *entries[32];
+    static gsize initialized = 0;
+    gint bit;
+
+    if (g_once_init_enter (&initialized)) {
+        const CharsetEntry *iter;
+
+        for (iter = &charset_map[0]; iter->gsm_name; iter++)
+            entries[g_bit_nth_lsf (iter->charset, -1)] = iter;
+        g_once_init_leave (&initialized, 1);
+    }
+
+    bit = g_bit_nth_lsf (charset, -1);
+    if (bit < 0 || charset != (1 << bit))
+        return NULL;
+    return entries[bit];
+}
+
 const char *
 mm_modem_charset_to_string (MMModemCharset charset)
 {
-    CharsetEntry *iter = &charset_map[0];
+    const CharsetEntry *entry;
 
     g_return_val_if_fail (charset != MM_MODEM_CHARSET_UNKNOWN, NULL);
 
-    while (iter->gsm_name) {
-        if (iter->charset == charset)
-            return iter->gsm_name;
-        iter++;
-    }
-    g_warn_if_reached ();
-    return NULL;
+    entry = charset_entry_get (charset);
+    g_warn_if_fail (entry != NULL);
+    return entry ? entry->gsm_name : NULL;
 }
 
 MMModemCharset
@@ -82,35 +100,45 @@ mm_modem_charset_from_string (const char *string)
 static const char *
 charset_iconv_to (MMModemCharset charset)
 {
-    CharsetEntry *iter = &charset_map[0];
+    const CharsetEntry *entry;
 
     g_return_val_if_fail (charset != MM_MODEM_CHARSET_UNKNOWN, NULL);
 
-    while (iter->gsm_name) {
-        if (iter->charset == charset)
-            return iter->iconv_to_name;
-        iter++;
-    }
-    g_warn_if_reached ();
-    return NULL;
+    entry = charset_entry_get (charset);
+    g_warn_if_fail (entry != NULL);
+    return entry ? entry->iconv_to_name : NULL;
 }
 
 static const char *
 charset_iconv_from (MMModemCharset charset)
 {
-    CharsetEntry *iter = &charset_map[0];
+    const CharsetEntry *entry;
 
     g_return_val_if_fail (charset != MM_MODEM_CHARSET_UNKNOWN, NULL);
 
-    while (iter->gsm_name) {
-        if (iter->charset == charset)
-            return iter->iconv_from_name;
-        iter++;
-    }
-    g_warn_if_reached ();
-    return NULL;
+    entry = charset_entry_get (charset);
+    g_warn_if_fail (entry != NULL);
+    return entry ? entry->iconv_from_name : NULL;
 }
 
+/* Native converters, defined below */
+static gboolean  charset_is_native     (MMModemCharset  charset);
+static gchar    *charset_native_decode (MMModemCharset  charset,
+                                        const guint8   *data,
+                                        gsize           len,
+                                        gsize          *out_len);
+static gsize     charset_native_encode (MMModemCharset  charset,
+                                        const gchar    *utf8,
+                                        gsize           len,
+                                        gboolean        translit,
+                                        guint8         *out);
+static guint8   *charset_native_encode_dup (MMModemCharset  charset,
+                                            const gchar    *utf8,
+                                            gboolean        translit,
+                                            gsize          *out_len);
+
+#define ENCODE_ERROR G_MAXSIZE
+
 gboolean
 mm_modem_charset_byte_array_append (GByteArray *array,
                                     const char *utf8,
@@ -125,6 +153,29 @@ mm_modem_charset_byte_array_append (GByteArray *array,
     g_return_val_if_fail (array != NULL, FALSE);
     g_return_val_if_fail (utf8 != NULL, FALSE);
 
+    if (charset_is_native (charset)) {
+        gsize len;
+        gsize start;
+
+        /* Encode straight into the array, once we know how much we need */
+        len = strlen (utf8);
+        if (!g_utf8_validate (utf8, len, NULL) ||
+            (written = charset_native_encode (charset, utf8, len, TRUE, NULL)) == ENCODE_ERROR) {
+            mm_warn ("failed to convert '%s' to %s character set",
+                     utf8, mm_modem_charset_to_string (charset));
+            return FALSE;
+        }
+
+        start = array->len;
+        g_byte_array_set_size (array, start + written + (quoted ? 2 : 0));
+        if (quoted)
+            array->data[start++] = '"';
+        charset_native_encode (charset, utf8, len, TRUE, &array->data[start]);
+        if (quoted)
+            array->data[start + written] = '"';
+        return TRUE;
+    }
+
     iconv_to = charset_iconv_to (charset);
     g_return_val_if_fail (iconv_to != NULL, FALSE);
 
@@ -159,6 +210,9 @@ mm_modem_charset_byte_array_to_utf8 (GByteArray     *array,
     g_return_val_if_fail (array != NULL, NULL);
     g_return_val_if_fail (charset != MM_MODEM_CHARSET_UNKNOWN, NULL);
 
+    if (charset_is_native (charset))
+        return charset_native_decode (charset, array->data, array->len, NULL);
+
     iconv_from = charset_iconv_from (charset);
     g_return_val_if_fail (iconv_from != NULL, FALSE);
 
@@ -185,7 +239,7 @@ mm_modem_charset_hex_to_utf8 (const char *src, MMModemCharset charset)
     g_return_val_if_fail (charset != MM_MODEM_CHARSET_UNKNOWN, NULL);
 
     iconv_from = charset_iconv_from (charset);
-    g_return_val_if_fail (iconv_from != NULL, FALSE);
+    g_return_val_if_fail (iconv_from != NULL || charset_is_native (charset), FALSE);
 
     unconverted = mm_utils_hexstr2bin (src, &unconverted_len);
     if (!unconverted)
@@ -194,12 +248,16 @@ mm_modem_charset_hex_to_utf8 (const char *src, MMModemCharset charset)
     if (charset == MM_MODEM_CHARSET_UTF8 || charset == MM_MODEM_CHARSET_IRA)
         return unconverted;
 
-    converted = g_convert (unconverted, unconverted_len,
-                           "UTF-8//TRANSLIT", iconv_from,
-                           NULL, NULL, &error);
-    if (!converted || error) {
-        g_clear_error (&error);
-        converted = NULL;
+    if (charset_is_native (charset))
+        converted = charset_native_decode (charset, (const guint8 *) unconverted, unconverted_len, NULL);
+    else {
+        converted = g_convert (unconverted, unconverted_len,
+                               "UTF-8//TRANSLIT", iconv_from,
+                               NULL, NULL, &error);
+        if (!converted || error) {
+            g_clear_error (&error);
+            converted = NULL;
+        }
     }
 
     g_free (unconverted);
@@ -220,20 +278,27 @@ mm_modem_charset_utf8_to_hex (const char *src, MMModemCharset charset)
     g_return_val_if_fail (charset != MM_MODEM_CHARSET_UNKNOWN, NULL);
 
     iconv_to = charset_iconv_from (charset);
-    g_return_val_if_fail (iconv_to != NULL, FALSE);
+    g_return_val_if_fail (iconv_to != NULL || charset_is_native (charset), FALSE);
 
     if (charset == MM_MODEM_CHARSET_UTF8 || charset == MM_MODEM_CHARSET_IRA)
         return g_strdup (src);
 
-    converted = g_convert (src, strlen (src),
-                           iconv_to, "UTF-8//TRANSLIT",
-                           NULL, &converted_len, &error);
-    if (!converted || error) {
-        g_clear_error (&error);
-        g_free (converted);
-        return NULL;
+    if (charset_is_native (charset))
+        converted = (char *) charset_native_encode_dup (charset, src, FALSE, &converted_len);
+    else {
+        converted = g_convert (src, strlen (src),
+                               iconv_to, "UTF-8//TRANSLIT",
+                               NULL, &converted_len, &error);
+        if (!converted || error) {
+            g_clear_error (&error);
+            g_free (converted);
+            converted = NULL;
+        }
     }
 
+    if (!converted)
+        return NULL;
+
     /* Get hex representation of the string */
     hex = mm_utils_bin2hexstr ((guint8 *)converted, converted_len);
     g_free (converted);
@@ -329,33 +394,6 @@ static const GsmUtf8Mapping gsm_def_utf8_alphabet[GSM_DEF_ALPHABET_SIZE] = {
     TWO(0xc3, 0xb6), TWO(0xc3, 0xb1), TWO(0xc3, 0xbc), TWO(0xc3, 0xa0)
 };
 
-static guint8
-gsm_def_char_to_utf8 (const guint8 gsm, guint8 out_utf8[2])
-{
-    g_return_val_if_fail (gsm < GSM_DEF_ALPHABET_SIZE, 0);
-    memcpy (&out_utf8[0], &gsm_def_utf8_alphabet[gsm].chars[0], gsm_def_utf8_alphabet[gsm].len);
-    return gsm_def_utf8_alphabet[gsm].len;
-}
-
-static gboolean
-utf8_to_gsm_def_char (const char *utf8, guint32 len, guint8 *out_gsm)
-{
-    int i;
-
-    if (len > 0 && len < 4) {
-        for (i = 0; i < GSM_DEF_ALPHABET_SIZE; i++) {
-            if (gsm_def_utf8_alphabet[i].len == len) {
-                if (memcmp (&gsm_def_utf8_alphabet[i].chars[0], utf8, len) == 0) {
-                    *out_gsm = i;
-                    return TRUE;
-                }
-            }
-        }
-    }
-    return FALSE;
-}
-
-
 #define EONE(a, g)        { {a, 0x00, 0x00}, 1, g }
 #define ETHR(a, b, c, g)  { {a, b,    c},    3, g }
 
@@ -376,127 +414,490 @@ static const GsmUtf8Mapping gsm_ext_utf8_alphabet[GSM_EXT_ALPHABET_SIZE] = {
 
 #define GSM_ESCAPE_CHAR 0x1b
 
-static guint8
-gsm_ext_char_to_utf8 (const guint8 gsm, guint8 out_utf8[3])
+/* Reverse mapping from Unicode to GSM, built from the tables above. Entries
+ * are the GSM char, with GSM_EXT_FLAG if it needs the escape char before. */
+#define GSM_NONE      0xFFFF
+#define GSM_EXT_FLAG  0x0100
+#define GSM_HIGH_SIZE 16
+
+typedef struct {
+    /* Index in gsm_ext_utf8_alphabet of each extended char, or -1 */
+    gint8 ext_index[GSM_DEF_ALPHABET_SIZE];
+    /* Code points below 0x100 */
+    guint16 latin1[256];
+    /* The few code points above (greek letters and the euro sign) */
+    gunichar high_chars[GSM_HIGH_SIZE];
+    guint16 high_gsm[GSM_HIGH_SIZE];
+    guint n_high;
+} GsmTables;
+
+static void
+gsm_tables_add (GsmTables *tables,
+                const GsmUtf8Mapping *mapping,
+                guint16 gsm)
 {
-    int i;
+    gunichar c;
 
-    for (i = 0; i < GSM_EXT_ALPHABET_SIZE; i++) {
-        if (gsm == gsm_ext_utf8_alphabet[i].gsm) {
-            memcpy (&out_utf8[0], &gsm_ext_utf8_alphabet[i].chars[0], gsm_ext_utf8_alphabet[i].len);
-            return gsm_ext_utf8_alphabet[i].len;
-        }
+    /* The escape char in the default alphabet has no valid mapping */
+    c = g_utf8_get_char_validated (mapping->chars, mapping->len);
+    if (c == (gunichar) -1 || c == (gunichar) -2)
+        return;
+
+    if (c < G_N_ELEMENTS (tables->latin1)) {
+        if (tables->latin1[c] == GSM_NONE)
+            tables->latin1[c] = gsm;
+        return;
     }
-    return 0;
+
+    g_assert (tables->n_high < GSM_HIGH_SIZE);
+    tables->high_chars[tables->n_high] = c;
+    tables->high_gsm[tables->n_high] = gsm;
+    tables->n_high++;
 }
 
-static gboolean
-utf8_to_gsm_ext_char (const char *utf8, guint32 len, guint8 *out_gsm)
+static const GsmTables *
+gsm_tables_get (void)
 {
-    int i;
+    static GsmTables tables;
+    static gsize initialized = 0;
+
+    if (g_once_init_enter (&initialized)) {
+        guint i;
 
-    if (len > 0 && len < 4) {
+        memset (tables.ext_index, -1, sizeof (tables.ext_index));
+        for (i = 0; i < G_N_ELEMENTS (tables.latin1); i++)
+            tables.latin1[i] = GSM_NONE;
+
+        /* Default alphabet first, so that it's preferred */
+        for (i = 0; i < GSM_DEF_ALPHABET_SIZE; i++)
+            gsm_tables_add (&tables, &gsm_def_utf8_alphabet[i], i);
         for (i = 0; i < GSM_EXT_ALPHABET_SIZE; i++) {
-            if (gsm_ext_utf8_alphabet[i].len == len) {
-                if (memcmp (&gsm_ext_utf8_alphabet[i].chars[0], utf8, len) == 0) {
-                    *out_gsm = gsm_ext_utf8_alphabet[i].gsm;
-                    return TRUE;
-                }
-            }
+            tables.ext_index[gsm_ext_utf8_alphabet[i].gsm] = i;
+            gsm_tables_add (&tables, &gsm_ext_utf8_alphabet[i], gsm_ext_utf8_alphabet[i].gsm | GSM_EXT_FLAG);
         }
+
+        g_once_init_leave (&initialized, 1);
     }
-    return FALSE;
+
+    return &tables;
 }
 
-guint8 *
-mm_charset_gsm_unpacked_to_utf8 (const guint8 *gsm, guint32 len)
+static guint16
+gsm_tables_lookup (const GsmTables *tables,
+                   gunichar c)
 {
-    int i;
-    GByteArray *utf8;
+    guint i;
 
-    g_return_val_if_fail (gsm != NULL, NULL);
-    g_return_val_if_fail (len < 4096, NULL);
+    if (c < G_N_ELEMENTS (tables->latin1))
+        return tables->latin1[c];
+
+    for (i = 0; i < tables->n_high; i++) {
+        if (tables->high_chars[i] == c)
+            return tables->high_gsm[i];
+    }
+    return GSM_NONE;
+}
+
+/*****************************************************************************/
+/* Native converters
+ *
+ * GSM (unpacked), IRA, ISO-8859-1, UCS-2 (as UTF-16BE) and UTF-8 are
+ * converted without iconv. Every converter is run twice: first without output
+ * buffer, to get the exact output size, then to fill in the buffer. */
+
+#define DECODE_ERROR G_MAXSIZE
+
+/* When transliterating, characters which cannot be encoded are replaced with
+ * their base character (e.g. 'a' for 'á') if possible, or with '?' */
+static gunichar
+unichar_translit_base (gunichar c)
+{
+    gunichar decomposition[G_UNICHAR_MAX_DECOMPOSITION_LENGTH];
+
+    if (g_unichar_fully_decompose (c, FALSE, decomposition, G_N_ELEMENTS (decomposition)) > 1)
+        return decomposition[0];
+    return '?';
+}
 
-    /* worst case initial length */
-    utf8 = g_byte_array_sized_new (len * 2 + 1);
+static gsize
+gsm_decode (const guint8 *in,
+            gsize len,
+            gchar *out)
+{
+    const GsmTables *tables;
+    gsize written = 0;
+    gsize i;
 
+    tables = gsm_tables_get ();
     for (i = 0; i < len; i++) {
-        guint8 uchars[4];
-        guint8 ulen;
-
-        if (gsm[i] == GSM_ESCAPE_CHAR) {
-            /* Extended alphabet, decode next char */
-            ulen = gsm_ext_char_to_utf8 (gsm[i+1], uchars);
-            if (ulen)
-                i += 1;
+        const GsmUtf8Mapping *mapping = NULL;
+
+        if (in[i] == GSM_ESCAPE_CHAR &&
+            (i + 1) < len &&
+            in[i + 1] < GSM_DEF_ALPHABET_SIZE &&
+            tables->ext_index[in[i + 1]] >= 0) {
+            /* Extended alphabet */
+            mapping = &gsm_ext_utf8_alphabet[tables->ext_index[in[i + 1]]];
+            i++;
+        } else if (in[i] == GSM_ESCAPE_CHAR) {
+            /* Unknown extended char, shown as a space as per 3GPP TS 23.038 */
+            if (out)
+                out[written] = ' ';
+            written++;
+            continue;
+        } else if (in[i] < GSM_DEF_ALPHABET_SIZE)
+            mapping = &gsm_def_utf8_alphabet[in[i]];
+
+        if (!mapping) {
+            if (out)
+                out[written] = '?';
+            written++;
+            continue;
+        }
+
+        if (out)
+            memcpy (&out[written], mapping->chars, mapping->len);
+        written += mapping->len;
+    }
+
+    return written;
+}
+
+static gsize
+gsm_encode (const gchar *utf8,
+            gsize len,
+            gboolean translit,
+            guint8 *out)
+{
+    const GsmTables *tables;
+    const gchar *p;
+    const gchar *end;
+    gsize written = 0;
+
+    tables = gsm_tables_get ();
+    for (p = utf8, end = utf8 + len; p < end; p = g_utf8_next_char (p)) {
+        guint16 gsm;
+
+        gsm = gsm_tables_lookup (tables, g_utf8_get_char (p));
+        if (gsm == GSM_NONE) {
+            if (!translit)
+                return ENCODE_ERROR;
+            gsm = gsm_tables_lookup (tables, unichar_translit_base (g_utf8_get_char (p)));
+            if (gsm == GSM_NONE || (gsm & GSM_EXT_FLAG))
+                gsm = '?';
+        }
+
+        if (gsm & GSM_EXT_FLAG) {
+            if (out) {
+                out[written] = GSM_ESCAPE_CHAR;
+                out[written + 1] = gsm & 0x7F;
+            }
+            written += 2;
         } else {
-            /* Default alphabet */
-            ulen = gsm_def_char_to_utf8 (gsm[i], uchars);
+            if (out)
+                out[written] = gsm;
+            written++;
         }
+    }
+
+    return written;
+}
+
+static gsize
+ucs2_decode (const guint8 *in,
+             gsize len,
+             gchar *out)
+{
+    gsize written = 0;
+    gsize i;
 
-        if (ulen)
-            g_byte_array_append (utf8, &uchars[0], ulen);
-        else
-            g_byte_array_append (utf8, (guint8 *) "?", 1);
+    /* UTF-16BE really, as surrogate pairs are also accepted */
+    if (len % 2)
+        return DECODE_ERROR;
+
+    for (i = 0; i < len; i += 2) {
+        gunichar c;
+
+        c = (in[i] << 8) | in[i + 1];
+        if (c >= 0xD800 && c < 0xDC00) {
+            gunichar low;
+
+            if ((i + 3) >= len)
+                return DECODE_ERROR;
+            low = (in[i + 2] << 8) | in[i + 3];
+            if (low < 0xDC00 || low >= 0xE000)
+                return DECODE_ERROR;
+            c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+            i += 2;
+        } else if (c >= 0xDC00 && c < 0xE000)
+            return DECODE_ERROR;
+
+        written += g_unichar_to_utf8 (c, out ? &out[written] : NULL);
     }
 
-    g_byte_array_append (utf8, (guint8 *) "\0", 1);  /* NULL terminator */
-    return g_byte_array_free (utf8, FALSE);
+    return written;
 }
 
-guint8 *
-mm_charset_utf8_to_unpacked_gsm (const char *utf8, guint32 *out_len)
+static gsize
+ucs2_encode (const gchar *utf8,
+             gsize len,
+             gboolean translit,
+             guint8 *out)
 {
-    GByteArray *gsm;
-    const char *c = utf8, *next = c;
-    static const guint8 gesc = GSM_ESCAPE_CHAR;
-    int i = 0;
+    const gchar *p;
+    const gchar *end;
+    gsize written = 0;
 
-    g_return_val_if_fail (utf8 != NULL, NULL);
-    g_return_val_if_fail (out_len != NULL, NULL);
-    g_return_val_if_fail (g_utf8_validate (utf8, -1, NULL), NULL);
+    for (p = utf8, end = utf8 + len; p < end; p = g_utf8_next_char (p)) {
+        gunichar c;
 
-    /* worst case initial length */
-    gsm = g_byte_array_sized_new (g_utf8_strlen (utf8, -1) * 2 + 1);
+        c = g_utf8_get_char (p);
+        if (c > 0xFFFF) {
+            /* Surrogate pair */
+            if (out) {
+                gunichar high = 0xD800 + ((c - 0x10000) >> 10);
+                gunichar low = 0xDC00 + ((c - 0x10000) & 0x3FF);
+
+                out[written]     = high >> 8;
+                out[written + 1] = high & 0xFF;
+                out[written + 2] = low >> 8;
+                out[written + 3] = low & 0xFF;
+            }
+            written += 4;
+            continue;
+        }
 
-    if (*utf8 == 0x00) {
-        /* Zero-length string */
-        g_byte_array_append (gsm, (guint8 *) "\0", 1);
-        *out_len = 0;
-        return g_byte_array_free (gsm, FALSE);
+        if (out) {
+            out[written]     = c >> 8;
+            out[written + 1] = c & 0xFF;
+        }
+        written += 2;
     }
 
-    while (next && *next) {
-        guint8 gch = 0x3f;  /* 0x3f == '?' */
+    return written;
+}
 
-        next = g_utf8_next_char (c);
+/* IRA and ISO-8859-1 map directly to the first 128 and 256 code points */
+static gsize
+single_byte_decode (const guint8 *in,
+                    gsize len,
+                    guint max,
+                    gchar *out)
+{
+    gsize written = 0;
+    gsize i;
 
-        /* Try escaped chars first, then default alphabet */
-        if (utf8_to_gsm_ext_char (c, next - c, &gch)) {
-            /* Add the escape char */
-            g_byte_array_append (gsm, &gesc, 1);
-            g_byte_array_append (gsm, &gch, 1);
-        } else if (utf8_to_gsm_def_char (c, next - c, &gch))
-            g_byte_array_append (gsm, &gch, 1);
+    for (i = 0; i < len; i++) {
+        if (in[i] > max)
+            return DECODE_ERROR;
 
-        c = next;
-        i++;
+        if (in[i] < 0x80) {
+            if (out)
+                out[written] = in[i];
+            written++;
+        } else {
+            if (out) {
+                out[written]     = 0xC0 | (in[i] >> 6);
+                out[written + 1] = 0x80 | (in[i] & 0x3F);
+            }
+            written += 2;
+        }
+    }
+
+    return written;
+}
+
+static gsize
+single_byte_encode (const gchar *utf8,
+                    gsize len,
+                    guint max,
+                    gboolean translit,
+                    guint8 *out)
+{
+    const gchar *p;
+    const gchar *end;
+    gsize written = 0;
+
+    for (p = utf8, end = utf8 + len; p < end; p = g_utf8_next_char (p)) {
+        gunichar c;
+
+        c = g_utf8_get_char (p);
+        if (c > max) {
+            if (!translit)
+                return ENCODE_ERROR;
+            c = unichar_translit_base (c);
+            if (c > max)
+                c = '?';
+        }
+
+        if (out)
+            out[written] = c;
+        written++;
     }
 
-    *out_len = gsm->len;
-    return g_byte_array_free (gsm, FALSE);
+    return written;
 }
 
 static gboolean
-gsm_is_subset (gunichar c, const char *utf8, gsize ulen)
+charset_is_native (MMModemCharset charset)
 {
-    guint8 gsm;
+    return !!(charset & (MM_MODEM_CHARSET_GSM |
+                         MM_MODEM_CHARSET_IRA |
+                         MM_MODEM_CHARSET_8859_1 |
+                         MM_MODEM_CHARSET_UCS2 |
+                         MM_MODEM_CHARSET_UTF8));
+}
 
-    if (utf8_to_gsm_def_char (utf8, ulen, &gsm))
-        return TRUE;
-    if (utf8_to_gsm_ext_char (utf8, ulen, &gsm))
-        return TRUE;
-    return FALSE;
+static gsize
+charset_native_decode_to (MMModemCharset charset,
+                          const guint8 *data,
+                          gsize len,
+                          gchar *out)
+{
+    switch (charset) {
+    case MM_MODEM_CHARSET_GSM:
+        return gsm_decode (data, len, out);
+    case MM_MODEM_CHARSET_IRA:
+        return single_byte_decode (data, len, 0x7F, out);
+    case MM_MODEM_CHARSET_8859_1:
+        return single_byte_decode (data, len, 0xFF, out);
+    case MM_MODEM_CHARSET_UCS2:
+        return ucs2_decode (data, len, out);
+    case MM_MODEM_CHARSET_UTF8:
+        if (!g_utf8_validate ((const gchar *) data, len, NULL))
+            return DECODE_ERROR;
+        if (out)
+            memcpy (out, data, len);
+        return len;
+    default:
+        g_assert_not_reached ();
+        return DECODE_ERROR;
+    }
+}
+
+gsize
+mm_modem_charset_decode_into (MMModemCharset charset,
+                              const guint8 *data,
+                              gsize len,
+                              gchar *out)
+{
+    g_return_val_if_fail (charset_is_native (charset), DECODE_ERROR);
+
+    return charset_native_decode_to (charset, data, len, out);
+}
+
+/* Returns a NUL-terminated UTF-8 string, or NULL if @data isn't valid in the
+ * given charset */
+static gchar *
+charset_native_decode (MMModemCharset charset,
+                       const guint8 *data,
+                       gsize len,
+                       gsize *out_len)
+{
+    gchar *utf8;
+    gsize utf8_len;
+
+    utf8_len = charset_native_decode_to (charset, data, len, NULL);
+    if (utf8_len == DECODE_ERROR)
+        return NULL;
+
+    utf8 = g_malloc (utf8_len + 1);
+    charset_native_decode_to (charset, data, len, utf8);
+    utf8[utf8_len] = '\0';
+
+    if (out_len)
+        *out_len = utf8_len;
+    return utf8;
+}
+
+/* Encodes @len bytes of valid UTF-8 into @out, if given, and returns the
+ * amount of bytes needed, or ENCODE_ERROR if there are chars which cannot
+ * be encoded and @translit is %FALSE */
+static gsize
+charset_native_encode (MMModemCharset charset,
+                       const gchar *utf8,
+                       gsize len,
+                       gboolean translit,
+                       guint8 *out)
+{
+    switch (charset) {
+    case MM_MODEM_CHARSET_GSM:
+        return gsm_encode (utf8, len, translit, out);
+    case MM_MODEM_CHARSET_IRA:
+        return single_byte_encode (utf8, len, 0x7F, translit, out);
+    case MM_MODEM_CHARSET_8859_1:
+        return single_byte_encode (utf8, len, 0xFF, translit, out);
+    case MM_MODEM_CHARSET_UCS2:
+        return ucs2_encode (utf8, len, translit, out);
+    case MM_MODEM_CHARSET_UTF8:
+        if (out)
+            memcpy (out, utf8, len);
+        return len;
+    default:
+        g_assert_not_reached ();
+        return ENCODE_ERROR;
+    }
+}
+
+/* Returns a NUL-terminated buffer, or NULL if @utf8 isn't valid UTF-8 or
+ * cannot be encoded */
+static guint8 *
+charset_native_encode_dup (MMModemCharset charset,
+                           const gchar *utf8,
+                           gboolean translit,
+                           gsize *out_len)
+{
+    guint8 *encoded;
+    gsize utf8_len;
+    gsize encoded_len;
+
+    utf8_len = strlen (utf8);
+    if (!g_utf8_validate (utf8, utf8_len, NULL))
+        return NULL;
+
+    encoded_len = charset_native_encode (charset, utf8, utf8_len, translit, NULL);
+    if (encoded_len == ENCODE_ERROR)
+        return NULL;
+
+    encoded = g_malloc (encoded_len + 1);
+    charset_native_encode (charset, utf8, utf8_len, translit, encoded);
+    encoded[encoded_len] = '\0';
+
+    if (out_len)
+        *out_len = encoded_len;
+    return encoded;
+}
+
+/*****************************************************************************/
+
+guint8 *
+mm_charset_gsm_unpacked_to_utf8 (const guint8 *gsm, guint32 len)
+{
+    g_return_val_if_fail (gsm != NULL, NULL);
+    g_return_val_if_fail (len < 4096, NULL);
+
+    return (guint8 *) charset_native_decode (MM_MODEM_CHARSET_GSM, gsm, len, NULL);
+}
+
+guint8 *
+mm_charset_utf8_to_unpacked_gsm (const char *utf8, guint32 *out_len)
+{
+    guint8 *gsm;
+    gsize len = 0;
+
+    g_return_val_if_fail (utf8 != NULL, NULL);
+    g_return_val_if_fail (out_len != NULL, NULL);
+    g_return_val_if_fail (g_utf8_validate (utf8, -1, NULL), NULL);
+
+    gsm = charset_native_encode_dup (MM_MODEM_CHARSET_GSM, utf8, TRUE, &len);
+    *out_len = len;
+    return gsm;
+}
+
+static gboolean
+gsm_is_subset (gunichar c, const char *utf8, gsize ulen)
+{
+    return (gsm_tables_lookup (gsm_tables_get (), c) != GSM_NONE);
 }
 
 static gboolean
@@ -643,40 +1044,104 @@ mm_charset_can_convert_to (const char *utf8,
     return TRUE;
 }
 
+/* Septets are packed LSB first, so every 8 septets starting at a byte
+ * boundary fill exactly 7 bytes, which are handled as a single 56-bit
+ * little-endian word. Only the septets before the first byte boundary and
+ * after the last full block are handled one by one. */
+#define GSM_BLOCK_SEPTETS 8
+#define GSM_BLOCK_BYTES   7
+
+static inline guint8
+gsm_unpack_septet (const guint8 *gsm,
+                   guint32 start_bit)
+{
+    guint offset;
+    guint8 c;
+
+    offset = start_bit % 8;
+    c = gsm[start_bit / 8] >> offset;
+    /* Grab any bits that spilled over to next byte */
+    if (offset > 1)
+        c |= gsm[(start_bit / 8) + 1] << (8 - offset);
+    return c & 0x7F;
+}
+
+static inline void
+gsm_unpack_block (const guint8 *gsm,
+                  guint8 *out)
+{
+    guint64 block;
+    guint i;
+
+    block = 0;
+    for (i = 0; i < GSM_BLOCK_BYTES; i++)
+        block |= ((guint64) gsm[i]) << (8 * i);
+    for (i = 0; i < GSM_BLOCK_SEPTETS; i++)
+        out[i] = (block >> (7 * i)) & 0x7F;
+}
+
+void
+mm_charset_gsm_unpack_into (const guint8 *gsm,
+                            guint32 num_septets,
+                            guint8 start_offset,  /* in _bits_ */
+                            guint8 *out)
+{
+    guint32 head;
+    guint32 i = 0;
+
+    /* Septets until the next one starts at a byte boundary */
+    head = MIN (start_offset % 8, num_septets);
+    for (; i < head; i++)
+        out[i] = gsm_unpack_septet (gsm, start_offset + (i * 7));
+
+    for (; (i + GSM_BLOCK_SEPTETS) <= num_septets; i += GSM_BLOCK_SEPTETS)
+        gsm_unpack_block (&gsm[(start_offset + (i * 7)) / 8], &out[i]);
+
+    for (; i < num_septets; i++)
+        out[i] = gsm_unpack_septet (gsm, start_offset + (i * 7));
+}
+
 guint8 *
 mm_charset_gsm_unpack (const guint8 *gsm,
                        guint32 num_septets,
                        guint8 start_offset,  /* in _bits_ */
                        guint32 *out_unpacked_len)
 {
-    GByteArray *unpacked;
-    int i;
-
-    unpacked = g_byte_array_sized_new (num_septets + 1);
-
-    for (i = 0; i < num_septets; i++) {
-        guint8 bits_here, bits_in_next, octet, offset, c;
-        guint32 start_bit;
+    guint8 *unpacked;
 
-        start_bit = start_offset + (i * 7); /* Overall bit offset of char in buffer */
-        offset = start_bit % 8;  /* Offset to start of char in this byte */
-        bits_here = offset ? (8 - offset) : 7;
-        bits_in_next = 7 - bits_here;
+    unpacked = g_malloc (num_septets + 1);
+    mm_charset_gsm_unpack_into (gsm, num_septets, start_offset, unpacked);
+    unpacked[num_septets] = 0;
+    *out_unpacked_len = num_septets;
+    return unpacked;
+}
 
-        /* Grab bits in the current byte */
-        octet = gsm[start_bit / 8];
-        c = (octet >> offset) & (0xFF >> (8 - bits_here));
+static inline void
+gsm_pack_septet (guint8 *packed,
+                 guint32 start_bit,
+                 guint8 c)
+{
+    guint offset;
 
-        /* Grab any bits that spilled over to next byte */
-        if (bits_in_next) {
-            octet = gsm[(start_bit / 8) + 1];
-            c |= (octet & (0xFF >> (8 - bits_in_next))) << bits_here;
-        }
-        g_byte_array_append (unpacked, &c, 1);
-    }
+    offset = start_bit % 8;
+    packed[start_bit / 8] |= (c & 0x7F) << offset;
+    /* Add the lost bits to next octet */
+    if (offset > 1)
+        packed[(start_bit / 8) + 1] |= (c & 0x7F) >> (8 - offset);
+}
 
-    *out_unpacked_len = unpacked->len;
-    return g_byte_array_free (unpacked, FALSE);
+static inline void
+gsm_pack_block (const guint8 *src,
+                guint8 *out)
+{
+    guint64 block;
+    guint i;
+
+    block = 0;
+    for (i = 0; i < GSM_BLOCK_SEPTETS; i++)
+        block |= ((guint64) (src[i] & 0x7F)) << (7 * i);
+    for (i = 0; i < GSM_BLOCK_BYTES; i++)
+        out[i] = (block >> (8 * i)) & 0xFF;
 }
 
 guint8 *
@@ -686,8 +1151,9 @@ mm_charset_gsm_pack (const guint8 *src,
                      guint32 *out_packed_len)
 {
     guint8 *packed;
-    guint octet = 0, lshift, plen;
-    int i = 0;
+    guint plen;
+    guint32 head;
+    guint32 i = 0;
 
     g_return_val_if_fail (start_offset < 8, NULL);
 
@@ -698,17 +1164,17 @@ mm_charset_gsm_pack (const guint8 *src,
 
     packed = g_malloc0 (plen);
 
-    for (i = 0, lshift = start_offset; i < src_len; i++) {
-        packed[octet] |= (src[i] & 0x7F) << lshift;
-        if (lshift > 1) {
-            /* Grab the lost bits and add to next octet */
-            g_assert (octet + 1 < plen);
-            packed[octet + 1] = (src[i] & 0x7F) >> (8 - lshift);
-        }
-        if (lshift)
-            octet++;
-        lshift = lshift ? lshift - 1 : 7;
-    }
+    /* Septets until the next one starts at a byte boundary; full blocks
+     * always start at a byte boundary, so no bits spill into them */
+    head = MIN (start_offset, src_len);
+    for (; i < head; i++)
+        gsm_pack_septet (packed, start_offset + (i * 7), src[i]);
+
+    for (; (i + GSM_BLOCK_SEPTETS) <= src_len; i += GSM_BLOCK_SEPTETS)
+        gsm_pack_block (&src[i], &packed[(start_offset + (i * 7)) / 8]);
+
+    for (; i < src_len; i++)
+        gsm_pack_septet (packed, start_offset + (i * 7), src[i]);
 
     if (out_packed_len)
         *out_packed_len = plen;
@@ -740,6 +1206,10 @@ mm_charset_take_and_convert_to_utf8 (gchar *str, MMModemCharset charset)
 
     case MM_MODEM_CHARSET_GSM:
     case MM_MODEM_CHARSET_8859_1:
+        utf8 = charset_native_decode (charset, (const guint8 *) str, strlen (str), NULL);
+        g_free (str);
+        break;
+
     case MM_MODEM_CHARSET_PCCP437:
     case MM_MODEM_CHARSET_PCDN: {
         const gchar *iconv_from;
@@ -761,7 +1231,7 @@ mm_charset_take_and_convert_to_utf8 (gchar *str, MMModemCharset charset)
     case MM_MODEM_CHARSET_UCS2: {
         gsize len;
         gboolean possibly_hex = TRUE;
-        gsize bread = 0, bwritten = 0;
+        const gchar *end = NULL;
 
         /* If the string comes in hex-UCS-2, len needs to be a multiple of 4 */
         len = strlen (str);
@@ -785,27 +1255,21 @@ mm_charset_take_and_convert_to_utf8 (gchar *str, MMModemCharset charset)
         }
 
         /* If not hex, then it might be raw UCS-2 (very unlikely) or ASCII/UTF-8
-         * (much more likely).  Try to convert to UTF-8 and if that fails, use
-         * the partial conversion length to re-convert the part of the string
-         * that is UTF-8, if any.
+         * (much more likely). If it isn't all valid UTF-8, keep the part of
+         * the string that is, if any.
          */
-        utf8 = g_convert (str, strlen (str),
-                          "UTF-8//TRANSLIT", "UTF-8//TRANSLIT",
-                          &bread, &bwritten, NULL);
+        if (g_utf8_validate (str, -1, &end)) {
+            utf8 = str;
+            break;
+        }
 
-        /* Valid conversion, or we didn't get enough valid UTF-8 */
-        if (utf8 || (bwritten <= 2)) {
+        /* Not enough valid UTF-8 */
+        if ((end - str) <= 2) {
             g_free (str);
             break;
         }
 
-        /* Last try; chop off the original string at the conversion failure
-         * location and get what we can.
-         */
-        str[bread] = '\0';
-        utf8 = g_convert (str, strlen (str),
-                          "UTF-8//TRANSLIT", "UTF-8//TRANSLIT",
-                          NULL, NULL, NULL);
+        utf8 = g_strndup (str, end - str);
         g_free (str);
         break;
     }
@@ -863,6 +1327,10 @@ mm_utf8_take_and_convert_to_charset (gchar *str,
 
     case MM_MODEM_CHARSET_GSM:
     case MM_MODEM_CHARSET_8859_1:
+        encoded = (gchar *) charset_native_encode_dup (charset, str, FALSE, NULL);
+        g_free (str);
+        break;
+
     case MM_MODEM_CHARSET_PCCP437:
     case MM_MODEM_CHARSET_PCDN: {
         const gchar *iconv_to;
@@ -882,24 +1350,13 @@ mm_utf8_take_and_convert_to_charset (gchar *str,
     }
 
     case MM_MODEM_CHARSET_UCS2: {
-        const gchar *iconv_to;
-        gsize encoded_len = 0;
-        GError *error = NULL;
-        gchar *hex;
-
-        iconv_to = charset_iconv_from (charset);
-        encoded = g_convert (str, strlen (str),
-                             iconv_to, "UTF-8",
-                             NULL, &encoded_len, &error);
-        if (!encoded || error) {
-            g_clear_error (&error);
-            encoded = NULL;
-        }
+        guint8 *ucs2;
+        gsize ucs2_len = 0;
 
         /* Get hex representation of the string */
-        hex = mm_utils_bin2hexstr ((guint8 *)encoded, encoded_len);
-        g_free (encoded);
-        encoded = hex;
+        ucs2 = charset_native_encode_dup (charset, str, FALSE, &ucs2_len);
+        encoded = ucs2 ? mm_utils_bin2hexstr (ucs2, ucs2_len) : NULL;
+        g_free (ucs2);
         g_free (str);
         break;
     }
@@ -62,6 +62,14 @@ guint8 *mm_charset_utf8_to_unpacked_gsm (const char *utf8, guint32 *out_len);
 
 guint8 *mm_charset_gsm_unpacked_to_utf8 (const guint8 *gsm, guint32 len);
 
+/* Decodes @len bytes in the given charset (GSM unpacked, IRA, 8859-1, UCS-2
+ * or UTF-8) to UTF-8 into @out, which is not NUL-terminated. If @out is
+ * NULL, only the required size is computed. Returns G_MAXSIZE on error. */
+gsize mm_modem_charset_decode_into (MMModemCharset charset,
+                                    const guint8 *data,
+                                    gsize len,
+                                    gchar *out);
+
 /* Checks whether conversion to the given charset may be done without errors */
 gboolean mm_charset_can_convert_to (const char *utf8,
                                     MMModemCharset charset);
@@ -71,6 +79,12 @@ guint8 *mm_charset_gsm_unpack (const guint8 *gsm,
                                guint8 start_offset,  /* in bits */
                                guint32 *out_unpacked_len);
 
+/* @out must hold at least @num_septets bytes */
+void mm_charset_gsm_unpack_into (const guint8 *gsm,
+                                 guint32 num_septets,
+                                 guint8 start_offset,  /* in bits */
+                                 guint8 *out);
+
 guint8 *mm_charset_gsm_pack (const guint8 *src,
                              guint32 src_len,
                              guint8 start_offset,  /* in bits */
@@ -0,0 +1,69 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include "mm-command-lanes.h"
+
+void
+mm_command_lanes_insert (GQueue             *queue,
+                         MMCommandLanesItem *item,
+                         gboolean            run_next)
+{
+    GList *l;
+    GList *overtaken;
+
+    /* If requested to run next, push to the head of the queue so that it really is
+     * the next one sent */
+    if (run_next) {
+        g_queue_push_head (queue, item);
+        return;
+    }
+
+    /* Otherwise, queue it right after the last command of the same or a more
+     * urgent lane, without going past a started command or one which was
+     * already overtaken too many times */
+    for (l = queue->tail; l; l = g_list_previous (l)) {
+        MMCommandLanesItem *other = (MMCommandLanesItem *) l->data;
+
+        if (other->lane <= item->lane ||
+            other->started ||
+            other->n_overtaken >= MM_COMMAND_LANES_MAX_OVERTAKEN)
+            break;
+    }
+
+    /* None of the ones we go past reached the limit */
+    for (overtaken = (l ? g_list_next (l) : queue->head); overtaken; overtaken = g_list_next (overtaken))
+        ((MMCommandLanesItem *) overtaken->data)->n_overtaken++;
+
+    if (l)
+        g_queue_insert_after (queue, l, item);
+    else
+        g_queue_push_head (queue, item);
+}
+
+guint
+mm_command_lanes_get_depth (GQueue *queue,
+                            guint   lane)
+{
+    GList *l;
+    guint  depth = 0;
+
+    /* The queue is short, so just count instead of tracking every
+     * path which removes commands from it */
+    for (l = queue->head; l; l = g_list_next (l)) {
+        if (((MMCommandLanesItem *) l->data)->lane == lane)
+            depth++;
+    }
+    return depth;
+}
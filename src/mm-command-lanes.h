@@ -0,0 +1,47 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#ifndef MM_COMMAND_LANES_H
+#define MM_COMMAND_LANES_H
+
+#include <glib.h>
+
+/* Ordering of a command queue with priority lanes, lane 0 being the most
+ * urgent one. Commands are queued after the ones of the same or a more urgent
+ * lane, so in lane order and in FIFO order within the same lane, but a queued
+ * command is overtaken by at most MM_COMMAND_LANES_MAX_OVERTAKEN commands of
+ * more urgent lanes, so that a busy lane never starves the others. A command
+ * already started is never overtaken.
+ *
+ * The queue items must start with a MMCommandLanesItem. */
+
+#define MM_COMMAND_LANES_MAX_OVERTAKEN 8
+
+typedef struct {
+    guint    lane;
+    gboolean started;
+    guint    n_overtaken;
+} MMCommandLanesItem;
+
+/* Queues the item in its place, or at the head if 'run_next' is set */
+void  mm_command_lanes_insert    (GQueue             *queue,
+                                  MMCommandLanesItem *item,
+                                  gboolean            run_next);
+
+/* Number of items queued in the lane, including the started one */
+guint mm_command_lanes_get_depth (GQueue             *queue,
+                                  guint               lane);
+
+#endif /* MM_COMMAND_LANES_H */
@@ -21,6 +21,9 @@
 #include <libmm-glib.h>
 
 #include "mm-context.h"
+#include "mm-freshness.h"
+#include "mm-properties-batch.h"
+#include "mm-netlink-monitor.h"
 
 /*****************************************************************************/
 /* Application context */
@@ -41,6 +44,9 @@ static gboolean      debug;
 static MMFilterRule  filter_policy = MM_FILTER_POLICY_DEFAULT;
 static gboolean      no_auto_scan = NO_AUTO_SCAN_DEFAULT;
 static const gchar  *initial_kernel_events;
+static gint          poll_stale_deadline = MM_FRESHNESS_DEFAULT_DEADLINE_SEC;
+static gint          properties_changed_window = MM_PROPERTIES_BATCH_DEFAULT_WINDOW_MS;
+static gint          bearer_throughput_interval = MM_NETLINK_MONITOR_STATS_INTERVAL_SEC;
 
 static gboolean
 filter_policy_option_arg (const gchar  *option_name,
@@ -90,6 +96,21 @@ static const GOptionEntry entries[] = {
         "Path to initial kernel events file",
         "[PATH]"
     },
+    {
+        "poll-stale-deadline", 0, 0, G_OPTION_ARG_INT, &poll_stale_deadline,
+        "Seconds after which values updated by polls or unsolicited messages are polled again",
+        "[SECONDS]"
+    },
+    {
+        "properties-changed-window", 0, 0, G_OPTION_ARG_INT, &properties_changed_window,
+        "Milliseconds during which property change notifications are merged, 0 to disable",
+        "[MS]"
+    },
+    {
+        "bearer-throughput-interval", 0, 0, G_OPTION_ARG_INT, &bearer_throughput_interval,
+        "Seconds between samples of the traffic of connected network interfaces",
+        "[SECONDS]"
+    },
     {
         "debug", 0, 0, G_OPTION_ARG_NONE, &debug,
         "Run with extended debugging capabilities",
@@ -132,6 +153,24 @@ mm_context_get_filter_policy (void)
     return filter_policy;
 }
 
+guint
+mm_context_get_poll_stale_deadline (void)
+{
+    return (guint) poll_stale_deadline;
+}
+
+guint
+mm_context_get_properties_changed_window (void)
+{
+    return (guint) properties_changed_window;
+}
+
+guint
+mm_context_get_bearer_throughput_interval (void)
+{
+    return (guint) bearer_throughput_interval;
+}
+
 /*****************************************************************************/
 /* Log context */
 
@@ -347,4 +386,19 @@ mm_context_init (gint argc,
         exit (1);
     }
 #endif
+
+    if (poll_stale_deadline < 0) {
+        g_warning ("error: invalid --poll-stale-deadline value given: %d", poll_stale_deadline);
+        exit (1);
+    }
+
+    if (properties_changed_window < 0) {
+        g_warning ("error: invalid --properties-changed-window value given: %d", properties_changed_window);
+        exit (1);
+    }
+
+    if (bearer_throughput_interval <= 0) {
+        g_warning ("error: invalid --bearer-throughput-interval value given: %d", bearer_throughput_interval);
+        exit (1);
+    }
 }
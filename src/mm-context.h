@@ -35,6 +35,13 @@ gboolean     mm_context_get_no_auto_scan          (void);
 /* Filter support */
 MMFilterRule mm_context_get_filter_policy (void);
 
+/* Polling support */
+guint        mm_context_get_poll_stale_deadline (void);
+guint        mm_context_get_bearer_throughput_interval (void);
+
+/* D-Bus support */
+guint        mm_context_get_properties_changed_window (void);
+
 /* Logging support */
 const gchar *mm_context_get_log_level               (void);
 const gchar *mm_context_get_log_file                (void);
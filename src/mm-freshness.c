@@ -0,0 +1,95 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include "mm-freshness.h"
+
+struct _MMFreshness {
+    guint  deadline[MM_FRESHNESS_PROPERTY_LAST];
+    /* Monotonic time of the last update, 0 if none */
+    gint64 updated[MM_FRESHNESS_PROPERTY_LAST];
+};
+
+MMFreshness *
+mm_freshness_new (guint deadline)
+{
+    MMFreshness *self;
+    guint        i;
+
+    self = g_slice_new0 (MMFreshness);
+    for (i = 0; i < MM_FRESHNESS_PROPERTY_LAST; i++)
+        self->deadline[i] = deadline;
+    return self;
+}
+
+void
+mm_freshness_free (MMFreshness *self)
+{
+    g_slice_free (MMFreshness, self);
+}
+
+void
+mm_freshness_set_expiry (MMFreshness         *self,
+                         MMFreshnessProperty  property,
+                         guint                expiry,
+                         guint                max_interval)
+{
+    guint limit = 0;
+
+    g_assert (property < MM_FRESHNESS_PROPERTY_LAST);
+
+    if (expiry > max_interval + MM_POLL_SCHEDULER_SLOT_SEC)
+        limit = expiry - max_interval - MM_POLL_SCHEDULER_SLOT_SEC;
+    self->deadline[property] = MIN (self->deadline[property], limit);
+}
+
+guint
+mm_freshness_get_deadline (MMFreshness         *self,
+                           MMFreshnessProperty  property)
+{
+    g_assert (property < MM_FRESHNESS_PROPERTY_LAST);
+
+    return self->deadline[property];
+}
+
+void
+mm_freshness_update (MMFreshness         *self,
+                     MMFreshnessProperty  property,
+                     gint64               now)
+{
+    g_assert (property < MM_FRESHNESS_PROPERTY_LAST);
+
+    /* Never store 0, which means no update */
+    self->updated[property] = MAX (now, 1);
+}
+
+void
+mm_freshness_clear (MMFreshness         *self,
+                    MMFreshnessProperty  property)
+{
+    g_assert (property < MM_FRESHNESS_PROPERTY_LAST);
+
+    self->updated[property] = 0;
+}
+
+gboolean
+mm_freshness_is_fresh (MMFreshness         *self,
+                       MMFreshnessProperty  property,
+                       gint64               now)
+{
+    g_assert (property < MM_FRESHNESS_PROPERTY_LAST);
+
+    return (self->updated[property] > 0 &&
+            now - self->updated[property] < (gint64) self->deadline[property] * G_USEC_PER_SEC);
+}
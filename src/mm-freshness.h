@@ -0,0 +1,68 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#ifndef MM_FRESHNESS_H
+#define MM_FRESHNESS_H
+
+#include <glib.h>
+
+#include "mm-poll-scheduler.h"
+
+/* Time of the last update of the modem properties that are both polled and
+ * reported in unsolicited messages (URCs, QMI/MBIM indications). Every update
+ * source timestamps the value, and the periodic checks only query the modem
+ * once the value is older than the stale deadline. */
+
+#define MM_FRESHNESS_DEFAULT_DEADLINE_SEC 300
+
+typedef enum {
+    MM_FRESHNESS_PROPERTY_SIGNAL_QUALITY,
+    MM_FRESHNESS_PROPERTY_ACCESS_TECHNOLOGIES,
+    MM_FRESHNESS_PROPERTY_CS_REGISTRATION_STATE,
+    MM_FRESHNESS_PROPERTY_PS_REGISTRATION_STATE,
+    MM_FRESHNESS_PROPERTY_EPS_REGISTRATION_STATE,
+    MM_FRESHNESS_PROPERTY_OPERATOR,
+    MM_FRESHNESS_PROPERTY_LAST
+} MMFreshnessProperty;
+
+typedef struct _MMFreshness MMFreshness;
+
+/* A deadline of 0 makes every value stale right away, i.e. always poll */
+MMFreshness *mm_freshness_new     (guint                deadline);
+void         mm_freshness_free    (MMFreshness         *self);
+
+/* Values which are no longer valid 'expiry' seconds after their last update
+ * (e.g. the signal quality is no longer 'recent') must be polled before that,
+ * so with checks every 'max_interval' seconds at most, the deadline of the
+ * property is limited to what's left of the expiry after one more interval,
+ * minus a slot of the poll scheduler as margin. */
+void         mm_freshness_set_expiry   (MMFreshness         *self,
+                                        MMFreshnessProperty  property,
+                                        guint                expiry,
+                                        guint                max_interval);
+guint        mm_freshness_get_deadline (MMFreshness         *self,
+                                        MMFreshnessProperty  property);
+
+/* Times are monotonic, in microseconds */
+void         mm_freshness_update  (MMFreshness         *self,
+                                   MMFreshnessProperty  property,
+                                   gint64               now);
+void         mm_freshness_clear   (MMFreshness         *self,
+                                   MMFreshnessProperty  property);
+gboolean     mm_freshness_is_fresh (MMFreshness        *self,
+                                    MMFreshnessProperty property,
+                                    gint64              now);
+
+#endif /* MM_FRESHNESS_H */
@@ -0,0 +1,105 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <string.h>
+
+#include "mm-histogram.h"
+
+/*****************************************************************************/
+
+static guint
+bucket_index (guint64 value)
+{
+    guint exponent;
+    guint sub_bucket;
+
+    if (value < MM_HISTOGRAM_SUB_BUCKETS)
+        return (guint) value;
+    if (value >= MM_HISTOGRAM_MAX_VALUE)
+        return MM_HISTOGRAM_N_BUCKETS - 1;
+
+    /* Position of the most significant bit, and the next bits below it */
+    exponent = g_bit_storage ((gulong) value) - 1;
+    sub_bucket = (guint) (value >> (exponent - MM_HISTOGRAM_SUB_BUCKET_BITS)) & (MM_HISTOGRAM_SUB_BUCKETS - 1);
+    return ((exponent - MM_HISTOGRAM_SUB_BUCKET_BITS + 1) * MM_HISTOGRAM_SUB_BUCKETS) + sub_bucket;
+}
+
+static guint64
+bucket_upper_bound (guint index)
+{
+    guint   shift;
+    guint64 lower;
+
+    if (index < MM_HISTOGRAM_SUB_BUCKETS)
+        return index;
+    /* The last bucket also holds all values out of range */
+    if (index == MM_HISTOGRAM_N_BUCKETS - 1)
+        return G_MAXUINT64;
+
+    shift = (index / MM_HISTOGRAM_SUB_BUCKETS) - 1;
+    lower = (guint64) (MM_HISTOGRAM_SUB_BUCKETS + (index % MM_HISTOGRAM_SUB_BUCKETS)) << shift;
+    return lower + (G_GUINT64_CONSTANT (1) << shift) - 1;
+}
+
+/*****************************************************************************/
+
+void
+mm_histogram_reset (MMHistogram *self)
+{
+    memset (self, 0, sizeof (MMHistogram));
+}
+
+void
+mm_histogram_record (MMHistogram *self,
+                     guint64      value)
+{
+    if (!self->count || value < self->min)
+        self->min = value;
+    if (value > self->max)
+        self->max = value;
+    self->count++;
+    self->total += value;
+    self->buckets[bucket_index (value)]++;
+}
+
+guint64
+mm_histogram_get_mean (const MMHistogram *self)
+{
+    return (self->count ? (self->total / self->count) : 0);
+}
+
+guint64
+mm_histogram_get_percentile (const MMHistogram *self,
+                             gdouble            percentile)
+{
+    guint64 rank;
+    guint64 accumulated = 0;
+    guint   i;
+
+    if (!self->count)
+        return 0;
+
+    percentile = CLAMP (percentile, 0.0, 100.0);
+    rank = (guint64) ((percentile / 100.0) * self->count + 0.5);
+    rank = CLAMP (rank, 1, self->count);
+
+    for (i = 0; i < MM_HISTOGRAM_N_BUCKETS; i++) {
+        accumulated += self->buckets[i];
+        if (accumulated >= rank)
+            return CLAMP (bucket_upper_bound (i), self->min, self->max);
+    }
+
+    return self->max;
+}
@@ -0,0 +1,52 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#ifndef MM_HISTOGRAM_H
+#define MM_HISTOGRAM_H
+
+#include <glib.h>
+
+/* Log-linear (HDR-style) histogram of unsigned values, e.g. latencies in
+ * microseconds. Values below 8 are counted exactly; above that, each power
+ * of two is split in 8 buckets, so reported percentiles are within 12.5%
+ * of the real value. Values above MM_HISTOGRAM_MAX_VALUE are counted in the
+ * last bucket, but min/max/mean are always exact. Recording is O(1) and
+ * never allocates. */
+
+#define MM_HISTOGRAM_SUB_BUCKET_BITS 3
+#define MM_HISTOGRAM_SUB_BUCKETS     (1 << MM_HISTOGRAM_SUB_BUCKET_BITS)
+#define MM_HISTOGRAM_MAX_EXPONENT    32
+#define MM_HISTOGRAM_MAX_VALUE       (G_GUINT64_CONSTANT (1) << MM_HISTOGRAM_MAX_EXPONENT)
+#define MM_HISTOGRAM_N_BUCKETS       (MM_HISTOGRAM_SUB_BUCKETS * (MM_HISTOGRAM_MAX_EXPONENT - MM_HISTOGRAM_SUB_BUCKET_BITS + 1))
+
+typedef struct {
+    guint64 count;
+    guint64 total;
+    guint64 min;
+    guint64 max;
+    guint32 buckets[MM_HISTOGRAM_N_BUCKETS];
+} MMHistogram;
+
+void    mm_histogram_reset          (MMHistogram       *self);
+void    mm_histogram_record         (MMHistogram       *self,
+                                     guint64            value);
+
+guint64 mm_histogram_get_mean       (const MMHistogram *self);
+/* Upper bound of the bucket holding the given percentile (0-100), clamped
+ * to the exact min and max; 0 if empty */
+guint64 mm_histogram_get_percentile (const MMHistogram *self,
+                                     gdouble            percentile);
+
+#endif /* MM_HISTOGRAM_H */
@@ -27,8 +27,11 @@
 #include "mm-modem-helpers.h"
 #include "mm-error-helpers.h"
 #include "mm-log.h"
+#include "mm-poll-scheduler.h"
 
-#define REGISTRATION_CHECK_TIMEOUT_SEC 30
+#define REGISTRATION_CHECK_TIMEOUT_SEC     30
+/* Back off while the registration state doesn't change */
+#define REGISTRATION_CHECK_MAX_TIMEOUT_SEC 60
 
 #define SUBSYSTEM_3GPP "3gpp"
 
@@ -1223,6 +1226,7 @@ reload_current_registration_info_context_step (GTask *task)
     }
 
     /* If all are loaded, all done */
+    mm_iface_modem_update_freshness (MM_IFACE_MODEM (self), MM_FRESHNESS_PROPERTY_OPERATOR);
     g_task_return_boolean (task, TRUE);
     g_object_unref (task);
 }
@@ -1281,6 +1285,7 @@ mm_iface_modem_3gpp_clear_current_operator (MMIfaceModem3gpp *self)
 
     mm_gdbus_modem3gpp_set_operator_code (skeleton, NULL);
     mm_gdbus_modem3gpp_set_operator_name (skeleton, NULL);
+    mm_iface_modem_clear_freshness (MM_IFACE_MODEM (self), MM_FRESHNESS_PROPERTY_OPERATOR);
     if (MM_IS_IFACE_MODEM_LOCATION (self))
         mm_iface_modem_location_3gpp_update_mcc_mnc (MM_IFACE_MODEM_LOCATION (self), 0, 0);
 }
@@ -1481,6 +1486,7 @@ mm_iface_modem_3gpp_update_cs_registration_state (MMIfaceModem3gpp *self,
 
     ctx = get_registration_state_context (self);
     ctx->cs = state;
+    mm_iface_modem_update_freshness (MM_IFACE_MODEM (self), MM_FRESHNESS_PROPERTY_CS_REGISTRATION_STATE);
     update_registration_state (self, get_consolidated_reg_state (ctx), TRUE);
 }
 
@@ -1500,6 +1506,7 @@ mm_iface_modem_3gpp_update_ps_registration_state (MMIfaceModem3gpp *self,
 
     ctx = get_registration_state_context (self);
     ctx->ps = state;
+    mm_iface_modem_update_freshness (MM_IFACE_MODEM (self), MM_FRESHNESS_PROPERTY_PS_REGISTRATION_STATE);
     update_registration_state (self, get_consolidated_reg_state (ctx), TRUE);
 }
 
@@ -1519,29 +1526,86 @@ mm_iface_modem_3gpp_update_eps_registration_state (MMIfaceModem3gpp *self,
 
     ctx = get_registration_state_context (self);
     ctx->eps = state;
+    mm_iface_modem_update_freshness (MM_IFACE_MODEM (self), MM_FRESHNESS_PROPERTY_EPS_REGISTRATION_STATE);
     update_registration_state (self, get_consolidated_reg_state (ctx), TRUE);
 }
 
 /*****************************************************************************/
 
 typedef struct {
-    guint timeout_source;
+    guint poll_id;
     gboolean running;
+    /* State before the running check */
+    MMModem3gppRegistrationState previous_state;
 } RegistrationCheckContext;
 
 static void
 registration_check_context_free (RegistrationCheckContext *ctx)
 {
-    if (ctx->timeout_source)
-        g_source_remove (ctx->timeout_source);
+    if (ctx->poll_id)
+        mm_poll_scheduler_remove (mm_poll_scheduler_get (), ctx->poll_id);
     g_free (ctx);
 }
 
+static gboolean
+registration_state_is_fresh (MMIfaceModem3gpp *self)
+{
+    gboolean cs_supported = FALSE;
+    gboolean ps_supported = FALSE;
+    gboolean eps_supported = FALSE;
+
+    g_object_get (self,
+                  MM_IFACE_MODEM_3GPP_CS_NETWORK_SUPPORTED,  &cs_supported,
+                  MM_IFACE_MODEM_3GPP_PS_NETWORK_SUPPORTED,  &ps_supported,
+                  MM_IFACE_MODEM_3GPP_EPS_NETWORK_SUPPORTED, &eps_supported,
+                  NULL);
+
+    return ((!cs_supported  || mm_iface_modem_is_fresh (MM_IFACE_MODEM (self), MM_FRESHNESS_PROPERTY_CS_REGISTRATION_STATE)) &&
+            (!ps_supported  || mm_iface_modem_is_fresh (MM_IFACE_MODEM (self), MM_FRESHNESS_PROPERTY_PS_REGISTRATION_STATE)) &&
+            (!eps_supported || mm_iface_modem_is_fresh (MM_IFACE_MODEM (self), MM_FRESHNESS_PROPERTY_EPS_REGISTRATION_STATE)));
+}
+
+static void
+periodic_operator_check_ready (MMIfaceModem3gpp *self,
+                               GAsyncResult *res)
+{
+    GError *error = NULL;
+
+    if (!mm_iface_modem_3gpp_reload_current_registration_info_finish (self, res, &error)) {
+        mm_dbg ("Couldn't refresh current operator: '%s'", error->message);
+        g_error_free (error);
+    }
+}
+
+/* Returns TRUE if the current operator is being reloaded */
+static gboolean
+periodic_operator_check (MMIfaceModem3gpp *self)
+{
+    MMModem3gppRegistrationState state = MM_MODEM_3GPP_REGISTRATION_STATE_UNKNOWN;
+
+    /* The operator is only loaded while registered, and it is already being
+     * reloaded if the registration state just changed */
+    g_object_get (self,
+                  MM_IFACE_MODEM_3GPP_REGISTRATION_STATE, &state,
+                  NULL);
+    if (!reg_state_is_registered (state) ||
+        get_registration_state_context (self)->reloading_registration_info ||
+        mm_iface_modem_is_fresh (MM_IFACE_MODEM (self), MM_FRESHNESS_PROPERTY_OPERATOR))
+        return FALSE;
+
+    mm_iface_modem_3gpp_reload_current_registration_info (
+        self,
+        (GAsyncReadyCallback)periodic_operator_check_ready,
+        NULL);
+    return TRUE;
+}
+
 static void
 periodic_registration_checks_ready (MMIfaceModem3gpp *self,
                                     GAsyncResult *res)
 {
     RegistrationCheckContext *ctx;
+    MMModem3gppRegistrationState state = MM_MODEM_3GPP_REGISTRATION_STATE_UNKNOWN;
     GError *error = NULL;
 
     mm_iface_modem_3gpp_run_registration_checks_finish (self, res, &error);
@@ -1552,25 +1616,44 @@ periodic_registration_checks_ready (MMIfaceModem3gpp *self,
 
     /* Remove the running tag */
     ctx = g_object_get_qdata (G_OBJECT (self), registration_check_context_quark);
-    if (ctx)
-        ctx->running = FALSE;
+    if (!ctx)
+        return;
+    ctx->running = FALSE;
+
+    g_object_get (self,
+                  MM_IFACE_MODEM_3GPP_REGISTRATION_STATE, &state,
+                  NULL);
+    mm_poll_scheduler_report (mm_poll_scheduler_get (), ctx->poll_id, state != ctx->previous_state);
+
+    periodic_operator_check (self);
 }
 
-static gboolean
+static void
 periodic_registration_check (MMIfaceModem3gpp *self)
 {
     RegistrationCheckContext *ctx;
 
     /* Only launch a new one if not one running already */
     ctx = g_object_get_qdata (G_OBJECT (self), registration_check_context_quark);
-    if (!ctx->running) {
-        ctx->running = TRUE;
-        mm_iface_modem_3gpp_run_registration_checks (
-            self,
-            (GAsyncReadyCallback)periodic_registration_checks_ready,
-            NULL);
+    if (ctx->running)
+        return;
+
+    /* Only poll the registration state if not recently updated, either by a
+     * previous check or by unsolicited messages */
+    if (registration_state_is_fresh (self)) {
+        if (!periodic_operator_check (self))
+            mm_poll_scheduler_skip (mm_poll_scheduler_get (), ctx->poll_id);
+        return;
     }
-    return G_SOURCE_CONTINUE;
+
+    ctx->running = TRUE;
+    g_object_get (self,
+                  MM_IFACE_MODEM_3GPP_REGISTRATION_STATE, &ctx->previous_state,
+                  NULL);
+    mm_iface_modem_3gpp_run_registration_checks (
+        self,
+        (GAsyncReadyCallback)periodic_registration_checks_ready,
+        NULL);
 }
 
 static void
@@ -1585,6 +1668,11 @@ periodic_registration_check_disable (MMIfaceModem3gpp *self)
                         registration_check_context_quark,
                         NULL);
 
+    /* Poll right away when enabled again */
+    mm_iface_modem_clear_freshness (MM_IFACE_MODEM (self), MM_FRESHNESS_PROPERTY_CS_REGISTRATION_STATE);
+    mm_iface_modem_clear_freshness (MM_IFACE_MODEM (self), MM_FRESHNESS_PROPERTY_PS_REGISTRATION_STATE);
+    mm_iface_modem_clear_freshness (MM_IFACE_MODEM (self), MM_FRESHNESS_PROPERTY_EPS_REGISTRATION_STATE);
+
     mm_dbg ("Periodic 3GPP registration checks disabled");
 }
 
@@ -1606,9 +1694,13 @@ periodic_registration_check_enable (MMIfaceModem3gpp *self)
     /* Create context and keep it as object data */
     mm_dbg ("Periodic 3GPP registration checks enabled");
     ctx = g_new0 (RegistrationCheckContext, 1);
-    ctx->timeout_source = g_timeout_add_seconds (REGISTRATION_CHECK_TIMEOUT_SEC,
-                                                 (GSourceFunc)periodic_registration_check,
-                                                 self);
+    ctx->poll_id = mm_poll_scheduler_add (mm_poll_scheduler_get (),
+                                          g_dbus_object_get_object_path (G_DBUS_OBJECT (self)),
+                                          "3gpp-registration-check",
+                                          REGISTRATION_CHECK_TIMEOUT_SEC,
+                                          REGISTRATION_CHECK_MAX_TIMEOUT_SEC,
+                                          (MMPollSchedulerFunc)periodic_registration_check,
+                                          self);
     g_object_set_qdata_full (G_OBJECT (self),
                              registration_check_context_quark,
                              ctx,
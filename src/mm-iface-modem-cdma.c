@@ -24,8 +24,11 @@
 #include "mm-base-modem.h"
 #include "mm-modem-helpers.h"
 #include "mm-log.h"
+#include "mm-poll-scheduler.h"
 
-#define REGISTRATION_CHECK_TIMEOUT_SEC 30
+#define REGISTRATION_CHECK_TIMEOUT_SEC     30
+/* Back off while the registration states don't change */
+#define REGISTRATION_CHECK_MAX_TIMEOUT_SEC 60
 
 #define SUBSYSTEM_CDMA1X "cdma1x"
 #define SUBSYSTEM_EVDO "evdo"
@@ -1129,15 +1132,18 @@ mm_iface_modem_cdma_update_cdma1x_registration_state (MMIfaceModemCdma *self,
 /*****************************************************************************/
 
 typedef struct {
-    guint timeout_source;
+    guint poll_id;
     gboolean running;
+    /* States before the running check */
+    MMModemCdmaRegistrationState previous_cdma1x_state;
+    MMModemCdmaRegistrationState previous_evdo_state;
 } RegistrationCheckContext;
 
 static void
 registration_check_context_free (RegistrationCheckContext *ctx)
 {
-    if (ctx->timeout_source)
-        g_source_remove (ctx->timeout_source);
+    if (ctx->poll_id)
+        mm_poll_scheduler_remove (mm_poll_scheduler_get (), ctx->poll_id);
     g_free (ctx);
 }
 
@@ -1146,6 +1152,8 @@ periodic_registration_checks_ready (MMIfaceModemCdma *self,
                                     GAsyncResult *res)
 {
     RegistrationCheckContext *ctx;
+    MMModemCdmaRegistrationState cdma1x_state = MM_MODEM_CDMA_REGISTRATION_STATE_UNKNOWN;
+    MMModemCdmaRegistrationState evdo_state = MM_MODEM_CDMA_REGISTRATION_STATE_UNKNOWN;
     GError *error = NULL;
 
     mm_iface_modem_cdma_run_registration_checks_finish (self, res, &error);
@@ -1156,11 +1164,21 @@ periodic_registration_checks_ready (MMIfaceModemCdma *self,
 
     /* Remove the running tag */
     ctx = g_object_get_qdata (G_OBJECT (self), registration_check_context_quark);
-    if (ctx)
-        ctx->running = FALSE;
+    if (!ctx)
+        return;
+    ctx->running = FALSE;
+
+    g_object_get (self,
+                  MM_IFACE_MODEM_CDMA_CDMA1X_REGISTRATION_STATE, &cdma1x_state,
+                  MM_IFACE_MODEM_CDMA_EVDO_REGISTRATION_STATE,   &evdo_state,
+                  NULL);
+    mm_poll_scheduler_report (mm_poll_scheduler_get (),
+                              ctx->poll_id,
+                              (cdma1x_state != ctx->previous_cdma1x_state ||
+                               evdo_state != ctx->previous_evdo_state));
 }
 
-static gboolean
+static void
 periodic_registration_check (MMIfaceModemCdma *self)
 {
     RegistrationCheckContext *ctx;
@@ -1169,12 +1187,15 @@ periodic_registration_check (MMIfaceModemCdma *self)
     ctx = g_object_get_qdata (G_OBJECT (self), registration_check_context_quark);
     if (!ctx->running) {
         ctx->running = TRUE;
+        g_object_get (self,
+                      MM_IFACE_MODEM_CDMA_CDMA1X_REGISTRATION_STATE, &ctx->previous_cdma1x_state,
+                      MM_IFACE_MODEM_CDMA_EVDO_REGISTRATION_STATE,   &ctx->previous_evdo_state,
+                      NULL);
         mm_iface_modem_cdma_run_registration_checks (
             self,
             (GAsyncReadyCallback)periodic_registration_checks_ready,
             NULL);
     }
-    return G_SOURCE_CONTINUE;
 }
 
 static void
@@ -1210,9 +1231,13 @@ periodic_registration_check_enable (MMIfaceModemCdma *self)
     /* Create context and keep it as object data */
     mm_dbg ("Periodic CDMA registration checks enabled");
     ctx = g_new0 (RegistrationCheckContext, 1);
-    ctx->timeout_source = g_timeout_add_seconds (REGISTRATION_CHECK_TIMEOUT_SEC,
-                                                 (GSourceFunc)periodic_registration_check,
-                                                 self);
+    ctx->poll_id = mm_poll_scheduler_add (mm_poll_scheduler_get (),
+                                          g_dbus_object_get_object_path (G_DBUS_OBJECT (self)),
+                                          "cdma-registration-check",
+                                          REGISTRATION_CHECK_TIMEOUT_SEC,
+                                          REGISTRATION_CHECK_MAX_TIMEOUT_SEC,
+                                          (MMPollSchedulerFunc)periodic_registration_check,
+                                          self);
     g_object_set_qdata_full (G_OBJECT (self),
                              registration_check_context_quark,
                              ctx,
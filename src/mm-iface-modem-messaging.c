@@ -363,6 +363,203 @@ handle_create (MmGdbusModemMessaging *skeleton,
 
 /*****************************************************************************/
 
+typedef struct {
+    MmGdbusModemMessaging *skeleton;
+    GDBusMethodInvocation *invocation;
+    MMIfaceModemMessaging *self;
+    MMSmsList *list;
+    gchar **paths;
+    guint current;
+    gboolean link_held;
+    GVariantBuilder results;
+    gint64 start_time;
+    gint64 message_start_time;
+    guint n_sent;
+    guint n_parts;
+} HandleSendManyContext;
+
+static void
+handle_send_many_context_free (HandleSendManyContext *ctx)
+{
+    g_variant_builder_clear (&ctx->results);
+    g_strfreev (ctx->paths);
+    if (ctx->list)
+        g_object_unref (ctx->list);
+    g_object_unref (ctx->skeleton);
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->self);
+    g_free (ctx);
+}
+
+static void
+send_many_add_result (HandleSendManyContext *ctx,
+                      guint n_parts,
+                      gint64 latency,
+                      gint64 duration,
+                      const GError *error)
+{
+    GVariantBuilder result;
+
+    g_variant_builder_init (&result, G_VARIANT_TYPE ("a{sv}"));
+    g_variant_builder_add (&result, "{sv}", "path",     g_variant_new_object_path (ctx->paths[ctx->current]));
+    g_variant_builder_add (&result, "{sv}", "parts",    g_variant_new_uint32 (n_parts));
+    g_variant_builder_add (&result, "{sv}", "latency",  g_variant_new_uint32 ((guint32) (latency / 1000)));
+    g_variant_builder_add (&result, "{sv}", "duration", g_variant_new_uint32 ((guint32) (duration / 1000)));
+    if (error)
+        g_variant_builder_add (&result, "{sv}", "error", g_variant_new_string (error->message));
+    g_variant_builder_add_value (&ctx->results, g_variant_builder_end (&result));
+}
+
+static void send_many_next (HandleSendManyContext *ctx);
+
+static void
+send_many_ready (MMBaseSms *sms,
+                 GAsyncResult *res,
+                 HandleSendManyContext *ctx)
+{
+    GError *error = NULL;
+    gint64 now;
+    guint n_parts = 0;
+
+    now = g_get_monotonic_time ();
+
+    if (!mm_base_sms_send_finish (sms, res, &error))
+        mm_dbg ("Couldn't send SMS '%s': %s", ctx->paths[ctx->current], error->message);
+    else {
+        n_parts = g_list_length (mm_base_sms_get_parts (sms));
+        ctx->n_sent++;
+        ctx->n_parts += n_parts;
+    }
+
+    send_many_add_result (ctx,
+                          n_parts,
+                          ctx->message_start_time - ctx->start_time,
+                          now - ctx->message_start_time,
+                          error);
+    if (error)
+        g_error_free (error);
+
+    ctx->current++;
+    send_many_next (ctx);
+}
+
+static void
+send_many_next (HandleSendManyContext *ctx)
+{
+    gdouble elapsed;
+
+    while (ctx->paths[ctx->current]) {
+        MMBaseSms *sms;
+        GError *error;
+
+        ctx->message_start_time = g_get_monotonic_time ();
+
+        sms = mm_sms_list_get_sms (ctx->list, ctx->paths[ctx->current]);
+        if (sms) {
+            mm_base_sms_send (sms,
+                              (GAsyncReadyCallback)send_many_ready,
+                              ctx);
+            return;
+        }
+
+        error = g_error_new (MM_CORE_ERROR,
+                             MM_CORE_ERROR_NOT_FOUND,
+                             "No SMS found with path '%s'",
+                             ctx->paths[ctx->current]);
+        send_many_add_result (ctx, 0, ctx->message_start_time - ctx->start_time, 0, error);
+        g_error_free (error);
+        ctx->current++;
+    }
+
+    if (ctx->link_held)
+        MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (ctx->self)->set_sms_link_hold (ctx->self, FALSE);
+
+    elapsed = (gdouble) (g_get_monotonic_time () - ctx->start_time) / G_USEC_PER_SEC;
+    mm_dbg ("Sent %u/%u SMS messages (%u parts) in %.2fs (%.2f parts/s)",
+            ctx->n_sent, ctx->current, ctx->n_parts, elapsed,
+            elapsed > 0 ? ctx->n_parts / elapsed : 0.0);
+
+    mm_gdbus_modem_messaging_complete_send_many (ctx->skeleton,
+                                                 ctx->invocation,
+                                                 g_variant_builder_end (&ctx->results));
+    handle_send_many_context_free (ctx);
+}
+
+static void
+handle_send_many_auth_ready (MMBaseModem *self,
+                             GAsyncResult *res,
+                             HandleSendManyContext *ctx)
+{
+    MMModemState modem_state = MM_MODEM_STATE_UNKNOWN;
+    GError *error = NULL;
+
+    if (!mm_base_modem_authorize_finish (self, res, &error)) {
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+        handle_send_many_context_free (ctx);
+        return;
+    }
+
+    g_object_get (self,
+                  MM_IFACE_MODEM_STATE, &modem_state,
+                  NULL);
+
+    if (modem_state < MM_MODEM_STATE_ENABLED) {
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_WRONG_STATE,
+                                               "Cannot send SMS: device not yet enabled");
+        handle_send_many_context_free (ctx);
+        return;
+    }
+
+    g_object_get (self,
+                  MM_IFACE_MODEM_MESSAGING_SMS_LIST, &ctx->list,
+                  NULL);
+    if (!ctx->list) {
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_WRONG_STATE,
+                                               "Cannot send SMS: missing SMS list");
+        handle_send_many_context_free (ctx);
+        return;
+    }
+
+    /* Keep the relay link open until the last message has been sent */
+    if (g_strv_length (ctx->paths) > 1 &&
+        MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (ctx->self)->set_sms_link_hold) {
+        MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (ctx->self)->set_sms_link_hold (ctx->self, TRUE);
+        ctx->link_held = TRUE;
+    }
+
+    send_many_next (ctx);
+}
+
+static gboolean
+handle_send_many (MmGdbusModemMessaging *skeleton,
+                  GDBusMethodInvocation *invocation,
+                  const gchar *const *paths,
+                  MMIfaceModemMessaging *self)
+{
+    HandleSendManyContext *ctx;
+
+    ctx = g_new0 (HandleSendManyContext, 1);
+    ctx->skeleton = g_object_ref (skeleton);
+    ctx->invocation = g_object_ref (invocation);
+    ctx->self = g_object_ref (self);
+    ctx->paths = g_strdupv ((gchar **)paths);
+    ctx->start_time = g_get_monotonic_time ();
+    g_variant_builder_init (&ctx->results, G_VARIANT_TYPE ("aa{sv}"));
+
+    mm_base_modem_authorize (MM_BASE_MODEM (self),
+                             invocation,
+                             MM_AUTHORIZATION_MESSAGING,
+                             (GAsyncReadyCallback)handle_send_many_auth_ready,
+                             ctx);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
 static gboolean
 handle_list (MmGdbusModemMessaging *skeleton,
              GDBusMethodInvocation *invocation,
@@ -1359,6 +1556,10 @@ interface_initialization_step (GTask *task)
                           "handle-list",
                           G_CALLBACK (handle_list),
                           self);
+        g_signal_connect (ctx->skeleton,
+                          "handle-send-many",
+                          G_CALLBACK (handle_send_many),
+                          self);
 
         /* Finally, export the new interface */
         mm_gdbus_object_skeleton_set_modem_messaging (MM_GDBUS_OBJECT_SKELETON (self),
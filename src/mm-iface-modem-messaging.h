@@ -79,6 +79,11 @@ struct _MMIfaceModemMessaging {
                                             GAsyncResult *res,
                                             GError **error);
 
+    /* Hold the relay link to the SMSC open between messages, or let it close
+     * again (optional) */
+    void (* set_sms_link_hold) (MMIfaceModemMessaging *self,
+                                gboolean hold);
+
     /* Setup SMS format (async) */
     void (* setup_sms_format) (MMIfaceModemMessaging *self,
                                GAsyncReadyCallback callback,
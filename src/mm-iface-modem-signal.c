@@ -20,6 +20,7 @@
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-signal.h"
 #include "mm-log.h"
+#include "mm-poll-scheduler.h"
 
 #define SUPPORT_CHECKED_TAG "signal-support-checked-tag"
 #define SUPPORTED_TAG       "signal-supported-tag"
@@ -41,14 +42,14 @@ mm_iface_modem_signal_bind_simple_status (MMIfaceModemSignal *self,
 
 typedef struct {
     guint rate;
-    guint timeout_source;
+    guint poll_id;
 } RefreshContext;
 
 static void
 refresh_context_free (RefreshContext *ctx)
 {
-    if (ctx->timeout_source)
-        g_source_remove (ctx->timeout_source);
+    if (ctx->poll_id)
+        mm_poll_scheduler_remove (mm_poll_scheduler_get (), ctx->poll_id);
     g_slice_free (RefreshContext, ctx);
 }
 
@@ -154,7 +155,7 @@ load_values_ready (MMIfaceModemSignal *self,
     g_object_unref (skeleton);
 }
 
-static gboolean
+static void
 refresh_context_cb (MMIfaceModemSignal *self)
 {
     MM_IFACE_MODEM_SIGNAL_GET_INTERFACE (self)->load_values (
@@ -162,7 +163,6 @@ refresh_context_cb (MMIfaceModemSignal *self)
         NULL,
         (GAsyncReadyCallback)load_values_ready,
         NULL);
-    return G_SOURCE_CONTINUE;
 }
 
 static void
@@ -238,9 +238,16 @@ setup_refresh_context (MMIfaceModemSignal *self,
     /* Update refresh context */
     mm_dbg ("Extended signal information reporting enabled (rate: %u seconds)", new_rate);
     ctx->rate = new_rate;
-    if (ctx->timeout_source)
-        g_source_remove (ctx->timeout_source);
-    ctx->timeout_source = g_timeout_add_seconds (ctx->rate, (GSourceFunc) refresh_context_cb, self);
+    if (ctx->poll_id)
+        mm_poll_scheduler_set_interval (mm_poll_scheduler_get (), ctx->poll_id, ctx->rate, 0);
+    else
+        ctx->poll_id = mm_poll_scheduler_add (mm_poll_scheduler_get (),
+                                              g_dbus_object_get_object_path (G_DBUS_OBJECT (self)),
+                                              "extended-signal",
+                                              ctx->rate,
+                                              0,
+                                              (MMPollSchedulerFunc) refresh_context_cb,
+                                              self);
 
     /* Also launch right away */
     refresh_context_cb (self);
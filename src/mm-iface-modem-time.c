@@ -20,6 +20,7 @@
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-time.h"
 #include "mm-log.h"
+#include "mm-poll-scheduler.h"
 
 #define SUPPORT_CHECKED_TAG          "time-support-checked-tag"
 #define SUPPORTED_TAG                "time-supported-tag"
@@ -145,11 +146,12 @@ network_timezone_context_free (NetworkTimezoneContext *ctx)
      * in stop_network_timezone() when the logic is disabled (or will be done
      * automatically when the last modem object reference is dropped) */
     if (ctx->network_timezone_poll_id)
-        g_source_remove (ctx->network_timezone_poll_id);
+        mm_poll_scheduler_remove (mm_poll_scheduler_get (), ctx->network_timezone_poll_id);
     g_free (ctx);
 }
 
-static gboolean network_timezone_poll_cb (MMIfaceModemTime *self);
+static void  network_timezone_poll_cb    (MMIfaceModemTime *self);
+static guint network_timezone_poll_add   (MMIfaceModemTime *self);
 
 static void
 update_network_timezone_dictionary (MMIfaceModemTime *self,
@@ -203,9 +205,7 @@ load_network_timezone_ready (MMIfaceModemTime *self,
         }
 
         /* Otherwise, relaunch timeout to query a bit later */
-        ctx->network_timezone_poll_id = g_timeout_add_seconds (NETWORK_TIMEZONE_POLL_INTERVAL_SEC,
-                                                               (GSourceFunc)network_timezone_poll_cb,
-                                                               self);
+        ctx->network_timezone_poll_id = network_timezone_poll_add (self);
         return;
     }
 
@@ -214,20 +214,32 @@ load_network_timezone_ready (MMIfaceModemTime *self,
     g_object_unref (tz);
 }
 
-static gboolean
+static void
 network_timezone_poll_cb (MMIfaceModemTime *self)
 {
     NetworkTimezoneContext *ctx;
 
+    /* Single shot */
     ctx = (NetworkTimezoneContext *) g_object_get_qdata (G_OBJECT (self), network_timezone_context_quark);
+    mm_poll_scheduler_remove (mm_poll_scheduler_get (), ctx->network_timezone_poll_id);
     ctx->network_timezone_poll_id = 0;
 
     MM_IFACE_MODEM_TIME_GET_INTERFACE (self)->load_network_timezone (
         self,
         (GAsyncReadyCallback)load_network_timezone_ready,
         NULL);
+}
 
-    return G_SOURCE_REMOVE;
+static guint
+network_timezone_poll_add (MMIfaceModemTime *self)
+{
+    return mm_poll_scheduler_add (mm_poll_scheduler_get (),
+                                  g_dbus_object_get_object_path (G_DBUS_OBJECT (self)),
+                                  "network-timezone",
+                                  NETWORK_TIMEZONE_POLL_INTERVAL_SEC,
+                                  0,
+                                  (MMPollSchedulerFunc)network_timezone_poll_cb,
+                                  self);
 }
 
 static void
@@ -239,7 +251,7 @@ start_network_timezone_poll (MMIfaceModemTime *self)
 
     mm_dbg ("Network timezone polling started");
     ctx->network_timezone_poll_retries = NETWORK_TIMEZONE_POLL_RETRIES;
-    ctx->network_timezone_poll_id = g_timeout_add_seconds (NETWORK_TIMEZONE_POLL_INTERVAL_SEC, (GSourceFunc)network_timezone_poll_cb, self);
+    ctx->network_timezone_poll_id = network_timezone_poll_add (self);
 }
 
 static void
@@ -251,7 +263,7 @@ stop_network_timezone_poll (MMIfaceModemTime *self)
 
     if (ctx->network_timezone_poll_id) {
         mm_dbg ("Network timezone polling stopped");
-        g_source_remove (ctx->network_timezone_poll_id);
+        mm_poll_scheduler_remove (mm_poll_scheduler_get (), ctx->network_timezone_poll_id);
         ctx->network_timezone_poll_id = 0;
     }
 }
@@ -28,22 +28,28 @@
 #include "mm-bearer-list.h"
 #include "mm-log.h"
 #include "mm-context.h"
+#include "mm-poll-scheduler.h"
 
 #define SIGNAL_QUALITY_RECENT_TIMEOUT_SEC 60
 
 #define SIGNAL_CHECK_INITIAL_RETRIES      5
 #define SIGNAL_CHECK_INITIAL_TIMEOUT_SEC  3
 #define SIGNAL_CHECK_TIMEOUT_SEC          30
+/* Back off while values don't change, but poll before they're no longer
+ * recent */
+#define SIGNAL_CHECK_MAX_TIMEOUT_SEC      50
 
 #define STATE_UPDATE_CONTEXT_TAG          "state-update-context-tag"
 #define SIGNAL_QUALITY_UPDATE_CONTEXT_TAG "signal-quality-update-context-tag"
 #define SIGNAL_CHECK_CONTEXT_TAG          "signal-check-context-tag"
 #define RESTART_INITIALIZE_IDLE_TAG       "restart-initialize-tag"
+#define FRESHNESS_TAG                     "freshness-tag"
 
 static GQuark state_update_context_quark;
 static GQuark signal_quality_update_context_quark;
 static GQuark signal_check_context_quark;
 static GQuark restart_initialize_idle_quark;
+static GQuark freshness_quark;
 
 /*****************************************************************************/
 
@@ -811,6 +817,67 @@ handle_command (MmGdbusModem *skeleton,
 
 /*****************************************************************************/
 
+typedef struct {
+    MmGdbusModem *skeleton;
+    GDBusMethodInvocation *invocation;
+    MMIfaceModem *self;
+} HandleGetPortStatsContext;
+
+static void
+handle_get_port_stats_context_free (HandleGetPortStatsContext *ctx)
+{
+    g_object_unref (ctx->skeleton);
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->self);
+    g_free (ctx);
+}
+
+static void
+handle_get_port_stats_auth_ready (MMBaseModem *self,
+                                  GAsyncResult *res,
+                                  HandleGetPortStatsContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!mm_base_modem_authorize_finish (self, res, &error))
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+    /* Not part of the stable API, so only in debug mode */
+    else if (!mm_context_get_debug ())
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_UNAUTHORIZED,
+                                               "Cannot get port statistics: "
+                                               "operation only allowed in debug mode");
+    else
+        mm_gdbus_modem_complete_get_port_stats (ctx->skeleton,
+                                                ctx->invocation,
+                                                mm_base_modem_get_port_stats (self));
+
+    handle_get_port_stats_context_free (ctx);
+}
+
+static gboolean
+handle_get_port_stats (MmGdbusModem *skeleton,
+                       GDBusMethodInvocation *invocation,
+                       MMIfaceModem *self)
+{
+    HandleGetPortStatsContext *ctx;
+
+    ctx = g_new (HandleGetPortStatsContext, 1);
+    ctx->skeleton = g_object_ref (skeleton);
+    ctx->invocation = g_object_ref (invocation);
+    ctx->self = g_object_ref (self);
+
+    mm_base_modem_authorize (MM_BASE_MODEM (self),
+                             invocation,
+                             MM_AUTHORIZATION_DEVICE_CONTROL,
+                             (GAsyncReadyCallback)handle_get_port_stats_auth_ready,
+                             ctx);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
 typedef struct {
     MmGdbusModem *skeleton;
     GDBusMethodInvocation *invocation;
@@ -959,6 +1026,53 @@ handle_list_bearers (MmGdbusModem *skeleton,
 
 /*****************************************************************************/
 
+static MMFreshness *
+get_freshness (MMIfaceModem *self)
+{
+    MMFreshness *freshness;
+
+    if (G_UNLIKELY (!freshness_quark))
+        freshness_quark = g_quark_from_static_string (FRESHNESS_TAG);
+
+    freshness = g_object_get_qdata (G_OBJECT (self), freshness_quark);
+    if (!freshness) {
+        freshness = mm_freshness_new (mm_context_get_poll_stale_deadline ());
+        /* Unsolicited updates must not delay the poll so much that the
+         * signal quality is no longer recent */
+        mm_freshness_set_expiry (freshness,
+                                 MM_FRESHNESS_PROPERTY_SIGNAL_QUALITY,
+                                 SIGNAL_QUALITY_RECENT_TIMEOUT_SEC,
+                                 SIGNAL_CHECK_MAX_TIMEOUT_SEC);
+        g_object_set_qdata_full (G_OBJECT (self), freshness_quark,
+                                 freshness, (GDestroyNotify) mm_freshness_free);
+    }
+
+    return freshness;
+}
+
+void
+mm_iface_modem_update_freshness (MMIfaceModem        *self,
+                                 MMFreshnessProperty  property)
+{
+    mm_freshness_update (get_freshness (self), property, g_get_monotonic_time ());
+}
+
+void
+mm_iface_modem_clear_freshness (MMIfaceModem        *self,
+                                MMFreshnessProperty  property)
+{
+    mm_freshness_clear (get_freshness (self), property);
+}
+
+gboolean
+mm_iface_modem_is_fresh (MMIfaceModem        *self,
+                         MMFreshnessProperty  property)
+{
+    return mm_freshness_is_fresh (get_freshness (self), property, g_get_monotonic_time ());
+}
+
+/*****************************************************************************/
+
 void
 mm_iface_modem_update_access_technologies (MMIfaceModem *self,
                                            MMModemAccessTechnology new_access_tech,
@@ -977,6 +1091,7 @@ mm_iface_modem_update_access_technologies (MMIfaceModem *self,
         return;
 
     old_access_tech = mm_gdbus_modem_get_access_technologies (skeleton);
+    mm_iface_modem_update_freshness (self, MM_FRESHNESS_PROPERTY_ACCESS_TECHNOLOGIES);
 
     /* Build the new access tech */
     built_access_tech = old_access_tech;
@@ -1125,6 +1240,7 @@ void
 mm_iface_modem_update_signal_quality (MMIfaceModem *self,
                                       guint signal_quality)
 {
+    mm_iface_modem_update_freshness (self, MM_FRESHNESS_PROPERTY_SIGNAL_QUALITY);
     update_signal_quality (self, signal_quality, TRUE);
 }
 
@@ -1143,13 +1259,22 @@ typedef struct {
     gboolean enabled;
     guint    interval;
     guint    initial_retries;
-    guint    timeout_source;
+    guint    poll_id;
 
     /* Values polled in this iteration */
     guint                   signal_quality;
     MMModemAccessTechnology access_technologies;
     guint                   access_technologies_mask;
 
+    /* Values polled in the previous iteration, to back off while they don't
+     * change */
+    guint                   previous_signal_quality;
+    MMModemAccessTechnology previous_access_technologies;
+
+    /* Values recently updated, not polled in this iteration */
+    gboolean signal_quality_fresh;
+    gboolean access_technologies_fresh;
+
     /* If both these are unset we'll automatically stop polling */
     gboolean signal_quality_polling_supported;
     gboolean access_technology_polling_supported;
@@ -1161,8 +1286,8 @@ typedef struct {
 static void
 signal_check_context_free (SignalCheckContext *ctx)
 {
-    if (ctx->timeout_source)
-        g_source_remove (ctx->timeout_source);
+    if (ctx->poll_id)
+        mm_poll_scheduler_remove (mm_poll_scheduler_get (), ctx->poll_id);
     g_slice_free (SignalCheckContext, ctx);
 }
 
@@ -1203,7 +1328,7 @@ get_signal_check_context (MMIfaceModem *self)
 
 static void     periodic_signal_check_disable (MMIfaceModem *self,
                                                gboolean      clear);
-static gboolean periodic_signal_check_cb      (MMIfaceModem *self);
+static void     periodic_signal_check_cb      (MMIfaceModem *self);
 static void     peridic_signal_check_step     (MMIfaceModem *self);
 
 static void
@@ -1258,8 +1383,10 @@ signal_quality_check_ready (MMIfaceModem *self,
         g_error_free (error);
     }
     /* We may have been disabled while this command was running. */
-    else if (ctx->enabled)
+    else if (ctx->enabled) {
+        mm_iface_modem_update_freshness (self, MM_FRESHNESS_PROPERTY_SIGNAL_QUALITY);
         update_signal_quality (self, ctx->signal_quality, TRUE);
+    }
 
     /* Go on */
     ctx->running_step++;
@@ -1271,6 +1398,7 @@ peridic_signal_check_step (MMIfaceModem *self)
 {
     gboolean periodic_signal_check_disabled = FALSE;
     SignalCheckContext *ctx;
+    guint previous_interval;
 
     ctx = get_signal_check_context (self);
 
@@ -1283,7 +1411,7 @@ peridic_signal_check_step (MMIfaceModem *self)
         ctx->running_step++;
 
     case SIGNAL_CHECK_STEP_SIGNAL_QUALITY:
-        if (ctx->enabled && ctx->signal_quality_polling_supported) {
+        if (ctx->enabled && ctx->signal_quality_polling_supported && !ctx->signal_quality_fresh) {
             MM_IFACE_MODEM_GET_INTERFACE (self)->load_signal_quality (
                 self, (GAsyncReadyCallback)signal_quality_check_ready, NULL);
             return;
@@ -1292,7 +1420,7 @@ peridic_signal_check_step (MMIfaceModem *self)
         ctx->running_step++;
 
     case SIGNAL_CHECK_STEP_ACCESS_TECHNOLOGIES:
-        if (ctx->enabled && ctx->access_technology_polling_supported) {
+        if (ctx->enabled && ctx->access_technology_polling_supported && !ctx->access_technologies_fresh) {
             MM_IFACE_MODEM_GET_INTERFACE (self)->load_access_technologies (
                 self, (GAsyncReadyCallback)access_technologies_check_ready, NULL);
             return;
@@ -1316,6 +1444,7 @@ peridic_signal_check_step (MMIfaceModem *self)
          * quality and access technology values. As soon as we get them, OR if
          * we made too many retries at a high frequency, we fallback to the
          * slower polling. */
+        previous_interval = ctx->interval;
         if (ctx->interval == SIGNAL_CHECK_INITIAL_TIMEOUT_SEC) {
             gboolean signal_quality_ready;
             gboolean access_technology_ready;
@@ -1352,14 +1481,27 @@ peridic_signal_check_step (MMIfaceModem *self)
             return;
         }
 
-        mm_dbg ("Periodic signal quality checks scheduled in %ds", ctx->interval);
-        g_assert (!ctx->timeout_source);
-        ctx->timeout_source = g_timeout_add_seconds (ctx->interval, (GSourceFunc) periodic_signal_check_cb, self);
+        /* Switch to the slower polling, backing off while the values don't
+         * change */
+        if (ctx->interval != previous_interval) {
+            mm_dbg ("Periodic signal quality checks scheduled every %ds", ctx->interval);
+            mm_poll_scheduler_set_interval (mm_poll_scheduler_get (),
+                                            ctx->poll_id,
+                                            SIGNAL_CHECK_TIMEOUT_SEC,
+                                            SIGNAL_CHECK_MAX_TIMEOUT_SEC);
+        } else {
+            mm_poll_scheduler_report (mm_poll_scheduler_get (),
+                                      ctx->poll_id,
+                                      (ctx->signal_quality != ctx->previous_signal_quality ||
+                                       ctx->access_technologies != ctx->previous_access_technologies));
+        }
+        ctx->previous_signal_quality = ctx->signal_quality;
+        ctx->previous_access_technologies = ctx->access_technologies;
         return;
     }
 }
 
-static gboolean
+static void
 periodic_signal_check_cb (MMIfaceModem *self)
 {
     SignalCheckContext *ctx;
@@ -1367,17 +1509,35 @@ periodic_signal_check_cb (MMIfaceModem *self)
     ctx = get_signal_check_context (self);
     g_assert (ctx->enabled);
 
-    /* Start the sequence */
+    /* Don't start a new sequence if the previous one is still running */
+    if (ctx->running_step != SIGNAL_CHECK_STEP_NONE)
+        return;
+
+    /* Once the initial checks are done, only poll the values that haven't
+     * been updated recently, either by a previous poll or by unsolicited
+     * messages */
+    ctx->signal_quality_fresh = FALSE;
+    ctx->access_technologies_fresh = FALSE;
+    if (ctx->interval != SIGNAL_CHECK_INITIAL_TIMEOUT_SEC) {
+        ctx->signal_quality_fresh = (!ctx->signal_quality_polling_supported ||
+                                     mm_iface_modem_is_fresh (self, MM_FRESHNESS_PROPERTY_SIGNAL_QUALITY));
+        ctx->access_technologies_fresh = (!ctx->access_technology_polling_supported ||
+                                          mm_iface_modem_is_fresh (self, MM_FRESHNESS_PROPERTY_ACCESS_TECHNOLOGIES));
+        if (ctx->signal_quality_fresh && ctx->access_technologies_fresh) {
+            mm_poll_scheduler_skip (mm_poll_scheduler_get (), ctx->poll_id);
+            return;
+        }
+    }
+
+    /* Start the sequence; values not polled are kept as in the previous
+     * iteration */
     ctx->running_step             = SIGNAL_CHECK_STEP_FIRST;
-    ctx->signal_quality           = 0;
-    ctx->access_technologies      = MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN;
+    ctx->signal_quality           = ctx->signal_quality_fresh ? ctx->previous_signal_quality : 0;
+    ctx->access_technologies      = (ctx->access_technologies_fresh ?
+                                     ctx->previous_access_technologies :
+                                     MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN);
     ctx->access_technologies_mask = MM_MODEM_ACCESS_TECHNOLOGY_ANY;
     peridic_signal_check_step (self);
-
-    /* Remove the timeout and clear the source id */
-    if (ctx->timeout_source)
-        ctx->timeout_source = 0;
-    return G_SOURCE_REMOVE;
 }
 
 void
@@ -1400,17 +1560,21 @@ mm_iface_modem_refresh_signal (MMIfaceModem *self)
 
     mm_dbg ("Periodic signal check refresh requested");
 
-    /* Remove the scheduled timeout as we're going to refresh
-     * right away */
-    if (ctx->timeout_source) {
-        g_source_remove (ctx->timeout_source);
-        ctx->timeout_source = 0;
-    }
-
     /* Reset refresh rate and initial retries when we're asked to refresh signal
-     * so that we poll at a higher frequency */
+     * so that we poll at a higher frequency; the scheduled check is restarted
+     * as we're going to refresh right away */
     ctx->interval        = SIGNAL_CHECK_INITIAL_TIMEOUT_SEC;
     ctx->initial_retries = SIGNAL_CHECK_INITIAL_RETRIES;
+    if (ctx->poll_id)
+        mm_poll_scheduler_set_interval (mm_poll_scheduler_get (), ctx->poll_id, ctx->interval, 0);
+    else
+        ctx->poll_id = mm_poll_scheduler_add (mm_poll_scheduler_get (),
+                                              g_dbus_object_get_object_path (G_DBUS_OBJECT (self)),
+                                              "signal-check",
+                                              ctx->interval,
+                                              0,
+                                              (MMPollSchedulerFunc) periodic_signal_check_cb,
+                                              self);
 
     /* Start sequence */
     periodic_signal_check_cb (self);
@@ -1432,12 +1596,14 @@ periodic_signal_check_disable (MMIfaceModem *self,
         mm_iface_modem_update_access_technologies (self,
                                                    MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN,
                                                    MM_MODEM_ACCESS_TECHNOLOGY_ANY);
+        mm_iface_modem_clear_freshness (self, MM_FRESHNESS_PROPERTY_SIGNAL_QUALITY);
+        mm_iface_modem_clear_freshness (self, MM_FRESHNESS_PROPERTY_ACCESS_TECHNOLOGIES);
     }
 
-    /* Remove scheduled timeout */
-    if (ctx->timeout_source) {
-        g_source_remove (ctx->timeout_source);
-        ctx->timeout_source = 0;
+    /* Remove scheduled check */
+    if (ctx->poll_id) {
+        mm_poll_scheduler_remove (mm_poll_scheduler_get (), ctx->poll_id);
+        ctx->poll_id = 0;
     }
 
     ctx->enabled = FALSE;
@@ -5109,6 +5275,7 @@ interface_initialization_step (GTask *task)
                           "signal::handle-factory-reset",            G_CALLBACK (handle_factory_reset),            self,
                           "signal::handle-create-bearer",            G_CALLBACK (handle_create_bearer),            self,
                           "signal::handle-command",                  G_CALLBACK (handle_command),                  self,
+                          "signal::handle-get-port-stats",           G_CALLBACK (handle_get_port_stats),           self,
                           "signal::handle-delete-bearer",            G_CALLBACK (handle_delete_bearer),            self,
                           "signal::handle-list-bearers",             G_CALLBACK (handle_list_bearers),             self,
                           "signal::handle-enable",                   G_CALLBACK (handle_enable),                   self,
@@ -26,6 +26,7 @@
 #include "mm-port-serial-at.h"
 #include "mm-base-bearer.h"
 #include "mm-base-sim.h"
+#include "mm-freshness.h"
 
 #define MM_TYPE_IFACE_MODEM            (mm_iface_modem_get_type ())
 #define MM_IFACE_MODEM(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), MM_TYPE_IFACE_MODEM, MMIfaceModem))
@@ -501,6 +502,15 @@ void mm_iface_modem_update_signal_quality (MMIfaceModem *self,
 /* Allow requesting to refresh signal via polling */
 void mm_iface_modem_refresh_signal (MMIfaceModem *self);
 
+/* Allow timestamping the values updated both by polling and by unsolicited
+ * messages, so that periodic checks only poll the stale ones */
+void     mm_iface_modem_update_freshness (MMIfaceModem        *self,
+                                          MMFreshnessProperty  property);
+void     mm_iface_modem_clear_freshness  (MMIfaceModem        *self,
+                                          MMFreshnessProperty  property);
+gboolean mm_iface_modem_is_fresh         (MMIfaceModem        *self,
+                                          MMFreshnessProperty  property);
+
 /* Allow setting allowed modes */
 void     mm_iface_modem_set_current_modes        (MMIfaceModem *self,
                                                   MMModemMode allowed,
@@ -50,7 +50,7 @@ enum {
 
 static gboolean ts_flags = TS_FLAG_NONE;
 static guint32 log_level = MM_LOG_LEVEL_INFO | MM_LOG_LEVEL_WARN | MM_LOG_LEVEL_ERR;
-static GTimeVal rel_start = { 0, 0 };
+static gint64 rel_start = 0;
 static int logfd = -1;
 static gboolean append_log_level_text = TRUE;
 
@@ -73,8 +73,188 @@ static const LogDesc level_descs[] = {
     { 0, NULL }
 };
 
-static GString *msgbuf = NULL;
-static volatile gsize msgbuf_once = 0;
+/* Each thread formats its messages in its own buffer */
+static void
+msgbuf_free (GString *msgbuf)
+{
+    g_string_free (msgbuf, TRUE);
+}
+
+static GPrivate msgbuf_private = G_PRIVATE_INIT ((GDestroyNotify) msgbuf_free);
+
+/*****************************************************************************/
+/* Asynchronous writer
+ *
+ * Formatted messages are pushed to a lock-free LIFO list, which the writer
+ * thread takes as a whole and writes (in FIFO order) to the backend, so that
+ * slow backends (fsync-ed files, syslog, journal) never block the producers.
+ * The writer mutex is only used to let the writer sleep while there is nothing
+ * to write.
+ */
+
+typedef struct _LogEntry LogEntry;
+struct _LogEntry {
+    LogEntry   *next;
+    const char *loc;  /* G_STRLOC, static */
+    const char *func; /* G_STRFUNC, static */
+    int         syslog_level;
+    gsize       length;
+    char        message[1];
+};
+
+static LogEntry *volatile queue = NULL;
+
+static GThread  *writer;
+static GMutex    writer_mutex;
+static GCond     writer_cond;
+static gint      writer_idle;
+static gboolean  writer_exiting;
+
+/* Held while writing to the backend */
+static GMutex    backend_mutex;
+
+static LogEntry *
+log_entry_new (const char *loc,
+               const char *func,
+               int syslog_level,
+               const char *message,
+               gsize length)
+{
+    LogEntry *entry;
+
+    entry = g_malloc (G_STRUCT_OFFSET (LogEntry, message) + length + 1);
+    entry->next = NULL;
+    entry->loc = loc;
+    entry->func = func;
+    entry->syslog_level = syslog_level;
+    entry->length = length;
+    memcpy (entry->message, message, length);
+    entry->message[length] = '\0';
+    return entry;
+}
+
+static void
+log_queue_push (LogEntry *entry)
+{
+    LogEntry *head;
+
+    do {
+        head = g_atomic_pointer_get (&queue);
+        entry->next = head;
+    } while (!g_atomic_pointer_compare_and_exchange (&queue, head, entry));
+
+    /* Wake up the writer if it's waiting for messages */
+    if (g_atomic_int_get (&writer_idle)) {
+        g_mutex_lock (&writer_mutex);
+        g_cond_signal (&writer_cond);
+        g_mutex_unlock (&writer_mutex);
+    }
+}
+
+static LogEntry *
+log_queue_take_all (void)
+{
+    LogEntry *head;
+    LogEntry *reversed = NULL;
+
+    do {
+        head = g_atomic_pointer_get (&queue);
+    } while (head && !g_atomic_pointer_compare_and_exchange (&queue, head, NULL));
+
+    /* Pushed in LIFO order, so reverse */
+    while (head) {
+        LogEntry *next;
+
+        next = head->next;
+        head->next = reversed;
+        reversed = head;
+        head = next;
+    }
+    return reversed;
+}
+
+/* Writes whatever is pending. The list is taken with the backend mutex held,
+ * so that a batch taken by the writer can't be overtaken by a later one */
+static gboolean
+log_write_pending (void)
+{
+    LogEntry *entries;
+
+    g_mutex_lock (&backend_mutex);
+    entries = log_queue_take_all ();
+    if (!entries) {
+        g_mutex_unlock (&backend_mutex);
+        return FALSE;
+    }
+
+    while (entries) {
+        LogEntry *next;
+
+        next = entries->next;
+        log_backend (entries->loc, entries->func, entries->syslog_level, entries->message, entries->length);
+        g_free (entries);
+        entries = next;
+    }
+    /* Make sure output is dumped to disk, once per batch */
+    if (logfd >= 0)
+        fsync (logfd);
+    g_mutex_unlock (&backend_mutex);
+    return TRUE;
+}
+
+/* Writes synchronously whatever is pending, e.g. before aborting */
+static void
+log_flush (void)
+{
+    log_write_pending ();
+}
+
+static gpointer
+log_writer_thread (gpointer unused)
+{
+    while (TRUE) {
+        gboolean exiting;
+
+        if (log_write_pending ())
+            continue;
+
+        g_mutex_lock (&writer_mutex);
+        g_atomic_int_set (&writer_idle, TRUE);
+        while (!g_atomic_pointer_get (&queue) && !writer_exiting)
+            g_cond_wait (&writer_cond, &writer_mutex);
+        g_atomic_int_set (&writer_idle, FALSE);
+        exiting = writer_exiting;
+        g_mutex_unlock (&writer_mutex);
+
+        if (exiting && !g_atomic_pointer_get (&queue))
+            break;
+    }
+
+    return NULL;
+}
+
+static void
+log_emit (const char *loc,
+          const char *func,
+          int syslog_level,
+          const char *message,
+          gsize length,
+          gboolean flush)
+{
+    /* No writer yet (or any more), write right away */
+    if (!writer) {
+        g_mutex_lock (&backend_mutex);
+        log_backend (loc, func, syslog_level, message, length);
+        if (logfd >= 0)
+            fsync (logfd);
+        g_mutex_unlock (&backend_mutex);
+        return;
+    }
+
+    log_queue_push (log_entry_new (loc, func, syslog_level, message, length));
+    if (flush)
+        log_flush ();
+}
 
 static int
 mm_to_syslog_priority (MMLogLevel level)
@@ -139,8 +319,6 @@ log_backend_file (const char *loc,
     ssize_t ign;
     ign = write (logfd, message, length);
     if (ign) {} /* whatever; really shut up about unused result */
-
-    fsync (logfd);  /* Make sure output is dumped to disk immediately  */
 }
 
 static void
@@ -190,6 +368,36 @@ log_backend_systemd_journal (const char *loc,
 }
 #endif
 
+static void
+append_timestamp (GString *msgbuf)
+{
+    gint64 now;
+
+    if (ts_flags == TS_FLAG_WALL) {
+        now = g_get_real_time ();
+        g_string_append_printf (msgbuf, "[%09" G_GINT64_FORMAT ".%06" G_GINT64_FORMAT "] ",
+                                now / G_USEC_PER_SEC, now % G_USEC_PER_SEC);
+    } else if (ts_flags == TS_FLAG_REL) {
+        now = g_get_real_time () - rel_start;
+        g_string_append_printf (msgbuf, "[%06" G_GINT64_FORMAT ".%06" G_GINT64_FORMAT "] ",
+                                now / G_USEC_PER_SEC, now % G_USEC_PER_SEC);
+    }
+}
+
+static GString *
+msgbuf_get (void)
+{
+    GString *msgbuf;
+
+    msgbuf = g_private_get (&msgbuf_private);
+    if (!msgbuf) {
+        msgbuf = g_string_sized_new (512);
+        g_private_set (&msgbuf_private, msgbuf);
+    } else
+        g_string_truncate (msgbuf, 0);
+    return msgbuf;
+}
+
 void
 _mm_log (const char *loc,
          const char *func,
@@ -198,37 +406,17 @@ _mm_log (const char *loc,
          ...)
 {
     va_list args;
-    GTimeVal tv;
+    GString *msgbuf;
 
     if (!(log_level & level))
         return;
 
-    if (g_once_init_enter (&msgbuf_once)) {
-        msgbuf = g_string_sized_new (512);
-        g_once_init_leave (&msgbuf_once, 1);
-    } else
-        g_string_truncate (msgbuf, 0);
+    msgbuf = msgbuf_get ();
 
     if (append_log_level_text)
         g_string_append_printf (msgbuf, "%s ", log_level_description (level));
 
-    if (ts_flags == TS_FLAG_WALL) {
-        g_get_current_time (&tv);
-        g_string_append_printf (msgbuf, "[%09ld.%06ld] ", tv.tv_sec, tv.tv_usec);
-    } else if (ts_flags == TS_FLAG_REL) {
-        glong secs;
-        glong usecs;
-
-        g_get_current_time (&tv);
-        secs = tv.tv_sec - rel_start.tv_sec;
-        usecs = tv.tv_usec - rel_start.tv_usec;
-        if (usecs < 0) {
-            secs--;
-            usecs += 1000000;
-        }
-
-        g_string_append_printf (msgbuf, "[%06ld.%06ld] ", secs, usecs);
-    }
+    append_timestamp (msgbuf);
 
 #if defined MM_LOG_FUNC_LOC
     g_string_append_printf (msgbuf, "[%s] %s(): ", loc, func);
@@ -240,16 +428,155 @@ _mm_log (const char *loc,
 
     g_string_append_c (msgbuf, '\n');
 
-    log_backend (loc, func, mm_to_syslog_priority (level), msgbuf->str, msgbuf->len);
+    /* Errors are written right away, as they may precede a crash */
+    log_emit (loc, func, mm_to_syslog_priority (level), msgbuf->str, msgbuf->len,
+              level == MM_LOG_LEVEL_ERR);
+}
+
+/*****************************************************************************/
+/* Per-owner trace ring buffers */
+
+typedef struct {
+    gchar *lines[MM_LOG_TRACE_RING_SIZE];
+    guint  next;
+} TraceRing;
+
+static GMutex      trace_mutex;
+static GHashTable *trace_rings;
+
+static void
+trace_ring_free (TraceRing *ring)
+{
+    guint i;
+
+    for (i = 0; i < MM_LOG_TRACE_RING_SIZE; i++)
+        g_free (ring->lines[i]);
+    g_slice_free (TraceRing, ring);
+}
+
+static void
+trace_ring_add (const char *owner,
+                const char *line)
+{
+    TraceRing *ring;
+    gchar     *stored;
+    gint64     now;
+
+    now = g_get_real_time ();
+    stored = g_strdup_printf ("[%09" G_GINT64_FORMAT ".%06" G_GINT64_FORMAT "] %s",
+                              now / G_USEC_PER_SEC, now % G_USEC_PER_SEC, line);
+
+    g_mutex_lock (&trace_mutex);
+    if (G_UNLIKELY (!trace_rings))
+        trace_rings = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) trace_ring_free);
+
+    ring = g_hash_table_lookup (trace_rings, owner);
+    if (!ring) {
+        ring = g_slice_new0 (TraceRing);
+        g_hash_table_insert (trace_rings, g_strdup (owner), ring);
+    }
+
+    g_free (ring->lines[ring->next]);
+    ring->lines[ring->next] = stored;
+    ring->next = (ring->next + 1) % MM_LOG_TRACE_RING_SIZE;
+    g_mutex_unlock (&trace_mutex);
+}
+
+static void
+trace_ring_dump (const char *owner,
+                 TraceRing *ring)
+{
+    GString *msgbuf;
+    guint    i;
+
+    msgbuf = msgbuf_get ();
+    g_string_append_printf (msgbuf, "(%s) recent traces:\n", owner);
+    log_emit (NULL, NULL, LOG_NOTICE, msgbuf->str, msgbuf->len, FALSE);
+
+    for (i = 0; i < MM_LOG_TRACE_RING_SIZE; i++) {
+        const gchar *line;
+
+        line = ring->lines[(ring->next + i) % MM_LOG_TRACE_RING_SIZE];
+        if (!line)
+            continue;
+
+        g_string_truncate (msgbuf, 0);
+        g_string_append_printf (msgbuf, "(%s) %s\n", owner, line);
+        log_emit (NULL, NULL, LOG_NOTICE, msgbuf->str, msgbuf->len, FALSE);
+    }
+}
+
+void
+_mm_log_trace (const char *loc,
+               const char *func,
+               const char *owner,
+               const char *fmt,
+               ...)
+{
+    va_list args;
+    gchar *line;
+
+    /* Nothing to do if neither logged nor kept */
+    if (!owner && !(log_level & MM_LOG_LEVEL_DEBUG))
+        return;
+
+    va_start (args, fmt);
+    line = g_strdup_vprintf (fmt, args);
+    va_end (args);
+
+    if (owner)
+        trace_ring_add (owner, line);
+
+    if (log_level & MM_LOG_LEVEL_DEBUG)
+        _mm_log (loc, func, MM_LOG_LEVEL_DEBUG, "%s", line);
+
+    g_free (line);
 }
 
+void
+mm_log_trace_dump (const char *owner)
+{
+    g_mutex_lock (&trace_mutex);
+    if (trace_rings) {
+        if (owner) {
+            TraceRing *ring;
+
+            ring = g_hash_table_lookup (trace_rings, owner);
+            if (ring)
+                trace_ring_dump (owner, ring);
+        } else {
+            GHashTableIter iter;
+            gpointer       key;
+            gpointer       value;
+
+            g_hash_table_iter_init (&iter, trace_rings);
+            while (g_hash_table_iter_next (&iter, &key, &value))
+                trace_ring_dump ((const char *) key, (TraceRing *) value);
+        }
+    }
+    g_mutex_unlock (&trace_mutex);
+}
+
+void
+mm_log_trace_forget (const char *owner)
+{
+    g_mutex_lock (&trace_mutex);
+    if (trace_rings)
+        g_hash_table_remove (trace_rings, owner);
+    g_mutex_unlock (&trace_mutex);
+}
+
+/*****************************************************************************/
+
 static void
 log_handler (const gchar *log_domain,
              GLogLevelFlags level,
              const gchar *message,
              gpointer ignored)
 {
-    log_backend (NULL, NULL, glib_to_syslog_priority (level), message, strlen (message));
+    /* Fatal messages abort right after this handler */
+    log_emit (NULL, NULL, glib_to_syslog_priority (level & G_LOG_LEVEL_MASK), message, strlen (message),
+              !!(level & (G_LOG_FLAG_FATAL | G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL)));
 }
 
 gboolean
@@ -299,7 +626,7 @@ mm_log_setup (const char *level,
         ts_flags = TS_FLAG_REL;
 
     /* Grab start time for relative timestamps */
-    g_get_current_time (&rel_start);
+    rel_start = g_get_real_time ();
 
 #if defined WITH_SYSTEMD_JOURNAL
     if (log_journal) {
@@ -342,14 +669,31 @@ mm_log_setup (const char *level,
                        NULL);
 #endif
 
+    writer = g_thread_new ("mm-log", log_writer_thread, NULL);
+
     return TRUE;
 }
 
 void
 mm_log_shutdown (void)
 {
+    if (writer) {
+        g_mutex_lock (&writer_mutex);
+        writer_exiting = TRUE;
+        g_cond_signal (&writer_cond);
+        g_mutex_unlock (&writer_mutex);
+        g_thread_join (writer);
+        writer = NULL;
+        writer_exiting = FALSE;
+    }
+
+    /* Anything pushed while the writer was exiting */
+    log_flush ();
+
     if (logfd < 0)
         closelog ();
-    else
+    else {
         close (logfd);
+        logfd = -1;
+    }
 }
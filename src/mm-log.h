@@ -41,12 +41,30 @@ typedef enum {
 #define mm_log(level, ...) \
     _mm_log (G_STRLOC, G_STRFUNC, level, ## __VA_ARGS__ )
 
+/* Debug traces which are also kept in a ring buffer of the given owner (e.g.
+ * the physical device uid of the modem), regardless of the log level, so that
+ * the last MM_LOG_TRACE_RING_SIZE ones can be dumped afterwards */
+#define MM_LOG_TRACE_RING_SIZE 256
+
+#define mm_trace(owner, ...) \
+    _mm_log_trace (G_STRLOC, G_STRFUNC, owner, ## __VA_ARGS__ )
+
 void _mm_log (const char *loc,
               const char *func,
               MMLogLevel level,
               const char *fmt,
               ...)  __attribute__((__format__ (__printf__, 4, 5)));
 
+void _mm_log_trace (const char *loc,
+                    const char *func,
+                    const char *owner,
+                    const char *fmt,
+                    ...)  __attribute__((__format__ (__printf__, 4, 5)));
+
+/* Dump the traces of the given owner, or of all owners if NULL */
+void mm_log_trace_dump   (const char *owner);
+void mm_log_trace_forget (const char *owner);
+
 gboolean mm_log_set_level (const char *level, GError **error);
 
 gboolean mm_log_setup (const char *level,
@@ -32,6 +32,8 @@
 #include "mm-modem-helpers.h"
 #include "mm-helper-enums-types.h"
 #include "mm-log.h"
+#include "mm-regex.h"
+#include "mm-at-tokenizer.h"
 
 /*****************************************************************************/
 
@@ -522,10 +524,10 @@ mm_voice_ring_regex_get (void)
     /* Example:
      * <CR><LF>RING<CR><LF>
      */
-    return g_regex_new ("\\r\\nRING\\r\\n",
-                        G_REGEX_RAW | G_REGEX_OPTIMIZE,
-                        0,
-                        NULL);
+    return mm_regex_get ("\\r\\nRING\\r\\n",
+                         G_REGEX_RAW | G_REGEX_OPTIMIZE,
+                         0,
+                         NULL);
 }
 
 GRegex *
@@ -535,10 +537,10 @@ mm_voice_cring_regex_get (void)
      * <CR><LF>+CRING: VOICE<CR><LF>
      * <CR><LF>+CRING: DATA<CR><LF>
      */
-    return g_regex_new ("\\r\\n\\+CRING:\\s*(\\S+)\\r\\n",
-                        G_REGEX_RAW | G_REGEX_OPTIMIZE,
-                        0,
-                        NULL);
+    return mm_regex_get ("\\r\\n\\+CRING:\\s*(\\S+)\\r\\n",
+                         G_REGEX_RAW | G_REGEX_OPTIMIZE,
+                         0,
+                         NULL);
 }
 
 GRegex *
@@ -548,10 +550,10 @@ mm_voice_clip_regex_get (void)
      * <CR><LF>+CLIP: "+393351391306",145,,,,0<CR><LF>
      *                 \_ Number      \_ Type \_ Validity
      */
-    return g_regex_new ("\\r\\n\\+CLIP:\\s*(\\S+),\\s*(\\d+),\\s*,\\s*,\\s*,\\s*(\\d+)\\r\\n",
-                        G_REGEX_RAW | G_REGEX_OPTIMIZE,
-                        0,
-                        NULL);
+    return mm_regex_get ("\\r\\n\\+CLIP:\\s*(\\S+),\\s*(\\d+),\\s*,\\s*,\\s*,\\s*(\\d+)\\r\\n",
+                         G_REGEX_RAW | G_REGEX_OPTIMIZE,
+                         0,
+                         NULL);
 }
 
 /*************************************************************************/
@@ -633,7 +635,7 @@ mm_parse_ifc_test_response (const gchar  *response,
     MMFlowControl  ta_mask     = MM_FLOW_CONTROL_UNKNOWN;
     MMFlowControl  mask        = MM_FLOW_CONTROL_UNKNOWN;
 
-    r = g_regex_new ("(?:\\+IFC:)?\\s*\\((.*)\\),\\((.*)\\)(?:\\r\\n)?", 0, 0, NULL);
+    r = mm_regex_get ("(?:\\+IFC:)?\\s*\\((.*)\\),\\((.*)\\)(?:\\r\\n)?", 0, 0, NULL);
     g_assert (r != NULL);
 
     g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -739,105 +741,105 @@ mm_3gpp_creg_regex_get (gboolean solicited)
 
     /* #1 */
     if (solicited)
-        regex = g_regex_new (CREG1 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get (CREG1 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     else
-        regex = g_regex_new ("\\r\\n" CREG1 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get ("\\r\\n" CREG1 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     g_assert (regex);
     g_ptr_array_add (array, regex);
 
     /* #2 */
     if (solicited)
-        regex = g_regex_new (CREG2 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get (CREG2 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     else
-        regex = g_regex_new ("\\r\\n" CREG2 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get ("\\r\\n" CREG2 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     g_assert (regex);
     g_ptr_array_add (array, regex);
 
     /* #3 */
     if (solicited)
-        regex = g_regex_new (CREG3 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get (CREG3 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     else
-        regex = g_regex_new ("\\r\\n" CREG3 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get ("\\r\\n" CREG3 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     g_assert (regex);
     g_ptr_array_add (array, regex);
 
     /* #4 */
     if (solicited)
-        regex = g_regex_new (CREG4 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get (CREG4 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     else
-        regex = g_regex_new ("\\r\\n" CREG4 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get ("\\r\\n" CREG4 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     g_assert (regex);
     g_ptr_array_add (array, regex);
 
     /* #5 */
     if (solicited)
-        regex = g_regex_new (CREG5 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get (CREG5 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     else
-        regex = g_regex_new ("\\r\\n" CREG5 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get ("\\r\\n" CREG5 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     g_assert (regex);
     g_ptr_array_add (array, regex);
 
     /* #6 */
     if (solicited)
-        regex = g_regex_new (CREG6 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get (CREG6 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     else
-        regex = g_regex_new ("\\r\\n" CREG6 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get ("\\r\\n" CREG6 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     g_assert (regex);
     g_ptr_array_add (array, regex);
 
     /* #7 */
     if (solicited)
-        regex = g_regex_new (CREG7 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get (CREG7 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     else
-        regex = g_regex_new ("\\r\\n" CREG7 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get ("\\r\\n" CREG7 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     g_assert (regex);
     g_ptr_array_add (array, regex);
 
     /* #8 */
     if (solicited)
-        regex = g_regex_new (CREG8 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get (CREG8 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     else
-        regex = g_regex_new ("\\r\\n" CREG8 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get ("\\r\\n" CREG8 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     g_assert (regex);
     g_ptr_array_add (array, regex);
 
     /* #9 */
     if (solicited)
-        regex = g_regex_new (CREG9 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get (CREG9 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     else
-        regex = g_regex_new ("\\r\\n" CREG9 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get ("\\r\\n" CREG9 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     g_assert (regex);
     g_ptr_array_add (array, regex);
 
     /* #10 */
     if (solicited)
-        regex = g_regex_new (CREG10 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get (CREG10 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     else
-        regex = g_regex_new ("\\r\\n" CREG10 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get ("\\r\\n" CREG10 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     g_assert (regex);
     g_ptr_array_add (array, regex);
 
     /* #11 */
     if (solicited)
-        regex = g_regex_new (CREG11 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get (CREG11 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     else
-        regex = g_regex_new ("\\r\\n" CREG11 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get ("\\r\\n" CREG11 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     g_assert (regex);
     g_ptr_array_add (array, regex);
 
     /* CEREG #1 */
     if (solicited)
-        regex = g_regex_new (CEREG1 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get (CEREG1 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     else
-        regex = g_regex_new ("\\r\\n" CEREG1 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get ("\\r\\n" CEREG1 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     g_assert (regex);
     g_ptr_array_add (array, regex);
 
     /* CEREG #2 */
     if (solicited)
-        regex = g_regex_new (CEREG2 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get (CEREG2 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     else
-        regex = g_regex_new ("\\r\\n" CEREG2 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        regex = mm_regex_get ("\\r\\n" CEREG2 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     g_assert (regex);
     g_ptr_array_add (array, regex);
 
@@ -856,10 +858,10 @@ mm_3gpp_creg_regex_destroy (GPtrArray *array)
 GRegex *
 mm_3gpp_ciev_regex_get (void)
 {
-    return g_regex_new ("\\r\\n\\+CIEV: (.*),(\\d)\\r\\n",
-                        G_REGEX_RAW | G_REGEX_OPTIMIZE,
-                        0,
-                        NULL);
+    return mm_regex_get ("\\r\\n\\+CIEV: (.*),(\\d)\\r\\n",
+                         G_REGEX_RAW | G_REGEX_OPTIMIZE,
+                         0,
+                         NULL);
 }
 
 /*************************************************************************/
@@ -867,10 +869,10 @@ mm_3gpp_ciev_regex_get (void)
 GRegex *
 mm_3gpp_cgev_regex_get (void)
 {
-    return g_regex_new ("\\r\\n\\+CGEV:\\s*(.*)\\r\\n",
-                        G_REGEX_RAW | G_REGEX_OPTIMIZE,
-                        0,
-                        NULL);
+    return mm_regex_get ("\\r\\n\\+CGEV:\\s*(.*)\\r\\n",
+                         G_REGEX_RAW | G_REGEX_OPTIMIZE,
+                         0,
+                         NULL);
 }
 
 /*************************************************************************/
@@ -878,10 +880,10 @@ mm_3gpp_cgev_regex_get (void)
 GRegex *
 mm_3gpp_cusd_regex_get (void)
 {
-    return g_regex_new ("\\r\\n\\+CUSD:\\s*(.*)\\r\\n",
-                        G_REGEX_RAW | G_REGEX_OPTIMIZE,
-                        0,
-                        NULL);
+    return mm_regex_get ("\\r\\n\\+CUSD:\\s*(.*)\\r\\n",
+                         G_REGEX_RAW | G_REGEX_OPTIMIZE,
+                         0,
+                         NULL);
 }
 
 /*************************************************************************/
@@ -889,10 +891,10 @@ mm_3gpp_cusd_regex_get (void)
 GRegex *
 mm_3gpp_cmti_regex_get (void)
 {
-    return g_regex_new ("\\r\\n\\+CMTI:\\s*\"(\\S+)\",\\s*(\\d+)\\r\\n",
-                        G_REGEX_RAW | G_REGEX_OPTIMIZE,
-                        0,
-                        NULL);
+    return mm_regex_get ("\\r\\n\\+CMTI:\\s*\"(\\S+)\",\\s*(\\d+)\\r\\n",
+                         G_REGEX_RAW | G_REGEX_OPTIMIZE,
+                         0,
+                         NULL);
 }
 
 GRegex *
@@ -901,10 +903,10 @@ mm_3gpp_cds_regex_get (void)
     /* Example:
      * <CR><LF>+CDS: 24<CR><LF>07914356060013F10659098136395339F6219011707193802190117071938030<CR><LF>
      */
-    return g_regex_new ("\\r\\n\\+CDS:\\s*(\\d+)\\r\\n(.*)\\r\\n",
-                        G_REGEX_RAW | G_REGEX_OPTIMIZE,
-                        0,
-                        NULL);
+    return mm_regex_get ("\\r\\n\\+CDS:\\s*(\\d+)\\r\\n(.*)\\r\\n",
+                         G_REGEX_RAW | G_REGEX_OPTIMIZE,
+                         0,
+                         NULL);
 }
 
 /*************************************************************************/
@@ -959,7 +961,7 @@ mm_3gpp_parse_ws46_test_response (const gchar  *response,
     gboolean    supported_3g = FALSE;
     gboolean    supported_2g = FALSE;
 
-    r = g_regex_new ("(?:\\+WS46:)?\\s*\\((.*)\\)(?:\\r\\n)?", 0, 0, NULL);
+    r = mm_regex_get ("(?:\\+WS46:)?\\s*\\((.*)\\)(?:\\r\\n)?", 0, 0, NULL);
     g_assert (r != NULL);
 
     g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -1126,11 +1128,9 @@ GList *
 mm_3gpp_parse_cops_test_response (const gchar *reply,
                                   GError **error)
 {
-    GRegex *r;
+    MMAtTokenizer tokenizer;
+    MMAtToken entry;
     GList *info_list = NULL;
-    GMatchInfo *match_info;
-    gboolean umts_format = TRUE;
-    GError *inner_error = NULL;
 
     g_return_val_if_fail (reply != NULL, NULL);
     if (error)
@@ -1145,129 +1145,123 @@ mm_3gpp_parse_cops_test_response (const gchar *reply,
 
     reply = strstr (reply, "+COPS: ") + 7;
 
-    /* Cell access technology (GSM, UTRAN, etc) got added later and not all
-     * modems implement it.  Some modesm have quirks that make it hard to
-     * use one regular experession for matching both pre-UMTS and UMTS
-     * responses.  So try UMTS-format first and fall back to pre-UMTS if
-     * we get no UMTS-formst matches.
-     */
-
-    /* Quirk: Sony-Ericsson TM-506 sometimes includes a stray ')' like so,
-     *        which is what makes it hard to match both pre-UMTS and UMTS in
-     *        the same regex:
-     *
-     *       +COPS: (2,"","T-Mobile","31026",0),(1,"AT&T","AT&T","310410"),0)
-     */
-
-    r = g_regex_new ("\\((\\d),\"([^\"\\)]*)\",([^,\\)]*),([^,\\)]*)[\\)]?,(\\d)\\)", G_REGEX_UNGREEDY, 0, &inner_error);
-    if (inner_error) {
-        mm_err ("Invalid regular expression: %s", inner_error->message);
-        g_error_free (inner_error);
-        g_set_error_literal (error,
-                             MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
-                             "Could not parse scan results");
-        return NULL;
-    }
-
-    /* If we didn't get any hits, try the pre-UMTS format match */
-    if (!g_regex_match (r, reply, 0, &match_info)) {
-        g_regex_unref (r);
-        g_match_info_free (match_info);
-        match_info = NULL;
-
-        /* Pre-UMTS format doesn't include the cell access technology after
-         * the numeric operator element.
-         *
-         * Ex: Motorola C-series (BUSlink SCWi275u) like so:
-         *
-         *       +COPS: (2,"T-Mobile","","310260"),(0,"Cingular Wireless","","310410")
-         */
-
-        /* Quirk: Some Nokia phones (N80) don't send the quotes for empty values:
-         *
-         *       +COPS: (2,"T - Mobile",,"31026"),(1,"Einstein PCS",,"31064"),(1,"Cingular",,"31041"),,(0,1,3),(0,2)
-         */
+    /* Entries may be split in several lines, with or without the tag */
+    mm_at_tokenizer_init (&tokenizer, reply, -1);
+    while (mm_at_tokenizer_next_line (&tokenizer, NULL)) {
+        if (g_str_has_prefix (tokenizer.p, "+COPS:"))
+            tokenizer.p += 6;
+
+        while (mm_at_tokenizer_next (&tokenizer, &entry)) {
+            MMAtTokenizer fields;
+            MMAtToken field;
+            MM3gppNetworkInfo *info;
+            gchar *tmp;
+            gchar *access_tech = NULL;
+            guint n_fields = 0;
+            gboolean valid = FALSE;
+
+            if (entry.type != MM_AT_TOKEN_TYPE_GROUP)
+                continue;
+
+            info = g_new0 (MM3gppNetworkInfo, 1);
+
+            /* Cell access technology (GSM, UTRAN, etc) got added later and not
+             * all modems implement it, so the fifth field is optional.
+             *
+             * Ex: Motorola C-series (BUSlink SCWi275u) like so:
+             *
+             *       +COPS: (2,"T-Mobile","","310260"),(0,"Cingular Wireless","","310410")
+             *
+             * Quirk: Some Nokia phones (N80) don't send the quotes for empty values:
+             *
+             *       +COPS: (2,"T - Mobile",,"31026"),(1,"Einstein PCS",,"31064"),(1,"Cingular",,"31041"),,(0,1,3),(0,2)
+             */
+            mm_at_tokenizer_init_group (&fields, &entry);
+            while (mm_at_tokenizer_next (&fields, &field)) {
+                switch (n_fields++) {
+                case 0:
+                    tmp = mm_at_token_dup (&field);
+                    info->status = parse_network_status (tmp);
+                    g_free (tmp);
+                    break;
+                case 1:
+                    info->operator_long = mm_at_token_dup (&field);
+                    break;
+                case 2:
+                    info->operator_short = mm_at_token_dup (&field);
+                    break;
+                case 3:
+                    info->operator_code = mm_at_token_dup (&field);
+                    break;
+                case 4:
+                    access_tech = mm_at_token_dup (&field);
+                    break;
+                default:
+                    break;
+                }
+            }
 
-        r = g_regex_new ("\\((\\d),([^,\\)]*),([^,\\)]*),([^\\)]*)\\)", G_REGEX_UNGREEDY, 0, &inner_error);
-        if (inner_error) {
-            mm_err ("Invalid regular expression: %s", inner_error->message);
-            g_error_free (inner_error);
-            g_set_error_literal (error,
-                                 MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
-                                 "Could not parse scan results");
-            return NULL;
-        }
+            /* Quirk: Sony-Ericsson TM-506 sometimes includes a stray ')' before
+             *        the access technology, like so:
+             *
+             *       +COPS: (2,"","T-Mobile","31026",0),(1,"AT&T","AT&T","310410"),0)
+             */
+            if (n_fields == 4) {
+                MMAtTokenizer aux;
+                MMAtToken stray;
+
+                aux = tokenizer;
+                if (mm_at_tokenizer_next (&aux, &stray) &&
+                    stray.type == MM_AT_TOKEN_TYPE_VALUE &&
+                    stray.len == 2 &&
+                    g_ascii_isdigit (stray.str[0]) &&
+                    stray.str[1] == ')') {
+                    access_tech = g_strndup (stray.str, 1);
+                    tokenizer = aux;
+                }
+            }
 
-        g_regex_match (r, reply, 0, &match_info);
-        umts_format = FALSE;
-    }
+            /* If none given, assume GSM */
+            info->access_tech = (access_tech ?
+                                 parse_access_tech (access_tech) :
+                                 MM_MODEM_ACCESS_TECHNOLOGY_GSM);
+            g_free (access_tech);
 
-    /* Parse the results */
-    while (g_match_info_matches (match_info)) {
-        MM3gppNetworkInfo *info;
-        gchar *tmp;
-        gboolean valid = FALSE;
-
-        info = g_new0 (MM3gppNetworkInfo, 1);
-
-        tmp = mm_get_string_unquoted_from_match_info (match_info, 1);
-        info->status = parse_network_status (tmp);
-        g_free (tmp);
-
-        info->operator_long = mm_get_string_unquoted_from_match_info (match_info, 2);
-        info->operator_short = mm_get_string_unquoted_from_match_info (match_info, 3);
-        info->operator_code = mm_get_string_unquoted_from_match_info (match_info, 4);
-
-        /* Only try for access technology with UMTS-format matches.
-         * If none give, assume GSM */
-        tmp = (umts_format ?
-               mm_get_string_unquoted_from_match_info (match_info, 5) :
-               NULL);
-        info->access_tech = (tmp ?
-                             parse_access_tech (tmp) :
-                             MM_MODEM_ACCESS_TECHNOLOGY_GSM);
-        g_free (tmp);
-
-        /* If the operator number isn't valid (ie, at least 5 digits),
-         * ignore the scan result; it's probably the parameter stuff at the
-         * end of the +COPS response.  The regex will sometimes catch this
-         * but there's no good way to ignore it.
-         */
-        if (info->operator_code && (strlen (info->operator_code) >= 5)) {
-            valid = TRUE;
-            tmp = info->operator_code;
-            while (*tmp) {
-                if (!isdigit (*tmp) && (*tmp != '-')) {
-                    valid = FALSE;
-                    break;
+            /* If the operator number isn't valid (ie, at least 5 digits),
+             * ignore the scan result; it's probably the parameter stuff at the
+             * end of the +COPS response.
+             */
+            if (info->operator_code && (strlen (info->operator_code) >= 5)) {
+                valid = TRUE;
+                tmp = info->operator_code;
+                while (*tmp) {
+                    if (!isdigit (*tmp) && (*tmp != '-')) {
+                        valid = FALSE;
+                        break;
+                    }
+                    tmp++;
                 }
-                tmp++;
             }
-        }
 
-        if (valid) {
-            gchar *access_tech_str;
+            if (valid) {
+                gchar *access_tech_str;
 
-            access_tech_str = mm_modem_access_technology_build_string_from_mask (info->access_tech);
-            mm_dbg ("Found network '%s' ('%s','%s'); availability: %s, access tech: %s",
-                    info->operator_code,
-                    info->operator_short ? info->operator_short : "no short name",
-                    info->operator_long ? info->operator_long : "no long name",
-                    mm_modem_3gpp_network_availability_get_string (info->status),
-                    access_tech_str);
-            g_free (access_tech_str);
+                access_tech_str = mm_modem_access_technology_build_string_from_mask (info->access_tech);
+                mm_dbg ("Found network '%s' ('%s','%s'); availability: %s, access tech: %s",
+                        info->operator_code,
+                        info->operator_short ? info->operator_short : "no short name",
+                        info->operator_long ? info->operator_long : "no long name",
+                        mm_modem_3gpp_network_availability_get_string (info->status),
+                        access_tech_str);
+                g_free (access_tech_str);
 
-            info_list = g_list_prepend (info_list, info);
+                info_list = g_list_prepend (info_list, info);
+            }
+            else
+                mm_3gpp_network_info_free (info);
         }
-        else
-            mm_3gpp_network_info_free (info);
-
-        g_match_info_next (match_info, NULL);
     }
 
-    g_match_info_free (match_info);
-    g_regex_unref (r);
-
     return info_list;
 }
 
@@ -1297,7 +1291,7 @@ mm_3gpp_parse_cops_read_response (const gchar              *response,
      * or:
      *   +COPS: <mode>,<format>,<oper>,<AcT>
      */
-    r = g_regex_new ("\\+COPS:\\s*(\\d+),(\\d+),([^,]*)(?:,(\\d+))?(?:\\r\\n)?", 0, 0, NULL);
+    r = mm_regex_get ("\\+COPS:\\s*(\\d+),(\\d+),([^,]*)(?:,(\\d+))?(?:\\r\\n)?", 0, 0, NULL);
     g_assert (r != NULL);
 
     g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -1430,9 +1424,9 @@ mm_3gpp_parse_cgdcont_test_response (const gchar *response,
         return NULL;
     }
 
-    r = g_regex_new ("\\+CGDCONT:\\s*\\(\\s*(\\d+)\\s*-?\\s*(\\d+)?[^\\)]*\\)\\s*,\\s*\\(?\"(\\S+)\"",
-                     G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
-                     0, &inner_error);
+    r = mm_regex_get ("\\+CGDCONT:\\s*\\(\\s*(\\d+)\\s*-?\\s*(\\d+)?[^\\)]*\\)\\s*,\\s*\\(?\"(\\S+)\"",
+                      G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
+                      0, &inner_error);
     g_assert (r != NULL);
 
     g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -1508,61 +1502,48 @@ GList *
 mm_3gpp_parse_cgdcont_read_response (const gchar *reply,
                                      GError **error)
 {
-    GError *inner_error = NULL;
-    GRegex *r;
-    GMatchInfo *match_info;
-    GList *list;
+    MMAtTokenizer tokenizer;
+    GList *list = NULL;
 
     if (!reply || !reply[0])
         /* No APNs configured, all done */
         return NULL;
 
-    list = NULL;
-    r = g_regex_new ("\\+CGDCONT:\\s*(\\d+)\\s*,([^, \\)]*)\\s*,([^, \\)]*)\\s*,([^, \\)]*)",
-                     G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
-                     0, &inner_error);
-    if (r) {
-        g_regex_match_full (r, reply, strlen (reply), 0, 0, &match_info, &inner_error);
-
-        while (!inner_error &&
-               g_match_info_matches (match_info)) {
-            gchar *str;
-            MMBearerIpFamily ip_family;
-
-            str = mm_get_string_unquoted_from_match_info (match_info, 2);
-            ip_family = mm_3gpp_get_ip_family_from_pdp_type (str);
-            if (ip_family == MM_BEARER_IP_FAMILY_NONE)
-                mm_dbg ("Ignoring PDP context type: '%s'", str);
-            else {
-                MM3gppPdpContext *pdp;
-
-                pdp = g_slice_new0 (MM3gppPdpContext);
-                if (!mm_get_uint_from_match_info (match_info, 1, &pdp->cid)) {
-                    inner_error = g_error_new (MM_CORE_ERROR,
-                                               MM_CORE_ERROR_FAILED,
-                                               "Couldn't parse CID from reply: '%s'",
-                                               reply);
-                    break;
-                }
-                pdp->pdp_type = ip_family;
-                pdp->apn = mm_get_string_unquoted_from_match_info (match_info, 3);
-
-                list = g_list_prepend (list, pdp);
-            }
+    mm_at_tokenizer_init (&tokenizer, reply, -1);
+    while (mm_at_tokenizer_next_line (&tokenizer, "+CGDCONT:")) {
+        MMAtToken cid;
+        MMAtToken pdp_type;
+        MMAtToken apn;
+        gchar pdp_type_str[16];
+        MMBearerIpFamily ip_family = MM_BEARER_IP_FAMILY_NONE;
+        MM3gppPdpContext *pdp;
+
+        if (!mm_at_tokenizer_next (&tokenizer, &cid) ||
+            !mm_at_tokenizer_next (&tokenizer, &pdp_type) ||
+            !mm_at_tokenizer_next (&tokenizer, &apn))
+            continue;
 
-            g_free (str);
-            g_match_info_next (match_info, &inner_error);
+        if (mm_at_token_copy (&pdp_type, pdp_type_str, sizeof (pdp_type_str)))
+            ip_family = mm_3gpp_get_ip_family_from_pdp_type (pdp_type_str);
+        if (ip_family == MM_BEARER_IP_FAMILY_NONE) {
+            mm_dbg ("Ignoring PDP context type: '%.*s'", (gint) pdp_type.len, pdp_type.str);
+            continue;
         }
 
-        g_match_info_free (match_info);
-        g_regex_unref (r);
-    }
+        pdp = g_slice_new0 (MM3gppPdpContext);
+        if (!mm_at_token_get_uint (&cid, &pdp->cid)) {
+            g_slice_free (MM3gppPdpContext, pdp);
+            mm_3gpp_pdp_context_list_free (list);
+            g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                         "Couldn't properly parse list of PDP contexts. "
+                         "Couldn't parse CID from reply: '%s'",
+                         reply);
+            return NULL;
+        }
+        pdp->pdp_type = ip_family;
+        pdp->apn = mm_at_token_dup (&apn);
 
-    if (inner_error) {
-        mm_3gpp_pdp_context_list_free (list);
-        g_propagate_error (error, inner_error);
-        g_prefix_error (error, "Couldn't properly parse list of PDP contexts. ");
-        return NULL;
+        list = g_list_prepend (list, pdp);
     }
 
     list = g_list_sort (list, (GCompareFunc)mm_3gpp_pdp_context_cmp);
@@ -1596,8 +1577,7 @@ mm_3gpp_parse_cgact_read_response (const gchar *reply,
                                    GError **error)
 {
     GError *inner_error = NULL;
-    GRegex *r;
-    GMatchInfo *match_info;
+    MMAtTokenizer tokenizer;
     GList *list;
 
     if (!reply || !reply[0])
@@ -1605,24 +1585,21 @@ mm_3gpp_parse_cgact_read_response (const gchar *reply,
         return NULL;
 
     list = NULL;
-    r = g_regex_new ("\\+CGACT:\\s*(\\d+),(\\d+)",
-                     G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW, 0, &inner_error);
-    g_assert (r);
-
-    g_regex_match_full (r, reply, strlen (reply), 0, 0, &match_info, &inner_error);
-    while (!inner_error && g_match_info_matches (match_info)) {
+    mm_at_tokenizer_init (&tokenizer, reply, -1);
+    while (mm_at_tokenizer_next_line (&tokenizer, "+CGACT:")) {
         MM3gppPdpContextActive *pdp_active;
+        MMAtToken token;
         guint cid = 0;
         guint aux = 0;
 
-        if (!mm_get_uint_from_match_info (match_info, 1, &cid)) {
+        if (!mm_at_tokenizer_next (&tokenizer, &token) || !mm_at_token_get_uint (&token, &cid)) {
             inner_error = g_error_new (MM_CORE_ERROR,
                                        MM_CORE_ERROR_FAILED,
                                        "Couldn't parse CID from reply: '%s'",
                                        reply);
             break;
         }
-        if (!mm_get_uint_from_match_info (match_info, 2, &aux) || (aux != 0 && aux != 1)) {
+        if (!mm_at_tokenizer_next (&tokenizer, &token) || !mm_at_token_get_uint (&token, &aux) || (aux != 0 && aux != 1)) {
             inner_error = g_error_new (MM_CORE_ERROR,
                                        MM_CORE_ERROR_FAILED,
                                        "Couldn't parse context status from reply: '%s'",
@@ -1634,13 +1611,8 @@ mm_3gpp_parse_cgact_read_response (const gchar *reply,
         pdp_active->cid = cid;
         pdp_active->active = (gboolean) aux;
         list = g_list_prepend (list, pdp_active);
-
-        g_match_info_next (match_info, &inner_error);
     }
 
-    g_match_info_free (match_info);
-    g_regex_unref (r);
-
     if (inner_error) {
         mm_3gpp_pdp_context_active_list_free (list);
         g_propagate_error (error, inner_error);
@@ -1872,7 +1844,7 @@ mm_3gpp_parse_cmgf_test_response (const gchar *reply,
     while (isspace (*reply))
         reply++;
 
-    r = g_regex_new ("\\(?\\s*(\\d+)\\s*[-,]?\\s*(\\d+)?\\s*\\)?", 0, 0, error);
+    r = mm_regex_get ("\\(?\\s*(\\d+)\\s*[-,]?\\s*(\\d+)?\\s*\\)?", 0, 0, error);
     if (!r)
         return FALSE;
 
@@ -1924,7 +1896,7 @@ mm_3gpp_parse_cmgr_read_response (const gchar *reply,
 
     /* +CMGR: <stat>,<alpha>,<length>(whitespace)<pdu> */
     /* The <alpha> and <length> fields are matched, but not currently used */
-    r = g_regex_new ("\\+CMGR:\\s*(\\d+)\\s*,([^,]*),\\s*(\\d+)\\s*([^\\r\\n]*)", 0, 0, NULL);
+    r = mm_regex_get ("\\+CMGR:\\s*(\\d+)\\s*,([^,]*),\\s*(\\d+)\\s*([^\\r\\n]*)", 0, 0, NULL);
     g_assert (r);
 
     if (!g_regex_match_full (r, reply, strlen (reply), 0, 0, &match_info, NULL)) {
@@ -2005,8 +1977,8 @@ mm_3gpp_parse_crsm_response (const gchar *reply,
         return FALSE;
     }
 
-    r = g_regex_new ("\\+CRSM:\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*\"?([0-9a-fA-F]+)\"?",
-                     G_REGEX_RAW, 0, NULL);
+    r = mm_regex_get ("\\+CRSM:\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*\"?([0-9a-fA-F]+)\"?",
+                      G_REGEX_RAW, 0, NULL);
     g_assert (r != NULL);
 
     if (g_regex_match_full (r, reply, strlen (reply), 0, 0, &match_info, NULL) &&
@@ -2119,16 +2091,16 @@ mm_3gpp_parse_cgcontrdp_response (const gchar  *response,
      * The format of the response changed in TS 27.007 v9.4.0, we try to detect
      * both formats ('a' if >= v9.4.0, 'b' if < v9.4.0) with a single regex here.
      */
-    r = g_regex_new ("\\+CGCONTRDP: "
-                     "(\\d+),(\\d+),([^,]*)" /* cid, bearer id, apn */
-                     "(?:,([^,]*))?" /* (a)ip+mask        or (b)ip */
-                     "(?:,([^,]*))?" /* (a)gateway        or (b)mask */
-                     "(?:,([^,]*))?" /* (a)dns1           or (b)gateway */
-                     "(?:,([^,]*))?" /* (a)dns2           or (b)dns1 */
-                     "(?:,([^,]*))?" /* (a)p-cscf primary or (b)dns2 */
-                     "(?:,(.*))?"    /* others, ignored */
-                     "(?:\\r\\n)?",
-                     0, 0, NULL);
+    r = mm_regex_get ("\\+CGCONTRDP: "
+                      "(\\d+),(\\d+),([^,]*)" /* cid, bearer id, apn */
+                      "(?:,([^,]*))?" /* (a)ip+mask        or (b)ip */
+                      "(?:,([^,]*))?" /* (a)gateway        or (b)mask */
+                      "(?:,([^,]*))?" /* (a)dns1           or (b)gateway */
+                      "(?:,([^,]*))?" /* (a)dns2           or (b)dns1 */
+                      "(?:,([^,]*))?" /* (a)p-cscf primary or (b)dns2 */
+                      "(?:,(.*))?"    /* others, ignored */
+                      "(?:\\r\\n)?",
+                      0, 0, NULL);
     g_assert (r != NULL);
 
     g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -2243,7 +2215,7 @@ mm_3gpp_parse_cfun_query_response (const gchar  *response,
      * +CFUN: 1,0
      *   ..but we don't care about the second number
      */
-    r = g_regex_new ("\\+CFUN: (\\d+)(?:,(?:\\d+))?(?:\\r\\n)?", 0, 0, NULL);
+    r = mm_regex_get ("\\+CFUN: (\\d+)(?:,(?:\\d+))?(?:\\r\\n)?", 0, 0, NULL);
     g_assert (r != NULL);
 
     g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -2289,16 +2261,10 @@ mm_3gpp_parse_cesq_response (const gchar  *response,
                              guint        *out_rsrp,
                              GError      **error)
 {
-    GRegex     *r;
-    GMatchInfo *match_info;
-    GError     *inner_error = NULL;
-    guint       rxlev = 99;
-    guint       ber = 99;
-    guint       rscp = 255;
-    guint       ecn0 = 255;
-    guint       rsrq = 255;
-    guint       rsrp = 255;
-    gboolean    success = FALSE;
+    static const gchar *names[] = { "RXLEV", "BER", "RSCP", "Ec/N0", "RSRQ", "RSRP" };
+    MMAtTokenizer       tokenizer;
+    guint               values[G_N_ELEMENTS (names)];
+    guint               i;
 
     g_assert (out_rxlev);
     g_assert (out_ber);
@@ -2310,59 +2276,28 @@ mm_3gpp_parse_cesq_response (const gchar  *response,
     /* Response may be e.g.:
      * +CESQ: 99,99,255,255,20,80
      */
-    r = g_regex_new ("\\+CESQ: (\\d+),(\\d+),(\\d+),(\\d+),(\\d+),(\\d+)(?:\\r\\n)?", 0, 0, NULL);
-    g_assert (r != NULL);
-
-    g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
-    if (!inner_error && g_match_info_matches (match_info)) {
-        if (!mm_get_uint_from_match_info (match_info, 1, &rxlev)) {
-            inner_error = g_error_new (MM_CORE_ERROR, MM_CORE_ERROR_FAILED, "Couldn't read RXLEV");
-            goto out;
-        }
-        if (!mm_get_uint_from_match_info (match_info, 2, &ber)) {
-            inner_error = g_error_new (MM_CORE_ERROR, MM_CORE_ERROR_FAILED, "Couldn't read BER");
-            goto out;
-        }
-        if (!mm_get_uint_from_match_info (match_info, 3, &rscp)) {
-            inner_error = g_error_new (MM_CORE_ERROR, MM_CORE_ERROR_FAILED, "Couldn't read RSCP");
-            goto out;
-        }
-        if (!mm_get_uint_from_match_info (match_info, 4, &ecn0)) {
-            inner_error = g_error_new (MM_CORE_ERROR, MM_CORE_ERROR_FAILED, "Couldn't read Ec/N0");
-            goto out;
-        }
-        if (!mm_get_uint_from_match_info (match_info, 5, &rsrq)) {
-            inner_error = g_error_new (MM_CORE_ERROR, MM_CORE_ERROR_FAILED, "Couldn't read RSRQ");
-            goto out;
-        }
-        if (!mm_get_uint_from_match_info (match_info, 6, &rsrp)) {
-            inner_error = g_error_new (MM_CORE_ERROR, MM_CORE_ERROR_FAILED, "Couldn't read RSRP");
-            goto out;
-        }
-        success = TRUE;
-    }
-
-out:
-    g_match_info_free (match_info);
-    g_regex_unref (r);
-
-    if (inner_error) {
-        g_propagate_error (error, inner_error);
-        return FALSE;
-    }
-
-    if (!success) {
+    mm_at_tokenizer_init (&tokenizer, response, -1);
+    if (!mm_at_tokenizer_next_line (&tokenizer, "+CESQ:")) {
         g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
                      "Couldn't parse +CESQ response: %s", response);
         return FALSE;
     }
 
-    *out_rxlev = rxlev;
-    *out_ber = ber;
-    *out_rscp = rscp;
-    *out_ecn0 = ecn0;
-    *out_rsrq = rsrq;
-    *out_rsrp = rsrp;
+    for (i = 0; i < G_N_ELEMENTS (names); i++) {
+        MMAtToken token;
+
+        if (!mm_at_tokenizer_next (&tokenizer, &token) || !mm_at_token_get_uint (&token, &values[i])) {
+            g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED, "Couldn't read %s", names[i]);
+            return FALSE;
+        }
+    }
+
+    *out_rxlev = values[0];
+    *out_ber = values[1];
+    *out_rscp = values[2];
+    *out_ecn0 = values[3];
+    *out_rsrq = values[4];
+    *out_rsrp = values[5];
     return TRUE;
 }
 
@@ -2589,116 +2524,126 @@ mm_3gpp_parse_cemode_query_response (const gchar                    *response,
 
 /*************************************************************************/
 
+static const struct {
+    const gchar  *name;
+    MMSmsStorage  storage;
+} storage_names[] = {
+    { "SM", MM_SMS_STORAGE_SM },
+    { "ME", MM_SMS_STORAGE_ME },
+    { "MT", MM_SMS_STORAGE_MT },
+    { "SR", MM_SMS_STORAGE_SR },
+    { "BM", MM_SMS_STORAGE_BM },
+    { "TA", MM_SMS_STORAGE_TA },
+};
+
 static MMSmsStorage
 storage_from_str (const gchar *str)
 {
-    if (g_str_equal (str, "SM"))
-        return MM_SMS_STORAGE_SM;
-    if (g_str_equal (str, "ME"))
-        return MM_SMS_STORAGE_ME;
-    if (g_str_equal (str, "MT"))
-        return MM_SMS_STORAGE_MT;
-    if (g_str_equal (str, "SR"))
-        return MM_SMS_STORAGE_SR;
-    if (g_str_equal (str, "BM"))
-        return MM_SMS_STORAGE_BM;
-    if (g_str_equal (str, "TA"))
-        return MM_SMS_STORAGE_TA;
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (storage_names); i++) {
+        if (g_str_equal (str, storage_names[i].name))
+            return storage_names[i].storage;
+    }
     return MM_SMS_STORAGE_UNKNOWN;
 }
 
+static MMSmsStorage
+storage_from_token (const MMAtToken *token)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (storage_names); i++) {
+        if (mm_at_token_equal (token, storage_names[i].name))
+            return storage_names[i].storage;
+    }
+    return MM_SMS_STORAGE_UNKNOWN;
+}
+
+/* Positions the tokenizer in the fields of the first line with the given tag,
+ * or in the ones of the first line if none has it */
+static gboolean
+tokenizer_init_response (MMAtTokenizer *tokenizer,
+                         const gchar   *reply,
+                         const gchar   *tag)
+{
+    mm_at_tokenizer_init (tokenizer, reply, -1);
+    if (mm_at_tokenizer_next_line (tokenizer, tag))
+        return TRUE;
+
+    mm_at_tokenizer_init (tokenizer, reply, -1);
+    return mm_at_tokenizer_next_line (tokenizer, NULL);
+}
+
+#define N_EXPECTED_GROUPS 3
+
 gboolean
 mm_3gpp_parse_cpms_test_response (const gchar *reply,
                                   GArray **mem1,
                                   GArray **mem2,
                                   GArray **mem3)
 {
-    GRegex *r;
-    gchar **split;
+    MMAtTokenizer tokenizer;
+    MMAtToken token;
+    GArray *tmp[N_EXPECTED_GROUPS] = { NULL };
+    guint n_groups = 0;
     guint i;
-    GArray *tmp1 = NULL;
-    GArray *tmp2 = NULL;
-    GArray *tmp3 = NULL;
 
     g_assert (mem1 != NULL);
     g_assert (mem2 != NULL);
     g_assert (mem3 != NULL);
 
-#define N_EXPECTED_GROUPS 3
-
-    split = mm_split_string_groups (mm_strip_tag (reply, "+CPMS:"));
-    if (!split)
-        return FALSE;
-
-    if (g_strv_length (split) != N_EXPECTED_GROUPS) {
-        mm_warn ("Cannot parse +CPMS test response: invalid number of groups (%u != %u)",
-                 g_strv_length (split), N_EXPECTED_GROUPS);
-        g_strfreev (split);
+    if (!tokenizer_init_response (&tokenizer, reply, "+CPMS:"))
         return FALSE;
-    }
-
-    r = g_regex_new ("\\s*\"([^,\\)]+)\"\\s*", 0, 0, NULL);
-    g_assert (r);
 
-    for (i = 0; i < N_EXPECTED_GROUPS; i++) {
-        GMatchInfo *match_info = NULL;
+    while (mm_at_tokenizer_next (&tokenizer, &token)) {
         GArray *array;
+        MMSmsStorage storage;
+
+        /* Just count any extra group */
+        if (n_groups++ >= N_EXPECTED_GROUPS)
+            continue;
 
         /* We always return a valid array, even if it may be empty */
         array = g_array_new (FALSE, FALSE, sizeof (MMSmsStorage));
-
-        /* Got a range group to match */
-        if (g_regex_match_full (r, split[i], strlen (split[i]), 0, 0, &match_info, NULL)) {
-            while (g_match_info_matches (match_info)) {
-                gchar *str;
-
-                str = g_match_info_fetch (match_info, 1);
-                if (str) {
-                    MMSmsStorage storage;
-
-                    storage = storage_from_str (str);
-                    g_array_append_val (array, storage);
-                    g_free (str);
-                }
-
-                g_match_info_next (match_info, NULL);
+        tmp[n_groups - 1] = array;
+
+        if (token.type == MM_AT_TOKEN_TYPE_STRING && token.len > 0) {
+            /* Single item */
+            storage = storage_from_token (&token);
+            g_array_append_val (array, storage);
+        } else if (token.type == MM_AT_TOKEN_TYPE_GROUP) {
+            MMAtTokenizer group;
+            MMAtToken item;
+
+            /* Got a range group to match */
+            mm_at_tokenizer_init_group (&group, &token);
+            while (mm_at_tokenizer_next (&group, &item)) {
+                if (item.type != MM_AT_TOKEN_TYPE_STRING || !item.len)
+                    continue;
+                storage = storage_from_token (&item);
+                g_array_append_val (array, storage);
             }
         }
-        g_match_info_free (match_info);
-
-        if (!tmp1)
-            tmp1 = array;
-        else if (!tmp2)
-            tmp2 = array;
-        else if (!tmp3)
-            tmp3 = array;
-        else
-            g_assert_not_reached ();
     }
 
-    g_strfreev (split);
-    g_regex_unref (r);
-
-    g_warn_if_fail (tmp1 != NULL);
-    g_warn_if_fail (tmp2 != NULL);
-    g_warn_if_fail (tmp3 != NULL);
-
     /* Only return TRUE if all sets have been parsed correctly
      * (even if the arrays may be empty) */
-    if (tmp1 && tmp2 && tmp3) {
-        *mem1 = tmp1;
-        *mem2 = tmp2;
-        *mem3 = tmp3;
+    if (n_groups == N_EXPECTED_GROUPS) {
+        *mem1 = tmp[0];
+        *mem2 = tmp[1];
+        *mem3 = tmp[2];
         return TRUE;
     }
 
+    mm_warn ("Cannot parse +CPMS test response: invalid number of groups (%u != %u)",
+             n_groups, N_EXPECTED_GROUPS);
+
     /* Otherwise, cleanup and return FALSE */
-    if (tmp1)
-        g_array_unref (tmp1);
-    if (tmp2)
-        g_array_unref (tmp2);
-    if (tmp3)
-        g_array_unref (tmp3);
+    for (i = 0; i < N_EXPECTED_GROUPS; i++) {
+        if (tmp[i])
+            g_array_unref (tmp[i]);
+    }
     return FALSE;
 }
 
@@ -2719,7 +2664,7 @@ mm_3gpp_parse_cpms_query_response (const gchar *reply,
     gboolean ret = FALSE;
     GMatchInfo *match_info = NULL;
 
-    r = g_regex_new (CPMS_QUERY_REGEX, G_REGEX_RAW, 0, NULL);
+    r = mm_regex_get (CPMS_QUERY_REGEX, G_REGEX_RAW, 0, NULL);
 
     g_assert (r);
 
@@ -2808,7 +2753,7 @@ mm_3gpp_parse_cscs_test_response (const gchar *reply,
     }
 
     /* Now parse each charset */
-    r = g_regex_new ("\\s*([^,\\)]+)\\s*", 0, 0, NULL);
+    r = mm_regex_get ("\\s*([^,\\)]+)\\s*", 0, 0, NULL);
     if (!r)
         return FALSE;
 
@@ -2850,7 +2795,7 @@ mm_3gpp_parse_clck_test_response (const gchar *reply,
     reply = mm_strip_tag (reply, "+CLCK:");
 
     /* Now parse each facility */
-    r = g_regex_new ("\\s*\"([^,\\)]+)\"\\s*", 0, 0, NULL);
+    r = mm_regex_get ("\\s*\"([^,\\)]+)\"\\s*", 0, 0, NULL);
     g_assert (r != NULL);
 
     *out_facilities = MM_MODEM_3GPP_FACILITY_NONE;
@@ -2888,7 +2833,7 @@ mm_3gpp_parse_clck_write_response (const gchar *reply,
 
     reply = mm_strip_tag (reply, "+CLCK:");
 
-    r = g_regex_new ("\\s*([01])\\s*", 0, 0, NULL);
+    r = mm_regex_get ("\\s*([01])\\s*", 0, 0, NULL);
     g_assert (r != NULL);
 
     if (g_regex_match (r, reply, 0, &match_info)) {
@@ -2928,8 +2873,8 @@ mm_3gpp_parse_cnum_exec_response (const gchar *reply)
     if (!reply || !reply[0])
         return NULL;
 
-    r = g_regex_new ("\\+CNUM:\\s*((\"([^\"]|(\\\"))*\")|([^,]*)),\"(?<num>\\S+)\",\\d",
-                     G_REGEX_UNGREEDY, 0, NULL);
+    r = mm_regex_get ("\\+CNUM:\\s*((\"([^\"]|(\\\"))*\")|([^,]*)),\"(?<num>\\S+)\",\\d",
+                      G_REGEX_UNGREEDY, 0, NULL);
     g_assert (r != NULL);
 
     g_regex_match (r, reply, 0, &match_info);
@@ -3077,7 +3022,7 @@ struct MM3gppCindResponse {
 };
 
 static MM3gppCindResponse *
-cind_response_new (const gchar *desc, guint idx, gint min, gint max)
+cind_response_new (const gchar *desc, gsize desc_len, guint idx, gint min, gint max)
 {
     MM3gppCindResponse *r;
     gchar *p;
@@ -3087,8 +3032,8 @@ cind_response_new (const gchar *desc, guint idx, gint min, gint max)
     r = g_malloc0 (sizeof (MM3gppCindResponse));
 
     /* Strip quotes */
-    r->desc = p = g_malloc0 (strlen (desc) + 1);
-    while (*desc) {
+    r->desc = p = g_malloc0 (desc_len + 1);
+    while (desc_len--) {
         if (*desc != '"' && !isspace (*desc))
             *p++ = tolower (*desc);
         desc++;
@@ -3149,20 +3094,13 @@ mm_3gpp_parse_cind_test_response (const gchar *reply,
                                   GError **error)
 {
     GHashTable *hash;
-    GRegex *r;
-    GMatchInfo *match_info;
-    guint idx = 1;
+    MMAtTokenizer tokenizer;
+    MMAtToken indicator;
+    guint idx = 0;
 
     g_return_val_if_fail (reply != NULL, NULL);
 
-    /* Strip whitespace and response tag */
-    if (g_str_has_prefix (reply, CIND_TAG))
-        reply += strlen (CIND_TAG);
-    while (isspace (*reply))
-        reply++;
-
-    r = g_regex_new ("\\(([^,]*),\\((\\d+)[-,](\\d+).*\\)", G_REGEX_UNGREEDY, 0, NULL);
-    if (!r) {
+    if (!tokenizer_init_response (&tokenizer, reply, CIND_TAG)) {
         g_set_error_literal (error,
                              MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
                              "Could not parse scan results.");
@@ -3171,33 +3109,40 @@ mm_3gpp_parse_cind_test_response (const gchar *reply,
 
     hash = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) cind_response_free);
 
-    if (g_regex_match_full (r, reply, strlen (reply), 0, 0, &match_info, NULL)) {
-        while (g_match_info_matches (match_info)) {
-            MM3gppCindResponse *resp;
-            gchar *desc, *tmp;
-            gint min = 0, max = 0;
-
-            desc = g_match_info_fetch (match_info, 1);
-
-            tmp = g_match_info_fetch (match_info, 2);
-            min = atoi (tmp);
-            g_free (tmp);
-
-            tmp = g_match_info_fetch (match_info, 3);
-            max = atoi (tmp);
-            g_free (tmp);
+    /* Each indicator is given as ("<desc>",(<min>-<max>)) or ("<desc>",(<value>,...)) */
+    while (mm_at_tokenizer_next (&tokenizer, &indicator)) {
+        MMAtTokenizer fields;
+        MMAtTokenizer values;
+        MMAtToken desc;
+        MMAtToken range;
+        MMAtToken value;
+        MM3gppCindResponse *resp;
+        guint min = 0;
+        guint max = 0;
+        guint aux;
+
+        idx++;
+        if (indicator.type != MM_AT_TOKEN_TYPE_GROUP)
+            continue;
 
-            resp = cind_response_new (desc, idx++, min, max);
-            if (resp)
-                g_hash_table_insert (hash, g_strdup (resp->desc), resp);
+        mm_at_tokenizer_init_group (&fields, &indicator);
+        if (!mm_at_tokenizer_next (&fields, &desc) ||
+            !mm_at_tokenizer_next (&fields, &range) ||
+            range.type != MM_AT_TOKEN_TYPE_GROUP)
+            continue;
 
-            g_free (desc);
+        mm_at_tokenizer_init_group (&values, &range);
+        if (!mm_at_tokenizer_next (&values, &value) ||
+            !mm_at_token_get_range (&value, &min, &max))
+            continue;
+        /* In lists of values, the last one is the maximum */
+        while (mm_at_tokenizer_next (&values, &value))
+            mm_at_token_get_range (&value, &aux, &max);
 
-            g_match_info_next (match_info, NULL);
-        }
+        resp = cind_response_new (desc.str, desc.len, idx, (gint) min, (gint) max);
+        if (resp)
+            g_hash_table_insert (hash, g_strdup (resp->desc), resp);
     }
-    g_match_info_free (match_info);
-    g_regex_unref (r);
 
     return hash;
 }
@@ -3225,7 +3170,7 @@ mm_3gpp_parse_cind_read_response (const gchar *reply,
 
     reply = mm_strip_tag (reply, CIND_TAG);
 
-    r = g_regex_new ("(\\d+)[^0-9]+", G_REGEX_UNGREEDY, 0, NULL);
+    r = mm_regex_get ("(\\d+)[^0-9]+", G_REGEX_UNGREEDY, 0, NULL);
     g_assert (r != NULL);
 
     if (!g_regex_match_full (r, reply, strlen (reply), 0, 0, &match_info, NULL)) {
@@ -3385,11 +3330,11 @@ mm_3gpp_parse_cgev_indication_pdp (const gchar  *str,
               type == MM_3GPP_CGEV_NW_DEACT_PDP ||
               type == MM_3GPP_CGEV_ME_DEACT_PDP);
 
-    r = g_regex_new ("(?:"
-                     "REJECT|"
-                     "NW REACT|"
-                     "NW DEACT|ME DEACT"
-                     ")\\s*([^,]*),\\s*([^,]*)(?:,\\s*([0-9]+))?", 0, 0, NULL);
+    r = mm_regex_get ("(?:"
+                      "REJECT|"
+                      "NW REACT|"
+                      "NW DEACT|ME DEACT"
+                      ")\\s*([^,]*),\\s*([^,]*)(?:,\\s*([0-9]+))?", 0, 0, NULL);
 
     str = mm_strip_tag (str, "+CGEV:");
     g_regex_match_full (r, str, strlen (str), 0, 0, &match_info, &inner_error);
@@ -3469,10 +3414,10 @@ mm_3gpp_parse_cgev_indication_primary (const gchar  *str,
               (type == MM_3GPP_CGEV_NW_DEACT_PRIMARY) ||
               (type == MM_3GPP_CGEV_ME_DEACT_PRIMARY));
 
-    r = g_regex_new ("(?:"
-                     "NW PDN ACT|ME PDN ACT|"
-                     "NW PDN DEACT|ME PDN DEACT|"
-                     ")\\s*([0-9]+)", 0, 0, NULL);
+    r = mm_regex_get ("(?:"
+                      "NW PDN ACT|ME PDN ACT|"
+                      "NW PDN DEACT|ME PDN DEACT|"
+                      ")\\s*([0-9]+)", 0, 0, NULL);
 
     str = mm_strip_tag (str, "+CGEV:");
     g_regex_match_full (r, str, strlen (str), 0, 0, &match_info, &inner_error);
@@ -3530,10 +3475,10 @@ mm_3gpp_parse_cgev_indication_secondary (const gchar  *str,
               type == MM_3GPP_CGEV_NW_DEACT_SECONDARY ||
               type == MM_3GPP_CGEV_ME_DEACT_SECONDARY);
 
-    r = g_regex_new ("(?:"
-                     "NW ACT|ME ACT|"
-                     "NW DEACT|ME DEACT"
-                     ")\\s*([0-9]+),\\s*([0-9]+),\\s*([0-9]+)", 0, 0, NULL);
+    r = mm_regex_get ("(?:"
+                      "NW ACT|ME ACT|"
+                      "NW DEACT|ME DEACT"
+                      ")\\s*([0-9]+),\\s*([0-9]+),\\s*([0-9]+)", 0, 0, NULL);
 
     str = mm_strip_tag (str, "+CGEV:");
     g_regex_match_full (r, str, strlen (str), 0, 0, &match_info, &inner_error);
@@ -3598,52 +3543,47 @@ GList *
 mm_3gpp_parse_pdu_cmgl_response (const gchar *str,
                                  GError **error)
 {
-    GError *inner_error = NULL;
+    MMAtTokenizer tokenizer;
     GList *list = NULL;
-    GMatchInfo *match_info;
-    GRegex *r;
 
     /*
      * +CMGL: <index>, <status>, [<alpha>], <length>
      *   or
      * +CMGL: <index>, <status>, <length>
      *
-     * We just read <index>, <stat> and the PDU itself.
+     * We just read <index>, <stat> and the PDU itself, which comes in the
+     * next line.
      */
-    r = g_regex_new ("\\+CMGL:\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,(.*)\\r\\n([^\\r\\n]*)(\\r\\n)?",
-                     G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (r != NULL);
-
-    g_regex_match_full (r, str, strlen (str), 0, 0, &match_info, &inner_error);
-    while (!inner_error && g_match_info_matches (match_info)) {
+    mm_at_tokenizer_init (&tokenizer, str, -1);
+    while (mm_at_tokenizer_next_line (&tokenizer, "+CMGL:")) {
         MM3gppPduInfo *info;
+        MMAtToken index_token;
+        MMAtToken status_token;
+        MMAtToken pdu_token;
 
         info = g_new0 (MM3gppPduInfo, 1);
-        if (mm_get_int_from_match_info (match_info, 1, &info->index) &&
-            mm_get_int_from_match_info (match_info, 2, &info->status) &&
-            (info->pdu = mm_get_string_unquoted_from_match_info (match_info, 4)) != NULL) {
-            /* Append to our list of results and keep on */
-            list = g_list_append (list, info);
-            g_match_info_next (match_info, &inner_error);
-        } else {
+        if (!mm_at_tokenizer_next (&tokenizer, &index_token) ||
+            !mm_at_token_get_int (&index_token, &info->index) ||
+            !mm_at_tokenizer_next (&tokenizer, &status_token) ||
+            !mm_at_token_get_int (&status_token, &info->status) ||
+            !mm_at_tokenizer_next_line (&tokenizer, NULL) ||
+            !mm_at_tokenizer_rest (&tokenizer, &pdu_token)) {
             mm_3gpp_pdu_info_free (info);
-            inner_error = g_error_new (MM_CORE_ERROR,
-                                       MM_CORE_ERROR_FAILED,
-                                       "Error parsing +CMGL response: '%s'",
-                                       str);
+            mm_3gpp_pdu_info_list_free (list);
+            g_set_error (error,
+                         MM_CORE_ERROR,
+                         MM_CORE_ERROR_FAILED,
+                         "Error parsing +CMGL response: '%s'",
+                         str);
+            return NULL;
         }
-    }
 
-    g_match_info_free (match_info);
-    g_regex_unref (r);
-
-    if (inner_error) {
-        g_propagate_error (error, inner_error);
-        mm_3gpp_pdu_info_list_free (list);
-        return NULL;
+        /* Append to our list of results and keep on */
+        info->pdu = mm_at_token_dup (&pdu_token);
+        list = g_list_prepend (list, info);
     }
 
-    return list;
+    return g_list_reverse (list);
 }
 
 /*************************************************************************/
@@ -4290,9 +4230,9 @@ mm_cdma_parse_crm_test_response (const gchar *reply,
      *   <--- +CRM: (0-2)
      */
 
-    r = g_regex_new ("\\+CRM:\\s*\\((\\d+)-(\\d+)\\)",
-                     G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
-                     0, error);
+    r = mm_regex_get ("\\+CRM:\\s*\\((\\d+)-(\\d+)\\)",
+                      G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
+                      0, error);
     g_assert (r != NULL);
 
     if (g_regex_match_full (r, reply, strlen (reply), 0, 0, &match_info, &match_error)) {
@@ -4578,7 +4518,7 @@ mm_parse_cclk_response (const char *response,
      *  +CCLK: "15/03/05,14:14:26-32"
      *  +CCLK: 17/07/26,11:42:15+01
      */
-    r = g_regex_new ("\\+CCLK:\\s*\"?(\\d+)/(\\d+)/(\\d+),(\\d+):(\\d+):(\\d+)([-+]\\d+)?\"?", 0, 0, NULL);
+    r = mm_regex_get ("\\+CCLK:\\s*\"?(\\d+)/(\\d+)/(\\d+),(\\d+):(\\d+):(\\d+)([-+]\\d+)?\"?", 0, 0, NULL);
     g_assert (r != NULL);
 
     if (!g_regex_match_full (r, response, -1, 0, 0, &match_info, &match_error)) {
@@ -4670,7 +4610,7 @@ mm_parse_csim_response (const gchar *response,
     guint hex_code;
     GError *inner_error = NULL;
 
-    r = g_regex_new ("\\+CSIM:\\s*[0-9]+,\\s*\".*([0-9a-fA-F]{4})\"", G_REGEX_RAW, 0, NULL);
+    r = mm_regex_get ("\\+CSIM:\\s*[0-9]+,\\s*\".*([0-9a-fA-F]{4})\"", G_REGEX_RAW, 0, NULL);
     g_regex_match (r, response, 0, &match_info);
 
     if (!g_match_info_matches (match_info)) {
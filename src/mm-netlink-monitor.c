@@ -0,0 +1,421 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/if.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#include "mm-netlink-monitor.h"
+#include "mm-poll-scheduler.h"
+#include "mm-log.h"
+
+#define RECEIVE_BUFFER_SIZE 16384
+
+typedef struct {
+    guint                 id;
+    gchar                *ifname;
+    MMNetlinkMonitorFunc  func;
+    gpointer              user_data;
+} Watch;
+
+struct _MMNetlinkMonitor {
+    gint        fd;
+    GIOChannel *channel;
+    guint       channel_id;
+    guint32     seq;
+    /* Watches, in the order they were added */
+    GList      *watches;
+    guint       next_id;
+    /* Job requesting the byte counters */
+    guint       stats_job_id;
+    guint       stats_interval;
+    /* Aligned for the netlink headers */
+    guint32     buffer[RECEIVE_BUFFER_SIZE / sizeof (guint32)];
+};
+
+/*****************************************************************************/
+
+void
+mm_netlink_stats_base_update (MMNetlinkStatsBase      *base,
+                              const MMNetlinkLinkInfo *info,
+                              guint64                 *rx_bytes,
+                              guint64                 *tx_bytes)
+{
+    if (!base->set || info->rx_bytes < base->rx_kernel || info->tx_bytes < base->tx_kernel) {
+        base->set = TRUE;
+        base->rx_kernel = info->rx_bytes;
+        base->tx_kernel = info->tx_bytes;
+        base->rx_exposed = *rx_bytes;
+        base->tx_exposed = *tx_bytes;
+    }
+
+    *rx_bytes = base->rx_exposed + (info->rx_bytes - base->rx_kernel);
+    *tx_bytes = base->tx_exposed + (info->tx_bytes - base->tx_kernel);
+}
+
+/*****************************************************************************/
+
+gboolean
+mm_netlink_link_info_parse (gconstpointer      message,
+                            gsize              length,
+                            MMNetlinkLinkInfo *info)
+{
+    struct nlmsghdr  *hdr = (struct nlmsghdr *) message;
+    struct ifinfomsg *ifi;
+    struct rtattr    *rta;
+    gint              rta_len;
+    gboolean          has_stats64 = FALSE;
+
+    if (length < NLMSG_LENGTH (sizeof (struct ifinfomsg)) ||
+        hdr->nlmsg_len < NLMSG_LENGTH (sizeof (struct ifinfomsg)) ||
+        hdr->nlmsg_len > length)
+        return FALSE;
+
+    if (hdr->nlmsg_type != RTM_NEWLINK && hdr->nlmsg_type != RTM_DELLINK)
+        return FALSE;
+
+    memset (info, 0, sizeof (*info));
+    ifi = NLMSG_DATA (hdr);
+    info->removed = (hdr->nlmsg_type == RTM_DELLINK);
+    info->up = !!(ifi->ifi_flags & IFF_UP);
+    info->carrier = !!(ifi->ifi_flags & IFF_LOWER_UP);
+
+    rta_len = IFLA_PAYLOAD (hdr);
+    for (rta = IFLA_RTA (ifi); RTA_OK (rta, rta_len); rta = RTA_NEXT (rta, rta_len)) {
+        switch (rta->rta_type) {
+        case IFLA_IFNAME:
+            memcpy (info->ifname, RTA_DATA (rta), MIN (RTA_PAYLOAD (rta), sizeof (info->ifname) - 1));
+            break;
+        case IFLA_STATS64: {
+            struct rtnl_link_stats64 stats;
+
+            /* Newer kernels may append fields, older ones may lack the last ones */
+            if (RTA_PAYLOAD (rta) < G_STRUCT_OFFSET (struct rtnl_link_stats64, rx_errors))
+                break;
+            memset (&stats, 0, sizeof (stats));
+            memcpy (&stats, RTA_DATA (rta), MIN (RTA_PAYLOAD (rta), sizeof (stats)));
+            info->has_stats = TRUE;
+            info->rx_bytes = stats.rx_bytes;
+            info->tx_bytes = stats.tx_bytes;
+            has_stats64 = TRUE;
+            break;
+        }
+        case IFLA_STATS: {
+            struct rtnl_link_stats stats;
+
+            if (has_stats64 || RTA_PAYLOAD (rta) < G_STRUCT_OFFSET (struct rtnl_link_stats, rx_errors))
+                break;
+            memset (&stats, 0, sizeof (stats));
+            memcpy (&stats, RTA_DATA (rta), MIN (RTA_PAYLOAD (rta), sizeof (stats)));
+            info->has_stats = TRUE;
+            info->rx_bytes = stats.rx_bytes;
+            info->tx_bytes = stats.tx_bytes;
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    return (info->ifname[0] != '\0');
+}
+
+/*****************************************************************************/
+
+static Watch *
+find_watch (MMNetlinkMonitor *self,
+            guint             id)
+{
+    GList *l;
+
+    for (l = self->watches; l; l = g_list_next (l)) {
+        if (((Watch *) l->data)->id == id)
+            return (Watch *) l->data;
+    }
+    return NULL;
+}
+
+static void
+dispatch_link_info (MMNetlinkMonitor        *self,
+                    const MMNetlinkLinkInfo *info)
+{
+    GList  *l;
+    GSList *ids = NULL;
+    GSList *k;
+
+    /* Callbacks may remove watches, so look them up again before running each */
+    for (l = self->watches; l; l = g_list_next (l)) {
+        if (g_str_equal (((Watch *) l->data)->ifname, info->ifname))
+            ids = g_slist_prepend (ids, GUINT_TO_POINTER (((Watch *) l->data)->id));
+    }
+    ids = g_slist_reverse (ids);
+
+    for (k = ids; k; k = g_slist_next (k)) {
+        Watch *watch;
+
+        watch = find_watch (self, GPOINTER_TO_UINT (k->data));
+        if (watch)
+            watch->func (info, watch->user_data);
+    }
+    g_slist_free (ids);
+}
+
+static void
+process_messages (MMNetlinkMonitor *self,
+                  gsize             length)
+{
+    struct nlmsghdr *hdr;
+    gint             len = (gint) length;
+
+    for (hdr = (struct nlmsghdr *) self->buffer; NLMSG_OK (hdr, len); hdr = NLMSG_NEXT (hdr, len)) {
+        MMNetlinkLinkInfo info;
+
+        if (hdr->nlmsg_type == NLMSG_ERROR) {
+            struct nlmsgerr *err = NLMSG_DATA (hdr);
+
+            /* e.g. ENODEV if the interface is already gone */
+            if (err->error)
+                mm_dbg ("Netlink request %u failed: %s", err->msg.nlmsg_seq, g_strerror (-err->error));
+            continue;
+        }
+
+        if (mm_netlink_link_info_parse (hdr, hdr->nlmsg_len, &info))
+            dispatch_link_info (self, &info);
+    }
+}
+
+static gboolean
+receive_cb (GIOChannel       *channel,
+            GIOCondition      condition,
+            MMNetlinkMonitor *self)
+{
+    gint fd = self->fd;
+
+    while (fd >= 0 && fd == self->fd) {
+        struct sockaddr_nl addr;
+        socklen_t          addr_len = sizeof (addr);
+        ssize_t            received;
+
+        received = recvfrom (fd, self->buffer, sizeof (self->buffer), 0, (struct sockaddr *) &addr, &addr_len);
+        if (received < 0) {
+            if (errno == EINTR)
+                continue;
+            /* Notifications were lost; the periodic requests recover the
+             * byte counters, and the link flags come with them */
+            if (errno == ENOBUFS) {
+                mm_dbg ("Netlink socket overrun, notifications lost");
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                mm_warn ("Couldn't receive from netlink socket: %s", g_strerror (errno));
+            break;
+        }
+        if (received == 0)
+            break;
+
+        /* Only the kernel may tell us about links; any other process may
+         * send messages to our port */
+        if (addr_len != sizeof (addr) || addr.nl_family != AF_NETLINK || addr.nl_pid != 0) {
+            mm_dbg ("Ignoring netlink message not sent by the kernel");
+            continue;
+        }
+
+        process_messages (self, (gsize) received);
+    }
+
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+static void
+request_link_info (MMNetlinkMonitor *self,
+                   const gchar      *ifname)
+{
+    struct {
+        struct nlmsghdr  hdr;
+        struct ifinfomsg ifi;
+        gchar            attrs[RTA_SPACE (IFNAMSIZ)];
+    } request;
+    struct rtattr *rta;
+    gsize          ifname_len;
+
+    ifname_len = strlen (ifname) + 1;
+
+    memset (&request, 0, sizeof (request));
+    request.hdr.nlmsg_type = RTM_GETLINK;
+    request.hdr.nlmsg_flags = NLM_F_REQUEST;
+    request.hdr.nlmsg_seq = ++self->seq;
+    request.ifi.ifi_family = AF_UNSPEC;
+
+    /* Looked up by name, so that no interface index is ever stale */
+    rta = (struct rtattr *) request.attrs;
+    rta->rta_type = IFLA_IFNAME;
+    rta->rta_len = RTA_LENGTH (ifname_len);
+    memcpy (RTA_DATA (rta), ifname, ifname_len);
+    request.hdr.nlmsg_len = NLMSG_LENGTH (sizeof (struct ifinfomsg)) + RTA_ALIGN (rta->rta_len);
+
+    if (send (self->fd, &request, request.hdr.nlmsg_len, 0) < 0)
+        mm_dbg ("Couldn't request link info of '%s': %s", ifname, g_strerror (errno));
+}
+
+static void
+stats_job_cb (MMNetlinkMonitor *self)
+{
+    GList *l;
+
+    for (l = self->watches; l; l = g_list_next (l))
+        request_link_info (self, ((Watch *) l->data)->ifname);
+}
+
+static void
+netlink_monitor_close (MMNetlinkMonitor *self)
+{
+    if (self->stats_job_id) {
+        mm_poll_scheduler_remove (mm_poll_scheduler_get (), self->stats_job_id);
+        self->stats_job_id = 0;
+    }
+    if (self->channel_id) {
+        g_source_remove (self->channel_id);
+        self->channel_id = 0;
+    }
+    if (self->channel) {
+        g_io_channel_unref (self->channel);
+        self->channel = NULL;
+    }
+    if (self->fd >= 0) {
+        close (self->fd);
+        self->fd = -1;
+    }
+}
+
+static gboolean
+netlink_monitor_open (MMNetlinkMonitor *self)
+{
+    struct sockaddr_nl addr;
+
+    self->fd = socket (AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+    if (self->fd < 0) {
+        mm_warn ("Couldn't open netlink socket: %s", g_strerror (errno));
+        return FALSE;
+    }
+
+    /* Link notifications */
+    memset (&addr, 0, sizeof (addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK;
+    if (bind (self->fd, (struct sockaddr *) &addr, sizeof (addr)) < 0) {
+        mm_warn ("Couldn't bind netlink socket: %s", g_strerror (errno));
+        close (self->fd);
+        self->fd = -1;
+        return FALSE;
+    }
+
+    self->channel = g_io_channel_unix_new (self->fd);
+    self->channel_id = g_io_add_watch (self->channel,
+                                       G_IO_IN | G_IO_ERR | G_IO_HUP,
+                                       (GIOFunc) receive_cb,
+                                       self);
+    self->stats_job_id = mm_poll_scheduler_add (mm_poll_scheduler_get (),
+                                                "netlink",
+                                                "link-stats",
+                                                self->stats_interval,
+                                                0,
+                                                (MMPollSchedulerFunc) stats_job_cb,
+                                                self);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+guint
+mm_netlink_monitor_add (MMNetlinkMonitor     *self,
+                        const gchar          *ifname,
+                        MMNetlinkMonitorFunc  func,
+                        gpointer              user_data)
+{
+    Watch *watch;
+
+    if (!ifname || !ifname[0] || strlen (ifname) >= IFNAMSIZ)
+        return 0;
+
+    /* The socket is only open while there are watches */
+    if (self->fd < 0 && !netlink_monitor_open (self))
+        return 0;
+
+    watch = g_slice_new0 (Watch);
+    watch->id = ++self->next_id;
+    if (G_UNLIKELY (!watch->id))
+        watch->id = ++self->next_id;
+    watch->ifname = g_strdup (ifname);
+    watch->func = func;
+    watch->user_data = user_data;
+    self->watches = g_list_append (self->watches, watch);
+
+    request_link_info (self, ifname);
+    return watch->id;
+}
+
+void
+mm_netlink_monitor_remove (MMNetlinkMonitor *self,
+                           guint             id)
+{
+    Watch *watch;
+
+    watch = find_watch (self, id);
+    if (!watch)
+        return;
+
+    self->watches = g_list_remove (self->watches, watch);
+    g_free (watch->ifname);
+    g_slice_free (Watch, watch);
+
+    if (!self->watches)
+        netlink_monitor_close (self);
+}
+
+void
+mm_netlink_monitor_set_stats_interval (MMNetlinkMonitor *self,
+                                       guint             interval)
+{
+    g_return_if_fail (interval > 0);
+
+    self->stats_interval = interval;
+    if (self->stats_job_id)
+        mm_poll_scheduler_set_interval (mm_poll_scheduler_get (), self->stats_job_id, interval, 0);
+}
+
+guint
+mm_netlink_monitor_get_stats_interval (MMNetlinkMonitor *self)
+{
+    return self->stats_interval;
+}
+
+MMNetlinkMonitor *
+mm_netlink_monitor_get (void)
+{
+    static MMNetlinkMonitor *shared;
+
+    if (G_UNLIKELY (!shared)) {
+        shared = g_slice_new0 (MMNetlinkMonitor);
+        shared->fd = -1;
+        shared->stats_interval = MM_NETLINK_MONITOR_STATS_INTERVAL_SEC;
+    }
+    return shared;
+}
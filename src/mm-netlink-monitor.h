@@ -0,0 +1,92 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#ifndef MM_NETLINK_MONITOR_H
+#define MM_NETLINK_MONITOR_H
+
+#include <glib.h>
+
+/* Monitor of the network interfaces used by the connected bearers, shared by
+ * all of them through a single rtnetlink socket. Link changes (carrier, up,
+ * removal) are reported as soon as the kernel notifies them; the kernel never
+ * notifies traffic, so the byte counters are requested for all the watched
+ * interfaces at once in a periodic job of the poll scheduler. None of this
+ * involves talking to the modem. */
+
+/* Default interval of the byte counters requests */
+#define MM_NETLINK_MONITOR_STATS_INTERVAL_SEC 5
+
+typedef struct {
+    /* IFNAMSIZ */
+    gchar    ifname[16];
+    /* RTM_DELLINK */
+    gboolean removed;
+    /* IFF_UP and IFF_LOWER_UP */
+    gboolean up;
+    gboolean carrier;
+    /* IFLA_STATS64, or IFLA_STATS if not available */
+    gboolean has_stats;
+    guint64  rx_bytes;
+    guint64  tx_bytes;
+} MMNetlinkLinkInfo;
+
+typedef struct _MMNetlinkMonitor MMNetlinkMonitor;
+
+typedef void (* MMNetlinkMonitorFunc) (const MMNetlinkLinkInfo *info,
+                                       gpointer                 user_data);
+
+/* Shared monitor, run in the default main context */
+MMNetlinkMonitor *mm_netlink_monitor_get    (void);
+
+/* Returns the watch id, or 0 if the interface cannot be monitored. The
+ * current link info is requested right away. */
+guint             mm_netlink_monitor_add    (MMNetlinkMonitor      *self,
+                                             const gchar           *ifname,
+                                             MMNetlinkMonitorFunc   func,
+                                             gpointer               user_data);
+void              mm_netlink_monitor_remove (MMNetlinkMonitor      *self,
+                                             guint                  id);
+
+/* Interval of the byte counters requests, in seconds */
+void              mm_netlink_monitor_set_stats_interval (MMNetlinkMonitor *self,
+                                                         guint             interval);
+guint             mm_netlink_monitor_get_stats_interval (MMNetlinkMonitor *self);
+
+/* Kernel byte counters of a link exposed as the bearer stats, which must never
+ * go back: on the first report, and whenever the kernel counters start over
+ * (e.g. the interface was re-created), the base is moved to the new kernel
+ * counters and the stats continue from the values exposed so far. */
+typedef struct {
+    gboolean set;
+    /* Kernel counters and exposed values at the last rebase */
+    guint64  rx_kernel;
+    guint64  tx_kernel;
+    guint64  rx_exposed;
+    guint64  tx_exposed;
+} MMNetlinkStatsBase;
+
+/* Takes the values exposed so far in rx_bytes/tx_bytes, and returns in them
+ * the new ones */
+void              mm_netlink_stats_base_update (MMNetlinkStatsBase      *base,
+                                                const MMNetlinkLinkInfo *info,
+                                                guint64                 *rx_bytes,
+                                                guint64                 *tx_bytes);
+
+/* Parses a single RTM_NEWLINK or RTM_DELLINK message */
+gboolean          mm_netlink_link_info_parse (gconstpointer         message,
+                                              gsize                 length,
+                                              MMNetlinkLinkInfo    *info);
+
+#endif /* MM_NETLINK_MONITOR_H */
@@ -27,6 +27,7 @@
 
 #include "mm-plugin-manager.h"
 #include "mm-plugin.h"
+#include "mm-probe-cache.h"
 #include "mm-log.h"
 
 static void initable_iface_init (GInitableIface *iface);
@@ -57,6 +58,9 @@ struct _MMPluginManagerPrivate {
 
     /* List of ongoing device support checks */
     GList *device_contexts;
+
+    /* Probing results of previously seen devices */
+    MMProbeCache *probe_cache;
 };
 
 /*****************************************************************************/
@@ -164,6 +168,124 @@ common_async_context_new (MMPluginManager *self,
     return common;
 }
 
+/*****************************************************************************/
+/* Probe cache */
+
+static gchar *
+probe_cache_build_key (MMPortProbe *probe)
+{
+    MMKernelDevice *port;
+
+    port = mm_port_probe_peek_port (probe);
+    return mm_probe_cache_build_key (mm_kernel_device_get_physdev_vid (port),
+                                     mm_kernel_device_get_physdev_pid (port),
+                                     mm_kernel_device_get_physdev_revision (port),
+                                     mm_kernel_device_get_property (port, "ID_USB_INTERFACES"),
+                                     mm_kernel_device_get_property (port, "ID_USB_INTERFACE_NUM"),
+                                     mm_kernel_device_get_subsystem (port));
+}
+
+static gint64
+probe_cache_now (void)
+{
+    return g_get_real_time () / G_USEC_PER_SEC;
+}
+
+/* Preloads the cached results in the probe, and sets up the verification of
+ * the main port type. Returns the name of the plugin which managed the port,
+ * or NULL if there are no cached results. */
+static gchar *
+probe_cache_apply (MMPluginManager *self,
+                   MMPortProbe     *probe)
+{
+    gchar             *key;
+    gchar             *plugin = NULL;
+    MMProbeCacheEntry  entry;
+
+    /* Only if nothing probed yet */
+    if (mm_port_probe_get_flags (probe) != MM_PORT_PROBE_NONE)
+        return NULL;
+
+    key = probe_cache_build_key (probe);
+    if (!key || !mm_probe_cache_lookup (self->priv->probe_cache, key, probe_cache_now (), &entry)) {
+        g_free (key);
+        return NULL;
+    }
+
+    mm_dbg ("(%s/%s) loading cached probing results (plugin '%s')",
+            mm_port_probe_get_port_subsys (probe),
+            mm_port_probe_get_port_name (probe),
+            entry.plugin);
+
+    /* The main type of the port is always probed again, so that stale results
+     * (e.g. a port not ready yet when it was probed) are detected with one
+     * single quick command; if the verification fails, everything preloaded
+     * is dropped and the port is fully probed. Only positive results are
+     * cached, so all the other probings run as usual. */
+    switch (entry.type) {
+    case MM_PROBE_CACHE_PORT_TYPE_AT:
+        mm_port_probe_set_cache_verification (probe, MM_PORT_PROBE_AT, TRUE);
+        if (entry.vendor)
+            mm_port_probe_set_result_at_vendor (probe, entry.vendor);
+        if (entry.product)
+            mm_port_probe_set_result_at_product (probe, entry.product);
+        if (entry.icera)
+            mm_port_probe_set_result_at_icera (probe, TRUE);
+        if (entry.xmm)
+            mm_port_probe_set_result_at_xmm (probe, TRUE);
+        break;
+    case MM_PROBE_CACHE_PORT_TYPE_QCDM:
+        mm_port_probe_set_cache_verification (probe, MM_PORT_PROBE_QCDM, TRUE);
+        break;
+    case MM_PROBE_CACHE_PORT_TYPE_QMI:
+        mm_port_probe_set_cache_verification (probe, MM_PORT_PROBE_QMI, TRUE);
+        break;
+    case MM_PROBE_CACHE_PORT_TYPE_MBIM:
+        mm_port_probe_set_cache_verification (probe, MM_PORT_PROBE_MBIM, TRUE);
+        break;
+    case MM_PROBE_CACHE_PORT_TYPE_UNKNOWN:
+    default:
+        g_assert_not_reached ();
+    }
+
+    plugin = g_strdup (entry.plugin);
+    mm_probe_cache_entry_clear (&entry);
+    g_free (key);
+    return plugin;
+}
+
+/* Stores the positive results of the probe, or removes the cached ones if
+ * there are none (e.g. no plugin, or the port is no longer AT) */
+static void
+probe_cache_update (MMPluginManager *self,
+                    MMPortProbe     *probe,
+                    const gchar     *plugin)
+{
+    gchar             *key;
+    MMProbeCacheEntry  entry = { 0 };
+
+    key = probe_cache_build_key (probe);
+    if (!key)
+        return;
+
+    if (mm_port_probe_is_at (probe)) {
+        entry.type    = MM_PROBE_CACHE_PORT_TYPE_AT;
+        entry.vendor  = (gchar *) mm_port_probe_get_vendor (probe);
+        entry.product = (gchar *) mm_port_probe_get_product (probe);
+        entry.icera   = mm_port_probe_is_icera (probe);
+        entry.xmm     = mm_port_probe_is_xmm (probe);
+    } else if (mm_port_probe_is_qcdm (probe))
+        entry.type = MM_PROBE_CACHE_PORT_TYPE_QCDM;
+    else if (mm_port_probe_is_qmi (probe))
+        entry.type = MM_PROBE_CACHE_PORT_TYPE_QMI;
+    else if (mm_port_probe_is_mbim (probe))
+        entry.type = MM_PROBE_CACHE_PORT_TYPE_MBIM;
+    entry.plugin = (gchar *) plugin;
+
+    mm_probe_cache_store (self->priv->probe_cache, key, probe_cache_now (), &entry);
+    g_free (key);
+}
+
 /*****************************************************************************/
 /* Port context */
 
@@ -673,6 +795,11 @@ port_context_new (MMPluginManager *self,
 /* Time to wait for ports to appear before starting to probe the first one */
 #define MIN_WAIT_TIME_MSECS 1500
 
+/* Once every USB interface of the device has exposed a port, the min wait time
+ * finishes earlier if no new port appears during this time */
+#define PORT_SETTLE_TIME_MSECS 500
+G_STATIC_ASSERT (PORT_SETTLE_TIME_MSECS < MIN_WAIT_TIME_MSECS);
+
 /* Time to wait for other ports to appear once the first port is exposed
  * (needs to be > MIN_WAIT_TIME_MSECS!!) */
 #define MIN_PROBING_TIME_MSECS 2500
@@ -710,8 +837,10 @@ struct _DeviceContext {
      * will be the one being returned in the async result */
     MMPlugin *best_plugin;
 
-    /* Minimum wait time. No port probing can start before this timeout expires.
-     * Once the timeout is expired, the id is reset to 0. */
+    /* Minimum wait time. No port probing can start before this timeout expires,
+     * which happens either when MIN_WAIT_TIME_MSECS elapse or, once all the USB
+     * interfaces of the device have ports, when no new port appears during
+     * PORT_SETTLE_TIME_MSECS. Once the timeout is expired, the id is reset to 0. */
     guint min_wait_time_id;
     /* Port support check contexts waiting to be run after min wait time */
     GList *wait_port_contexts;
@@ -1041,9 +1170,22 @@ port_context_run_ready (MMPluginManager    *self,
     } else {
         /* Set the plugin as the best one in the device context */
         device_context_set_best_plugin (common->device_context, common->port_context, best_plugin);
-        g_object_unref (best_plugin);
     }
 
+    /* Store the results for the next time the same device shows up; on
+     * errors other than UNSUPPORTED we don't really know what happened */
+    if (best_plugin || !error) {
+        GObject *probe;
+
+        probe = mm_device_peek_port_probe (common->device_context->device, common->port_context->port);
+        if (probe)
+            probe_cache_update (self,
+                                MM_PORT_PROBE (probe),
+                                best_plugin ? mm_plugin_get_name (best_plugin) : NULL);
+    }
+    if (best_plugin)
+        g_object_unref (best_plugin);
+
     /* We MUST have the port context in the list at this point, because we're
      * going to remove the reference, so assert if this is not true. The caller
      * must always make sure that the port_context is available in the list */
@@ -1078,6 +1220,7 @@ device_context_run_port_context (DeviceContext *device_context,
     GList           *plugins;
     MMPlugin        *suggested = NULL;
     MMPluginManager *self;
+    GObject         *probe;
 
     /* Recover plugin manager */
     self = MM_PLUGIN_MANAGER (device_context->self);
@@ -1094,6 +1237,25 @@ device_context_run_port_context (DeviceContext *device_context,
         suggested = device_context->best_plugin;
     }
 
+    /* If the same port was already probed in an identical device, preload the
+     * cached positive results (the main port type gets verified) and suggest
+     * the plugin which managed it. */
+    probe = mm_device_peek_port_probe (device_context->device, port_context->port);
+    if (probe) {
+        gchar *cached_plugin;
+
+        cached_plugin = probe_cache_apply (self, MM_PORT_PROBE (probe));
+        if (cached_plugin && !suggested && !g_str_equal (cached_plugin, MM_PLUGIN_GENERIC_NAME)) {
+            suggested = mm_plugin_manager_peek_plugin (self, cached_plugin);
+            if (suggested && !g_list_find (plugins, suggested))
+                suggested = NULL;
+            if (suggested)
+                mm_dbg ("[plugin manager] task %s: suggesting cached plugin: %s",
+                        port_context->name, cached_plugin);
+        }
+        g_free (cached_plugin);
+    }
+
     port_context_run (self,
                       port_context,
                       plugins,
@@ -1141,6 +1303,77 @@ device_context_min_wait_time_elapsed (DeviceContext *device_context)
     return G_SOURCE_REMOVE;
 }
 
+/* Checks whether every interface listed in ID_USB_INTERFACES (e.g.
+ * ":020201:0a0000:ff0000:") already has a port waiting. Devices which aren't
+ * USB, or with interfaces not exposing any port, never get there. */
+static gboolean
+device_context_all_interfaces_grabbed (DeviceContext *device_context)
+{
+    GHashTable   *interfaces;
+    const gchar  *usb_interfaces = NULL;
+    gchar       **split;
+    guint         n_expected = 0;
+    gboolean      complete = TRUE;
+    GList        *l;
+    guint         i;
+
+    interfaces = g_hash_table_new (g_str_hash, g_str_equal);
+    for (l = device_context->wait_port_contexts; l && complete; l = g_list_next (l)) {
+        PortContext *port_context = (PortContext *)(l->data);
+        const gchar *num;
+
+        num = mm_kernel_device_get_property (port_context->port, "ID_USB_INTERFACE_NUM");
+        if (!usb_interfaces)
+            usb_interfaces = mm_kernel_device_get_property (port_context->port, "ID_USB_INTERFACES");
+        if (!num || !usb_interfaces)
+            complete = FALSE;
+        else
+            g_hash_table_add (interfaces, (gpointer) num);
+    }
+
+    if (complete) {
+        split = g_strsplit (usb_interfaces, ":", -1);
+        for (i = 0; split[i]; i++) {
+            if (split[i][0])
+                n_expected++;
+        }
+        g_strfreev (split);
+        complete = (n_expected > 0 && g_hash_table_size (interfaces) >= n_expected);
+    }
+
+    g_hash_table_unref (interfaces);
+    return complete;
+}
+
+static void
+device_context_reschedule_min_wait_time (DeviceContext *device_context)
+{
+    gdouble elapsed_msecs;
+    guint   timeout_msecs;
+
+    g_assert (device_context->min_wait_time_id);
+
+    /* Until all the expected ports are there, keep on waiting the whole min
+     * wait time, as more may still appear */
+    if (!device_context_all_interfaces_grabbed (device_context))
+        return;
+
+    g_source_remove (device_context->min_wait_time_id);
+
+    /* Wait for other ports of the same interfaces during the settle time, but
+     * never for longer than the min wait time since the device context was
+     * started */
+    elapsed_msecs = g_timer_elapsed (device_context->timer, NULL) * 1000.0;
+    if (elapsed_msecs >= MIN_WAIT_TIME_MSECS)
+        timeout_msecs = 0;
+    else
+        timeout_msecs = MIN (PORT_SETTLE_TIME_MSECS, MIN_WAIT_TIME_MSECS - (guint) elapsed_msecs);
+
+    device_context->min_wait_time_id = g_timeout_add (timeout_msecs,
+                                                      (GSourceFunc) device_context_min_wait_time_elapsed,
+                                                      device_context);
+}
+
 static void
 device_context_port_released (DeviceContext  *device_context,
                               MMKernelDevice *port)
@@ -1217,6 +1450,8 @@ device_context_port_grabbed (DeviceContext  *device_context,
                 port_context->name);
         /* Store the port reference in the list within the device */
         device_context->wait_port_contexts = g_list_prepend (device_context->wait_port_contexts, port_context);
+        /* And give some more time to other ports to appear */
+        device_context_reschedule_min_wait_time (device_context);
         return;
     }
 
@@ -1707,8 +1942,13 @@ initable_init (GInitable *initable,
                GCancellable *cancellable,
                GError **error)
 {
+    MMPluginManager *self = MM_PLUGIN_MANAGER (initable);
+
+    /* Load the probing results of previously seen devices */
+    self->priv->probe_cache = mm_probe_cache_new (PKGSTATEDIR "/probe-cache");
+
     /* Load the list of plugins */
-    return load_plugins (MM_PLUGIN_MANAGER (initable), error);
+    return load_plugins (self, error);
 }
 
 static void
@@ -1728,6 +1968,8 @@ dispose (GObject *object)
 
     g_clear_object (&self->priv->filter);
 
+    g_clear_pointer (&self->priv->probe_cache, mm_probe_cache_free);
+
     G_OBJECT_CLASS (mm_plugin_manager_parent_class)->dispose (object);
 }
 
@@ -0,0 +1,436 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include "mm-poll-scheduler.h"
+
+#define SLOT_USEC ((gint64) MM_POLL_SCHEDULER_SLOT_SEC * G_USEC_PER_SEC)
+
+typedef struct {
+    guint                id;
+    gchar               *owner;
+    gchar               *name;
+    MMPollSchedulerFunc  func;
+    gpointer             user_data;
+
+    /* Intervals, in seconds */
+    guint                base_interval;
+    guint                max_interval;
+    guint                interval;
+
+    /* Monotonic time of the last run (or touch), and of the next run */
+    gint64               last;
+    gint64               due;
+
+    guint64              n_runs;
+    guint64              n_satisfied;
+} PollJob;
+
+struct _MMPollScheduler {
+    /* Job id -> PollJob */
+    GHashTable *jobs;
+    guint       last_id;
+
+    /* Either run in the main context, or with the time given by the user */
+    gboolean    attached;
+    gint64      now;
+    guint       source_id;
+    gint64      source_wakeup;
+    gboolean    dispatching;
+
+    guint64     n_wakeups;
+    guint64     n_runs;
+    guint64     n_satisfied;
+};
+
+static void reschedule (MMPollScheduler *self);
+
+/*****************************************************************************/
+
+static void
+poll_job_free (PollJob *job)
+{
+    g_free (job->owner);
+    g_free (job->name);
+    g_slice_free (PollJob, job);
+}
+
+static gint64
+get_time (MMPollScheduler *self)
+{
+    return (self->attached ? g_get_monotonic_time () : self->now);
+}
+
+static gint64
+get_early_usec (PollJob *job)
+{
+    return ((gint64) job->interval * G_USEC_PER_SEC) / 4;
+}
+
+static void
+poll_job_update_due (PollJob *job)
+{
+    gint64 target;
+    gint64 granularity;
+
+    /* Long intervals are aligned to the slots shared by all jobs, short ones
+     * just to the second */
+    target = job->last + (gint64) job->interval * G_USEC_PER_SEC;
+    granularity = (job->interval >= 2 * MM_POLL_SCHEDULER_SLOT_SEC) ? SLOT_USEC : G_USEC_PER_SEC;
+    job->due = ((target + granularity / 2) / granularity) * granularity;
+}
+
+/*****************************************************************************/
+
+typedef struct {
+    guint  id;
+    gint64 due;
+} DueJob;
+
+static gint
+due_job_cmp (const DueJob *a,
+             const DueJob *b)
+{
+    if (a->due != b->due)
+        return (a->due < b->due) ? -1 : 1;
+    return (a->id < b->id) ? -1 : (a->id > b->id);
+}
+
+static GArray *
+collect_jobs (MMPollScheduler *self,
+              gint64           early_until)
+{
+    GHashTableIter  iter;
+    PollJob        *job;
+    GArray         *array;
+
+    array = g_array_sized_new (FALSE, FALSE, sizeof (DueJob), g_hash_table_size (self->jobs));
+    g_hash_table_iter_init (&iter, self->jobs);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&job)) {
+        DueJob due_job;
+
+        if (early_until >= 0 && (job->due - get_early_usec (job)) > early_until)
+            continue;
+        due_job.id = job->id;
+        due_job.due = job->due;
+        g_array_append_val (array, due_job);
+    }
+    g_array_sort (array, (GCompareFunc) due_job_cmp);
+    return array;
+}
+
+void
+mm_poll_scheduler_dispatch (MMPollScheduler *self)
+{
+    GArray *due_jobs;
+    gint64  now;
+    gint64  wakeup;
+    guint   i;
+
+    now = get_time (self);
+
+    /* Nothing to do unless at least one job is really due */
+    wakeup = mm_poll_scheduler_get_next_wakeup (self);
+    if (wakeup < 0 || wakeup > now)
+        return;
+
+    /* Run the jobs due now, and also the ones due soon, so that they are
+     * aligned with this wakeup from now on. Jobs are looked up again before
+     * running, as callbacks may remove other jobs. */
+    self->n_wakeups++;
+    self->dispatching = TRUE;
+    due_jobs = collect_jobs (self, now);
+    for (i = 0; i < due_jobs->len; i++) {
+        PollJob *job;
+
+        job = g_hash_table_lookup (self->jobs, GUINT_TO_POINTER (g_array_index (due_jobs, DueJob, i).id));
+        if (!job)
+            continue;
+
+        job->last = now;
+        poll_job_update_due (job);
+        job->n_runs++;
+        self->n_runs++;
+
+        /* Note: may remove the job */
+        job->func (job->user_data);
+    }
+    g_array_unref (due_jobs);
+    self->dispatching = FALSE;
+
+    reschedule (self);
+}
+
+gint64
+mm_poll_scheduler_get_next_wakeup (MMPollScheduler *self)
+{
+    GHashTableIter  iter;
+    PollJob        *job;
+    gint64          wakeup = -1;
+
+    g_hash_table_iter_init (&iter, self->jobs);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&job)) {
+        if (wakeup < 0 || job->due < wakeup)
+            wakeup = job->due;
+    }
+    return wakeup;
+}
+
+static gboolean
+scheduler_source_cb (MMPollScheduler *self)
+{
+    self->source_id = 0;
+    mm_poll_scheduler_dispatch (self);
+    /* Always rearm, even if the wakeup was too early */
+    reschedule (self);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+reschedule (MMPollScheduler *self)
+{
+    gint64 wakeup;
+    gint64 delay;
+
+    /* Manual schedulers are dispatched by the user, and while dispatching
+     * we'll reschedule once all jobs have run */
+    if (!self->attached || self->dispatching)
+        return;
+
+    wakeup = mm_poll_scheduler_get_next_wakeup (self);
+    if (self->source_id && wakeup == self->source_wakeup)
+        return;
+
+    if (self->source_id) {
+        g_source_remove (self->source_id);
+        self->source_id = 0;
+    }
+    if (wakeup < 0)
+        return;
+
+    /* Second-based timeouts are coalesced by GLib with any other ones in the
+     * process, and never fire before the given time */
+    delay = wakeup - get_time (self);
+    self->source_wakeup = wakeup;
+    self->source_id = g_timeout_add_seconds (delay > 0 ? (guint) ((delay + G_USEC_PER_SEC - 1) / G_USEC_PER_SEC) : 0,
+                                             (GSourceFunc) scheduler_source_cb,
+                                             self);
+}
+
+/*****************************************************************************/
+
+guint
+mm_poll_scheduler_add (MMPollScheduler     *self,
+                       const gchar         *owner,
+                       const gchar         *name,
+                       guint                interval,
+                       guint                max_interval,
+                       MMPollSchedulerFunc  func,
+                       gpointer             user_data)
+{
+    PollJob *job;
+
+    g_return_val_if_fail (interval > 0, 0);
+    g_return_val_if_fail (func != NULL, 0);
+
+    job = g_slice_new0 (PollJob);
+    do {
+        job->id = ++self->last_id;
+    } while (!job->id || g_hash_table_contains (self->jobs, GUINT_TO_POINTER (job->id)));
+    job->owner = g_strdup (owner);
+    job->name = g_strdup (name);
+    job->func = func;
+    job->user_data = user_data;
+    job->base_interval = interval;
+    job->max_interval = MAX (interval, max_interval);
+    job->interval = interval;
+    job->last = get_time (self);
+    poll_job_update_due (job);
+
+    g_hash_table_insert (self->jobs, GUINT_TO_POINTER (job->id), job);
+    reschedule (self);
+    return job->id;
+}
+
+void
+mm_poll_scheduler_remove (MMPollScheduler *self,
+                          guint            id)
+{
+    if (g_hash_table_remove (self->jobs, GUINT_TO_POINTER (id)))
+        reschedule (self);
+}
+
+void
+mm_poll_scheduler_set_interval (MMPollScheduler *self,
+                                guint            id,
+                                guint            interval,
+                                guint            max_interval)
+{
+    PollJob *job;
+
+    g_return_if_fail (interval > 0);
+
+    job = g_hash_table_lookup (self->jobs, GUINT_TO_POINTER (id));
+    if (!job)
+        return;
+
+    job->base_interval = interval;
+    job->max_interval = MAX (interval, max_interval);
+    job->interval = interval;
+    job->last = get_time (self);
+    poll_job_update_due (job);
+    reschedule (self);
+}
+
+void
+mm_poll_scheduler_touch (MMPollScheduler *self,
+                         guint            id)
+{
+    PollJob *job;
+
+    job = g_hash_table_lookup (self->jobs, GUINT_TO_POINTER (id));
+    if (!job)
+        return;
+
+    job->n_satisfied++;
+    self->n_satisfied++;
+    job->last = get_time (self);
+    poll_job_update_due (job);
+    reschedule (self);
+}
+
+void
+mm_poll_scheduler_skip (MMPollScheduler *self,
+                        guint            id)
+{
+    PollJob *job;
+
+    job = g_hash_table_lookup (self->jobs, GUINT_TO_POINTER (id));
+    if (!job)
+        return;
+
+    /* The run was already accounted before calling the job */
+    g_return_if_fail (self->dispatching && job->n_runs > 0);
+
+    job->n_runs--;
+    self->n_runs--;
+    job->n_satisfied++;
+    self->n_satisfied++;
+}
+
+void
+mm_poll_scheduler_report (MMPollScheduler *self,
+                          guint            id,
+                          gboolean         changed)
+{
+    PollJob *job;
+    guint    interval;
+
+    job = g_hash_table_lookup (self->jobs, GUINT_TO_POINTER (id));
+    if (!job || job->max_interval == job->base_interval)
+        return;
+
+    interval = (changed ?
+                job->base_interval :
+                MIN (job->interval + MAX (job->interval / 2, 1), job->max_interval));
+    if (interval == job->interval)
+        return;
+
+    job->interval = interval;
+    poll_job_update_due (job);
+    reschedule (self);
+}
+
+/*****************************************************************************/
+
+GVariant *
+mm_poll_scheduler_get_timeline (MMPollScheduler *self)
+{
+    GVariantBuilder  builder;
+    GVariantBuilder  jobs;
+    GArray          *all_jobs;
+    gint64           now;
+    guint            i;
+
+    now = get_time (self);
+
+    g_variant_builder_init (&jobs, G_VARIANT_TYPE ("aa{sv}"));
+    all_jobs = collect_jobs (self, -1);
+    for (i = 0; i < all_jobs->len; i++) {
+        PollJob *job;
+
+        job = g_hash_table_lookup (self->jobs, GUINT_TO_POINTER (g_array_index (all_jobs, DueJob, i).id));
+        g_variant_builder_open (&jobs, G_VARIANT_TYPE ("a{sv}"));
+        if (job->owner)
+            g_variant_builder_add (&jobs, "{sv}", "owner", g_variant_new_string (job->owner));
+        if (job->name)
+            g_variant_builder_add (&jobs, "{sv}", "name", g_variant_new_string (job->name));
+        g_variant_builder_add (&jobs, "{sv}", "interval",  g_variant_new_uint32 (job->interval));
+        g_variant_builder_add (&jobs, "{sv}", "next",      g_variant_new_int64 ((job->due - now) / 1000));
+        g_variant_builder_add (&jobs, "{sv}", "runs",      g_variant_new_uint64 (job->n_runs));
+        g_variant_builder_add (&jobs, "{sv}", "satisfied", g_variant_new_uint64 (job->n_satisfied));
+        g_variant_builder_close (&jobs);
+    }
+    g_array_unref (all_jobs);
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+    g_variant_builder_add (&builder, "{sv}", "wakeups",   g_variant_new_uint64 (self->n_wakeups));
+    g_variant_builder_add (&builder, "{sv}", "runs",      g_variant_new_uint64 (self->n_runs));
+    g_variant_builder_add (&builder, "{sv}", "satisfied", g_variant_new_uint64 (self->n_satisfied));
+    g_variant_builder_add (&builder, "{sv}", "jobs",      g_variant_builder_end (&jobs));
+    return g_variant_builder_end (&builder);
+}
+
+/*****************************************************************************/
+
+void
+mm_poll_scheduler_set_time (MMPollScheduler *self,
+                            gint64           now)
+{
+    g_return_if_fail (!self->attached);
+
+    self->now = now;
+}
+
+MMPollScheduler *
+mm_poll_scheduler_new (void)
+{
+    MMPollScheduler *self;
+
+    self = g_slice_new0 (MMPollScheduler);
+    self->jobs = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) poll_job_free);
+    self->source_wakeup = -1;
+    return self;
+}
+
+void
+mm_poll_scheduler_free (MMPollScheduler *self)
+{
+    if (self->source_id)
+        g_source_remove (self->source_id);
+    g_hash_table_unref (self->jobs);
+    g_slice_free (MMPollScheduler, self);
+}
+
+MMPollScheduler *
+mm_poll_scheduler_get (void)
+{
+    static MMPollScheduler *shared;
+
+    if (G_UNLIKELY (!shared)) {
+        shared = mm_poll_scheduler_new ();
+        shared->attached = TRUE;
+    }
+    return shared;
+}
@@ -0,0 +1,88 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#ifndef MM_POLL_SCHEDULER_H
+#define MM_POLL_SCHEDULER_H
+
+#include <glib.h>
+
+/* Scheduler of the periodic checks of all modems and bearers (signal quality,
+ * registration, connection status...), so that they share wakeups instead of
+ * each running its own timeout.
+ *
+ * Jobs with intervals of at least two slots are aligned to slot boundaries,
+ * and whenever the scheduler wakes up it also runs the jobs due within the
+ * next quarter of their interval, so that jobs with the same interval end up
+ * running together. Jobs may be postponed when the polled values are updated
+ * by other means (see mm_poll_scheduler_touch()), or may find themselves that
+ * there is nothing to poll (see mm_poll_scheduler_skip()), and adaptive jobs
+ * (with a max interval) back off while the polled values don't change. */
+
+#define MM_POLL_SCHEDULER_SLOT_SEC 5
+
+typedef struct _MMPollScheduler MMPollScheduler;
+
+typedef void (* MMPollSchedulerFunc) (gpointer user_data);
+
+/* Shared scheduler, run in the default main context */
+MMPollScheduler *mm_poll_scheduler_get         (void);
+
+/* Scheduler not attached to any main context: time is given with
+ * mm_poll_scheduler_set_time() and jobs run in mm_poll_scheduler_dispatch() */
+MMPollScheduler *mm_poll_scheduler_new         (void);
+void             mm_poll_scheduler_free        (MMPollScheduler     *self);
+void             mm_poll_scheduler_set_time    (MMPollScheduler     *self,
+                                                gint64               now);
+void             mm_poll_scheduler_dispatch    (MMPollScheduler     *self);
+/* Monotonic time of the next wakeup, or -1 if no jobs */
+gint64           mm_poll_scheduler_get_next_wakeup (MMPollScheduler *self);
+
+/* Returns the job id. The first run happens after one interval. If
+ * max_interval is greater than interval, the job is adaptive (see
+ * mm_poll_scheduler_report()). The callback may remove the job. */
+guint            mm_poll_scheduler_add         (MMPollScheduler     *self,
+                                                const gchar         *owner,
+                                                const gchar         *name,
+                                                guint                interval,
+                                                guint                max_interval,
+                                                MMPollSchedulerFunc  func,
+                                                gpointer             user_data);
+void             mm_poll_scheduler_remove      (MMPollScheduler     *self,
+                                                guint                id);
+/* Restarts the job with new intervals, counting from now */
+void             mm_poll_scheduler_set_interval (MMPollScheduler    *self,
+                                                 guint               id,
+                                                 guint               interval,
+                                                 guint               max_interval);
+
+/* The polled values were just updated by other means (e.g. an unsolicited
+ * message), so the next run is postponed one interval from now */
+void             mm_poll_scheduler_touch       (MMPollScheduler     *self,
+                                                guint                id);
+/* Called from the job callback when there was nothing to poll, e.g. all the
+ * values are still fresh: the run is counted as satisfied instead */
+void             mm_poll_scheduler_skip        (MMPollScheduler     *self,
+                                                guint                id);
+/* Whether the last run of an adaptive job found changes: if so, the job goes
+ * back to its base interval; otherwise the interval grows up to the max */
+void             mm_poll_scheduler_report      (MMPollScheduler     *self,
+                                                guint                id,
+                                                gboolean             changed);
+
+/* Dictionary with the "wakeups", "runs" and "satisfied" counters, and the
+ * "jobs" array with the details of each job, in the order they're due */
+GVariant        *mm_poll_scheduler_get_timeline (MMPollScheduler    *self);
+
+#endif /* MM_POLL_SCHEDULER_H */
@@ -0,0 +1,204 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <string.h>
+
+#include "mm-port-index.h"
+
+struct _MMPortIndex {
+    /* "subsystem/name" -> owner */
+    GHashTable *ports;
+    /* owner -> GPtrArray of keys in 'ports', so that all ports of an owner
+     * can be removed without walking the whole index */
+    GHashTable *owners;
+};
+
+/* Keys are usually short (e.g. "tty/ttyUSB10"), so avoid allocating them on
+ * lookups */
+#define KEY_BUFFER_SIZE 64
+
+static const gchar *
+build_key (gchar       *buffer,
+           const gchar *subsystem,
+           const gchar *name,
+           gchar      **allocated)
+{
+    gsize subsystem_len;
+    gsize name_len;
+
+    subsystem_len = strlen (subsystem);
+    name_len = strlen (name);
+
+    *allocated = NULL;
+    if (subsystem_len + name_len + 2 > KEY_BUFFER_SIZE) {
+        *allocated = g_strconcat (subsystem, "/", name, NULL);
+        return *allocated;
+    }
+
+    memcpy (buffer, subsystem, subsystem_len);
+    buffer[subsystem_len] = '/';
+    memcpy (&buffer[subsystem_len + 1], name, name_len + 1);
+    return buffer;
+}
+
+/*****************************************************************************/
+
+static void
+owner_remove_key (MMPortIndex *self,
+                  gpointer     owner,
+                  const gchar *key)
+{
+    GPtrArray *keys;
+
+    keys = g_hash_table_lookup (self->owners, owner);
+    if (!keys)
+        return;
+
+    g_ptr_array_remove_fast (keys, (gpointer) key);
+    if (keys->len == 0)
+        g_hash_table_remove (self->owners, owner);
+}
+
+void
+mm_port_index_add (MMPortIndex *self,
+                   const gchar *subsystem,
+                   const gchar *name,
+                   gpointer     owner)
+{
+    gchar        buffer[KEY_BUFFER_SIZE];
+    gchar       *allocated;
+    const gchar *key;
+    gpointer     stored_key;
+    gpointer     previous;
+    GPtrArray   *keys;
+
+    g_return_if_fail (subsystem && name && owner);
+
+    key = build_key (buffer, subsystem, name, &allocated);
+
+    /* Replacing the owner of a port */
+    if (g_hash_table_lookup_extended (self->ports, key, &stored_key, &previous)) {
+        g_free (allocated);
+        if (previous == owner)
+            return;
+        owner_remove_key (self, previous, stored_key);
+        /* The already stored key is kept, the new one is freed */
+        g_hash_table_insert (self->ports, g_strdup (stored_key), owner);
+    } else {
+        stored_key = allocated ? allocated : g_strdup (key);
+        g_hash_table_insert (self->ports, stored_key, owner);
+    }
+
+    keys = g_hash_table_lookup (self->owners, owner);
+    if (!keys) {
+        keys = g_ptr_array_new ();
+        g_hash_table_insert (self->owners, owner, keys);
+    }
+    g_ptr_array_add (keys, stored_key);
+}
+
+void
+mm_port_index_remove (MMPortIndex *self,
+                      const gchar *subsystem,
+                      const gchar *name,
+                      gpointer     owner)
+{
+    gchar        buffer[KEY_BUFFER_SIZE];
+    gchar       *allocated;
+    const gchar *key;
+    gpointer     stored_key;
+    gpointer     stored_owner;
+
+    g_return_if_fail (subsystem && name);
+
+    key = build_key (buffer, subsystem, name, &allocated);
+
+    /* Only remove if owned by the given owner, if any given */
+    if (g_hash_table_lookup_extended (self->ports, key, &stored_key, &stored_owner) &&
+        (!owner || owner == stored_owner)) {
+        owner_remove_key (self, stored_owner, stored_key);
+        g_hash_table_remove (self->ports, key);
+    }
+
+    g_free (allocated);
+}
+
+void
+mm_port_index_remove_owner (MMPortIndex *self,
+                            gpointer     owner)
+{
+    GPtrArray *keys;
+    guint      i;
+
+    keys = g_hash_table_lookup (self->owners, owner);
+    if (!keys)
+        return;
+
+    /* Keys are owned by the ports table, so remove them from there last */
+    g_hash_table_steal (self->owners, owner);
+    for (i = 0; i < keys->len; i++)
+        g_hash_table_remove (self->ports, g_ptr_array_index (keys, i));
+    g_ptr_array_unref (keys);
+}
+
+gpointer
+mm_port_index_lookup (MMPortIndex *self,
+                      const gchar *subsystem,
+                      const gchar *name)
+{
+    gchar        buffer[KEY_BUFFER_SIZE];
+    gchar       *allocated;
+    const gchar *key;
+    gpointer     owner;
+
+    if (!subsystem || !name)
+        return NULL;
+
+    key = build_key (buffer, subsystem, name, &allocated);
+    owner = g_hash_table_lookup (self->ports, key);
+    g_free (allocated);
+    return owner;
+}
+
+guint
+mm_port_index_get_size (MMPortIndex *self)
+{
+    return g_hash_table_size (self->ports);
+}
+
+/*****************************************************************************/
+
+MMPortIndex *
+mm_port_index_new (void)
+{
+    MMPortIndex *self;
+
+    self = g_slice_new (MMPortIndex);
+    self->ports = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    self->owners = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) g_ptr_array_unref);
+    return self;
+}
+
+void
+mm_port_index_free (MMPortIndex *self)
+{
+    if (!self)
+        return;
+
+    /* Owner key arrays point to keys in the ports table */
+    g_hash_table_destroy (self->owners);
+    g_hash_table_destroy (self->ports);
+    g_slice_free (MMPortIndex, self);
+}
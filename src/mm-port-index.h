@@ -0,0 +1,47 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#ifndef MM_PORT_INDEX_H
+#define MM_PORT_INDEX_H
+
+#include <glib.h>
+
+/* Index of kernel ports (by subsystem and name) to the object owning them,
+ * e.g. the MMDevice which grabbed the port. Owners are not referenced.
+ *
+ * The name is not the identity of the port: a lookup only gives a candidate,
+ * which the caller must confirm (e.g. with mm_kernel_device_cmp()), falling
+ * back to a full search if it doesn't match. */
+typedef struct _MMPortIndex MMPortIndex;
+
+MMPortIndex *mm_port_index_new          (void);
+void         mm_port_index_free         (MMPortIndex *self);
+
+void         mm_port_index_add          (MMPortIndex *self,
+                                         const gchar *subsystem,
+                                         const gchar *name,
+                                         gpointer     owner);
+void         mm_port_index_remove       (MMPortIndex *self,
+                                         const gchar *subsystem,
+                                         const gchar *name,
+                                         gpointer     owner);
+void         mm_port_index_remove_owner (MMPortIndex *self,
+                                         gpointer     owner);
+gpointer     mm_port_index_lookup       (MMPortIndex *self,
+                                         const gchar *subsystem,
+                                         const gchar *name);
+guint        mm_port_index_get_size     (MMPortIndex *self);
+
+#endif /* MM_PORT_INDEX_H */
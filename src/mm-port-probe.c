@@ -98,6 +98,12 @@ struct _MMPortProbePrivate {
     gboolean maybe_at_ppp;
     gboolean maybe_qcdm;
 
+    /* Probing results preloaded from the probe cache, and the result which
+     * is still to be probed to verify them */
+    guint32 cache_verify;
+    gboolean cache_verify_expected;
+    gboolean cache_stale;
+
     /* Current probing task. Only one can be available at a time */
     GTask *task;
 };
@@ -150,10 +156,61 @@ port_probe_task_return_boolean (MMPortProbe *self,
 
 /*****************************************************************************/
 
+static void port_probe_cache_verification_failed (MMPortProbe *self);
+
+static void
+port_probe_check_cache_verification (MMPortProbe *self,
+                                     guint32      flag,
+                                     gboolean     result)
+{
+    if (!(self->priv->cache_verify & flag))
+        return;
+
+    self->priv->cache_verify = MM_PORT_PROBE_NONE;
+    if (result == self->priv->cache_verify_expected) {
+        mm_dbg ("(%s/%s) cached probing results verified",
+                mm_kernel_device_get_subsystem (self->priv->port),
+                mm_kernel_device_get_name (self->priv->port));
+        return;
+    }
+
+    port_probe_cache_verification_failed (self);
+}
+
+void
+mm_port_probe_set_cache_verification (MMPortProbe     *self,
+                                      MMPortProbeFlag  flag,
+                                      gboolean         expected)
+{
+    g_return_if_fail (MM_IS_PORT_PROBE (self));
+    g_return_if_fail (!(self->priv->flags & flag));
+
+    self->priv->cache_verify = flag;
+    self->priv->cache_verify_expected = expected;
+}
+
+gboolean
+mm_port_probe_get_cache_stale (MMPortProbe *self)
+{
+    g_return_val_if_fail (MM_IS_PORT_PROBE (self), FALSE);
+
+    return self->priv->cache_stale;
+}
+
+MMPortProbeFlag
+mm_port_probe_get_flags (MMPortProbe *self)
+{
+    g_return_val_if_fail (MM_IS_PORT_PROBE (self), MM_PORT_PROBE_NONE);
+
+    return (MMPortProbeFlag) self->priv->flags;
+}
+
 void
 mm_port_probe_set_result_at (MMPortProbe *self,
                              gboolean at)
 {
+    port_probe_check_cache_verification (self, MM_PORT_PROBE_AT, at);
+
     self->priv->is_at = at;
     self->priv->flags |= MM_PORT_PROBE_AT;
 
@@ -263,6 +320,8 @@ void
 mm_port_probe_set_result_qcdm (MMPortProbe *self,
                                gboolean qcdm)
 {
+    port_probe_check_cache_verification (self, MM_PORT_PROBE_QCDM, qcdm);
+
     self->priv->is_qcdm = qcdm;
     self->priv->flags |= MM_PORT_PROBE_QCDM;
 
@@ -296,6 +355,8 @@ void
 mm_port_probe_set_result_qmi (MMPortProbe *self,
                               gboolean qmi)
 {
+    port_probe_check_cache_verification (self, MM_PORT_PROBE_QMI, qmi);
+
     self->priv->is_qmi = qmi;
     self->priv->flags |= MM_PORT_PROBE_QMI;
 
@@ -327,6 +388,8 @@ void
 mm_port_probe_set_result_mbim (MMPortProbe *self,
                                gboolean mbim)
 {
+    port_probe_check_cache_verification (self, MM_PORT_PROBE_MBIM, mbim);
+
     self->priv->is_mbim = mbim;
     self->priv->flags |= MM_PORT_PROBE_MBIM;
 
@@ -359,6 +422,7 @@ mm_port_probe_set_result_mbim (MMPortProbe *self,
 typedef struct {
     /* ---- Generic task context ---- */
     guint32 flags;
+    guint32 requested_flags;
     guint source_id;
     GCancellable *cancellable;
 
@@ -456,6 +520,35 @@ port_probe_run_context_free (PortProbeRunContext *ctx)
     g_slice_free (PortProbeRunContext, ctx);
 }
 
+static void
+port_probe_cache_verification_failed (MMPortProbe *self)
+{
+    mm_dbg ("(%s/%s) cached probing results are stale, probing again",
+            mm_kernel_device_get_subsystem (self->priv->port),
+            mm_kernel_device_get_name (self->priv->port));
+
+    /* Drop all the preloaded results */
+    self->priv->flags = MM_PORT_PROBE_NONE;
+    self->priv->is_at = FALSE;
+    self->priv->is_qcdm = FALSE;
+    self->priv->is_qmi = FALSE;
+    self->priv->is_mbim = FALSE;
+    self->priv->is_icera = FALSE;
+    self->priv->is_xmm = FALSE;
+    g_clear_pointer (&self->priv->vendor, g_free);
+    g_clear_pointer (&self->priv->product, g_free);
+    self->priv->cache_stale = TRUE;
+
+    /* And make sure the ongoing probing runs every step requested */
+    if (self->priv->task) {
+        PortProbeRunContext *ctx;
+
+        ctx = g_task_get_task_data (self->priv->task);
+        if (ctx)
+            ctx->flags = ctx->requested_flags;
+    }
+}
+
 /***************************************************************/
 /* QMI & MBIM */
 
@@ -1051,10 +1144,34 @@ out:
     g_clear_error (&result_error);
 }
 
+/* Timeout of each AT probing attempt, but the last one, once another port in
+ * the same device has already been detected as AT-capable */
+#define SIBLING_AT_PROBING_TIMEOUT_SECS 1
+
+static MMPortProbe *
+port_probe_peek_at_sibling (MMPortProbe *self,
+                            guint32      flags)
+{
+    GList *l;
+
+    /* Look for another AT port in the same device which already completed the
+     * given probing steps */
+    for (l = mm_device_peek_port_probe_list (self->priv->device); l; l = g_list_next (l)) {
+        MMPortProbe *other = MM_PORT_PROBE (l->data);
+
+        if (other != self &&
+            other->priv->is_at &&
+            (other->priv->flags & (MM_PORT_PROBE_AT | flags)) == (MM_PORT_PROBE_AT | flags))
+            return other;
+    }
+    return NULL;
+}
+
 static gboolean
 serial_probe_at (MMPortProbe *self)
 {
     PortProbeRunContext *ctx;
+    guint                timeout;
 
     g_assert (self->priv->task);
     ctx = g_task_get_task_data (self->priv->task);
@@ -1074,10 +1191,26 @@ serial_probe_at (MMPortProbe *self)
         return G_SOURCE_REMOVE;
     }
 
+    /* If we already know which ports in the device are AT-capable, there is
+     * no point in waiting long for this one: a real AT port usually replies
+     * right away. The last attempt always gets the full timeout, so that a
+     * slow AT port is not reported as not AT-capable. */
+    timeout = ctx->at_commands->timeout;
+    if (ctx->at_result_processor == serial_probe_at_result_processor &&
+        !ctx->at_custom_probe &&
+        timeout > SIBLING_AT_PROBING_TIMEOUT_SECS &&
+        ctx->at_commands[1].command &&
+        port_probe_peek_at_sibling (self, 0)) {
+        mm_dbg ("(%s/%s) another port is already AT-capable, shortening AT probing timeout",
+                mm_kernel_device_get_subsystem (self->priv->port),
+                mm_kernel_device_get_name (self->priv->port));
+        timeout = SIBLING_AT_PROBING_TIMEOUT_SECS;
+    }
+
     mm_port_serial_at_command (
         MM_PORT_SERIAL_AT (ctx->serial),
         ctx->at_commands->command,
-        ctx->at_commands->timeout,
+        timeout,
         FALSE,
         FALSE,
         ctx->at_probing_cancellable,
@@ -1188,6 +1321,20 @@ serial_probe_schedule (MMPortProbe *self)
     /* Vendor requested and not already probed? */
     else if ((ctx->flags & MM_PORT_PROBE_AT_VENDOR) &&
         !(self->priv->flags & MM_PORT_PROBE_AT_VENDOR)) {
+        MMPortProbe *sibling;
+
+        /* Reuse the vendor string if already probed in another port */
+        sibling = port_probe_peek_at_sibling (self, MM_PORT_PROBE_AT_VENDOR);
+        if (sibling && sibling->priv->vendor) {
+            mm_dbg ("(%s/%s) reusing vendor string probed in %s",
+                    mm_kernel_device_get_subsystem (self->priv->port),
+                    mm_kernel_device_get_name (self->priv->port),
+                    mm_kernel_device_get_name (sibling->priv->port));
+            mm_port_probe_set_result_at_vendor (self, sibling->priv->vendor);
+            serial_probe_schedule (self);
+            return;
+        }
+
         /* Prepare AT vendor probing */
         ctx->at_result_processor = serial_probe_at_vendor_result_processor;
         ctx->at_commands = vendor_probing;
@@ -1195,6 +1342,20 @@ serial_probe_schedule (MMPortProbe *self)
     /* Product requested and not already probed? */
     else if ((ctx->flags & MM_PORT_PROBE_AT_PRODUCT) &&
              !(self->priv->flags & MM_PORT_PROBE_AT_PRODUCT)) {
+        MMPortProbe *sibling;
+
+        /* Reuse the product string if already probed in another port */
+        sibling = port_probe_peek_at_sibling (self, MM_PORT_PROBE_AT_PRODUCT);
+        if (sibling && sibling->priv->product) {
+            mm_dbg ("(%s/%s) reusing product string probed in %s",
+                    mm_kernel_device_get_subsystem (self->priv->port),
+                    mm_kernel_device_get_name (self->priv->port),
+                    mm_kernel_device_get_name (sibling->priv->port));
+            mm_port_probe_set_result_at_product (self, sibling->priv->product);
+            serial_probe_schedule (self);
+            return;
+        }
+
         /* Prepare AT product probing */
         ctx->at_result_processor = serial_probe_at_product_result_processor;
         ctx->at_commands = product_probing;
@@ -1451,6 +1612,7 @@ mm_port_probe_run (MMPortProbe                *self,
     ctx->at_remove_echo = at_remove_echo;
     ctx->at_send_lf = at_send_lf;
     ctx->flags = MM_PORT_PROBE_NONE;
+    ctx->requested_flags = flags;
     ctx->at_custom_probe = at_custom_probe;
     ctx->at_custom_init = at_custom_init ? (MMPortProbeAtCustomInit)at_custom_init->async : NULL;
     ctx->at_custom_init_finish = at_custom_init ? (MMPortProbeAtCustomInitFinish)at_custom_init->finish : NULL;
@@ -1498,7 +1660,7 @@ mm_port_probe_run (MMPortProbe                *self,
      * for the missing things. */
     for (i = MM_PORT_PROBE_AT; i <= MM_PORT_PROBE_MBIM; i = (i << 1)) {
         if ((flags & i) && !(self->priv->flags & i))
-            ctx->flags += i;
+            ctx->flags |= i;
     }
 
     /* All requested probings already available? If so, we're done */
@@ -108,6 +108,14 @@ void mm_port_probe_set_result_qmi        (MMPortProbe *self,
 void mm_port_probe_set_result_mbim       (MMPortProbe *self,
                                           gboolean mbim);
 
+/* Probing results loaded from the probe cache must be verified by running
+ * the given probing step, which is expected to report 'expected'. If it
+ * doesn't, all preloaded results are dropped and probing starts over. */
+void     mm_port_probe_set_cache_verification (MMPortProbe *self,
+                                               MMPortProbeFlag flag,
+                                               gboolean expected);
+gboolean mm_port_probe_get_cache_stale        (MMPortProbe *self);
+
 /* Run probing */
 void     mm_port_probe_run        (MMPortProbe *self,
                                    MMPortProbeFlag flags,
@@ -126,6 +134,7 @@ gboolean mm_port_probe_run_finish (MMPortProbe *self,
 gboolean mm_port_probe_run_cancel_at_probing (MMPortProbe *self);
 
 /* Probing result getters */
+MMPortProbeFlag mm_port_probe_get_flags      (MMPortProbe *self);
 MMPortType    mm_port_probe_get_port_type    (MMPortProbe *self);
 gboolean      mm_port_probe_is_at            (MMPortProbe *self);
 gboolean      mm_port_probe_is_qcdm          (MMPortProbe *self);
@@ -42,6 +42,12 @@ struct _MMPortSerialAtPrivate {
     GDestroyNotify response_parser_notify;
 
     GSList *unsolicited_msg_handlers;
+    /* Leading token (e.g. '+CREG') to list of handlers, in priority order */
+    GHashTable *unsolicited_msg_handlers_index;
+    /* Registration order of the last handler added */
+    guint unsolicited_msg_handlers_serial;
+    /* Handlers added or enabled, the already scanned data must be rescanned */
+    gboolean unsolicited_msg_handlers_rescan;
 
     MMPortSerialAtFlag flags;
 
@@ -96,34 +102,58 @@ mm_port_serial_at_set_response_parser (MMPortSerialAt *self,
     self->priv->response_parser_notify = notify;
 }
 
-void
-mm_port_serial_at_remove_echo (GByteArray *response)
+/* Returns the length of the echo (or garbage) found before the first <CR><LF> */
+static gsize
+echo_len (const guint8 *data,
+          gsize len)
 {
-    guint i;
+    gsize i;
 
-    if (response->len <= 2)
-        return;
+    if (len <= 2)
+        return 0;
 
-    for (i = 0; i < (response->len - 1); i++) {
+    for (i = 0; i < (len - 1); i++) {
         /* If there is any content before the first
          * <CR><LF>, assume it's echo or garbage, and skip it */
-        if (response->data[i] == '\r' && response->data[i + 1] == '\n') {
-            if (i > 0)
-                g_byte_array_remove_range (response, 0, i);
-            /* else, good, we're already started with <CR><LF> */
-            break;
-        }
+        if (data[i] == '\r' && data[i + 1] == '\n')
+            return i;
     }
+
+    return 0;
+}
+
+void
+mm_port_serial_at_remove_echo (GByteArray *response)
+{
+    gsize len;
+
+    len = echo_len (response->data, response->len);
+    if (len > 0)
+        g_byte_array_remove_range (response, 0, len);
+}
+
+static void
+buffer_remove_echo (MMPortSerialBuffer *response)
+{
+    const guint8 *data;
+    gsize len;
+
+    data = mm_port_serial_buffer_peek (response, &len);
+    len = echo_len (data, len);
+    if (len > 0)
+        mm_port_serial_buffer_consume (response, len);
 }
 
 static MMPortSerialResponseType
 parse_response (MMPortSerial *port,
-                GByteArray *response,
+                MMPortSerialBuffer *response,
                 GByteArray **parsed_response,
                 GError **error)
 {
     MMPortSerialAt *self = MM_PORT_SERIAL_AT (port);
     GString *string;
+    const guint8 *data;
+    gsize len;
     gsize parsed_len;
     GError *inner_error = NULL;
 
@@ -131,30 +161,29 @@ parse_response (MMPortSerial *port,
 
     /* Remove echo */
     if (self->priv->remove_echo)
-        mm_port_serial_at_remove_echo (response);
+        buffer_remove_echo (response);
 
     /* If there's no response to receive, we're done; e.g. if we only got
      * unsolicited messages */
-    if (!response->len)
+    data = mm_port_serial_buffer_peek (response, &len);
+    if (!len)
         return MM_PORT_SERIAL_RESPONSE_NONE;
 
     /* Construct the string that AT-parsing functions expect */
-    string = g_string_sized_new (response->len + 1);
-    g_string_append_len (string, (const char *) response->data, response->len);
-
-    /* Fully cleanup the response array, we'll consider the contents we got
-     * as the full reply that the command may expect. */
-    g_byte_array_remove_range (response, 0, response->len);
+    string = g_string_sized_new (len + 1);
+    g_string_append_len (string, (const char *) data, len);
 
     /* Parse it; returns FALSE if there is nothing we can do with this
-     * response yet. */
+     * response yet, in which case the response buffer is left untouched. */
     if (!self->priv->response_parser_fn (self->priv->response_parser_user_data, string, &inner_error)) {
-        /* Copy what we got back in the response buffer. */
-        g_byte_array_append (response, (const guint8 *) string->str, string->len);
         g_string_free (string, TRUE);
         return MM_PORT_SERIAL_RESPONSE_NONE;
     }
 
+    /* Fully cleanup the response buffer, we'll consider the contents we got
+     * as the full reply that the command may expect. */
+    mm_port_serial_buffer_consume (response, len);
+
     /* If we got an error, propagate it without any further response string */
     if (inner_error) {
         g_string_free (string, TRUE);
@@ -172,12 +201,178 @@ parse_response (MMPortSerial *port,
 
 typedef struct {
     GRegex *regex;
+    /* Leading token, NULL if the handler cannot be indexed */
+    gchar *key;
+    /* Registration order, higher in newer handlers */
+    guint serial;
     MMPortSerialAtUnsolicitedMsgFn callback;
     gboolean enable;
     gpointer user_data;
     GDestroyNotify notify;
 } MMAtUnsolicitedMsgHandler;
 
+/* Maximum length of the leading token used to index unsolicited message
+ * handlers, including the symbol prefix */
+#define UNSOLICITED_MSG_KEY_MAX_LEN 32
+
+/* Characters allowed as prefix of the leading token, e.g. '+CREG' or '^RSSI' */
+#define UNSOLICITED_MSG_KEY_SYMBOLS "+^%$*#@!_"
+
+/* Returns the length of the leading token of the line starting at @str, i.e.
+ * an optional symbol followed by alphanumeric characters, or 0 if none. */
+static gsize
+unsolicited_msg_key_len (const gchar *str,
+                         gsize        len)
+{
+    gsize i = 0;
+
+    if (len > 0 && strchr (UNSOLICITED_MSG_KEY_SYMBOLS, str[0]))
+        i++;
+    while (i < len && g_ascii_isalnum (str[i]))
+        i++;
+
+    /* A symbol alone is not a valid key */
+    if (i == 0 || !g_ascii_isalnum (str[i - 1]))
+        return 0;
+    return i;
+}
+
+/* Checks whether the given pattern has an alternation outside of any group,
+ * which would make the leading token of the pattern not mandatory. */
+static gboolean
+unsolicited_msg_pattern_has_toplevel_alternation (const gchar *pattern)
+{
+    const gchar *p;
+    guint depth = 0;
+    gboolean in_class = FALSE;
+
+    for (p = pattern; *p; p++) {
+        if (*p == '\\') {
+            if (!*(++p))
+                break;
+            continue;
+        }
+        if (in_class) {
+            if (*p == ']')
+                in_class = FALSE;
+            continue;
+        }
+        switch (*p) {
+        case '[':
+            in_class = TRUE;
+            break;
+        case '(':
+            depth++;
+            break;
+        case ')':
+            if (depth > 0)
+                depth--;
+            break;
+        case '|':
+            if (depth == 0)
+                return TRUE;
+            break;
+        default:
+            break;
+        }
+    }
+
+    return FALSE;
+}
+
+/* Builds the literal leading token of the regex, skipping the leading line
+ * separators. E.g. '+CREG' for '\r\n\+CREG:(.*)\r\n'. Returns NULL if the
+ * pattern doesn't start with at least one mandatory line separator followed by
+ * a literal token and by a character that cannot be part of the token, in
+ * which case the handler will be applied to the whole response buffer.
+ *
+ * The mandatory line separator ensures that a match can only start in the
+ * line separators preceding a line, which is the only place where indexed
+ * handlers are tried. */
+static gchar *
+unsolicited_msg_handler_build_key (GRegex *regex)
+{
+    const gchar *pattern;
+    const gchar *p;
+    const gchar *next;
+    GString *key;
+    gboolean has_separator = FALSE;
+
+    if (g_regex_get_compile_flags (regex) & (G_REGEX_CASELESS | G_REGEX_EXTENDED))
+        return NULL;
+
+    pattern = g_regex_get_pattern (regex);
+    if (unsolicited_msg_pattern_has_toplevel_alternation (pattern))
+        return NULL;
+
+    /* Skip leading line separators, with optional quantifiers */
+    p = pattern;
+    while (p[0] == '\\' && (p[1] == 'r' || p[1] == 'n' || p[1] == 'R')) {
+        p += 2;
+        if (*p == '?' || *p == '*')
+            p++;
+        else {
+            if (*p == '+')
+                p++;
+            has_separator = TRUE;
+        }
+    }
+    if (!has_separator)
+        return NULL;
+
+    key = g_string_sized_new (UNSOLICITED_MSG_KEY_MAX_LEN);
+
+    /* Optional symbol, escaped or not */
+    if (p[0] == '\\' && p[1] && strchr (UNSOLICITED_MSG_KEY_SYMBOLS, p[1])) {
+        g_string_append_c (key, p[1]);
+        p += 2;
+    } else if (*p && strchr ("%#@!_", *p)) {
+        g_string_append_c (key, *p);
+        p++;
+    }
+
+    while (g_ascii_isalnum (*p))
+        g_string_append_c (key, *p++);
+
+    if (key->len == 0 || !g_ascii_isalnum (key->str[key->len - 1]) || key->len >= UNSOLICITED_MSG_KEY_MAX_LEN)
+        goto out_invalid;
+
+    /* The token must be followed by something which is never alphanumeric
+     * and which isn't optional, or by the end of the pattern */
+    if (!*p)
+        return g_string_free (key, FALSE);
+
+    if (p[0] == '\\') {
+        if (!p[1] || (g_ascii_isalnum (p[1]) && !strchr ("rnsR", p[1])))
+            goto out_invalid;
+        next = p + 2;
+    } else {
+        if (strchr (".[]()|?*+{}^$", *p))
+            goto out_invalid;
+        next = p + 1;
+    }
+
+    if (*next == '?' || *next == '*' || *next == '{')
+        goto out_invalid;
+
+    return g_string_free (key, FALSE);
+
+out_invalid:
+    g_string_free (key, TRUE);
+    return NULL;
+}
+
+static void
+unsolicited_msg_handler_free (MMAtUnsolicitedMsgHandler *handler)
+{
+    if (handler->notify)
+        handler->notify (handler->user_data);
+
+    g_regex_unref (handler->regex);
+    g_free (handler->key);
+    g_slice_free (MMAtUnsolicitedMsgHandler, handler);
+}
+
 static gint
 unsolicited_msg_handler_cmp (MMAtUnsolicitedMsgHandler *handler,
                              GRegex *regex)
@@ -213,13 +408,64 @@ mm_port_serial_at_add_unsolicited_msg_handler (MMPortSerialAt *self,
          * plugin. */
         handler = g_slice_new (MMAtUnsolicitedMsgHandler);
         handler->regex = g_regex_ref (regex);
+        handler->key = unsolicited_msg_handler_build_key (regex);
+        handler->serial = ++self->priv->unsolicited_msg_handlers_serial;
         self->priv->unsolicited_msg_handlers = g_slist_prepend (self->priv->unsolicited_msg_handlers, handler);
+
+        /* Same priority rules in the index */
+        if (handler->key) {
+            GSList *indexed;
+
+            indexed = g_hash_table_lookup (self->priv->unsolicited_msg_handlers_index, handler->key);
+            g_hash_table_steal (self->priv->unsolicited_msg_handlers_index, handler->key);
+            g_hash_table_insert (self->priv->unsolicited_msg_handlers_index,
+                                 handler->key,
+                                 g_slist_prepend (indexed, handler));
+        }
     }
 
     handler->callback = callback;
     handler->enable = TRUE;
     handler->user_data = user_data;
     handler->notify = notify;
+
+    self->priv->unsolicited_msg_handlers_rescan = TRUE;
+}
+
+void
+mm_port_serial_at_remove_unsolicited_msg_handler (MMPortSerialAt *self,
+                                                  GRegex *regex)
+{
+    GSList *existing;
+    MMAtUnsolicitedMsgHandler *handler;
+
+    g_return_if_fail (MM_IS_PORT_SERIAL_AT (self));
+    g_return_if_fail (regex != NULL);
+
+    existing = g_slist_find_custom (self->priv->unsolicited_msg_handlers,
+                                    regex,
+                                    (GCompareFunc)unsolicited_msg_handler_cmp);
+    if (!existing)
+        return;
+
+    handler = existing->data;
+    self->priv->unsolicited_msg_handlers = g_slist_delete_link (self->priv->unsolicited_msg_handlers, existing);
+
+    if (handler->key) {
+        GSList *indexed;
+
+        /* The key in the index may be the one owned by this handler, so
+         * re-insert the remaining ones with a key owned by any of them */
+        indexed = g_hash_table_lookup (self->priv->unsolicited_msg_handlers_index, handler->key);
+        g_hash_table_steal (self->priv->unsolicited_msg_handlers_index, handler->key);
+        indexed = g_slist_remove (indexed, handler);
+        if (indexed)
+            g_hash_table_insert (self->priv->unsolicited_msg_handlers_index,
+                                 ((MMAtUnsolicitedMsgHandler *) indexed->data)->key,
+                                 indexed);
+    }
+
+    unsolicited_msg_handler_free (handler);
 }
 
 void
@@ -239,71 +485,270 @@ mm_port_serial_at_enable_unsolicited_msg_handler (MMPortSerialAt *self,
     if (existing) {
         handler = existing->data;
         handler->enable = enable;
+        if (enable)
+            self->priv->unsolicited_msg_handlers_rescan = TRUE;
     }
 }
 
+typedef enum {
+    UNSOLICITED_MSG_MATCH_NONE,
+    UNSOLICITED_MSG_MATCH_FULL,
+    UNSOLICITED_MSG_MATCH_PARTIAL,
+} UnsolicitedMsgMatch;
+
+/* Runs the handler at the given line, allowing the match to start anywhere in
+ * the line separators preceding it. If the handler matches, the matched
+ * contents are removed from the response and the start of the match is
+ * returned in @match_start. If the handler could only match with more data,
+ * a partial match is reported, and the line needs to be scanned again on the
+ * next read. */
+static UnsolicitedMsgMatch
+unsolicited_msg_handler_run_at_line (MMPortSerialAt *self,
+                                     MMAtUnsolicitedMsgHandler *handler,
+                                     MMPortSerialBuffer *response,
+                                     gsize separator_start,
+                                     gsize line_start,
+                                     gsize *match_start)
+{
+    UnsolicitedMsgMatch result = UNSOLICITED_MSG_MATCH_NONE;
+    const guint8 *data;
+    gsize len;
+    gsize pos;
+
+    data = mm_port_serial_buffer_peek (response, &len);
+
+    for (pos = separator_start; pos <= line_start; pos++) {
+        GMatchInfo *match_info = NULL;
+        gint start;
+        gint end;
+
+        if (!g_regex_match_full (handler->regex,
+                                 (const gchar *) data,
+                                 len,
+                                 pos,
+                                 G_REGEX_MATCH_ANCHORED | G_REGEX_MATCH_PARTIAL,
+                                 &match_info,
+                                 NULL)) {
+            if (g_match_info_is_partial_match (match_info))
+                result = UNSOLICITED_MSG_MATCH_PARTIAL;
+            g_match_info_free (match_info);
+            continue;
+        }
+
+        if (handler->callback)
+            handler->callback (self, match_info, handler->user_data);
+
+        g_match_info_fetch_pos (match_info, 0, &start, &end);
+        g_match_info_free (match_info);
+
+        if (end > start)
+            mm_port_serial_buffer_remove_range (response, start, end - start);
+        *match_start = start;
+        return UNSOLICITED_MSG_MATCH_FULL;
+    }
+
+    return result;
+}
+
+/* Applies the indexed handlers registered after @serial_min and before
+ * @serial_max: the response is walked line by line, starting at the scanned
+ * mark, and only the handlers registered for the leading token of each line
+ * are run, anchored to that line.
+ *
+ * Returns the offset from which the response needs to be scanned again on the
+ * next read: the line separators before the first line that is either not
+ * complete yet or partially matched by any handler. */
+static gsize
+parse_unsolicited_indexed (MMPortSerialAt *self,
+                           MMPortSerialBuffer *response,
+                           guint serial_min,
+                           guint serial_max,
+                           gboolean *removed)
+{
+    gsize i;
+    gsize len;
+    gsize rescan = G_MAXSIZE;
+
+    i = mm_port_serial_buffer_get_scanned (response);
+
+    while (TRUE) {
+        const gchar *data;
+        gsize separator_start;
+        gsize line_start;
+        gsize key_len;
+        gboolean handled = FALSE;
+        gboolean partial = FALSE;
+
+        data = (const gchar *) mm_port_serial_buffer_peek (response, &len);
+
+        /* Skip line separators, including the ones right before a match
+         * just removed */
+        while (i > 0 && (data[i - 1] == '\r' || data[i - 1] == '\n'))
+            i--;
+        separator_start = i;
+        while (i < len && (data[i] == '\r' || data[i] == '\n'))
+            i++;
+        if (i == len) {
+            rescan = MIN (rescan, separator_start);
+            break;
+        }
+        line_start = i;
+
+        key_len = unsolicited_msg_key_len (&data[line_start], len - line_start);
+        if (key_len > 0 && key_len < UNSOLICITED_MSG_KEY_MAX_LEN) {
+            gchar key[UNSOLICITED_MSG_KEY_MAX_LEN];
+            GSList *l;
+
+            memcpy (key, &data[line_start], key_len);
+            key[key_len] = '\0';
+
+            for (l = g_hash_table_lookup (self->priv->unsolicited_msg_handlers_index, key); l && !handled; l = g_slist_next (l)) {
+                MMAtUnsolicitedMsgHandler *handler = (MMAtUnsolicitedMsgHandler *) l->data;
+
+                if (!handler->enable || handler->serial <= serial_min || handler->serial >= serial_max)
+                    continue;
+
+                switch (unsolicited_msg_handler_run_at_line (self, handler, response, separator_start, line_start, &i)) {
+                case UNSOLICITED_MSG_MATCH_FULL:
+                    handled = TRUE;
+                    break;
+                case UNSOLICITED_MSG_MATCH_PARTIAL:
+                    partial = TRUE;
+                    break;
+                case UNSOLICITED_MSG_MATCH_NONE:
+                default:
+                    break;
+                }
+            }
+        }
+
+        /* If the line was consumed, keep on from where the match started */
+        if (handled) {
+            *removed = TRUE;
+            continue;
+        }
+
+        /* Otherwise, skip to the end of the line; the line is done unless
+         * incomplete or waiting for more data to match */
+        while (i < len && data[i] != '\r' && data[i] != '\n')
+            i++;
+        if (partial || i == len)
+            rescan = MIN (rescan, separator_start);
+        if (i == len)
+            break;
+    }
+
+    return rescan;
+}
+
+/* Applies a handler which needs to look at the whole buffer. Returns TRUE if
+ * any contents were removed. */
 static gboolean
-remove_eval_cb (const GMatchInfo *match_info,
-                GString *result,
-                gpointer user_data)
+parse_unsolicited_whole (MMPortSerialAt *self,
+                         MMAtUnsolicitedMsgHandler *handler,
+                         MMPortSerialBuffer *response)
 {
-    int *result_len = (int *) user_data;
-    int start;
-    int end;
+    GMatchInfo *match_info;
+    GArray *matches = NULL;
+    const guint8 *data;
+    gsize len;
+    gint start;
+    gint end;
+    guint i;
 
-    if (g_match_info_fetch_pos  (match_info, 0, &start, &end))
-        *result_len -= (end - start);
+    data = mm_port_serial_buffer_peek (response, &len);
+    g_regex_match_full (handler->regex,
+                        (const char *) data,
+                        len,
+                        0, 0, &match_info, NULL);
+    while (g_match_info_matches (match_info)) {
+        if (handler->callback)
+            handler->callback (self, match_info, handler->user_data);
+
+        if (g_match_info_fetch_pos (match_info, 0, &start, &end) && end > start) {
+            if (!matches)
+                matches = g_array_new (FALSE, FALSE, sizeof (gint));
+            g_array_append_val (matches, start);
+            g_array_append_val (matches, end);
+        }
+        g_match_info_next (match_info, NULL);
+    }
+    g_match_info_free (match_info);
 
-    return FALSE;
+    if (!matches)
+        return FALSE;
+
+    /* Remove matches in place, last one first so that the previous
+     * positions are still valid */
+    for (i = matches->len; i > 0; i -= 2) {
+        start = g_array_index (matches, gint, i - 2);
+        end = g_array_index (matches, gint, i - 1);
+        mm_port_serial_buffer_remove_range (response, start, end - start);
+    }
+    g_array_unref (matches);
+    return TRUE;
 }
 
 static void
-parse_unsolicited (MMPortSerial *port, GByteArray *response)
+parse_unsolicited (MMPortSerial *port, MMPortSerialBuffer *response)
 {
     MMPortSerialAt *self = MM_PORT_SERIAL_AT (port);
     GSList *iter;
+    guint serial_max = G_MAXUINT;
+    gboolean pending_indexed = FALSE;
+    gboolean has_rescan = FALSE;
+    gboolean rescan_valid = TRUE;
+    gsize rescan = G_MAXSIZE;
 
     /* Remove echo */
     if (self->priv->remove_echo)
-        mm_port_serial_at_remove_echo (response);
+        buffer_remove_echo (response);
 
-    for (iter = self->priv->unsolicited_msg_handlers; iter; iter = iter->next) {
-        MMAtUnsolicitedMsgHandler *handler = (MMAtUnsolicitedMsgHandler *) iter->data;
-        GMatchInfo *match_info;
-        gboolean matches;
+    if (self->priv->unsolicited_msg_handlers_rescan) {
+        mm_port_serial_buffer_set_scanned (response, 0);
+        self->priv->unsolicited_msg_handlers_rescan = FALSE;
+    }
 
-        if (!handler->enable)
+    /* Handlers are applied in registration order, newest first. Consecutive
+     * indexed handlers are applied together in a single walk through the
+     * lines, and the ones which need to look at the whole buffer in between.
+     *
+     * The offset to scan again on the next read is only kept if nothing was
+     * removed after having computed it, as it could have moved; otherwise,
+     * the next read will just scan again from the previous mark. */
+    for (iter = self->priv->unsolicited_msg_handlers; ; iter = iter->next) {
+        MMAtUnsolicitedMsgHandler *handler = iter ? (MMAtUnsolicitedMsgHandler *) iter->data : NULL;
+        gboolean removed = FALSE;
+
+        if (handler && handler->key) {
+            pending_indexed = TRUE;
             continue;
-
-        matches = g_regex_match_full (handler->regex,
-                                      (const char *) response->data,
-                                      response->len,
-                                      0, 0, &match_info, NULL);
-        if (handler->callback) {
-            while (g_match_info_matches (match_info)) {
-                handler->callback (self, match_info, handler->user_data);
-                g_match_info_next (match_info, NULL);
-            }
         }
 
-        g_match_info_free (match_info);
+        if (pending_indexed && mm_port_serial_buffer_get_len (response) > 0) {
+            gsize walk_rescan;
 
-        if (matches) {
-            /* Remove matches */
-            char *str;
-            int result_len = response->len;
+            walk_rescan = parse_unsolicited_indexed (self, response, handler ? handler->serial : 0, serial_max, &removed);
+            if (has_rescan && removed)
+                rescan_valid = FALSE;
+            rescan = MIN (rescan, walk_rescan);
+            has_rescan = TRUE;
+        }
+        pending_indexed = FALSE;
 
-            str = g_regex_replace_eval (handler->regex,
-                                        (const char *) response->data,
-                                        response->len,
-                                        0, 0,
-                                        remove_eval_cb, &result_len, NULL);
+        if (!handler)
+            break;
 
-            g_byte_array_remove_range (response, 0, response->len);
-            g_byte_array_append (response, (const guint8 *) str, result_len);
-            g_free (str);
-        }
+        serial_max = handler->serial;
+        if (handler->enable &&
+            mm_port_serial_buffer_get_len (response) > 0 &&
+            parse_unsolicited_whole (self, handler, response) &&
+            has_rescan)
+            rescan_valid = FALSE;
     }
+
+    if (has_rescan && rescan_valid)
+        mm_port_serial_buffer_set_scanned (response, MIN (rescan, mm_port_serial_buffer_get_len (response)));
 }
 
 /*****************************************************************************/
@@ -395,14 +840,15 @@ serial_command_ready (MMPortSerial *port,
 }
 
 void
-mm_port_serial_at_command (MMPortSerialAt *self,
-                           const char *command,
-                           guint32 timeout_seconds,
-                           gboolean is_raw,
-                           gboolean allow_cached,
-                           GCancellable *cancellable,
-                           GAsyncReadyCallback callback,
-                           gpointer user_data)
+mm_port_serial_at_command_full (MMPortSerialAt *self,
+                                const char *command,
+                                guint32 timeout_seconds,
+                                gboolean is_raw,
+                                gboolean allow_cached,
+                                MMPortSerialCommandPriority priority,
+                                GCancellable *cancellable,
+                                GAsyncReadyCallback callback,
+                                gpointer user_data)
 {
     GSimpleAsyncResult *simple;
     GByteArray *buf;
@@ -428,17 +874,190 @@ mm_port_serial_at_command (MMPortSerialAt *self,
                             timeout_seconds,
                             allow_cached,
                             is_raw, /* raw commands always run next, never queued last */
+                            priority,
                             cancellable,
                             (GAsyncReadyCallback)serial_command_ready,
                             simple);
     g_byte_array_unref (buf);
 }
 
+void
+mm_port_serial_at_command (MMPortSerialAt *self,
+                           const char *command,
+                           guint32 timeout_seconds,
+                           gboolean is_raw,
+                           gboolean allow_cached,
+                           GCancellable *cancellable,
+                           GAsyncReadyCallback callback,
+                           gpointer user_data)
+{
+    mm_port_serial_at_command_full (self,
+                                    command,
+                                    timeout_seconds,
+                                    is_raw,
+                                    allow_cached,
+                                    MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
+                                    cancellable,
+                                    callback,
+                                    user_data);
+}
+
+/*****************************************************************************/
+/* Reply cache policy */
+
+typedef struct {
+    const gchar *command;
+    /* If TRUE, 'command' is just the prefix of a set command, e.g. "+CFUN=" */
+    gboolean is_prefix;
+    guint ttl_seconds;
+    MMPortSerialCacheInvalidation invalidate_on;
+    MMPortSerialCacheInvalidation invalidates;
+} CachePolicy;
+
+static const CachePolicy cache_policies[] = {
+    /* Device identification never changes */
+    { "+CGMI",      FALSE, 0,    MM_PORT_SERIAL_CACHE_INVALIDATION_NONE,  MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    { "+GMI",       FALSE, 0,    MM_PORT_SERIAL_CACHE_INVALIDATION_NONE,  MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    { "+CGMM",      FALSE, 0,    MM_PORT_SERIAL_CACHE_INVALIDATION_NONE,  MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    { "+GMM",       FALSE, 0,    MM_PORT_SERIAL_CACHE_INVALIDATION_NONE,  MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    { "+CGSN",      FALSE, 0,    MM_PORT_SERIAL_CACHE_INVALIDATION_NONE,  MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    { "+GSN",       FALSE, 0,    MM_PORT_SERIAL_CACHE_INVALIDATION_NONE,  MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    /* The firmware revision may change after an upgrade without a reprobe */
+    { "+CGMR",      FALSE, 3600, MM_PORT_SERIAL_CACHE_INVALIDATION_NONE,  MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    { "+GMR",       FALSE, 3600, MM_PORT_SERIAL_CACHE_INVALIDATION_NONE,  MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    /* Test commands listing static capabilities */
+    { "+CSCS=?",    FALSE, 0,    MM_PORT_SERIAL_CACHE_INVALIDATION_NONE,  MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    { "+CGDCONT=?", FALSE, 0,    MM_PORT_SERIAL_CACHE_INVALIDATION_POWER, MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    { "+WS46=?",    FALSE, 0,    MM_PORT_SERIAL_CACHE_INVALIDATION_POWER, MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    /* Available storages depend on the SIM */
+    { "+CPMS=?",    FALSE, 600,  (MM_PORT_SERIAL_CACHE_INVALIDATION_SIM |
+                                  MM_PORT_SERIAL_CACHE_INVALIDATION_POWER), MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    /* Identity of the SIM and files read from it */
+    { "+CIMI",      FALSE, 0,    MM_PORT_SERIAL_CACHE_INVALIDATION_SIM,   MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    { "+CRSM=176,", TRUE,  0,    MM_PORT_SERIAL_CACHE_INVALIDATION_SIM,   MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    /* Signal quality is only worth caching for a few seconds */
+    { "+CSQ",       FALSE, 5,    MM_PORT_SERIAL_CACHE_INVALIDATION_POWER, MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    { "+CSQ?",      FALSE, 5,    MM_PORT_SERIAL_CACHE_INVALIDATION_POWER, MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    /* Set commands changing the state the cached replies depend on */
+    { "+CFUN=",     TRUE,  0,    MM_PORT_SERIAL_CACHE_INVALIDATION_ALL,   MM_PORT_SERIAL_CACHE_INVALIDATION_POWER },
+    { "+CPIN=",     TRUE,  0,    MM_PORT_SERIAL_CACHE_INVALIDATION_ALL,   MM_PORT_SERIAL_CACHE_INVALIDATION_SIM },
+    { "+CSCS=",     TRUE,  0,    MM_PORT_SERIAL_CACHE_INVALIDATION_ALL,   MM_PORT_SERIAL_CACHE_INVALIDATION_CHARSET },
+};
+
+/* Skips the AT prefix and the trailing CR/LF; returns FALSE if there is no
+ * AT prefix, e.g. in raw commands */
+static gboolean
+command_strip (const GByteArray *command,
+               const gchar **cmd,
+               gsize *cmd_len)
+{
+    gboolean is_at = FALSE;
+
+    *cmd = (const gchar *) command->data;
+    *cmd_len = command->len;
+
+    if (*cmd_len >= 2 && g_ascii_strncasecmp (*cmd, "AT", 2) == 0) {
+        *cmd += 2;
+        *cmd_len -= 2;
+        is_at = TRUE;
+    }
+    while (*cmd_len > 0 && ((*cmd)[*cmd_len - 1] == '\r' || (*cmd)[*cmd_len - 1] == '\n'))
+        (*cmd_len)--;
+
+    return is_at;
+}
+
+static void
+get_cache_policy (MMPortSerial *port,
+                  const GByteArray *command,
+                  guint *ttl_seconds,
+                  MMPortSerialCacheInvalidation *invalidate_on,
+                  MMPortSerialCacheInvalidation *invalidates)
+{
+    const gchar *cmd;
+    gsize cmd_len;
+    guint i;
+
+    command_strip (command, &cmd, &cmd_len);
+
+    for (i = 0; i < G_N_ELEMENTS (cache_policies); i++) {
+        gsize policy_len;
+
+        policy_len = strlen (cache_policies[i].command);
+        if (cmd_len < policy_len ||
+            g_ascii_strncasecmp (cmd, cache_policies[i].command, policy_len) != 0)
+            continue;
+
+        if (cache_policies[i].is_prefix) {
+            /* Test commands of a setter don't change anything */
+            if (cmd_len == policy_len + 1 && cmd[policy_len] == '?')
+                continue;
+        } else if (cmd_len != policy_len)
+            continue;
+
+        *ttl_seconds = cache_policies[i].ttl_seconds;
+        *invalidate_on = cache_policies[i].invalidate_on;
+        *invalidates = cache_policies[i].invalidates;
+        return;
+    }
+}
+
+/*****************************************************************************/
+/* Command statistics key */
+
+static void
+get_stats_key (MMPortSerial *port,
+               const GByteArray *command,
+               gchar *key,
+               gsize key_size)
+{
+    const gchar *cmd;
+    gsize cmd_len;
+    gsize name_len;
+    gsize i;
+    const gchar *suffix;
+
+    /* e.g. SMS PDUs sent after the prompt */
+    if (!command_strip (command, &cmd, &cmd_len)) {
+        g_strlcpy (key, "raw", key_size);
+        return;
+    }
+
+    if (cmd_len == 0) {
+        g_strlcpy (key, "AT", key_size);
+        return;
+    }
+
+    /* The command name, and whether it's a test, read or set command,
+     * e.g. "+COPS=?", "+COPS?" or "+COPS=" */
+    for (name_len = 0; name_len < cmd_len; name_len++) {
+        if (cmd[name_len] == '=' || cmd[name_len] == '?' || cmd[name_len] == ';')
+            break;
+    }
+
+    if (name_len + 1 < cmd_len && cmd[name_len] == '=' && cmd[name_len + 1] == '?')
+        suffix = "=?";
+    else if (name_len < cmd_len && cmd[name_len] == '=')
+        suffix = "=";
+    else if (name_len < cmd_len && cmd[name_len] == '?')
+        suffix = "?";
+    else
+        suffix = "";
+
+    name_len = MIN (name_len, key_size - strlen (suffix) - 1);
+    for (i = 0; i < name_len; i++)
+        key[i] = g_ascii_toupper (cmd[i]);
+    strcpy (&key[name_len], suffix);
+}
+
+/*****************************************************************************/
+
 static void
 debug_log (MMPortSerial *port, const char *prefix, const char *buf, gsize len)
 {
     static GString *debug = NULL;
     const char *s;
+    MMKernelDevice *kernel_device;
 
     if (!debug)
         debug = g_string_sized_new (256);
@@ -461,7 +1080,10 @@ debug_log (MMPortSerial *port, const char *prefix, const char *buf, gsize len)
     }
 
     g_string_append_c (debug, '\'');
-    mm_dbg ("(%s): %s", mm_port_get_device (MM_PORT (port)), debug->str);
+    /* Keep the traces of each modem, so that they can be dumped on failure */
+    kernel_device = mm_port_peek_kernel_device (MM_PORT (port));
+    mm_trace (kernel_device ? mm_kernel_device_get_physdev_uid (kernel_device) : NULL,
+              "(%s): %s", mm_port_get_device (MM_PORT (port)), debug->str);
     g_string_truncate (debug, 0);
 }
 
@@ -550,6 +1172,11 @@ mm_port_serial_at_init (MMPortSerialAt *self)
 
     /* By default, don't send line feed */
     self->priv->send_lf = FALSE;
+
+    self->priv->unsolicited_msg_handlers_index = g_hash_table_new_full (g_str_hash,
+                                                                        g_str_equal,
+                                                                        NULL,
+                                                                        (GDestroyNotify) g_slist_free);
 }
 
 static void
@@ -612,17 +1239,10 @@ finalize (GObject *object)
 {
     MMPortSerialAt *self = MM_PORT_SERIAL_AT (object);
 
-    while (self->priv->unsolicited_msg_handlers) {
-        MMAtUnsolicitedMsgHandler *handler = (MMAtUnsolicitedMsgHandler *) self->priv->unsolicited_msg_handlers->data;
-
-        if (handler->notify)
-            handler->notify (handler->user_data);
-
-        g_regex_unref (handler->regex);
-        g_slice_free (MMAtUnsolicitedMsgHandler, handler);
-        self->priv->unsolicited_msg_handlers = g_slist_delete_link (self->priv->unsolicited_msg_handlers,
-                                                                    self->priv->unsolicited_msg_handlers);
-    }
+    /* Keys are owned by the handlers, so the index goes first */
+    g_hash_table_unref (self->priv->unsolicited_msg_handlers_index);
+    g_slist_free_full (self->priv->unsolicited_msg_handlers,
+                       (GDestroyNotify) unsolicited_msg_handler_free);
 
     if (self->priv->response_parser_notify)
         self->priv->response_parser_notify (self->priv->response_parser_user_data);
@@ -648,6 +1268,8 @@ mm_port_serial_at_class_init (MMPortSerialAtClass *klass)
     serial_class->parse_unsolicited = parse_unsolicited;
     serial_class->parse_response = parse_response;
     serial_class->debug_log = debug_log;
+    serial_class->get_cache_policy = get_cache_policy;
+    serial_class->get_stats_key = get_stats_key;
     serial_class->config = config;
 
     g_object_class_install_property
@@ -86,6 +86,9 @@ void     mm_port_serial_at_add_unsolicited_msg_handler (MMPortSerialAt *self,
                                                         gpointer user_data,
                                                         GDestroyNotify notify);
 
+void     mm_port_serial_at_remove_unsolicited_msg_handler (MMPortSerialAt *self,
+                                                           GRegex *regex);
+
 void     mm_port_serial_at_enable_unsolicited_msg_handler (MMPortSerialAt *self,
                                                            GRegex *regex,
                                                            gboolean enable);
@@ -103,6 +106,15 @@ void         mm_port_serial_at_command        (MMPortSerialAt *self,
                                                GCancellable *cancellable,
                                                GAsyncReadyCallback callback,
                                                gpointer user_data);
+void         mm_port_serial_at_command_full   (MMPortSerialAt *self,
+                                               const char *command,
+                                               guint32 timeout_seconds,
+                                               gboolean is_raw,
+                                               gboolean allow_cached,
+                                               MMPortSerialCommandPriority priority,
+                                               GCancellable *cancellable,
+                                               GAsyncReadyCallback callback,
+                                               gpointer user_data);
 const gchar *mm_port_serial_at_command_finish (MMPortSerialAt *self,
                                                GAsyncResult *res,
                                                GError **error);
@@ -20,6 +20,7 @@
 
 #include "mm-port-serial-gps.h"
 #include "mm-log.h"
+#include "mm-regex.h"
 
 G_DEFINE_TYPE (MMPortSerialGps, mm_port_serial_gps, MM_TYPE_PORT_SERIAL)
 
@@ -53,52 +54,51 @@ mm_port_serial_gps_add_trace_handler (MMPortSerialGps *self,
 
 /*****************************************************************************/
 
-static gboolean
-remove_eval_cb (const GMatchInfo *match_info,
-                GString *result,
-                gpointer user_data)
-{
-    int *result_len = (int *) user_data;
-    int start;
-    int end;
-
-    if (g_match_info_fetch_pos  (match_info, 0, &start, &end))
-        *result_len -= (end - start);
-
-    return FALSE;
-}
-
 static MMPortSerialResponseType
 parse_response (MMPortSerial *port,
-                GByteArray *response,
+                MMPortSerialBuffer *response,
                 GByteArray **parsed_response,
                 GError **error)
 {
     MMPortSerialGps *self = MM_PORT_SERIAL_GPS (port);
     gboolean matches;
     GMatchInfo *match_info;
-    gchar *str;
-    gint result_len;
-    guint i;
-
-    for (i = 0; i < response->len; i++) {
+    GByteArray *unmatched;
+    const guint8 *data;
+    gsize len;
+    gsize i;
+    gint start;
+    gint end;
+    gint last_end = 0;
+
+    data = mm_port_serial_buffer_peek (response, &len);
+    for (i = 0; i < len; i++) {
         /* If there is any content before the first $,
          * assume it's garbage, and skip it */
-        if (response->data[i] == '$') {
-            if (i > 0)
-                g_byte_array_remove_range (response, 0, i);
+        if (data[i] == '$') {
+            if (i > 0) {
+                mm_port_serial_buffer_consume (response, i);
+                data = mm_port_serial_buffer_peek (response, &len);
+            }
             /* else, good, we're already started with $ */
             break;
         }
     }
 
     matches = g_regex_match_full (self->priv->known_traces_regex,
-                                  (const gchar *) response->data,
-                                  response->len,
+                                  (const gchar *) data,
+                                  len,
                                   0, 0, &match_info, NULL);
+    if (!matches) {
+        g_match_info_free (match_info);
+        return MM_PORT_SERIAL_RESPONSE_NONE;
+    }
 
-    if (self->priv->callback) {
-        while (g_match_info_matches (match_info)) {
+    /* Report each trace, and keep whatever is found in between as the
+     * parsed response */
+    unmatched = g_byte_array_new ();
+    while (g_match_info_matches (match_info)) {
+        if (self->priv->callback) {
             gchar *trace;
 
             trace = g_match_info_fetch (match_info, 0);
@@ -106,28 +106,22 @@ parse_response (MMPortSerial *port,
                 self->priv->callback (self, trace, self->priv->user_data);
                 g_free (trace);
             }
-            g_match_info_next (match_info, NULL);
         }
-    }
 
+        if (g_match_info_fetch_pos (match_info, 0, &start, &end)) {
+            g_byte_array_append (unmatched, &data[last_end], start - last_end);
+            last_end = end;
+        }
+        g_match_info_next (match_info, NULL);
+    }
     g_match_info_free (match_info);
-
-    if (!matches)
-        return MM_PORT_SERIAL_RESPONSE_NONE;
-
-    /* Remove matches */
-    result_len = response->len;
-    str = g_regex_replace_eval (self->priv->known_traces_regex,
-                                (const char *) response->data,
-                                response->len,
-                                0, 0,
-                                remove_eval_cb, &result_len, NULL);
+    g_byte_array_append (unmatched, &data[last_end], len - last_end);
 
     /* Cleanup response buffer */
-    g_byte_array_remove_range (response, 0, response->len);
+    mm_port_serial_buffer_consume (response, len);
 
     /* Build parsed response */
-    *parsed_response = g_byte_array_new_take ((guint8 *)str, result_len);
+    *parsed_response = unmatched;
 
     return TRUE;
 }
@@ -186,10 +180,10 @@ mm_port_serial_gps_init (MMPortSerialGps *self)
 
     /* We'll assume that all traces start with the dollar sign and end with \r\n */
     self->priv->known_traces_regex =
-        g_regex_new ("\\$.*\\r\\n",
-                     G_REGEX_RAW | G_REGEX_OPTIMIZE,
-                     0,
-                     NULL);
+        mm_regex_get ("\\$.*\\r\\n",
+                      G_REGEX_RAW | G_REGEX_OPTIMIZE,
+                      0,
+                      NULL);
 }
 
 static void
@@ -38,9 +38,9 @@ struct _MMPortSerialQcdmPrivate {
 /*****************************************************************************/
 
 static gboolean
-find_qcdm_start (GByteArray *response, gsize *start)
+find_qcdm_start (const guint8 *data, gsize len, gsize *start)
 {
-    int i, last = -1;
+    gint i, last = -1;
 
     /* Look for 3 bytes and a QCDM frame marker, ie enough data for a valid
      * frame.  There will usually be three cases here; (1) a QCDM frame
@@ -48,8 +48,8 @@ find_qcdm_start (GByteArray *response, gsize *start)
      * with 0x7E and ending with 0x7E, and (3) a non-QCDM frame that still
      * uses HDLC framing (like Sierra CnS) that starts and ends with 0x7E.
      */
-    for (i = 0; i < response->len; i++) {
-        if (response->data[i] == 0x7E) {
+    for (i = 0; i < len; i++) {
+        if (data[i] == 0x7E) {
             if (i > last + 3) {
                 /* Got a full QCDM frame; 3 non-0x7E bytes and a terminator */
                 if (start)
@@ -65,11 +65,13 @@ find_qcdm_start (GByteArray *response, gsize *start)
 }
 
 static MMPortSerialResponseType
-parse_qcdm (GByteArray *response,
+parse_qcdm (MMPortSerialBuffer *response,
             gboolean want_log,
             GByteArray **parsed_response,
             GError **error)
 {
+    const guint8 *data;
+    gsize len;
     gsize start = 0;
     gsize used = 0;
     gsize unescaped_len = 0;
@@ -77,7 +79,8 @@ parse_qcdm (GByteArray *response,
     qcdmbool more = FALSE;
 
     /* Get the offset into the buffer of where the QCDM frame starts */
-    if (!find_qcdm_start (response, &start)) {
+    data = mm_port_serial_buffer_peek (response, &len);
+    if (!find_qcdm_start (data, len, &start)) {
         /* Discard the unparsable data right away, we do need a QCDM
          * start, and anything that comes before it is unknown data
          * that we'll never use. */
@@ -85,14 +88,17 @@ parse_qcdm (GByteArray *response,
     }
 
     /* If there is anything before the start marker, remove it */
-    g_byte_array_remove_range (response, 0, start);
-    if (response->len == 0)
+    if (start > 0) {
+        mm_port_serial_buffer_consume (response, start);
+        data = mm_port_serial_buffer_peek (response, &len);
+    }
+    if (len == 0)
         return MM_PORT_SERIAL_RESPONSE_NONE;
 
     /* Try to decapsulate the response into a buffer */
     unescaped_buffer = g_malloc (1024);
-    if (!dm_decapsulate_buffer ((const char *)(response->data),
-                                response->len,
+    if (!dm_decapsulate_buffer ((const char *) data,
+                                len,
                                 (char *)unescaped_buffer,
                                 1024,
                                 &unescaped_len,
@@ -133,13 +139,13 @@ parse_qcdm (GByteArray *response,
     /* Remove the data we used from the input buffer, leaving out any
      * additional data that may already been received (e.g. from the following
      * message). */
-    g_byte_array_remove_range (response, 0, used);
+    mm_port_serial_buffer_consume (response, used);
     return MM_PORT_SERIAL_RESPONSE_BUFFER;
 }
 
 static MMPortSerialResponseType
 parse_response (MMPortSerial *port,
-                GByteArray *response,
+                MMPortSerialBuffer *response,
                 GByteArray **parsed_response,
                 GError **error)
 {
@@ -194,6 +200,7 @@ mm_port_serial_qcdm_command (MMPortSerialQcdm *self,
                             timeout_seconds,
                             FALSE, /* never cached */
                             FALSE, /* always queued last */
+                            MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
                             cancellable,
                             (GAsyncReadyCallback)serial_command_ready,
                             task);
@@ -204,6 +211,7 @@ debug_log (MMPortSerial *port, const char *prefix, const char *buf, gsize len)
 {
     static GString *debug = NULL;
     const char *s = buf;
+    MMKernelDevice *kernel_device;
 
     if (!debug)
         debug = g_string_sized_new (512);
@@ -213,7 +221,10 @@ debug_log (MMPortSerial *port, const char *prefix, const char *buf, gsize len)
     while (len--)
         g_string_append_printf (debug, " %02x", (guint8) (*s++ & 0xFF));
 
-    mm_dbg ("(%s): %s", mm_port_get_device (MM_PORT (port)), debug->str);
+    /* Keep the traces of each modem, so that they can be dumped on failure */
+    kernel_device = mm_port_peek_kernel_device (MM_PORT (port));
+    mm_trace (kernel_device ? mm_kernel_device_get_physdev_uid (kernel_device) : NULL,
+              "(%s): %s", mm_port_get_device (MM_PORT (port)), debug->str);
     g_string_truncate (debug, 0);
 }
 
@@ -288,7 +299,7 @@ mm_port_serial_qcdm_enable_unsolicited_msg_handler (MMPortSerialQcdm *self,
 }
 
 static void
-parse_unsolicited (MMPortSerial *port, GByteArray *response)
+parse_unsolicited (MMPortSerial *port, MMPortSerialBuffer *response)
 {
     MMPortSerialQcdm *self = MM_PORT_SERIAL_QCDM (port);
     GByteArray *log_buffer = NULL;
@@ -35,6 +35,7 @@
 
 #include "mm-port-serial.h"
 #include "mm-log.h"
+#include "mm-command-lanes.h"
 #include "mm-helper-enums-types.h"
 
 static gboolean port_serial_queue_process          (gpointer data);
@@ -45,6 +46,11 @@ static void     port_serial_reopen_cancel          (MMPortSerial *self);
 static void     port_serial_set_cached_reply       (MMPortSerial *self,
                                                     const GByteArray *command,
                                                     const GByteArray *response);
+static void     port_serial_get_cache_policy       (MMPortSerial *self,
+                                                    const GByteArray *command,
+                                                    guint *ttl_seconds,
+                                                    MMPortSerialCacheInvalidation *invalidate_on,
+                                                    MMPortSerialCacheInvalidation *invalidates);
 
 G_DEFINE_TYPE (MMPortSerial, mm_port_serial, MM_TYPE_PORT)
 
@@ -67,6 +73,7 @@ enum {
     BUFFER_FULL,
     TIMED_OUT,
     FORCED_CLOSE,
+    CACHE_INVALIDATED,
 
     LAST_SIGNAL
 };
@@ -75,13 +82,25 @@ static guint signals[LAST_SIGNAL] = { 0 };
 
 #define SERIAL_BUF_SIZE 2048
 
+/* Commands beyond this many different ones get their statistics aggregated
+ * together, so that e.g. arbitrary commands sent by users don't grow the
+ * table forever */
+#define COMMAND_STATS_MAX_KEYS 64
+#define COMMAND_STATS_KEY_SIZE 32
+#define COMMAND_STATS_KEY_OTHER "other"
+
 struct _MMPortSerialPrivate {
     guint32 open_count;
     gboolean forced_close;
     int fd;
     GHashTable *reply_cache;
+    guint reply_cache_hits;
+    guint reply_cache_misses;
     GQueue *queue;
-    GByteArray *response;
+    MMPortSerialBuffer *response;
+    MMPortSerialLaneStats lane_stats[MM_PORT_SERIAL_COMMAND_PRIORITY_LAST];
+    /* Command stats key -> MMPortSerialCommandStats */
+    GHashTable *command_stats;
 
     /* For real ports, iochannel, and we implement the eagain limit */
     GIOChannel *iochannel;
@@ -115,10 +134,168 @@ struct _MMPortSerialPrivate {
     GTask *reopen_task;
 };
 
+/*****************************************************************************/
+/* Response buffer */
+
+struct _MMPortSerialBuffer {
+    guint8 *data;
+    /* Allocated size */
+    gsize   size;
+    /* Pending data goes from start to end */
+    gsize   start;
+    gsize   end;
+    /* Pending data already scanned, see mm_port_serial_buffer_set_scanned() */
+    gsize   scanned;
+};
+
+MMPortSerialBuffer *
+mm_port_serial_buffer_new (gsize size)
+{
+    MMPortSerialBuffer *buffer;
+
+    buffer = g_slice_new0 (MMPortSerialBuffer);
+    buffer->size = MAX (size, 1);
+    buffer->data = g_malloc (buffer->size);
+    return buffer;
+}
+
+void
+mm_port_serial_buffer_free (MMPortSerialBuffer *buffer)
+{
+    g_free (buffer->data);
+    g_slice_free (MMPortSerialBuffer, buffer);
+}
+
+const guint8 *
+mm_port_serial_buffer_peek (MMPortSerialBuffer *buffer,
+                            gsize *len)
+{
+    *len = buffer->end - buffer->start;
+    return &buffer->data[buffer->start];
+}
+
+gsize
+mm_port_serial_buffer_get_len (MMPortSerialBuffer *buffer)
+{
+    return buffer->end - buffer->start;
+}
+
+guint8 *
+mm_port_serial_buffer_reserve (MMPortSerialBuffer *buffer,
+                               gsize len)
+{
+    gsize pending;
+
+    /* Enough room at the tail already? */
+    if (buffer->size - buffer->end >= len)
+        return &buffer->data[buffer->end];
+
+    /* Compact, moving the pending data to the beginning of the storage */
+    pending = buffer->end - buffer->start;
+    if (buffer->start > 0) {
+        memmove (buffer->data, &buffer->data[buffer->start], pending);
+        buffer->start = 0;
+        buffer->end = pending;
+    }
+
+    /* And grow if still not enough */
+    if (buffer->size - buffer->end < len) {
+        buffer->size = MAX (buffer->size * 2, pending + len);
+        buffer->data = g_realloc (buffer->data, buffer->size);
+    }
+
+    return &buffer->data[buffer->end];
+}
+
+void
+mm_port_serial_buffer_commit (MMPortSerialBuffer *buffer,
+                              gsize len)
+{
+    g_assert (buffer->end + len <= buffer->size);
+    buffer->end += len;
+}
+
+void
+mm_port_serial_buffer_append (MMPortSerialBuffer *buffer,
+                              const guint8 *data,
+                              gsize len)
+{
+    memcpy (mm_port_serial_buffer_reserve (buffer, len), data, len);
+    mm_port_serial_buffer_commit (buffer, len);
+}
+
+void
+mm_port_serial_buffer_consume (MMPortSerialBuffer *buffer,
+                               gsize len)
+{
+    g_assert (len <= buffer->end - buffer->start);
+
+    buffer->start += len;
+    buffer->scanned = buffer->scanned > len ? buffer->scanned - len : 0;
+    /* Reuse the whole storage when everything consumed */
+    if (buffer->start == buffer->end)
+        buffer->start = buffer->end = 0;
+}
+
+void
+mm_port_serial_buffer_remove_range (MMPortSerialBuffer *buffer,
+                                    gsize offset,
+                                    gsize len)
+{
+    gsize pending;
+    gsize after;
+    gsize scanned;
+
+    pending = buffer->end - buffer->start;
+    g_assert (offset + len <= pending);
+
+    /* The scanned mark stays on the same contents, or moves back to where
+     * the range was removed if it was inside */
+    scanned = buffer->scanned;
+    if (scanned > offset)
+        scanned = (scanned >= offset + len) ? scanned - len : offset;
+
+    /* Move whichever side of the removed range is shorter */
+    after = pending - offset - len;
+    if (offset <= after) {
+        memmove (&buffer->data[buffer->start + len], &buffer->data[buffer->start], offset);
+        mm_port_serial_buffer_consume (buffer, len);
+    } else {
+        memmove (&buffer->data[buffer->start + offset], &buffer->data[buffer->start + offset + len], after);
+        buffer->end -= len;
+    }
+
+    buffer->scanned = scanned;
+}
+
+void
+mm_port_serial_buffer_clear (MMPortSerialBuffer *buffer)
+{
+    buffer->start = buffer->end = 0;
+    buffer->scanned = 0;
+}
+
+gsize
+mm_port_serial_buffer_get_scanned (MMPortSerialBuffer *buffer)
+{
+    return buffer->scanned;
+}
+
+void
+mm_port_serial_buffer_set_scanned (MMPortSerialBuffer *buffer,
+                                   gsize scanned)
+{
+    g_assert (scanned <= buffer->end - buffer->start);
+    buffer->scanned = scanned;
+}
+
 /*****************************************************************************/
 /* Command */
 
 typedef struct {
+    /* Must be first, the queue is ordered by mm_command_lanes_insert() */
+    MMCommandLanesItem lane;
+
     MMPortSerial *self;
     GSimpleAsyncResult *result;
     GCancellable *cancellable;
@@ -127,8 +304,16 @@ typedef struct {
     gboolean allow_cached;
     guint32 eagain_count;
 
+    /* Timings of the command lifecycle, in monotonic time */
+    gint64 queued_time;
+    gint64 send_start_time;
+    gint64 send_end_time;
+    gint64 first_byte_time;
+    /* Time spent in the response parsers */
+    gint64 parse_us;
+    gboolean cached;
+
     guint32 idx;
-    gboolean started;
     gboolean done;
 } CommandContext;
 
@@ -158,12 +343,134 @@ mm_port_serial_command_finish (MMPortSerial *self,
     return g_byte_array_ref (g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res)));
 }
 
+void
+mm_port_serial_get_lane_stats (MMPortSerial *self,
+                               MMPortSerialCommandPriority priority,
+                               MMPortSerialLaneStats *stats)
+{
+    g_return_if_fail (MM_IS_PORT_SERIAL (self));
+    g_return_if_fail (priority < MM_PORT_SERIAL_COMMAND_PRIORITY_LAST);
+    g_return_if_fail (stats != NULL);
+
+    *stats = self->priv->lane_stats[priority];
+    stats->depth = mm_command_lanes_get_depth (self->priv->queue, priority);
+}
+
+static void
+port_serial_lane_dispatched (MMPortSerial *self,
+                             CommandContext *ctx)
+{
+    MMPortSerialLaneStats *stats;
+    guint64 wait_us;
+
+    stats = &self->priv->lane_stats[ctx->lane.lane];
+    wait_us = (guint64) (ctx->send_start_time - ctx->queued_time);
+    stats->n_dispatched++;
+    stats->total_wait_us += wait_us;
+    if (wait_us > stats->max_wait_us)
+        stats->max_wait_us = wait_us;
+}
+
+static void
+command_stats_free (MMPortSerialCommandStats *stats)
+{
+    g_slice_free (MMPortSerialCommandStats, stats);
+}
+
+static MMPortSerialCommandStats *
+port_serial_peek_command_stats (MMPortSerial *self,
+                                const GByteArray *command)
+{
+    gchar key[COMMAND_STATS_KEY_SIZE] = { 0 };
+    MMPortSerialCommandStats *stats;
+
+    if (MM_PORT_SERIAL_GET_CLASS (self)->get_stats_key)
+        MM_PORT_SERIAL_GET_CLASS (self)->get_stats_key (self, command, key, sizeof (key));
+    else if (command->len > 0)
+        g_snprintf (key, sizeof (key), "0x%02x", command->data[0]);
+
+    stats = g_hash_table_lookup (self->priv->command_stats, key);
+    if (stats)
+        return stats;
+
+    if (g_hash_table_size (self->priv->command_stats) >= COMMAND_STATS_MAX_KEYS) {
+        stats = g_hash_table_lookup (self->priv->command_stats, COMMAND_STATS_KEY_OTHER);
+        if (stats)
+            return stats;
+        g_strlcpy (key, COMMAND_STATS_KEY_OTHER, sizeof (key));
+    }
+
+    stats = g_slice_new0 (MMPortSerialCommandStats);
+    g_hash_table_insert (self->priv->command_stats, g_strdup (key), stats);
+    return stats;
+}
+
+static void
+port_serial_record_command_stats (MMPortSerial *self,
+                                  CommandContext *ctx,
+                                  const GError *error)
+{
+    MMPortSerialCommandStats *stats;
+
+    stats = port_serial_peek_command_stats (self, ctx->command);
+    stats->n_commands++;
+
+    if (ctx->cached) {
+        stats->n_cache_hits++;
+        return;
+    }
+
+    if (g_error_matches (error, MM_SERIAL_ERROR, MM_SERIAL_ERROR_RESPONSE_TIMEOUT))
+        stats->n_timeouts++;
+    else if (error)
+        stats->n_errors++;
+
+    /* Failed before anything was written */
+    if (!ctx->lane.started)
+        return;
+
+    mm_histogram_record (&stats->queue_wait, (guint64) (ctx->send_start_time - ctx->queued_time));
+    if (!ctx->done)
+        return;
+    mm_histogram_record (&stats->send, (guint64) (ctx->send_end_time - ctx->send_start_time));
+    if (!ctx->first_byte_time)
+        return;
+    mm_histogram_record (&stats->first_byte, (guint64) (ctx->first_byte_time - ctx->send_end_time));
+    mm_histogram_record (&stats->parse, (guint64) ctx->parse_us);
+}
+
+void
+mm_port_serial_foreach_command_stats (MMPortSerial *self,
+                                      MMPortSerialCommandStatsFunc callback,
+                                      gpointer user_data)
+{
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+
+    g_return_if_fail (MM_IS_PORT_SERIAL (self));
+    g_return_if_fail (callback != NULL);
+
+    g_hash_table_iter_init (&iter, self->priv->command_stats);
+    while (g_hash_table_iter_next (&iter, &key, &value))
+        callback ((const gchar *) key, (const MMPortSerialCommandStats *) value, user_data);
+}
+
+guint
+mm_port_serial_get_n_consecutive_timeouts (MMPortSerial *self)
+{
+    g_return_val_if_fail (MM_IS_PORT_SERIAL (self), 0);
+
+    return self->priv->n_consecutive_timeouts;
+}
+
 void
 mm_port_serial_command (MMPortSerial *self,
                         GByteArray *command,
                         guint32 timeout_seconds,
                         gboolean allow_cached,
                         gboolean run_next,
+                        MMPortSerialCommandPriority priority,
                         GCancellable *cancellable,
                         GAsyncReadyCallback callback,
                         gpointer user_data)
@@ -172,6 +479,7 @@ mm_port_serial_command (MMPortSerial *self,
 
     g_return_if_fail (MM_IS_PORT_SERIAL (self));
     g_return_if_fail (command != NULL);
+    g_return_if_fail (priority < MM_PORT_SERIAL_COMMAND_PRIORITY_LAST);
 
     /* Setup command context */
     ctx = g_slice_new0 (CommandContext);
@@ -183,6 +491,7 @@ mm_port_serial_command (MMPortSerial *self,
     ctx->command = g_byte_array_ref (command);
     ctx->allow_cached = allow_cached;
     ctx->timeout = timeout_seconds;
+    ctx->lane.lane = priority;
     ctx->cancellable = (cancellable ? g_object_ref (cancellable) : NULL);
 
     /* Only accept about 3 seconds of EAGAIN for this command */
@@ -204,12 +513,8 @@ mm_port_serial_command (MMPortSerial *self,
     if (!allow_cached)
         port_serial_set_cached_reply (self, ctx->command, NULL);
 
-    /* If requested to run next, push to the head of the queue so that it really is
-     * the next one sent */
-    if (run_next)
-        g_queue_push_head (self->priv->queue, ctx);
-    else
-        g_queue_push_tail (self->priv->queue, ctx);
+    ctx->queued_time = g_get_monotonic_time ();
+    mm_command_lanes_insert (self->priv->queue, &ctx->lane, run_next);
 
     if (g_queue_get_length (self->priv->queue) == 1)
         port_serial_schedule_queue_process (self, 0);
@@ -570,8 +875,23 @@ port_serial_process_command (MMPortSerial *self,
     }
 
     /* Only print command the first time */
-    if (ctx->started == FALSE) {
-        ctx->started = TRUE;
+    if (ctx->lane.started == FALSE) {
+        guint ttl_seconds;
+        MMPortSerialCacheInvalidation invalidate_on;
+        MMPortSerialCacheInvalidation invalidates;
+
+        ctx->lane.started = TRUE;
+        ctx->send_start_time = g_get_monotonic_time ();
+        port_serial_lane_dispatched (self, ctx);
+
+        /* Drop the cached replies which this command makes obsolete, and let
+         * the modem drop the ones cached in its other ports as well */
+        port_serial_get_cache_policy (self, ctx->command, &ttl_seconds, &invalidate_on, &invalidates);
+        if (invalidates != MM_PORT_SERIAL_CACHE_INVALIDATION_NONE) {
+            mm_port_serial_invalidate_cached_replies (self, invalidates);
+            g_signal_emit (self, signals[CACHE_INVALIDATED], 0, invalidates);
+        }
+
         serial_debug (self, "-->", (const char *) ctx->command->data, ctx->command->len);
     }
 
@@ -663,12 +983,47 @@ port_serial_process_command (MMPortSerial *self,
     } else
         g_assert_not_reached ();
 
-    if (ctx->idx >= ctx->command->len)
+    if (ctx->idx >= ctx->command->len) {
         ctx->done = TRUE;
+        ctx->send_end_time = g_get_monotonic_time ();
+    }
 
     return TRUE;
 }
 
+typedef struct {
+    GByteArray *response;
+    /* Monotonic time after which the reply is obsolete, 0 if never */
+    gint64 expiration_time;
+    MMPortSerialCacheInvalidation invalidate_on;
+} CachedReply;
+
+static void
+cached_reply_free (CachedReply *cached)
+{
+    g_byte_array_unref (cached->response);
+    g_slice_free (CachedReply, cached);
+}
+
+static void
+port_serial_get_cache_policy (MMPortSerial *self,
+                              const GByteArray *command,
+                              guint *ttl_seconds,
+                              MMPortSerialCacheInvalidation *invalidate_on,
+                              MMPortSerialCacheInvalidation *invalidates)
+{
+    *ttl_seconds = 0;
+    *invalidate_on = MM_PORT_SERIAL_CACHE_INVALIDATION_ALL;
+    *invalidates = MM_PORT_SERIAL_CACHE_INVALIDATION_NONE;
+
+    if (MM_PORT_SERIAL_GET_CLASS (self)->get_cache_policy)
+        MM_PORT_SERIAL_GET_CLASS (self)->get_cache_policy (self,
+                                                           command,
+                                                           ttl_seconds,
+                                                           invalidate_on,
+                                                           invalidates);
+}
+
 static void
 port_serial_set_cached_reply (MMPortSerial *self,
                               const GByteArray *command,
@@ -680,11 +1035,19 @@ port_serial_set_cached_reply (MMPortSerial *self,
 
     if (response) {
         GByteArray *cmd_copy = g_byte_array_sized_new (command->len);
-        GByteArray *rsp_copy = g_byte_array_sized_new (response->len);
+        CachedReply *cached;
+        guint ttl_seconds;
+        MMPortSerialCacheInvalidation invalidates;
+
+        cached = g_slice_new0 (CachedReply);
+        cached->response = g_byte_array_sized_new (response->len);
+        g_byte_array_append (cached->response, response->data, response->len);
+        port_serial_get_cache_policy (self, command, &ttl_seconds, &cached->invalidate_on, &invalidates);
+        if (ttl_seconds)
+            cached->expiration_time = g_get_monotonic_time () + ((gint64) ttl_seconds * G_USEC_PER_SEC);
 
         g_byte_array_append (cmd_copy, command->data, command->len);
-        g_byte_array_append (rsp_copy, response->data, response->len);
-        g_hash_table_insert (self->priv->reply_cache, cmd_copy, rsp_copy);
+        g_hash_table_insert (self->priv->reply_cache, cmd_copy, cached);
     } else
         g_hash_table_remove (self->priv->reply_cache, command);
 }
@@ -693,7 +1056,61 @@ static const GByteArray *
 port_serial_get_cached_reply (MMPortSerial *self,
                               GByteArray *command)
 {
-    return (const GByteArray *)g_hash_table_lookup (self->priv->reply_cache, command);
+    CachedReply *cached;
+
+    cached = (CachedReply *)g_hash_table_lookup (self->priv->reply_cache, command);
+    if (cached && cached->expiration_time && g_get_monotonic_time () >= cached->expiration_time) {
+        g_hash_table_remove (self->priv->reply_cache, command);
+        cached = NULL;
+    }
+
+    if (!cached) {
+        self->priv->reply_cache_misses++;
+        return NULL;
+    }
+
+    self->priv->reply_cache_hits++;
+    return cached->response;
+}
+
+static gboolean
+cached_reply_invalidated (gpointer key,
+                          CachedReply *cached,
+                          gpointer what)
+{
+    return !!(cached->invalidate_on & GPOINTER_TO_UINT (what));
+}
+
+void
+mm_port_serial_invalidate_cached_replies (MMPortSerial *self,
+                                          MMPortSerialCacheInvalidation what)
+{
+    guint n_removed;
+
+    g_return_if_fail (MM_IS_PORT_SERIAL (self));
+
+    if (what == MM_PORT_SERIAL_CACHE_INVALIDATION_NONE)
+        return;
+
+    n_removed = g_hash_table_foreach_remove (self->priv->reply_cache,
+                                             (GHRFunc)cached_reply_invalidated,
+                                             GUINT_TO_POINTER (what));
+    if (n_removed)
+        mm_dbg ("(%s) invalidated %u cached replies",
+                mm_port_get_device (MM_PORT (self)), n_removed);
+}
+
+void
+mm_port_serial_get_cache_stats (MMPortSerial *self,
+                                guint *hits,
+                                guint *misses)
+{
+    g_return_if_fail (MM_IS_PORT_SERIAL (self));
+
+    if (hits)
+        *hits = self->priv->reply_cache_hits;
+    if (misses)
+        *misses = self->priv->reply_cache_misses;
 }
 
 static void
@@ -747,6 +1164,8 @@ port_serial_got_response (MMPortSerial *self,
 
         ctx = (CommandContext *) g_queue_pop_head (self->priv->queue);
         if (ctx) {
+            port_serial_record_command_stats (self, ctx, error);
+
             /* Complete the command context with the appropriate result */
             if (error)
                 g_simple_async_result_set_from_error (ctx->result, error);
@@ -843,6 +1262,7 @@ port_serial_queue_process (gpointer data)
         if (cached) {
             GByteArray *parsed_response;
 
+            ctx->cached = TRUE;
             parsed_response = g_byte_array_sized_new (cached->len);
             g_byte_array_append (parsed_response, cached->data, cached->len);
             /* Note: may complete last operation and unref the MMPortSerial */
@@ -906,6 +1326,13 @@ parse_response_buffer (MMPortSerial *self)
 {
     GError *error = NULL;
     GByteArray *parsed_response = NULL;
+    MMPortSerialResponseType response_type;
+    CommandContext *ctx;
+    gint64 parse_start_time;
+
+    /* Parsing time is accounted to the command waiting for its reply, if any */
+    ctx = (CommandContext *) g_queue_peek_head (self->priv->queue);
+    parse_start_time = (ctx && ctx->done) ? g_get_monotonic_time () : 0;
 
     /* Parse unsolicited messages in the subclass.
      *
@@ -923,10 +1350,17 @@ parse_response_buffer (MMPortSerial *self)
      * response buffer, and the response buffer is cleaned up accordingly.
      */
     g_assert (MM_PORT_SERIAL_GET_CLASS (self)->parse_response != NULL);
-    switch (MM_PORT_SERIAL_GET_CLASS (self)->parse_response (self,
-                                                             self->priv->response,
-                                                             &parsed_response,
-                                                             &error)) {
+    response_type = MM_PORT_SERIAL_GET_CLASS (self)->parse_response (self,
+                                                                     self->priv->response,
+                                                                     &parsed_response,
+                                                                     &error);
+
+    /* Unsolicited message handlers may have completed the command, so look it
+     * up again */
+    if (parse_start_time && ctx == g_queue_peek_head (self->priv->queue))
+        ctx->parse_us += g_get_monotonic_time () - parse_start_time;
+
+    switch (response_type) {
     case MM_PORT_SERIAL_RESPONSE_BUFFER:
         /* We have a valid response to process */
         g_assert (parsed_response);
@@ -953,7 +1387,7 @@ static gboolean
 common_input_available (MMPortSerial *self,
                         GIOCondition condition)
 {
-    char buf[SERIAL_BUF_SIZE + 1];
+    gchar *buf;
     gsize bytes_read;
     GIOStatus status = G_IO_STATUS_NORMAL;
     CommandContext *ctx;
@@ -966,26 +1400,27 @@ common_input_available (MMPortSerial *self,
         device = mm_port_get_device (MM_PORT (self));
         mm_dbg ("(%s) unexpected port hangup!", device);
 
-        if (self->priv->response->len)
-            g_byte_array_remove_range (self->priv->response, 0, self->priv->response->len);
+        mm_port_serial_buffer_clear (self->priv->response);
         port_serial_close_force (self);
         return G_SOURCE_REMOVE;
     }
 
     if (condition & G_IO_ERR) {
-        if (self->priv->response->len)
-            g_byte_array_remove_range (self->priv->response, 0, self->priv->response->len);
+        mm_port_serial_buffer_clear (self->priv->response);
         return G_SOURCE_CONTINUE;
     }
 
     /* Don't read any input if the current command isn't done being sent yet */
     ctx = g_queue_peek_nth (self->priv->queue, 0);
-    if (ctx && (ctx->started == TRUE) && (ctx->done == FALSE))
+    if (ctx && (ctx->lane.started == TRUE) && (ctx->done == FALSE))
         return G_SOURCE_CONTINUE;
 
     while (iterate) {
         bytes_read = 0;
 
+        /* Read straight into the free space of the response buffer */
+        buf = (gchar *) mm_port_serial_buffer_reserve (self->priv->response, SERIAL_BUF_SIZE);
+
         if (self->priv->iochannel) {
             status = g_io_channel_read_chars (self->priv->iochannel,
                                               buf,
@@ -1030,13 +1465,26 @@ common_input_available (MMPortSerial *self,
 
         g_assert (bytes_read > 0);
         serial_debug (self, "<--", buf, bytes_read);
-        g_byte_array_append (self->priv->response, (const guint8 *) buf, bytes_read);
+        mm_port_serial_buffer_commit (self->priv->response, bytes_read);
+
+        /* First bytes received since the command in flight was written */
+        ctx = g_queue_peek_head (self->priv->queue);
+        if (ctx && ctx->done && !ctx->first_byte_time)
+            ctx->first_byte_time = g_get_monotonic_time ();
 
         /* Make sure the response doesn't grow too long */
-        if ((self->priv->response->len > SERIAL_BUF_SIZE) && self->priv->spew_control) {
+        if ((mm_port_serial_buffer_get_len (self->priv->response) > SERIAL_BUF_SIZE) && self->priv->spew_control) {
+            GByteArray *full;
+            const guint8 *data;
+            gsize len;
+
             /* Notify listeners and then trim the buffer */
-            g_signal_emit (self, signals[BUFFER_FULL], 0, self->priv->response);
-            g_byte_array_remove_range (self->priv->response, 0, (SERIAL_BUF_SIZE / 2));
+            data = mm_port_serial_buffer_peek (self->priv->response, &len);
+            full = g_byte_array_sized_new (len);
+            g_byte_array_append (full, data, len);
+            g_signal_emit (self, signals[BUFFER_FULL], 0, full);
+            g_byte_array_unref (full);
+            mm_port_serial_buffer_consume (self->priv->response, (SERIAL_BUF_SIZE / 2));
         }
 
         /* See if we can parse anything. The response parsing may actually
@@ -1954,7 +2402,8 @@ mm_port_serial_init (MMPortSerial *self)
 {
     self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, MM_TYPE_PORT_SERIAL, MMPortSerialPrivate);
 
-    self->priv->reply_cache = g_hash_table_new_full (ba_hash, ba_equal, ba_free, ba_free);
+    self->priv->reply_cache = g_hash_table_new_full (ba_hash, ba_equal, ba_free, (GDestroyNotify)cached_reply_free);
+    self->priv->command_stats = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify)command_stats_free);
 
     self->priv->fd = -1;
     self->priv->baud = 57600;
@@ -1965,7 +2414,7 @@ mm_port_serial_init (MMPortSerial *self)
     self->priv->send_delay = 1000;
 
     self->priv->queue = g_queue_new ();
-    self->priv->response = g_byte_array_sized_new (500);
+    self->priv->response = mm_port_serial_buffer_new (2 * SERIAL_BUF_SIZE);
 }
 
 static void
@@ -2073,7 +2522,8 @@ finalize (GObject *object)
         g_source_remove (self->priv->queue_id);
 
     g_hash_table_destroy (self->priv->reply_cache);
-    g_byte_array_unref (self->priv->response);
+    g_hash_table_destroy (self->priv->command_stats);
+    mm_port_serial_buffer_free (self->priv->response);
     g_queue_free (self->priv->queue);
 
     G_OBJECT_CLASS (mm_port_serial_parent_class)->finalize (object);
@@ -2195,4 +2645,13 @@ mm_port_serial_class_init (MMPortSerialClass *klass)
                       NULL, NULL,
                       g_cclosure_marshal_generic,
                       G_TYPE_NONE, 0);
+
+    signals[CACHE_INVALIDATED] =
+        g_signal_new ("cache-invalidated",
+                      G_OBJECT_CLASS_TYPE (object_class),
+                      G_SIGNAL_RUN_FIRST,
+                      G_STRUCT_OFFSET (MMPortSerialClass, cache_invalidated),
+                      NULL, NULL,
+                      g_cclosure_marshal_generic,
+                      G_TYPE_NONE, 1, G_TYPE_UINT);
 }
@@ -22,6 +22,7 @@
 #include <gio/gio.h>
 
 #include "mm-modem-helpers.h"
+#include "mm-histogram.h"
 #include "mm-port.h"
 
 #define MM_TYPE_PORT_SERIAL            (mm_port_serial_get_type ())
@@ -47,10 +48,96 @@ typedef enum {
     MM_PORT_SERIAL_RESPONSE_ERROR,
 } MMPortSerialResponseType;
 
+/* Priority lanes of the command queue. Commands are sent in lane order, and
+ * in FIFO order within the same lane; a command already being sent or
+ * waiting for its response is never preempted, and a queued command is
+ * overtaken by at most MM_COMMAND_LANES_MAX_OVERTAKEN more urgent ones. */
+typedef enum {
+    MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
+    MM_PORT_SERIAL_COMMAND_PRIORITY_POLL,
+    MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND,
+    MM_PORT_SERIAL_COMMAND_PRIORITY_LAST
+} MMPortSerialCommandPriority;
+
+typedef struct {
+    /* Commands currently queued in the lane, including the one in flight */
+    guint   depth;
+    /* Commands dispatched so far from the lane */
+    guint64 n_dispatched;
+    /* Time spent queued before being dispatched, in microseconds */
+    guint64 total_wait_us;
+    guint64 max_wait_us;
+} MMPortSerialLaneStats;
+
+/* Statistics of the commands sent through the port, aggregated by command
+ * (see the get_stats_key() vfunc). Times are given in microseconds. */
+typedef struct {
+    /* Commands completed, including errors and cached replies */
+    guint64     n_commands;
+    guint64     n_timeouts;
+    guint64     n_errors;
+    guint64     n_cache_hits;
+    /* Time spent queued before being sent */
+    MMHistogram queue_wait;
+    /* Time to write the whole command, including the send delay */
+    MMHistogram send;
+    /* Time since the command was written until the first byte of reply */
+    MMHistogram first_byte;
+    /* Time spent in the response parsers until the reply was complete */
+    MMHistogram parse;
+} MMPortSerialCommandStats;
+
+typedef void (* MMPortSerialCommandStatsFunc) (const gchar                    *key,
+                                               const MMPortSerialCommandStats *stats,
+                                               gpointer                        user_data);
+
+/* State changes which make cached replies obsolete */
+typedef enum {
+    MM_PORT_SERIAL_CACHE_INVALIDATION_NONE    = 0,
+    MM_PORT_SERIAL_CACHE_INVALIDATION_SIM     = 1 << 0,
+    MM_PORT_SERIAL_CACHE_INVALIDATION_POWER   = 1 << 1,
+    MM_PORT_SERIAL_CACHE_INVALIDATION_CHARSET = 1 << 2,
+    MM_PORT_SERIAL_CACHE_INVALIDATION_ALL     = (MM_PORT_SERIAL_CACHE_INVALIDATION_SIM |
+                                                 MM_PORT_SERIAL_CACHE_INVALIDATION_POWER |
+                                                 MM_PORT_SERIAL_CACHE_INVALIDATION_CHARSET)
+} MMPortSerialCacheInvalidation;
+
 typedef struct _MMPortSerial MMPortSerial;
 typedef struct _MMPortSerialClass MMPortSerialClass;
 typedef struct _MMPortSerialPrivate MMPortSerialPrivate;
 
+/* Buffer storing the data received in the port which hasn't been consumed yet
+ * by the response parsers. The pending data is always available as one single
+ * contiguous view; consuming data from the head just moves an offset, and the
+ * storage is compacted only when more room is needed for new reads. */
+typedef struct _MMPortSerialBuffer MMPortSerialBuffer;
+
+MMPortSerialBuffer *mm_port_serial_buffer_new          (gsize size);
+void                mm_port_serial_buffer_free         (MMPortSerialBuffer *buffer);
+const guint8       *mm_port_serial_buffer_peek         (MMPortSerialBuffer *buffer,
+                                                        gsize *len);
+gsize               mm_port_serial_buffer_get_len      (MMPortSerialBuffer *buffer);
+guint8             *mm_port_serial_buffer_reserve      (MMPortSerialBuffer *buffer,
+                                                        gsize len);
+void                mm_port_serial_buffer_commit       (MMPortSerialBuffer *buffer,
+                                                        gsize len);
+void                mm_port_serial_buffer_append       (MMPortSerialBuffer *buffer,
+                                                        const guint8 *data,
+                                                        gsize len);
+void                mm_port_serial_buffer_consume      (MMPortSerialBuffer *buffer,
+                                                        gsize len);
+void                mm_port_serial_buffer_remove_range (MMPortSerialBuffer *buffer,
+                                                        gsize offset,
+                                                        gsize len);
+void                mm_port_serial_buffer_clear        (MMPortSerialBuffer *buffer);
+
+/* Length of the pending data already scanned by the unsolicited message
+ * parser, which doesn't need to be scanned again on the next read. The mark
+ * follows the contents when data is consumed or removed. */
+gsize               mm_port_serial_buffer_get_scanned  (MMPortSerialBuffer *buffer);
+void                mm_port_serial_buffer_set_scanned  (MMPortSerialBuffer *buffer,
+                                                        gsize scanned);
+
 struct _MMPortSerial {
     MMPort parent;
     MMPortSerialPrivate *priv;
@@ -61,9 +148,9 @@ struct _MMPortSerialClass {
 
     /* Called for subclasses to parse unsolicited responses.  If any recognized
      * unsolicited response is found, it should be removed from the 'response'
-     * byte array before returning.
+     * buffer before returning.
      */
-    void     (*parse_unsolicited) (MMPortSerial *self, GByteArray *response);
+    void     (*parse_unsolicited) (MMPortSerial *self, MMPortSerialBuffer *response);
 
     /*
      * Called to parse the device's response to a command or determine if the
@@ -78,14 +165,27 @@ struct _MMPortSerialClass {
      * If there is no response, @MM_PORT_SERIAL_RESPONSE_NONE will be returned,
      * and neither @error nor @parsed_response will be set.
      *
-     * The implementation is allowed to cleanup the @response byte array, e.g. to
-     * just remove 1 single response if more than one found.
+     * The implementation is allowed to cleanup the @response buffer, e.g. to
+     * just consume 1 single response if more than one found.
      */
     MMPortSerialResponseType (*parse_response) (MMPortSerial *self,
-                                                GByteArray *response,
+                                                MMPortSerialBuffer *response,
                                                 GByteArray **parsed_response,
                                                 GError **error);
 
+    /* Called to decide how the reply to a command may be cached. If
+     * @ttl_seconds is 0 the cached reply never expires; it is always dropped
+     * when any of the state changes in @invalidate_on happen. Sending the
+     * command itself triggers the state changes given in @invalidates.
+     * If not implemented, cached replies never expire and any state change
+     * invalidates them.
+     */
+    void     (*get_cache_policy)  (MMPortSerial *self,
+                                   const GByteArray *command,
+                                   guint *ttl_seconds,
+                                   MMPortSerialCacheInvalidation *invalidate_on,
+                                   MMPortSerialCacheInvalidation *invalidates);
+
     /* Called to configure the serial port fd after it's opened.  On error, should
      * return FALSE and set 'error' as appropriate.
      */
@@ -95,6 +195,14 @@ struct _MMPortSerialClass {
      * should get ignored. */
     void     (*config)            (MMPortSerial *self);
 
+    /* Called to get the key under which the statistics of a command are
+     * aggregated, e.g. the command name without arguments. If not
+     * implemented, the first byte of the command is used. */
+    void     (*get_stats_key)     (MMPortSerial *self,
+                                   const GByteArray *command,
+                                   gchar *key,
+                                   gsize key_size);
+
     void (*debug_log)             (MMPortSerial *self,
                                    const char *prefix,
                                    const char *buf,
@@ -104,6 +212,7 @@ struct _MMPortSerialClass {
     void (*buffer_full)           (MMPortSerial *port, const GByteArray *buffer);
     void (*timed_out)             (MMPortSerial *port, guint n_consecutive_replies);
     void (*forced_close)          (MMPortSerial *port);
+    void (*cache_invalidated)     (MMPortSerial *port, MMPortSerialCacheInvalidation what);
 };
 
 GType mm_port_serial_get_type (void);
@@ -145,6 +254,7 @@ void        mm_port_serial_command        (MMPortSerial *self,
                                            guint32 timeout_seconds,
                                            gboolean allow_cached,
                                            gboolean run_next,
+                                           MMPortSerialCommandPriority priority,
                                            GCancellable *cancellable,
                                            GAsyncReadyCallback callback,
                                            gpointer user_data);
@@ -152,6 +262,21 @@ GByteArray *mm_port_serial_command_finish (MMPortSerial *self,
                                            GAsyncResult *res,
                                            GError **error);
 
+void        mm_port_serial_get_lane_stats (MMPortSerial *self,
+                                           MMPortSerialCommandPriority priority,
+                                           MMPortSerialLaneStats *stats);
+
+void        mm_port_serial_foreach_command_stats      (MMPortSerial *self,
+                                                       MMPortSerialCommandStatsFunc callback,
+                                                       gpointer user_data);
+guint       mm_port_serial_get_n_consecutive_timeouts (MMPortSerial *self);
+
+void mm_port_serial_invalidate_cached_replies (MMPortSerial *self,
+                                               MMPortSerialCacheInvalidation what);
+void mm_port_serial_get_cache_stats           (MMPortSerial *self,
+                                               guint *hits,
+                                               guint *misses);
+
 gboolean mm_port_serial_set_flow_control (MMPortSerial   *self,
                                           MMFlowControl   flow_control,
                                           GError        **error);
@@ -0,0 +1,270 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "mm-probe-cache.h"
+#include "mm-log.h"
+
+/* Bump whenever the format of the stored results changes */
+#define PROBE_CACHE_VERSION 2
+
+#define PROBE_CACHE_GROUP_INFO  "probe-cache"
+#define PROBE_CACHE_KEY_VERSION "version"
+
+#define PROBE_CACHE_KEY_UPDATED "updated"
+#define PROBE_CACHE_KEY_PLUGIN  "plugin"
+#define PROBE_CACHE_KEY_TYPE    "type"
+#define PROBE_CACHE_KEY_VENDOR  "vendor"
+#define PROBE_CACHE_KEY_PRODUCT "product"
+#define PROBE_CACHE_KEY_ICERA   "icera"
+#define PROBE_CACHE_KEY_XMM     "xmm"
+
+static const gchar *port_type_names[] = {
+    [MM_PROBE_CACHE_PORT_TYPE_UNKNOWN] = NULL,
+    [MM_PROBE_CACHE_PORT_TYPE_AT]      = "at",
+    [MM_PROBE_CACHE_PORT_TYPE_QCDM]    = "qcdm",
+    [MM_PROBE_CACHE_PORT_TYPE_QMI]     = "qmi",
+    [MM_PROBE_CACHE_PORT_TYPE_MBIM]    = "mbim",
+};
+
+struct _MMProbeCache {
+    gchar    *path;
+    GKeyFile *key_file;
+};
+
+/*****************************************************************************/
+
+void
+mm_probe_cache_entry_clear (MMProbeCacheEntry *entry)
+{
+    g_free (entry->plugin);
+    g_free (entry->vendor);
+    g_free (entry->product);
+    memset (entry, 0, sizeof (MMProbeCacheEntry));
+}
+
+static MMProbeCachePortType
+port_type_from_string (const gchar *str)
+{
+    guint i;
+
+    for (i = MM_PROBE_CACHE_PORT_TYPE_AT; str && i < G_N_ELEMENTS (port_type_names); i++) {
+        if (g_str_equal (str, port_type_names[i]))
+            return (MMProbeCachePortType) i;
+    }
+    return MM_PROBE_CACHE_PORT_TYPE_UNKNOWN;
+}
+
+/*****************************************************************************/
+
+gchar *
+mm_probe_cache_build_key (guint16      vid,
+                          guint16      pid,
+                          guint16      revision,
+                          const gchar *interfaces,
+                          const gchar *interface_number,
+                          const gchar *subsystem)
+{
+    /* Only USB devices, where the vid/pid/revision identify the firmware, the
+     * list of interfaces identifies the composition, and the interface number
+     * identifies the port */
+    if (!vid || !pid || !interfaces || !interface_number || !subsystem)
+        return NULL;
+
+    return g_strdup_printf ("%04x:%04x:%04x:%s:%s:%s",
+                            vid, pid, revision,
+                            interfaces,
+                            interface_number,
+                            subsystem);
+}
+
+/*****************************************************************************/
+
+static void
+probe_cache_save (MMProbeCache *self)
+{
+    gchar  *data;
+    gsize   len;
+    gchar  *dir;
+    GError *error = NULL;
+
+    dir = g_path_get_dirname (self->path);
+    if (g_mkdir_with_parents (dir, 0755) < 0)
+        mm_warn ("couldn't create probe cache directory '%s': %s", dir, g_strerror (errno));
+    g_free (dir);
+
+    data = g_key_file_to_data (self->key_file, &len, NULL);
+    if (!g_file_set_contents (self->path, data, len, &error)) {
+        mm_warn ("couldn't write probe cache '%s': %s", self->path, error->message);
+        g_error_free (error);
+    }
+    g_free (data);
+}
+
+static void
+probe_cache_remove (MMProbeCache *self,
+                    const gchar  *key)
+{
+    if (!g_key_file_has_group (self->key_file, key))
+        return;
+
+    g_key_file_remove_group (self->key_file, key, NULL);
+    probe_cache_save (self);
+}
+
+/*****************************************************************************/
+
+gboolean
+mm_probe_cache_lookup (MMProbeCache      *self,
+                       const gchar       *key,
+                       gint64             now,
+                       MMProbeCacheEntry *entry)
+{
+    gchar                *str;
+    gint64                updated;
+    MMProbeCachePortType  type;
+
+    memset (entry, 0, sizeof (MMProbeCacheEntry));
+
+    if (!g_key_file_has_group (self->key_file, key))
+        return FALSE;
+
+    /* Entries from the future are as suspicious as the old ones */
+    updated = g_key_file_get_int64 (self->key_file, key, PROBE_CACHE_KEY_UPDATED, NULL);
+    if (updated > now || now - updated > MM_PROBE_CACHE_MAX_AGE_SEC) {
+        mm_dbg ("removing expired probe cache entry '%s'", key);
+        probe_cache_remove (self, key);
+        return FALSE;
+    }
+
+    str = g_key_file_get_string (self->key_file, key, PROBE_CACHE_KEY_TYPE, NULL);
+    type = port_type_from_string (str);
+    g_free (str);
+
+    entry->plugin = g_key_file_get_string (self->key_file, key, PROBE_CACHE_KEY_PLUGIN, NULL);
+    if (!entry->plugin || type == MM_PROBE_CACHE_PORT_TYPE_UNKNOWN) {
+        mm_dbg ("removing invalid probe cache entry '%s'", key);
+        mm_probe_cache_entry_clear (entry);
+        probe_cache_remove (self, key);
+        return FALSE;
+    }
+
+    entry->type = type;
+    if (type == MM_PROBE_CACHE_PORT_TYPE_AT) {
+        entry->vendor  = g_key_file_get_string  (self->key_file, key, PROBE_CACHE_KEY_VENDOR,  NULL);
+        entry->product = g_key_file_get_string  (self->key_file, key, PROBE_CACHE_KEY_PRODUCT, NULL);
+        entry->icera   = g_key_file_get_boolean (self->key_file, key, PROBE_CACHE_KEY_ICERA,   NULL);
+        entry->xmm     = g_key_file_get_boolean (self->key_file, key, PROBE_CACHE_KEY_XMM,     NULL);
+    }
+    return TRUE;
+}
+
+void
+mm_probe_cache_store (MMProbeCache            *self,
+                      const gchar             *key,
+                      gint64                   now,
+                      const MMProbeCacheEntry *entry)
+{
+    gchar  *previous;
+    gchar  *current;
+    gint64  updated;
+
+    /* Negative results are never stored */
+    if (!entry->plugin || entry->type == MM_PROBE_CACHE_PORT_TYPE_UNKNOWN) {
+        probe_cache_remove (self, key);
+        return;
+    }
+
+    previous = g_key_file_to_data (self->key_file, NULL, NULL);
+    updated = g_key_file_get_int64 (self->key_file, key, PROBE_CACHE_KEY_UPDATED, NULL);
+
+    /* Rebuild the whole group, so that no key of a previous entry is kept */
+    g_key_file_remove_group (self->key_file, key, NULL);
+    g_key_file_set_int64  (self->key_file, key, PROBE_CACHE_KEY_UPDATED, updated);
+    g_key_file_set_string (self->key_file, key, PROBE_CACHE_KEY_PLUGIN, entry->plugin);
+    g_key_file_set_string (self->key_file, key, PROBE_CACHE_KEY_TYPE,   port_type_names[entry->type]);
+    if (entry->type == MM_PROBE_CACHE_PORT_TYPE_AT) {
+        if (entry->vendor)
+            g_key_file_set_string (self->key_file, key, PROBE_CACHE_KEY_VENDOR, entry->vendor);
+        if (entry->product)
+            g_key_file_set_string (self->key_file, key, PROBE_CACHE_KEY_PRODUCT, entry->product);
+        if (entry->icera)
+            g_key_file_set_boolean (self->key_file, key, PROBE_CACHE_KEY_ICERA, TRUE);
+        if (entry->xmm)
+            g_key_file_set_boolean (self->key_file, key, PROBE_CACHE_KEY_XMM, TRUE);
+    }
+
+    /* Only refresh the timestamp (and write to disk) if the results changed,
+     * so that entries still expire even if always verified successfully */
+    current = g_key_file_to_data (self->key_file, NULL, NULL);
+    if (g_strcmp0 (previous, current) != 0) {
+        g_key_file_set_int64 (self->key_file, key, PROBE_CACHE_KEY_UPDATED, now);
+        probe_cache_save (self);
+    }
+
+    g_free (current);
+    g_free (previous);
+}
+
+void
+mm_probe_cache_invalidate (MMProbeCache *self,
+                           const gchar  *key)
+{
+    probe_cache_remove (self, key);
+}
+
+/*****************************************************************************/
+
+MMProbeCache *
+mm_probe_cache_new (const gchar *path)
+{
+    MMProbeCache *self;
+    GError       *error = NULL;
+
+    g_return_val_if_fail (path != NULL, NULL);
+
+    self = g_slice_new0 (MMProbeCache);
+    self->path = g_strdup (path);
+    self->key_file = g_key_file_new ();
+
+    if (!g_key_file_load_from_file (self->key_file, path, G_KEY_FILE_NONE, &error)) {
+        if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+            mm_warn ("couldn't load probe cache '%s': %s", path, error->message);
+        g_error_free (error);
+    } else if (g_key_file_get_integer (self->key_file, PROBE_CACHE_GROUP_INFO, PROBE_CACHE_KEY_VERSION, NULL) != PROBE_CACHE_VERSION) {
+        mm_dbg ("discarding probe cache '%s': unknown version", path);
+        g_key_file_free (self->key_file);
+        self->key_file = g_key_file_new ();
+    }
+
+    g_key_file_set_integer (self->key_file, PROBE_CACHE_GROUP_INFO, PROBE_CACHE_KEY_VERSION, PROBE_CACHE_VERSION);
+    return self;
+}
+
+void
+mm_probe_cache_free (MMProbeCache *self)
+{
+    if (!self)
+        return;
+
+    g_key_file_free (self->key_file);
+    g_free (self->path);
+    g_slice_free (MMProbeCache, self);
+}
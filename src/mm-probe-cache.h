@@ -0,0 +1,86 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#ifndef MM_PROBE_CACHE_H
+#define MM_PROBE_CACHE_H
+
+#include <glib.h>
+
+/* Persistent cache of port probing results.
+ *
+ * Results are keyed by the USB vid/pid/revision of the physical device, the
+ * list of interfaces it exposes (so that a different USB composition of the
+ * same device never matches), the interface number and the subsystem of the
+ * port.
+ *
+ * Only positive results are stored: the main type of the port and, for AT
+ * ports, what the port replied to the vendor/product/Icera/XMM probings.
+ * Anything else is always probed again. Entries expire after
+ * MM_PROBE_CACHE_MAX_AGE_SEC, and are expected to be verified with a quick
+ * probing of the main type before being trusted. */
+
+#define MM_PROBE_CACHE_MAX_AGE_SEC (30 * 24 * 60 * 60)
+
+typedef enum {
+    MM_PROBE_CACHE_PORT_TYPE_UNKNOWN,
+    MM_PROBE_CACHE_PORT_TYPE_AT,
+    MM_PROBE_CACHE_PORT_TYPE_QCDM,
+    MM_PROBE_CACHE_PORT_TYPE_QMI,
+    MM_PROBE_CACHE_PORT_TYPE_MBIM,
+} MMProbeCachePortType;
+
+typedef struct {
+    gchar                *plugin;
+    MMProbeCachePortType  type;
+    /* AT ports only */
+    gchar                *vendor;
+    gchar                *product;
+    gboolean              icera;
+    gboolean              xmm;
+} MMProbeCacheEntry;
+
+void          mm_probe_cache_entry_clear (MMProbeCacheEntry *entry);
+
+typedef struct _MMProbeCache MMProbeCache;
+
+MMProbeCache *mm_probe_cache_new        (const gchar  *path);
+void          mm_probe_cache_free       (MMProbeCache *self);
+
+/* Returns NULL if the port can't be identified */
+gchar        *mm_probe_cache_build_key  (guint16      vid,
+                                         guint16      pid,
+                                         guint16      revision,
+                                         const gchar *interfaces,
+                                         const gchar *interface_number,
+                                         const gchar *subsystem);
+
+/* Loads the entry stored for the key, if any and if not expired at 'now'
+ * (in seconds). Expired entries are removed. */
+gboolean      mm_probe_cache_lookup     (MMProbeCache      *self,
+                                         const gchar       *key,
+                                         gint64             now,
+                                         MMProbeCacheEntry *entry);
+
+/* Stores the entry, or removes the one stored for the key if the entry has no
+ * plugin or no known port type. */
+void          mm_probe_cache_store      (MMProbeCache            *self,
+                                         const gchar             *key,
+                                         gint64                   now,
+                                         const MMProbeCacheEntry *entry);
+
+void          mm_probe_cache_invalidate (MMProbeCache *self,
+                                         const gchar  *key);
+
+#endif /* MM_PROBE_CACHE_H */
@@ -0,0 +1,414 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include "mm-properties-batch.h"
+#include "mm-log.h"
+
+#define PROPERTIES_INTERFACE "org.freedesktop.DBus.Properties"
+#define PROPERTIES_CHANGED   "PropertiesChanged"
+
+typedef struct {
+    gchar        *path;
+    /* Merged PropertiesChanged signal */
+    gchar        *interface;
+    GHashTable   *changed;
+    GHashTable   *invalidated;
+    /* Held signal, if any */
+    GDBusMessage *message;
+} PendingEntry;
+
+struct _MMPropertiesBatch {
+    guint            window;
+    GMutex           mutex;
+
+    /* Pending entries, in order */
+    GQueue           queue;
+    /* Path and interface -> entry still accepting changes */
+    GHashTable      *mergeable;
+
+    /* A message is held, so the pending changes must be sent right away */
+    gboolean         flush_now;
+
+    GDBusConnection *connection;
+    guint            filter_id;
+    GMainContext    *context;
+    GSource         *flush_source;
+    /* Messages being sent by ourselves, not to be intercepted again */
+    GHashTable      *sending;
+
+    guint64          n_received;
+    guint64          n_emitted;
+};
+
+/*****************************************************************************/
+
+static void
+pending_entry_free (PendingEntry *entry)
+{
+    g_free (entry->path);
+    g_free (entry->interface);
+    if (entry->changed)
+        g_hash_table_unref (entry->changed);
+    if (entry->invalidated)
+        g_hash_table_unref (entry->invalidated);
+    if (entry->message)
+        g_object_unref (entry->message);
+    g_slice_free (PendingEntry, entry);
+}
+
+static GDBusMessage *
+pending_entry_build_signal (PendingEntry *entry)
+{
+    GDBusMessage    *message;
+    GVariantBuilder  changed;
+    GVariantBuilder  invalidated;
+    GHashTableIter   iter;
+    gpointer         name;
+    gpointer         value;
+
+    if (entry->message)
+        return g_object_ref (entry->message);
+
+    g_variant_builder_init (&changed, G_VARIANT_TYPE ("a{sv}"));
+    g_hash_table_iter_init (&iter, entry->changed);
+    while (g_hash_table_iter_next (&iter, &name, &value))
+        g_variant_builder_add (&changed, "{sv}", (const gchar *) name, (GVariant *) value);
+
+    g_variant_builder_init (&invalidated, G_VARIANT_TYPE ("as"));
+    g_hash_table_iter_init (&iter, entry->invalidated);
+    while (g_hash_table_iter_next (&iter, &name, NULL))
+        g_variant_builder_add (&invalidated, "s", (const gchar *) name);
+
+    message = g_dbus_message_new_signal (entry->path, PROPERTIES_INTERFACE, PROPERTIES_CHANGED);
+    g_dbus_message_set_body (message, g_variant_new ("(sa{sv}as)",
+                                                     entry->interface,
+                                                     &changed,
+                                                     &invalidated));
+    return message;
+}
+
+/*****************************************************************************/
+
+static gboolean
+add_held_message (MMPropertiesBatch *self,
+                  GDBusMessage      *message)
+{
+    PendingEntry *entry;
+    GDBusMessage *copy;
+    GError       *error = NULL;
+
+    if (g_queue_is_empty (&self->queue))
+        return FALSE;
+
+    /* The message may already be locked, so a copy is held */
+    copy = g_dbus_message_copy (message, &error);
+    if (!copy) {
+        mm_dbg ("Couldn't hold message: %s", error->message);
+        g_error_free (error);
+        return FALSE;
+    }
+
+    /* Changes notified after this message must not be merged into the ones
+     * notified before */
+    g_hash_table_remove_all (self->mergeable);
+
+    entry = g_slice_new0 (PendingEntry);
+    entry->path = g_strdup (g_dbus_message_get_path (message));
+    entry->message = copy;
+    g_queue_push_tail (&self->queue, entry);
+
+    /* A client may read any object right after getting a reply or a signal,
+     * e.g. the bearer after the reply to Simple.Connect, or the new object
+     * after InterfacesAdded, so nothing is kept waiting for the window */
+    self->flush_now = TRUE;
+    return TRUE;
+}
+
+static gboolean
+add_unlocked (MMPropertiesBatch *self,
+              GDBusMessage      *message)
+{
+    PendingEntry  *entry;
+    GVariant      *body;
+    GVariant      *changed;
+    const gchar  **invalidated;
+    const gchar   *path;
+    const gchar   *interface;
+    gchar         *key;
+    GVariantIter   iter;
+    gchar         *name;
+    GVariant      *value;
+    guint          i;
+
+    switch (g_dbus_message_get_message_type (message)) {
+    case G_DBUS_MESSAGE_TYPE_METHOD_RETURN:
+    case G_DBUS_MESSAGE_TYPE_ERROR:
+        /* Replies must not overtake any pending change */
+        return add_held_message (self, message);
+    case G_DBUS_MESSAGE_TYPE_SIGNAL:
+        break;
+    case G_DBUS_MESSAGE_TYPE_METHOD_CALL:
+    case G_DBUS_MESSAGE_TYPE_INVALID:
+    default:
+        return FALSE;
+    }
+
+    path = g_dbus_message_get_path (message);
+    body = g_dbus_message_get_body (message);
+    /* Only broadcast PropertiesChanged signals are merged, any other signal is
+     * held after the pending changes, whatever its object */
+    if (!path ||
+        g_dbus_message_get_destination (message) ||
+        g_strcmp0 (g_dbus_message_get_interface (message), PROPERTIES_INTERFACE) != 0 ||
+        g_strcmp0 (g_dbus_message_get_member (message), PROPERTIES_CHANGED) != 0 ||
+        !body ||
+        !g_variant_is_of_type (body, G_VARIANT_TYPE ("(sa{sv}as)")))
+        return add_held_message (self, message);
+
+    g_variant_get (body, "(&s@a{sv}^a&s)", &interface, &changed, &invalidated);
+
+    key = g_strdup_printf ("%s %s", path, interface);
+    entry = g_hash_table_lookup (self->mergeable, key);
+    if (!entry) {
+        entry = g_slice_new0 (PendingEntry);
+        entry->path = g_strdup (path);
+        entry->interface = g_strdup (interface);
+        entry->changed = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_variant_unref);
+        entry->invalidated = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+        g_queue_push_tail (&self->queue, entry);
+        g_hash_table_insert (self->mergeable, key, entry);
+    } else
+        g_free (key);
+
+    /* Last value wins; a property is either changed or invalidated */
+    g_variant_iter_init (&iter, changed);
+    while (g_variant_iter_next (&iter, "{sv}", &name, &value)) {
+        g_hash_table_remove (entry->invalidated, name);
+        g_hash_table_insert (entry->changed, name, value);
+    }
+    for (i = 0; invalidated[i]; i++) {
+        g_hash_table_remove (entry->changed, invalidated[i]);
+        g_hash_table_add (entry->invalidated, g_strdup (invalidated[i]));
+    }
+
+    g_variant_unref (changed);
+    g_free (invalidated);
+
+    self->n_received++;
+    return TRUE;
+}
+
+gboolean
+mm_properties_batch_add (MMPropertiesBatch *self,
+                         GDBusMessage      *message)
+{
+    gboolean added;
+
+    g_mutex_lock (&self->mutex);
+    added = add_unlocked (self, message);
+    g_mutex_unlock (&self->mutex);
+    return added;
+}
+
+/*****************************************************************************/
+
+GList *
+mm_properties_batch_take (MMPropertiesBatch *self)
+{
+    PendingEntry *entry;
+    GList        *signals = NULL;
+
+    g_mutex_lock (&self->mutex);
+    g_hash_table_remove_all (self->mergeable);
+    self->flush_now = FALSE;
+    while ((entry = g_queue_pop_head (&self->queue))) {
+        signals = g_list_prepend (signals, pending_entry_build_signal (entry));
+        if (!entry->message)
+            self->n_emitted++;
+        pending_entry_free (entry);
+    }
+    g_mutex_unlock (&self->mutex);
+
+    return g_list_reverse (signals);
+}
+
+void
+mm_properties_batch_flush (MMPropertiesBatch *self)
+{
+    GList *signals;
+    GList *l;
+
+    g_mutex_lock (&self->mutex);
+    if (self->flush_source) {
+        g_source_destroy (self->flush_source);
+        g_source_unref (self->flush_source);
+        self->flush_source = NULL;
+    }
+    g_mutex_unlock (&self->mutex);
+
+    signals = mm_properties_batch_take (self);
+    if (!self->connection) {
+        g_list_free_full (signals, g_object_unref);
+        return;
+    }
+
+    for (l = signals; l; l = g_list_next (l)) {
+        GDBusMessage *message = l->data;
+        GError       *error = NULL;
+
+        g_mutex_lock (&self->mutex);
+        g_hash_table_add (self->sending, message);
+        g_mutex_unlock (&self->mutex);
+
+        if (!g_dbus_connection_send_message (self->connection,
+                                             message,
+                                             G_DBUS_SEND_MESSAGE_FLAGS_NONE,
+                                             NULL,
+                                             &error)) {
+            mm_dbg ("Couldn't send batched signal in '%s': %s",
+                    g_dbus_message_get_path (message), error->message);
+            g_error_free (error);
+
+            g_mutex_lock (&self->mutex);
+            g_hash_table_remove (self->sending, message);
+            g_mutex_unlock (&self->mutex);
+        }
+    }
+    g_list_free_full (signals, g_object_unref);
+}
+
+static gboolean
+flush_cb (MMPropertiesBatch *self)
+{
+    mm_properties_batch_flush (self);
+    return G_SOURCE_REMOVE;
+}
+
+/*****************************************************************************/
+
+/* Runs in the GDBus worker thread */
+static GDBusMessage *
+filter_cb (GDBusConnection   *connection,
+           GDBusMessage      *message,
+           gboolean           incoming,
+           MMPropertiesBatch *self)
+{
+    gboolean added = FALSE;
+
+    if (incoming)
+        return message;
+
+    g_mutex_lock (&self->mutex);
+    if (!g_hash_table_remove (self->sending, message)) {
+        added = add_unlocked (self, message);
+        if (added && (!self->flush_source || self->flush_now)) {
+            if (self->flush_source) {
+                g_source_destroy (self->flush_source);
+                g_source_unref (self->flush_source);
+            }
+            self->flush_source = g_timeout_source_new (self->flush_now ? 0 : self->window);
+            g_source_set_callback (self->flush_source, (GSourceFunc) flush_cb, self, NULL);
+            g_source_attach (self->flush_source, self->context);
+            self->flush_now = FALSE;
+        }
+    }
+    g_mutex_unlock (&self->mutex);
+
+    if (!added)
+        return message;
+
+    /* Dropped, sent merged when flushing */
+    g_object_unref (message);
+    return NULL;
+}
+
+static void
+properties_batch_finalize (MMPropertiesBatch *self)
+{
+    if (self->flush_source) {
+        g_source_destroy (self->flush_source);
+        g_source_unref (self->flush_source);
+    }
+    g_queue_foreach (&self->queue, (GFunc) pending_entry_free, NULL);
+    g_queue_clear (&self->queue);
+    g_hash_table_unref (self->mergeable);
+    g_hash_table_unref (self->sending);
+    if (self->context)
+        g_main_context_unref (self->context);
+    if (self->connection)
+        g_object_unref (self->connection);
+    g_mutex_clear (&self->mutex);
+    g_slice_free (MMPropertiesBatch, self);
+}
+
+void
+mm_properties_batch_attach (MMPropertiesBatch *self,
+                            GDBusConnection   *connection)
+{
+    g_return_if_fail (self->connection == NULL);
+
+    self->connection = g_object_ref (connection);
+    self->context = g_main_context_ref_thread_default ();
+    /* The filter may still run after being removed, so the batch is only
+     * finalized when the filter is destroyed */
+    self->filter_id = g_dbus_connection_add_filter (connection,
+                                                    (GDBusMessageFilterFunction) filter_cb,
+                                                    self,
+                                                    (GDestroyNotify) properties_batch_finalize);
+}
+
+/*****************************************************************************/
+
+void
+mm_properties_batch_get_stats (MMPropertiesBatch *self,
+                               guint64           *n_received,
+                               guint64           *n_emitted)
+{
+    g_mutex_lock (&self->mutex);
+    if (n_received)
+        *n_received = self->n_received;
+    if (n_emitted)
+        *n_emitted = self->n_emitted;
+    g_mutex_unlock (&self->mutex);
+}
+
+/*****************************************************************************/
+
+MMPropertiesBatch *
+mm_properties_batch_new (guint window_ms)
+{
+    MMPropertiesBatch *self;
+
+    self = g_slice_new0 (MMPropertiesBatch);
+    self->window = window_ms;
+    g_mutex_init (&self->mutex);
+    g_queue_init (&self->queue);
+    self->mergeable = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    self->sending = g_hash_table_new (g_direct_hash, g_direct_equal);
+    return self;
+}
+
+void
+mm_properties_batch_free (MMPropertiesBatch *self)
+{
+    if (!self->connection) {
+        properties_batch_finalize (self);
+        return;
+    }
+
+    /* Send whatever is pending before going away */
+    mm_properties_batch_flush (self);
+    g_dbus_connection_remove_filter (self->connection, self->filter_id);
+}
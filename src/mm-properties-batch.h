@@ -0,0 +1,66 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#ifndef MM_PROPERTIES_BATCH_H
+#define MM_PROPERTIES_BATCH_H
+
+#include <glib.h>
+#include <gio/gio.h>
+
+/* Coalescing of the PropertiesChanged signals emitted by all the interface
+ * skeletons exported in a connection. The skeletons already merge the changes
+ * done within the same main loop iteration; the batch merges the signals sent
+ * within a time window, so that a burst of updates (e.g. signal quality,
+ * access technologies and registration state while enabling) ends up as a
+ * single signal per object and interface. Values are always up to date in the
+ * skeletons, only their notification is delayed.
+ *
+ * Any other signal (e.g. StateChanged, or InterfacesAdded in the object
+ * manager) and any method reply sent while there are pending changes is held
+ * after them, whatever its object, and the pending changes are sent right
+ * away. So a client never gets a reply or a signal before the changes done
+ * until then, e.g. the reply to Simple.Connect on the modem before the changes
+ * of the connected bearer. */
+
+#define MM_PROPERTIES_BATCH_DEFAULT_WINDOW_MS 100
+
+typedef struct _MMPropertiesBatch MMPropertiesBatch;
+
+MMPropertiesBatch *mm_properties_batch_new       (guint               window_ms);
+void               mm_properties_batch_free      (MMPropertiesBatch  *self);
+
+/* Intercepts the signals sent in the connection, and sends the merged ones
+ * from the current thread-default main context */
+void               mm_properties_batch_attach    (MMPropertiesBatch  *self,
+                                                  GDBusConnection    *connection);
+
+/* Returns TRUE if the message is taken into the batch: either a broadcast
+ * PropertiesChanged signal, which is merged with the pending ones, or any
+ * other signal or method reply sent while there are pending changes, which is
+ * held */
+gboolean           mm_properties_batch_add       (MMPropertiesBatch  *self,
+                                                  GDBusMessage       *message);
+/* Returns the pending changes as a list of PropertiesChanged signals, one per
+ * object and interface, in the order they were first changed, along with the
+ * held signals */
+GList             *mm_properties_batch_take      (MMPropertiesBatch  *self);
+/* Sends the pending changes right away */
+void               mm_properties_batch_flush     (MMPropertiesBatch  *self);
+
+void               mm_properties_batch_get_stats (MMPropertiesBatch  *self,
+                                                  guint64            *n_received,
+                                                  guint64            *n_emitted);
+
+#endif /* MM_PROPERTIES_BATCH_H */
@@ -0,0 +1,89 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <glib.h>
+
+#include "mm-regex.h"
+
+static GMutex      registry_mutex;
+static GHashTable *registry;
+
+static guint   n_compiled;
+static guint   n_reused;
+static gdouble compile_time;
+
+GRegex *
+mm_regex_get (const gchar         *pattern,
+              GRegexCompileFlags   compile_options,
+              GRegexMatchFlags     match_options,
+              GError             **error)
+{
+    gchar  *key;
+    GRegex *regex;
+
+    g_return_val_if_fail (pattern != NULL, NULL);
+
+    key = g_strdup_printf ("%x:%x:%s", (guint) compile_options, (guint) match_options, pattern);
+
+    g_mutex_lock (&registry_mutex);
+
+    if (G_UNLIKELY (!registry))
+        registry = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_regex_unref);
+
+    regex = g_hash_table_lookup (registry, key);
+    if (regex) {
+        n_reused++;
+        g_free (key);
+    } else {
+        GTimer *timer;
+
+        /* Compiled with the lock held, so that concurrent requests of the same
+         * pattern don't compile it twice */
+        timer = g_timer_new ();
+        regex = g_regex_new (pattern, compile_options, match_options, error);
+        compile_time += g_timer_elapsed (timer, NULL);
+        g_timer_destroy (timer);
+
+        if (!regex) {
+            g_mutex_unlock (&registry_mutex);
+            g_free (key);
+            return NULL;
+        }
+
+        n_compiled++;
+        g_hash_table_insert (registry, key, regex);
+    }
+
+    g_regex_ref (regex);
+
+    g_mutex_unlock (&registry_mutex);
+
+    return regex;
+}
+
+void
+mm_regex_get_stats (guint   *out_n_compiled,
+                    guint   *out_n_reused,
+                    gdouble *out_compile_time)
+{
+    g_mutex_lock (&registry_mutex);
+    if (out_n_compiled)
+        *out_n_compiled = n_compiled;
+    if (out_n_reused)
+        *out_n_reused = n_reused;
+    if (out_compile_time)
+        *out_compile_time = compile_time;
+    g_mutex_unlock (&registry_mutex);
+}
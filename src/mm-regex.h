@@ -0,0 +1,35 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#ifndef MM_REGEX_H
+#define MM_REGEX_H
+
+#include <glib.h>
+
+/* Process-wide registry of compiled regular expressions.
+ *
+ * Drop-in replacement for g_regex_new(): each pattern (with its compile and
+ * match options) is compiled only once, and every caller gets a new reference
+ * to the same immutable GRegex, to be released with g_regex_unref(). */
+GRegex *mm_regex_get       (const gchar         *pattern,
+                            GRegexCompileFlags   compile_options,
+                            GRegexMatchFlags     match_options,
+                            GError             **error);
+
+void    mm_regex_get_stats (guint               *n_compiled,
+                            guint               *n_reused,
+                            gdouble             *compile_time);
+
+#endif /* MM_REGEX_H */
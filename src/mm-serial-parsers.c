@@ -49,51 +49,272 @@ response_clean (GString *response)
     }
 }
 
+/*****************************************************************************/
+/* Final result code scanner
+ *
+ * The built-in result codes are matched without GRegex: the last line of the
+ * response is located once and compared against the known tail-anchored codes,
+ * and the few codes that are allowed anywhere in the response (CONNECT, ERROR,
+ * connection failures and NA) are looked for in a single walk over the line
+ * starts. No heap allocations are needed unless an error string must be
+ * reported.
+ */
+
+typedef enum {
+    RESULT_CODE_NONE,
+    /* Successful replies */
+    RESULT_CODE_OK,
+    RESULT_CODE_CONNECT,
+    RESULT_CODE_SMS_PROMPT,
+    /* Error replies */
+    RESULT_CODE_CME_ERROR,
+    RESULT_CODE_CMS_ERROR,
+    RESULT_CODE_CME_ERROR_STR,
+    RESULT_CODE_CMS_ERROR_STR,
+    RESULT_CODE_EZX_ERROR,
+    RESULT_CODE_UNKNOWN_ERROR,
+    RESULT_CODE_CONNECT_FAILED,
+    RESULT_CODE_NA,
+} ResultCode;
 
-static gboolean
-remove_eval_cb (const GMatchInfo *match_info,
-                GString *result,
-                gpointer user_data)
+typedef struct {
+    ResultCode code;
+    /* Where the response must be truncated to (RESULT_CODE_OK) */
+    gsize      truncate_len;
+    /* Numeric value (CME/CMS numeric errors, connection failures) */
+    guint      value;
+    /* Error string (CME/CMS string errors), not NUL-terminated */
+    const gchar *str;
+    gsize        str_len;
+} ResultCodeInfo;
+
+/* Line-start tokens which may be found anywhere in the response */
+#define LINE_TOKEN_CONNECT         (1 << 0)
+#define LINE_TOKEN_ERROR           (1 << 1)
+#define LINE_TOKEN_CONNECT_FAILED  (1 << 2)
+#define LINE_TOKEN_NA              (1 << 3)
+
+#define HAS_PREFIX(str, len, prefix)                                    \
+    ((len) >= (sizeof (prefix) - 1) && !memcmp ((str), (prefix), sizeof (prefix) - 1))
+#define HAS_SUFFIX(str, len, suffix)                                    \
+    ((len) >= (sizeof (suffix) - 1) &&                                  \
+     !memcmp ((str) + (len) - (sizeof (suffix) - 1), (suffix), sizeof (suffix) - 1))
+
+static inline gboolean
+is_space (gchar c)
 {
-    int *result_len = (int *) user_data;
-    int start;
-    int end;
+    /* Same set as the PCRE \s class */
+    return (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v');
+}
 
-    if (g_match_info_fetch_pos  (match_info, 0, &start, &end))
-        *result_len -= (end - start);
+/* Returns a mask of the line tokens found in the response, looking only at the
+ * positions right after each <CR><LF>. The first connection failure found is
+ * reported in @connection_error. */
+static guint
+scan_line_tokens (const gchar *str,
+                  gsize        len,
+                  guint       *connection_error)
+{
+    const gchar *p;
+    const gchar *end;
+    guint        found = 0;
+
+    end = str + len;
+    for (p = str; p < end && (p = memchr (p, '\n', end - p)) != NULL; p++) {
+        const gchar *line;
+        gsize        line_len;
+
+        if (p == str || *(p - 1) != '\r')
+            continue;
+
+        line = p + 1;
+        line_len = end - line;
+        if (!line_len)
+            break;
+
+        switch (line[0]) {
+        case 'C':
+            /* CONNECT needs a complete line: anything but <LF> until <CR><LF> */
+            if (!(found & LINE_TOKEN_CONNECT) && HAS_PREFIX (line, line_len, "CONNECT")) {
+                const gchar *eol;
+
+                eol = memchr (line, '\n', line_len);
+                if (eol && eol >= line + 8 && *(eol - 1) == '\r')
+                    found |= LINE_TOKEN_CONNECT;
+            }
+            break;
+        case 'E':
+            if (HAS_PREFIX (line, line_len, "ERROR"))
+                found |= LINE_TOKEN_ERROR;
+            break;
+        case 'B':
+            if (!(found & LINE_TOKEN_CONNECT_FAILED) && HAS_PREFIX (line, line_len, "BUSY")) {
+                found |= LINE_TOKEN_CONNECT_FAILED;
+                *connection_error = MM_CONNECTION_ERROR_BUSY;
+            }
+            break;
+        case 'N':
+            if (!(found & LINE_TOKEN_CONNECT_FAILED) && HAS_PREFIX (line, line_len, "NO CARRIER")) {
+                found |= LINE_TOKEN_CONNECT_FAILED;
+                *connection_error = MM_CONNECTION_ERROR_NO_CARRIER;
+            } else if (!(found & LINE_TOKEN_CONNECT_FAILED) && HAS_PREFIX (line, line_len, "NO ANSWER")) {
+                found |= LINE_TOKEN_CONNECT_FAILED;
+                *connection_error = MM_CONNECTION_ERROR_NO_ANSWER;
+            } else if (HAS_PREFIX (line, line_len, "NA\r\n"))
+                found |= LINE_TOKEN_NA;
+            break;
+        default:
+            break;
+        }
+    }
 
-    return TRUE;
+    return found;
 }
 
-static void
-remove_matches (GRegex *r, GString *string)
+/* Parses '<prefix>:\s*<value><CR><LF>' in the last line of the response */
+static ResultCode
+scan_error_line (const gchar    *line,
+                 gsize           line_len,
+                 gsize           prefix_len,
+                 ResultCode      numeric_code,
+                 ResultCode      string_code,
+                 ResultCodeInfo *info)
 {
-    char *str;
-    int result_len = string->len;
+    const gchar *value;
+    gsize        value_len;
+    gsize        i;
+    gboolean     numeric;
+    guint        n = 0;
+
+    value = line + prefix_len;
+    value_len = line_len - prefix_len;
+    while (value_len > 0 && is_space (*value)) {
+        value++;
+        value_len--;
+    }
 
-    str = g_regex_replace_eval (r, string->str, string->len, 0, 0,
-                                remove_eval_cb, &result_len, NULL);
+    numeric = (value_len > 0);
+    for (i = 0; numeric && i < value_len; i++) {
+        if (!g_ascii_isdigit (value[i]))
+            numeric = FALSE;
+        else if (n < G_MAXUINT / 10)
+            n = (n * 10) + (value[i] - '0');
+    }
 
-    g_string_truncate (string, 0);
-    g_string_append_len (string, str, result_len);
-    g_free (str);
+    if (numeric) {
+        info->value = n;
+        return numeric_code;
+    }
+
+    if (string_code == RESULT_CODE_NONE)
+        return RESULT_CODE_NONE;
+
+    /* At least one character is needed in the string; if the leading
+     * whitespace took everything, give back the last one as the regex would */
+    if (!value_len) {
+        if (value == line + prefix_len)
+            return RESULT_CODE_NONE;
+        value--;
+        value_len++;
+    }
+
+    info->str = value;
+    info->str_len = value_len;
+    return string_code;
 }
 
+static ResultCode
+scan_result_code (const gchar    *str,
+                  gsize           len,
+                  ResultCodeInfo *info)
+{
+    const gchar *line = NULL;
+    gsize        line_len = 0;
+    gsize        stripped_len;
+    guint        tokens;
+    guint        connection_error = 0;
+
+    memset (info, 0, sizeof (ResultCodeInfo));
+
+    /* OK: '<CR><LF>OK' followed by one or more '<CR><LF>' at the end */
+    stripped_len = len;
+    while (HAS_SUFFIX (str, stripped_len, "\r\n"))
+        stripped_len -= 2;
+    if (stripped_len < len && HAS_SUFFIX (str, stripped_len, "\r\nOK")) {
+        info->truncate_len = stripped_len - 4;
+        return (info->code = RESULT_CODE_OK);
+    }
+
+    tokens = scan_line_tokens (str, len, &connection_error);
+
+    /* CONNECT, anywhere in the response */
+    if (tokens & LINE_TOKEN_CONNECT)
+        return (info->code = RESULT_CODE_CONNECT);
+
+    /* SMS prompt: '<CR><LF>>' followed by optional whitespace at the end */
+    stripped_len = len;
+    while (stripped_len > 0 && is_space (str[stripped_len - 1]))
+        stripped_len--;
+    if (HAS_SUFFIX (str, stripped_len, "\r\n>"))
+        return (info->code = RESULT_CODE_SMS_PROMPT);
+
+    /* Locate the last full line: '<CR><LF><line><CR><LF>' at the end, with no
+     * other <CR> or <LF> within the line */
+    if (len > 4 && HAS_SUFFIX (str, len, "\r\n")) {
+        const gchar *p;
+
+        line_len = 0;
+        for (p = str + len - 3; p >= str && *p != '\r' && *p != '\n'; p--)
+            line_len++;
+        if (p > str && *p == '\n' && *(p - 1) == '\r')
+            line = p + 1;
+    }
+
+    if (line && line_len > 0) {
+        ResultCode code = RESULT_CODE_NONE;
+
+        switch (line[0]) {
+        case '+':
+            if (HAS_PREFIX (line, line_len, "+CME ERROR:"))
+                code = scan_error_line (line, line_len, 11, RESULT_CODE_CME_ERROR, RESULT_CODE_CME_ERROR_STR, info);
+            else if (HAS_PREFIX (line, line_len, "+CMS ERROR:"))
+                code = scan_error_line (line, line_len, 11, RESULT_CODE_CMS_ERROR, RESULT_CODE_CMS_ERROR_STR, info);
+            break;
+        case 'M':
+            /* Motorola EZX errors */
+            if (HAS_PREFIX (line, line_len, "MODEM ERROR:"))
+                code = scan_error_line (line, line_len, 12, RESULT_CODE_EZX_ERROR, RESULT_CODE_NONE, info);
+            break;
+        default:
+            break;
+        }
+
+        if (code != RESULT_CODE_NONE)
+            return (info->code = code);
+    }
+
+    /* Last resort; unknown error */
+    if ((tokens & LINE_TOKEN_ERROR) || HAS_SUFFIX (str, len, "COMMAND NOT SUPPORT\r\n"))
+        return (info->code = RESULT_CODE_UNKNOWN_ERROR);
+
+    /* Connection failures */
+    if (tokens & LINE_TOKEN_CONNECT_FAILED)
+        info->value = connection_error;
+    else if (HAS_SUFFIX (str, len, "NO DIALTONE\r\n"))
+        info->value = MM_CONNECTION_ERROR_NO_DIALTONE;
+    else if (tokens & LINE_TOKEN_NA)
+        return (info->code = RESULT_CODE_NA);
+    else
+        return RESULT_CODE_NONE;
+
+    return (info->code = RESULT_CODE_CONNECT_FAILED);
+}
+
+/*****************************************************************************/
+
 typedef struct {
-    /* Regular expressions for successful replies */
-    GRegex *regex_ok;
-    GRegex *regex_connect;
-    GRegex *regex_sms;
+    /* Custom regular expressions for successful and error replies */
     GRegex *regex_custom_successful;
-    /* Regular expressions for error replies */
-    GRegex *regex_cme_error;
-    GRegex *regex_cms_error;
-    GRegex *regex_cme_error_str;
-    GRegex *regex_cms_error_str;
-    GRegex *regex_ezx_error;
-    GRegex *regex_unknown_error;
-    GRegex *regex_connect_failed;
-    GRegex *regex_na;
     GRegex *regex_custom_error;
     /* User-provided parser filter */
     mm_serial_parser_v1_filter_fn filter_callback;
@@ -104,23 +325,8 @@ gpointer
 mm_serial_parser_v1_new (void)
 {
     MMSerialParserV1 *parser;
-    GRegexCompileFlags flags = G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW | G_REGEX_OPTIMIZE;
 
     parser = g_slice_new (MMSerialParserV1);
-
-    parser->regex_ok = g_regex_new ("\\r\\nOK(\\r\\n)+$", flags, 0, NULL);
-    parser->regex_connect = g_regex_new ("\\r\\nCONNECT.*\\r\\n", flags, 0, NULL);
-    parser->regex_sms = g_regex_new ("\\r\\n>\\s*$", flags, 0, NULL);
-    parser->regex_cme_error = g_regex_new ("\\r\\n\\+CME ERROR:\\s*(\\d+)\\r\\n$", flags, 0, NULL);
-    parser->regex_cms_error = g_regex_new ("\\r\\n\\+CMS ERROR:\\s*(\\d+)\\r\\n$", flags, 0, NULL);
-    parser->regex_cme_error_str = g_regex_new ("\\r\\n\\+CME ERROR:\\s*([^\\n\\r]+)\\r\\n$", flags, 0, NULL);
-    parser->regex_cms_error_str = g_regex_new ("\\r\\n\\+CMS ERROR:\\s*([^\\n\\r]+)\\r\\n$", flags, 0, NULL);
-    parser->regex_ezx_error = g_regex_new ("\\r\\n\\MODEM ERROR:\\s*(\\d+)\\r\\n$", flags, 0, NULL);
-    parser->regex_unknown_error = g_regex_new ("\\r\\n(ERROR)|(COMMAND NOT SUPPORT)\\r\\n$", flags, 0, NULL);
-    parser->regex_connect_failed = g_regex_new ("\\r\\n(NO CARRIER)|(BUSY)|(NO ANSWER)|(NO DIALTONE)\\r\\n$", flags, 0, NULL);
-    /* Samsung Z810 may reply "NA" to report a not-available error */
-    parser->regex_na = g_regex_new ("\\r\\nNA\\r\\n", flags, 0, NULL);
-
     parser->regex_custom_successful = NULL;
     parser->regex_custom_error = NULL;
     parser->filter_callback = NULL;
@@ -166,8 +372,9 @@ mm_serial_parser_v1_parse (gpointer data,
                            GError **error)
 {
     MMSerialParserV1 *parser = (MMSerialParserV1 *) data;
-    GMatchInfo *match_info;
+    GMatchInfo *match_info = NULL;
     GError *local_error = NULL;
+    ResultCodeInfo info;
     gboolean found = FALSE;
     char *str = NULL;
 
@@ -201,31 +408,23 @@ mm_serial_parser_v1_parse (gpointer data,
         found = g_regex_match_full (parser->regex_custom_successful,
                                     response->str, response->len,
                                     0, 0, NULL, NULL);
+        if (found) {
+            response_clean (response);
+            return TRUE;
+        }
     }
 
-    if (!found) {
-        found = g_regex_match_full (parser->regex_ok,
-                                    response->str, response->len,
-                                    0, 0, NULL, NULL);
-        if (found)
-            remove_matches (parser->regex_ok, response);
-    }
-
-    if (!found) {
-        found = g_regex_match_full (parser->regex_connect,
-                                    response->str, response->len,
-                                    0, 0, NULL, NULL);
-    }
-
-    if (!found) {
-        found = g_regex_match_full (parser->regex_sms,
-                                    response->str, response->len,
-                                    0, 0, NULL, NULL);
-    }
-
-    if (found) {
+    /* Single scan for all the built-in result codes */
+    switch (scan_result_code (response->str, response->len, &info)) {
+    case RESULT_CODE_OK:
+        g_string_truncate (response, info.truncate_len);
+        /* fall through */
+    case RESULT_CODE_CONNECT:
+    case RESULT_CODE_SMS_PROMPT:
         response_clean (response);
         return TRUE;
+    default:
+        break;
     }
 
     /* Now failures */
@@ -241,122 +440,46 @@ mm_serial_parser_v1_parse (gpointer data,
             local_error = mm_mobile_equipment_error_for_code (atoi (str));
             goto done;
         }
-        g_match_info_free (match_info);
     }
 
-    /* Numeric CME errors */
-    found = g_regex_match_full (parser->regex_cme_error,
-                                response->str, response->len,
-                                0, 0, &match_info, NULL);
-    if (found) {
-        str = g_match_info_fetch (match_info, 1);
-        g_assert (str);
-        local_error = mm_mobile_equipment_error_for_code (atoi (str));
-        goto done;
-    }
-    g_match_info_free (match_info);
-
-    /* Numeric CMS errors */
-    found = g_regex_match_full (parser->regex_cms_error,
-                                response->str, response->len,
-                                0, 0, &match_info, NULL);
-    if (found) {
-        str = g_match_info_fetch (match_info, 1);
-        g_assert (str);
-        local_error = mm_message_error_for_code (atoi (str));
-        goto done;
-    }
-    g_match_info_free (match_info);
-
-    /* String CME errors */
-    found = g_regex_match_full (parser->regex_cme_error_str,
-                                response->str, response->len,
-                                0, 0, &match_info, NULL);
-    if (found) {
-        str = g_match_info_fetch (match_info, 1);
-        g_assert (str);
+    found = TRUE;
+    switch (info.code) {
+    case RESULT_CODE_CME_ERROR:
+        local_error = mm_mobile_equipment_error_for_code (info.value);
+        break;
+    case RESULT_CODE_CMS_ERROR:
+        local_error = mm_message_error_for_code (info.value);
+        break;
+    case RESULT_CODE_CME_ERROR_STR:
+        str = g_strndup (info.str, info.str_len);
         local_error = mm_mobile_equipment_error_for_string (str);
-        goto done;
-    }
-    g_match_info_free (match_info);
-
-    /* String CMS errors */
-    found = g_regex_match_full (parser->regex_cms_error_str,
-                                response->str, response->len,
-                                0, 0, &match_info, NULL);
-    if (found) {
-        str = g_match_info_fetch (match_info, 1);
-        g_assert (str);
+        break;
+    case RESULT_CODE_CMS_ERROR_STR:
+        str = g_strndup (info.str, info.str_len);
         local_error = mm_message_error_for_string (str);
-        goto done;
-    }
-    g_match_info_free (match_info);
-
-    /* Motorola EZX errors */
-    found = g_regex_match_full (parser->regex_ezx_error,
-                                response->str, response->len,
-                                0, 0, &match_info, NULL);
-    if (found) {
-        str = g_match_info_fetch (match_info, 1);
-        g_assert (str);
-        local_error = mm_mobile_equipment_error_for_code (MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN);
-        goto done;
-    }
-    g_match_info_free (match_info);
-
-    /* Last resort; unknown error */
-    found = g_regex_match_full (parser->regex_unknown_error,
-                                response->str, response->len,
-                                0, 0, &match_info, NULL);
-    if (found) {
+        break;
+    case RESULT_CODE_EZX_ERROR:
+    case RESULT_CODE_UNKNOWN_ERROR:
         local_error = mm_mobile_equipment_error_for_code (MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN);
-        goto done;
-    }
-    g_match_info_free (match_info);
-
-    /* Connection failures */
-    found = g_regex_match_full (parser->regex_connect_failed,
-                                response->str, response->len,
-                                0, 0, &match_info, NULL);
-    if (found) {
-        MMConnectionError code;
-
-        str = g_match_info_fetch (match_info, 1);
-        g_assert (str);
-
-        if (!strcmp (str, "NO CARRIER"))
-            code = MM_CONNECTION_ERROR_NO_CARRIER;
-        else if (!strcmp (str, "BUSY"))
-            code = MM_CONNECTION_ERROR_BUSY;
-        else if (!strcmp (str, "NO ANSWER"))
-            code = MM_CONNECTION_ERROR_NO_ANSWER;
-        else if (!strcmp (str, "NO DIALTONE"))
-            code = MM_CONNECTION_ERROR_NO_DIALTONE;
-        else {
-            /* uhm... make something up (yes, ok, lie!). */
-            code = MM_CONNECTION_ERROR_NO_CARRIER;
-        }
-
-        local_error = mm_connection_error_for_code (code);
-        goto done;
-    }
-    g_match_info_free (match_info);
-
-    /* NA error */
-    found = g_regex_match_full (parser->regex_na,
-                                response->str, response->len,
-                                0, 0, &match_info, NULL);
-    if (found) {
+        break;
+    case RESULT_CODE_CONNECT_FAILED:
+        local_error = mm_connection_error_for_code ((MMConnectionError) info.value);
+        break;
+    case RESULT_CODE_NA:
         /* Assume NA means 'Not Allowed' :) */
         local_error = g_error_new (MM_MOBILE_EQUIPMENT_ERROR,
                                    MM_MOBILE_EQUIPMENT_ERROR_NOT_ALLOWED,
                                    "Not Allowed");
-        goto done;
+        break;
+    default:
+        found = FALSE;
+        break;
     }
 
 done:
     g_free (str);
-    g_match_info_free (match_info);
+    if (match_info)
+        g_match_info_free (match_info);
     if (found)
         response_clean (response);
 
@@ -385,18 +508,6 @@ mm_serial_parser_v1_destroy (gpointer data)
 
     g_return_if_fail (parser != NULL);
 
-    g_regex_unref (parser->regex_ok);
-    g_regex_unref (parser->regex_connect);
-    g_regex_unref (parser->regex_sms);
-    g_regex_unref (parser->regex_cme_error);
-    g_regex_unref (parser->regex_cms_error);
-    g_regex_unref (parser->regex_cme_error_str);
-    g_regex_unref (parser->regex_cms_error_str);
-    g_regex_unref (parser->regex_ezx_error);
-    g_regex_unref (parser->regex_unknown_error);
-    g_regex_unref (parser->regex_connect_failed);
-    g_regex_unref (parser->regex_na);
-
     if (parser->regex_custom_successful)
         g_regex_unref (parser->regex_custom_successful);
     if (parser->regex_custom_error)
@@ -0,0 +1,276 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include "mm-sms-index.h"
+
+typedef struct {
+    MMSmsStorage storage;
+    guint        index;
+} PartKey;
+
+typedef struct {
+    /* PartKey in 'parts' */
+    GPtrArray *parts;
+    /* "reference/number" keys in 'multiparts' */
+    GPtrArray *multiparts;
+} ItemEntry;
+
+struct _MMSmsIndex {
+    /* PartKey -> item */
+    GHashTable *parts;
+    /* "reference/number" -> GSList of items */
+    GHashTable *multiparts;
+    /* item -> ItemEntry, so that all keys of an item can be removed without
+     * walking the whole index */
+    GHashTable *items;
+};
+
+/* Keys are usually short (e.g. "42/+34600000000"), so avoid allocating them
+ * on lookups */
+#define KEY_BUFFER_SIZE 48
+
+/*****************************************************************************/
+
+static guint
+part_key_hash (const PartKey *key)
+{
+    return (key->index * 31) + (guint) key->storage;
+}
+
+static gboolean
+part_key_equal (const PartKey *a,
+                const PartKey *b)
+{
+    return (a->index == b->index && a->storage == b->storage);
+}
+
+static void
+part_key_free (PartKey *key)
+{
+    g_slice_free (PartKey, key);
+}
+
+static const gchar *
+build_multipart_key (gchar        *buffer,
+                     guint         reference,
+                     const gchar  *number,
+                     gchar       **allocated)
+{
+    *allocated = NULL;
+    if (!number)
+        number = "";
+
+    if (g_snprintf (buffer, KEY_BUFFER_SIZE, "%u/%s", reference, number) < KEY_BUFFER_SIZE)
+        return buffer;
+
+    *allocated = g_strdup_printf ("%u/%s", reference, number);
+    return *allocated;
+}
+
+static void
+item_entry_free (ItemEntry *entry)
+{
+    g_ptr_array_unref (entry->parts);
+    g_ptr_array_unref (entry->multiparts);
+    g_slice_free (ItemEntry, entry);
+}
+
+static ItemEntry *
+item_entry_get (MMSmsIndex *self,
+                gpointer    item)
+{
+    ItemEntry *entry;
+
+    entry = g_hash_table_lookup (self->items, item);
+    if (!entry) {
+        entry = g_slice_new (ItemEntry);
+        entry->parts = g_ptr_array_new ();
+        entry->multiparts = g_ptr_array_new ();
+        g_hash_table_insert (self->items, item, entry);
+    }
+    return entry;
+}
+
+/*****************************************************************************/
+
+void
+mm_sms_index_add_part (MMSmsIndex   *self,
+                       MMSmsStorage  storage,
+                       guint         index,
+                       gpointer      item)
+{
+    PartKey   key;
+    gpointer  stored_key;
+    gpointer  previous;
+    PartKey  *new_key;
+
+    g_return_if_fail (item != NULL);
+
+    key.storage = storage;
+    key.index = index;
+
+    if (g_hash_table_lookup_extended (self->parts, &key, &stored_key, &previous)) {
+        ItemEntry *previous_entry;
+
+        if (previous == item)
+            return;
+
+        /* Moving the part to a different item; the already stored key is
+         * kept, the new one is freed */
+        previous_entry = g_hash_table_lookup (self->items, previous);
+        if (previous_entry)
+            g_ptr_array_remove_fast (previous_entry->parts, stored_key);
+        new_key = g_slice_dup (PartKey, &key);
+        g_hash_table_insert (self->parts, new_key, item);
+    } else {
+        stored_key = g_slice_dup (PartKey, &key);
+        g_hash_table_insert (self->parts, stored_key, item);
+    }
+
+    g_ptr_array_add (item_entry_get (self, item)->parts, stored_key);
+}
+
+gpointer
+mm_sms_index_lookup_part (MMSmsIndex   *self,
+                          MMSmsStorage  storage,
+                          guint         index)
+{
+    PartKey key;
+
+    key.storage = storage;
+    key.index = index;
+    return g_hash_table_lookup (self->parts, &key);
+}
+
+guint
+mm_sms_index_get_n_parts (MMSmsIndex *self)
+{
+    return g_hash_table_size (self->parts);
+}
+
+/*****************************************************************************/
+
+void
+mm_sms_index_add_multipart (MMSmsIndex  *self,
+                            guint        reference,
+                            const gchar *number,
+                            gpointer     item)
+{
+    gchar        buffer[KEY_BUFFER_SIZE];
+    gchar       *allocated;
+    const gchar *key;
+    gpointer     stored_key;
+    gpointer     items;
+
+    g_return_if_fail (item != NULL);
+
+    key = build_multipart_key (buffer, reference, number, &allocated);
+
+    if (g_hash_table_lookup_extended (self->multiparts, key, &stored_key, &items)) {
+        g_free (allocated);
+        if (g_slist_find (items, item))
+            return;
+        /* Steal and re-insert, so that the stored key is kept */
+        g_hash_table_steal (self->multiparts, stored_key);
+        g_hash_table_insert (self->multiparts, stored_key, g_slist_prepend (items, item));
+    } else {
+        stored_key = allocated ? allocated : g_strdup (key);
+        g_hash_table_insert (self->multiparts, stored_key, g_slist_prepend (NULL, item));
+    }
+
+    g_ptr_array_add (item_entry_get (self, item)->multiparts, stored_key);
+}
+
+const GSList *
+mm_sms_index_lookup_multipart (MMSmsIndex  *self,
+                               guint        reference,
+                               const gchar *number)
+{
+    gchar         buffer[KEY_BUFFER_SIZE];
+    gchar        *allocated;
+    const gchar  *key;
+    const GSList *items;
+
+    key = build_multipart_key (buffer, reference, number, &allocated);
+    items = g_hash_table_lookup (self->multiparts, key);
+    g_free (allocated);
+    return items;
+}
+
+/*****************************************************************************/
+
+void
+mm_sms_index_remove_item (MMSmsIndex *self,
+                          gpointer    item)
+{
+    ItemEntry *entry;
+    guint      i;
+
+    entry = g_hash_table_lookup (self->items, item);
+    if (!entry)
+        return;
+
+    g_hash_table_steal (self->items, item);
+
+    for (i = 0; i < entry->parts->len; i++)
+        g_hash_table_remove (self->parts, g_ptr_array_index (entry->parts, i));
+
+    for (i = 0; i < entry->multiparts->len; i++) {
+        gpointer  stored_key;
+        GSList   *items;
+
+        stored_key = g_ptr_array_index (entry->multiparts, i);
+        items = g_hash_table_lookup (self->multiparts, stored_key);
+        g_hash_table_steal (self->multiparts, stored_key);
+        items = g_slist_remove (items, item);
+        /* The key is only freed once no other item holds it */
+        if (items)
+            g_hash_table_insert (self->multiparts, stored_key, items);
+        else
+            g_free (stored_key);
+    }
+
+    item_entry_free (entry);
+}
+
+/*****************************************************************************/
+
+MMSmsIndex *
+mm_sms_index_new (void)
+{
+    MMSmsIndex *self;
+
+    self = g_slice_new (MMSmsIndex);
+    self->parts = g_hash_table_new_full ((GHashFunc) part_key_hash,
+                                         (GEqualFunc) part_key_equal,
+                                         (GDestroyNotify) part_key_free,
+                                         NULL);
+    self->multiparts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_slist_free);
+    self->items = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) item_entry_free);
+    return self;
+}
+
+void
+mm_sms_index_free (MMSmsIndex *self)
+{
+    if (!self)
+        return;
+
+    /* Item entries point to keys in the other tables */
+    g_hash_table_destroy (self->items);
+    g_hash_table_destroy (self->multiparts);
+    g_hash_table_destroy (self->parts);
+    g_slice_free (MMSmsIndex, self);
+}
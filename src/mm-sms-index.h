@@ -0,0 +1,56 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#ifndef MM_SMS_INDEX_H
+#define MM_SMS_INDEX_H
+
+#include <glib.h>
+
+#include <ModemManager.h>
+
+/* Index of SMS parts (by storage and part index) and of multipart messages
+ * (by concatenation reference and number) to the object holding them, e.g.
+ * the MMBaseSms. Items are not referenced. */
+typedef struct _MMSmsIndex MMSmsIndex;
+
+MMSmsIndex   *mm_sms_index_new              (void);
+void          mm_sms_index_free             (MMSmsIndex   *self);
+
+/* A part index may only be held by one item; adding it again moves it */
+void          mm_sms_index_add_part         (MMSmsIndex   *self,
+                                             MMSmsStorage  storage,
+                                             guint         index,
+                                             gpointer      item);
+gpointer      mm_sms_index_lookup_part      (MMSmsIndex   *self,
+                                             MMSmsStorage  storage,
+                                             guint         index);
+
+/* Several items may share the same reference and number, so the lookup
+ * returns all of them, the last added first */
+void          mm_sms_index_add_multipart    (MMSmsIndex   *self,
+                                             guint         reference,
+                                             const gchar  *number,
+                                             gpointer      item);
+const GSList *mm_sms_index_lookup_multipart (MMSmsIndex   *self,
+                                             guint         reference,
+                                             const gchar  *number);
+
+/* Removes all the part indices and multipart keys held by the item */
+void          mm_sms_index_remove_item      (MMSmsIndex   *self,
+                                             gpointer      item);
+
+guint         mm_sms_index_get_n_parts      (MMSmsIndex   *self);
+
+#endif /* MM_SMS_INDEX_H */
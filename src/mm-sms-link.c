@@ -0,0 +1,43 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include "mm-sms-link.h"
+
+MMSmsLinkMode
+mm_sms_link_hold (MMSmsLink *self,
+                  gboolean   until_released)
+{
+    MMSmsLinkMode mode = MM_SMS_LINK_MODE_NONE;
+
+    if (!until_released) {
+        /* Already held for longer */
+        if (!self->holds)
+            mode = MM_SMS_LINK_MODE_TEMPORARY;
+    } else if (self->holds++ == 0)
+        mode = MM_SMS_LINK_MODE_ENABLED;
+
+    return (self->unsupported ? MM_SMS_LINK_MODE_NONE : mode);
+}
+
+MMSmsLinkMode
+mm_sms_link_release (MMSmsLink *self)
+{
+    g_return_val_if_fail (self->holds > 0, MM_SMS_LINK_MODE_NONE);
+
+    if (--self->holds > 0 || self->unsupported)
+        return MM_SMS_LINK_MODE_NONE;
+
+    return MM_SMS_LINK_MODE_DISABLED;
+}
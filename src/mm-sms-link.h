@@ -0,0 +1,43 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#ifndef MM_SMS_LINK_H
+#define MM_SMS_LINK_H
+
+#include <glib.h>
+
+/* Accounting of the users holding the SMS relay link open (AT+CMMS). The
+ * link is either held until the next message is sent, or until released by
+ * every user which held it; each operation returns the +CMMS mode to set, if
+ * any. */
+
+typedef enum {
+    MM_SMS_LINK_MODE_NONE      = -1, /* No command needed */
+    MM_SMS_LINK_MODE_DISABLED  = 0,
+    MM_SMS_LINK_MODE_TEMPORARY = 1,
+    MM_SMS_LINK_MODE_ENABLED   = 2,
+} MMSmsLinkMode;
+
+typedef struct {
+    guint    holds;
+    /* Set when the modem rejected +CMMS, so that it isn't tried again */
+    gboolean unsupported;
+} MMSmsLink;
+
+MMSmsLinkMode mm_sms_link_hold    (MMSmsLink *self,
+                                   gboolean   until_released);
+MMSmsLinkMode mm_sms_link_release (MMSmsLink *self);
+
+#endif /* MM_SMS_LINK_H */
@@ -27,6 +27,7 @@
 #include "mm-iface-modem-messaging.h"
 #include "mm-sms-list.h"
 #include "mm-base-sms.h"
+#include "mm-sms-index.h"
 #include "mm-log.h"
 
 G_DEFINE_TYPE (MMSmsList, mm_sms_list, G_TYPE_OBJECT);
@@ -45,33 +46,161 @@ enum {
 };
 static guint signals[SIGNAL_LAST];
 
+/* Incomplete multipart messages which didn't get any new part in this time,
+ * or the oldest ones when there are more than this amount, are no longer
+ * considered when reassembling new parts */
+#define PENDING_MULTIPART_TIMEOUT_SECS (3 * 24 * 3600)
+#define PENDING_MULTIPART_MAX          128
+
+typedef struct {
+    MMBaseSms *sms;
+    gint64     last_update;
+} PendingMultipart;
+
 struct _MMSmsListPrivate {
     /* The owner modem */
     MMBaseModem *modem;
     /* List of sms objects */
     GList *list;
+    guint n_sms;
+    /* Path -> link in list */
+    GHashTable *paths;
+    /* Part indices and multipart references of the sms objects */
+    MMSmsIndex *index;
+    /* Incomplete multipart messages being reassembled, oldest update first */
+    GQueue pending;
+    /* MMBaseSms -> link in pending */
+    GHashTable *pending_links;
 };
 
 /*****************************************************************************/
 
+static void
+pending_multipart_remove (MMSmsList *self,
+                          MMBaseSms *sms)
+{
+    GList *l;
+
+    l = g_hash_table_lookup (self->priv->pending_links, sms);
+    if (!l)
+        return;
+
+    g_hash_table_remove (self->priv->pending_links, sms);
+    g_slice_free (PendingMultipart, l->data);
+    g_queue_delete_link (&self->priv->pending, l);
+}
+
+static void
+pending_multipart_update (MMSmsList *self,
+                          MMBaseSms *sms)
+{
+    PendingMultipart *pending;
+
+    pending_multipart_remove (self, sms);
+    if (mm_base_sms_multipart_is_complete (sms))
+        return;
+
+    pending = g_slice_new (PendingMultipart);
+    pending->sms = sms;
+    pending->last_update = g_get_monotonic_time ();
+    g_queue_push_tail (&self->priv->pending, pending);
+    g_hash_table_insert (self->priv->pending_links, sms, g_queue_peek_tail_link (&self->priv->pending));
+}
+
+static void
+index_sms (MMSmsList *self,
+           MMBaseSms *sms)
+{
+    MMSmsStorage storage;
+    GList *l;
+
+    storage = mm_base_sms_get_storage (sms);
+    if (storage == MM_SMS_STORAGE_UNKNOWN)
+        return;
+
+    for (l = mm_base_sms_get_parts (sms); l; l = g_list_next (l)) {
+        guint index;
+
+        index = mm_sms_part_get_index ((MMSmsPart *)l->data);
+        if (index != SMS_PART_INVALID_INDEX)
+            mm_sms_index_add_part (self->priv->index, storage, index, sms);
+    }
+
+    /* User-created multipart messages, known by the number they're sent to */
+    if (mm_base_sms_is_multipart (sms) &&
+        mm_gdbus_sms_get_pdu_type (MM_GDBUS_SMS (sms)) == MM_SMS_PDU_TYPE_SUBMIT &&
+        mm_gdbus_sms_get_number (MM_GDBUS_SMS (sms)))
+        mm_sms_index_add_multipart (self->priv->index,
+                                    mm_base_sms_get_multipart_reference (sms),
+                                    mm_gdbus_sms_get_number (MM_GDBUS_SMS (sms)),
+                                    sms);
+}
+
+static void
+sms_storage_updated (MMBaseSms *sms,
+                     GParamSpec *pspec,
+                     MMSmsList *self)
+{
+    /* Parts get their index when the message is stored */
+    index_sms (self, sms);
+}
+
+static void
+list_insert (MMSmsList *self,
+             MMBaseSms *sms)
+{
+    const gchar *path;
+
+    self->priv->list = g_list_prepend (self->priv->list, sms);
+    self->priv->n_sms++;
+
+    path = mm_base_sms_get_path (sms);
+    if (path)
+        g_hash_table_insert (self->priv->paths, g_strdup (path), self->priv->list);
+
+    index_sms (self, sms);
+    g_signal_connect (sms,
+                      "notify::storage",
+                      G_CALLBACK (sms_storage_updated),
+                      self);
+}
+
+static void
+list_remove (MMSmsList *self,
+             GList *l,
+             const gchar *path)
+{
+    MMBaseSms *sms;
+
+    sms = MM_BASE_SMS (l->data);
+    g_signal_handlers_disconnect_by_func (sms, sms_storage_updated, self);
+    mm_sms_index_remove_item (self->priv->index, sms);
+    pending_multipart_remove (self, sms);
+    if (path)
+        g_hash_table_remove (self->priv->paths, path);
+
+    self->priv->list = g_list_delete_link (self->priv->list, l);
+    self->priv->n_sms--;
+    g_object_unref (sms);
+}
+
+/*****************************************************************************/
+
 gboolean
 mm_sms_list_has_local_multipart_reference (MMSmsList *self,
                                            const gchar *number,
                                            guint8 reference)
 {
-    GList *l;
+    const GSList *l;
 
     /* No one should look for multipart reference 0, which isn't valid */
     g_assert (reference != 0);
 
-    for (l = self->priv->list; l; l = g_list_next (l)) {
+    for (l = mm_sms_index_lookup_multipart (self->priv->index, reference, number); l; l = g_slist_next (l)) {
         MMBaseSms *sms = MM_BASE_SMS (l->data);
 
-        if (mm_base_sms_is_multipart (sms) &&
-            mm_gdbus_sms_get_pdu_type (MM_GDBUS_SMS (sms)) == MM_SMS_PDU_TYPE_SUBMIT &&
-            mm_base_sms_get_storage (sms) != MM_SMS_STORAGE_UNKNOWN &&
-            mm_base_sms_get_multipart_reference (sms) == reference &&
-            g_str_equal (mm_gdbus_sms_get_number (MM_GDBUS_SMS (sms)), number)) {
+        if (mm_gdbus_sms_get_pdu_type (MM_GDBUS_SMS (sms)) == MM_SMS_PDU_TYPE_SUBMIT &&
+            mm_base_sms_get_storage (sms) != MM_SMS_STORAGE_UNKNOWN) {
             /* Yes, the SMS list has an SMS with the same destination number
              * and multipart reference */
             return TRUE;
@@ -86,7 +215,7 @@ mm_sms_list_has_local_multipart_reference (MMSmsList *self,
 guint
 mm_sms_list_get_count (MMSmsList *self)
 {
-    return g_list_length (self->priv->list);
+    return self->priv->n_sms;
 }
 
 GStrv
@@ -96,8 +225,7 @@ mm_sms_list_get_paths (MMSmsList *self)
     GList *l;
     guint i;
 
-    path_list = g_new0 (gchar *,
-                        1 + g_list_length (self->priv->list));
+    path_list = g_new0 (gchar *, 1 + self->priv->n_sms);
 
     for (i = 0, l = self->priv->list; l; l = g_list_next (l)) {
         const gchar *path;
@@ -111,6 +239,16 @@ mm_sms_list_get_paths (MMSmsList *self)
     return path_list;
 }
 
+MMBaseSms *
+mm_sms_list_get_sms (MMSmsList *self,
+                     const gchar *sms_path)
+{
+    GList *l;
+
+    l = g_hash_table_lookup (self->priv->paths, sms_path);
+    return (l ? MM_BASE_SMS (l->data) : NULL);
+}
+
 /*****************************************************************************/
 
 gboolean
@@ -121,13 +259,6 @@ mm_sms_list_delete_sms_finish (MMSmsList *self,
     return g_task_propagate_boolean (G_TASK (res), error);
 }
 
-static guint
-cmp_sms_by_path (MMBaseSms *sms,
-                 const gchar *path)
-{
-    return g_strcmp0 (mm_base_sms_get_path (sms), path);
-}
-
 static void
 delete_ready (MMBaseSms *sms,
               GAsyncResult *res,
@@ -148,13 +279,9 @@ delete_ready (MMBaseSms *sms,
     self = g_task_get_source_object (task);
     path = g_task_get_task_data (task);
     /* The SMS was properly deleted, we now remove it from our list */
-    l = g_list_find_custom (self->priv->list,
-                            path,
-                            (GCompareFunc)cmp_sms_by_path);
-    if (l) {
-        g_object_unref (MM_BASE_SMS (l->data));
-        self->priv->list = g_list_delete_link (self->priv->list, l);
-    }
+    l = g_hash_table_lookup (self->priv->paths, path);
+    if (l)
+        list_remove (self, l, path);
 
     /* We don't need to unref the SMS any more, but we can use the
      * reference we got in the method, which is the one kept alive
@@ -178,9 +305,7 @@ mm_sms_list_delete_sms (MMSmsList *self,
     GList *l;
     GTask *task;
 
-    l = g_list_find_custom (self->priv->list,
-                            (gpointer)sms_path,
-                            (GCompareFunc)cmp_sms_by_path);
+    l = g_hash_table_lookup (self->priv->paths, sms_path);
     if (!l) {
         g_task_report_new_error (self,
                                  callback,
@@ -208,7 +333,7 @@ void
 mm_sms_list_add_sms (MMSmsList *self,
                      MMBaseSms *sms)
 {
-    self->priv->list = g_list_prepend (self->priv->list, g_object_ref (sms));
+    list_insert (self, g_object_ref (sms));
     g_signal_emit (self, signals[SIGNAL_ADDED], 0,
                    mm_base_sms_get_path (sms),
                    FALSE);
@@ -216,27 +341,27 @@ mm_sms_list_add_sms (MMSmsList *self,
 
 /*****************************************************************************/
 
-static guint
-cmp_sms_by_concat_reference (MMBaseSms *sms,
-                             gpointer user_data)
+/* Drops the incomplete multipart messages which are too old, or the oldest
+ * ones if there are too many, from the reassembly of new parts. They are
+ * kept in the list, with the parts they already got, until deleted. */
+static void
+evict_pending_multiparts (MMSmsList *self)
 {
-    if (!mm_base_sms_is_multipart (sms))
-        return -1;
+    gint64 now;
 
-    return (GPOINTER_TO_UINT (user_data) - mm_base_sms_get_multipart_reference (sms));
-}
+    now = g_get_monotonic_time ();
+    while (!g_queue_is_empty (&self->priv->pending)) {
+        PendingMultipart *pending;
 
-typedef struct {
-    guint part_index;
-    MMSmsStorage storage;
-} PartIndexAndStorage;
+        pending = g_queue_peek_head (&self->priv->pending);
+        if (g_queue_get_length (&self->priv->pending) <= PENDING_MULTIPART_MAX &&
+            (now - pending->last_update) < ((gint64) PENDING_MULTIPART_TIMEOUT_SECS * G_USEC_PER_SEC))
+            break;
 
-static guint
-cmp_sms_by_part_index_and_storage (MMBaseSms *sms,
-                                   PartIndexAndStorage *ctx)
-{
-    return !(mm_base_sms_get_storage (sms) == ctx->storage &&
-             mm_base_sms_has_part_index (sms, ctx->part_index));
+        mm_dbg ("Evicting incomplete multipart SMS (reference: '%u')",
+                mm_base_sms_get_multipart_reference (pending->sms));
+        pending_multipart_remove (self, pending->sms);
+    }
 }
 
 static gboolean
@@ -256,7 +381,7 @@ take_singlepart (MMSmsList *self,
     if (!sms)
         return FALSE;
 
-    self->priv->list = g_list_prepend (self->priv->list, sms);
+    list_insert (self, sms);
     g_signal_emit (self, signals[SIGNAL_ADDED], 0,
                    mm_base_sms_get_path (sms),
                    state == MM_SMS_STATE_RECEIVED);
@@ -270,17 +395,37 @@ take_multipart (MMSmsList *self,
                 MMSmsStorage storage,
                 GError **error)
 {
-    GList *l;
+    const GSList *l;
     MMBaseSms *sms;
     guint concat_reference;
+    guint index;
 
     concat_reference = mm_sms_part_get_concat_reference (part);
-    l = g_list_find_custom (self->priv->list,
-                            GUINT_TO_POINTER (concat_reference),
-                            (GCompareFunc)cmp_sms_by_concat_reference);
-    if (l)
+    index = mm_sms_part_get_index (part);
+
+    /* Parts of messages which timed out start a new one */
+    evict_pending_multiparts (self);
+
+    /* Look for the message being reassembled with the same reference and
+     * from the same number */
+    for (l = mm_sms_index_lookup_multipart (self->priv->index,
+                                            concat_reference,
+                                            mm_sms_part_get_number (part));
+         l;
+         l = g_slist_next (l)) {
+        sms = MM_BASE_SMS (l->data);
+        if (!g_hash_table_contains (self->priv->pending_links, sms))
+            continue;
+
         /* Try to take the part */
-        return mm_base_sms_multipart_take_part (MM_BASE_SMS (l->data), part, error);
+        if (!mm_base_sms_multipart_take_part (sms, part, error))
+            return FALSE;
+
+        if (storage != MM_SMS_STORAGE_UNKNOWN && index != SMS_PART_INVALID_INDEX)
+            mm_sms_index_add_part (self->priv->index, storage, index, sms);
+        pending_multipart_update (self, sms);
+        return TRUE;
+    }
 
     /* Create new Multipart */
     sms = mm_base_sms_multipart_new (self->priv->modem,
@@ -293,7 +438,12 @@ take_multipart (MMSmsList *self,
     if (!sms)
         return FALSE;
 
-    self->priv->list = g_list_prepend (self->priv->list, sms);
+    list_insert (self, sms);
+    mm_sms_index_add_multipart (self->priv->index,
+                                concat_reference,
+                                mm_sms_part_get_number (part),
+                                sms);
+    pending_multipart_update (self, sms);
     g_signal_emit (self, signals[SIGNAL_ADDED], 0,
                    mm_base_sms_get_path (sms),
                    (state == MM_SMS_STATE_RECEIVED ||
@@ -307,18 +457,18 @@ mm_sms_list_has_part (MMSmsList *self,
                       MMSmsStorage storage,
                       guint index)
 {
-    PartIndexAndStorage ctx;
+    MMBaseSms *sms;
 
     if (storage == MM_SMS_STORAGE_UNKNOWN ||
         index == SMS_PART_INVALID_INDEX)
         return FALSE;
 
-    ctx.part_index = index;
-    ctx.storage = storage;
-
-    return !!g_list_find_custom (self->priv->list,
-                                 &ctx,
-                                 (GCompareFunc)cmp_sms_by_part_index_and_storage);
+    /* Part indices may have been reset (e.g. on a failed removal), so always
+     * double check with the message */
+    sms = mm_sms_index_lookup_part (self->priv->index, storage, index);
+    return (sms &&
+            mm_base_sms_get_storage (sms) == storage &&
+            mm_base_sms_has_part_index (sms, index));
 }
 
 gboolean
@@ -421,6 +571,10 @@ mm_sms_list_init (MMSmsList *self)
     self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self,
                                               MM_TYPE_SMS_LIST,
                                               MMSmsListPrivate);
+    self->priv->paths = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    self->priv->index = mm_sms_index_new ();
+    g_queue_init (&self->priv->pending);
+    self->priv->pending_links = g_hash_table_new (g_direct_hash, g_direct_equal);
 }
 
 static void
@@ -429,12 +583,24 @@ dispose (GObject *object)
     MMSmsList *self = MM_SMS_LIST (object);
 
     g_clear_object (&self->priv->modem);
-    g_list_free_full (self->priv->list, g_object_unref);
-    self->priv->list = NULL;
+    while (self->priv->list)
+        list_remove (self, self->priv->list, mm_base_sms_get_path (MM_BASE_SMS (self->priv->list->data)));
 
     G_OBJECT_CLASS (mm_sms_list_parent_class)->dispose (object);
 }
 
+static void
+finalize (GObject *object)
+{
+    MMSmsList *self = MM_SMS_LIST (object);
+
+    g_hash_table_destroy (self->priv->paths);
+    mm_sms_index_free (self->priv->index);
+    g_hash_table_destroy (self->priv->pending_links);
+
+    G_OBJECT_CLASS (mm_sms_list_parent_class)->finalize (object);
+}
+
 static void
 mm_sms_list_class_init (MMSmsListClass *klass)
 {
@@ -446,6 +612,7 @@ mm_sms_list_class_init (MMSmsListClass *klass)
     object_class->get_property = get_property;
     object_class->set_property = set_property;
     object_class->dispose = dispose;
+    object_class->finalize = finalize;
 
     /* Properties */
     properties[PROP_MODEM] =
@@ -60,6 +60,8 @@ MMSmsList *mm_sms_list_new (MMBaseModem *modem);
 
 GStrv mm_sms_list_get_paths (MMSmsList *self);
 guint mm_sms_list_get_count (MMSmsList *self);
+MMBaseSms *mm_sms_list_get_sms (MMSmsList *self,
+                                const gchar *sms_path);
 
 gboolean mm_sms_list_has_part (MMSmsList *self,
                                MMSmsStorage storage,
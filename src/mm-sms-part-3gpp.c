@@ -119,9 +119,112 @@ sms_string_to_bcd_semi_octets (guint8 *buf, gsize buflen, const char *string)
     return addrlen / 2;
 }
 
+/*****************************************************************************/
+/* Decoding arena
+ *
+ * All the intermediate buffers needed while decoding a PDU (binary PDU,
+ * unpacked septets, decoded strings) are taken from an arena, which is reset
+ * before each PDU; only the final strings are copied into the MMSmsPart, in
+ * one single allocation. The first chunk is usually a buffer in the stack. */
+
+#define DECODE_ARENA_CHUNK_SIZE 4096
+
+typedef struct {
+    guint8 *initial;
+    guint8 *chunk;
+    gsize   chunk_size;
+    gsize   used;
+    /* Previous chunks, no longer used for new allocations */
+    GSList *full;
+} DecodeArena;
+
+static void
+decode_arena_init (DecodeArena *arena,
+                   guint8      *buffer,
+                   gsize        buffer_size)
+{
+    arena->initial = arena->chunk = buffer;
+    arena->chunk_size = buffer_size;
+    arena->used = 0;
+    arena->full = NULL;
+}
+
+static gpointer
+decode_arena_alloc (DecodeArena *arena,
+                    gsize        size)
+{
+    gpointer mem;
+
+    size = (size + 7) & ~((gsize) 7);
+    if (arena->used + size > arena->chunk_size) {
+        if (arena->chunk != arena->initial)
+            arena->full = g_slist_prepend (arena->full, arena->chunk);
+        arena->chunk_size = MAX (DECODE_ARENA_CHUNK_SIZE, size);
+        arena->chunk = g_malloc (arena->chunk_size);
+        arena->used = 0;
+    }
+
+    mem = arena->chunk + arena->used;
+    arena->used += size;
+    return mem;
+}
+
+/* The current chunk is kept for the next PDU */
+static void
+decode_arena_reset (DecodeArena *arena)
+{
+    g_slist_free_full (arena->full, g_free);
+    arena->full = NULL;
+    arena->used = 0;
+}
+
+static void
+decode_arena_clear (DecodeArena *arena)
+{
+    decode_arena_reset (arena);
+    if (arena->chunk != arena->initial)
+        g_free (arena->chunk);
+    arena->chunk = NULL;
+    arena->chunk_size = 0;
+}
+
+static gchar *
+decode_arena_charset_to_utf8 (DecodeArena    *arena,
+                              MMModemCharset  charset,
+                              const guint8   *data,
+                              gsize           len)
+{
+    gchar *utf8;
+    gsize  utf8_len;
+
+    utf8_len = mm_modem_charset_decode_into (charset, data, len, NULL);
+    if (utf8_len == G_MAXSIZE)
+        return NULL;
+
+    utf8 = decode_arena_alloc (arena, utf8_len + 1);
+    mm_modem_charset_decode_into (charset, data, len, utf8);
+    utf8[utf8_len] = '\0';
+    return utf8;
+}
+
+static guint8 *
+decode_arena_gsm_unpack (DecodeArena  *arena,
+                         const guint8 *gsm,
+                         guint32       num_septets,
+                         guint8        start_offset)
+{
+    guint8 *unpacked;
+
+    unpacked = decode_arena_alloc (arena, num_septets);
+    mm_charset_gsm_unpack_into (gsm, num_septets, start_offset, unpacked);
+    return unpacked;
+}
+
+/*****************************************************************************/
+
 /* len is in semi-octets */
-static char *
-sms_decode_address (const guint8 *address, int len)
+static const gchar *
+sms_decode_address (DecodeArena *arena, const guint8 *address, int len)
 {
     guint8 addrtype, addrplan;
     char *utf8;
@@ -133,14 +236,14 @@ sms_decode_address (const guint8 *address, int len)
     if (addrtype == SMS_NUMBER_TYPE_ALPHA) {
         guint8 *unpacked;
         guint32 unpacked_len;
-        unpacked = mm_charset_gsm_unpack (address, (len * 4) / 7, 0, &unpacked_len);
-        utf8 = (char *)mm_charset_gsm_unpacked_to_utf8 (unpacked,
-                                                        unpacked_len);
-        g_free (unpacked);
+
+        unpacked_len = (len * 4) / 7;
+        unpacked = decode_arena_gsm_unpack (arena, address, unpacked_len, 0);
+        utf8 = decode_arena_charset_to_utf8 (arena, MM_MODEM_CHARSET_GSM, unpacked, unpacked_len);
     } else if (addrtype == SMS_NUMBER_TYPE_INTL &&
                addrplan == SMS_NUMBER_PLAN_TELEPHONE) {
         /* International telphone number, format as "+1234567890" */
-        utf8 = g_malloc (len + 3); /* '+' + digits + possible trailing 0xf + NUL */
+        utf8 = decode_arena_alloc (arena, len + 3); /* '+' + digits + possible trailing 0xf + NUL */
         utf8[0] = '+';
         sms_semi_octets_to_bcd_string (utf8 + 1, address, (len + 1) / 2);
     } else {
@@ -149,21 +252,22 @@ sms_decode_address (const guint8 *address, int len)
          * don't apply any special formatting if we don't know the
          * format.
          */
-        utf8 = g_malloc (len + 2); /* digits + possible trailing 0xf + NUL */
+        utf8 = decode_arena_alloc (arena, len + 2); /* digits + possible trailing 0xf + NUL */
         sms_semi_octets_to_bcd_string (utf8, address, (len + 1) / 2);
     }
 
     return utf8;
 }
 
-static char *
-sms_decode_timestamp (const guint8 *timestamp)
+static const gchar *
+sms_decode_timestamp (DecodeArena *arena, const guint8 *timestamp)
 {
     /* YYMMDDHHMMSS+ZZ */
     char *timestr;
     int quarters, hours;
 
-    timestr = g_malloc0 (16);
+    timestr = decode_arena_alloc (arena, 16);
+    timestr[15] = '\0';
     sms_semi_octets_to_bcd_string (timestr, timestamp, 6);
     quarters = ((timestamp[6] & 0x7) * 10) + ((timestamp[6] >> 4) & 0xf);
     hours = quarters / 4;
@@ -234,19 +338,17 @@ sms_encoding_type (int dcs)
     return scheme;
 }
 
-static char *
-sms_decode_text (const guint8 *text, int len, MMSmsEncoding encoding, int bit_offset)
+static const gchar *
+sms_decode_text (DecodeArena *arena, const guint8 *text, int len, MMSmsEncoding encoding, int bit_offset)
 {
-    char *utf8;
+    const gchar *utf8;
     guint8 *unpacked;
-    guint32 unpacked_len;
 
     if (encoding == MM_SMS_ENCODING_GSM7) {
         mm_dbg ("Converting SMS part text from GSM-7 to UTF-8...");
-        unpacked = mm_charset_gsm_unpack ((const guint8 *) text, len, bit_offset, &unpacked_len);
-        utf8 = (char *) mm_charset_gsm_unpacked_to_utf8 (unpacked, unpacked_len);
+        unpacked = decode_arena_gsm_unpack (arena, text, len, bit_offset);
+        utf8 = decode_arena_charset_to_utf8 (arena, MM_MODEM_CHARSET_GSM, unpacked, len);
         mm_dbg ("   Got UTF-8 text: '%s'", utf8);
-        g_free (unpacked);
     } else if (encoding == MM_SMS_ENCODING_UCS2) {
         /* Despite 3GPP TS 23.038 specifies that Unicode SMS messages are
          * encoded in UCS-2, UTF-16 encoding is commonly used instead on many
@@ -257,24 +359,21 @@ sms_decode_text (const guint8 *text, int len, MMSmsEncoding encoding, int bit_of
          * code points (i.e. a high surrogate in 0xD800..0xDBFF, followed by a
          * low surrogate in 0xDC00..0xDFFF). An isolated surrogate code point
          * has no general interpretation in UTF-16, but could be a valid
-         * (though unmapped) code point in UCS-2. Here we first try to decode
-         * the SMS message in UTF-16BE, and if that fails, fall back to decode
-         * in UCS-2BE.
+         * (though unmapped) code point in UCS-2. The UCS-2 decoder accepts
+         * UTF-16BE surrogate pairs; isolated surrogates are not valid in
+         * either (as was the case with iconv's UCS-2BE), so they are not
+         * decoded.
          */
         mm_dbg ("Converting SMS part text from UTF-16BE to UTF-8...");
-        utf8 = g_convert ((const gchar *) text, len, "UTF8", "UTF16BE", NULL, NULL, NULL);
-        if (!utf8) {
-            mm_dbg ("Converting SMS part text from UCS-2BE to UTF8...");
-            utf8 = g_convert ((const gchar *) text, len, "UTF8", "UCS-2BE", NULL, NULL, NULL);
-        }
+        utf8 = decode_arena_charset_to_utf8 (arena, MM_MODEM_CHARSET_UCS2, text, len);
         if (!utf8) {
             mm_warn ("Couldn't convert SMS part contents from UTF-16BE/UCS-2BE to UTF-8: not decoding any text");
-            utf8 = g_strdup ("");
+            utf8 = "";
         } else
             mm_dbg ("   Got UTF-8 text: '%s'", utf8);
     } else {
         mm_warn ("Unexpected encoding '%s': not decoding any text", mm_sms_encoding_get_string (encoding));
-        utf8 = g_strdup ("");
+        utf8 = "";
     }
 
     return utf8;
@@ -337,18 +436,29 @@ validity_to_relative (guint validity)
     return 255; /* 63 weeks */
 }
 
-MMSmsPart *
-mm_sms_part_3gpp_new_from_pdu (guint index,
-                               const gchar *hexpdu,
-                               GError **error)
+static MMSmsPart *sms_part_3gpp_decode (DecodeArena   *arena,
+                                        guint          index,
+                                        const guint8  *pdu,
+                                        gsize          pdu_len,
+                                        GError       **error);
+
+/* Enough for most PDUs, so that usually nothing is allocated besides the
+ * MMSmsPart and its strings */
+#define DECODE_ARENA_STACK_SIZE 1024
+
+static MMSmsPart *
+sms_part_3gpp_decode_hex (DecodeArena  *arena,
+                          guint         index,
+                          const gchar  *hexpdu,
+                          GError      **error)
 {
-    gsize pdu_len;
+    gsize   hexpdu_len;
     guint8 *pdu;
-    MMSmsPart *part;
 
     /* Convert PDU from hex to binary */
-    pdu = (guint8 *) mm_utils_hexstr2bin (hexpdu, &pdu_len);
-    if (!pdu) {
+    hexpdu_len = strlen (hexpdu);
+    pdu = decode_arena_alloc (arena, hexpdu_len / 2);
+    if ((hexpdu_len % 2) || !mm_utils_hexstr2bin_into (hexpdu, hexpdu_len, pdu)) {
         g_set_error_literal (error,
                              MM_CORE_ERROR,
                              MM_CORE_ERROR_FAILED,
@@ -356,17 +466,76 @@ mm_sms_part_3gpp_new_from_pdu (guint index,
         return NULL;
     }
 
-    part = mm_sms_part_3gpp_new_from_binary_pdu (index, pdu, pdu_len, error);
-    g_free (pdu);
+    return sms_part_3gpp_decode (arena, index, pdu, hexpdu_len / 2, error);
+}
+
+MMSmsPart *
+mm_sms_part_3gpp_new_from_pdu (guint index,
+                               const gchar *hexpdu,
+                               GError **error)
+{
+    DecodeArena  arena;
+    guint8       buffer[DECODE_ARENA_STACK_SIZE];
+    MMSmsPart   *part;
 
+    decode_arena_init (&arena, buffer, sizeof (buffer));
+    part = sms_part_3gpp_decode_hex (&arena, index, hexpdu, error);
+    decode_arena_clear (&arena);
     return part;
 }
 
+guint
+mm_sms_part_3gpp_new_from_pdus (guint               n_pdus,
+                                const guint        *indices,
+                                const gchar *const *hexpdus,
+                                MMSmsPart         **out_parts,
+                                GError            **out_errors)
+{
+    DecodeArena  arena;
+    guint8       buffer[DECODE_ARENA_STACK_SIZE];
+    guint        n_parts = 0;
+    guint        i;
+
+    g_return_val_if_fail (out_parts != NULL, 0);
+
+    /* One single arena for the whole batch, reset after each PDU */
+    decode_arena_init (&arena, buffer, sizeof (buffer));
+    for (i = 0; i < n_pdus; i++) {
+        out_parts[i] = sms_part_3gpp_decode_hex (&arena,
+                                                 indices ? indices[i] : SMS_PART_INVALID_INDEX,
+                                                 hexpdus[i],
+                                                 out_errors ? &out_errors[i] : NULL);
+        if (out_parts[i])
+            n_parts++;
+        decode_arena_reset (&arena);
+    }
+    decode_arena_clear (&arena);
+
+    return n_parts;
+}
+
 MMSmsPart *
 mm_sms_part_3gpp_new_from_binary_pdu (guint index,
                                       const guint8 *pdu,
                                       gsize pdu_len,
                                       GError **error)
+{
+    DecodeArena  arena;
+    guint8       buffer[DECODE_ARENA_STACK_SIZE];
+    MMSmsPart   *part;
+
+    decode_arena_init (&arena, buffer, sizeof (buffer));
+    part = sms_part_3gpp_decode (&arena, index, pdu, pdu_len, error);
+    decode_arena_clear (&arena);
+    return part;
+}
+
+static MMSmsPart *
+sms_part_3gpp_decode (DecodeArena   *arena,
+                      guint          index,
+                      const guint8  *pdu,
+                      gsize          pdu_len,
+                      GError       **error)
 {
     MMSmsPart *sms_part;
     guint8 pdu_type;
@@ -382,6 +551,12 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
     guint tp_dcs_offset = 0;
     guint tp_user_data_len_offset = 0;
     MMSmsEncoding user_data_encoding = MM_SMS_ENCODING_UNKNOWN;
+    /* Strings, in the arena until the part is complete */
+    const gchar *smsc = NULL;
+    const gchar *number = NULL;
+    const gchar *timestamp = NULL;
+    const gchar *discharge_timestamp = NULL;
+    const gchar *text = NULL;
 
     /* Create the new MMSmsPart */
     sms_part = mm_sms_part_new (index, MM_SMS_PDU_TYPE_UNKNOWN);
@@ -414,9 +589,8 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
     if (smsc_addr_size_bytes > 0) {
         PDU_SIZE_CHECK (offset + smsc_addr_size_bytes, "cannot read SMSC address");
         /* SMSC may not be given in DELIVER PDUs */
-        mm_sms_part_take_smsc (sms_part,
-                               sms_decode_address (&pdu[1], 2 * (smsc_addr_size_bytes - 1)));
-        mm_dbg ("  SMSC address parsed: '%s'", mm_sms_part_get_smsc (sms_part));
+        smsc = sms_decode_address (arena, &pdu[1], 2 * (smsc_addr_size_bytes - 1));
+        mm_dbg ("  SMSC address parsed: '%s'", smsc);
         offset += smsc_addr_size_bytes;
     } else
         mm_dbg ("  No SMSC address given");
@@ -487,10 +661,8 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
     tp_addr_size_bytes = (tp_addr_size_digits + 1) >> 1;
 
     PDU_SIZE_CHECK (offset + tp_addr_size_bytes, "cannot read number");
-    mm_sms_part_take_number (sms_part,
-                             sms_decode_address (&pdu[offset],
-                                                 tp_addr_size_digits));
-    mm_dbg ("  Number parsed: '%s'", mm_sms_part_get_number (sms_part));
+    number = sms_decode_address (arena, &pdu[offset], tp_addr_size_digits);
+    mm_dbg ("  Number parsed: '%s'", number);
     offset += (1 + tp_addr_size_bytes); /* +1 due to the Type of Address byte */
 
     /* ---------------------------------------------------------------------- */
@@ -507,8 +679,7 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
         tp_dcs_offset = offset++;
 
         /* ------ Timestamp (7 bytes) ------ */
-        mm_sms_part_take_timestamp (sms_part,
-                                    sms_decode_timestamp (&pdu[offset]));
+        timestamp = sms_decode_timestamp (arena, &pdu[offset]);
         offset += 7;
 
         tp_user_data_len_offset = offset;
@@ -559,13 +730,11 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
         PDU_SIZE_CHECK (offset + 15, "cannot read Timestamps/TP-STATUS"); /* 7+7+1=15 */
 
         /* ------ Timestamp (7 bytes) ------ */
-        mm_sms_part_take_timestamp (sms_part,
-                                    sms_decode_timestamp (&pdu[offset]));
+        timestamp = sms_decode_timestamp (arena, &pdu[offset]);
         offset += 7;
 
         /* ------ Discharge Timestamp (7 bytes) ------ */
-        mm_sms_part_take_discharge_timestamp (sms_part,
-                                              sms_decode_timestamp (&pdu[offset]));
+        discharge_timestamp = sms_decode_timestamp (arena, &pdu[offset]);
         offset += 7;
 
         /* ----- TP-STATUS (1 byte) ------ */
@@ -715,12 +884,12 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
         case MM_SMS_ENCODING_UCS2:
             /* Otherwise if it's 7-bit or UCS2 we can decode it */
             mm_dbg ("Decoding SMS text with '%u' elements", tp_user_data_size_elements);
-            mm_sms_part_take_text (sms_part,
-                                   sms_decode_text (&pdu[tp_user_data_offset],
-                                                    tp_user_data_size_elements,
-                                                    user_data_encoding,
-                                                    bit_offset));
-            g_warn_if_fail (mm_sms_part_get_text (sms_part) != NULL);
+            text = sms_decode_text (arena,
+                                    &pdu[tp_user_data_offset],
+                                    tp_user_data_size_elements,
+                                    user_data_encoding,
+                                    bit_offset);
+            g_warn_if_fail (text != NULL);
             break;
 
         default:
@@ -742,6 +911,7 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
         }
     }
 
+    mm_sms_part_set_strings (sms_part, smsc, number, timestamp, discharge_timestamp, text);
     return sms_part;
 }
 
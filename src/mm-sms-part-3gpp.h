@@ -26,6 +26,16 @@ MMSmsPart *mm_sms_part_3gpp_new_from_pdu  (guint index,
                                            const gchar *hexpdu,
                                            GError **error);
 
+/* Decodes @n_pdus PDUs, sharing the intermediate buffers between them.
+ * @out_parts (and @out_errors, if given) must hold @n_pdus elements; parts
+ * which cannot be decoded are set to NULL. @indices may be NULL if the PDUs
+ * are not stored. Returns the number of parts decoded. */
+guint      mm_sms_part_3gpp_new_from_pdus (guint               n_pdus,
+                                           const guint        *indices,
+                                           const gchar *const *hexpdus,
+                                           MMSmsPart         **out_parts,
+                                           GError            **out_errors);
+
 MMSmsPart *mm_sms_part_3gpp_new_from_binary_pdu (guint index,
                                                  const guint8 *pdu,
                                                  gsize pdu_len,
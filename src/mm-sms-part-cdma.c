@@ -229,34 +229,200 @@ encoding_to_string (Encoding encoding)
 }
 
 /*****************************************************************************/
-/* Read bits; o_bits < 8; n_bits <= 8
- *
- * Byte 0            Byte 1
- * [7|6|5|4|3|2|1|0] [7|6|5|4|3|2|1|0]
- *
- * o_bits+n_bits <= 16
+/* Bit reader and writer
  *
+ * Fields are packed most significant bit first and, after the first few
+ * ones, are no longer byte aligned; so both just keep a running bit offset
+ * over the whole buffer instead of a byte and a bit offset.
  */
-static guint8
-read_bits (const guint8 *bytes,
-           guint8 o_bits,
-           guint8 n_bits)
+
+typedef struct {
+    const guint8 *data;
+    guint         len;    /* in bytes */
+    guint         offset; /* in bits */
+} BitReader;
+
+static inline void
+bit_reader_init (BitReader    *reader,
+                 const guint8 *data,
+                 guint         len)
+{
+    reader->data = data;
+    reader->len = len;
+    reader->offset = 0;
+}
+
+/* Number of bytes needed to read n_bits more */
+static inline guint
+bit_reader_required (const BitReader *reader,
+                     guint            n_bits)
+{
+    return (reader->offset + n_bits + 7) / 8;
+}
+
+static inline gboolean
+bit_reader_has (const BitReader *reader,
+                guint            n_bits)
+{
+    return bit_reader_required (reader, n_bits) <= reader->len;
+}
+
+/* n_bits <= 16 */
+static guint
+bit_reader_read (BitReader *reader,
+                 guint      n_bits)
+{
+    const guint8 *p;
+    guint32       window;
+    guint         n_bytes;
+    guint         i;
+
+    g_assert (n_bits <= 16);
+    g_assert (bit_reader_has (reader, n_bits));
+
+    if (!n_bits)
+        return 0;
+
+    /* Load all the bytes the field spans at once */
+    p = &reader->data[reader->offset / 8];
+    n_bytes = ((reader->offset % 8) + n_bits + 7) / 8;
+    window = p[0];
+    for (i = 1; i < n_bytes; i++)
+        window = (window << 8) | p[i];
+
+    window >>= (n_bytes * 8) - (reader->offset % 8) - n_bits;
+    reader->offset += n_bits;
+    return window & ((1 << n_bits) - 1);
+}
+
+/* Reads n_fields of n_bits each (n_bits <= 8), one per output byte */
+static void
+bit_reader_read_fields (BitReader *reader,
+                        guint      n_bits,
+                        guint      n_fields,
+                        guint8    *out)
+{
+    const guint8 *p;
+    guint32       acc;
+    guint         acc_bits;
+    guint         i;
+
+    g_assert (n_bits > 0 && n_bits <= 8);
+    g_assert (bit_reader_has (reader, n_bits * n_fields));
+
+    if (!n_fields)
+        return;
+
+    p = &reader->data[reader->offset / 8];
+
+    if (n_bits == 8 && !(reader->offset % 8)) {
+        memcpy (out, p, n_fields);
+        reader->offset += 8 * n_fields;
+        return;
+    }
+
+    /* Each input byte is loaded only once into the accumulator, which never
+     * holds more than 15 bits */
+    acc_bits = 8 - (reader->offset % 8);
+    acc = *p++ & ((1 << acc_bits) - 1);
+    for (i = 0; i < n_fields; i++) {
+        if (acc_bits < n_bits) {
+            acc = (acc << 8) | *p++;
+            acc_bits += 8;
+        }
+        acc_bits -= n_bits;
+        out[i] = (acc >> acc_bits) & ((1 << n_bits) - 1);
+        acc &= (1 << acc_bits) - 1;
+    }
+    reader->offset += n_bits * n_fields;
+}
+
+typedef struct {
+    guint8 *data;   /* must be zero-initialized */
+    guint   offset; /* in bits */
+} BitWriter;
+
+static inline void
+bit_writer_init (BitWriter *writer,
+                 guint8    *data)
+{
+    writer->data = data;
+    writer->offset = 0;
+}
+
+/* Number of bytes written, including the last partial one */
+static inline guint
+bit_writer_get_len (const BitWriter *writer)
+{
+    return (writer->offset + 7) / 8;
+}
+
+/* n_bits <= 16 */
+static void
+bit_writer_write (BitWriter *writer,
+                  guint      n_bits,
+                  guint      value)
 {
-    guint8 bits_in_first;
-    guint8 bits_in_second;
+    guint8  *p;
+    guint32  window;
+    guint    n_bytes;
 
-    g_assert (o_bits < 8);
-    g_assert (n_bits <= 8);
-    g_assert (o_bits + n_bits <= 16);
+    g_assert (n_bits <= 16);
 
-    /* Read only from the first byte */
-    if (o_bits + n_bits <= 8)
-        return (bytes[0] >> (8 - o_bits - n_bits)) & ((1 << n_bits) - 1);
+    if (!n_bits)
+        return;
+
+    p = &writer->data[writer->offset / 8];
+    n_bytes = ((writer->offset % 8) + n_bits + 7) / 8;
+    window = (value & ((1 << n_bits) - 1)) << ((n_bytes * 8) - (writer->offset % 8) - n_bits);
+    while (n_bytes--) {
+        p[n_bytes] |= window & 0xFF;
+        window >>= 8;
+    }
+    writer->offset += n_bits;
+}
+
+/* Writes n_fields of n_bits each (n_bits <= 8), one per input byte */
+static void
+bit_writer_write_fields (BitWriter    *writer,
+                         guint         n_bits,
+                         guint         n_fields,
+                         const guint8 *in)
+{
+    guint8  *p;
+    guint32  acc;
+    guint    acc_bits;
+    guint    i;
+
+    g_assert (n_bits > 0 && n_bits <= 8);
+
+    if (!n_fields)
+        return;
+
+    p = &writer->data[writer->offset / 8];
+
+    if (n_bits == 8 && !(writer->offset % 8)) {
+        memcpy (p, in, n_fields);
+        writer->offset += 8 * n_fields;
+        return;
+    }
 
-    /* Read (8 - o_bits) from the first byte and (n_bits - (8 - o_bits)) from the second byte */
-    bits_in_first = 8 - o_bits;
-    bits_in_second = n_bits - bits_in_first;
-    return (read_bits (&bytes[0], o_bits, bits_in_first) << bits_in_second) | read_bits (&bytes[1], 0, bits_in_second);
+    /* Start with the bits already written in the current byte, and flush
+     * whole bytes as soon as they are complete */
+    acc_bits = writer->offset % 8;
+    acc = p[0] >> (8 - acc_bits);
+    for (i = 0; i < n_fields; i++) {
+        acc = (acc << n_bits) | (in[i] & ((1 << n_bits) - 1));
+        acc_bits += n_bits;
+        if (acc_bits >= 8) {
+            acc_bits -= 8;
+            *p++ = (acc >> acc_bits) & 0xFF;
+            acc &= (1 << acc_bits) - 1;
+        }
+    }
+    if (acc_bits)
+        *p = acc << (8 - acc_bits);
+    writer->offset += n_bits * n_fields;
 }
 
 /*****************************************************************************/
@@ -309,29 +475,38 @@ cause_code_to_delivery_state (guint8 error_class,
     return (MMSmsDeliveryState) delivery_state;
 }
 
+
 /*****************************************************************************/
 
+/* Enough for any PDU a modem would give us */
+#define PDU_STACK_SIZE 512
+
 MMSmsPart *
 mm_sms_part_cdma_new_from_pdu (guint index,
                                const gchar *hexpdu,
                                GError **error)
 {
+    guint8 buffer[PDU_STACK_SIZE];
+    gsize hexpdu_len;
     gsize pdu_len;
     guint8 *pdu;
     MMSmsPart *part;
 
     /* Convert PDU from hex to binary */
-    pdu = (guint8 *) mm_utils_hexstr2bin (hexpdu, &pdu_len);
-    if (!pdu) {
+    hexpdu_len = strlen (hexpdu);
+    pdu_len = hexpdu_len / 2;
+    pdu = (pdu_len <= sizeof (buffer)) ? buffer : g_malloc (pdu_len);
+    if ((hexpdu_len % 2) || !mm_utils_hexstr2bin_into (hexpdu, hexpdu_len, pdu)) {
         g_set_error_literal (error,
                              MM_CORE_ERROR,
                              MM_CORE_ERROR_FAILED,
                              "Couldn't convert CDMA PDU from hex to binary");
-        return NULL;
-    }
+        part = NULL;
+    } else
+        part = mm_sms_part_cdma_new_from_binary_pdu (index, pdu, pdu_len, error);
 
-    part = mm_sms_part_cdma_new_from_binary_pdu (index, pdu, pdu_len, error);
-    g_free (pdu);
+    if (pdu != buffer)
+        g_free (pdu);
 
     return part;
 }
@@ -463,43 +638,42 @@ dtmf_to_ascii (guint8 dtmf)
     return '\0';
 }
 
+
 static void
 read_address (MMSmsPart *sms_part,
               const struct Parameter *parameter)
 {
+    static const gchar hex_digits[] = "0123456789ABCDEF";
+    BitReader reader;
     guint8 digit_mode;
     guint8 number_mode;
     guint8 number_type;
     guint8 numbering_plan;
     guint8 num_fields;
-    guint byte_offset = 0;
-    guint bit_offset = 0;
     guint i;
     gchar *number = NULL;
 
-#define OFFSETS_UPDATE(n_bits) do { \
-        bit_offset += n_bits;       \
-        if (bit_offset >= 8) {      \
-            bit_offset-=8;          \
-            byte_offset++;          \
-        }                           \
-    } while (0)
-
-#define PARAMETER_SIZE_CHECK(required_size)                             \
-    if (parameter->parameter_len < required_size) {                     \
+#define PARAMETER_SIZE_CHECK(n_bits)                                    \
+    if (!bit_reader_has (&reader, n_bits)) {                            \
         mm_dbg ("        cannot read address, need at least %u bytes (got %u)", \
-                required_size,                                          \
+                bit_reader_required (&reader, n_bits),                  \
                 parameter->parameter_len);                              \
         return;                                                         \
     }
 
-    /* Readability of digit mode and number mode (first 2 bits, i.e. first byte) */
-    PARAMETER_SIZE_CHECK (1);
+    if (mm_sms_part_get_number (sms_part)) {
+        mm_dbg ("        cannot read address; an address field was already read");
+        return;
+    }
+
+    bit_reader_init (&reader, parameter->parameter_value, parameter->parameter_len);
+
+    /* Readability of digit mode and number mode (first 2 bits, i.e. first
+     * byte), and of number type when given (next 3 bits) */
+    PARAMETER_SIZE_CHECK (2);
 
     /* Digit mode */
-    digit_mode = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 1);
-    OFFSETS_UPDATE (1);
-    g_assert (digit_mode <= 1);
+    digit_mode = bit_reader_read (&reader, 1);
     switch (digit_mode) {
     case DIGIT_MODE_DTMF:
         mm_dbg ("        digit mode: dtmf");
@@ -512,8 +686,7 @@ read_address (MMSmsPart *sms_part,
     }
 
     /* Number mode */
-    number_mode = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 1);
-    OFFSETS_UPDATE (1);
+    number_mode = bit_reader_read (&reader, 1);
     switch (number_mode) {
     case NUMBER_MODE_DIGIT:
         mm_dbg ("        number mode: digit");
@@ -527,9 +700,7 @@ read_address (MMSmsPart *sms_part,
 
     /* Number type */
     if (digit_mode == DIGIT_MODE_ASCII) {
-        /* No need for readability check, still in first byte always */
-        number_type = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 3);
-        OFFSETS_UPDATE (3);
+        number_type = bit_reader_read (&reader, 3);
         switch (number_type) {
         case NUMBER_TYPE_UNKNOWN:
             mm_dbg ("        number type: unknown");
@@ -558,10 +729,8 @@ read_address (MMSmsPart *sms_part,
 
     /* Numbering plan */
     if (digit_mode == DIGIT_MODE_ASCII && number_mode == NUMBER_MODE_DIGIT) {
-        /* Readability of numbering plan; may go to second byte */
-        PARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + 4) / 8));
-        numbering_plan = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 4);
-        OFFSETS_UPDATE (4);
+        PARAMETER_SIZE_CHECK (4);
+        numbering_plan = bit_reader_read (&reader, 4);
         switch (numbering_plan) {
         case NUMBERING_PLAN_UNKNOWN:
             mm_dbg ("        numbering plan: unknown");
@@ -582,66 +751,52 @@ read_address (MMSmsPart *sms_part,
             mm_dbg ("        numbering plan unknown (%u)", numbering_plan);
             break;
         }
-    } else
-        numbering_plan = 0xFF;
+    }
 
-    /* Readability of num_fields; will go to third byte (((bit_offset + 8) / 8) == 1) */
-    PARAMETER_SIZE_CHECK (byte_offset + 2);
-    num_fields = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 8);
-    OFFSETS_UPDATE (8);
+    PARAMETER_SIZE_CHECK (8);
+    num_fields = bit_reader_read (&reader, 8);
     mm_dbg ("        num fields: %u", num_fields);
 
-    /* Address string */
+    /* Address string, unpacked straight into the string we give to the part */
 
     if (digit_mode == DIGIT_MODE_DTMF) {
         /* DTMF */
-        PARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 4)) / 8));
+        PARAMETER_SIZE_CHECK (num_fields * 4);
         number = g_malloc (num_fields + 1);
-        for (i = 0; i < num_fields; i++) {
-            number[i] = dtmf_to_ascii (read_bits (&parameter->parameter_value[byte_offset], bit_offset, 4));
-            OFFSETS_UPDATE (4);
-        }
+        bit_reader_read_fields (&reader, 4, num_fields, (guint8 *)number);
+        for (i = 0; i < num_fields; i++)
+            number[i] = dtmf_to_ascii (number[i]);
         number[i] = '\0';
-    } else if (number_mode == NUMBER_MODE_DIGIT) {
-        /* ASCII
+    } else if (number_mode == NUMBER_MODE_DIGIT ||
+               number_type == DATA_NETWORK_ADDRESS_TYPE_INTERNET_EMAIL_ADDRESS) {
+        /* ASCII, or Internet e-mail address (ASCII)
          * TODO: should we expose numbering plan and number type? */
-        PARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 8)) / 8));
-        number = g_malloc (num_fields + 1);
-        for (i = 0; i < num_fields; i++) {
-            number[i] = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 8);
-            OFFSETS_UPDATE (8);
-        }
-        number[i] = '\0';
-    } else if (number_type == DATA_NETWORK_ADDRESS_TYPE_INTERNET_EMAIL_ADDRESS) {
-        /* Internet e-mail address (ASCII) */
-        PARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 8)) / 8));
+        PARAMETER_SIZE_CHECK (num_fields * 8);
         number = g_malloc (num_fields + 1);
-        for (i = 0; i < num_fields; i++) {
-            number[i] = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 8);
-            OFFSETS_UPDATE (8);
-        }
-        number[i] = '\0';
+        bit_reader_read_fields (&reader, 8, num_fields, (guint8 *)number);
+        number[num_fields] = '\0';
     } else if (number_type == DATA_NETWORK_ADDRESS_TYPE_INTERNET_PROTOCOL) {
-        GString *str;
-
         /* Binary data network address (most significant first)
          * For now, just print the hex string (e.g. FF:01...) */
-        PARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 8)) / 8));
-        str = g_string_sized_new (num_fields * 2);
+        PARAMETER_SIZE_CHECK (num_fields * 8);
+        number = g_malloc (num_fields * 2 + 1);
+        bit_reader_read_fields (&reader, 8, num_fields, (guint8 *)&number[num_fields]);
+        /* Expanding in place from the start never overwrites a byte not
+         * yet expanded */
         for (i = 0; i < num_fields; i++) {
-            g_string_append_printf (str, "%.2X", read_bits (&parameter->parameter_value[byte_offset], bit_offset, 8));
-            OFFSETS_UPDATE (8);
+            guint8 byte = (guint8) number[num_fields + i];
+
+            number[2 * i]     = hex_digits[byte >> 4];
+            number[2 * i + 1] = hex_digits[byte & 0x0F];
         }
-        number = g_string_free (str, FALSE);
+        number[2 * num_fields] = '\0';
     } else
         mm_dbg ("        data network address number type unknown (%u)", number_type);
 
     mm_dbg ("        address: %s", number);
 
-    mm_sms_part_set_number (sms_part, number);
-    g_free (number);
+    mm_sms_part_take_number (sms_part, number);
 
-#undef OFFSETS_UPDATE
 #undef PARAMETER_SIZE_CHECK
 }
 
@@ -659,7 +814,7 @@ read_bearer_reply_option (MMSmsPart *sms_part,
         return;
     }
 
-    sequence = read_bits (&parameter->parameter_value[0], 0, 6);
+    sequence = parameter->parameter_value[0] >> 2;
     mm_dbg ("        sequence: %u", sequence);
 
     mm_sms_part_set_message_reference (sms_part, sequence);
@@ -674,7 +829,7 @@ read_cause_codes (MMSmsPart *sms_part,
     guint8 cause_code;
     MMSmsDeliveryState delivery_state;
 
-    g_assert (parameter->parameter_id == PARAMETER_ID_BEARER_REPLY_OPTION);
+    g_assert (parameter->parameter_id == PARAMETER_ID_CAUSE_CODES);
 
     if (parameter->parameter_len != 1 && parameter->parameter_len != 2) {
         mm_dbg ("        invalid cause codes length found (%u): ignoring",
@@ -682,10 +837,10 @@ read_cause_codes (MMSmsPart *sms_part,
         return;
     }
 
-    sequence = read_bits (&parameter->parameter_value[0], 0, 6);
+    sequence = parameter->parameter_value[0] >> 2;
     mm_dbg ("        sequence: %u", sequence);
 
-    error_class = read_bits (&parameter->parameter_value[0], 6, 2);
+    error_class = parameter->parameter_value[0] & 0x03;
     mm_dbg ("        error class: %u", error_class);
 
     if (error_class != ERROR_CLASS_NO_ERROR) {
@@ -710,6 +865,16 @@ static void
 read_bearer_data_message_identifier (MMSmsPart *sms_part,
                                      const struct Parameter *subparameter)
 {
+    static const MMSmsPduType pdu_types[] = {
+        [TELESERVICE_MESSAGE_TYPE_UNKNOWN]                  = MM_SMS_PDU_TYPE_UNKNOWN,
+        [TELESERVICE_MESSAGE_TYPE_DELIVER]                  = MM_SMS_PDU_TYPE_CDMA_DELIVER,
+        [TELESERVICE_MESSAGE_TYPE_SUBMIT]                   = MM_SMS_PDU_TYPE_CDMA_SUBMIT,
+        [TELESERVICE_MESSAGE_TYPE_CANCELLATION]             = MM_SMS_PDU_TYPE_CDMA_CANCELLATION,
+        [TELESERVICE_MESSAGE_TYPE_DELIVERY_ACKNOWLEDGEMENT] = MM_SMS_PDU_TYPE_CDMA_DELIVERY_ACKNOWLEDGEMENT,
+        [TELESERVICE_MESSAGE_TYPE_USER_ACKNOWLEDGEMENT]     = MM_SMS_PDU_TYPE_CDMA_USER_ACKNOWLEDGEMENT,
+        [TELESERVICE_MESSAGE_TYPE_READ_ACKNOWLEDGEMENT]     = MM_SMS_PDU_TYPE_CDMA_READ_ACKNOWLEDGEMENT,
+    };
+    BitReader reader;
     guint8 message_type;
     guint16 message_id;
     guint8 header_ind;
@@ -722,46 +887,22 @@ read_bearer_data_message_identifier (MMSmsPart *sms_part,
         return;
     }
 
-    message_type = read_bits (&subparameter->parameter_value[0], 0, 4);
-    switch (message_type) {
-    case TELESERVICE_MESSAGE_TYPE_UNKNOWN:
-        mm_dbg ("            message type: unknown");
-        break;
-    case TELESERVICE_MESSAGE_TYPE_DELIVER:
-        mm_dbg ("            message type: deliver");
-        mm_sms_part_set_pdu_type (sms_part, MM_SMS_PDU_TYPE_CDMA_DELIVER);
-        break;
-    case TELESERVICE_MESSAGE_TYPE_SUBMIT:
-        mm_dbg ("            message type: submit");
-        mm_sms_part_set_pdu_type (sms_part, MM_SMS_PDU_TYPE_CDMA_SUBMIT);
-        break;
-    case TELESERVICE_MESSAGE_TYPE_CANCELLATION:
-        mm_dbg ("            message type: cancellation");
-        mm_sms_part_set_pdu_type (sms_part, MM_SMS_PDU_TYPE_CDMA_CANCELLATION);
-        break;
-    case TELESERVICE_MESSAGE_TYPE_DELIVERY_ACKNOWLEDGEMENT:
-        mm_dbg ("            message type: delivery acknowledgement");
-        mm_sms_part_set_pdu_type (sms_part, MM_SMS_PDU_TYPE_CDMA_DELIVERY_ACKNOWLEDGEMENT);
-        break;
-    case TELESERVICE_MESSAGE_TYPE_USER_ACKNOWLEDGEMENT:
-        mm_dbg ("            message type: user acknowledgement");
-        mm_sms_part_set_pdu_type (sms_part, MM_SMS_PDU_TYPE_CDMA_USER_ACKNOWLEDGEMENT);
-        break;
-    case TELESERVICE_MESSAGE_TYPE_READ_ACKNOWLEDGEMENT:
-        mm_dbg ("            message type: read acknowledgement");
-        mm_sms_part_set_pdu_type (sms_part, MM_SMS_PDU_TYPE_CDMA_READ_ACKNOWLEDGEMENT);
-        break;
-    default:
+    bit_reader_init (&reader, subparameter->parameter_value, subparameter->parameter_len);
+
+    message_type = bit_reader_read (&reader, 4);
+    if (message_type < G_N_ELEMENTS (pdu_types)) {
+        mm_dbg ("            message type: %s",
+                (message_type == TELESERVICE_MESSAGE_TYPE_UNKNOWN ?
+                 "unknown" : mm_sms_pdu_type_get_string (pdu_types[message_type])));
+        if (pdu_types[message_type] != MM_SMS_PDU_TYPE_UNKNOWN)
+            mm_sms_part_set_pdu_type (sms_part, pdu_types[message_type]);
+    } else
         mm_dbg ("            message type unknown (%u)", message_type);
-        break;
-    }
 
-    message_id = ((read_bits (&subparameter->parameter_value[0], 4, 8) << 8) |
-                  (read_bits (&subparameter->parameter_value[1], 4, 8)));
-    message_id = GUINT16_FROM_BE (message_id);
+    message_id = bit_reader_read (&reader, 16);
     mm_dbg ("            message id: %u", (guint) message_id);
 
-    header_ind = read_bits (&subparameter->parameter_value[2], 4, 1);
+    header_ind = bit_reader_read (&reader, 1);
     mm_dbg ("            header indicator: %u", header_ind);
 }
 
@@ -769,64 +910,52 @@ static void
 read_bearer_data_user_data (MMSmsPart *sms_part,
                             const struct Parameter *subparameter)
 {
+    BitReader reader;
     guint8 message_encoding;
     guint8 message_type = 0;
     guint8 num_fields;
-    guint byte_offset = 0;
-    guint bit_offset = 0;
-
-#define OFFSETS_UPDATE(n_bits) do { \
-        bit_offset += n_bits;       \
-        if (bit_offset >= 8) {      \
-            bit_offset-=8;          \
-            byte_offset++;          \
-        }                           \
-    } while (0)
-
-#define SUBPARAMETER_SIZE_CHECK(required_size)                             \
-    if (subparameter->parameter_len < required_size) {                  \
+
+#define SUBPARAMETER_SIZE_CHECK(n_bits)                                 \
+    if (!bit_reader_has (&reader, n_bits)) {                            \
         mm_dbg ("        cannot read user data, need at least %u bytes (got %u)", \
-                required_size,                                          \
+                bit_reader_required (&reader, n_bits),                  \
                 subparameter->parameter_len);                           \
         return;                                                         \
     }
 
     g_assert (subparameter->parameter_id == SUBPARAMETER_ID_USER_DATA);
 
+    bit_reader_init (&reader, subparameter->parameter_value, subparameter->parameter_len);
+
     /* Message encoding */
-    SUBPARAMETER_SIZE_CHECK (1);
-    message_encoding = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 5);
-    OFFSETS_UPDATE (5);
+    SUBPARAMETER_SIZE_CHECK (5);
+    message_encoding = bit_reader_read (&reader, 5);
     mm_dbg ("            message encoding: %s", encoding_to_string (message_encoding));
 
     /* Message type, only if extended protocol message */
     if (message_encoding == ENCODING_EXTENDED_PROTOCOL_MESSAGE) {
-        SUBPARAMETER_SIZE_CHECK (2);
-        message_type = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 8);
-        OFFSETS_UPDATE (8);
+        SUBPARAMETER_SIZE_CHECK (8);
+        message_type = bit_reader_read (&reader, 8);
         mm_dbg ("            message type: %u", message_type);
     }
 
     /* Number of fields */
-    SUBPARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + 8) / 8));
-    num_fields = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 8);
-    OFFSETS_UPDATE (8);
+    SUBPARAMETER_SIZE_CHECK (8);
+    num_fields = bit_reader_read (&reader, 8);
     mm_dbg ("            num fields: %u", num_fields);
 
-    /* Now, process actual text or data */
+    /* Now, process actual text or data. Fields are unpacked straight into
+     * the buffer given to the part, except for Latin and Unicode, which go
+     * through a stack buffer (the subparameter length is given in one byte,
+     * so they can't be longer than that) before being decoded to UTF-8 */
     switch (message_encoding) {
     case ENCODING_OCTET: {
         GByteArray *data;
-        guint i;
-
-        SUBPARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 8)) / 8));
 
+        SUBPARAMETER_SIZE_CHECK (num_fields * 8);
         data = g_byte_array_sized_new (num_fields);
         g_byte_array_set_size (data, num_fields);
-        for (i = 0; i < num_fields; i++) {
-            data->data[i] = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 8);
-            OFFSETS_UPDATE (8);
-        }
+        bit_reader_read_fields (&reader, 8, num_fields, data->data);
 
         mm_dbg ("            data: (%u bytes)", num_fields);
         mm_sms_part_take_data (sms_part, data);
@@ -835,74 +964,52 @@ read_bearer_data_user_data (MMSmsPart *sms_part,
 
     case ENCODING_ASCII_7BIT: {
         gchar *text;
-        guint i;
-
-        SUBPARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 7)) / 8));
 
+        SUBPARAMETER_SIZE_CHECK (num_fields * 7);
         text = g_malloc (num_fields + 1);
-        for (i = 0; i < num_fields; i++) {
-            text[i] = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 7);
-            OFFSETS_UPDATE (7);
-        }
-        text[i] = '\0';
+        bit_reader_read_fields (&reader, 7, num_fields, (guint8 *)text);
+        text[num_fields] = '\0';
 
         mm_dbg ("            text: '%s'", text);
         mm_sms_part_take_text (sms_part, text);
         break;
     }
 
-    case ENCODING_LATIN: {
-        gchar *latin;
-        gchar *text;
-        guint i;
-
-        SUBPARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 8)) / 8));
-
-        latin = g_malloc (num_fields + 1);
-        for (i = 0; i < num_fields; i++) {
-            latin[i] = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 8);
-            OFFSETS_UPDATE (8);
-        }
-        latin[i] = '\0';
-
-        text = g_convert (latin, -1, "UTF-8", "ISO−8859−1", NULL, NULL, NULL);
-        if (!text) {
-            mm_dbg ("            text/data: ignored (latin to UTF-8 conversion error)");
-        } else {
-            mm_dbg ("            text: '%s'", text);
-            mm_sms_part_take_text (sms_part, text);
-        }
-
-        g_free (latin);
-        break;
-    }
-
+    case ENCODING_LATIN:
     case ENCODING_UNICODE: {
-        gchar *utf16;
-        gchar *text;
-        guint i;
+        guint8 unpacked[G_MAXUINT8];
+        MMModemCharset charset;
         guint num_bytes;
+        gchar *text;
+        gsize text_len;
 
-        /* 2 bytes per field! */
-        num_bytes = num_fields * 2;
-
-        SUBPARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_bytes * 8)) / 8));
-
-        utf16 = g_malloc (num_bytes);
-        for (i = 0; i < num_bytes; i++) {
-            utf16[i] = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 8);
-            OFFSETS_UPDATE (8);
+        /* Unicode: 2 bytes per field! */
+        if (message_encoding == ENCODING_LATIN) {
+            charset = MM_MODEM_CHARSET_8859_1;
+            num_bytes = num_fields;
+        } else {
+            charset = MM_MODEM_CHARSET_UCS2;
+            num_bytes = num_fields * 2;
         }
 
-        text = g_convert (utf16, num_bytes, "UTF-8", "UCS-2BE", NULL, NULL, NULL);
-        if (!text) {
-            mm_dbg ("            text/data: ignored (UTF-16 to UTF-8 conversion error)");
-        } else {
-            mm_dbg ("            text: '%s'", text);
-            mm_sms_part_take_text (sms_part, text);
+        SUBPARAMETER_SIZE_CHECK (num_bytes * 8);
+        g_assert (num_bytes <= sizeof (unpacked));
+        bit_reader_read_fields (&reader, 8, num_bytes, unpacked);
+
+        /* Up to 2 UTF-8 bytes per Latin character, and up to 3 per UTF-16
+         * code unit (4 per surrogate pair) */
+        text = g_malloc ((charset == MM_MODEM_CHARSET_8859_1 ? 2 * num_bytes : 3 * num_fields) + 1);
+        text_len = mm_modem_charset_decode_into (charset, unpacked, num_bytes, text);
+        if (text_len == G_MAXSIZE) {
+            mm_dbg ("            text/data: ignored (%s to UTF-8 conversion error)",
+                    message_encoding == ENCODING_LATIN ? "latin" : "UTF-16");
+            g_free (text);
+            break;
         }
+        text[text_len] = '\0';
 
-        g_free (utf16);
+        mm_dbg ("            text: '%s'", text);
+        mm_sms_part_take_text (sms_part, text);
         break;
     }
 
@@ -910,10 +1017,51 @@ read_bearer_data_user_data (MMSmsPart *sms_part,
         mm_dbg ("            text/data: ignored (unsupported encoding)");
     }
 
-#undef OFFSETS_UPDATE
 #undef SUBPARAMETER_SIZE_CHECK
 }
 
+/*****************************************************************************/
+/* Parameter and subparameter dispatch
+ *
+ * Both tables are indexed by the (sub)parameter ID; those without a reader
+ * are just skipped. */
+
+typedef void (* ParameterReadFunc) (MMSmsPart *sms_part,
+                                    const struct Parameter *parameter);
+
+typedef struct {
+    const gchar       *name;
+    ParameterReadFunc  read;
+} ParameterHandler;
+
+/* 3GPP2 C.S0015-B, section 4.5, table 4.5-1 */
+static const ParameterHandler subparameter_handlers[] = {
+    [SUBPARAMETER_ID_MESSAGE_ID]                      = { "message ID",                      read_bearer_data_message_identifier },
+    [SUBPARAMETER_ID_USER_DATA]                       = { "user data",                       read_bearer_data_user_data },
+    [SUBPARAMETER_ID_USER_RESPONSE_CODE]              = { "user response code",              NULL },
+    [SUBPARAMETER_ID_MESSAGE_CENTER_TIME_STAMP]       = { "message center timestamp",        NULL },
+    [SUBPARAMETER_ID_VALIDITY_PERIOD_ABSOLUTE]        = { "absolute validity period",        NULL },
+    [SUBPARAMETER_ID_VALIDITY_PERIOD_RELATIVE]        = { "relative validity period",        NULL },
+    [SUBPARAMETER_ID_DEFERRED_DELIVERY_TIME_ABSOLUTE] = { "absolute deferred delivery time", NULL },
+    [SUBPARAMETER_ID_DEFERRED_DELIVERY_TIME_RELATIVE] = { "relative deferred delivery time", NULL },
+    [SUBPARAMETER_ID_PRIORITY_INDICATOR]              = { "priority indicator",              NULL },
+    [SUBPARAMETER_ID_PRIVACY_INDICATOR]               = { "privacy indicator",               NULL },
+    [SUBPARAMETER_ID_REPLY_OPTION]                    = { "reply option",                    NULL },
+    [SUBPARAMETER_ID_NUMBER_OF_MESSAGES]              = { "number of messages",              NULL },
+    [SUBPARAMETER_ID_ALERT_ON_MESSAGE_DELIVERY]       = { "alert on message delivery",       NULL },
+    [SUBPARAMETER_ID_LANGUAGE_INDICATOR]              = { "language indicator",              NULL },
+    [SUBPARAMETER_ID_CALL_BACK_NUMBER]                = { "call back number",                NULL },
+    [SUBPARAMETER_ID_MESSAGE_DISPLAY_MODE]            = { "message display mode",            NULL },
+    [SUBPARAMETER_ID_MULTIPLE_ENCODING_USER_DATA]     = { "multiple encoding user data",     NULL },
+    [SUBPARAMETER_ID_MESSAGE_DEPOSIT_INDEX]           = { "message deposit index",           NULL },
+    [SUBPARAMETER_ID_SERVICE_CATEGORY_PROGRAM_DATA]   = { "service category program data",   NULL },
+    [SUBPARAMETER_ID_SERVICE_CATEGORY_PROGRAM_RESULT] = { "service category program result", NULL },
+    [SUBPARAMETER_ID_MESSAGE_STATUS]                  = { "message status",                  NULL },
+    [SUBPARAMETER_ID_TP_FAILURE_CAUSE]                = { "TP failure cause",                NULL },
+    [SUBPARAMETER_ID_ENHANCED_VMN]                    = { "enhanced vmn",                    NULL },
+    [SUBPARAMETER_ID_ENHANCED_VMN_ACK]                = { "enhanced vmn ack",                NULL },
+};
+
 static void
 read_bearer_data (MMSmsPart *sms_part,
                   const struct Parameter *parameter)
@@ -931,6 +1079,7 @@ read_bearer_data (MMSmsPart *sms_part,
     offset = 0;
     while (offset < parameter->parameter_len) {
         const struct Parameter *subparameter;
+        const ParameterHandler *handler;
 
         PARAMETER_SIZE_CHECK (offset + 2);
         subparameter = (const struct Parameter *)&parameter->parameter_value[offset];
@@ -939,91 +1088,36 @@ read_bearer_data (MMSmsPart *sms_part,
         PARAMETER_SIZE_CHECK (offset + subparameter->parameter_len);
         offset += subparameter->parameter_len;
 
-        switch (subparameter->parameter_id) {
-        case SUBPARAMETER_ID_MESSAGE_ID:
-            mm_dbg ("        reading message ID...");
-            read_bearer_data_message_identifier (sms_part, subparameter);
-            break;
-        case SUBPARAMETER_ID_USER_DATA:
-            mm_dbg ("        reading user data...");
-            read_bearer_data_user_data (sms_part, subparameter);
-            break;
-        case SUBPARAMETER_ID_USER_RESPONSE_CODE:
-            mm_dbg ("        skipping user response code...");
-            break;
-        case SUBPARAMETER_ID_MESSAGE_CENTER_TIME_STAMP:
-            mm_dbg ("        skipping message center timestamp...");
-            break;
-        case SUBPARAMETER_ID_VALIDITY_PERIOD_ABSOLUTE:
-            mm_dbg ("        skipping absolute validity period...");
-            break;
-        case SUBPARAMETER_ID_VALIDITY_PERIOD_RELATIVE:
-            mm_dbg ("        skipping relative validity period...");
-            break;
-        case SUBPARAMETER_ID_DEFERRED_DELIVERY_TIME_ABSOLUTE:
-            mm_dbg ("        skipping absolute deferred delivery time...");
-            break;
-        case SUBPARAMETER_ID_DEFERRED_DELIVERY_TIME_RELATIVE:
-            mm_dbg ("        skipping relative deferred delivery time...");
-            break;
-        case SUBPARAMETER_ID_PRIORITY_INDICATOR:
-            mm_dbg ("        skipping priority indicator...");
-            break;
-        case SUBPARAMETER_ID_PRIVACY_INDICATOR:
-            mm_dbg ("        skipping privacy indicator...");
-            break;
-        case SUBPARAMETER_ID_REPLY_OPTION:
-            mm_dbg ("        skipping reply option...");
-            break;
-        case SUBPARAMETER_ID_NUMBER_OF_MESSAGES:
-            mm_dbg ("        skipping number of messages...");
-            break;
-        case SUBPARAMETER_ID_ALERT_ON_MESSAGE_DELIVERY:
-            mm_dbg ("        skipping alert on message delivery...");
-            break;
-        case SUBPARAMETER_ID_LANGUAGE_INDICATOR:
-            mm_dbg ("        skipping language indicator...");
-            break;
-        case SUBPARAMETER_ID_CALL_BACK_NUMBER:
-            mm_dbg ("        skipping call back number...");
-            break;
-        case SUBPARAMETER_ID_MESSAGE_DISPLAY_MODE:
-            mm_dbg ("        skipping message display mode...");
-            break;
-        case SUBPARAMETER_ID_MULTIPLE_ENCODING_USER_DATA:
-            mm_dbg ("        skipping multiple encoding user data...");
-            break;
-        case SUBPARAMETER_ID_MESSAGE_DEPOSIT_INDEX:
-            mm_dbg ("        skipping message deposit index...");
-            break;
-        case SUBPARAMETER_ID_SERVICE_CATEGORY_PROGRAM_DATA:
-            mm_dbg ("        skipping service category program data...");
-            break;
-        case SUBPARAMETER_ID_SERVICE_CATEGORY_PROGRAM_RESULT:
-            mm_dbg ("        skipping service category program result...");
-            break;
-        case SUBPARAMETER_ID_MESSAGE_STATUS:
-            mm_dbg ("        skipping message status...");
-            break;
-        case SUBPARAMETER_ID_TP_FAILURE_CAUSE:
-            mm_dbg ("        skipping TP failure case...");
-            break;
-        case SUBPARAMETER_ID_ENHANCED_VMN:
-            mm_dbg ("        skipping enhanced vmn...");
-            break;
-        case SUBPARAMETER_ID_ENHANCED_VMN_ACK:
-            mm_dbg ("        skipping enhanced vmn ack...");
-            break;
-        default:
+        if (subparameter->parameter_id >= G_N_ELEMENTS (subparameter_handlers)) {
             mm_dbg ("    unknown subparameter found: '%u' (ignoring)",
                     subparameter->parameter_id);
-            break;
+            continue;
         }
+
+        handler = &subparameter_handlers[subparameter->parameter_id];
+        if (handler->read) {
+            mm_dbg ("        reading %s...", handler->name);
+            handler->read (sms_part, subparameter);
+        } else
+            mm_dbg ("        skipping %s...", handler->name);
     }
 
 #undef PARAMETER_SIZE_CHECK
 }
 
+/* 3GPP2 C.S0015-B, section 3.4.3, table 3.4.3-1 */
+static const ParameterHandler parameter_handlers[] = {
+    [PARAMETER_ID_TELESERVICE_ID]         = { "teleservice ID",         read_teleservice_id },
+    [PARAMETER_ID_SERVICE_CATEGORY]       = { "service category",       read_service_category },
+    [PARAMETER_ID_ORIGINATING_ADDRESS]    = { "originating address",    read_address },
+    [PARAMETER_ID_ORIGINATING_SUBADDRESS] = { "originating subaddress", NULL },
+    [PARAMETER_ID_DESTINATION_ADDRESS]    = { "destination address",    read_address },
+    [PARAMETER_ID_DESTINATION_SUBADDRESS] = { "destination subaddress", NULL },
+    [PARAMETER_ID_BEARER_REPLY_OPTION]    = { "bearer reply option",    read_bearer_reply_option },
+    [PARAMETER_ID_CAUSE_CODES]            = { "cause codes",            read_cause_codes },
+    [PARAMETER_ID_BEARER_DATA]            = { "bearer data",            read_bearer_data },
+};
+
 MMSmsPart *
 mm_sms_part_cdma_new_from_binary_pdu (guint index,
                                       const guint8 *pdu,
@@ -1078,6 +1172,7 @@ mm_sms_part_cdma_new_from_binary_pdu (guint index,
     /* Now walk parameters one by one */
     while (offset < pdu_len) {
         const struct Parameter *parameter;
+        const ParameterHandler *handler;
 
         PDU_SIZE_CHECK (offset + 2, "cannot read parameter header");
         parameter = (const struct Parameter *)&pdu[offset];
@@ -1086,52 +1181,18 @@ mm_sms_part_cdma_new_from_binary_pdu (guint index,
         PDU_SIZE_CHECK (offset + parameter->parameter_len, "cannot read parameter value");
         offset += parameter->parameter_len;
 
-        switch (parameter->parameter_id) {
-        case PARAMETER_ID_TELESERVICE_ID:
-            mm_dbg ("    reading teleservice ID...");
-            read_teleservice_id (sms_part, parameter);
-            break;
-        case PARAMETER_ID_SERVICE_CATEGORY:
-            mm_dbg ("    reading service category...");
-            read_service_category (sms_part, parameter);
-            break;
-        case PARAMETER_ID_ORIGINATING_ADDRESS:
-            mm_dbg ("    reading originating address...");
-            if (mm_sms_part_get_number (sms_part))
-                mm_dbg ("        cannot read originating address; an address field was already read");
-            else
-                read_address (sms_part, parameter);
-            break;
-        case PARAMETER_ID_ORIGINATING_SUBADDRESS:
-            mm_dbg ("    skipping originating subaddress...");
-            break;
-        case PARAMETER_ID_DESTINATION_ADDRESS:
-            mm_dbg ("    reading destination address...");
-            if (mm_sms_part_get_number (sms_part))
-                mm_dbg ("        cannot read destination address; an address field was already read");
-            else
-                read_address (sms_part, parameter);
-            break;
-        case PARAMETER_ID_DESTINATION_SUBADDRESS:
-            mm_dbg ("    skipping destination subaddress...");
-            break;
-        case PARAMETER_ID_BEARER_REPLY_OPTION:
-            mm_dbg ("    reading bearer reply option...");
-            read_bearer_reply_option (sms_part, parameter);
-            break;
-        case PARAMETER_ID_CAUSE_CODES:
-            mm_dbg ("    reading cause codes...");
-            read_cause_codes (sms_part, parameter);
-            break;
-        case PARAMETER_ID_BEARER_DATA:
-            mm_dbg ("    reading bearer data...");
-            read_bearer_data (sms_part, parameter);
-            break;
-        default:
+        if (parameter->parameter_id >= G_N_ELEMENTS (parameter_handlers)) {
             mm_dbg ("    unknown parameter found: '%u' (ignoring)",
                     parameter->parameter_id);
-            break;
+            continue;
         }
+
+        handler = &parameter_handlers[parameter->parameter_id];
+        if (handler->read) {
+            mm_dbg ("    reading %s...", handler->name);
+            handler->read (sms_part, parameter);
+        } else
+            mm_dbg ("    skipping %s...", handler->name);
     }
 
     /* Check mandatory parameters */
@@ -1155,43 +1216,6 @@ mm_sms_part_cdma_new_from_binary_pdu (guint index,
     return sms_part;
 }
 
-/*****************************************************************************/
-/* Write bits; o_bits < 8; n_bits <= 8
- *
- * Byte 0            Byte 1
- * [7|6|5|4|3|2|1|0] [7|6|5|4|3|2|1|0]
- *
- * o_bits+n_bits <= 16
- *
- * NOTE! The bits being set should be 0 initially.
- */
-static void
-write_bits (guint8 *bytes,
-            guint8 o_bits,
-            guint8 n_bits,
-            guint8 bits)
-{
-    guint8 bits_in_first;
-    guint8 bits_in_second;
-
-    g_assert (o_bits < 8);
-    g_assert (n_bits <= 8);
-    g_assert (o_bits + n_bits <= 16);
-
-    /* Write only in the first byte */
-    if (o_bits + n_bits <= 8) {
-        bytes[0] |= (bits & ((1 << n_bits) - 1)) << (8 - o_bits - n_bits);
-        return;
-    }
-
-    /* Write (8 - o_bits) in the first byte and (n_bits - (8 - o_bits)) in the second byte */
-    bits_in_first = 8 - o_bits;
-    bits_in_second = n_bits - bits_in_first;
-
-    write_bits (&bytes[0], o_bits, bits_in_first, (bits >> bits_in_second));
-    write_bits (&bytes[1], 0, bits_in_second, bits);
-}
-
 /*****************************************************************************/
 
 static guint8
@@ -1250,40 +1274,28 @@ write_destination_address (MMSmsPart *part,
                            guint *absolute_offset,
                            GError **error)
 {
+    BitWriter writer;
     const gchar *number;
-    guint bit_offset;
-    guint byte_offset;
     guint n_digits;
+    guint len;
     guint i;
 
     mm_dbg ("    writing destination address...");
 
-#define OFFSETS_UPDATE(n_bits) do { \
-        bit_offset += n_bits;       \
-        if (bit_offset >= 8) {      \
-            bit_offset-=8;          \
-            byte_offset++;          \
-        }                           \
-    } while (0)
-
     number = mm_sms_part_get_number (part);
     n_digits = strlen (number);
 
     pdu[0] = PARAMETER_ID_DESTINATION_ADDRESS;
     /* Write parameter length at the end */
-
-    byte_offset = 2;
-    bit_offset = 0;
+    bit_writer_init (&writer, &pdu[2]);
 
     /* Digit mode: DTMF always */
     mm_dbg ("        digit mode: dtmf");
-    write_bits (&pdu[byte_offset], bit_offset, 1, DIGIT_MODE_DTMF);
-    OFFSETS_UPDATE (1);
+    bit_writer_write (&writer, 1, DIGIT_MODE_DTMF);
 
     /* Number mode: DIGIT always */
     mm_dbg ("        number mode: digit");
-    write_bits (&pdu[byte_offset], bit_offset, 1, NUMBER_MODE_DIGIT);
-    OFFSETS_UPDATE (1);
+    bit_writer_write (&writer, 1, NUMBER_MODE_DIGIT);
 
     /* Number type and numbering plan only needed in ASCII digit mode, so skip */
 
@@ -1297,8 +1309,7 @@ write_destination_address (MMSmsPart *part,
         return FALSE;
     }
     mm_dbg ("        num fields: %u", n_digits);
-    write_bits (&pdu[byte_offset], bit_offset, 8, n_digits);
-    OFFSETS_UPDATE (8);
+    bit_writer_write (&writer, 8, n_digits);
 
     /* Actual DTMF encoded number */
     mm_dbg ("        address: %s", number);
@@ -1314,23 +1325,20 @@ write_destination_address (MMSmsPart *part,
                          number[i]);
             return FALSE;
         }
-        write_bits (&pdu[byte_offset], bit_offset, 4, dtmf);
-        OFFSETS_UPDATE (4);
+        bit_writer_write (&writer, 4, dtmf);
     }
 
-#undef OFFSETS_UPDATE
-
-    /* Write parameter length (remove header length to offset) */
-    byte_offset += !!bit_offset - 2;
-    if (byte_offset > 256) {
+    /* Write parameter length */
+    len = bit_writer_get_len (&writer);
+    if (len > 256) {
         g_set_error (error,
                      MM_CORE_ERROR,
                      MM_CORE_ERROR_UNSUPPORTED,
                      "Number too long (max 256 bytes, %u given)",
-                     byte_offset);
+                     len);
         return FALSE;
     }
-    pdu[1] = byte_offset;
+    pdu[1] = len;
 
     *absolute_offset += (2 + pdu[1]);
     return TRUE;
@@ -1348,7 +1356,7 @@ write_bearer_data_message_identifier (MMSmsPart *part,
     mm_dbg ("        writing message identifier: submit");
 
     /* Message type */
-    write_bits (&pdu[2], 0, 4, TELESERVICE_MESSAGE_TYPE_SUBMIT);
+    pdu[2] |= TELESERVICE_MESSAGE_TYPE_SUBMIT << 4;
 
     /* Skip adding a message id; assume it's filled in by device */
 
@@ -1365,24 +1373,15 @@ decide_best_encoding (const gchar *text,
                       guint *num_bits_per_field,
                       Encoding *encoding)
 {
-    guint ascii_unsupported = 0;
     guint i;
     guint len;
 
     len = strlen (text);
 
-    /* Check if we can do ASCII-7 */
-    for (i = 0; i < len; i++) {
-        if (text[i] & 0x80) {
-            ascii_unsupported++;
-            break;
-        }
-    }
-
-    /* If ASCII-7 already supported, done we are */
-    if (!ascii_unsupported) {
-        *out = g_byte_array_sized_new (len);
-        g_byte_array_append (*out, (const guint8 *)text, len);
+    /* If ASCII-7 supported, the text is written as is, done we are */
+    for (i = 0; i < len && !(text[i] & 0x80); i++);
+    if (i == len) {
+        *out = NULL;
         *num_fields = len;
         *num_bits_per_field = 7;
         *encoding = ENCODING_ASCII_7BIT;
@@ -1419,28 +1418,19 @@ write_bearer_data_user_data (MMSmsPart *part,
                              guint *parameter_offset,
                              GError **error)
 {
+    BitWriter writer;
     const gchar *text;
     const GByteArray *data;
-    guint bit_offset = 0;
-    guint byte_offset = 0;
     guint num_fields;
     guint num_bits_per_field;
-    guint i;
+    guint len;
     Encoding encoding;
     GByteArray *converted = NULL;
-    const GByteArray *aux;
-    guint num_bits_per_iter;
+    const guint8 *fields;
+    guint fields_len;
 
     mm_dbg ("        writing user data...");
 
-#define OFFSETS_UPDATE(n_bits) do { \
-        bit_offset += n_bits;       \
-        if (bit_offset >= 8) {      \
-            bit_offset-=8;          \
-            byte_offset++;          \
-        }                           \
-    } while (0)
-
     text = mm_sms_part_get_text (part);
     data = mm_sms_part_get_data (part);
     g_assert (text || data);
@@ -1448,8 +1438,7 @@ write_bearer_data_user_data (MMSmsPart *part,
 
     pdu[0] = SUBPARAMETER_ID_USER_DATA;
     /* Write parameter length at the end */
-    byte_offset = 2;
-    bit_offset = 0;
+    bit_writer_init (&writer, &pdu[2]);
 
     /* Text or Data */
     if (text) {
@@ -1458,9 +1447,16 @@ write_bearer_data_user_data (MMSmsPart *part,
                               &num_fields,
                               &num_bits_per_field,
                               &encoding);
-        aux = (const GByteArray *)converted;
+        if (converted) {
+            fields = converted->data;
+            fields_len = converted->len;
+        } else {
+            fields = (const guint8 *)text;
+            fields_len = num_fields;
+        }
     } else {
-        aux = data;
+        fields = data->data;
+        fields_len = data->len;
         num_fields = data->len;
         num_bits_per_field = 8;
         encoding = ENCODING_OCTET;
@@ -1468,8 +1464,7 @@ write_bearer_data_user_data (MMSmsPart *part,
 
     /* Message encoding*/
     mm_dbg ("            message encoding: %s", encoding_to_string (encoding));
-    write_bits (&pdu[byte_offset], bit_offset, 5, encoding);
-    OFFSETS_UPDATE (5);
+    bit_writer_write (&writer, 5, encoding);
 
     /* Number of fields */
     if (num_fields > 256) {
@@ -1483,37 +1478,33 @@ write_bearer_data_user_data (MMSmsPart *part,
         return FALSE;
     }
     mm_dbg ("            num fields: %u", num_fields);
-    write_bits (&pdu[byte_offset], bit_offset, 8, num_fields);
-    OFFSETS_UPDATE (8);
+    bit_writer_write (&writer, 8, num_fields);
 
-    /* For ASCII-7, write 7 bits in each iteration; for the remaining ones
-     * go byte per byte */
+    /* For ASCII-7, write 7 bits per field; for the remaining ones go byte
+     * per byte */
     if (text)
         mm_dbg ("            text: '%s'", text);
     else
         mm_dbg ("            data: (%u bytes)", num_fields);
-    num_bits_per_iter = num_bits_per_field < 8 ? num_bits_per_field : 8;
-    for (i = 0; i < aux->len; i++) {
-        write_bits (&pdu[byte_offset], bit_offset, num_bits_per_iter, aux->data[i]);
-        OFFSETS_UPDATE (num_bits_per_iter);
-    }
+    bit_writer_write_fields (&writer,
+                             num_bits_per_field < 8 ? num_bits_per_field : 8,
+                             fields_len,
+                             fields);
 
     if (converted)
         g_byte_array_unref (converted);
 
-#undef OFFSETS_UPDATE
-
-    /* Write subparameter length (remove header length to offset) */
-    byte_offset += !!bit_offset - 2;
-    if (byte_offset > 256) {
+    /* Write subparameter length */
+    len = bit_writer_get_len (&writer);
+    if (len > 256) {
         g_set_error (error,
                      MM_CORE_ERROR,
                      MM_CORE_ERROR_UNSUPPORTED,
                      "Data or Text too long (max 256 bytes, %u given)",
-                     byte_offset);
+                     len);
         return FALSE;
     }
-    pdu[1] = byte_offset;
+    pdu[1] = len;
 
     *parameter_offset += (2 + pdu[1]);
     return TRUE;
@@ -52,16 +52,31 @@ struct _MMSmsPart {
     /* CDMA specific */
     MMSmsCdmaTeleserviceId cdma_teleservice_id;
     MMSmsCdmaServiceCategory cdma_service_category;
+
+    /* Single block holding the strings given in mm_sms_part_set_strings() */
+    gchar *strings;
+    gsize strings_len;
 };
 
+/* Strings within the packed block are not freed on their own */
+static void
+part_release_str (MMSmsPart *self,
+                  gchar *str)
+{
+    if (self->strings && str >= self->strings && str < self->strings + self->strings_len)
+        return;
+    g_free (str);
+}
+
 void
 mm_sms_part_free (MMSmsPart *self)
 {
-    g_free (self->discharge_timestamp);
-    g_free (self->timestamp);
-    g_free (self->smsc);
-    g_free (self->number);
-    g_free (self->text);
+    part_release_str (self, self->discharge_timestamp);
+    part_release_str (self, self->timestamp);
+    part_release_str (self, self->smsc);
+    part_release_str (self, self->number);
+    part_release_str (self, self->text);
+    g_free (self->strings);
     if (self->data)
         g_byte_array_unref (self->data);
     g_slice_free (MMSmsPart, self);
@@ -87,7 +102,7 @@ mm_sms_part_free (MMSmsPart *self)
     mm_sms_part_set_##name (MMSmsPart *self,     \
                             const gchar *value)  \
     {                                            \
-        g_free (self->name);                     \
+        part_release_str (self, self->name);     \
         self->name = g_strdup (value);           \
     }                                            \
                                                  \
@@ -95,7 +110,7 @@ mm_sms_part_free (MMSmsPart *self)
     mm_sms_part_take_##name (MMSmsPart *self,    \
                              gchar *value)       \
     {                                            \
-        g_free (self->name);                     \
+        part_release_str (self, self->name);     \
         self->name = value;                      \
     }
 
@@ -166,6 +181,70 @@ mm_sms_part_should_concat (MMSmsPart *self)
     return self->should_concat;
 }
 
+static gchar *
+strings_append (gchar **pos,
+                const gchar *str)
+{
+    gchar *start;
+    gsize len;
+
+    if (!str)
+        return NULL;
+
+    start = *pos;
+    len = strlen (str) + 1;
+    memcpy (start, str, len);
+    *pos += len;
+    return start;
+}
+
+void
+mm_sms_part_set_strings (MMSmsPart *self,
+                         const gchar *smsc,
+                         const gchar *number,
+                         const gchar *timestamp,
+                         const gchar *discharge_timestamp,
+                         const gchar *text)
+{
+    gchar *strings;
+    gchar *pos;
+    gsize len = 0;
+    gchar *new_smsc;
+    gchar *new_number;
+    gchar *new_timestamp;
+    gchar *new_discharge_timestamp;
+    gchar *new_text;
+
+    len += smsc ? strlen (smsc) + 1 : 0;
+    len += number ? strlen (number) + 1 : 0;
+    len += timestamp ? strlen (timestamp) + 1 : 0;
+    len += discharge_timestamp ? strlen (discharge_timestamp) + 1 : 0;
+    len += text ? strlen (text) + 1 : 0;
+
+    /* Copy first, as the new strings may be the current ones */
+    strings = pos = (len ? g_malloc (len) : NULL);
+    new_smsc = strings_append (&pos, smsc);
+    new_number = strings_append (&pos, number);
+    new_timestamp = strings_append (&pos, timestamp);
+    new_discharge_timestamp = strings_append (&pos, discharge_timestamp);
+    new_text = strings_append (&pos, text);
+
+    part_release_str (self, self->smsc);
+    part_release_str (self, self->number);
+    part_release_str (self, self->timestamp);
+    part_release_str (self, self->discharge_timestamp);
+    part_release_str (self, self->text);
+    g_free (self->strings);
+
+    self->strings = strings;
+    self->strings_len = len;
+    self->smsc = new_smsc;
+    self->number = new_number;
+    self->timestamp = new_timestamp;
+    self->discharge_timestamp = new_discharge_timestamp;
+    self->text = new_text;
+}
+
 PART_GET_FUNC (MMSmsCdmaTeleserviceId, cdma_teleservice_id)
 PART_SET_FUNC (MMSmsCdmaTeleserviceId, cdma_teleservice_id)
 PART_GET_FUNC (MMSmsCdmaServiceCategory, cdma_service_category)
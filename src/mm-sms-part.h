@@ -81,6 +81,15 @@ void              mm_sms_part_set_text               (MMSmsPart *part,
 void              mm_sms_part_take_text              (MMSmsPart *part,
                                                       gchar *text);
 
+/* Sets all the string fields at once, in a single allocation; NULL ones are
+ * unset */
+void              mm_sms_part_set_strings            (MMSmsPart *part,
+                                                      const gchar *smsc,
+                                                      const gchar *number,
+                                                      const gchar *timestamp,
+                                                      const gchar *discharge_timestamp,
+                                                      const gchar *text);
+
 const GByteArray *mm_sms_part_get_data               (MMSmsPart *part);
 void              mm_sms_part_set_data               (MMSmsPart *part,
                                                       GByteArray *data);
@@ -0,0 +1,257 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <string.h>
+
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-throughput.h"
+
+struct _MMThroughput {
+    guint    interval;
+    /* Last counters */
+    gboolean has_sample;
+    gint64   time;
+    guint64  rx_bytes;
+    guint64  tx_bytes;
+    /* Rates */
+    gboolean has_rate;
+    guint64  rx_rate;
+    guint64  tx_rate;
+    guint64  rx_peak;
+    guint64  tx_peak;
+    gdouble  rx_average;
+    gdouble  tx_average;
+    /* Ring of the last rates */
+    guint32  rx_history[MM_THROUGHPUT_HISTORY_SIZE];
+    guint32  tx_history[MM_THROUGHPUT_HISTORY_SIZE];
+    guint    history_first;
+    guint    history_len;
+};
+
+/*****************************************************************************/
+
+static guint64
+compute_rate (guint64 bytes,
+              gint64  elapsed)
+{
+    return (guint64) (((gdouble) bytes * G_USEC_PER_SEC) / elapsed);
+}
+
+static void
+update_average (gdouble *average,
+                guint64  rate,
+                gdouble  alpha)
+{
+    *average += alpha * ((gdouble) rate - *average);
+}
+
+static void
+history_add (MMThroughput *self,
+             guint64       rx_rate,
+             guint64       tx_rate)
+{
+    guint i;
+
+    if (self->history_len < MM_THROUGHPUT_HISTORY_SIZE) {
+        i = (self->history_first + self->history_len) % MM_THROUGHPUT_HISTORY_SIZE;
+        self->history_len++;
+    } else {
+        /* Full, overwrite the oldest one */
+        i = self->history_first;
+        self->history_first = (self->history_first + 1) % MM_THROUGHPUT_HISTORY_SIZE;
+    }
+
+    self->rx_history[i] = (guint32) MIN (rx_rate, G_MAXUINT32);
+    self->tx_history[i] = (guint32) MIN (tx_rate, G_MAXUINT32);
+}
+
+gboolean
+mm_throughput_add_sample (MMThroughput *self,
+                          gint64        time_usec,
+                          guint64       rx_bytes,
+                          guint64       tx_bytes)
+{
+    gint64  elapsed;
+    gdouble alpha;
+
+    if (!self->has_sample ||
+        rx_bytes < self->rx_bytes ||
+        tx_bytes < self->tx_bytes) {
+        self->has_sample = TRUE;
+        self->time = time_usec;
+        self->rx_bytes = rx_bytes;
+        self->tx_bytes = tx_bytes;
+        return FALSE;
+    }
+
+    /* Counters reported out of the periodic requests (e.g. along with link
+     * notifications) are too close to the previous sample, keep it */
+    elapsed = time_usec - self->time;
+    if (elapsed <= 0 || elapsed < ((gint64) self->interval * G_USEC_PER_SEC) / 2)
+        return FALSE;
+
+    /* Rates over the actual elapsed time, which may not be the exact interval */
+    self->rx_rate = compute_rate (rx_bytes - self->rx_bytes, elapsed);
+    self->tx_rate = compute_rate (tx_bytes - self->tx_bytes, elapsed);
+    self->time = time_usec;
+    self->rx_bytes = rx_bytes;
+    self->tx_bytes = tx_bytes;
+
+    self->rx_peak = MAX (self->rx_peak, self->rx_rate);
+    self->tx_peak = MAX (self->tx_peak, self->tx_rate);
+
+    /* Weight from the elapsed time, a first order approximation of
+     * 1 - exp (-elapsed / tau), so the time constant holds whatever the interval */
+    if (!self->has_rate) {
+        self->rx_average = (gdouble) self->rx_rate;
+        self->tx_average = (gdouble) self->tx_rate;
+    } else {
+        alpha = ((gdouble) elapsed) / ((gdouble) elapsed + (gdouble) MM_THROUGHPUT_AVERAGE_TAU_SEC * G_USEC_PER_SEC);
+        update_average (&self->rx_average, self->rx_rate, alpha);
+        update_average (&self->tx_average, self->tx_rate, alpha);
+    }
+    self->has_rate = TRUE;
+
+    history_add (self, self->rx_rate, self->tx_rate);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+guint
+mm_throughput_get_interval (MMThroughput *self)
+{
+    return self->interval;
+}
+
+guint64
+mm_throughput_get_rx_rate (MMThroughput *self)
+{
+    return self->rx_rate;
+}
+
+guint64
+mm_throughput_get_tx_rate (MMThroughput *self)
+{
+    return self->tx_rate;
+}
+
+guint64
+mm_throughput_get_rx_peak (MMThroughput *self)
+{
+    return self->rx_peak;
+}
+
+guint64
+mm_throughput_get_tx_peak (MMThroughput *self)
+{
+    return self->tx_peak;
+}
+
+guint64
+mm_throughput_get_rx_average (MMThroughput *self)
+{
+    return (guint64) (self->rx_average + 0.5);
+}
+
+guint64
+mm_throughput_get_tx_average (MMThroughput *self)
+{
+    return (guint64) (self->tx_average + 0.5);
+}
+
+guint
+mm_throughput_get_n_history (MMThroughput *self)
+{
+    return self->history_len;
+}
+
+void
+mm_throughput_get_history (MMThroughput *self,
+                           guint         i,
+                           guint32      *rx_rate,
+                           guint32      *tx_rate)
+{
+    g_assert (i < self->history_len);
+
+    i = (self->history_first + i) % MM_THROUGHPUT_HISTORY_SIZE;
+    if (rx_rate)
+        *rx_rate = self->rx_history[i];
+    if (tx_rate)
+        *tx_rate = self->tx_history[i];
+}
+
+/*****************************************************************************/
+
+GVariant *
+mm_throughput_get_dictionary (MMThroughput *self)
+{
+    MMBearerThroughput *throughput;
+    GVariant           *dictionary;
+    guint               i;
+
+    if (!self->has_rate)
+        return NULL;
+
+    throughput = mm_bearer_throughput_new ();
+    mm_bearer_throughput_set_interval   (throughput, self->interval);
+    mm_bearer_throughput_set_rx_rate    (throughput, mm_throughput_get_rx_rate    (self));
+    mm_bearer_throughput_set_tx_rate    (throughput, mm_throughput_get_tx_rate    (self));
+    mm_bearer_throughput_set_rx_peak    (throughput, mm_throughput_get_rx_peak    (self));
+    mm_bearer_throughput_set_tx_peak    (throughput, mm_throughput_get_tx_peak    (self));
+    mm_bearer_throughput_set_rx_average (throughput, mm_throughput_get_rx_average (self));
+    mm_bearer_throughput_set_tx_average (throughput, mm_throughput_get_tx_average (self));
+    for (i = 0; i < self->history_len; i++) {
+        guint32 rx_rate;
+        guint32 tx_rate;
+
+        mm_throughput_get_history (self, i, &rx_rate, &tx_rate);
+        mm_bearer_throughput_add_history (throughput, rx_rate, tx_rate);
+    }
+
+    dictionary = mm_bearer_throughput_get_dictionary (throughput);
+    g_object_unref (throughput);
+    return dictionary;
+}
+
+/*****************************************************************************/
+
+void
+mm_throughput_reset (MMThroughput *self)
+{
+    guint interval;
+
+    interval = self->interval;
+    memset (self, 0, sizeof (*self));
+    self->interval = interval;
+}
+
+MMThroughput *
+mm_throughput_new (guint interval)
+{
+    MMThroughput *self;
+
+    self = g_slice_new0 (MMThroughput);
+    self->interval = interval;
+    return self;
+}
+
+void
+mm_throughput_free (MMThroughput *self)
+{
+    g_slice_free (MMThroughput, self);
+}
@@ -0,0 +1,63 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#ifndef MM_THROUGHPUT_H
+#define MM_THROUGHPUT_H
+
+#include <glib.h>
+
+/* Throughput of a connection, computed from the byte counters sampled at a
+ * fixed interval: rate in the last interval, peak rate, moving average, and
+ * the rates of the last intervals in a ring of fixed size, so that the memory
+ * used per bearer doesn't depend on how long it stays connected. */
+
+#define MM_THROUGHPUT_HISTORY_SIZE     60
+#define MM_THROUGHPUT_AVERAGE_TAU_SEC  10
+
+typedef struct _MMThroughput MMThroughput;
+
+MMThroughput *mm_throughput_new            (guint         interval);
+void          mm_throughput_free           (MMThroughput *self);
+
+/* Drops all samples, e.g. on a new connection */
+void          mm_throughput_reset          (MMThroughput *self);
+
+/* Returns TRUE if a new rate was computed. Samples taken less than half an
+ * interval after the previous one are ignored, and counters going backwards
+ * (e.g. the interface was reset) only start over from the new values. */
+gboolean      mm_throughput_add_sample     (MMThroughput *self,
+                                            gint64        time_usec,
+                                            guint64       rx_bytes,
+                                            guint64       tx_bytes);
+
+guint         mm_throughput_get_interval   (MMThroughput *self);
+guint64       mm_throughput_get_rx_rate    (MMThroughput *self);
+guint64       mm_throughput_get_tx_rate    (MMThroughput *self);
+guint64       mm_throughput_get_rx_peak    (MMThroughput *self);
+guint64       mm_throughput_get_tx_peak    (MMThroughput *self);
+guint64       mm_throughput_get_rx_average (MMThroughput *self);
+guint64       mm_throughput_get_tx_average (MMThroughput *self);
+
+/* Number of rates in the history, and the n-th one, oldest first */
+guint         mm_throughput_get_n_history  (MMThroughput *self);
+void          mm_throughput_get_history    (MMThroughput *self,
+                                            guint         i,
+                                            guint32      *rx_rate,
+                                            guint32      *tx_rate);
+
+/* "Throughput" property of the bearer, NULL until the first rate is known */
+GVariant     *mm_throughput_get_dictionary (MMThroughput *self);
+
+#endif /* MM_THROUGHPUT_H */
@@ -0,0 +1,65 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#ifndef MM_LOG_TEST_H
+#define MM_LOG_TEST_H
+
+#include <glib.h>
+
+#include "mm-log.h"
+
+/* Logging functions used by the test programs instead of the ones of the
+ * daemon. Messages are only printed if ENABLE_TEST_MESSAGE_TRACES is defined
+ * when including this header, which must be done only once per program. */
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         MMLogLevel level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+void
+_mm_log_trace (const char *loc,
+               const char *func,
+               const char *owner,
+               const char *fmt,
+               ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+#endif /* MM_LOG_TEST_H */
@@ -18,7 +18,9 @@
 #include <glib.h>
 
 #include "mm-port-serial-at.h"
-#include "mm-log.h"
+#include "mm-serial-parsers.h"
+#include "mm-error-helpers.h"
+#include "mm-log-test.h"
 
 typedef struct {
     gchar *original;
@@ -64,31 +66,654 @@ at_serial_echo_removal (void)
     }
 }
 
-void
-_mm_log (const char *loc,
-         const char *func,
-         guint32 level,
-         const char *fmt,
-         ...)
+/*****************************************************************************/
+
+typedef struct {
+    const gchar *response;
+    gboolean     found;
+    GQuark     (*error_domain) (void); /* NULL if no error expected */
+    gint         error_code;
+    const gchar *cleaned;      /* only checked on success */
+} ParserTest;
+
+static const ParserTest parser_tests[] = {
+    /* Incomplete */
+    { "\r\n+CSQ: 10,99\r\n", FALSE, NULL, 0, NULL },
+    { "\r\nOK", FALSE, NULL, 0, NULL },
+    { "\r\n+CME ERROR: 10", FALSE, NULL, 0, NULL },
+    /* Successful */
+    { "\r\nOK\r\n", TRUE, NULL, 0, "" },
+    { "\r\n+CSQ: 10,99\r\n\r\nOK\r\n", TRUE, NULL, 0, "+CSQ: 10,99" },
+    { "\r\n+CSQ: 10,99\r\n\r\nOK\r\n\r\n", TRUE, NULL, 0, "+CSQ: 10,99" },
+    { "\r\nCONNECT 115200\r\n", TRUE, NULL, 0, "CONNECT 115200" },
+    { "\r\n> ", TRUE, NULL, 0, "> " },
+    /* Errors */
+    { "\r\n+CME ERROR: 10\r\n", TRUE, mm_mobile_equipment_error_quark, MM_MOBILE_EQUIPMENT_ERROR_SIM_NOT_INSERTED, NULL },
+    { "\r\n+CME ERROR: SIM not inserted\r\n", TRUE, mm_mobile_equipment_error_quark, MM_MOBILE_EQUIPMENT_ERROR_SIM_NOT_INSERTED, NULL },
+    { "\r\n+CMS ERROR: 310\r\n", TRUE, mm_message_error_quark, MM_MESSAGE_ERROR_SIM_NOT_INSERTED, NULL },
+    { "\r\nMODEM ERROR: 3\r\n", TRUE, mm_mobile_equipment_error_quark, MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN, NULL },
+    { "\r\nERROR\r\n", TRUE, mm_mobile_equipment_error_quark, MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN, NULL },
+    { "\r\nCOMMAND NOT SUPPORT\r\n", TRUE, mm_mobile_equipment_error_quark, MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN, NULL },
+    { "\r\nNO CARRIER\r\n", TRUE, mm_connection_error_quark, MM_CONNECTION_ERROR_NO_CARRIER, NULL },
+    { "\r\nBUSY\r\n", TRUE, mm_connection_error_quark, MM_CONNECTION_ERROR_BUSY, NULL },
+    { "\r\nNO ANSWER\r\n", TRUE, mm_connection_error_quark, MM_CONNECTION_ERROR_NO_ANSWER, NULL },
+    { "\r\nNO DIALTONE\r\n", TRUE, mm_connection_error_quark, MM_CONNECTION_ERROR_NO_DIALTONE, NULL },
+    { "\r\nNA\r\n", TRUE, mm_mobile_equipment_error_quark, MM_MOBILE_EQUIPMENT_ERROR_NOT_ALLOWED, NULL },
+};
+
+static void
+at_serial_parser (void)
+{
+    gpointer parser;
+    guint i;
+
+    parser = mm_serial_parser_v1_new ();
+
+    for (i = 0; i < G_N_ELEMENTS (parser_tests); i++) {
+        GString *response;
+        GError *error = NULL;
+        gboolean found;
+
+        response = g_string_new (parser_tests[i].response);
+        found = mm_serial_parser_v1_parse (parser, response, &error);
+        g_assert (found == parser_tests[i].found);
+
+        if (!parser_tests[i].error_domain) {
+            g_assert_no_error (error);
+            if (found)
+                g_assert_cmpstr (response->str, ==, parser_tests[i].cleaned);
+        } else
+            g_assert_error (error, parser_tests[i].error_domain (), parser_tests[i].error_code);
+
+        g_clear_error (&error);
+        g_string_free (response, TRUE);
+    }
+
+    mm_serial_parser_v1_destroy (parser);
+}
+
+/* Compares the parser against the regex cascade it replaced, using the same
+ * responses as the functional test. Only run in perf mode (-m perf). */
+static void
+at_serial_parser_perf (void)
+{
+    static const gchar *legacy_patterns[] = {
+        "\\r\\nOK(\\r\\n)+$",
+        "\\r\\nCONNECT.*\\r\\n",
+        "\\r\\n>\\s*$",
+        "\\r\\n\\+CME ERROR:\\s*(\\d+)\\r\\n$",
+        "\\r\\n\\+CMS ERROR:\\s*(\\d+)\\r\\n$",
+        "\\r\\n\\+CME ERROR:\\s*([^\\n\\r]+)\\r\\n$",
+        "\\r\\n\\+CMS ERROR:\\s*([^\\n\\r]+)\\r\\n$",
+        "\\r\\nMODEM ERROR:\\s*(\\d+)\\r\\n$",
+        "\\r\\n(ERROR)|(COMMAND NOT SUPPORT)\\r\\n$",
+        "\\r\\n(NO CARRIER)|(BUSY)|(NO ANSWER)|(NO DIALTONE)\\r\\n$",
+        "\\r\\nNA\\r\\n",
+    };
+    GRegex *legacy[G_N_ELEMENTS (legacy_patterns)];
+    gpointer parser;
+    GString *response;
+    gdouble legacy_time;
+    gdouble scanner_time;
+    guint iterations = 10000;
+    guint n, i, j;
+
+    if (!g_test_perf ())
+        return;
+
+    for (j = 0; j < G_N_ELEMENTS (legacy_patterns); j++)
+        legacy[j] = g_regex_new (legacy_patterns[j], G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    parser = mm_serial_parser_v1_new ();
+    response = g_string_sized_new (256);
+
+    /* Legacy: every regex evaluated over the whole buffer, stopping at the
+     * first match, as the old parser did */
+    g_test_timer_start ();
+    for (n = 0; n < iterations; n++) {
+        for (i = 0; i < G_N_ELEMENTS (parser_tests); i++) {
+            for (j = 0; j < G_N_ELEMENTS (legacy); j++) {
+                GMatchInfo *match_info = NULL;
+                gboolean matched;
+
+                matched = g_regex_match_full (legacy[j], parser_tests[i].response, -1, 0, 0, &match_info, NULL);
+                g_match_info_free (match_info);
+                if (matched)
+                    break;
+            }
+        }
+    }
+    legacy_time = g_test_timer_elapsed ();
+
+    g_test_timer_start ();
+    for (n = 0; n < iterations; n++) {
+        for (i = 0; i < G_N_ELEMENTS (parser_tests); i++) {
+            GError *error = NULL;
+
+            g_string_assign (response, parser_tests[i].response);
+            mm_serial_parser_v1_parse (parser, response, &error);
+            g_clear_error (&error);
+        }
+    }
+    scanner_time = g_test_timer_elapsed ();
+
+    g_test_minimized_result (scanner_time, "serial parser: %.3fs (legacy regex cascade: %.3fs, %u responses)",
+                             scanner_time, legacy_time, iterations * (guint) G_N_ELEMENTS (parser_tests));
+
+    g_string_free (response, TRUE);
+    mm_serial_parser_v1_destroy (parser);
+    for (j = 0; j < G_N_ELEMENTS (legacy); j++)
+        g_regex_unref (legacy[j]);
+}
+
+/*****************************************************************************/
+
+static void
+at_serial_buffer (void)
+{
+    MMPortSerialBuffer *buffer;
+    const guint8 *data;
+    guint8 *free_space;
+    gsize len;
+
+    /* Small initial size, so that it needs to grow */
+    buffer = mm_port_serial_buffer_new (8);
+
+    mm_port_serial_buffer_append (buffer, (const guint8 *) "\r\nOK\r\n", 6);
+    free_space = mm_port_serial_buffer_reserve (buffer, 12);
+    memcpy (free_space, "\r\n+CSQ: 1\r\n", 11);
+    mm_port_serial_buffer_commit (buffer, 11);
+
+    data = mm_port_serial_buffer_peek (buffer, &len);
+    g_assert_cmpuint (len, ==, 17);
+    g_assert (memcmp (data, "\r\nOK\r\n\r\n+CSQ: 1\r\n", len) == 0);
+
+    /* Consuming from the head */
+    mm_port_serial_buffer_consume (buffer, 6);
+    data = mm_port_serial_buffer_peek (buffer, &len);
+    g_assert_cmpuint (len, ==, 11);
+    g_assert (memcmp (data, "\r\n+CSQ: 1\r\n", len) == 0);
+
+    /* Removing in the middle, moving either the head or the tail */
+    mm_port_serial_buffer_remove_range (buffer, 2, 1);
+    mm_port_serial_buffer_remove_range (buffer, 8, 2);
+    data = mm_port_serial_buffer_peek (buffer, &len);
+    g_assert_cmpuint (len, ==, 8);
+    g_assert (memcmp (data, "\r\nCSQ: 1", len) == 0);
+
+    /* Compaction keeps the pending data */
+    free_space = mm_port_serial_buffer_reserve (buffer, 1024);
+    memset (free_space, 'x', 1024);
+    mm_port_serial_buffer_commit (buffer, 1024);
+    data = mm_port_serial_buffer_peek (buffer, &len);
+    g_assert_cmpuint (len, ==, 1032);
+    g_assert (memcmp (data, "\r\nCSQ: 1x", 9) == 0);
+
+    mm_port_serial_buffer_consume (buffer, len);
+    g_assert_cmpuint (mm_port_serial_buffer_get_len (buffer), ==, 0);
+
+    /* The scanned mark follows the contents */
+    mm_port_serial_buffer_append (buffer, (const guint8 *) "\r\nOK\r\n\r\n+CSQ: 1\r\n", 17);
+    mm_port_serial_buffer_set_scanned (buffer, 12);
+    mm_port_serial_buffer_consume (buffer, 2);
+    g_assert_cmpuint (mm_port_serial_buffer_get_scanned (buffer), ==, 10);
+    mm_port_serial_buffer_remove_range (buffer, 12, 2);
+    g_assert_cmpuint (mm_port_serial_buffer_get_scanned (buffer), ==, 10);
+    mm_port_serial_buffer_remove_range (buffer, 0, 4);
+    g_assert_cmpuint (mm_port_serial_buffer_get_scanned (buffer), ==, 6);
+    mm_port_serial_buffer_remove_range (buffer, 4, 4);
+    g_assert_cmpuint (mm_port_serial_buffer_get_scanned (buffer), ==, 4);
+    mm_port_serial_buffer_consume (buffer, 5);
+    g_assert_cmpuint (mm_port_serial_buffer_get_scanned (buffer), ==, 0);
+    mm_port_serial_buffer_append (buffer, (const guint8 *) "OK", 2);
+    mm_port_serial_buffer_set_scanned (buffer, 1);
+    mm_port_serial_buffer_clear (buffer);
+    g_assert_cmpuint (mm_port_serial_buffer_get_scanned (buffer), ==, 0);
+
+    mm_port_serial_buffer_free (buffer);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+    guint creg;
+    guint ring;
+    guint connection_failed;
+    guint generic;
+    guint rssi;
+    gchar *last_creg;
+} UnsolicitedCounters;
+
+static void
+unsolicited_creg_cb (MMPortSerialAt *port,
+                     GMatchInfo *match_info,
+                     UnsolicitedCounters *counters)
+{
+    counters->creg++;
+    g_free (counters->last_creg);
+    counters->last_creg = g_match_info_fetch (match_info, 1);
+}
+
+static void
+unsolicited_ring_cb (MMPortSerialAt *port,
+                     GMatchInfo *match_info,
+                     UnsolicitedCounters *counters)
+{
+    counters->ring++;
+}
+
+static void
+unsolicited_connection_failed_cb (MMPortSerialAt *port,
+                                  GMatchInfo *match_info,
+                                  UnsolicitedCounters *counters)
 {
-#if defined ENABLE_TEST_MESSAGE_TRACES
-    /* Dummy log function */
-    va_list args;
-    gchar *msg;
+    counters->connection_failed++;
+}
+
+static void
+unsolicited_generic_cb (MMPortSerialAt *port,
+                        GMatchInfo *match_info,
+                        UnsolicitedCounters *counters)
+{
+    counters->generic++;
+}
 
-    va_start (args, fmt);
-    msg = g_strdup_vprintf (fmt, args);
-    va_end (args);
-    g_print ("%s\n", msg);
-    g_free (msg);
-#endif
+static void
+unsolicited_rssi_cb (MMPortSerialAt *port,
+                     GMatchInfo *match_info,
+                     UnsolicitedCounters *counters)
+{
+    counters->rssi++;
 }
 
+static void
+at_serial_unsolicited (void)
+{
+    static const gchar *input =
+        "\r\n+CREG: 1\r\n"
+        "\r\nRING\r\n"
+        "\r\n+CSQ: 10,99\r\n"
+        "\r\nBUSY\r\n"
+        "\r\n\r\n+CREG: 5\r\n"
+        "\r\n+CREG: 2";
+    static const gchar *expected =
+        "\r\n+CSQ: 10,99\r\n"
+        "\r\n\r\n+CREG: 2";
+    UnsolicitedCounters counters = { 0 };
+    MMPortSerialAt *port;
+    MMPortSerialBuffer *response;
+    const guint8 *data;
+    gsize len;
+    GRegex *creg;
+    GRegex *ring;
+    GRegex *connection_failed;
+
+    port = mm_port_serial_at_new ("ttyTEST0", MM_PORT_SUBSYS_TTY);
+
+    /* Indexed by leading token */
+    creg = g_regex_new ("\\r\\n\\+CREG:\\s*(\\d)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    ring = g_regex_new ("\\r\\nRING\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    /* Not indexed, applied to the whole buffer */
+    connection_failed = g_regex_new ("\\r\\n(NO CARRIER|BUSY)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+
+    mm_port_serial_at_add_unsolicited_msg_handler (port, creg, (MMPortSerialAtUnsolicitedMsgFn) unsolicited_creg_cb, &counters, NULL);
+    mm_port_serial_at_add_unsolicited_msg_handler (port, ring, (MMPortSerialAtUnsolicitedMsgFn) unsolicited_ring_cb, &counters, NULL);
+    mm_port_serial_at_add_unsolicited_msg_handler (port, connection_failed, (MMPortSerialAtUnsolicitedMsgFn) unsolicited_connection_failed_cb, &counters, NULL);
+
+    /* Disabled handlers don't consume anything */
+    mm_port_serial_at_enable_unsolicited_msg_handler (port, ring, FALSE);
+    response = mm_port_serial_buffer_new (64);
+    mm_port_serial_buffer_append (response, (const guint8 *) "\r\nRING\r\n", 8);
+    MM_PORT_SERIAL_GET_CLASS (port)->parse_unsolicited (MM_PORT_SERIAL (port), response);
+    g_assert_cmpuint (mm_port_serial_buffer_get_len (response), ==, 8);
+    g_assert_cmpuint (counters.ring, ==, 0);
+    mm_port_serial_buffer_free (response);
+    mm_port_serial_at_enable_unsolicited_msg_handler (port, ring, TRUE);
+
+    response = mm_port_serial_buffer_new (64);
+    mm_port_serial_buffer_append (response, (const guint8 *) input, strlen (input));
+    MM_PORT_SERIAL_GET_CLASS (port)->parse_unsolicited (MM_PORT_SERIAL (port), response);
+
+    g_assert_cmpuint (counters.creg, ==, 2);
+    g_assert_cmpstr (counters.last_creg, ==, "5");
+    g_assert_cmpuint (counters.ring, ==, 1);
+    g_assert_cmpuint (counters.connection_failed, ==, 1);
+    data = mm_port_serial_buffer_peek (response, &len);
+    g_assert_cmpuint (len, ==, strlen (expected));
+    g_assert (memcmp (data, expected, len) == 0);
+
+    mm_port_serial_buffer_free (response);
+    g_regex_unref (creg);
+    g_regex_unref (ring);
+    g_regex_unref (connection_failed);
+    g_object_unref (port);
+    g_free (counters.last_creg);
+}
+
+static void
+at_serial_unsolicited_order (void)
+{
+    static const gchar *input =
+        "\r\n+CREG: 1\r\n"
+        "\r\n+CREG: 5\r\n"
+        "\r\n+CGREG: 1\r\n";
+    UnsolicitedCounters counters = { 0 };
+    MMPortSerialAt *port;
+    MMPortSerialBuffer *response;
+    GRegex *creg;
+    GRegex *generic;
+    GRegex *roaming;
+
+    port = mm_port_serial_at_new ("ttyTEST0", MM_PORT_SUBSYS_TTY);
+
+    /* Indexed, not indexed, indexed; the newest one always has priority */
+    creg = g_regex_new ("\\r\\n\\+CREG:\\s*(\\d)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    generic = g_regex_new ("\\r\\n\\+(CREG|CGREG):\\s*(\\d)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    roaming = g_regex_new ("\\r\\n\\+CREG:\\s*(5)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+
+    mm_port_serial_at_add_unsolicited_msg_handler (port, creg, (MMPortSerialAtUnsolicitedMsgFn) unsolicited_creg_cb, &counters, NULL);
+    mm_port_serial_at_add_unsolicited_msg_handler (port, generic, (MMPortSerialAtUnsolicitedMsgFn) unsolicited_generic_cb, &counters, NULL);
+    mm_port_serial_at_add_unsolicited_msg_handler (port, roaming, (MMPortSerialAtUnsolicitedMsgFn) unsolicited_ring_cb, &counters, NULL);
+
+    response = mm_port_serial_buffer_new (64);
+    mm_port_serial_buffer_append (response, (const guint8 *) input, strlen (input));
+    MM_PORT_SERIAL_GET_CLASS (port)->parse_unsolicited (MM_PORT_SERIAL (port), response);
+
+    g_assert_cmpuint (counters.ring, ==, 1);
+    g_assert_cmpuint (counters.generic, ==, 2);
+    g_assert_cmpuint (counters.creg, ==, 0);
+    g_assert_cmpuint (mm_port_serial_buffer_get_len (response), ==, 0);
+
+    /* Without the generic one, the older indexed one gets it */
+    mm_port_serial_at_remove_unsolicited_msg_handler (port, generic);
+    mm_port_serial_buffer_append (response, (const guint8 *) input, strlen (input));
+    MM_PORT_SERIAL_GET_CLASS (port)->parse_unsolicited (MM_PORT_SERIAL (port), response);
+
+    g_assert_cmpuint (counters.ring, ==, 2);
+    g_assert_cmpuint (counters.creg, ==, 1);
+    g_assert_cmpstr (counters.last_creg, ==, "1");
+    g_assert_cmpuint (mm_port_serial_buffer_get_len (response), ==, strlen ("\r\n+CGREG: 1\r\n"));
+
+    mm_port_serial_buffer_free (response);
+    g_regex_unref (creg);
+    g_regex_unref (generic);
+    g_regex_unref (roaming);
+    g_object_unref (port);
+    g_free (counters.last_creg);
+}
+
+static void
+at_serial_unsolicited_mid_line (void)
+{
+    static const gchar *input =
+        "\r\n+CSQ: 10,99^RSSI:5\r\n"
+        "\r\n^RSSI:7\r\n";
+    static const gchar *expected =
+        "\r\n+CSQ: 10,99"
+        "\r\n";
+    UnsolicitedCounters counters = { 0 };
+    MMPortSerialAt *port;
+    MMPortSerialBuffer *response;
+    const guint8 *data;
+    gsize len;
+    GRegex *rssi;
+
+    port = mm_port_serial_at_new ("ttyTEST0", MM_PORT_SUBSYS_TTY);
+
+    /* No leading line separator, so it may match anywhere */
+    rssi = g_regex_new ("\\^RSSI:\\s*(\\d+)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    mm_port_serial_at_add_unsolicited_msg_handler (port, rssi, (MMPortSerialAtUnsolicitedMsgFn) unsolicited_rssi_cb, &counters, NULL);
+
+    response = mm_port_serial_buffer_new (64);
+    mm_port_serial_buffer_append (response, (const guint8 *) input, strlen (input));
+    MM_PORT_SERIAL_GET_CLASS (port)->parse_unsolicited (MM_PORT_SERIAL (port), response);
+
+    g_assert_cmpuint (counters.rssi, ==, 2);
+    data = mm_port_serial_buffer_peek (response, &len);
+    g_assert_cmpuint (len, ==, strlen (expected));
+    g_assert (memcmp (data, expected, len) == 0);
+
+    mm_port_serial_buffer_free (response);
+    g_regex_unref (rssi);
+    g_object_unref (port);
+}
+
+static void
+at_serial_unsolicited_incremental (void)
+{
+    UnsolicitedCounters counters = { 0 };
+    MMPortSerialAt *port;
+    MMPortSerialBuffer *response;
+    GRegex *creg;
+    GRegex *ring;
+
+    port = mm_port_serial_at_new ("ttyTEST0", MM_PORT_SUBSYS_TTY);
+
+    creg = g_regex_new ("\\r\\n\\+CREG:\\s*(\\d)\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    ring = g_regex_new ("\\r\\nRING\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    mm_port_serial_at_add_unsolicited_msg_handler (port, creg, (MMPortSerialAtUnsolicitedMsgFn) unsolicited_creg_cb, &counters, NULL);
+    mm_port_serial_at_add_unsolicited_msg_handler (port, ring, (MMPortSerialAtUnsolicitedMsgFn) unsolicited_ring_cb, &counters, NULL);
+    response = mm_port_serial_buffer_new (64);
+
+    /* Complete lines are not scanned again, the incomplete one is */
+    mm_port_serial_buffer_append (response, (const guint8 *) "\r\n+CSQ: 10,99\r\n\r\n+CR", 20);
+    MM_PORT_SERIAL_GET_CLASS (port)->parse_unsolicited (MM_PORT_SERIAL (port), response);
+    g_assert_cmpuint (mm_port_serial_buffer_get_scanned (response), ==, 13);
+    mm_port_serial_buffer_append (response, (const guint8 *) "EG: 1\r", 6);
+    MM_PORT_SERIAL_GET_CLASS (port)->parse_unsolicited (MM_PORT_SERIAL (port), response);
+    g_assert_cmpuint (counters.creg, ==, 0);
+
+    /* A complete line which a handler could match with more data is kept */
+    g_assert_cmpuint (mm_port_serial_buffer_get_scanned (response), ==, 13);
+    mm_port_serial_buffer_append (response, (const guint8 *) "\n", 1);
+    MM_PORT_SERIAL_GET_CLASS (port)->parse_unsolicited (MM_PORT_SERIAL (port), response);
+    g_assert_cmpuint (counters.creg, ==, 1);
+    g_assert_cmpuint (mm_port_serial_buffer_get_len (response), ==, 15);
+    g_assert_cmpuint (mm_port_serial_buffer_get_scanned (response), ==, 13);
+
+    /* Handlers enabled later get to see the already scanned data */
+    mm_port_serial_buffer_clear (response);
+    mm_port_serial_at_enable_unsolicited_msg_handler (port, ring, FALSE);
+    mm_port_serial_buffer_append (response, (const guint8 *) "\r\nRING\r\n\r\nOK", 12);
+    MM_PORT_SERIAL_GET_CLASS (port)->parse_unsolicited (MM_PORT_SERIAL (port), response);
+    g_assert_cmpuint (counters.ring, ==, 0);
+    g_assert_cmpuint (mm_port_serial_buffer_get_scanned (response), ==, 6);
+    mm_port_serial_at_enable_unsolicited_msg_handler (port, ring, TRUE);
+    MM_PORT_SERIAL_GET_CLASS (port)->parse_unsolicited (MM_PORT_SERIAL (port), response);
+    g_assert_cmpuint (counters.ring, ==, 1);
+    g_assert_cmpuint (mm_port_serial_buffer_get_len (response), ==, 4);
+
+    mm_port_serial_buffer_free (response);
+    g_regex_unref (creg);
+    g_regex_unref (ring);
+    g_object_unref (port);
+    g_free (counters.last_creg);
+}
+
+static void
+unsolicited_cmgl_cb (MMPortSerialAt *port,
+                     GMatchInfo *match_info,
+                     GPtrArray *pdus)
+{
+    g_ptr_array_add (pdus, g_match_info_fetch (match_info, 3));
+}
+
+static void
+at_serial_unsolicited_streaming (void)
+{
+    static const gchar *chunks[] = {
+        "\r\n+CMGL: 1,1,,20\r\n0791",
+        "44872000",
+        "0000\r\n+CMGL: 4,1,,2",
+        "0\r\n07914487200000",
+        "00\r\n\r\nOK\r\n",
+    };
+    MMPortSerialAt *port;
+    MMPortSerialBuffer *response;
+    GPtrArray *pdus;
+    GRegex *cmgl;
+    const guint8 *data;
+    gsize len;
+    guint i;
+
+    port = mm_port_serial_at_new ("ttyTEST0", MM_PORT_SUBSYS_TTY);
+    pdus = g_ptr_array_new_with_free_func (g_free);
+
+    cmgl = g_regex_new ("\\r\\n\\+CMGL:\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,[^\\r\\n]*\\r\\n([0-9A-Fa-f]+)(?=\\r\\n)",
+                        G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    mm_port_serial_at_add_unsolicited_msg_handler (port, cmgl, (MMPortSerialAtUnsolicitedMsgFn) unsolicited_cmgl_cb, pdus, NULL);
+
+    /* Entries are consumed as soon as their PDU line is complete */
+    response = mm_port_serial_buffer_new (64);
+    for (i = 0; i < G_N_ELEMENTS (chunks); i++) {
+        mm_port_serial_buffer_append (response, (const guint8 *) chunks[i], strlen (chunks[i]));
+        MM_PORT_SERIAL_GET_CLASS (port)->parse_unsolicited (MM_PORT_SERIAL (port), response);
+        if (i == 1)
+            g_assert_cmpuint (pdus->len, ==, 0);
+        if (i == 2)
+            g_assert_cmpuint (pdus->len, ==, 1);
+    }
+
+    g_assert_cmpuint (pdus->len, ==, 2);
+    g_assert_cmpstr (g_ptr_array_index (pdus, 0), ==, "0791448720000000");
+    g_assert_cmpstr (g_ptr_array_index (pdus, 1), ==, "0791448720000000");
+    data = mm_port_serial_buffer_peek (response, &len);
+    g_assert_cmpuint (len, ==, strlen ("\r\n\r\nOK\r\n"));
+    g_assert (memcmp (data, "\r\n\r\nOK\r\n", len) == 0);
+    mm_port_serial_buffer_free (response);
+
+    /* Once removed, the entries are left in the response */
+    mm_port_serial_at_remove_unsolicited_msg_handler (port, cmgl);
+    response = mm_port_serial_buffer_new (64);
+    mm_port_serial_buffer_append (response, (const guint8 *) chunks[0], strlen (chunks[0]));
+    mm_port_serial_buffer_append (response, (const guint8 *) chunks[1], strlen (chunks[1]));
+    mm_port_serial_buffer_append (response, (const guint8 *) chunks[2], strlen (chunks[2]));
+    MM_PORT_SERIAL_GET_CLASS (port)->parse_unsolicited (MM_PORT_SERIAL (port), response);
+    g_assert_cmpuint (pdus->len, ==, 2);
+    mm_port_serial_buffer_free (response);
+
+    g_regex_unref (cmgl);
+    g_ptr_array_unref (pdus);
+    g_object_unref (port);
+}
+
+typedef struct {
+    const gchar *command;
+    guint ttl_seconds;
+    MMPortSerialCacheInvalidation invalidate_on;
+    MMPortSerialCacheInvalidation invalidates;
+} CachePolicyTest;
+
+static const CachePolicyTest cache_policy_tests[] = {
+    { "AT+CGMI\r",      0, MM_PORT_SERIAL_CACHE_INVALIDATION_NONE,  MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    { "AT+GSN\r\n",     0, MM_PORT_SERIAL_CACHE_INVALIDATION_NONE,  MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    { "at+cgmr\r",      3600, MM_PORT_SERIAL_CACHE_INVALIDATION_NONE, MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    { "AT+CPMS=?\r",    600, (MM_PORT_SERIAL_CACHE_INVALIDATION_SIM | MM_PORT_SERIAL_CACHE_INVALIDATION_POWER), MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    { "AT+CSQ\r",       5, MM_PORT_SERIAL_CACHE_INVALIDATION_POWER, MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    { "AT+CFUN=4\r",    0, MM_PORT_SERIAL_CACHE_INVALIDATION_ALL,   MM_PORT_SERIAL_CACHE_INVALIDATION_POWER },
+    { "AT+CSCS=\"UCS2\"\r", 0, MM_PORT_SERIAL_CACHE_INVALIDATION_ALL, MM_PORT_SERIAL_CACHE_INVALIDATION_CHARSET },
+    { "AT+CSCS=?\r",    0, MM_PORT_SERIAL_CACHE_INVALIDATION_NONE,  MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    { "AT+CFUN=?\r",    0, MM_PORT_SERIAL_CACHE_INVALIDATION_ALL,   MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    { "AT+CIMI\r",      0, MM_PORT_SERIAL_CACHE_INVALIDATION_SIM,   MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    { "AT+CRSM=176,12258,0,0,10\r", 0, MM_PORT_SERIAL_CACHE_INVALIDATION_SIM, MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    /* Only reads from the SIM */
+    { "AT+CRSM=214,28486,0,0,17\r", 0, MM_PORT_SERIAL_CACHE_INVALIDATION_ALL, MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    /* Unknown commands: never expire, invalidated by any state change */
+    { "AT+CGMIX\r",     0, MM_PORT_SERIAL_CACHE_INVALIDATION_ALL,   MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+    { "AT+COPS?\r",     0, MM_PORT_SERIAL_CACHE_INVALIDATION_ALL,   MM_PORT_SERIAL_CACHE_INVALIDATION_NONE },
+};
+
+static void
+at_serial_cache_policy (void)
+{
+    MMPortSerialAt *port;
+    guint i;
+
+    port = mm_port_serial_at_new ("ttyTEST0", MM_PORT_SUBSYS_TTY);
+
+    for (i = 0; i < G_N_ELEMENTS (cache_policy_tests); i++) {
+        GByteArray *command;
+        guint ttl_seconds = 0;
+        MMPortSerialCacheInvalidation invalidate_on = MM_PORT_SERIAL_CACHE_INVALIDATION_ALL;
+        MMPortSerialCacheInvalidation invalidates = MM_PORT_SERIAL_CACHE_INVALIDATION_NONE;
+
+        command = g_byte_array_new ();
+        g_byte_array_append (command,
+                             (const guint8 *) cache_policy_tests[i].command,
+                             strlen (cache_policy_tests[i].command));
+        MM_PORT_SERIAL_GET_CLASS (port)->get_cache_policy (MM_PORT_SERIAL (port),
+                                                           command,
+                                                           &ttl_seconds,
+                                                           &invalidate_on,
+                                                           &invalidates);
+        g_assert_cmpuint (ttl_seconds, ==, cache_policy_tests[i].ttl_seconds);
+        g_assert_cmpuint (invalidate_on, ==, cache_policy_tests[i].invalidate_on);
+        g_assert_cmpuint (invalidates, ==, cache_policy_tests[i].invalidates);
+        g_byte_array_unref (command);
+    }
+
+    g_object_unref (port);
+}
+
+typedef struct {
+    const gchar *command;
+    const gchar *key;
+} StatsKeyTest;
+
+static const StatsKeyTest stats_key_tests[] = {
+    { "AT+COPS=?\r",     "+COPS=?" },
+    { "AT+COPS?\r",      "+COPS?"  },
+    { "AT+COPS=0,2\r",   "+COPS="  },
+    { "at+csq\r\n",      "+CSQ"    },
+    { "AT+CMGS=12\r",    "+CMGS="  },
+    { "ATE0\r",          "E0"      },
+    { "AT\r",            "AT"      },
+    { "0011000B91\x1a",  "raw"     },
+};
+
+static void
+at_serial_stats_key (void)
+{
+    MMPortSerialAt *port;
+    guint i;
+
+    port = mm_port_serial_at_new ("ttyTEST0", MM_PORT_SUBSYS_TTY);
+
+    for (i = 0; i < G_N_ELEMENTS (stats_key_tests); i++) {
+        GByteArray *command;
+        gchar key[32];
+
+        command = g_byte_array_new ();
+        g_byte_array_append (command,
+                             (const guint8 *) stats_key_tests[i].command,
+                             strlen (stats_key_tests[i].command));
+        MM_PORT_SERIAL_GET_CLASS (port)->get_stats_key (MM_PORT_SERIAL (port),
+                                                        command,
+                                                        key,
+                                                        sizeof (key));
+        g_assert_cmpstr (key, ==, stats_key_tests[i].key);
+        g_byte_array_unref (command);
+    }
+
+    g_object_unref (port);
+}
+
+/*****************************************************************************/
+
 int main (int argc, char **argv)
 {
     g_test_init (&argc, &argv, NULL);
 
     g_test_add_func ("/ModemManager/AT-serial/echo-removal", at_serial_echo_removal);
+    g_test_add_func ("/ModemManager/AT-serial/parser", at_serial_parser);
+    g_test_add_func ("/ModemManager/AT-serial/parser-perf", at_serial_parser_perf);
+    g_test_add_func ("/ModemManager/AT-serial/buffer", at_serial_buffer);
+    g_test_add_func ("/ModemManager/AT-serial/unsolicited", at_serial_unsolicited);
+    g_test_add_func ("/ModemManager/AT-serial/unsolicited-streaming", at_serial_unsolicited_streaming);
+    g_test_add_func ("/ModemManager/AT-serial/unsolicited-order", at_serial_unsolicited_order);
+    g_test_add_func ("/ModemManager/AT-serial/unsolicited-mid-line", at_serial_unsolicited_mid_line);
+    g_test_add_func ("/ModemManager/AT-serial/unsolicited-incremental", at_serial_unsolicited_incremental);
+    g_test_add_func ("/ModemManager/AT-serial/cache-policy", at_serial_cache_policy);
+    g_test_add_func ("/ModemManager/AT-serial/stats-key", at_serial_stats_key);
 
     return g_test_run ();
 }
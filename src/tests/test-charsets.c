@@ -18,7 +18,7 @@
 #include <locale.h>
 
 #include "mm-modem-helpers.h"
-#include "mm-log.h"
+#include "mm-log-test.h"
 
 #if defined ENABLE_TEST_MESSAGE_TRACES
 #define trace(message, ...) g_print (message, ##__VA_ARGS__)
@@ -315,6 +315,176 @@ test_gsm7_pack_7_chars_offset (void)
     g_free (packed);
 }
 
+/* The original one septet at a time implementations, to compare against */
+
+static guint8 *
+reference_gsm_unpack (const guint8 *gsm,
+                      guint32       num_septets,
+                      guint8        start_offset)
+{
+    guint8 *unpacked;
+    guint32 i;
+
+    unpacked = g_malloc (num_septets + 1);
+    for (i = 0; i < num_septets; i++) {
+        guint8  bits_here, bits_in_next, offset, c;
+        guint32 start_bit;
+
+        start_bit = start_offset + (i * 7);
+        offset = start_bit % 8;
+        bits_here = offset ? (8 - offset) : 7;
+        bits_in_next = 7 - bits_here;
+
+        c = (gsm[start_bit / 8] >> offset) & (0xFF >> (8 - bits_here));
+        if (bits_in_next)
+            c |= (gsm[(start_bit / 8) + 1] & (0xFF >> (8 - bits_in_next))) << bits_here;
+        unpacked[i] = c;
+    }
+    return unpacked;
+}
+
+static guint8 *
+reference_gsm_pack (const guint8 *src,
+                    guint32       src_len,
+                    guint8        start_offset,
+                    guint32      *out_packed_len)
+{
+    guint8 *packed;
+    guint   octet = 0, lshift, plen;
+    guint32 i;
+
+    plen = (src_len * 7) + start_offset;
+    if (plen % 8)
+        plen += 8;
+    plen /= 8;
+
+    packed = g_malloc0 (plen);
+    for (i = 0, lshift = start_offset; i < src_len; i++) {
+        packed[octet] |= (src[i] & 0x7F) << lshift;
+        if (lshift > 1)
+            packed[octet + 1] = (src[i] & 0x7F) >> (8 - lshift);
+        if (lshift)
+            octet++;
+        lshift = lshift ? lshift - 1 : 7;
+    }
+
+    *out_packed_len = plen;
+    return packed;
+}
+
+static void
+test_gsm7_pack_unpack_fuzz (void)
+{
+    guint iteration;
+
+    for (iteration = 0; iteration < 5000; iteration++) {
+        guint8  src[200];
+        guint32 src_len;
+        guint8  offset;
+        guint8 *packed;
+        guint8 *expected;
+        guint32 packed_len = 0;
+        guint32 expected_len = 0;
+        guint8 *unpacked;
+        guint32 unpacked_len = 0;
+        guint32 i;
+
+        /* Random septets (with the 8th bit set sometimes, which must be
+         * ignored), at any offset, covering partial and full blocks */
+        src_len = g_test_rand_int_range (0, G_N_ELEMENTS (src));
+        offset = g_test_rand_int_range (0, 8);
+        for (i = 0; i < src_len; i++)
+            src[i] = g_test_rand_int_range (0, 256);
+
+        packed = mm_charset_gsm_pack (src, src_len, offset, &packed_len);
+        expected = reference_gsm_pack (src, src_len, offset, &expected_len);
+        g_assert_cmpuint (packed_len, ==, expected_len);
+        g_assert (packed_len == 0 || memcmp (packed, expected, packed_len) == 0);
+
+        unpacked = mm_charset_gsm_unpack (packed, src_len, offset, &unpacked_len);
+        g_assert_cmpuint (unpacked_len, ==, src_len);
+        for (i = 0; i < src_len; i++)
+            g_assert_cmpuint (unpacked[i], ==, src[i] & 0x7F);
+        g_free (unpacked);
+        g_free (expected);
+
+        /* Unpacking at other offsets, e.g. when skipping a UDH */
+        if (packed_len > 1) {
+            guint8  unpack_offset;
+            guint32 num_septets;
+
+            unpack_offset = g_test_rand_int_range (0, 16);
+            if (unpack_offset < (packed_len * 8)) {
+                num_septets = ((packed_len * 8) - unpack_offset) / 7;
+                unpacked = mm_charset_gsm_unpack (packed, num_septets, unpack_offset, &unpacked_len);
+                expected = reference_gsm_unpack (packed, num_septets, unpack_offset);
+                g_assert_cmpuint (unpacked_len, ==, num_septets);
+                g_assert (num_septets == 0 || memcmp (unpacked, expected, num_septets) == 0);
+                g_free (unpacked);
+                g_free (expected);
+            }
+        }
+
+        g_free (packed);
+    }
+}
+
+#define PERF_N_GSM7_MESSAGES 100000
+
+static void
+test_gsm7_pack_unpack_perf (void)
+{
+    guint8   src[160];
+    guint8  *packed;
+    guint32  packed_len = 0;
+    gdouble  pack_time, unpack_time;
+    gdouble  reference_pack_time, reference_unpack_time;
+    guint    i;
+
+    if (!g_test_perf ())
+        return;
+
+    /* Full-length messages after a 7 byte UDH, i.e. at a 7 bit offset */
+    for (i = 0; i < G_N_ELEMENTS (src); i++)
+        src[i] = 0x20 + (i % 0x5F);
+
+    g_test_timer_start ();
+    for (i = 0; i < PERF_N_GSM7_MESSAGES; i++)
+        g_free (mm_charset_gsm_pack (src, G_N_ELEMENTS (src), 7, &packed_len));
+    pack_time = g_test_timer_elapsed ();
+
+    g_test_timer_start ();
+    for (i = 0; i < PERF_N_GSM7_MESSAGES; i++)
+        g_free (reference_gsm_pack (src, G_N_ELEMENTS (src), 7, &packed_len));
+    reference_pack_time = g_test_timer_elapsed ();
+
+    packed = mm_charset_gsm_pack (src, G_N_ELEMENTS (src), 7, &packed_len);
+
+    g_test_timer_start ();
+    for (i = 0; i < PERF_N_GSM7_MESSAGES; i++) {
+        guint32 unpacked_len;
+
+        g_free (mm_charset_gsm_unpack (packed, G_N_ELEMENTS (src), 7, &unpacked_len));
+    }
+    unpack_time = g_test_timer_elapsed ();
+
+    g_test_timer_start ();
+    for (i = 0; i < PERF_N_GSM7_MESSAGES; i++)
+        g_free (reference_gsm_unpack (packed, G_N_ELEMENTS (src), 7));
+    reference_unpack_time = g_test_timer_elapsed ();
+
+    g_test_minimized_result (pack_time / PERF_N_GSM7_MESSAGES * 1e9,
+                             "GSM7 pack: %.1fns per message (one septet at a time: %.1fns)",
+                             pack_time / PERF_N_GSM7_MESSAGES * 1e9,
+                             reference_pack_time / PERF_N_GSM7_MESSAGES * 1e9);
+    g_test_minimized_result (unpack_time / PERF_N_GSM7_MESSAGES * 1e9,
+                             "GSM7 unpack: %.1fns per message (one septet at a time: %.1fns)",
+                             unpack_time / PERF_N_GSM7_MESSAGES * 1e9,
+                             reference_unpack_time / PERF_N_GSM7_MESSAGES * 1e9);
+
+    g_free (packed);
+}
+
 static void
 test_take_convert_ucs2_hex_utf8 (void)
 {
@@ -350,6 +520,146 @@ test_take_convert_ucs2_bad_ascii2 (void)
     g_assert (converted == NULL);
 }
 
+static void
+test_hex_utf8_roundtrip (void)
+{
+    static const struct {
+        MMModemCharset  charset;
+        const gchar    *utf8;
+        const gchar    *hex;
+    } tests[] = {
+        { MM_MODEM_CHARSET_UCS2,   "T-Mobile",     "0054002D004D006F00620069006C0065" },
+        { MM_MODEM_CHARSET_UCS2,   "€ホ",           "20AC30DB" },
+        { MM_MODEM_CHARSET_UCS2,   "𝄞",            "D834DD1E" },
+        { MM_MODEM_CHARSET_GSM,    "{a€}",         "1B28611B651B29" },
+        { MM_MODEM_CHARSET_8859_1, "patín",        "706174ED6E" },
+    };
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (tests); i++) {
+        gchar *hex;
+        gchar *utf8;
+
+        hex = mm_modem_charset_utf8_to_hex (tests[i].utf8, tests[i].charset);
+        g_assert_cmpstr (hex, ==, tests[i].hex);
+        utf8 = mm_modem_charset_hex_to_utf8 (hex, tests[i].charset);
+        g_assert_cmpstr (utf8, ==, tests[i].utf8);
+        g_free (utf8);
+        g_free (hex);
+    }
+
+    /* Invalid hex, odd UCS-2 lengths and lone surrogates */
+    g_assert (!mm_modem_charset_hex_to_utf8 ("00G4", MM_MODEM_CHARSET_UCS2));
+    g_assert (!mm_modem_charset_hex_to_utf8 ("005400", MM_MODEM_CHARSET_UCS2));
+    g_assert (!mm_modem_charset_hex_to_utf8 ("D8340054", MM_MODEM_CHARSET_UCS2));
+
+    /* Chars which cannot be encoded */
+    g_assert (!mm_modem_charset_utf8_to_hex ("patín", MM_MODEM_CHARSET_GSM));
+}
+
+/*****************************************************************************/
+
+#define PERF_N_MESSAGES 20000
+
+static gchar *
+build_ucs2_hex (void)
+{
+    static const gchar *text = "Your balance is 12,34€. Ütopia ホモ・サピエンス!";
+    GString *str;
+    gchar   *hex;
+
+    str = g_string_new (NULL);
+    while (str->len < 160)
+        g_string_append (str, text);
+    hex = mm_modem_charset_utf8_to_hex (str->str, MM_MODEM_CHARSET_UCS2);
+    g_string_free (str, TRUE);
+    return hex;
+}
+
+static gchar *
+legacy_ucs2_hex_to_utf8 (const gchar *hex)
+{
+    gchar *bin;
+    gsize  bin_len = 0;
+    gchar *utf8;
+
+    /* What mm_modem_charset_hex_to_utf8() used to do */
+    bin = mm_utils_hexstr2bin (hex, &bin_len);
+    utf8 = g_convert (bin, bin_len, "UTF-8//TRANSLIT", "UCS-2BE", NULL, NULL, NULL);
+    g_free (bin);
+    return utf8;
+}
+
+static void
+test_charsets_perf (void)
+{
+    gchar   *hex;
+    gchar   *expected;
+    gchar   *native;
+    gchar   *gsm_text;
+    gsize    hex_len;
+    gdouble  native_time;
+    gdouble  legacy_time;
+    gdouble  gsm_time;
+    guint    i;
+
+    if (!g_test_perf ())
+        return;
+
+    hex = build_ucs2_hex ();
+    hex_len = strlen (hex);
+    expected = legacy_ucs2_hex_to_utf8 (hex);
+    g_assert (expected);
+    native = mm_modem_charset_hex_to_utf8 (hex, MM_MODEM_CHARSET_UCS2);
+    g_assert_cmpstr (native, ==, expected);
+    g_free (native);
+
+    g_test_timer_start ();
+    for (i = 0; i < PERF_N_MESSAGES; i++) {
+        gchar *utf8;
+
+        utf8 = mm_modem_charset_hex_to_utf8 (hex, MM_MODEM_CHARSET_UCS2);
+        g_assert (utf8);
+        g_free (utf8);
+    }
+    native_time = g_test_timer_elapsed ();
+
+    g_test_timer_start ();
+    for (i = 0; i < PERF_N_MESSAGES; i++)
+        g_free (legacy_ucs2_hex_to_utf8 (hex));
+    legacy_time = g_test_timer_elapsed ();
+
+    g_test_maximized_result (hex_len * PERF_N_MESSAGES / native_time / 1e6,
+                             "UCS-2 hex to UTF-8: %.1f MB/s (iconv: %.1f MB/s)",
+                             hex_len * PERF_N_MESSAGES / native_time / 1e6,
+                             hex_len * PERF_N_MESSAGES / legacy_time / 1e6);
+
+    /* GSM round trip of a full-length message with extended chars */
+    gsm_text = g_strnfill (150, 'a');
+    memcpy (gsm_text, "{Ω€}", strlen ("{Ω€}"));
+    g_test_timer_start ();
+    for (i = 0; i < PERF_N_MESSAGES; i++) {
+        guint8  *gsm;
+        guint8  *utf8;
+        guint32  len = 0;
+
+        gsm = mm_charset_utf8_to_unpacked_gsm (gsm_text, &len);
+        utf8 = mm_charset_gsm_unpacked_to_utf8 (gsm, len);
+        g_assert (utf8);
+        g_free (utf8);
+        g_free (gsm);
+    }
+    gsm_time = g_test_timer_elapsed ();
+
+    g_test_minimized_result (gsm_time / PERF_N_MESSAGES * 1e6,
+                             "GSM round trip: %.3fus per message",
+                             gsm_time / PERF_N_MESSAGES * 1e6);
+
+    g_free (gsm_text);
+    g_free (expected);
+    g_free (hex);
+}
+
 struct charset_can_convert_to_test_s {
     const char *utf8;
     gboolean    to_gsm;
@@ -410,26 +720,6 @@ test_charset_can_covert_to (void)
     }
 }
 
-void
-_mm_log (const char *loc,
-         const char *func,
-         guint32 level,
-         const char *fmt,
-         ...)
-{
-#if defined ENABLE_TEST_MESSAGE_TRACES
-    /* Dummy log function */
-    va_list args;
-    gchar *msg;
-
-    va_start (args, fmt);
-    msg = g_strdup_vprintf (fmt, args);
-    va_end (args);
-    g_print ("%s\n", msg);
-    g_free (msg);
-#endif
-}
-
 int main (int argc, char **argv)
 {
     setlocale (LC_ALL, "");
@@ -448,6 +738,8 @@ int main (int argc, char **argv)
     g_test_add_func ("/MM/charsets/gsm7/pack/24-chars",          test_gsm7_pack_24_chars);
     g_test_add_func ("/MM/charsets/gsm7/pack/last-septet-alone", test_gsm7_pack_last_septet_alone);
     g_test_add_func ("/MM/charsets/gsm7/pack/7-chars-offset",    test_gsm7_pack_7_chars_offset);
+    g_test_add_func ("/MM/charsets/gsm7/pack-unpack/fuzz",       test_gsm7_pack_unpack_fuzz);
+    g_test_add_func ("/MM/charsets/gsm7/pack-unpack/perf",       test_gsm7_pack_unpack_perf);
 
     g_test_add_func ("/MM/charsets/take-convert/ucs2/hex",         test_take_convert_ucs2_hex_utf8);
     g_test_add_func ("/MM/charsets/take-convert/ucs2/bad-ascii",   test_take_convert_ucs2_bad_ascii);
@@ -455,5 +747,8 @@ int main (int argc, char **argv)
 
     g_test_add_func ("/MM/charsets/can-convert-to", test_charset_can_covert_to);
 
+    g_test_add_func ("/MM/charsets/hex-roundtrip", test_hex_utf8_roundtrip);
+    g_test_add_func ("/MM/charsets/perf",          test_charsets_perf);
+
     return g_test_run ();
 }
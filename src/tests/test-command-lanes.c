@@ -0,0 +1,232 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <glib.h>
+#include <locale.h>
+
+/* Define symbol to enable test message traces */
+#undef ENABLE_TEST_MESSAGE_TRACES
+
+#include "mm-command-lanes.h"
+#include "mm-log-test.h"
+
+#define LANE_INTERACTIVE 0
+#define LANE_POLL        1
+#define LANE_BACKGROUND  2
+
+typedef struct {
+    MMCommandLanesItem item;
+    guint              id;
+} Command;
+
+static Command *
+command_new (guint lane,
+             guint id)
+{
+    Command *command;
+
+    command = g_slice_new0 (Command);
+    command->item.lane = lane;
+    command->id = id;
+    return command;
+}
+
+static void
+command_free (Command *command)
+{
+    g_slice_free (Command, command);
+}
+
+static void
+queue (GQueue *q,
+       guint   lane,
+       guint   id)
+{
+    mm_command_lanes_insert (q, &command_new (lane, id)->item, FALSE);
+}
+
+/* Sends and completes the command at the head, returning its id */
+static guint
+dispatch (GQueue *q)
+{
+    Command *command;
+    guint    id;
+
+    command = g_queue_pop_head (q);
+    g_assert (command);
+    id = command->id;
+    command_free (command);
+    return id;
+}
+
+static void
+assert_order (GQueue      *q,
+              const guint *ids,
+              guint        n_ids)
+{
+    GList *l;
+    guint  i;
+
+    g_assert_cmpuint (g_queue_get_length (q), ==, n_ids);
+    for (l = q->head, i = 0; l; l = g_list_next (l), i++)
+        g_assert_cmpuint (((Command *) l->data)->id, ==, ids[i]);
+}
+
+/*****************************************************************************/
+
+static void
+test_order (void)
+{
+    GQueue      q = G_QUEUE_INIT;
+    const guint expected[] = { 3, 4, 2, 5, 1, 6 };
+
+    /* Lane order, FIFO within the same lane */
+    queue (&q, LANE_BACKGROUND,  1);
+    queue (&q, LANE_POLL,        2);
+    queue (&q, LANE_INTERACTIVE, 3);
+    queue (&q, LANE_INTERACTIVE, 4);
+    queue (&q, LANE_POLL,        5);
+    queue (&q, LANE_BACKGROUND,  6);
+    assert_order (&q, expected, G_N_ELEMENTS (expected));
+
+    g_assert_cmpuint (mm_command_lanes_get_depth (&q, LANE_INTERACTIVE), ==, 2);
+    g_assert_cmpuint (mm_command_lanes_get_depth (&q, LANE_POLL), ==, 2);
+    g_assert_cmpuint (mm_command_lanes_get_depth (&q, LANE_BACKGROUND), ==, 2);
+
+    g_queue_foreach (&q, (GFunc) command_free, NULL);
+    g_queue_clear (&q);
+}
+
+static void
+test_started (void)
+{
+    GQueue      q = G_QUEUE_INIT;
+    const guint expected[] = { 1, 3, 2 };
+
+    /* The command in flight is never overtaken */
+    queue (&q, LANE_BACKGROUND, 1);
+    ((MMCommandLanesItem *) g_queue_peek_head (&q))->started = TRUE;
+    queue (&q, LANE_BACKGROUND,  2);
+    queue (&q, LANE_INTERACTIVE, 3);
+    assert_order (&q, expected, G_N_ELEMENTS (expected));
+
+    g_queue_foreach (&q, (GFunc) command_free, NULL);
+    g_queue_clear (&q);
+}
+
+static void
+test_run_next (void)
+{
+    GQueue      q = G_QUEUE_INIT;
+    const guint expected[] = { 3, 1, 2 };
+
+    /* Whatever the lane */
+    queue (&q, LANE_INTERACTIVE, 1);
+    queue (&q, LANE_POLL,        2);
+    mm_command_lanes_insert (&q, &command_new (LANE_BACKGROUND, 3)->item, TRUE);
+    assert_order (&q, expected, G_N_ELEMENTS (expected));
+
+    g_queue_foreach (&q, (GFunc) command_free, NULL);
+    g_queue_clear (&q);
+}
+
+static void
+test_starvation (void)
+{
+    GQueue q = G_QUEUE_INIT;
+    guint  next_id = 100;
+    guint  last_interactive = 0;
+    guint  n_dispatched = 0;
+    guint  n_poll_dispatched = 0;
+    guint  background_dispatched = 0;
+    guint  i;
+
+    queue (&q, LANE_BACKGROUND, 1);
+    queue (&q, LANE_POLL,       2);
+
+    /* Interactive commands arriving faster than they are sent */
+    for (i = 0; i < 100; i++) {
+        guint id;
+
+        queue (&q, LANE_INTERACTIVE, next_id++);
+        queue (&q, LANE_INTERACTIVE, next_id++);
+
+        id = dispatch (&q);
+        n_dispatched++;
+        if (id == 1)
+            background_dispatched = n_dispatched;
+        else if (id == 2)
+            n_poll_dispatched = n_dispatched;
+        else {
+            /* Still FIFO within the lane */
+            g_assert_cmpuint (id, >, last_interactive);
+            last_interactive = id;
+        }
+    }
+
+    /* Both lower lanes got their turn, in lane order */
+    g_assert_cmpuint (n_poll_dispatched, >, 0);
+    g_assert_cmpuint (n_poll_dispatched, <=, MM_COMMAND_LANES_MAX_OVERTAKEN + 1);
+    g_assert_cmpuint (background_dispatched, >, n_poll_dispatched);
+    g_assert_cmpuint (background_dispatched, <=, MM_COMMAND_LANES_MAX_OVERTAKEN + 2);
+
+    g_queue_foreach (&q, (GFunc) command_free, NULL);
+    g_queue_clear (&q);
+}
+
+static void
+test_no_starvation_when_idle (void)
+{
+    GQueue      q = G_QUEUE_INIT;
+    const guint expected[] = { 10, 11, 12, 1 };
+    guint       i;
+
+    /* Once a command is let through, the next ones in its lane start over */
+    queue (&q, LANE_BACKGROUND, 1);
+    for (i = 0; i < MM_COMMAND_LANES_MAX_OVERTAKEN; i++)
+        queue (&q, LANE_INTERACTIVE, 100 + i);
+    queue (&q, LANE_INTERACTIVE, 200);
+    g_assert_cmpuint (((Command *) g_queue_peek_nth (&q, MM_COMMAND_LANES_MAX_OVERTAKEN))->id, ==, 1);
+    g_assert_cmpuint (((Command *) g_queue_peek_tail (&q))->id, ==, 200);
+
+    while (!g_queue_is_empty (&q))
+        dispatch (&q);
+
+    queue (&q, LANE_BACKGROUND,  1);
+    queue (&q, LANE_INTERACTIVE, 10);
+    queue (&q, LANE_INTERACTIVE, 11);
+    queue (&q, LANE_INTERACTIVE, 12);
+    assert_order (&q, expected, G_N_ELEMENTS (expected));
+
+    g_queue_foreach (&q, (GFunc) command_free, NULL);
+    g_queue_clear (&q);
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    setlocale (LC_ALL, "");
+
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/command-lanes/order", test_order);
+    g_test_add_func ("/MM/command-lanes/started", test_started);
+    g_test_add_func ("/MM/command-lanes/run-next", test_run_next);
+    g_test_add_func ("/MM/command-lanes/starvation", test_starvation);
+    g_test_add_func ("/MM/command-lanes/idle", test_no_starvation_when_idle);
+
+    return g_test_run ();
+}
@@ -0,0 +1,253 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <glib.h>
+#include <locale.h>
+
+/* Define symbol to enable test message traces */
+#undef ENABLE_TEST_MESSAGE_TRACES
+
+#include "mm-poll-scheduler.h"
+#include "mm-freshness.h"
+#include "mm-log-test.h"
+
+#define SEC(x) ((gint64) (x) * G_USEC_PER_SEC)
+
+/* Start at an arbitrary time not aligned to slots */
+#define START_TIME SEC (1000003)
+
+/* Same timeouts as the signal check in MMIfaceModem */
+#define SIGNAL_QUALITY_RECENT_TIMEOUT_SEC 60
+#define SIGNAL_CHECK_TIMEOUT_SEC          30
+#define SIGNAL_CHECK_MAX_TIMEOUT_SEC      50
+
+/* Moves the time forward up to the given time, dispatching all wakeups in
+ * between */
+static void
+run_until (MMPollScheduler *scheduler,
+           gint64          *now,
+           gint64           until)
+{
+    while (TRUE) {
+        gint64 wakeup;
+
+        wakeup = mm_poll_scheduler_get_next_wakeup (scheduler);
+        if (wakeup < 0 || wakeup > until)
+            break;
+        *now = MAX (*now, wakeup);
+        mm_poll_scheduler_set_time (scheduler, *now);
+        mm_poll_scheduler_dispatch (scheduler);
+    }
+
+    *now = until;
+    mm_poll_scheduler_set_time (scheduler, *now);
+}
+
+/*****************************************************************************/
+
+static void
+test_freshness (void)
+{
+    MMFreshness *freshness;
+    gint64       now = START_TIME;
+
+    freshness = mm_freshness_new (300);
+
+    /* Never updated */
+    g_assert (!mm_freshness_is_fresh (freshness, MM_FRESHNESS_PROPERTY_SIGNAL_QUALITY, now));
+
+    mm_freshness_update (freshness, MM_FRESHNESS_PROPERTY_SIGNAL_QUALITY, now);
+    g_assert (mm_freshness_is_fresh (freshness, MM_FRESHNESS_PROPERTY_SIGNAL_QUALITY, now + SEC (299)));
+    g_assert (!mm_freshness_is_fresh (freshness, MM_FRESHNESS_PROPERTY_SIGNAL_QUALITY, now + SEC (300)));
+    g_assert (!mm_freshness_is_fresh (freshness, MM_FRESHNESS_PROPERTY_ACCESS_TECHNOLOGIES, now));
+
+    mm_freshness_clear (freshness, MM_FRESHNESS_PROPERTY_SIGNAL_QUALITY);
+    g_assert (!mm_freshness_is_fresh (freshness, MM_FRESHNESS_PROPERTY_SIGNAL_QUALITY, now));
+
+    mm_freshness_free (freshness);
+
+    /* No deadline, always stale */
+    freshness = mm_freshness_new (0);
+    mm_freshness_update (freshness, MM_FRESHNESS_PROPERTY_OPERATOR, now);
+    g_assert (!mm_freshness_is_fresh (freshness, MM_FRESHNESS_PROPERTY_OPERATOR, now));
+    mm_freshness_free (freshness);
+}
+
+static void
+test_freshness_expiry (void)
+{
+    MMFreshness *freshness;
+
+    freshness = mm_freshness_new (MM_FRESHNESS_DEFAULT_DEADLINE_SEC);
+    mm_freshness_set_expiry (freshness,
+                             MM_FRESHNESS_PROPERTY_SIGNAL_QUALITY,
+                             SIGNAL_QUALITY_RECENT_TIMEOUT_SEC,
+                             SIGNAL_CHECK_MAX_TIMEOUT_SEC);
+    g_assert_cmpuint (mm_freshness_get_deadline (freshness, MM_FRESHNESS_PROPERTY_SIGNAL_QUALITY), ==,
+                      SIGNAL_QUALITY_RECENT_TIMEOUT_SEC - SIGNAL_CHECK_MAX_TIMEOUT_SEC - MM_POLL_SCHEDULER_SLOT_SEC);
+    /* Other properties not affected */
+    g_assert_cmpuint (mm_freshness_get_deadline (freshness, MM_FRESHNESS_PROPERTY_OPERATOR), ==,
+                      MM_FRESHNESS_DEFAULT_DEADLINE_SEC);
+
+    /* Expiry too short for the checks, always poll */
+    mm_freshness_set_expiry (freshness, MM_FRESHNESS_PROPERTY_OPERATOR, 30, 30);
+    g_assert_cmpuint (mm_freshness_get_deadline (freshness, MM_FRESHNESS_PROPERTY_OPERATOR), ==, 0);
+    mm_freshness_free (freshness);
+
+    /* A deadline shorter than the limit is kept */
+    freshness = mm_freshness_new (1);
+    mm_freshness_set_expiry (freshness,
+                             MM_FRESHNESS_PROPERTY_SIGNAL_QUALITY,
+                             SIGNAL_QUALITY_RECENT_TIMEOUT_SEC,
+                             SIGNAL_CHECK_MAX_TIMEOUT_SEC);
+    g_assert_cmpuint (mm_freshness_get_deadline (freshness, MM_FRESHNESS_PROPERTY_SIGNAL_QUALITY), ==, 1);
+    mm_freshness_free (freshness);
+}
+
+/*****************************************************************************/
+
+/* Signal check of a modem reporting signal quality changes in unsolicited
+ * messages, every given number of seconds; the check backs off while polls
+ * find no changes, as in MMIfaceModem */
+typedef struct {
+    MMPollScheduler *scheduler;
+    MMFreshness     *freshness;
+    gint64          *now;
+    guint            id;
+    guint            n_polls;
+    /* Longest time without any update, so without a recent signal quality */
+    gint64           last_update;
+    gint64           max_gap;
+} FreshnessCheck;
+
+static void
+freshness_check_updated (FreshnessCheck *check)
+{
+    check->max_gap = MAX (check->max_gap, *check->now - check->last_update);
+    check->last_update = *check->now;
+    mm_freshness_update (check->freshness, MM_FRESHNESS_PROPERTY_SIGNAL_QUALITY, *check->now);
+}
+
+static void
+freshness_check_cb (FreshnessCheck *check)
+{
+    if (mm_freshness_is_fresh (check->freshness, MM_FRESHNESS_PROPERTY_SIGNAL_QUALITY, *check->now)) {
+        mm_poll_scheduler_skip (check->scheduler, check->id);
+        return;
+    }
+
+    check->n_polls++;
+    freshness_check_updated (check);
+    mm_poll_scheduler_report (check->scheduler, check->id, FALSE);
+}
+
+static guint
+freshness_run_polls (guint   deadline,
+                     gboolean expiry,
+                     guint    unsolicited_interval,
+                     gint64  *max_gap)
+{
+    MMPollScheduler *scheduler;
+    FreshnessCheck   check;
+    gint64           now = START_TIME;
+    gint64           end = START_TIME + SEC (3600);
+
+    scheduler = mm_poll_scheduler_new ();
+    mm_poll_scheduler_set_time (scheduler, now);
+
+    check.scheduler = scheduler;
+    check.freshness = mm_freshness_new (deadline);
+    if (expiry)
+        mm_freshness_set_expiry (check.freshness,
+                                 MM_FRESHNESS_PROPERTY_SIGNAL_QUALITY,
+                                 SIGNAL_QUALITY_RECENT_TIMEOUT_SEC,
+                                 SIGNAL_CHECK_MAX_TIMEOUT_SEC);
+    check.now = &now;
+    check.n_polls = 0;
+    check.last_update = now;
+    check.max_gap = 0;
+    check.id = mm_poll_scheduler_add (scheduler, "test", "signal-check",
+                                      SIGNAL_CHECK_TIMEOUT_SEC, SIGNAL_CHECK_MAX_TIMEOUT_SEC,
+                                      (MMPollSchedulerFunc) freshness_check_cb, &check);
+
+    /* Initial value loaded when enabling */
+    freshness_check_updated (&check);
+
+    while (now < end) {
+        run_until (scheduler, &now, MIN (now + SEC (unsolicited_interval), end));
+        freshness_check_updated (&check);
+    }
+
+    if (max_gap)
+        *max_gap = check.max_gap;
+
+    mm_freshness_free (check.freshness);
+    mm_poll_scheduler_free (scheduler);
+    return check.n_polls;
+}
+
+static void
+test_freshness_polls (void)
+{
+    guint n_polls;
+
+    /* Always polling without deadline, backing off up to once every 50s */
+    n_polls = freshness_run_polls (0, FALSE, 3600, NULL);
+    g_assert_cmpuint (n_polls, >=, 3600 / SIGNAL_CHECK_MAX_TIMEOUT_SEC);
+
+    /* Idle modem: polls only when the last value got stale */
+    g_assert_cmpuint (freshness_run_polls (MM_FRESHNESS_DEFAULT_DEADLINE_SEC, FALSE, 3600, NULL), <=, n_polls / 5 + 1);
+
+    /* Modem reporting changes often enough: never polls */
+    g_assert_cmpuint (freshness_run_polls (MM_FRESHNESS_DEFAULT_DEADLINE_SEC, FALSE, 60, NULL), ==, 0);
+    g_assert_cmpuint (freshness_run_polls (MM_FRESHNESS_DEFAULT_DEADLINE_SEC, TRUE, 1, NULL), ==, 0);
+}
+
+static void
+test_freshness_recent (void)
+{
+    guint  unsolicited_interval;
+    gint64 max_gap;
+
+    /* Without limit, once unsolicited updates stop, the next poll comes long
+     * after the signal quality stopped being recent */
+    freshness_run_polls (MM_FRESHNESS_DEFAULT_DEADLINE_SEC, FALSE, 3600, &max_gap);
+    g_assert_cmpint (max_gap, >=, SEC (SIGNAL_QUALITY_RECENT_TIMEOUT_SEC));
+
+    /* With the limit, the signal quality is always recent, whatever the rate
+     * of unsolicited updates */
+    for (unsolicited_interval = 1; unsolicited_interval <= 180; unsolicited_interval++) {
+        freshness_run_polls (MM_FRESHNESS_DEFAULT_DEADLINE_SEC, TRUE, unsolicited_interval, &max_gap);
+        g_assert_cmpint (max_gap, <, SEC (SIGNAL_QUALITY_RECENT_TIMEOUT_SEC));
+    }
+    freshness_run_polls (MM_FRESHNESS_DEFAULT_DEADLINE_SEC, TRUE, 3600, &max_gap);
+    g_assert_cmpint (max_gap, <, SEC (SIGNAL_QUALITY_RECENT_TIMEOUT_SEC));
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    setlocale (LC_ALL, "");
+
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/freshness/deadline", test_freshness);
+    g_test_add_func ("/MM/freshness/expiry",   test_freshness_expiry);
+    g_test_add_func ("/MM/freshness/polls",    test_freshness_polls);
+    g_test_add_func ("/MM/freshness/recent",   test_freshness_recent);
+
+    return g_test_run ();
+}
@@ -0,0 +1,110 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <glib.h>
+#include <locale.h>
+
+/* Define symbol to enable test message traces */
+#undef ENABLE_TEST_MESSAGE_TRACES
+
+#include "mm-histogram.h"
+#include "mm-log-test.h"
+
+/*****************************************************************************/
+
+static void
+test_histogram_empty (void)
+{
+    MMHistogram histogram;
+
+    mm_histogram_reset (&histogram);
+    g_assert_cmpuint (histogram.count, ==, 0);
+    g_assert_cmpuint (mm_histogram_get_mean (&histogram), ==, 0);
+    g_assert_cmpuint (mm_histogram_get_percentile (&histogram, 50.0), ==, 0);
+    g_assert_cmpuint (mm_histogram_get_percentile (&histogram, 100.0), ==, 0);
+}
+
+static void
+test_histogram_exact (void)
+{
+    MMHistogram histogram;
+    guint       i;
+
+    /* Small values get one bucket each */
+    mm_histogram_reset (&histogram);
+    for (i = 1; i <= 10; i++)
+        mm_histogram_record (&histogram, i);
+
+    g_assert_cmpuint (histogram.count, ==, 10);
+    g_assert_cmpuint (histogram.min, ==, 1);
+    g_assert_cmpuint (histogram.max, ==, 10);
+    g_assert_cmpuint (mm_histogram_get_mean (&histogram), ==, 5);
+    g_assert_cmpuint (mm_histogram_get_percentile (&histogram, 0.0), ==, 1);
+    g_assert_cmpuint (mm_histogram_get_percentile (&histogram, 50.0), ==, 5);
+    g_assert_cmpuint (mm_histogram_get_percentile (&histogram, 90.0), ==, 9);
+    g_assert_cmpuint (mm_histogram_get_percentile (&histogram, 100.0), ==, 10);
+}
+
+static void
+test_histogram_precision (void)
+{
+    MMHistogram histogram;
+    guint64     value;
+
+    /* Any single value is reported within the bucket precision */
+    for (value = 1; value < (G_GUINT64_CONSTANT (1) << 34); value = (value * 3) / 2 + 1) {
+        guint64 p50;
+
+        mm_histogram_reset (&histogram);
+        mm_histogram_record (&histogram, value);
+        mm_histogram_record (&histogram, value);
+        p50 = mm_histogram_get_percentile (&histogram, 50.0);
+        g_assert_cmpuint (p50, ==, value);
+    }
+
+    /* With values spread over several buckets, percentiles are the upper
+     * bound of the bucket, so never lower and at most 12.5% higher */
+    mm_histogram_reset (&histogram);
+    for (value = 1000; value < 2000; value++)
+        mm_histogram_record (&histogram, value);
+    value = mm_histogram_get_percentile (&histogram, 50.0);
+    g_assert_cmpuint (value, >=, 1499);
+    g_assert_cmpuint (value, <=, 1499 + 1499 / 8);
+    value = mm_histogram_get_percentile (&histogram, 99.0);
+    g_assert_cmpuint (value, >=, 1989);
+    g_assert_cmpuint (value, <=, 1999);
+
+    /* Values above the range end up in the last bucket, reported as max */
+    mm_histogram_reset (&histogram);
+    mm_histogram_record (&histogram, 10);
+    mm_histogram_record (&histogram, MM_HISTOGRAM_MAX_VALUE * 4);
+    g_assert_cmpuint (mm_histogram_get_percentile (&histogram, 100.0), ==, MM_HISTOGRAM_MAX_VALUE * 4);
+    g_assert_cmpuint (mm_histogram_get_percentile (&histogram, 50.0), ==, 10);
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    setlocale (LC_ALL, "");
+
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/histogram/empty",     test_histogram_empty);
+    g_test_add_func ("/MM/histogram/exact",     test_histogram_exact);
+    g_test_add_func ("/MM/histogram/precision", test_histogram_precision);
+
+    return g_test_run ();
+}
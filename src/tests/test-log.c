@@ -0,0 +1,308 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <locale.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* This test runs the actual logging setup of the daemon, writing to a
+ * temporary log file, so it doesn't use the logging stubs of the other
+ * tests */
+#include "mm-log.h"
+
+#define N_THREADS             4
+#define N_MESSAGES_PER_THREAD 2000
+
+typedef struct {
+    gchar *path;
+} TestFixture;
+
+static void
+fixture_setup (TestFixture *fixture,
+               const gchar *level)
+{
+    GError *error = NULL;
+    gint    fd;
+
+    fd = g_file_open_tmp ("test-log-XXXXXX", &fixture->path, &error);
+    g_assert_no_error (error);
+    close (fd);
+
+    g_assert (mm_log_setup (level, fixture->path, FALSE, FALSE, FALSE, &error));
+    g_assert_no_error (error);
+}
+
+static void
+fixture_teardown (TestFixture *fixture)
+{
+    g_unlink (fixture->path);
+    g_free (fixture->path);
+}
+
+static gchar **
+read_lines (TestFixture *fixture)
+{
+    GError *error = NULL;
+    gchar  *contents;
+    gchar **lines;
+
+    g_assert (g_file_get_contents (fixture->path, &contents, NULL, &error));
+    g_assert_no_error (error);
+    lines = g_strsplit (contents, "\n", -1);
+    g_free (contents);
+    return lines;
+}
+
+/* Finds the given key in the line and reads the number after it */
+static gboolean
+parse_line (const gchar *line,
+            const gchar *key,
+            guint       *num)
+{
+    const gchar *found;
+
+    found = strstr (line, key);
+    if (!found)
+        return FALSE;
+    return sscanf (found + strlen (key), "%u", num) == 1;
+}
+
+/*****************************************************************************/
+
+static void
+test_flush_on_shutdown (void)
+{
+    TestFixture   fixture;
+    gchar       **lines;
+    guint         i;
+    guint         n = 0;
+
+    fixture_setup (&fixture, "INFO");
+
+    for (i = 0; i < 1000; i++)
+        mm_info ("message %u", i);
+    /* Below the log level */
+    mm_dbg ("debug message");
+    mm_log_shutdown ();
+
+    /* Everything queued is written, in order */
+    lines = read_lines (&fixture);
+    for (i = 0; lines[i]; i++) {
+        guint num;
+
+        g_assert (!strstr (lines[i], "debug message"));
+        if (!parse_line (lines[i], "message ", &num))
+            continue;
+        g_assert_cmpuint (num, ==, n);
+        n++;
+    }
+    g_assert_cmpuint (n, ==, 1000);
+
+    g_strfreev (lines);
+    fixture_teardown (&fixture);
+}
+
+static void
+test_error_flush (void)
+{
+    TestFixture   fixture;
+    gchar       **lines;
+    guint         i;
+    guint         n = 0;
+    gboolean      found = FALSE;
+
+    fixture_setup (&fixture, "INFO");
+
+    for (i = 0; i < 1000; i++)
+        mm_info ("message %u", i);
+    mm_err ("fatal error");
+
+    /* Errors are written synchronously, along with everything before them */
+    lines = read_lines (&fixture);
+    for (i = 0; lines[i]; i++) {
+        guint num;
+
+        if (strstr (lines[i], "fatal error")) {
+            g_assert_cmpuint (n, ==, 1000);
+            found = TRUE;
+            continue;
+        }
+        if (!parse_line (lines[i], "message ", &num))
+            continue;
+        g_assert (!found);
+        g_assert_cmpuint (num, ==, n);
+        n++;
+    }
+    g_assert (found);
+    g_strfreev (lines);
+
+    mm_log_shutdown ();
+    fixture_teardown (&fixture);
+}
+
+static gpointer
+producer_thread (gpointer data)
+{
+    guint id;
+    guint i;
+
+    id = GPOINTER_TO_UINT (data);
+    for (i = 0; i < N_MESSAGES_PER_THREAD; i++)
+        mm_info ("thread %u message %u", id, i);
+    return NULL;
+}
+
+static void
+test_ordering (void)
+{
+    TestFixture   fixture;
+    GThread      *threads[N_THREADS];
+    guint         next[N_THREADS] = { 0 };
+    gchar       **lines;
+    guint         i;
+
+    fixture_setup (&fixture, "INFO");
+
+    for (i = 0; i < N_THREADS; i++)
+        threads[i] = g_thread_new ("producer", producer_thread, GUINT_TO_POINTER (i));
+    for (i = 0; i < N_THREADS; i++)
+        g_thread_join (threads[i]);
+    mm_log_shutdown ();
+
+    /* Messages of different threads may be interleaved, but the ones of
+     * each thread are all there, whole and in order */
+    lines = read_lines (&fixture);
+    for (i = 0; lines[i]; i++) {
+        guint id;
+        guint num;
+
+        if (!parse_line (lines[i], "thread ", &id))
+            continue;
+        g_assert (parse_line (lines[i], "message ", &num));
+        g_assert_cmpuint (id, <, N_THREADS);
+        g_assert_cmpuint (num, ==, next[id]);
+        next[id]++;
+    }
+    for (i = 0; i < N_THREADS; i++)
+        g_assert_cmpuint (next[i], ==, N_MESSAGES_PER_THREAD);
+
+    g_strfreev (lines);
+    fixture_teardown (&fixture);
+}
+
+/*****************************************************************************/
+
+static void
+test_trace_ring_overflow (void)
+{
+    TestFixture   fixture;
+    gchar       **lines;
+    guint         i;
+    guint         n = 0;
+    gboolean      header = FALSE;
+
+    fixture_setup (&fixture, "INFO");
+
+    /* Kept even if not logged */
+    for (i = 0; i < MM_LOG_TRACE_RING_SIZE + 44; i++)
+        mm_trace ("modem-a", "trace %u", i);
+    mm_trace ("modem-b", "trace %u", 1000);
+    mm_log_trace_dump ("modem-a");
+    mm_log_shutdown ();
+
+    /* Only the last ones, oldest first, and only of the given owner */
+    lines = read_lines (&fixture);
+    for (i = 0; lines[i]; i++) {
+        guint num;
+
+        if (strstr (lines[i], "(modem-a) recent traces:")) {
+            header = TRUE;
+            continue;
+        }
+        g_assert (!strstr (lines[i], "modem-b"));
+        if (!parse_line (lines[i], "trace ", &num))
+            continue;
+        g_assert (header);
+        g_assert (g_str_has_prefix (lines[i], "(modem-a) "));
+        g_assert_cmpuint (num, ==, 44 + n);
+        n++;
+    }
+    g_assert_cmpuint (n, ==, MM_LOG_TRACE_RING_SIZE);
+
+    mm_log_trace_forget ("modem-a");
+    mm_log_trace_forget ("modem-b");
+    g_strfreev (lines);
+    fixture_teardown (&fixture);
+}
+
+static void
+test_trace_ring_forget (void)
+{
+    TestFixture   fixture;
+    gchar       **lines;
+    guint         i;
+    guint         n_a = 0;
+    guint         n_b = 0;
+
+    fixture_setup (&fixture, "DEBUG");
+
+    for (i = 0; i < 3; i++) {
+        mm_trace ("modem-a", "trace %u", i);
+        mm_trace ("modem-b", "trace %u", i);
+    }
+    mm_log_trace_forget ("modem-a");
+    /* All the owners left */
+    mm_log_trace_dump (NULL);
+    mm_log_shutdown ();
+
+    /* Traces are logged as they come in debug level, and dumped afterwards
+     * only for the owners that weren't forgotten */
+    lines = read_lines (&fixture);
+    for (i = 0; lines[i]; i++) {
+        if (!strstr (lines[i], "trace "))
+            continue;
+        if (g_str_has_prefix (lines[i], "(modem-a) "))
+            n_a++;
+        else if (g_str_has_prefix (lines[i], "(modem-b) "))
+            n_b++;
+    }
+    g_assert_cmpuint (n_a, ==, 0);
+    g_assert_cmpuint (n_b, ==, 3);
+    g_assert_cmpuint (g_strv_length (lines), ==, 6 + 1 + 3 + 1);
+
+    mm_log_trace_forget ("modem-b");
+    g_strfreev (lines);
+    fixture_teardown (&fixture);
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    setlocale (LC_ALL, "");
+
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/log/flush-on-shutdown",   test_flush_on_shutdown);
+    g_test_add_func ("/MM/log/error-flush",         test_error_flush);
+    g_test_add_func ("/MM/log/ordering",            test_ordering);
+    g_test_add_func ("/MM/log/trace-ring/overflow", test_trace_ring_overflow);
+    g_test_add_func ("/MM/log/trace-ring/forget",   test_trace_ring_forget);
+
+    return g_test_run ();
+}
@@ -21,7 +21,7 @@
 
 #include "mm-enums-types.h"
 #include "mm-modem-helpers-qmi.h"
-#include "mm-log.h"
+#include "mm-log-test.h"
 
 static void
 test_capabilities_expected (MMQmiCapabilitiesContext *ctx,
@@ -309,26 +309,6 @@ test_gobi3k_cdma (void)
 
 /*****************************************************************************/
 
-void
-_mm_log (const char *loc,
-         const char *func,
-         guint32 level,
-         const char *fmt,
-         ...)
-{
-#if defined ENABLE_TEST_MESSAGE_TRACES
-    /* Dummy log function */
-    va_list args;
-    gchar *msg;
-
-    va_start (args, fmt);
-    msg = g_strdup_vprintf (fmt, args);
-    va_end (args);
-    g_print ("%s\n", msg);
-    g_free (msg);
-#endif
-}
-
 int main (int argc, char **argv)
 {
     setlocale (LC_ALL, "");
@@ -21,7 +21,8 @@
 
 #include <libmm-glib.h>
 #include "mm-modem-helpers.h"
-#include "mm-log.h"
+#include "mm-at-tokenizer.h"
+#include "mm-log-test.h"
 
 #if defined ENABLE_TEST_MESSAGE_TRACES
 #define trace(message, ...) g_print (message, ##__VA_ARGS__)
@@ -881,6 +882,20 @@ test_cops_response_samsung_z810 (void *f, gpointer d)
     test_cops_results ("Samsung Z810", reply, &expected[0], G_N_ELEMENTS (expected));
 }
 
+static void
+test_cops_response_mixed_format (void *f, gpointer d)
+{
+    /* Entries with and without access technology in the same response */
+    const char *reply = "+COPS: (2,\"T-Mobile\",\"TMO\",\"31026\",2),(1,\"AT&T\",,\"310410\"),(1,\"Cingular\",\"Cinglr\",\"310410\",0),,(0,1,2,3,4),(0,1,2)";
+    static MM3gppNetworkInfo expected[] = {
+        { MM_MODEM_3GPP_NETWORK_AVAILABILITY_CURRENT, "T-Mobile", "TMO", "31026", MM_MODEM_ACCESS_TECHNOLOGY_UMTS },
+        { MM_MODEM_3GPP_NETWORK_AVAILABILITY_AVAILABLE, "AT&T", NULL, "310410", MM_MODEM_ACCESS_TECHNOLOGY_GSM },
+        { MM_MODEM_3GPP_NETWORK_AVAILABILITY_AVAILABLE, "Cingular", "Cinglr", "310410", MM_MODEM_ACCESS_TECHNOLOGY_GSM },
+    };
+
+    test_cops_results ("mixed format", reply, &expected[0], G_N_ELEMENTS (expected));
+}
+
 static void
 test_cops_response_gsm_invalid (void *f, gpointer d)
 {
@@ -4005,27 +4020,194 @@ test_bcd_to_string (void *f, gpointer d)
 }
 
 /*****************************************************************************/
+/* Test the AT response tokenizer */
+
+static void
+test_at_tokenizer (void *f, gpointer d)
+{
+    const gchar   *str = "+TAG: 1, \"two\" ,(1-3),,(\"a\",(\"b,c\")),  0A \r\n\r\n+OTHER: 5\r\n+TAG: -7\r\nraw, line ";
+    MMAtTokenizer  tokenizer;
+    MMAtTokenizer  group;
+    MMAtToken      token;
+    guint          uval;
+    gint           ival;
+    guint          min;
+    guint          max;
+    gchar         *dup;
+
+    mm_at_tokenizer_init (&tokenizer, str, -1);
+    g_assert (mm_at_tokenizer_next_line (&tokenizer, "+TAG:"));
+
+    g_assert (mm_at_tokenizer_next (&tokenizer, &token));
+    g_assert_cmpint (token.type, ==, MM_AT_TOKEN_TYPE_VALUE);
+    g_assert (mm_at_token_get_uint (&token, &uval));
+    g_assert_cmpuint (uval, ==, 1);
+
+    g_assert (mm_at_tokenizer_next (&tokenizer, &token));
+    g_assert_cmpint (token.type, ==, MM_AT_TOKEN_TYPE_STRING);
+    g_assert (mm_at_token_equal (&token, "two"));
+    g_assert (!mm_at_token_get_uint (&token, &uval));
+
+    g_assert (mm_at_tokenizer_next (&tokenizer, &token));
+    g_assert_cmpint (token.type, ==, MM_AT_TOKEN_TYPE_GROUP);
+    g_assert (mm_at_token_get_range (&token, &min, &max));
+    g_assert_cmpuint (min, ==, 1);
+    g_assert_cmpuint (max, ==, 3);
+
+    g_assert (mm_at_tokenizer_next (&tokenizer, &token));
+    g_assert_cmpint (token.type, ==, MM_AT_TOKEN_TYPE_NONE);
+    g_assert (!mm_at_token_dup (&token));
+
+    /* Nested groups, with separators within quotes */
+    g_assert (mm_at_tokenizer_next (&tokenizer, &token));
+    g_assert_cmpint (token.type, ==, MM_AT_TOKEN_TYPE_GROUP);
+    mm_at_tokenizer_init_group (&group, &token);
+    g_assert (mm_at_tokenizer_next (&group, &token));
+    g_assert (mm_at_token_equal (&token, "a"));
+    g_assert (mm_at_tokenizer_next (&group, &token));
+    g_assert_cmpint (token.type, ==, MM_AT_TOKEN_TYPE_GROUP);
+    dup = mm_at_token_dup (&token);
+    g_assert_cmpstr (dup, ==, "\"b,c\"");
+    g_free (dup);
+    g_assert (!mm_at_tokenizer_next (&group, &token));
+
+    g_assert (mm_at_tokenizer_next (&tokenizer, &token));
+    g_assert (mm_at_token_get_hex (&token, &uval));
+    g_assert_cmpuint (uval, ==, 0x0A);
+
+    g_assert (!mm_at_tokenizer_next (&tokenizer, &token));
+
+    /* Lines with other tags are skipped */
+    g_assert (mm_at_tokenizer_next_line (&tokenizer, "+TAG:"));
+    g_assert (mm_at_tokenizer_next (&tokenizer, &token));
+    g_assert (mm_at_token_get_int (&token, &ival));
+    g_assert_cmpint (ival, ==, -7);
+
+    /* Raw lines */
+    g_assert (mm_at_tokenizer_next_line (&tokenizer, NULL));
+    g_assert (mm_at_tokenizer_rest (&tokenizer, &token));
+    dup = mm_at_token_dup (&token);
+    g_assert_cmpstr (dup, ==, "raw, line");
+    g_free (dup);
+
+    g_assert (!mm_at_tokenizer_next_line (&tokenizer, NULL));
+}
 
-void
-_mm_log (const char *loc,
-         const char *func,
-         guint32 level,
-         const char *fmt,
-         ...)
+/*****************************************************************************/
+/* Compare the tokenizer based parsers with the previous regex based ones */
+
+#define PERF_N_ITERATIONS 2000
+#define PERF_N_CMGL       200
+
+static void
+legacy_regex_parse (const gchar        *pattern,
+                    GRegexCompileFlags  flags,
+                    const gchar        *reply)
 {
-#if defined ENABLE_TEST_MESSAGE_TRACES
-    /* Dummy log function */
-    va_list args;
-    gchar *msg;
-
-    va_start (args, fmt);
-    msg = g_strdup_vprintf (fmt, args);
-    va_end (args);
-    g_print ("%s\n", msg);
-    g_free (msg);
-#endif
+    GRegex     *r;
+    GMatchInfo *match_info = NULL;
+
+    /* Compile, match and fetch every field, as the parsers used to do */
+    r = g_regex_new (pattern, flags, 0, NULL);
+    g_assert (r);
+    g_regex_match_full (r, reply, strlen (reply), 0, 0, &match_info, NULL);
+    while (g_match_info_matches (match_info)) {
+        gint i;
+
+        for (i = 1; i < g_match_info_get_match_count (match_info); i++)
+            g_free (g_match_info_fetch (match_info, i));
+        g_match_info_next (match_info, NULL);
+    }
+    g_match_info_free (match_info);
+    g_regex_unref (r);
 }
 
+static void
+test_at_tokenizer_perf (void *f, gpointer d)
+{
+    const gchar *cgdcont =
+        "+CGDCONT: 1,\"IP\",\"nate.sktelecom.com\",\"\",0,0\r\n"
+        "+CGDCONT: 2,\"IP\",\"epc.tmobile.com\",\"\",0,0\r\n"
+        "+CGDCONT: 3,\"IP\",\"MAXROAM.com\",\"\",0,0\r\n";
+    const gchar *cind =
+        "+CIND: (\"Voice Mail\",(0,1)),(\"service\",(0,1)),(\"call\",(0,1)),(\"Roam\",(0-2)),"
+        "(\"signal\",(0-5)),(\"callsetup\",(0-3)),(\"smsfull\",(0,1))";
+    const gchar *cesq = "+CESQ: 99,99,255,255,20,80";
+    GString     *cmgl;
+    guint        i;
+    gdouble      legacy_time;
+    gdouble      tokenizer_time;
+    gdouble      legacy_cmgl_time;
+    gdouble      tokenizer_cmgl_time;
+
+    if (!g_test_perf ())
+        return;
+
+    cmgl = g_string_new (NULL);
+    for (i = 0; i < PERF_N_CMGL; i++)
+        g_string_append_printf (cmgl,
+                                "+CMGL: %u,1,,147\r\n07914306073011F00405812261F700003130916191314095C27"
+                                "4D96D2FBBD3E437280CB2BEC961F3DB5D76818EF2F0381D9E83E06F39A8CC2E9FD372F"
+                                "77BEE0249CBE37A594E0E83E2F532085E2F93CB73D0B93CA7A7DFEEB01C447F93DF731"
+                                "0BD3E07CDCB727B7A9C7ECF41E432C8FC96B7C32079189E26874179D0F8DD7E93C3A0B"
+                                "21B246AA641D637396C7EBBCB22D0FD7E77B5D376B3AB3C07\r\n", i);
+
+    g_test_timer_start ();
+    for (i = 0; i < PERF_N_ITERATIONS; i++) {
+        legacy_regex_parse ("\\+CGDCONT:\\s*(\\d+)\\s*,([^, \\)]*)\\s*,([^, \\)]*)\\s*,([^, \\)]*)",
+                            G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW, cgdcont);
+        legacy_regex_parse ("\\(([^,]*),\\((\\d+)[-,](\\d+).*\\)", G_REGEX_UNGREEDY, cind);
+        legacy_regex_parse ("\\+CESQ: (\\d+),(\\d+),(\\d+),(\\d+),(\\d+),(\\d+)(?:\\r\\n)?", 0, cesq);
+    }
+    legacy_time = g_test_timer_elapsed ();
+
+    g_test_timer_start ();
+    for (i = 0; i < PERF_N_ITERATIONS; i++) {
+        GList      *list;
+        GHashTable *hash;
+        guint       rxlev, ber, rscp, ecn0, rsrq, rsrp;
+
+        list = mm_3gpp_parse_cgdcont_read_response (cgdcont, NULL);
+        g_assert_cmpuint (g_list_length (list), ==, 3);
+        mm_3gpp_pdp_context_list_free (list);
+        hash = mm_3gpp_parse_cind_test_response (cind, NULL);
+        g_assert_cmpuint (g_hash_table_size (hash), ==, 7);
+        g_hash_table_unref (hash);
+        g_assert (mm_3gpp_parse_cesq_response (cesq, &rxlev, &ber, &rscp, &ecn0, &rsrq, &rsrp, NULL));
+    }
+    tokenizer_time = g_test_timer_elapsed ();
+
+    g_test_timer_start ();
+    for (i = 0; i < PERF_N_ITERATIONS / 100; i++)
+        legacy_regex_parse ("\\+CMGL:\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,(.*)\\r\\n([^\\r\\n]*)(\\r\\n)?",
+                            G_REGEX_RAW | G_REGEX_OPTIMIZE, cmgl->str);
+    legacy_cmgl_time = g_test_timer_elapsed ();
+
+    g_test_timer_start ();
+    for (i = 0; i < PERF_N_ITERATIONS / 100; i++) {
+        GList *list;
+
+        list = mm_3gpp_parse_pdu_cmgl_response (cmgl->str, NULL);
+        g_assert_cmpuint (g_list_length (list), ==, PERF_N_CMGL);
+        mm_3gpp_pdu_info_list_free (list);
+    }
+    tokenizer_cmgl_time = g_test_timer_elapsed ();
+
+    g_test_minimized_result (tokenizer_time / PERF_N_ITERATIONS * 1e6,
+                             "CGDCONT+CIND+CESQ: %.3fus per set (regex: %.3fus)",
+                             tokenizer_time / PERF_N_ITERATIONS * 1e6,
+                             legacy_time / PERF_N_ITERATIONS * 1e6);
+    g_test_minimized_result (tokenizer_cmgl_time / (PERF_N_ITERATIONS / 100) * 1e3,
+                             "+CMGL with %u messages: %.3fms (regex: %.3fms)",
+                             PERF_N_CMGL,
+                             tokenizer_cmgl_time / (PERF_N_ITERATIONS / 100) * 1e3,
+                             legacy_cmgl_time / (PERF_N_ITERATIONS / 100) * 1e3);
+
+    g_string_free (cmgl, TRUE);
+}
+
+/*****************************************************************************/
+
 #define TESTCASE(t, d) g_test_create_case (#t, 0, d, NULL, (GTestFixtureFunc) t, NULL)
 
 int main (int argc, char **argv)
@@ -4088,6 +4270,7 @@ int main (int argc, char **argv)
     g_test_suite_add (suite, TESTCASE (test_cops_response_gobi, NULL));
     g_test_suite_add (suite, TESTCASE (test_cops_response_sek600i, NULL));
     g_test_suite_add (suite, TESTCASE (test_cops_response_samsung_z810, NULL));
+    g_test_suite_add (suite, TESTCASE (test_cops_response_mixed_format, NULL));
 
     g_test_suite_add (suite, TESTCASE (test_cops_response_gsm_invalid, NULL));
     g_test_suite_add (suite, TESTCASE (test_cops_response_umts_invalid, NULL));
@@ -4240,6 +4423,9 @@ int main (int argc, char **argv)
 
     g_test_suite_add (suite, TESTCASE (test_bcd_to_string, NULL));
 
+    g_test_suite_add (suite, TESTCASE (test_at_tokenizer, NULL));
+    g_test_suite_add (suite, TESTCASE (test_at_tokenizer_perf, NULL));
+
     result = g_test_run ();
 
     reg_test_data_free (reg_data);
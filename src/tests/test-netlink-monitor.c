@@ -0,0 +1,263 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <glib.h>
+#include <locale.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <linux/if.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+/* Define symbol to enable test message traces */
+#undef ENABLE_TEST_MESSAGE_TRACES
+
+#include "mm-netlink-monitor.h"
+#include "mm-log-test.h"
+
+/*****************************************************************************/
+
+typedef struct {
+    guint32 data[1024];
+} TestMessage;
+
+static struct nlmsghdr *
+test_message_init (TestMessage *message,
+                   guint16      type,
+                   guint        flags)
+{
+    struct nlmsghdr  *hdr = (struct nlmsghdr *) message->data;
+    struct ifinfomsg *ifi;
+
+    memset (message, 0, sizeof (*message));
+    hdr->nlmsg_type = type;
+    hdr->nlmsg_len = NLMSG_LENGTH (sizeof (struct ifinfomsg));
+    ifi = NLMSG_DATA (hdr);
+    ifi->ifi_family = AF_UNSPEC;
+    ifi->ifi_index = 3;
+    ifi->ifi_flags = flags;
+    return hdr;
+}
+
+static void
+test_message_add_attr (struct nlmsghdr *hdr,
+                       guint16          type,
+                       gconstpointer    data,
+                       gsize            length)
+{
+    struct rtattr *rta;
+
+    rta = (struct rtattr *) (((guint8 *) hdr) + NLMSG_ALIGN (hdr->nlmsg_len));
+    rta->rta_type = type;
+    rta->rta_len = RTA_LENGTH (length);
+    memcpy (RTA_DATA (rta), data, length);
+    hdr->nlmsg_len = NLMSG_ALIGN (hdr->nlmsg_len) + RTA_ALIGN (rta->rta_len);
+}
+
+/*****************************************************************************/
+
+static void
+test_parse_newlink (void)
+{
+    TestMessage               message;
+    struct nlmsghdr          *hdr;
+    struct rtnl_link_stats    stats;
+    struct rtnl_link_stats64  stats64;
+    MMNetlinkLinkInfo         info;
+
+    hdr = test_message_init (&message, RTM_NEWLINK, IFF_UP | IFF_RUNNING | IFF_LOWER_UP);
+    test_message_add_attr (hdr, IFLA_IFNAME, "wwan0", strlen ("wwan0") + 1);
+
+    /* 32bit counters wrapped, 64bit ones win whatever the order */
+    memset (&stats, 0, sizeof (stats));
+    stats.rx_bytes = 1234;
+    stats.tx_bytes = 5678;
+    test_message_add_attr (hdr, IFLA_STATS, &stats, sizeof (stats));
+    memset (&stats64, 0, sizeof (stats64));
+    stats64.rx_bytes = G_GUINT64_CONSTANT (0x100000000) + 1234;
+    stats64.tx_bytes = G_GUINT64_CONSTANT (0x100000000) + 5678;
+    test_message_add_attr (hdr, IFLA_STATS64, &stats64, sizeof (stats64));
+
+    g_assert (mm_netlink_link_info_parse (hdr, hdr->nlmsg_len, &info));
+    g_assert_cmpstr (info.ifname, ==, "wwan0");
+    g_assert (!info.removed);
+    g_assert (info.up);
+    g_assert (info.carrier);
+    g_assert (info.has_stats);
+    g_assert_cmpuint (info.rx_bytes, ==, G_GUINT64_CONSTANT (0x100000000) + 1234);
+    g_assert_cmpuint (info.tx_bytes, ==, G_GUINT64_CONSTANT (0x100000000) + 5678);
+}
+
+static void
+test_parse_stats32 (void)
+{
+    TestMessage             message;
+    struct nlmsghdr        *hdr;
+    struct rtnl_link_stats  stats;
+    MMNetlinkLinkInfo       info;
+
+    /* Up, but no carrier */
+    hdr = test_message_init (&message, RTM_NEWLINK, IFF_UP);
+    test_message_add_attr (hdr, IFLA_IFNAME, "usb0", strlen ("usb0") + 1);
+    memset (&stats, 0, sizeof (stats));
+    stats.rx_bytes = 100;
+    stats.tx_bytes = 200;
+    test_message_add_attr (hdr, IFLA_STATS, &stats, sizeof (stats));
+
+    g_assert (mm_netlink_link_info_parse (hdr, hdr->nlmsg_len, &info));
+    g_assert_cmpstr (info.ifname, ==, "usb0");
+    g_assert (info.up);
+    g_assert (!info.carrier);
+    g_assert (info.has_stats);
+    g_assert_cmpuint (info.rx_bytes, ==, 100);
+    g_assert_cmpuint (info.tx_bytes, ==, 200);
+}
+
+static void
+test_parse_dellink (void)
+{
+    TestMessage        message;
+    struct nlmsghdr   *hdr;
+    MMNetlinkLinkInfo  info;
+
+    hdr = test_message_init (&message, RTM_DELLINK, 0);
+    test_message_add_attr (hdr, IFLA_IFNAME, "wwan0", strlen ("wwan0") + 1);
+
+    g_assert (mm_netlink_link_info_parse (hdr, hdr->nlmsg_len, &info));
+    g_assert_cmpstr (info.ifname, ==, "wwan0");
+    g_assert (info.removed);
+    g_assert (!info.up);
+    g_assert (!info.has_stats);
+}
+
+static void
+test_parse_invalid (void)
+{
+    TestMessage        message;
+    struct nlmsghdr   *hdr;
+    MMNetlinkLinkInfo  info;
+    static const gchar long_ifname[] = "wwan0wwan0wwan0wwan0";
+
+    /* Not a link message */
+    hdr = test_message_init (&message, RTM_NEWADDR, 0);
+    test_message_add_attr (hdr, IFLA_IFNAME, "wwan0", strlen ("wwan0") + 1);
+    g_assert (!mm_netlink_link_info_parse (hdr, hdr->nlmsg_len, &info));
+
+    /* No name */
+    hdr = test_message_init (&message, RTM_NEWLINK, IFF_UP);
+    g_assert (!mm_netlink_link_info_parse (hdr, hdr->nlmsg_len, &info));
+
+    /* Truncated */
+    hdr = test_message_init (&message, RTM_NEWLINK, IFF_UP);
+    test_message_add_attr (hdr, IFLA_IFNAME, "wwan0", strlen ("wwan0") + 1);
+    g_assert (!mm_netlink_link_info_parse (hdr, hdr->nlmsg_len - 1, &info));
+    g_assert (!mm_netlink_link_info_parse (hdr, NLMSG_HDRLEN, &info));
+
+    /* Name not NUL-terminated, and too long */
+    hdr = test_message_init (&message, RTM_NEWLINK, IFF_UP);
+    test_message_add_attr (hdr, IFLA_IFNAME, long_ifname, strlen (long_ifname));
+    g_assert (mm_netlink_link_info_parse (hdr, hdr->nlmsg_len, &info));
+    g_assert_cmpuint (strlen (info.ifname), ==, sizeof (info.ifname) - 1);
+
+    /* Stats too short to hold the byte counters are ignored */
+    hdr = test_message_init (&message, RTM_NEWLINK, IFF_UP);
+    test_message_add_attr (hdr, IFLA_IFNAME, "wwan0", strlen ("wwan0") + 1);
+    test_message_add_attr (hdr, IFLA_STATS64, long_ifname, 8);
+    g_assert (mm_netlink_link_info_parse (hdr, hdr->nlmsg_len, &info));
+    g_assert (!info.has_stats);
+}
+
+/*****************************************************************************/
+
+static void
+stats_base_update (MMNetlinkStatsBase *base,
+                   guint64             kernel_rx_bytes,
+                   guint64             kernel_tx_bytes,
+                   guint64            *rx_bytes,
+                   guint64            *tx_bytes)
+{
+    MMNetlinkLinkInfo info;
+
+    memset (&info, 0, sizeof (info));
+    info.has_stats = TRUE;
+    info.rx_bytes = kernel_rx_bytes;
+    info.tx_bytes = kernel_tx_bytes;
+    mm_netlink_stats_base_update (base, &info, rx_bytes, tx_bytes);
+}
+
+static void
+test_stats_base (void)
+{
+    MMNetlinkStatsBase base = { 0 };
+    guint64            rx_bytes;
+    guint64            tx_bytes;
+
+    /* First report continues from the values read from the modem */
+    rx_bytes = 1000;
+    tx_bytes = 500;
+    stats_base_update (&base, 50000, 40000, &rx_bytes, &tx_bytes);
+    g_assert_cmpuint (rx_bytes, ==, 1000);
+    g_assert_cmpuint (tx_bytes, ==, 500);
+
+    stats_base_update (&base, 52000, 40100, &rx_bytes, &tx_bytes);
+    g_assert_cmpuint (rx_bytes, ==, 3000);
+    g_assert_cmpuint (tx_bytes, ==, 600);
+
+    /* Kernel counters below the exposed values (interface re-created):
+     * continue from the exposed values, never go back nor wrap */
+    stats_base_update (&base, 100, 10, &rx_bytes, &tx_bytes);
+    g_assert_cmpuint (rx_bytes, ==, 3000);
+    g_assert_cmpuint (tx_bytes, ==, 600);
+
+    stats_base_update (&base, 1100, 20, &rx_bytes, &tx_bytes);
+    g_assert_cmpuint (rx_bytes, ==, 4000);
+    g_assert_cmpuint (tx_bytes, ==, 610);
+
+    /* Only one of the counters going back also rebases */
+    stats_base_update (&base, 2100, 0, &rx_bytes, &tx_bytes);
+    g_assert_cmpuint (rx_bytes, ==, 4000);
+    g_assert_cmpuint (tx_bytes, ==, 610);
+    stats_base_update (&base, 2200, 5, &rx_bytes, &tx_bytes);
+    g_assert_cmpuint (rx_bytes, ==, 4100);
+    g_assert_cmpuint (tx_bytes, ==, 615);
+
+    /* First report of a new connection, with stats reset to 0 */
+    base.set = FALSE;
+    rx_bytes = 0;
+    tx_bytes = 0;
+    stats_base_update (&base, 2300, 10, &rx_bytes, &tx_bytes);
+    g_assert_cmpuint (rx_bytes, ==, 0);
+    g_assert_cmpuint (tx_bytes, ==, 0);
+    stats_base_update (&base, 2400, 10, &rx_bytes, &tx_bytes);
+    g_assert_cmpuint (rx_bytes, ==, 100);
+    g_assert_cmpuint (tx_bytes, ==, 0);
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    setlocale (LC_ALL, "");
+
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/netlink-monitor/parse/newlink", test_parse_newlink);
+    g_test_add_func ("/MM/netlink-monitor/parse/stats32", test_parse_stats32);
+    g_test_add_func ("/MM/netlink-monitor/parse/dellink", test_parse_dellink);
+    g_test_add_func ("/MM/netlink-monitor/parse/invalid", test_parse_invalid);
+    g_test_add_func ("/MM/netlink-monitor/stats-base",    test_stats_base);
+
+    return g_test_run ();
+}
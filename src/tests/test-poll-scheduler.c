@@ -0,0 +1,363 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <glib.h>
+#include <locale.h>
+
+/* Define symbol to enable test message traces */
+#undef ENABLE_TEST_MESSAGE_TRACES
+
+#include "mm-poll-scheduler.h"
+#include "mm-log-test.h"
+
+#define SEC(x) ((gint64) (x) * G_USEC_PER_SEC)
+
+/* Start at an arbitrary time not aligned to slots */
+#define START_TIME SEC (1000003)
+
+typedef struct {
+    MMPollScheduler *scheduler;
+    gint64          *now;
+    guint            id;
+    GArray          *runs;
+    guint            remove_id;
+    gboolean         skip;
+} TestJob;
+
+static void
+test_job_cb (TestJob *job)
+{
+    g_array_append_val (job->runs, *job->now);
+    if (job->skip)
+        mm_poll_scheduler_skip (job->scheduler, job->id);
+    if (job->remove_id)
+        mm_poll_scheduler_remove (job->scheduler, job->remove_id);
+}
+
+static void
+test_job_init (TestJob         *job,
+               MMPollScheduler *scheduler,
+               gint64          *now,
+               guint            interval,
+               guint            max_interval)
+{
+    job->scheduler = scheduler;
+    job->now = now;
+    job->runs = g_array_new (FALSE, FALSE, sizeof (gint64));
+    job->remove_id = 0;
+    job->skip = FALSE;
+    job->id = mm_poll_scheduler_add (scheduler, "test", "job", interval, max_interval,
+                                     (MMPollSchedulerFunc) test_job_cb, job);
+    g_assert_cmpuint (job->id, !=, 0);
+}
+
+static gint64
+test_job_get_run (TestJob *job,
+                  guint    i)
+{
+    return g_array_index (job->runs, gint64, i);
+}
+
+/* Moves the time forward up to the given time, dispatching all wakeups in
+ * between; returns the number of wakeups */
+static guint
+run_until (MMPollScheduler *scheduler,
+           gint64          *now,
+           gint64           until)
+{
+    guint n_wakeups = 0;
+
+    while (TRUE) {
+        gint64 wakeup;
+
+        wakeup = mm_poll_scheduler_get_next_wakeup (scheduler);
+        if (wakeup < 0 || wakeup > until)
+            break;
+        *now = MAX (*now, wakeup);
+        mm_poll_scheduler_set_time (scheduler, *now);
+        mm_poll_scheduler_dispatch (scheduler);
+        n_wakeups++;
+    }
+
+    *now = until;
+    mm_poll_scheduler_set_time (scheduler, *now);
+    return n_wakeups;
+}
+
+/* Moves the time forward to the next wakeup, and dispatches it */
+static void
+run_next (MMPollScheduler *scheduler,
+          gint64          *now)
+{
+    *now = MAX (*now, mm_poll_scheduler_get_next_wakeup (scheduler));
+    mm_poll_scheduler_set_time (scheduler, *now);
+    mm_poll_scheduler_dispatch (scheduler);
+}
+
+/*****************************************************************************/
+
+static void
+test_poll_scheduler_alignment (void)
+{
+    MMPollScheduler *scheduler;
+    TestJob          a;
+    TestJob          b;
+    gint64           now = START_TIME;
+    guint            i;
+
+    scheduler = mm_poll_scheduler_new ();
+    mm_poll_scheduler_set_time (scheduler, now);
+
+    test_job_init (&a, scheduler, &now, 30, 0);
+    run_until (scheduler, &now, now + SEC (7));
+    test_job_init (&b, scheduler, &now, 30, 0);
+    run_until (scheduler, &now, START_TIME + SEC (300));
+
+    /* Runs are aligned to slots, and never much later than the interval */
+    for (i = 0; i < a.runs->len; i++) {
+        g_assert_cmpint (test_job_get_run (&a, i) % SEC (MM_POLL_SCHEDULER_SLOT_SEC), ==, 0);
+        if (i > 0) {
+            g_assert_cmpint (test_job_get_run (&a, i) - test_job_get_run (&a, i - 1), >=, SEC (30) * 3 / 4 - SEC (MM_POLL_SCHEDULER_SLOT_SEC));
+            g_assert_cmpint (test_job_get_run (&a, i) - test_job_get_run (&a, i - 1), <=, SEC (30) + SEC (MM_POLL_SCHEDULER_SLOT_SEC) / 2);
+        }
+    }
+    g_assert_cmpuint (a.runs->len, >=, 9);
+
+    /* After the first cycle, both jobs run together */
+    g_assert_cmpuint (b.runs->len, >=, 9);
+    for (i = 1; i < b.runs->len; i++)
+        g_assert_cmpint (test_job_get_run (&b, i), ==, test_job_get_run (&a, a.runs->len - b.runs->len + i));
+
+    /* Short intervals are kept, aligned to seconds */
+    mm_poll_scheduler_remove (scheduler, a.id);
+    mm_poll_scheduler_set_interval (scheduler, b.id, 3, 0);
+    g_array_set_size (b.runs, 0);
+    run_until (scheduler, &now, now + SEC (30));
+    g_assert_cmpuint (b.runs->len, ==, 10);
+
+    mm_poll_scheduler_remove (scheduler, b.id);
+    g_assert_cmpint (mm_poll_scheduler_get_next_wakeup (scheduler), ==, -1);
+
+    g_array_unref (a.runs);
+    g_array_unref (b.runs);
+    mm_poll_scheduler_free (scheduler);
+}
+
+static void
+test_poll_scheduler_touch (void)
+{
+    MMPollScheduler *scheduler;
+    TestJob          job;
+    gint64           now = START_TIME;
+    GVariant        *timeline;
+    guint64          satisfied = 0;
+
+    scheduler = mm_poll_scheduler_new ();
+    mm_poll_scheduler_set_time (scheduler, now);
+    test_job_init (&job, scheduler, &now, 30, 0);
+
+    /* Values updated right before the poll, so it's skipped */
+    run_until (scheduler, &now, START_TIME + SEC (20));
+    mm_poll_scheduler_touch (scheduler, job.id);
+    run_until (scheduler, &now, START_TIME + SEC (40));
+    g_assert_cmpuint (job.runs->len, ==, 0);
+
+    run_until (scheduler, &now, START_TIME + SEC (60));
+    g_assert_cmpuint (job.runs->len, ==, 1);
+    g_assert_cmpint (test_job_get_run (&job, 0), >=, START_TIME + SEC (45));
+
+    timeline = mm_poll_scheduler_get_timeline (scheduler);
+    g_assert (g_variant_lookup (timeline, "satisfied", "t", &satisfied));
+    g_assert_cmpuint (satisfied, ==, 1);
+    g_variant_unref (timeline);
+
+    g_array_unref (job.runs);
+    mm_poll_scheduler_free (scheduler);
+}
+
+static void
+test_poll_scheduler_skip (void)
+{
+    MMPollScheduler *scheduler;
+    TestJob          job;
+    gint64           now = START_TIME;
+    GVariant        *timeline;
+    guint64          runs = 0;
+    guint64          satisfied = 0;
+
+    scheduler = mm_poll_scheduler_new ();
+    mm_poll_scheduler_set_time (scheduler, now);
+    test_job_init (&job, scheduler, &now, 30, 0);
+
+    /* Nothing to poll, still called every interval but not counted as runs */
+    job.skip = TRUE;
+    run_until (scheduler, &now, START_TIME + SEC (100));
+    g_assert_cmpuint (job.runs->len, ==, 3);
+
+    job.skip = FALSE;
+    run_until (scheduler, &now, START_TIME + SEC (130));
+    g_assert_cmpuint (job.runs->len, ==, 4);
+
+    timeline = mm_poll_scheduler_get_timeline (scheduler);
+    g_assert (g_variant_lookup (timeline, "runs", "t", &runs));
+    g_assert (g_variant_lookup (timeline, "satisfied", "t", &satisfied));
+    g_assert_cmpuint (runs, ==, 1);
+    g_assert_cmpuint (satisfied, ==, 3);
+    g_variant_unref (timeline);
+
+    g_array_unref (job.runs);
+    mm_poll_scheduler_free (scheduler);
+}
+
+static void
+test_poll_scheduler_adaptive (void)
+{
+    MMPollScheduler *scheduler;
+    TestJob          job;
+    gint64           now = START_TIME;
+    guint            i;
+    static const guint expected[] = { 30, 45, 60, 60 };
+
+    scheduler = mm_poll_scheduler_new ();
+    mm_poll_scheduler_set_time (scheduler, now);
+    test_job_init (&job, scheduler, &now, 20, 60);
+
+    /* Back off while nothing changes */
+    for (i = 0; i <= G_N_ELEMENTS (expected); i++) {
+        run_next (scheduler, &now);
+        g_assert_cmpuint (job.runs->len, ==, i + 1);
+        mm_poll_scheduler_report (scheduler, job.id, FALSE);
+    }
+    for (i = 0; i < G_N_ELEMENTS (expected); i++)
+        g_assert_cmpint (test_job_get_run (&job, i + 1) - test_job_get_run (&job, i), ==, SEC (expected[i]));
+
+    /* Any change goes back to the base interval */
+    mm_poll_scheduler_report (scheduler, job.id, TRUE);
+    run_next (scheduler, &now);
+    g_assert_cmpint (now - test_job_get_run (&job, G_N_ELEMENTS (expected)), ==, SEC (20));
+
+    g_array_unref (job.runs);
+    mm_poll_scheduler_free (scheduler);
+}
+
+static void
+test_poll_scheduler_remove (void)
+{
+    MMPollScheduler *scheduler;
+    TestJob          a;
+    TestJob          b;
+    gint64           now = START_TIME;
+
+    scheduler = mm_poll_scheduler_new ();
+    mm_poll_scheduler_set_time (scheduler, now);
+
+    /* Both due at the same time, and each one removes the other, so only the
+     * first one added runs */
+    test_job_init (&a, scheduler, &now, 10, 0);
+    test_job_init (&b, scheduler, &now, 10, 0);
+    a.remove_id = b.id;
+    b.remove_id = a.id;
+    run_next (scheduler, &now);
+    g_assert_cmpuint (a.runs->len, ==, 1);
+    g_assert_cmpuint (b.runs->len, ==, 0);
+    g_assert_cmpint (mm_poll_scheduler_get_next_wakeup (scheduler), !=, -1);
+
+    /* One-shot job, removing itself */
+    a.remove_id = a.id;
+    run_next (scheduler, &now);
+    g_assert_cmpuint (a.runs->len, ==, 2);
+    g_assert_cmpint (mm_poll_scheduler_get_next_wakeup (scheduler), ==, -1);
+
+    g_array_unref (a.runs);
+    g_array_unref (b.runs);
+    mm_poll_scheduler_free (scheduler);
+}
+
+/*****************************************************************************/
+
+#define PERF_N_MODEMS 50
+#define PERF_DURATION SEC (3600)
+
+/* Periodic checks of each modem: signal, registration, extended signal,
+ * bearer stats and bearer connection status */
+static const guint perf_intervals[] = { 30, 30, 10, 30, 5 };
+
+static void
+test_poll_scheduler_perf (void)
+{
+    MMPollScheduler *scheduler;
+    TestJob          jobs[PERF_N_MODEMS][G_N_ELEMENTS (perf_intervals)];
+    gint64           now = START_TIME;
+    guint64          independent_wakeups = 0;
+    guint            n_wakeups;
+    guint            i;
+    guint            j;
+
+    if (!g_test_perf ())
+        return;
+
+    scheduler = mm_poll_scheduler_new ();
+    mm_poll_scheduler_set_time (scheduler, now);
+
+    /* Modems added at arbitrary times */
+    for (i = 0; i < PERF_N_MODEMS; i++) {
+        run_until (scheduler, &now, now + g_test_rand_int_range (0, 5 * G_USEC_PER_SEC));
+        for (j = 0; j < G_N_ELEMENTS (perf_intervals); j++) {
+            test_job_init (&jobs[i][j], scheduler, &now, perf_intervals[j], 0);
+            independent_wakeups += PERF_DURATION / SEC (perf_intervals[j]);
+        }
+    }
+
+    n_wakeups = run_until (scheduler, &now, now + PERF_DURATION);
+
+    /* No job is ever delayed beyond its interval and half a slot */
+    for (i = 0; i < PERF_N_MODEMS; i++) {
+        for (j = 0; j < G_N_ELEMENTS (perf_intervals); j++) {
+            TestJob *job = &jobs[i][j];
+            guint    k;
+
+            for (k = 1; k < job->runs->len; k++)
+                g_assert_cmpint (test_job_get_run (job, k) - test_job_get_run (job, k - 1), <=,
+                                 SEC (perf_intervals[j]) + SEC (MM_POLL_SCHEDULER_SLOT_SEC) / 2);
+            g_array_unref (job->runs);
+        }
+    }
+
+    g_test_minimized_result ((gdouble) n_wakeups / 60.0,
+                             "poll scheduler: %.1f wakeups per minute (independent timers: %.1f, %u modems)",
+                             (gdouble) n_wakeups / 60.0,
+                             (gdouble) independent_wakeups / 60.0,
+                             PERF_N_MODEMS);
+
+    mm_poll_scheduler_free (scheduler);
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    setlocale (LC_ALL, "");
+
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/poll-scheduler/alignment", test_poll_scheduler_alignment);
+    g_test_add_func ("/MM/poll-scheduler/touch",     test_poll_scheduler_touch);
+    g_test_add_func ("/MM/poll-scheduler/skip",      test_poll_scheduler_skip);
+    g_test_add_func ("/MM/poll-scheduler/adaptive",  test_poll_scheduler_adaptive);
+    g_test_add_func ("/MM/poll-scheduler/remove",    test_poll_scheduler_remove);
+    g_test_add_func ("/MM/poll-scheduler/perf",      test_poll_scheduler_perf);
+
+    return g_test_run ();
+}
@@ -0,0 +1,295 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <glib.h>
+#include <glib-object.h>
+#include <stdlib.h>
+#include <string.h>
+#include <locale.h>
+
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+/* Define symbol to enable test message traces */
+#undef ENABLE_TEST_MESSAGE_TRACES
+
+#include "mm-port-index.h"
+#include "mm-log-test.h"
+
+/*****************************************************************************/
+
+static void
+test_port_index (void)
+{
+    MMPortIndex *port_index;
+    gchar        owner_a;
+    gchar        owner_b;
+    gchar        long_name[128];
+
+    port_index = mm_port_index_new ();
+
+    mm_port_index_add (port_index, "tty", "ttyUSB0", &owner_a);
+    mm_port_index_add (port_index, "tty", "ttyUSB1", &owner_a);
+    mm_port_index_add (port_index, "net", "wwan0",   &owner_a);
+    mm_port_index_add (port_index, "tty", "ttyUSB2", &owner_b);
+    g_assert_cmpuint (mm_port_index_get_size (port_index), ==, 4);
+
+    g_assert (mm_port_index_lookup (port_index, "tty", "ttyUSB0") == &owner_a);
+    g_assert (mm_port_index_lookup (port_index, "net", "wwan0")   == &owner_a);
+    g_assert (mm_port_index_lookup (port_index, "tty", "ttyUSB2") == &owner_b);
+    g_assert (!mm_port_index_lookup (port_index, "net", "ttyUSB0"));
+    g_assert (!mm_port_index_lookup (port_index, "tty", "ttyUSB3"));
+
+    /* Removing with the wrong owner does nothing */
+    mm_port_index_remove (port_index, "tty", "ttyUSB2", &owner_a);
+    g_assert (mm_port_index_lookup (port_index, "tty", "ttyUSB2") == &owner_b);
+    mm_port_index_remove (port_index, "tty", "ttyUSB2", &owner_b);
+    g_assert (!mm_port_index_lookup (port_index, "tty", "ttyUSB2"));
+
+    /* Ports may move to a different owner */
+    mm_port_index_add (port_index, "tty", "ttyUSB1", &owner_b);
+    g_assert (mm_port_index_lookup (port_index, "tty", "ttyUSB1") == &owner_b);
+
+    /* Names longer than the lookup buffer */
+    memset (long_name, 'a', sizeof (long_name) - 1);
+    long_name[sizeof (long_name) - 1] = '\0';
+    mm_port_index_add (port_index, "usbmisc", long_name, &owner_b);
+    g_assert (mm_port_index_lookup (port_index, "usbmisc", long_name) == &owner_b);
+
+    mm_port_index_remove_owner (port_index, &owner_a);
+    g_assert (!mm_port_index_lookup (port_index, "tty", "ttyUSB0"));
+    g_assert (!mm_port_index_lookup (port_index, "net", "wwan0"));
+    g_assert (mm_port_index_lookup (port_index, "tty", "ttyUSB1") == &owner_b);
+    g_assert_cmpuint (mm_port_index_get_size (port_index), ==, 2);
+
+    mm_port_index_remove_owner (port_index, &owner_b);
+    g_assert_cmpuint (mm_port_index_get_size (port_index), ==, 0);
+
+    mm_port_index_free (port_index);
+}
+
+/*****************************************************************************/
+
+#define PERF_N_DEVICES          1000
+#define PERF_N_PORTS_PER_DEVICE 6
+
+typedef struct {
+    gchar *subsystem;
+    gchar *name;
+} LegacyPort;
+
+typedef struct {
+    GList *ports;
+} LegacyDevice;
+
+static GPtrArray *
+build_events (void)
+{
+    static const gchar *subsystems[PERF_N_PORTS_PER_DEVICE] = { "tty", "tty", "tty", "net", "usbmisc", "tty" };
+    GPtrArray *events;
+    guint      i, j;
+
+    /* All ports of all devices get added, then removed in a different order,
+     * as in a hotplug storm on a big USB hub */
+    events = g_ptr_array_new_with_free_func (g_object_unref);
+    for (i = 0; i < 2; i++) {
+        for (j = 0; j < PERF_N_DEVICES * PERF_N_PORTS_PER_DEVICE; j++) {
+            MMKernelEventProperties *properties;
+            guint                    port;
+            gchar                   *name;
+
+            port = (i == 0 ? j : (j * 7919) % (PERF_N_DEVICES * PERF_N_PORTS_PER_DEVICE));
+            name = g_strdup_printf ("port%u", port);
+
+            properties = mm_kernel_event_properties_new ();
+            mm_kernel_event_properties_set_action    (properties, i == 0 ? "add" : "remove");
+            mm_kernel_event_properties_set_subsystem (properties, subsystems[port % PERF_N_PORTS_PER_DEVICE]);
+            mm_kernel_event_properties_set_name      (properties, name);
+            g_ptr_array_add (events, properties);
+            g_free (name);
+        }
+    }
+    return events;
+}
+
+static guint
+event_device (MMKernelEventProperties *properties)
+{
+    guint port;
+
+    port = atoi (mm_kernel_event_properties_get_name (properties) + 4);
+    return port / PERF_N_PORTS_PER_DEVICE;
+}
+
+static LegacyDevice *
+legacy_find_device_by_port (LegacyDevice *devices,
+                            const gchar  *subsystem,
+                            const gchar  *name)
+{
+    guint i;
+
+    for (i = 0; i < PERF_N_DEVICES; i++) {
+        GList *l;
+
+        for (l = devices[i].ports; l; l = g_list_next (l)) {
+            LegacyPort *port = l->data;
+
+            if (g_str_equal (port->subsystem, subsystem) && g_str_equal (port->name, name))
+                return &devices[i];
+        }
+    }
+    return NULL;
+}
+
+static void
+legacy_port_free (LegacyPort *port)
+{
+    g_free (port->subsystem);
+    g_free (port->name);
+    g_slice_free (LegacyPort, port);
+}
+
+static gdouble
+replay_legacy (GPtrArray *events)
+{
+    LegacyDevice *devices;
+    guint         i;
+    gdouble       elapsed;
+
+    devices = g_new0 (LegacyDevice, PERF_N_DEVICES);
+
+    g_test_timer_start ();
+    for (i = 0; i < events->len; i++) {
+        MMKernelEventProperties *properties = g_ptr_array_index (events, i);
+        const gchar             *subsystem;
+        const gchar             *name;
+        LegacyDevice            *device;
+
+        subsystem = mm_kernel_event_properties_get_subsystem (properties);
+        name = mm_kernel_event_properties_get_name (properties);
+        device = legacy_find_device_by_port (devices, subsystem, name);
+
+        if (g_str_equal (mm_kernel_event_properties_get_action (properties), "add")) {
+            LegacyPort *port;
+
+            g_assert (!device);
+            port = g_slice_new (LegacyPort);
+            port->subsystem = g_strdup (subsystem);
+            port->name = g_strdup (name);
+            device = &devices[event_device (properties)];
+            device->ports = g_list_prepend (device->ports, port);
+        } else {
+            GList *l;
+
+            g_assert (device);
+            for (l = device->ports; l; l = g_list_next (l)) {
+                LegacyPort *port = l->data;
+
+                if (g_str_equal (port->subsystem, subsystem) && g_str_equal (port->name, name)) {
+                    device->ports = g_list_delete_link (device->ports, l);
+                    legacy_port_free (port);
+                    break;
+                }
+            }
+        }
+    }
+    elapsed = g_test_timer_elapsed ();
+
+    for (i = 0; i < PERF_N_DEVICES; i++)
+        g_assert (!devices[i].ports);
+    g_free (devices);
+    return elapsed;
+}
+
+static gdouble
+replay_indexed (GPtrArray *events)
+{
+    MMPortIndex *port_index;
+    guint       *n_ports;
+    guint        i;
+    gdouble      elapsed;
+
+    port_index = mm_port_index_new ();
+    n_ports = g_new0 (guint, PERF_N_DEVICES);
+
+    g_test_timer_start ();
+    for (i = 0; i < events->len; i++) {
+        MMKernelEventProperties *properties = g_ptr_array_index (events, i);
+        const gchar             *subsystem;
+        const gchar             *name;
+        guint                   *device;
+
+        subsystem = mm_kernel_event_properties_get_subsystem (properties);
+        name = mm_kernel_event_properties_get_name (properties);
+        device = mm_port_index_lookup (port_index, subsystem, name);
+
+        if (g_str_equal (mm_kernel_event_properties_get_action (properties), "add")) {
+            g_assert (!device);
+            device = &n_ports[event_device (properties)];
+            mm_port_index_add (port_index, subsystem, name, device);
+            (*device)++;
+        } else {
+            g_assert (device);
+            mm_port_index_remove (port_index, subsystem, name, device);
+            /* Last port gone, device removed */
+            if (--(*device) == 0)
+                mm_port_index_remove_owner (port_index, device);
+        }
+    }
+    elapsed = g_test_timer_elapsed ();
+
+    g_assert_cmpuint (mm_port_index_get_size (port_index), ==, 0);
+    g_free (n_ports);
+    mm_port_index_free (port_index);
+    return elapsed;
+}
+
+static void
+test_port_index_perf (void)
+{
+    GPtrArray *events;
+    gdouble    legacy_time;
+    gdouble    indexed_time;
+
+    if (!g_test_perf ())
+        return;
+
+    events = build_events ();
+
+    legacy_time = replay_legacy (events);
+    indexed_time = replay_indexed (events);
+
+    g_test_minimized_result (indexed_time / events->len * 1e6,
+                             "port lookup: %.3fus per event (legacy scan: %.3fus per event, %u devices, %u events)",
+                             indexed_time / events->len * 1e6,
+                             legacy_time / events->len * 1e6,
+                             PERF_N_DEVICES, events->len);
+
+    g_ptr_array_unref (events);
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    setlocale (LC_ALL, "");
+
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/port-index/add-remove", test_port_index);
+    g_test_add_func ("/MM/port-index/perf",       test_port_index_perf);
+
+    return g_test_run ();
+}
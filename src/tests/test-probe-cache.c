@@ -0,0 +1,282 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <locale.h>
+
+/* Define symbol to enable test message traces */
+#undef ENABLE_TEST_MESSAGE_TRACES
+
+#include "mm-probe-cache.h"
+#include "mm-log-test.h"
+
+#define NOW   G_GINT64_CONSTANT (1500000000)
+#define DAY   (24 * 60 * 60)
+
+/*****************************************************************************/
+
+typedef struct {
+    gchar *dir;
+    gchar *path;
+    gchar *key;
+} Fixture;
+
+static void
+fixture_setup (Fixture       *fixture,
+               gconstpointer  unused)
+{
+    fixture->dir = g_dir_make_tmp ("test-probe-cache-XXXXXX", NULL);
+    g_assert (fixture->dir);
+    /* The cache creates the missing directories when writing */
+    fixture->path = g_build_filename (fixture->dir, "state", "probe-cache", NULL);
+    fixture->key = mm_probe_cache_build_key (0x1199, 0x68c0, 0x0006, ":ff0000:ff0000:020600:", "03", "tty");
+    g_assert (fixture->key);
+}
+
+static void
+fixture_teardown (Fixture       *fixture,
+                  gconstpointer  unused)
+{
+    gchar *state;
+
+    g_unlink (fixture->path);
+    state = g_path_get_dirname (fixture->path);
+    g_rmdir (state);
+    g_free (state);
+    g_rmdir (fixture->dir);
+
+    g_free (fixture->key);
+    g_free (fixture->path);
+    g_free (fixture->dir);
+}
+
+static void
+store_at_entry (MMProbeCache *cache,
+                const gchar  *key,
+                gint64        now)
+{
+    MMProbeCacheEntry entry = {
+        .plugin  = (gchar *) "sierra",
+        .type    = MM_PROBE_CACHE_PORT_TYPE_AT,
+        .vendor  = (gchar *) "Sierra Wireless",
+        .product = (gchar *) "MC7710",
+        .icera   = FALSE,
+        .xmm     = TRUE,
+    };
+
+    mm_probe_cache_store (cache, key, now, &entry);
+}
+
+/*****************************************************************************/
+
+static void
+test_build_key (void)
+{
+    gchar *key1;
+    gchar *key2;
+
+    /* Not a USB port */
+    g_assert (mm_probe_cache_build_key (0, 0, 0, NULL, NULL, "tty") == NULL);
+    /* Unknown composition */
+    g_assert (mm_probe_cache_build_key (0x1199, 0x68c0, 0x0006, NULL, "03", "tty") == NULL);
+
+    /* Same port in a different composition of the same device */
+    key1 = mm_probe_cache_build_key (0x1199, 0x68c0, 0x0006, ":ff0000:ff0000:020600:", "03", "tty");
+    key2 = mm_probe_cache_build_key (0x1199, 0x68c0, 0x0006, ":ff0000:ff0000:ff0000:", "03", "tty");
+    g_assert (key1 && key2);
+    g_assert_cmpstr (key1, !=, key2);
+    g_free (key1);
+    g_free (key2);
+}
+
+static void
+test_store_lookup (Fixture       *fixture,
+                   gconstpointer  unused)
+{
+    MMProbeCache      *cache;
+    MMProbeCacheEntry  entry;
+
+    cache = mm_probe_cache_new (fixture->path);
+    g_assert (!mm_probe_cache_lookup (cache, fixture->key, NOW, &entry));
+    store_at_entry (cache, fixture->key, NOW);
+    mm_probe_cache_free (cache);
+
+    /* Loaded back from disk */
+    cache = mm_probe_cache_new (fixture->path);
+    g_assert (mm_probe_cache_lookup (cache, fixture->key, NOW + DAY, &entry));
+    g_assert_cmpstr (entry.plugin, ==, "sierra");
+    g_assert_cmpuint (entry.type, ==, MM_PROBE_CACHE_PORT_TYPE_AT);
+    g_assert_cmpstr (entry.vendor, ==, "Sierra Wireless");
+    g_assert_cmpstr (entry.product, ==, "MC7710");
+    g_assert (!entry.icera);
+    g_assert (entry.xmm);
+    mm_probe_cache_entry_clear (&entry);
+    g_assert (entry.plugin == NULL);
+
+    /* A non-AT port doesn't get any of the AT results */
+    entry.plugin = (gchar *) "generic";
+    entry.type = MM_PROBE_CACHE_PORT_TYPE_QMI;
+    entry.vendor = (gchar *) "ignored";
+    mm_probe_cache_store (cache, fixture->key, NOW, &entry);
+    g_assert (mm_probe_cache_lookup (cache, fixture->key, NOW, &entry));
+    g_assert_cmpstr (entry.plugin, ==, "generic");
+    g_assert_cmpuint (entry.type, ==, MM_PROBE_CACHE_PORT_TYPE_QMI);
+    g_assert (entry.vendor == NULL);
+    mm_probe_cache_entry_clear (&entry);
+
+    mm_probe_cache_free (cache);
+}
+
+static void
+test_negative_not_stored (Fixture       *fixture,
+                          gconstpointer  unused)
+{
+    MMProbeCache      *cache;
+    MMProbeCacheEntry  entry = { 0 };
+
+    cache = mm_probe_cache_new (fixture->path);
+
+    /* No port type known */
+    entry.plugin = (gchar *) "generic";
+    mm_probe_cache_store (cache, fixture->key, NOW, &entry);
+    g_assert (!mm_probe_cache_lookup (cache, fixture->key, NOW, &entry));
+    g_assert (!g_file_test (fixture->path, G_FILE_TEST_EXISTS));
+
+    /* No plugin */
+    entry.type = MM_PROBE_CACHE_PORT_TYPE_AT;
+    mm_probe_cache_store (cache, fixture->key, NOW, &entry);
+    g_assert (!mm_probe_cache_lookup (cache, fixture->key, NOW, &entry));
+
+    /* A port which is no longer AT drops the positive result stored before */
+    store_at_entry (cache, fixture->key, NOW);
+    g_assert (mm_probe_cache_lookup (cache, fixture->key, NOW, &entry));
+    mm_probe_cache_entry_clear (&entry);
+    entry.plugin = (gchar *) "sierra";
+    mm_probe_cache_store (cache, fixture->key, NOW, &entry);
+    g_assert (!mm_probe_cache_lookup (cache, fixture->key, NOW, &entry));
+
+    mm_probe_cache_free (cache);
+
+    cache = mm_probe_cache_new (fixture->path);
+    g_assert (!mm_probe_cache_lookup (cache, fixture->key, NOW, &entry));
+    mm_probe_cache_free (cache);
+}
+
+static void
+test_invalidate (Fixture       *fixture,
+                 gconstpointer  unused)
+{
+    MMProbeCache      *cache;
+    MMProbeCacheEntry  entry;
+    gchar             *other_key;
+
+    other_key = mm_probe_cache_build_key (0x1199, 0x68c0, 0x0006, ":ff0000:ff0000:020600:", "00", "tty");
+
+    cache = mm_probe_cache_new (fixture->path);
+    store_at_entry (cache, fixture->key, NOW);
+    store_at_entry (cache, other_key, NOW);
+    mm_probe_cache_invalidate (cache, fixture->key);
+    g_assert (!mm_probe_cache_lookup (cache, fixture->key, NOW, &entry));
+    mm_probe_cache_free (cache);
+
+    /* Removed from disk, and only that one */
+    cache = mm_probe_cache_new (fixture->path);
+    g_assert (!mm_probe_cache_lookup (cache, fixture->key, NOW, &entry));
+    g_assert (mm_probe_cache_lookup (cache, other_key, NOW, &entry));
+    mm_probe_cache_entry_clear (&entry);
+    mm_probe_cache_free (cache);
+
+    g_free (other_key);
+}
+
+static void
+test_expiry (Fixture       *fixture,
+             gconstpointer  unused)
+{
+    MMProbeCache      *cache;
+    MMProbeCacheEntry  entry;
+
+    cache = mm_probe_cache_new (fixture->path);
+    store_at_entry (cache, fixture->key, NOW);
+
+    /* Storing the same results doesn't extend the lifetime of the entry */
+    store_at_entry (cache, fixture->key, NOW + 10 * DAY);
+    g_assert (mm_probe_cache_lookup (cache, fixture->key, NOW + MM_PROBE_CACHE_MAX_AGE_SEC, &entry));
+    mm_probe_cache_entry_clear (&entry);
+
+    /* Expired, and removed */
+    g_assert (!mm_probe_cache_lookup (cache, fixture->key, NOW + MM_PROBE_CACHE_MAX_AGE_SEC + 1, &entry));
+    g_assert (!mm_probe_cache_lookup (cache, fixture->key, NOW, &entry));
+
+    /* Entries from the future aren't trusted either */
+    store_at_entry (cache, fixture->key, NOW);
+    g_assert (!mm_probe_cache_lookup (cache, fixture->key, NOW - 1, &entry));
+
+    mm_probe_cache_free (cache);
+}
+
+static void
+test_version (Fixture       *fixture,
+              gconstpointer  unused)
+{
+    MMProbeCache      *cache;
+    MMProbeCacheEntry  entry;
+    gchar             *dir;
+    gchar             *contents;
+
+    /* A cache in the format of the first version, with negative results */
+    contents = g_strdup_printf ("[probe-cache]\n"
+                                "version=1\n"
+                                "\n"
+                                "[1199:68c0:0006:03:tty]\n"
+                                "plugin=sierra\n"
+                                "flags=1\n"
+                                "at=false\n"
+                                "\n"
+                                "[%s]\n"
+                                "plugin=sierra\n"
+                                "type=at\n"
+                                "updated=%" G_GINT64_FORMAT "\n",
+                                fixture->key, NOW);
+    dir = g_path_get_dirname (fixture->path);
+    g_assert_cmpint (g_mkdir_with_parents (dir, 0755), ==, 0);
+    g_assert (g_file_set_contents (fixture->path, contents, -1, NULL));
+    g_free (contents);
+    g_free (dir);
+
+    cache = mm_probe_cache_new (fixture->path);
+    g_assert (!mm_probe_cache_lookup (cache, "1199:68c0:0006:03:tty", NOW, &entry));
+    g_assert (!mm_probe_cache_lookup (cache, fixture->key, NOW, &entry));
+    mm_probe_cache_free (cache);
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    setlocale (LC_ALL, "");
+
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/probe-cache/build-key", test_build_key);
+    g_test_add ("/MM/probe-cache/store-lookup", Fixture, NULL, fixture_setup, test_store_lookup, fixture_teardown);
+    g_test_add ("/MM/probe-cache/negative-not-stored", Fixture, NULL, fixture_setup, test_negative_not_stored, fixture_teardown);
+    g_test_add ("/MM/probe-cache/invalidate", Fixture, NULL, fixture_setup, test_invalidate, fixture_teardown);
+    g_test_add ("/MM/probe-cache/expiry", Fixture, NULL, fixture_setup, test_expiry, fixture_teardown);
+    g_test_add ("/MM/probe-cache/version", Fixture, NULL, fixture_setup, test_version, fixture_teardown);
+
+    return g_test_run ();
+}
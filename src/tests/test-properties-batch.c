@@ -0,0 +1,406 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <locale.h>
+
+/* Define symbol to enable test message traces */
+#undef ENABLE_TEST_MESSAGE_TRACES
+
+#include "mm-properties-batch.h"
+#include "mm-log-test.h"
+
+#define MODEM_PATH       "/org/freedesktop/ModemManager1/Modem/0"
+#define OTHER_MODEM_PATH "/org/freedesktop/ModemManager1/Modem/1"
+#define MODEM_INTERFACE  "org.freedesktop.ModemManager1.Modem"
+#define SIGNAL_INTERFACE "org.freedesktop.ModemManager1.Modem.Signal"
+
+/*****************************************************************************/
+
+static GDBusMessage *
+properties_changed_new (const gchar *path,
+                        const gchar *interface,
+                        const gchar *changed_name,
+                        GVariant    *changed_value,
+                        const gchar *invalidated_name)
+{
+    GDBusMessage    *message;
+    GVariantBuilder  changed;
+    GVariantBuilder  invalidated;
+
+    g_variant_builder_init (&changed, G_VARIANT_TYPE ("a{sv}"));
+    if (changed_name)
+        g_variant_builder_add (&changed, "{sv}", changed_name, changed_value);
+    g_variant_builder_init (&invalidated, G_VARIANT_TYPE ("as"));
+    if (invalidated_name)
+        g_variant_builder_add (&invalidated, "s", invalidated_name);
+
+    message = g_dbus_message_new_signal (path, "org.freedesktop.DBus.Properties", "PropertiesChanged");
+    g_dbus_message_set_body (message, g_variant_new ("(sa{sv}as)", interface, &changed, &invalidated));
+    return message;
+}
+
+static void
+add_properties_changed (MMPropertiesBatch *batch,
+                        const gchar       *path,
+                        const gchar       *interface,
+                        const gchar       *changed_name,
+                        GVariant          *changed_value,
+                        const gchar       *invalidated_name)
+{
+    GDBusMessage *message;
+
+    message = properties_changed_new (path, interface, changed_name, changed_value, invalidated_name);
+    g_assert (mm_properties_batch_add (batch, message));
+    g_object_unref (message);
+}
+
+static void
+check_properties_changed (GDBusMessage *message,
+                          const gchar  *path,
+                          const gchar  *interface,
+                          guint         n_changed,
+                          guint         n_invalidated)
+{
+    const gchar  *signal_interface;
+    GVariant     *changed;
+    const gchar **invalidated;
+
+    g_assert_cmpint (g_dbus_message_get_message_type (message), ==, G_DBUS_MESSAGE_TYPE_SIGNAL);
+    g_assert_cmpstr (g_dbus_message_get_path (message), ==, path);
+    g_assert_cmpstr (g_dbus_message_get_interface (message), ==, "org.freedesktop.DBus.Properties");
+    g_assert_cmpstr (g_dbus_message_get_member (message), ==, "PropertiesChanged");
+
+    g_variant_get (g_dbus_message_get_body (message), "(&s@a{sv}^a&s)", &signal_interface, &changed, &invalidated);
+    g_assert_cmpstr (signal_interface, ==, interface);
+    g_assert_cmpuint (g_variant_n_children (changed), ==, n_changed);
+    g_assert_cmpuint (g_strv_length ((gchar **) invalidated), ==, n_invalidated);
+    g_variant_unref (changed);
+    g_free (invalidated);
+}
+
+static guint32
+lookup_changed_uint32 (GDBusMessage *message,
+                       const gchar  *name)
+{
+    GVariant *changed;
+    guint32   value = 0;
+
+    g_variant_get (g_dbus_message_get_body (message), "(&s@a{sv}as)", NULL, &changed, NULL);
+    g_assert (g_variant_lookup (changed, name, "u", &value));
+    g_variant_unref (changed);
+    return value;
+}
+
+static gboolean
+lookup_invalidated (GDBusMessage *message,
+                    const gchar  *name)
+{
+    const gchar **invalidated;
+    gboolean      found = FALSE;
+    guint         i;
+
+    g_variant_get (g_dbus_message_get_body (message), "(&sa{sv}^a&s)", NULL, NULL, &invalidated);
+    for (i = 0; invalidated[i] && !found; i++)
+        found = g_str_equal (invalidated[i], name);
+    g_free (invalidated);
+    return found;
+}
+
+/*****************************************************************************/
+
+static void
+test_properties_batch_merge (void)
+{
+    MMPropertiesBatch *batch;
+    GList             *signals;
+
+    batch = mm_properties_batch_new (MM_PROPERTIES_BATCH_DEFAULT_WINDOW_MS);
+
+    add_properties_changed (batch, MODEM_PATH, MODEM_INTERFACE,  "SignalQuality",       g_variant_new_uint32 (10), NULL);
+    add_properties_changed (batch, MODEM_PATH, SIGNAL_INTERFACE, "Rate",                g_variant_new_uint32 (5),  NULL);
+    add_properties_changed (batch, MODEM_PATH, MODEM_INTERFACE,  "AccessTechnologies",  g_variant_new_uint32 (2),  NULL);
+    add_properties_changed (batch, MODEM_PATH, MODEM_INTERFACE,  "SignalQuality",       g_variant_new_uint32 (20), NULL);
+
+    /* One signal per object and interface, in the order first changed */
+    signals = mm_properties_batch_take (batch);
+    g_assert_cmpuint (g_list_length (signals), ==, 2);
+    check_properties_changed (signals->data, MODEM_PATH, MODEM_INTERFACE, 2, 0);
+    g_assert_cmpuint (lookup_changed_uint32 (signals->data, "SignalQuality"), ==, 20);
+    g_assert_cmpuint (lookup_changed_uint32 (signals->data, "AccessTechnologies"), ==, 2);
+    check_properties_changed (signals->next->data, MODEM_PATH, SIGNAL_INTERFACE, 1, 0);
+    g_assert_cmpuint (lookup_changed_uint32 (signals->next->data, "Rate"), ==, 5);
+    g_list_free_full (signals, g_object_unref);
+
+    /* Nothing left */
+    g_assert (mm_properties_batch_take (batch) == NULL);
+
+    mm_properties_batch_free (batch);
+}
+
+static void
+test_properties_batch_invalidate (void)
+{
+    MMPropertiesBatch *batch;
+    GList             *signals;
+
+    batch = mm_properties_batch_new (MM_PROPERTIES_BATCH_DEFAULT_WINDOW_MS);
+
+    /* Changed, then invalidated */
+    add_properties_changed (batch, MODEM_PATH, MODEM_INTERFACE, "SignalQuality", g_variant_new_uint32 (10), NULL);
+    add_properties_changed (batch, MODEM_PATH, MODEM_INTERFACE, NULL, NULL, "SignalQuality");
+    /* Invalidated, then changed */
+    add_properties_changed (batch, MODEM_PATH, MODEM_INTERFACE, NULL, NULL, "State");
+    add_properties_changed (batch, MODEM_PATH, MODEM_INTERFACE, "State", g_variant_new_uint32 (8), NULL);
+
+    signals = mm_properties_batch_take (batch);
+    g_assert_cmpuint (g_list_length (signals), ==, 1);
+    check_properties_changed (signals->data, MODEM_PATH, MODEM_INTERFACE, 1, 1);
+    g_assert (lookup_invalidated (signals->data, "SignalQuality"));
+    g_assert_cmpuint (lookup_changed_uint32 (signals->data, "State"), ==, 8);
+    g_list_free_full (signals, g_object_unref);
+
+    mm_properties_batch_free (batch);
+}
+
+static void
+test_properties_batch_ordering (void)
+{
+    MMPropertiesBatch *batch;
+    GDBusMessage      *message;
+    GList             *signals;
+
+    batch = mm_properties_batch_new (MM_PROPERTIES_BATCH_DEFAULT_WINDOW_MS);
+
+    /* Other signals go through while there are no pending changes */
+    message = g_dbus_message_new_signal (MODEM_PATH, MODEM_INTERFACE, "StateChanged");
+    g_dbus_message_set_body (message, g_variant_new ("(iiu)", 6, 7, 0));
+    g_assert (!mm_properties_batch_add (batch, message));
+    g_object_unref (message);
+
+    add_properties_changed (batch, MODEM_PATH, MODEM_INTERFACE, "State", g_variant_new_uint32 (7), NULL);
+
+    /* Once there are pending changes they are held, whatever their object... */
+    message = g_dbus_message_new_signal (OTHER_MODEM_PATH, MODEM_INTERFACE, "StateChanged");
+    g_dbus_message_set_body (message, g_variant_new ("(iiu)", 6, 7, 0));
+    g_assert (mm_properties_batch_add (batch, message));
+    g_object_unref (message);
+
+    /* ...and later changes are not merged into the earlier ones */
+    add_properties_changed (batch, MODEM_PATH, MODEM_INTERFACE, "State", g_variant_new_uint32 (8), NULL);
+
+    /* Object manager signals are held as well */
+    message = g_dbus_message_new_signal ("/org/freedesktop/ModemManager1", "org.freedesktop.DBus.ObjectManager", "InterfacesAdded");
+    g_dbus_message_set_body (message, g_variant_new ("(o@a{sa{sv}})", OTHER_MODEM_PATH, g_variant_new_array (G_VARIANT_TYPE ("{sa{sv}}"), NULL, 0)));
+    g_assert (mm_properties_batch_add (batch, message));
+    g_object_unref (message);
+
+    /* Unicast signals are held, but never merged */
+    message = properties_changed_new (MODEM_PATH, MODEM_INTERFACE, "State", g_variant_new_uint32 (8), NULL);
+    g_dbus_message_set_destination (message, ":1.42");
+    g_assert (mm_properties_batch_add (batch, message));
+    g_object_unref (message);
+
+    /* Method calls go through */
+    message = g_dbus_message_new_method_call ("org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus", "Hello");
+    g_assert (!mm_properties_batch_add (batch, message));
+    g_object_unref (message);
+
+    signals = mm_properties_batch_take (batch);
+    g_assert_cmpuint (g_list_length (signals), ==, 5);
+    check_properties_changed (signals->data, MODEM_PATH, MODEM_INTERFACE, 1, 0);
+    g_assert_cmpuint (lookup_changed_uint32 (signals->data, "State"), ==, 7);
+    g_assert_cmpstr (g_dbus_message_get_member (signals->next->data), ==, "StateChanged");
+    g_assert_cmpstr (g_dbus_message_get_path (signals->next->data), ==, OTHER_MODEM_PATH);
+    check_properties_changed (signals->next->next->data, MODEM_PATH, MODEM_INTERFACE, 1, 0);
+    g_assert_cmpuint (lookup_changed_uint32 (signals->next->next->data, "State"), ==, 8);
+    g_assert_cmpstr (g_dbus_message_get_member (signals->next->next->next->data), ==, "InterfacesAdded");
+    check_properties_changed (signals->next->next->next->next->data, MODEM_PATH, MODEM_INTERFACE, 1, 0);
+    g_assert_cmpstr (g_dbus_message_get_destination (signals->next->next->next->next->data), ==, ":1.42");
+    g_list_free_full (signals, g_object_unref);
+
+    mm_properties_batch_free (batch);
+}
+
+static GDBusMessage *
+method_call_new (const gchar *path,
+                 guint32      serial)
+{
+    GDBusMessage *message;
+
+    message = g_dbus_message_new_method_call (NULL, path, MODEM_INTERFACE, "Enable");
+    g_dbus_message_set_sender (message, ":1.42");
+    g_dbus_message_set_serial (message, serial);
+    return message;
+}
+
+static void
+test_properties_batch_replies (void)
+{
+    MMPropertiesBatch *batch;
+    GDBusMessage      *call;
+    GDBusMessage      *reply;
+    GList             *signals;
+
+    batch = mm_properties_batch_new (MM_PROPERTIES_BATCH_DEFAULT_WINDOW_MS);
+
+    /* Replies go through while there are no pending changes */
+    call = method_call_new (MODEM_PATH, 10);
+    reply = g_dbus_message_new_method_reply (call);
+    g_assert (!mm_properties_batch_add (batch, reply));
+    g_object_unref (reply);
+    g_object_unref (call);
+
+    /* Reply to a call on an object is held after the pending changes of any
+     * other object, and later changes are not merged into the earlier ones */
+    add_properties_changed (batch, OTHER_MODEM_PATH, MODEM_INTERFACE, "State", g_variant_new_uint32 (7), NULL);
+    call = method_call_new (MODEM_PATH, 11);
+    reply = g_dbus_message_new_method_reply (call);
+    g_assert (mm_properties_batch_add (batch, reply));
+    g_object_unref (reply);
+    g_object_unref (call);
+    add_properties_changed (batch, OTHER_MODEM_PATH, MODEM_INTERFACE, "State", g_variant_new_uint32 (8), NULL);
+
+    /* Errors are held as well */
+    call = method_call_new (MODEM_PATH, 12);
+    reply = g_dbus_message_new_method_error (call, "org.freedesktop.ModemManager1.Error.Core.Failed", "failed");
+    g_assert (mm_properties_batch_add (batch, reply));
+    g_object_unref (reply);
+    g_object_unref (call);
+
+    signals = mm_properties_batch_take (batch);
+    g_assert_cmpuint (g_list_length (signals), ==, 4);
+    check_properties_changed (signals->data, OTHER_MODEM_PATH, MODEM_INTERFACE, 1, 0);
+    g_assert_cmpuint (lookup_changed_uint32 (signals->data, "State"), ==, 7);
+    g_assert_cmpint (g_dbus_message_get_message_type (signals->next->data), ==, G_DBUS_MESSAGE_TYPE_METHOD_RETURN);
+    g_assert_cmpuint (g_dbus_message_get_reply_serial (signals->next->data), ==, 11);
+    g_assert_cmpstr (g_dbus_message_get_destination (signals->next->data), ==, ":1.42");
+    check_properties_changed (signals->next->next->data, OTHER_MODEM_PATH, MODEM_INTERFACE, 1, 0);
+    g_assert_cmpuint (lookup_changed_uint32 (signals->next->next->data, "State"), ==, 8);
+    g_assert_cmpint (g_dbus_message_get_message_type (signals->next->next->next->data), ==, G_DBUS_MESSAGE_TYPE_ERROR);
+    g_assert_cmpuint (g_dbus_message_get_reply_serial (signals->next->next->next->data), ==, 12);
+    g_list_free_full (signals, g_object_unref);
+
+    mm_properties_batch_free (batch);
+}
+
+static void
+test_properties_batch_stats (void)
+{
+    MMPropertiesBatch *batch;
+    guint64            n_received;
+    guint64            n_emitted;
+    guint              i;
+
+    batch = mm_properties_batch_new (MM_PROPERTIES_BATCH_DEFAULT_WINDOW_MS);
+
+    for (i = 0; i < 10; i++)
+        add_properties_changed (batch, MODEM_PATH, MODEM_INTERFACE, "SignalQuality", g_variant_new_uint32 (i), NULL);
+    add_properties_changed (batch, OTHER_MODEM_PATH, MODEM_INTERFACE, "SignalQuality", g_variant_new_uint32 (i), NULL);
+
+    mm_properties_batch_get_stats (batch, &n_received, &n_emitted);
+    g_assert_cmpuint (n_received, ==, 11);
+    g_assert_cmpuint (n_emitted, ==, 0);
+
+    /* Without connection, flushing just discards */
+    mm_properties_batch_flush (batch);
+    mm_properties_batch_get_stats (batch, &n_received, &n_emitted);
+    g_assert_cmpuint (n_received, ==, 11);
+    g_assert_cmpuint (n_emitted, ==, 2);
+
+    mm_properties_batch_free (batch);
+}
+
+/*****************************************************************************/
+
+#define PERF_N_MODEMS 50
+
+/* Properties updated while enabling a modem, as notified by the skeletons,
+ * i.e. already merged within each main loop iteration */
+static const struct {
+    const gchar *interface;
+    const gchar *name;
+} perf_updates[] = {
+    { MODEM_INTERFACE,                                  "State"              },
+    { MODEM_INTERFACE,                                  "PowerState"         },
+    { MODEM_INTERFACE,                                  "State"              },
+    { "org.freedesktop.ModemManager1.Modem.Modem3gpp",  "RegistrationState"  },
+    { MODEM_INTERFACE,                                  "AccessTechnologies" },
+    { MODEM_INTERFACE,                                  "SignalQuality"      },
+    { "org.freedesktop.ModemManager1.Modem.Modem3gpp",  "OperatorCode"       },
+    { "org.freedesktop.ModemManager1.Modem.Modem3gpp",  "OperatorName"       },
+    { MODEM_INTERFACE,                                  "State"              },
+    { MODEM_INTERFACE,                                  "SignalQuality"      },
+    { MODEM_INTERFACE,                                  "AccessTechnologies" },
+    { MODEM_INTERFACE,                                  "SignalQuality"      },
+};
+
+static void
+test_properties_batch_perf (void)
+{
+    MMPropertiesBatch *batch;
+    GList             *signals;
+    guint64            n_received;
+    guint64            n_emitted;
+    guint              i;
+    guint              j;
+
+    if (!g_test_perf ())
+        return;
+
+    batch = mm_properties_batch_new (MM_PROPERTIES_BATCH_DEFAULT_WINDOW_MS);
+
+    /* All modems enabled at the same time, updates interleaved */
+    for (j = 0; j < G_N_ELEMENTS (perf_updates); j++) {
+        for (i = 0; i < PERF_N_MODEMS; i++) {
+            gchar *path;
+
+            path = g_strdup_printf ("/org/freedesktop/ModemManager1/Modem/%u", i);
+            add_properties_changed (batch, path, perf_updates[j].interface, perf_updates[j].name,
+                                    g_variant_new_uint32 (j), NULL);
+            g_free (path);
+        }
+    }
+
+    signals = mm_properties_batch_take (batch);
+    g_assert_cmpuint (g_list_length (signals), ==, PERF_N_MODEMS * 2);
+    g_list_free_full (signals, g_object_unref);
+
+    mm_properties_batch_get_stats (batch, &n_received, &n_emitted);
+    g_test_minimized_result ((gdouble) n_emitted,
+                             "properties batch: %" G_GUINT64_FORMAT " signals emitted for %" G_GUINT64_FORMAT " notifications (%u modems)",
+                             n_emitted, n_received, PERF_N_MODEMS);
+
+    mm_properties_batch_free (batch);
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    setlocale (LC_ALL, "");
+
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/properties-batch/merge",      test_properties_batch_merge);
+    g_test_add_func ("/MM/properties-batch/invalidate", test_properties_batch_invalidate);
+    g_test_add_func ("/MM/properties-batch/ordering",   test_properties_batch_ordering);
+    g_test_add_func ("/MM/properties-batch/replies",    test_properties_batch_replies);
+    g_test_add_func ("/MM/properties-batch/stats",      test_properties_batch_stats);
+    g_test_add_func ("/MM/properties-batch/perf",       test_properties_batch_perf);
+
+    return g_test_run ();
+}
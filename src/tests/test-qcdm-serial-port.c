@@ -34,7 +34,7 @@
 #include "libqcdm/src/utils.h"
 #include "libqcdm/src/com.h"
 #include "libqcdm/src/errors.h"
-#include "mm-log.h"
+#include "mm-log-test.h"
 
 typedef struct {
     int master;
@@ -437,26 +437,6 @@ test_pty_cleanup (TestData *d)
     }
 }
 
-void
-_mm_log (const char *loc,
-         const char *func,
-         guint32 level,
-         const char *fmt,
-         ...)
-{
-#if defined ENABLE_TEST_MESSAGE_TRACES
-    /* Dummy log function */
-    va_list args;
-    gchar *msg;
-
-    va_start (args, fmt);
-    msg = g_strdup_vprintf (fmt, args);
-    va_end (args);
-    g_print ("%s\n", msg);
-    g_free (msg);
-#endif
-}
-
 typedef void (*TCFunc) (TestData *, gconstpointer);
 #define TESTCASE_PTY(s, t) g_test_add (s, TestData, NULL, (TCFunc)test_pty_create, (TCFunc)t, (TCFunc)test_pty_cleanup);
 
@@ -0,0 +1,134 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <glib.h>
+#include <glib-object.h>
+#include <string.h>
+#include <locale.h>
+
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+/* Define symbol to enable test message traces */
+#undef ENABLE_TEST_MESSAGE_TRACES
+
+#include "mm-regex.h"
+#include "mm-modem-helpers.h"
+#include "mm-log-test.h"
+
+/*****************************************************************************/
+
+static void
+test_regex_shared (void)
+{
+    GRegex *a;
+    GRegex *b;
+    GRegex *c;
+    GError *error = NULL;
+    guint   n_compiled;
+    guint   n_reused;
+    guint   n_compiled_after;
+    guint   n_reused_after;
+
+    mm_regex_get_stats (&n_compiled, &n_reused, NULL);
+
+    a = mm_regex_get ("\\+TEST:\\s*(\\d+)", G_REGEX_RAW, 0, NULL);
+    b = mm_regex_get ("\\+TEST:\\s*(\\d+)", G_REGEX_RAW, 0, NULL);
+    g_assert (a != NULL);
+    g_assert (a == b);
+
+    /* Same pattern, different flags */
+    c = mm_regex_get ("\\+TEST:\\s*(\\d+)", G_REGEX_RAW | G_REGEX_CASELESS, 0, NULL);
+    g_assert (c != NULL);
+    g_assert (c != a);
+
+    mm_regex_get_stats (&n_compiled_after, &n_reused_after, NULL);
+    g_assert_cmpuint (n_compiled_after - n_compiled, ==, 2);
+    g_assert_cmpuint (n_reused_after - n_reused, ==, 1);
+
+    /* Each caller owns a reference */
+    g_regex_unref (a);
+    g_regex_unref (b);
+    g_regex_unref (c);
+    a = mm_regex_get ("\\+TEST:\\s*(\\d+)", G_REGEX_RAW, 0, NULL);
+    g_assert (g_regex_match (a, "+TEST: 1", 0, NULL));
+    g_regex_unref (a);
+
+    /* Errors are not cached */
+    g_assert (!mm_regex_get ("(unbalanced", 0, 0, &error));
+    g_assert (error != NULL);
+    g_clear_error (&error);
+    g_assert (!mm_regex_get ("(unbalanced", 0, 0, &error));
+    g_assert (error != NULL);
+    g_clear_error (&error);
+}
+
+/*****************************************************************************/
+
+#define PERF_N_ITERATIONS 1000
+
+static void
+test_regex_perf (void)
+{
+    guint   i;
+    gdouble legacy_time;
+    gdouble shared_time;
+    gdouble compile_time;
+
+    if (!g_test_perf ())
+        return;
+
+    /* What every modem (re-)initialization used to do */
+    g_test_timer_start ();
+    for (i = 0; i < PERF_N_ITERATIONS; i++) {
+        GRegex *r;
+
+        r = g_regex_new ("\\r\\n\\+CREG:\\s*(\\d{1}),\\s*(\\d{1})\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*(\\d{1,2})\\s*\\r\\n",
+                         G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        g_regex_unref (r);
+    }
+    legacy_time = g_test_timer_elapsed ();
+
+    g_test_timer_start ();
+    for (i = 0; i < PERF_N_ITERATIONS; i++) {
+        GPtrArray *array;
+
+        array = mm_3gpp_creg_regex_get (TRUE);
+        mm_3gpp_creg_regex_destroy (array);
+    }
+    shared_time = g_test_timer_elapsed ();
+
+    mm_regex_get_stats (NULL, NULL, &compile_time);
+
+    g_test_minimized_result (shared_time / PERF_N_ITERATIONS * 1e6,
+                             "CREG regex set: %.3fus per request (compiling a single pattern: %.3fus, total compile time: %.3fms)",
+                             shared_time / PERF_N_ITERATIONS * 1e6,
+                             legacy_time / PERF_N_ITERATIONS * 1e6,
+                             compile_time * 1e3);
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    setlocale (LC_ALL, "");
+
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/regex/shared", test_regex_shared);
+    g_test_add_func ("/MM/regex/perf",   test_regex_perf);
+
+    return g_test_run ();
+}
@@ -0,0 +1,293 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <glib.h>
+#include <glib-object.h>
+#include <string.h>
+#include <locale.h>
+
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+/* Define symbol to enable test message traces */
+#undef ENABLE_TEST_MESSAGE_TRACES
+
+#include "mm-sms-index.h"
+#include "mm-log-test.h"
+
+/*****************************************************************************/
+
+static void
+test_sms_index (void)
+{
+    MMSmsIndex   *sms_index;
+    const GSList *items;
+    gchar         sms_a;
+    gchar         sms_b;
+    gchar         sms_c;
+    gchar         long_number[128];
+
+    sms_index = mm_sms_index_new ();
+
+    mm_sms_index_add_part (sms_index, MM_SMS_STORAGE_SM, 0, &sms_a);
+    mm_sms_index_add_part (sms_index, MM_SMS_STORAGE_SM, 1, &sms_a);
+    mm_sms_index_add_part (sms_index, MM_SMS_STORAGE_ME, 0, &sms_b);
+    g_assert_cmpuint (mm_sms_index_get_n_parts (sms_index), ==, 3);
+
+    g_assert (mm_sms_index_lookup_part (sms_index, MM_SMS_STORAGE_SM, 0) == &sms_a);
+    g_assert (mm_sms_index_lookup_part (sms_index, MM_SMS_STORAGE_SM, 1) == &sms_a);
+    g_assert (mm_sms_index_lookup_part (sms_index, MM_SMS_STORAGE_ME, 0) == &sms_b);
+    g_assert (!mm_sms_index_lookup_part (sms_index, MM_SMS_STORAGE_ME, 1));
+    g_assert (!mm_sms_index_lookup_part (sms_index, MM_SMS_STORAGE_MT, 0));
+
+    /* Parts may move to a different message */
+    mm_sms_index_add_part (sms_index, MM_SMS_STORAGE_SM, 1, &sms_b);
+    g_assert (mm_sms_index_lookup_part (sms_index, MM_SMS_STORAGE_SM, 1) == &sms_b);
+    g_assert_cmpuint (mm_sms_index_get_n_parts (sms_index), ==, 3);
+
+    /* Same reference, different numbers */
+    mm_sms_index_add_multipart (sms_index, 12, "+34600000001", &sms_a);
+    mm_sms_index_add_multipart (sms_index, 12, "+34600000002", &sms_b);
+    mm_sms_index_add_multipart (sms_index, 12, "+34600000002", &sms_c);
+    mm_sms_index_add_multipart (sms_index, 13, NULL, &sms_c);
+
+    items = mm_sms_index_lookup_multipart (sms_index, 12, "+34600000001");
+    g_assert_cmpuint (g_slist_length ((GSList *) items), ==, 1);
+    g_assert (items->data == &sms_a);
+    items = mm_sms_index_lookup_multipart (sms_index, 12, "+34600000002");
+    g_assert_cmpuint (g_slist_length ((GSList *) items), ==, 2);
+    g_assert (items->data == &sms_c);
+    g_assert (!mm_sms_index_lookup_multipart (sms_index, 12, "+34600000003"));
+    g_assert (!mm_sms_index_lookup_multipart (sms_index, 14, NULL));
+    items = mm_sms_index_lookup_multipart (sms_index, 13, NULL);
+    g_assert (items && items->data == &sms_c);
+
+    /* Numbers longer than the lookup buffer */
+    memset (long_number, '1', sizeof (long_number) - 1);
+    long_number[sizeof (long_number) - 1] = '\0';
+    mm_sms_index_add_multipart (sms_index, 1, long_number, &sms_a);
+    items = mm_sms_index_lookup_multipart (sms_index, 1, long_number);
+    g_assert (items && items->data == &sms_a);
+
+    mm_sms_index_remove_item (sms_index, &sms_a);
+    g_assert (!mm_sms_index_lookup_part (sms_index, MM_SMS_STORAGE_SM, 0));
+    g_assert (mm_sms_index_lookup_part (sms_index, MM_SMS_STORAGE_SM, 1) == &sms_b);
+    g_assert (!mm_sms_index_lookup_multipart (sms_index, 12, "+34600000001"));
+    g_assert (!mm_sms_index_lookup_multipart (sms_index, 1, long_number));
+    g_assert_cmpuint (mm_sms_index_get_n_parts (sms_index), ==, 2);
+
+    mm_sms_index_remove_item (sms_index, &sms_c);
+    items = mm_sms_index_lookup_multipart (sms_index, 12, "+34600000002");
+    g_assert_cmpuint (g_slist_length ((GSList *) items), ==, 1);
+    g_assert (items->data == &sms_b);
+
+    mm_sms_index_remove_item (sms_index, &sms_b);
+    g_assert_cmpuint (mm_sms_index_get_n_parts (sms_index), ==, 0);
+    g_assert (!mm_sms_index_lookup_multipart (sms_index, 12, "+34600000002"));
+
+    mm_sms_index_free (sms_index);
+}
+
+/*****************************************************************************/
+
+#define PERF_N_PARTS     30000
+#define PERF_N_SENDERS   50
+#define PERF_CONCAT_MAX  3
+
+typedef struct {
+    guint  reference;
+    gchar *number;
+    guint  indices[PERF_CONCAT_MAX];
+    guint  n_parts;
+} SyntheticSms;
+
+typedef struct {
+    guint        index;
+    guint        reference;
+    const gchar *number;
+} SyntheticPart;
+
+static SyntheticPart *
+build_parts (gchar **numbers)
+{
+    SyntheticPart *parts;
+    guint          i;
+
+    /* Multipart messages of PERF_CONCAT_MAX parts from several senders, with
+     * 8-bit references wrapping around */
+    parts = g_new (SyntheticPart, PERF_N_PARTS);
+    for (i = 0; i < PERF_N_PARTS; i++) {
+        guint message;
+
+        message = i / PERF_CONCAT_MAX;
+        parts[i].index = i;
+        parts[i].number = numbers[message % PERF_N_SENDERS];
+        parts[i].reference = 1 + ((message / PERF_N_SENDERS) % 255);
+    }
+    return parts;
+}
+
+static gboolean
+legacy_has_part (GList *list,
+                 guint  index)
+{
+    GList *l;
+
+    for (l = list; l; l = g_list_next (l)) {
+        SyntheticSms *sms = l->data;
+        guint         i;
+
+        for (i = 0; i < sms->n_parts; i++)
+            if (sms->indices[i] == index)
+                return TRUE;
+    }
+    return FALSE;
+}
+
+static gdouble
+ingest_legacy (SyntheticPart *parts,
+               guint         *n_messages)
+{
+    GList   *list = NULL;
+    guint    i;
+    gdouble  elapsed;
+
+    g_test_timer_start ();
+    for (i = 0; i < PERF_N_PARTS; i++) {
+        SyntheticSms *sms = NULL;
+        GList        *l;
+
+        g_assert (!legacy_has_part (list, parts[i].index));
+        for (l = list; l; l = g_list_next (l)) {
+            SyntheticSms *candidate = l->data;
+
+            if (candidate->n_parts < PERF_CONCAT_MAX &&
+                candidate->reference == parts[i].reference &&
+                g_str_equal (candidate->number, parts[i].number)) {
+                sms = candidate;
+                break;
+            }
+        }
+        if (!sms) {
+            sms = g_slice_new0 (SyntheticSms);
+            sms->reference = parts[i].reference;
+            sms->number = (gchar *) parts[i].number;
+            list = g_list_prepend (list, sms);
+        }
+        sms->indices[sms->n_parts++] = parts[i].index;
+    }
+    elapsed = g_test_timer_elapsed ();
+
+    *n_messages = g_list_length (list);
+    for (; list; list = g_list_delete_link (list, list))
+        g_slice_free (SyntheticSms, list->data);
+    return elapsed;
+}
+
+static gdouble
+ingest_indexed (SyntheticPart *parts,
+                guint         *n_messages)
+{
+    MMSmsIndex *sms_index;
+    GList      *list = NULL;
+    guint       i;
+    gdouble     elapsed;
+
+    sms_index = mm_sms_index_new ();
+
+    g_test_timer_start ();
+    for (i = 0; i < PERF_N_PARTS; i++) {
+        SyntheticSms *sms = NULL;
+        const GSList *l;
+
+        g_assert (!mm_sms_index_lookup_part (sms_index, MM_SMS_STORAGE_ME, parts[i].index));
+        for (l = mm_sms_index_lookup_multipart (sms_index, parts[i].reference, parts[i].number); l; l = g_slist_next (l)) {
+            SyntheticSms *candidate = l->data;
+
+            if (candidate->n_parts < PERF_CONCAT_MAX) {
+                sms = candidate;
+                break;
+            }
+        }
+        if (!sms) {
+            sms = g_slice_new0 (SyntheticSms);
+            sms->reference = parts[i].reference;
+            sms->number = (gchar *) parts[i].number;
+            list = g_list_prepend (list, sms);
+            mm_sms_index_add_multipart (sms_index, sms->reference, sms->number, sms);
+        }
+        sms->indices[sms->n_parts++] = parts[i].index;
+        mm_sms_index_add_part (sms_index, MM_SMS_STORAGE_ME, parts[i].index, sms);
+    }
+    elapsed = g_test_timer_elapsed ();
+
+    g_assert_cmpuint (mm_sms_index_get_n_parts (sms_index), ==, PERF_N_PARTS);
+    *n_messages = g_list_length (list);
+    for (; list; list = g_list_delete_link (list, list)) {
+        mm_sms_index_remove_item (sms_index, list->data);
+        g_slice_free (SyntheticSms, list->data);
+    }
+    g_assert_cmpuint (mm_sms_index_get_n_parts (sms_index), ==, 0);
+    mm_sms_index_free (sms_index);
+    return elapsed;
+}
+
+static void
+test_sms_index_perf (void)
+{
+    SyntheticPart *parts;
+    gchar         *numbers[PERF_N_SENDERS];
+    guint          legacy_messages;
+    guint          indexed_messages;
+    gdouble        legacy_time;
+    gdouble        indexed_time;
+    guint          i;
+
+    if (!g_test_perf ())
+        return;
+
+    for (i = 0; i < PERF_N_SENDERS; i++)
+        numbers[i] = g_strdup_printf ("+346%08u", i);
+    parts = build_parts (numbers);
+
+    legacy_time = ingest_legacy (parts, &legacy_messages);
+    indexed_time = ingest_indexed (parts, &indexed_messages);
+    g_assert_cmpuint (legacy_messages, ==, PERF_N_PARTS / PERF_CONCAT_MAX);
+    g_assert_cmpuint (indexed_messages, ==, legacy_messages);
+
+    g_test_minimized_result (indexed_time / PERF_N_PARTS * 1e6,
+                             "sms part ingestion: %.3fus per part (legacy scan: %.3fus per part, %u parts)",
+                             indexed_time / PERF_N_PARTS * 1e6,
+                             legacy_time / PERF_N_PARTS * 1e6,
+                             PERF_N_PARTS);
+
+    g_free (parts);
+    for (i = 0; i < PERF_N_SENDERS; i++)
+        g_free (numbers[i]);
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    setlocale (LC_ALL, "");
+
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/sms-index/add-remove", test_sms_index);
+    g_test_add_func ("/MM/sms-index/perf",       test_sms_index_perf);
+
+    return g_test_run ();
+}
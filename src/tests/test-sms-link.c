@@ -0,0 +1,223 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <glib.h>
+#include <locale.h>
+
+/* Define symbol to enable test message traces */
+#undef ENABLE_TEST_MESSAGE_TRACES
+
+#include "mm-sms-link.h"
+#include "mm-log-test.h"
+
+/*****************************************************************************/
+
+static void
+test_temporary (void)
+{
+    MMSmsLink link = { 0 };
+
+    /* Each multipart message sent on its own asks for the link again */
+    g_assert_cmpint (mm_sms_link_hold (&link, FALSE), ==, MM_SMS_LINK_MODE_TEMPORARY);
+    g_assert_cmpint (mm_sms_link_hold (&link, FALSE), ==, MM_SMS_LINK_MODE_TEMPORARY);
+    g_assert_cmpuint (link.holds, ==, 0);
+}
+
+static void
+test_nested (void)
+{
+    MMSmsLink link = { 0 };
+
+    /* Only the first hold and the last release change the mode */
+    g_assert_cmpint (mm_sms_link_hold (&link, TRUE), ==, MM_SMS_LINK_MODE_ENABLED);
+    g_assert_cmpint (mm_sms_link_hold (&link, TRUE), ==, MM_SMS_LINK_MODE_NONE);
+    g_assert_cmpuint (link.holds, ==, 2);
+
+    /* Multipart messages don't downgrade a held link */
+    g_assert_cmpint (mm_sms_link_hold (&link, FALSE), ==, MM_SMS_LINK_MODE_NONE);
+
+    g_assert_cmpint (mm_sms_link_release (&link), ==, MM_SMS_LINK_MODE_NONE);
+    g_assert_cmpint (mm_sms_link_hold (&link, FALSE), ==, MM_SMS_LINK_MODE_NONE);
+    g_assert_cmpint (mm_sms_link_release (&link), ==, MM_SMS_LINK_MODE_DISABLED);
+    g_assert_cmpuint (link.holds, ==, 0);
+
+    /* And all over again */
+    g_assert_cmpint (mm_sms_link_hold (&link, FALSE), ==, MM_SMS_LINK_MODE_TEMPORARY);
+    g_assert_cmpint (mm_sms_link_hold (&link, TRUE), ==, MM_SMS_LINK_MODE_ENABLED);
+    g_assert_cmpint (mm_sms_link_release (&link), ==, MM_SMS_LINK_MODE_DISABLED);
+}
+
+/*****************************************************************************/
+/* Same flow as SendMany(): the link is held for the whole batch, each
+ * multipart message asks for it too, and it's released once the last message
+ * is done, whether it failed or not */
+
+typedef struct {
+    guint    n_parts;
+    gboolean fails;
+} Message;
+
+static void
+record (GArray        *modes,
+        MMSmsLinkMode  mode)
+{
+    if (mode != MM_SMS_LINK_MODE_NONE)
+        g_array_append_val (modes, mode);
+}
+
+static guint
+send_many (MMSmsLink     *link,
+           const Message *messages,
+           guint          n_messages,
+           GArray        *modes)
+{
+    gboolean held = FALSE;
+    guint    n_sent = 0;
+    guint    i;
+
+    if (n_messages > 1) {
+        record (modes, mm_sms_link_hold (link, TRUE));
+        held = TRUE;
+    }
+
+    for (i = 0; i < n_messages; i++) {
+        if (messages[i].n_parts > 1)
+            record (modes, mm_sms_link_hold (link, FALSE));
+        if (!messages[i].fails)
+            n_sent++;
+    }
+
+    if (held)
+        record (modes, mm_sms_link_release (link));
+    return n_sent;
+}
+
+static void
+assert_modes (GArray              *modes,
+              const MMSmsLinkMode *expected,
+              guint                n_expected)
+{
+    guint i;
+
+    g_assert_cmpuint (modes->len, ==, n_expected);
+    for (i = 0; i < n_expected; i++)
+        g_assert_cmpint (g_array_index (modes, MMSmsLinkMode, i), ==, expected[i]);
+    g_array_set_size (modes, 0);
+}
+
+static void
+test_send_many (void)
+{
+    MMSmsLink           link = { 0 };
+    GArray             *modes;
+    const Message       batch[] = { { 1, FALSE }, { 3, FALSE }, { 1, FALSE } };
+    const Message       single[] = { { 2, FALSE } };
+    const MMSmsLinkMode batch_modes[] = { MM_SMS_LINK_MODE_ENABLED, MM_SMS_LINK_MODE_DISABLED };
+    const MMSmsLinkMode single_modes[] = { MM_SMS_LINK_MODE_TEMPORARY };
+
+    modes = g_array_new (FALSE, FALSE, sizeof (MMSmsLinkMode));
+
+    g_assert_cmpuint (send_many (&link, batch, G_N_ELEMENTS (batch), modes), ==, 3);
+    assert_modes (modes, batch_modes, G_N_ELEMENTS (batch_modes));
+    g_assert_cmpuint (link.holds, ==, 0);
+
+    g_assert_cmpuint (send_many (&link, single, G_N_ELEMENTS (single), modes), ==, 1);
+    assert_modes (modes, single_modes, G_N_ELEMENTS (single_modes));
+
+    g_array_unref (modes);
+}
+
+static void
+test_send_many_errors (void)
+{
+    MMSmsLink           link = { 0 };
+    GArray             *modes;
+    const Message       first_fails[] = { { 2, TRUE }, { 1, FALSE } };
+    const Message       all_fail[] = { { 1, TRUE }, { 1, TRUE }, { 4, TRUE } };
+    const MMSmsLinkMode expected[] = { MM_SMS_LINK_MODE_ENABLED, MM_SMS_LINK_MODE_DISABLED };
+
+    modes = g_array_new (FALSE, FALSE, sizeof (MMSmsLinkMode));
+
+    /* The link is released even if messages fail */
+    g_assert_cmpuint (send_many (&link, first_fails, G_N_ELEMENTS (first_fails), modes), ==, 1);
+    assert_modes (modes, expected, G_N_ELEMENTS (expected));
+    g_assert_cmpuint (link.holds, ==, 0);
+
+    g_assert_cmpuint (send_many (&link, all_fail, G_N_ELEMENTS (all_fail), modes), ==, 0);
+    assert_modes (modes, expected, G_N_ELEMENTS (expected));
+    g_assert_cmpuint (link.holds, ==, 0);
+
+    g_array_unref (modes);
+}
+
+static void
+test_send_many_overlapping (void)
+{
+    MMSmsLink           link = { 0 };
+    GArray             *modes;
+    const Message       batch[] = { { 1, FALSE }, { 2, TRUE } };
+    const MMSmsLinkMode expected[] = { MM_SMS_LINK_MODE_ENABLED };
+
+    modes = g_array_new (FALSE, FALSE, sizeof (MMSmsLinkMode));
+
+    /* A batch sent while another one holds the link doesn't release it */
+    record (modes, mm_sms_link_hold (&link, TRUE));
+    send_many (&link, batch, G_N_ELEMENTS (batch), modes);
+    assert_modes (modes, expected, G_N_ELEMENTS (expected));
+    g_assert_cmpuint (link.holds, ==, 1);
+
+    /* Until the first one is done */
+    g_assert_cmpint (mm_sms_link_release (&link), ==, MM_SMS_LINK_MODE_DISABLED);
+    g_assert_cmpuint (link.holds, ==, 0);
+
+    g_array_unref (modes);
+}
+
+static void
+test_unsupported (void)
+{
+    MMSmsLink link = { 0 };
+
+    /* Rejected while held: the count is still kept, but nothing is sent */
+    g_assert_cmpint (mm_sms_link_hold (&link, TRUE), ==, MM_SMS_LINK_MODE_ENABLED);
+    link.unsupported = TRUE;
+    g_assert_cmpint (mm_sms_link_hold (&link, TRUE), ==, MM_SMS_LINK_MODE_NONE);
+    g_assert_cmpint (mm_sms_link_release (&link), ==, MM_SMS_LINK_MODE_NONE);
+    g_assert_cmpint (mm_sms_link_release (&link), ==, MM_SMS_LINK_MODE_NONE);
+    g_assert_cmpuint (link.holds, ==, 0);
+
+    g_assert_cmpint (mm_sms_link_hold (&link, FALSE), ==, MM_SMS_LINK_MODE_NONE);
+    g_assert_cmpint (mm_sms_link_hold (&link, TRUE), ==, MM_SMS_LINK_MODE_NONE);
+    g_assert_cmpint (mm_sms_link_release (&link), ==, MM_SMS_LINK_MODE_NONE);
+    g_assert_cmpuint (link.holds, ==, 0);
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    setlocale (LC_ALL, "");
+
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/sms-link/temporary", test_temporary);
+    g_test_add_func ("/MM/sms-link/nested", test_nested);
+    g_test_add_func ("/MM/sms-link/send-many", test_send_many);
+    g_test_add_func ("/MM/sms-link/send-many-errors", test_send_many_errors);
+    g_test_add_func ("/MM/sms-link/send-many-overlapping", test_send_many_overlapping);
+    g_test_add_func ("/MM/sms-link/unsupported", test_unsupported);
+
+    return g_test_run ();
+}
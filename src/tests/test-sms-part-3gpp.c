@@ -24,7 +24,7 @@
 #include <libmm-glib.h>
 
 #include "mm-sms-part-3gpp.h"
-#include "mm-log.h"
+#include "mm-log-test.h"
 
 /* If defined will print debugging traces */
 #ifdef TEST_SMS_PART_ENABLE_TRACE
@@ -454,6 +454,116 @@ test_pdu_not_stored (void)
         NULL, 0);
 }
 
+static const gchar *batch_hexpdus[] = {
+    /* GSM7, with UDH */
+    "07911356131313F64004850120390011609232239180A006080400100201D7327BFD6EB340E232"
+    "1BF46E83EA7790F59D1E97DBE1341B442F83C465763D3DA797E56537C81D0ECB41AB59CC1693C1"
+    "6031D96C064241E5656838AF03A96230982A269BCD462917C8FA4E8FCBED709A0D7ABBE9F6B0FB"
+    "5C7683D27350984D4FABC9A0B33C4C4FCF5D20EBFB2D079DCB62793DBD06D9C36E50FB2D4E97D9"
+    "A0B49B5E96BBCB",
+    /* Not valid hex */
+    "07914356060013F1065A0981363973ZZ",
+    /* UCS2 SUBMIT */
+    "002100098136397339F70008224F60597D4F60597D4F60597D4F60597D4F60597D4F60597D4F60597D4F60597D4F60",
+    /* Status report */
+    "07914356060013F1065A098136397339F7219011700463802190117004638030",
+    /* Too short */
+    "07912143658709F1040B91810055151200",
+};
+
+static void
+test_pdu_batch (void)
+{
+    MMSmsPart *parts[G_N_ELEMENTS (batch_hexpdus)];
+    GError    *errors[G_N_ELEMENTS (batch_hexpdus)] = { NULL };
+    guint      indices[G_N_ELEMENTS (batch_hexpdus)];
+    guint      n_parts;
+    guint      i;
+
+    for (i = 0; i < G_N_ELEMENTS (batch_hexpdus); i++)
+        indices[i] = i + 10;
+
+    n_parts = mm_sms_part_3gpp_new_from_pdus (G_N_ELEMENTS (batch_hexpdus), indices, batch_hexpdus, parts, errors);
+    g_assert_cmpuint (n_parts, ==, 3);
+
+    /* Same results as when decoding one by one */
+    for (i = 0; i < G_N_ELEMENTS (batch_hexpdus); i++) {
+        MMSmsPart *part;
+        GError    *error = NULL;
+
+        part = mm_sms_part_3gpp_new_from_pdu (indices[i], batch_hexpdus[i], &error);
+        if (!part) {
+            g_assert (error);
+            g_assert (!parts[i]);
+            g_assert_error (errors[i], error->domain, error->code);
+            g_error_free (errors[i]);
+            g_error_free (error);
+            continue;
+        }
+
+        g_assert_no_error (errors[i]);
+        g_assert (parts[i]);
+        g_assert_cmpuint (mm_sms_part_get_index (parts[i]), ==, indices[i]);
+        g_assert_cmpuint (mm_sms_part_get_pdu_type (parts[i]), ==, mm_sms_part_get_pdu_type (part));
+        g_assert_cmpstr (mm_sms_part_get_smsc (parts[i]), ==, mm_sms_part_get_smsc (part));
+        g_assert_cmpstr (mm_sms_part_get_number (parts[i]), ==, mm_sms_part_get_number (part));
+        g_assert_cmpstr (mm_sms_part_get_timestamp (parts[i]), ==, mm_sms_part_get_timestamp (part));
+        g_assert_cmpstr (mm_sms_part_get_discharge_timestamp (parts[i]), ==, mm_sms_part_get_discharge_timestamp (part));
+        g_assert_cmpstr (mm_sms_part_get_text (parts[i]), ==, mm_sms_part_get_text (part));
+        g_assert_cmpuint (mm_sms_part_get_concat_reference (parts[i]), ==, mm_sms_part_get_concat_reference (part));
+
+        /* Strings may still be replaced one by one */
+        mm_sms_part_set_number (parts[i], "+34600000000");
+        g_assert_cmpstr (mm_sms_part_get_number (parts[i]), ==, "+34600000000");
+        g_assert_cmpstr (mm_sms_part_get_text (parts[i]), ==, mm_sms_part_get_text (part));
+
+        mm_sms_part_free (part);
+        mm_sms_part_free (parts[i]);
+    }
+}
+
+#define PERF_N_PDUS 20000
+
+static void
+test_pdu_batch_perf (void)
+{
+    MMSmsPart   **parts;
+    const gchar **hexpdus;
+    gdouble       single_time;
+    gdouble       batch_time;
+    guint         i;
+
+    if (!g_test_perf ())
+        return;
+
+    /* e.g. draining a full SIM storage */
+    hexpdus = g_new (const gchar *, PERF_N_PDUS);
+    for (i = 0; i < PERF_N_PDUS; i++)
+        hexpdus[i] = batch_hexpdus[(i % 2) ? 0 : 2];
+    parts = g_new (MMSmsPart *, PERF_N_PDUS);
+
+    g_test_timer_start ();
+    for (i = 0; i < PERF_N_PDUS; i++)
+        parts[i] = mm_sms_part_3gpp_new_from_pdu (i, hexpdus[i], NULL);
+    single_time = g_test_timer_elapsed ();
+    for (i = 0; i < PERF_N_PDUS; i++)
+        mm_sms_part_free (parts[i]);
+
+    g_test_timer_start ();
+    g_assert_cmpuint (mm_sms_part_3gpp_new_from_pdus (PERF_N_PDUS, NULL, hexpdus, parts, NULL), ==, PERF_N_PDUS);
+    batch_time = g_test_timer_elapsed ();
+    for (i = 0; i < PERF_N_PDUS; i++)
+        mm_sms_part_free (parts[i]);
+
+    g_test_minimized_result (batch_time / PERF_N_PDUS * 1e6,
+                             "PDU decoding: %.3fus per PDU in batch (%.3fus one by one)",
+                             batch_time / PERF_N_PDUS * 1e6,
+                             single_time / PERF_N_PDUS * 1e6);
+
+    g_free (parts);
+    g_free (hexpdus);
+}
+
 /********************* SMS ADDRESS ENCODER TESTS *********************/
 
 static void
@@ -841,26 +951,6 @@ test_text_split_two_pdu_ucs2 (void)
 
 /************************************************************/
 
-void
-_mm_log (const char *loc,
-         const char *func,
-         guint32 level,
-         const char *fmt,
-         ...)
-{
-#if defined ENABLE_TEST_MESSAGE_TRACES
-    /* Dummy log function */
-    va_list args;
-    gchar *msg;
-
-    va_start (args, fmt);
-    msg = g_strdup_vprintf (fmt, args);
-    va_end (args);
-    g_print ("%s\n", msg);
-    g_free (msg);
-#endif
-}
-
 int main (int argc, char **argv)
 {
     setlocale (LC_ALL, "");
@@ -881,6 +971,8 @@ int main (int argc, char **argv)
     g_test_add_func ("/MM/SMS/3GPP/PDU-Parser/pdu-multipart", test_pdu_multipart);
     g_test_add_func ("/MM/SMS/3GPP/PDU-Parser/pdu-stored-by-us", test_pdu_stored_by_us);
     g_test_add_func ("/MM/SMS/3GPP/PDU-Parser/pdu-not-stored", test_pdu_not_stored);
+    g_test_add_func ("/MM/SMS/3GPP/PDU-Parser/batch", test_pdu_batch);
+    g_test_add_func ("/MM/SMS/3GPP/PDU-Parser/batch-perf", test_pdu_batch_perf);
 
     g_test_add_func ("/MM/SMS/3GPP/Address-Encoder/smsc-intl", test_address_encode_smsc_intl);
     g_test_add_func ("/MM/SMS/3GPP/Address-Encoder/smsc-unknown", test_address_encode_smsc_unknown);
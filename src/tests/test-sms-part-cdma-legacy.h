@@ -0,0 +1,32 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2013 Google, Inc.
+ */
+
+#ifndef TEST_SMS_PART_CDMA_LEGACY_H
+#define TEST_SMS_PART_CDMA_LEGACY_H
+
+#include <glib.h>
+
+#include "mm-sms-part.h"
+
+/* Previous implementation of the CDMA PDU codec, baseline of the benchmark */
+MMSmsPart *legacy_sms_part_cdma_new_from_binary_pdu (guint index,
+                                                     const guint8 *pdu,
+                                                     gsize pdu_len,
+                                                     GError **error);
+guint8    *legacy_sms_part_cdma_get_submit_pdu      (MMSmsPart *part,
+                                                     guint *out_pdulen,
+                                                     GError **error);
+
+#endif /* TEST_SMS_PART_CDMA_LEGACY_H */
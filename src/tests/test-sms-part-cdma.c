@@ -23,7 +23,9 @@
 #include <libmm-glib.h>
 
 #include "mm-sms-part-cdma.h"
-#include "mm-log.h"
+#include "mm-log-test.h"
+
+#include "test-sms-part-cdma-legacy.h"
 
 /* If defined will print debugging traces */
 #ifdef TEST_SMS_PART_ENABLE_TRACE
@@ -503,28 +505,238 @@ test_create_pdu_text_unicode_encoding (void)
                             expected, sizeof (expected));
 }
 
-/************************************************************/
+/********************* PDU ROUND TRIP TESTS *********************/
 
-void
-_mm_log (const char *loc,
-         const char *func,
-         guint32 level,
-         const char *fmt,
-         ...)
+static MMSmsPart *
+common_create_part (const gchar *number,
+                    const gchar *text,
+                    const guint8 *data,
+                    gsize data_size)
 {
-#if defined ENABLE_TEST_MESSAGE_TRACES
-    /* Dummy log function */
-    va_list args;
-    gchar *msg;
-
-    va_start (args, fmt);
-    msg = g_strdup_vprintf (fmt, args);
-    va_end (args);
-    g_print ("%s\n", msg);
-    g_free (msg);
-#endif
+    MMSmsPart *part;
+
+    part = mm_sms_part_new (0, MM_SMS_PDU_TYPE_CDMA_SUBMIT);
+    mm_sms_part_set_cdma_teleservice_id (part, MM_SMS_CDMA_TELESERVICE_ID_WMT);
+    mm_sms_part_set_number (part, number);
+    if (text)
+        mm_sms_part_set_text (part, text);
+    else {
+        GByteArray *data_bytearray;
+
+        data_bytearray = g_byte_array_sized_new (data_size);
+        g_byte_array_append (data_bytearray, data, data_size);
+        mm_sms_part_take_data (part, data_bytearray);
+    }
+    return part;
+}
+
+static void
+common_test_roundtrip (const gchar *number,
+                       const gchar *text,
+                       const guint8 *data,
+                       gsize data_size)
+{
+    MMSmsPart *part;
+    guint8 *pdu;
+    guint len = 0;
+    GError *error = NULL;
+
+    part = common_create_part (number, text, data, data_size);
+    pdu = mm_sms_part_cdma_get_submit_pdu (part, &len, &error);
+    mm_sms_part_free (part);
+
+    trace_pdu (pdu, len);
+
+    g_assert_no_error (error);
+    g_assert (pdu != NULL);
+
+    part = mm_sms_part_cdma_new_from_binary_pdu (0, pdu, len, &error);
+    g_assert_no_error (error);
+    g_assert (part != NULL);
+
+    g_assert_cmpuint (mm_sms_part_get_pdu_type (part), ==, MM_SMS_PDU_TYPE_CDMA_SUBMIT);
+    g_assert_cmpuint (mm_sms_part_get_cdma_teleservice_id (part), ==, MM_SMS_CDMA_TELESERVICE_ID_WMT);
+    g_assert_cmpstr (mm_sms_part_get_number (part), ==, number);
+    if (text)
+        g_assert_cmpstr (mm_sms_part_get_text (part), ==, text);
+    else {
+        const GByteArray *part_data;
+
+        part_data = mm_sms_part_get_data (part);
+        g_assert (part_data != NULL);
+        g_assert_cmpuint (part_data->len, ==, data_size);
+        g_assert_cmpint (memcmp (part_data->data, data, data_size), ==, 0);
+    }
+
+    mm_sms_part_free (part);
+    g_free (pdu);
+}
+
+static gchar *
+build_text (const gchar *unit,
+            guint n_units)
+{
+    GString *str;
+    guint i;
+
+    str = g_string_new ("");
+    for (i = 0; i < n_units; i++)
+        g_string_append (str, unit);
+    return g_string_free (str, FALSE);
+}
+
+static void
+test_roundtrip_text (void)
+{
+    static const gchar *units[] = {
+        "A",  /* 7-bit ASCII */
+        "ñ",  /* Latin */
+        "中", /* Unicode */
+    };
+    guint i;
+    guint n_units;
+
+    /* All lengths, so that the bit reader and writer go through every
+     * possible alignment of the last field */
+    for (i = 0; i < G_N_ELEMENTS (units); i++) {
+        for (n_units = 1; n_units <= 120; n_units++) {
+            gchar *text;
+
+            text = build_text (units[i], n_units);
+            common_test_roundtrip ("3305773196", text, NULL, 0);
+            g_free (text);
+        }
+    }
+
+    /* Mixed contents */
+    common_test_roundtrip ("1", "Hello, world! ~{}|", NULL, 0);
+    common_test_roundtrip ("0123456789", "Campeón! ¿Qué tal? Ñandú", NULL, 0);
+    common_test_roundtrip ("01234567890123456789", "中國哲學書 and some ASCII", NULL, 0);
+}
+
+static void
+test_roundtrip_data (void)
+{
+    guint8 data[140];
+    guint i;
+
+    for (i = 0; i < sizeof (data); i++)
+        data[i] = (guint8) (i * 37);
+
+    for (i = 1; i <= sizeof (data); i++)
+        common_test_roundtrip ("3305773196", NULL, data, i);
+}
+
+/********************* PDU CODEC BENCHMARK *********************/
+
+#define PERF_N_PDUS 20000
+
+typedef guint8 *   (* PerfCreateFunc) (MMSmsPart *part, guint *out_pdulen, GError **error);
+typedef MMSmsPart *(* PerfParseFunc)  (guint index, const guint8 *pdu, gsize pdu_len, GError **error);
+
+static void
+perf_run (MMSmsPart      *part,
+          PerfCreateFunc  create,
+          PerfParseFunc   parse,
+          gdouble        *create_time,
+          gdouble        *parse_time)
+{
+    MMSmsPart *parsed;
+    guint8 *pdu;
+    guint len = 0;
+    guint i;
+
+    g_test_timer_start ();
+    for (i = 0; i < PERF_N_PDUS; i++) {
+        pdu = create (part, &len, NULL);
+        g_assert (pdu != NULL);
+        g_free (pdu);
+    }
+    *create_time = g_test_timer_elapsed () / PERF_N_PDUS * 1e6;
+
+    pdu = create (part, &len, NULL);
+    g_test_timer_start ();
+    for (i = 0; i < PERF_N_PDUS; i++) {
+        parsed = parse (0, pdu, len, NULL);
+        g_assert (parsed != NULL);
+        mm_sms_part_free (parsed);
+    }
+    *parse_time = g_test_timer_elapsed () / PERF_N_PDUS * 1e6;
+    g_free (pdu);
+}
+
+static void
+common_test_perf (const gchar *description,
+                  const gchar *text)
+{
+    MMSmsPart *part;
+    MMSmsPart *parsed;
+    MMSmsPart *legacy_parsed;
+    guint8 *pdu;
+    guint8 *legacy_pdu;
+    guint len = 0;
+    guint legacy_len = 0;
+    gdouble parse_time;
+    gdouble create_time;
+    gdouble legacy_parse_time;
+    gdouble legacy_create_time;
+
+    part = common_create_part ("3305773196", text, NULL, 0);
+
+    /* Both implementations create the same PDU */
+    pdu = mm_sms_part_cdma_get_submit_pdu (part, &len, NULL);
+    legacy_pdu = legacy_sms_part_cdma_get_submit_pdu (part, &legacy_len, NULL);
+    g_assert (pdu != NULL);
+    g_assert (legacy_pdu != NULL);
+    g_assert_cmpuint (len, ==, legacy_len);
+    g_assert (memcmp (pdu, legacy_pdu, len) == 0);
+    g_free (legacy_pdu);
+
+    /* And parse it back the same way, so that both do the same work */
+    parsed = mm_sms_part_cdma_new_from_binary_pdu (0, pdu, len, NULL);
+    legacy_parsed = legacy_sms_part_cdma_new_from_binary_pdu (0, pdu, len, NULL);
+    g_assert (parsed != NULL);
+    g_assert (legacy_parsed != NULL);
+    g_assert_cmpstr (mm_sms_part_get_text (parsed), ==, text);
+    g_assert_cmpstr (mm_sms_part_get_text (legacy_parsed), ==, text);
+    mm_sms_part_free (legacy_parsed);
+    mm_sms_part_free (parsed);
+    g_free (pdu);
+
+    perf_run (part,
+              legacy_sms_part_cdma_get_submit_pdu,
+              legacy_sms_part_cdma_new_from_binary_pdu,
+              &legacy_create_time,
+              &legacy_parse_time);
+    perf_run (part,
+              mm_sms_part_cdma_get_submit_pdu,
+              mm_sms_part_cdma_new_from_binary_pdu,
+              &create_time,
+              &parse_time);
+    mm_sms_part_free (part);
+
+    g_test_minimized_result (parse_time,
+                             "%s: %.3fus per parsed PDU (legacy: %.3fus, %.1fx), "
+                             "%.3fus per created PDU (legacy: %.3fus, %.1fx) (%u bytes, %u PDUs)",
+                             description,
+                             parse_time, legacy_parse_time, legacy_parse_time / parse_time,
+                             create_time, legacy_create_time, legacy_create_time / create_time,
+                             len, PERF_N_PDUS);
+}
+
+static void
+test_perf (void)
+{
+    if (!g_test_perf ())
+        return;
+
+    common_test_perf ("ascii",   "Hello world, this is a plain ASCII CDMA text message of some length!");
+    common_test_perf ("latin",   "Campeón! ¿Qué tal? Ñandú");
+    common_test_perf ("unicode", "中國哲學書電子化計劃");
 }
 
+/************************************************************/
+
 int main (int argc, char **argv)
 {
     setlocale (LC_ALL, "");
@@ -543,5 +755,10 @@ int main (int argc, char **argv)
     g_test_add_func ("/MM/SMS/CDMA/PDU-Creator/latin-encoding", test_create_pdu_text_latin_encoding);
     g_test_add_func ("/MM/SMS/CDMA/PDU-Creator/unicode-encoding", test_create_pdu_text_unicode_encoding);
 
+    g_test_add_func ("/MM/SMS/CDMA/PDU-Roundtrip/text", test_roundtrip_text);
+    g_test_add_func ("/MM/SMS/CDMA/PDU-Roundtrip/data", test_roundtrip_data);
+
+    g_test_add_func ("/MM/SMS/CDMA/PDU-Codec/perf", test_perf);
+
     return g_test_run ();
 }
@@ -0,0 +1,225 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 The ModemManager developers
+ */
+
+#include <glib.h>
+#include <locale.h>
+
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+/* Define symbol to enable test message traces */
+#undef ENABLE_TEST_MESSAGE_TRACES
+
+#include "mm-throughput.h"
+#include "mm-log-test.h"
+
+#define SEC(x) ((gint64) (x) * G_USEC_PER_SEC)
+
+#define INTERVAL 5
+
+/*****************************************************************************/
+
+static void
+test_rate (void)
+{
+    MMThroughput *throughput;
+
+    throughput = mm_throughput_new (INTERVAL);
+    g_assert_cmpuint (mm_throughput_get_interval (throughput), ==, INTERVAL);
+
+    /* First sample only sets the reference */
+    g_assert (!mm_throughput_add_sample (throughput, SEC (100), 1000, 2000));
+    g_assert (mm_throughput_get_dictionary (throughput) == NULL);
+
+    g_assert (mm_throughput_add_sample (throughput, SEC (105), 6000, 2500));
+    g_assert_cmpuint (mm_throughput_get_rx_rate (throughput), ==, 1000);
+    g_assert_cmpuint (mm_throughput_get_tx_rate (throughput), ==, 100);
+    g_assert_cmpuint (mm_throughput_get_rx_average (throughput), ==, 1000);
+    g_assert_cmpuint (mm_throughput_get_tx_average (throughput), ==, 100);
+
+    /* Rate computed over the actual elapsed time */
+    g_assert (mm_throughput_add_sample (throughput, SEC (115), 16000, 2500));
+    g_assert_cmpuint (mm_throughput_get_rx_rate (throughput), ==, 1000);
+    g_assert_cmpuint (mm_throughput_get_tx_rate (throughput), ==, 0);
+
+    /* Too close to the previous sample, ignored and the reference is kept */
+    g_assert (!mm_throughput_add_sample (throughput, SEC (116), 17000, 2600));
+    g_assert (!mm_throughput_add_sample (throughput, SEC (115), 17000, 2600));
+    g_assert (mm_throughput_add_sample (throughput, SEC (120), 21000, 3000));
+    g_assert_cmpuint (mm_throughput_get_rx_rate (throughput), ==, 1000);
+    g_assert_cmpuint (mm_throughput_get_tx_rate (throughput), ==, 100);
+    g_assert_cmpuint (mm_throughput_get_n_history (throughput), ==, 3);
+
+    mm_throughput_free (throughput);
+}
+
+static void
+test_peak_average (void)
+{
+    MMThroughput *throughput;
+    guint64       rx_bytes = 0;
+    gint64        now;
+    guint         i;
+
+    throughput = mm_throughput_new (INTERVAL);
+
+    now = SEC (100);
+    mm_throughput_add_sample (throughput, now, rx_bytes, 0);
+
+    /* A single burst sets the peak, but barely moves the average */
+    for (i = 0; i < 10; i++) {
+        now += SEC (INTERVAL);
+        rx_bytes += (i == 1 ? 500000 : 5000);
+        g_assert (mm_throughput_add_sample (throughput, now, rx_bytes, 0));
+    }
+    g_assert_cmpuint (mm_throughput_get_rx_rate (throughput), ==, 1000);
+    g_assert_cmpuint (mm_throughput_get_rx_peak (throughput), ==, 100000);
+    g_assert_cmpuint (mm_throughput_get_tx_peak (throughput), ==, 0);
+    g_assert_cmpuint (mm_throughput_get_rx_average (throughput), >, 1000);
+    g_assert_cmpuint (mm_throughput_get_rx_average (throughput), <, 10000);
+
+    /* The average follows a step after a few time constants */
+    for (i = 0; i < (10 * MM_THROUGHPUT_AVERAGE_TAU_SEC) / INTERVAL; i++) {
+        now += SEC (INTERVAL);
+        rx_bytes += 10000 * INTERVAL;
+        mm_throughput_add_sample (throughput, now, rx_bytes, 0);
+    }
+    g_assert_cmpuint (mm_throughput_get_rx_average (throughput), >=, 9990);
+    g_assert_cmpuint (mm_throughput_get_rx_average (throughput), <=, 10000);
+    g_assert_cmpuint (mm_throughput_get_rx_peak (throughput), ==, 100000);
+
+    mm_throughput_free (throughput);
+}
+
+static void
+test_history (void)
+{
+    MMThroughput *throughput;
+    guint32       rx_rate;
+    guint32       tx_rate;
+    guint         i;
+
+    throughput = mm_throughput_new (1);
+    mm_throughput_add_sample (throughput, SEC (0), 0, 0);
+
+    /* Rate i in the i-th interval, more than fit in the ring */
+    for (i = 1; i <= MM_THROUGHPUT_HISTORY_SIZE + 15; i++)
+        g_assert (mm_throughput_add_sample (throughput,
+                                            SEC (i),
+                                            ((guint64) i * (i + 1)) / 2,
+                                            (guint64) i * 10));
+
+    /* Only the last ones kept, oldest first */
+    g_assert_cmpuint (mm_throughput_get_n_history (throughput), ==, MM_THROUGHPUT_HISTORY_SIZE);
+    for (i = 0; i < MM_THROUGHPUT_HISTORY_SIZE; i++) {
+        mm_throughput_get_history (throughput, i, &rx_rate, &tx_rate);
+        g_assert_cmpuint (rx_rate, ==, 16 + i);
+        g_assert_cmpuint (tx_rate, ==, 10);
+    }
+
+    mm_throughput_free (throughput);
+}
+
+static void
+test_counters_reset (void)
+{
+    MMThroughput *throughput;
+
+    throughput = mm_throughput_new (INTERVAL);
+    mm_throughput_add_sample (throughput, SEC (0), 100000, 100000);
+    g_assert (mm_throughput_add_sample (throughput, SEC (5), 150000, 100500));
+    g_assert_cmpuint (mm_throughput_get_rx_rate (throughput), ==, 10000);
+
+    /* Counters back to 0, no bogus rate, just start over */
+    g_assert (!mm_throughput_add_sample (throughput, SEC (10), 500, 500));
+    g_assert_cmpuint (mm_throughput_get_rx_rate (throughput), ==, 10000);
+    g_assert (mm_throughput_add_sample (throughput, SEC (15), 5500, 1500));
+    g_assert_cmpuint (mm_throughput_get_rx_rate (throughput), ==, 1000);
+    g_assert_cmpuint (mm_throughput_get_tx_rate (throughput), ==, 200);
+    g_assert_cmpuint (mm_throughput_get_rx_peak (throughput), ==, 10000);
+    g_assert_cmpuint (mm_throughput_get_n_history (throughput), ==, 2);
+
+    /* A new connection drops everything, but the interval */
+    mm_throughput_reset (throughput);
+    g_assert_cmpuint (mm_throughput_get_interval (throughput), ==, INTERVAL);
+    g_assert_cmpuint (mm_throughput_get_rx_peak (throughput), ==, 0);
+    g_assert_cmpuint (mm_throughput_get_n_history (throughput), ==, 0);
+    g_assert (mm_throughput_get_dictionary (throughput) == NULL);
+    g_assert (!mm_throughput_add_sample (throughput, SEC (20), 0, 0));
+
+    mm_throughput_free (throughput);
+}
+
+static void
+test_dictionary (void)
+{
+    MMThroughput       *throughput;
+    MMBearerThroughput *bearer_throughput;
+    GVariant           *dictionary;
+    GError             *error = NULL;
+    const guint32      *rx_rates;
+    const guint32      *tx_rates;
+    guint               n_samples;
+
+    throughput = mm_throughput_new (INTERVAL);
+    mm_throughput_add_sample (throughput, SEC (0), 0, 0);
+    mm_throughput_add_sample (throughput, SEC (5), 5000, 50000);
+    mm_throughput_add_sample (throughput, SEC (10), 30000, 50000);
+    /* Rates above 32 bits are clamped in the history only */
+    mm_throughput_add_sample (throughput, SEC (15), 30000 + G_GUINT64_CONSTANT (0x200000000) * INTERVAL, 50000);
+
+    dictionary = g_variant_ref_sink (mm_throughput_get_dictionary (throughput));
+    bearer_throughput = mm_bearer_throughput_new_from_dictionary (dictionary, &error);
+    g_assert_no_error (error);
+    g_assert (bearer_throughput);
+
+    g_assert_cmpuint (mm_bearer_throughput_get_interval (bearer_throughput), ==, INTERVAL);
+    g_assert_cmpuint (mm_bearer_throughput_get_rx_rate (bearer_throughput), ==, G_GUINT64_CONSTANT (0x200000000));
+    g_assert_cmpuint (mm_bearer_throughput_get_tx_rate (bearer_throughput), ==, 0);
+    g_assert_cmpuint (mm_bearer_throughput_get_rx_peak (bearer_throughput), ==, G_GUINT64_CONSTANT (0x200000000));
+    g_assert_cmpuint (mm_bearer_throughput_get_tx_peak (bearer_throughput), ==, 10000);
+    g_assert_cmpuint (mm_bearer_throughput_get_rx_average (bearer_throughput), ==, mm_throughput_get_rx_average (throughput));
+    g_assert_cmpuint (mm_bearer_throughput_get_tx_average (bearer_throughput), ==, mm_throughput_get_tx_average (throughput));
+
+    g_assert (mm_bearer_throughput_peek_history (bearer_throughput, &rx_rates, &tx_rates, &n_samples));
+    g_assert_cmpuint (n_samples, ==, 3);
+    g_assert_cmpuint (rx_rates[0], ==, 1000);
+    g_assert_cmpuint (rx_rates[1], ==, 5000);
+    g_assert_cmpuint (rx_rates[2], ==, G_MAXUINT32);
+    g_assert_cmpuint (tx_rates[0], ==, 10000);
+    g_assert_cmpuint (tx_rates[1], ==, 0);
+    g_assert_cmpuint (tx_rates[2], ==, 0);
+
+    g_object_unref (bearer_throughput);
+    g_variant_unref (dictionary);
+    mm_throughput_free (throughput);
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    setlocale (LC_ALL, "");
+
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/throughput/rate", test_rate);
+    g_test_add_func ("/MM/throughput/peak-average", test_peak_average);
+    g_test_add_func ("/MM/throughput/history", test_history);
+    g_test_add_func ("/MM/throughput/counters-reset", test_counters_reset);
+    g_test_add_func ("/MM/throughput/dictionary", test_dictionary);
+
+    return g_test_run ();
+}
@@ -26,7 +26,7 @@
 #undef ENABLE_TEST_MESSAGE_TRACES
 
 #include "mm-kernel-device-generic-rules.h"
-#include "mm-log.h"
+#include "mm-log-test.h"
 
 /************************************************************/
 
@@ -46,26 +46,144 @@ test_load_cleanup_core (void)
 
 /************************************************************/
 
-void
-_mm_log (const char *loc,
-         const char *func,
-         guint32 level,
-         const char *fmt,
-         ...)
+static void
+common_setup_device (MMUdevRuleDevice *device,
+                     guint             i,
+                     guint16           vid,
+                     guint16           pid,
+                     gchar            *name,
+                     gchar            *sysfs_path)
+{
+    static const gchar *drivers[] = { "option", "qcserial", "cdc_acm", "qmi_wwan", "ftdi_sio", "sierra" };
+
+    memset (device, 0, sizeof (MMUdevRuleDevice));
+
+    g_snprintf (name, 32, "ttyUSB%u", i);
+    g_snprintf (sysfs_path, 256, "/sys/devices/pci0000:00/0000:00:14.0/usb1/1-%u/1-%u:1.%u/%s/tty/%s",
+                i % 16, i % 16, i % 8, name, name);
+
+    device->subsystem          = "tty";
+    device->name               = name;
+    device->sysfs_path         = sysfs_path;
+    device->driver             = drivers[i % G_N_ELEMENTS (drivers)];
+    device->physdev_vid        = vid;
+    device->physdev_pid        = pid;
+    device->interface_class    = 0xff;
+    device->interface_subclass = i % 3;
+    device->interface_protocol = i % 5;
+    device->interface_number   = i % 8;
+}
+
+static void
+test_apply (void)
 {
-#if defined ENABLE_TEST_MESSAGE_TRACES
-    /* Dummy log function */
-    va_list args;
-    gchar *msg;
-
-    va_start (args, fmt);
-    msg = g_strdup_vprintf (fmt, args);
-    va_end (args);
-    g_print ("%s\n", msg);
-    g_free (msg);
-#endif
+    GArray           *rules;
+    GError           *error = NULL;
+    MMUdevRuleDevice  device;
+    gchar             name[32];
+    gchar             sysfs_path[256];
+    GObject          *properties;
+
+    rules = mm_kernel_device_generic_rules_load (TESTUDEVRULESDIR, &error);
+    g_assert_no_error (error);
+    g_assert (rules);
+
+    /* FTDI serial adapter, greylisted by vid */
+    common_setup_device (&device, 0, 0x0403, 0x6001, name, sysfs_path);
+    properties = g_object_new (G_TYPE_OBJECT, NULL);
+    mm_kernel_device_generic_rules_apply (rules, &device, properties);
+    g_assert_cmpstr (g_object_get_data (properties, "ID_MM_CANDIDATE"), ==, "1");
+    g_assert_cmpstr (g_object_get_data (properties, "ID_MM_DEVICE_MANUAL_SCAN_ONLY"), ==, "1");
+    g_assert (!g_object_get_data (properties, "ID_MM_DEVICE_IGNORE"));
+    g_object_unref (properties);
+
+    /* APC UPS, blacklisted by vid */
+    common_setup_device (&device, 1, 0x051d, 0x0002, name, sysfs_path);
+    properties = g_object_new (G_TYPE_OBJECT, NULL);
+    mm_kernel_device_generic_rules_apply (rules, &device, properties);
+    g_assert_cmpstr (g_object_get_data (properties, "ID_MM_CANDIDATE"), ==, "1");
+    g_assert_cmpstr (g_object_get_data (properties, "ID_MM_DEVICE_IGNORE"), ==, "1");
+    g_object_unref (properties);
+
+    /* Prolific adapter, greylisted by vid and pid; a different pid isn't */
+    common_setup_device (&device, 3, 0x067b, 0x2303, name, sysfs_path);
+    properties = g_object_new (G_TYPE_OBJECT, NULL);
+    mm_kernel_device_generic_rules_apply (rules, &device, properties);
+    g_assert_cmpstr (g_object_get_data (properties, "ID_MM_DEVICE_MANUAL_SCAN_ONLY"), ==, "1");
+    g_object_unref (properties);
+
+    common_setup_device (&device, 3, 0x067b, 0x2304, name, sysfs_path);
+    properties = g_object_new (G_TYPE_OBJECT, NULL);
+    mm_kernel_device_generic_rules_apply (rules, &device, properties);
+    g_assert (!g_object_get_data (properties, "ID_MM_DEVICE_MANUAL_SCAN_ONLY"));
+    g_object_unref (properties);
+
+    /* Bluetooth RFCOMM ttys are never candidates */
+    common_setup_device (&device, 2, 0x0000, 0x0000, name, sysfs_path);
+    device.name = "rfcomm0";
+    device.sysfs_path = "/sys/devices/virtual/tty/rfcomm0";
+    properties = g_object_new (G_TYPE_OBJECT, NULL);
+    mm_kernel_device_generic_rules_apply (rules, &device, properties);
+    g_assert (!g_object_get_data (properties, "ID_MM_CANDIDATE"));
+    g_object_unref (properties);
+
+    g_array_unref (rules);
 }
 
+static void
+test_apply_perf (void)
+{
+    GArray           *rules;
+    GError           *error = NULL;
+    GArray           *vids;
+    MMUdevRuleDevice  device;
+    gchar             name[32];
+    gchar             sysfs_path[256];
+    guint             n_ports = 5000;
+    guint             i;
+    gdouble           elapsed;
+
+    if (!g_test_perf ())
+        return;
+
+    rules = mm_kernel_device_generic_rules_load (TESTUDEVRULESDIR, &error);
+    g_assert_no_error (error);
+    g_assert (rules);
+
+    /* Half of the population uses vids found in the rules, so that both the
+     * skipped and the evaluated paths are exercised */
+    vids = g_array_new (FALSE, FALSE, sizeof (guint16));
+    for (i = 0; i < rules->len; i++) {
+        MMUdevRule *rule;
+
+        rule = &g_array_index (rules, MMUdevRule, i);
+        if (rule->vid)
+            g_array_append_val (vids, rule->vid);
+    }
+    g_assert_cmpuint (vids->len, >, 0);
+
+    g_test_timer_start ();
+    for (i = 0; i < n_ports; i++) {
+        GObject *properties;
+        guint16  vid;
+
+        vid = ((i % 2) ? g_array_index (vids, guint16, i % vids->len) : (guint16) (0x1000 + i));
+        common_setup_device (&device, i, vid, (guint16) (i % 0x100), name, sysfs_path);
+        properties = g_object_new (G_TYPE_OBJECT, NULL);
+        mm_kernel_device_generic_rules_apply (rules, &device, properties);
+        g_object_unref (properties);
+    }
+    elapsed = g_test_timer_elapsed ();
+
+    g_test_minimized_result (elapsed, "udev rules: %.3fs (%u rules, %u ports)",
+                             elapsed, rules->len, n_ports);
+
+    g_array_unref (vids);
+    g_array_unref (rules);
+}
+
+/************************************************************/
+
 int main (int argc, char **argv)
 {
     setlocale (LC_ALL, "");
@@ -73,6 +191,8 @@ int main (int argc, char **argv)
     g_test_init (&argc, &argv, NULL);
 
     g_test_add_func ("/MM/test-udev-rules/load-cleanup-core", test_load_cleanup_core);
+    g_test_add_func ("/MM/test-udev-rules/apply",             test_apply);
+    g_test_add_func ("/MM/test-udev-rules/apply-perf",        test_apply_perf);
 
     return g_test_run ();
 }
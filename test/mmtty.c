@@ -103,6 +103,26 @@ _mm_log (const char *loc,
     g_free (msg);
 }
 
+void
+_mm_log_trace (const char *loc,
+               const char *func,
+               const char *owner,
+               const char *fmt,
+               ...)
+{
+    va_list args;
+    gchar *msg;
+
+    if (!verbose_flag)
+        return;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+}
+
 static void
 print_version_and_exit (void)
 {